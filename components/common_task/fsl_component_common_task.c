@@ -24,10 +24,32 @@
 /*******************************************************************************
  * Definitions
  ******************************************************************************/
+#if (defined(COMMON_TASK_PRIORITY_QUEUE) && (COMMON_TASK_PRIORITY_QUEUE > 0U))
+typedef struct _common_task_msg_entry
+{
+    common_task_message_t *msg;
+    uint32_t cycles; /* COMMON_TASK_GET_CYCLES() at post */
+} common_task_msg_entry_t;
+
+/* Bounded FIFO of one message priority */
+typedef struct _common_task_msg_queue
+{
+    common_task_msg_entry_t entries[COMMON_TASK_MAX_MSGQ_COUNT];
+    uint8_t head;
+    uint8_t count;
+    common_task_msg_statistics_t statistics;
+} common_task_msg_queue_t;
+#endif /* COMMON_TASK_PRIORITY_QUEUE */
+
 typedef struct _common_task_state
 {
     OSA_TASK_HANDLE_DEFINE(commonTaskHandle);
+#if (defined(COMMON_TASK_PRIORITY_QUEUE) && (COMMON_TASK_PRIORITY_QUEUE > 0U))
+    OSA_SEMAPHORE_HANDLE_DEFINE(semaphoreHandle);
+    common_task_msg_queue_t queue[COMMON_TASK_MSG_PRIORITY_COUNT];
+#else
     OSA_MSGQ_HANDLE_DEFINE(msgqhandle, COMMON_TASK_MAX_MSGQ_COUNT, sizeof(void *));
+#endif
     uint8_t isInitialized;
 } common_task_state_t;
 
@@ -49,12 +71,61 @@ OSA_TASK_DEFINE(COMMON_TASK_task, COMMON_TASK_PRIORITY, 1, COMMON_TASK_STACK_SIZ
  * Code
  ******************************************************************************/
 
+#if (defined(COMMON_TASK_PRIORITY_QUEUE) && (COMMON_TASK_PRIORITY_QUEUE > 0U))
+/* Take the oldest message of the most urgent non-empty priority, called with the critical section held */
+static common_task_message_t *COMMON_TASK_take_message(common_task_state_t *commonTaskStateHandle)
+{
+    common_task_msg_queue_t *queue;
+    common_task_msg_entry_t *entry;
+    uint32_t latency;
+
+    for (uint32_t priority = 0U; priority < COMMON_TASK_MSG_PRIORITY_COUNT; priority++)
+    {
+        queue = &commonTaskStateHandle->queue[priority];
+        if (0U == queue->count)
+        {
+            continue;
+        }
+
+        entry       = &queue->entries[queue->head];
+        queue->head = (uint8_t)((queue->head + 1U) % COMMON_TASK_MAX_MSGQ_COUNT);
+        queue->count--;
+
+        latency = (COMMON_TASK_GET_CYCLES() - entry->cycles) / COMMON_TASK_CYCLES_PER_USEC;
+        queue->statistics.executed++;
+        queue->statistics.latencyTotal += latency;
+        if (latency > queue->statistics.latencyMax)
+        {
+            queue->statistics.latencyMax = latency;
+        }
+        return entry->msg;
+    }
+
+    return NULL;
+}
+#endif /* COMMON_TASK_PRIORITY_QUEUE */
+
 void COMMON_TASK_task(osa_task_param_t param)
 {
     common_task_state_t *commonTaskStateHandle = (common_task_state_t *)param;
     common_task_message_t *msg;
     do
     {
+#if (defined(COMMON_TASK_PRIORITY_QUEUE) && (COMMON_TASK_PRIORITY_QUEUE > 0U))
+        if (KOSA_StatusSuccess ==
+            OSA_SemaphoreWait((osa_semaphore_handle_t)commonTaskStateHandle->semaphoreHandle, osaWaitForever_c))
+        {
+            OSA_SR_ALLOC();
+            OSA_ENTER_CRITICAL();
+            msg = COMMON_TASK_take_message(commonTaskStateHandle);
+            OSA_EXIT_CRITICAL();
+
+            if ((NULL != msg) && (NULL != msg->callback))
+            {
+                msg->callback(msg->callbackParam);
+            }
+        }
+#else
         if (KOSA_StatusSuccess ==
             OSA_MsgQGet((osa_msgq_handle_t)commonTaskStateHandle->msgqhandle, &msg, osaWaitForever_c))
         {
@@ -63,6 +134,7 @@ void COMMON_TASK_task(osa_task_param_t param)
                 msg->callback(msg->callbackParam);
             }
         }
+#endif
     } while (gUseRtos_c);
 }
 
@@ -76,8 +148,13 @@ common_task_status_t COMMON_TASK_init(void)
     }
     s_commonTaskState->isInitialized = 1U;
 
+#if (defined(COMMON_TASK_PRIORITY_QUEUE) && (COMMON_TASK_PRIORITY_QUEUE > 0U))
+    (void)memset(s_commonTaskState->queue, 0, sizeof(s_commonTaskState->queue));
+    status = OSA_SemaphoreCreate((osa_semaphore_handle_t)s_commonTaskState->semaphoreHandle, 0U);
+#else
     status =
         OSA_MsgQCreate((osa_msgq_handle_t)s_commonTaskState->msgqhandle, COMMON_TASK_MAX_MSGQ_COUNT, sizeof(void *));
+#endif
     assert(KOSA_StatusSuccess == status);
 
     status = OSA_TaskCreate((osa_task_handle_t)s_commonTaskState->commonTaskHandle, OSA_TASK(COMMON_TASK_task),
@@ -95,23 +172,118 @@ common_task_status_t COMMON_TASK_deinit(void)
         return kStatus_COMMON_TASK_Error;
     }
 
+#if (defined(COMMON_TASK_PRIORITY_QUEUE) && (COMMON_TASK_PRIORITY_QUEUE > 0U))
+    (void)OSA_SemaphoreDestroy((osa_semaphore_handle_t)s_commonTaskState->semaphoreHandle);
+#else
     OSA_MsgQDestroy((osa_msgq_handle_t)s_commonTaskState->msgqhandle);
+#endif
     OSA_TaskDestroy((osa_task_handle_t)s_commonTaskState->commonTaskHandle);
     s_commonTaskState->isInitialized = 0U;
 
     return kStatus_COMMON_TASK_Success;
 }
 
+#if (defined(COMMON_TASK_PRIORITY_QUEUE) && (COMMON_TASK_PRIORITY_QUEUE > 0U))
+common_task_status_t COMMON_TASK_post_message_with_priority(common_task_message_t *msg, uint8_t priority)
+{
+    common_task_msg_queue_t *queue;
+    common_task_msg_entry_t *entry;
+    common_task_status_t status = kStatus_COMMON_TASK_Success;
+    bool coalesced              = false;
+
+    assert(msg);
+    assert(msg->callback);
+    assert(s_commonTaskState->isInitialized);
+
+    if (priority >= COMMON_TASK_MSG_PRIORITY_COUNT)
+    {
+        return kStatus_COMMON_TASK_Error;
+    }
+    queue = &s_commonTaskState->queue[priority];
+
+    OSA_SR_ALLOC();
+    OSA_ENTER_CRITICAL();
+    /* The queue is short, a linear scan for a duplicate keeps the post bounded */
+    for (uint32_t i = 0U; i < queue->count; i++)
+    {
+        entry = &queue->entries[(queue->head + i) % COMMON_TASK_MAX_MSGQ_COUNT];
+        if ((entry->msg->callback == msg->callback) && (entry->msg->callbackParam == msg->callbackParam))
+        {
+            coalesced = true;
+            break;
+        }
+    }
+
+    if (coalesced)
+    {
+        queue->statistics.coalesced++;
+    }
+    else if (queue->count >= COMMON_TASK_MAX_MSGQ_COUNT)
+    {
+        queue->statistics.dropped++;
+        status = kStatus_COMMON_TASK_Busy;
+    }
+    else
+    {
+        entry         = &queue->entries[(queue->head + queue->count) % COMMON_TASK_MAX_MSGQ_COUNT];
+        entry->msg    = msg;
+        entry->cycles = COMMON_TASK_GET_CYCLES();
+        queue->count++;
+        queue->statistics.posted++;
+    }
+    OSA_EXIT_CRITICAL();
+
+    if ((kStatus_COMMON_TASK_Success == status) && !coalesced)
+    {
+        if (KOSA_StatusSuccess != OSA_SemaphorePost((osa_semaphore_handle_t)s_commonTaskState->semaphoreHandle))
+        {
+            status = kStatus_COMMON_TASK_Error;
+        }
+    }
+    return status;
+}
+
+common_task_status_t COMMON_TASK_get_statistics(uint8_t priority,
+                                                common_task_msg_statistics_t *statistics,
+                                                bool reset)
+{
+    assert(statistics);
+
+    if (priority >= COMMON_TASK_MSG_PRIORITY_COUNT)
+    {
+        return kStatus_COMMON_TASK_Error;
+    }
+
+    OSA_SR_ALLOC();
+    OSA_ENTER_CRITICAL();
+    *statistics = s_commonTaskState->queue[priority].statistics;
+    if (reset)
+    {
+        (void)memset(&s_commonTaskState->queue[priority].statistics, 0, sizeof(common_task_msg_statistics_t));
+    }
+    OSA_EXIT_CRITICAL();
+
+    return kStatus_COMMON_TASK_Success;
+}
+#endif /* COMMON_TASK_PRIORITY_QUEUE */
+
 common_task_status_t COMMON_TASK_post_message(common_task_message_t *msg)
 {
     assert(msg);
     assert(msg->callback);
     assert(s_commonTaskState->isInitialized);
 
+#if (defined(COMMON_TASK_PRIORITY_QUEUE) && (COMMON_TASK_PRIORITY_QUEUE > 0U))
+    if (kStatus_COMMON_TASK_Success != COMMON_TASK_post_message_with_priority(msg, COMMON_TASK_MSG_PRIORITY_DEFAULT))
+    {
+        return kStatus_COMMON_TASK_Error;
+    }
+#else
     if (KOSA_StatusSuccess != OSA_MsgQPut((osa_msgq_handle_t)s_commonTaskState->msgqhandle, &msg))
     {
         return kStatus_COMMON_TASK_Error;
     }
+#endif
     return kStatus_COMMON_TASK_Success;
 }
 
@@ -127,7 +299,21 @@ int COMMON_TASK_get_pending_message_count(void)
         return -1;
     }
 
+#if (defined(COMMON_TASK_PRIORITY_QUEUE) && (COMMON_TASK_PRIORITY_QUEUE > 0U))
+    int count = 0;
+
+    OSA_SR_ALLOC();
+    OSA_ENTER_CRITICAL();
+    for (uint32_t priority = 0U; priority < COMMON_TASK_MSG_PRIORITY_COUNT; priority++)
+    {
+        count += (int)s_commonTaskState->queue[priority].count;
+    }
+    OSA_EXIT_CRITICAL();
+
+    return count;
+#else
     return OSA_MsgQAvailableMsgs((osa_msgq_handle_t)s_commonTaskState->msgqhandle);
+#endif
 }
 #endif
 #endif
@@ -42,6 +42,44 @@
 #define COMMON_TASK_STACK_SIZE (2000U)
 #endif
 
+/*!
+ * @brief Enables the multi-priority message queue of common task.
+ *
+ * Messages are kept in one bounded queue per priority and the task always executes the oldest message of the
+ * highest pending priority. Posting a message whose callback and parameter are already pending at the same
+ * priority is coalesced into the pending one. Queue depth per priority is #COMMON_TASK_MAX_MSGQ_COUNT.
+ */
+#ifndef COMMON_TASK_PRIORITY_QUEUE
+#define COMMON_TASK_PRIORITY_QUEUE (0)
+#endif
+
+#if (defined(COMMON_TASK_PRIORITY_QUEUE) && (COMMON_TASK_PRIORITY_QUEUE > 0U))
+/*! @brief Definition of common task message priority count, priority 0 is the most urgent. */
+#ifndef COMMON_TASK_MSG_PRIORITY_COUNT
+#define COMMON_TASK_MSG_PRIORITY_COUNT (4U)
+#endif
+
+/*! @brief Definition of the priority used by #COMMON_TASK_post_message. */
+#ifndef COMMON_TASK_MSG_PRIORITY_DEFAULT
+#define COMMON_TASK_MSG_PRIORITY_DEFAULT (COMMON_TASK_MSG_PRIORITY_COUNT - 1U)
+#endif
+
+/*!
+ * @brief Definition of the free running cycle counter used for the latency statistics.
+ *
+ * Defaults to the DWT cycle counter, the application is responsible for enabling it. Latencies are reported in
+ * microseconds and must stay below one wrap of the counter.
+ */
+#ifndef COMMON_TASK_GET_CYCLES
+#define COMMON_TASK_GET_CYCLES() (DWT->CYCCNT)
+#endif
+
+/*! @brief Definition of the #COMMON_TASK_GET_CYCLES counts per microsecond. */
+#ifndef COMMON_TASK_CYCLES_PER_USEC
+#define COMMON_TASK_CYCLES_PER_USEC (SystemCoreClock / 1000000U)
+#endif
+#endif /* COMMON_TASK_PRIORITY_QUEUE */
+
 /*! @brief The status type of common task */
 typedef enum _common_task_status
 {
@@ -60,6 +98,19 @@ typedef struct _common_task_message
     void *callbackParam;
 } common_task_message_t;
 
+#if (defined(COMMON_TASK_PRIORITY_QUEUE) && (COMMON_TASK_PRIORITY_QUEUE > 0U))
+/*! @brief The message statistics of one common task priority */
+typedef struct _common_task_msg_statistics
+{
+    uint32_t posted;       /*!< Messages queued */
+    uint32_t coalesced;    /*!< Posts merged into an already pending message */
+    uint32_t dropped;      /*!< Posts rejected because the queue was full */
+    uint32_t executed;     /*!< Messages executed */
+    uint32_t latencyMax;   /*!< Longest time from post to execution, in microseconds */
+    uint32_t latencyTotal; /*!< Sum of post to execution times of executed messages, in microseconds */
+} common_task_msg_statistics_t;
+#endif /* COMMON_TASK_PRIORITY_QUEUE */
+
 /*******************************************************************************
  * API
  ******************************************************************************/
@@ -112,6 +163,36 @@ common_task_status_t COMMON_TASK_deinit(void);
  */
 common_task_status_t COMMON_TASK_post_message(common_task_message_t *msg);
 
+#if (defined(COMMON_TASK_PRIORITY_QUEUE) && (COMMON_TASK_PRIORITY_QUEUE > 0U))
+/*!
+ * @brief Posts a new message to common task with given priority
+ *
+ * This function is used to post a new message to the queue of the given priority. If a message with the same
+ * callback and callback parameter is already pending at that priority, the post is coalesced into it and the
+ * callback runs only once. The function can be called from interrupt context.
+ *
+ * @param msg Pointer to point to a memory space of #common_task_message_t allocated by the caller.
+ * @param priority Message priority, 0 is the most urgent, less than #COMMON_TASK_MSG_PRIORITY_COUNT.
+ * @retval kStatus_COMMON_TASK_Success The message is queued or coalesced.
+ * @retval kStatus_COMMON_TASK_Busy The queue of the priority is full.
+ * @retval kStatus_COMMON_TASK_Error An error occurred when post a message to the common task.
+ */
+common_task_status_t COMMON_TASK_post_message_with_priority(common_task_message_t *msg, uint8_t priority);
+
+/*!
+ * @brief Get the message statistics of a common task priority
+ *
+ * @param priority Message priority, less than #COMMON_TASK_MSG_PRIORITY_COUNT.
+ * @param statistics Filled with the statistics of the priority.
+ * @param reset Clear the statistics after reading them.
+ * @retval kStatus_COMMON_TASK_Success The statistics are read.
+ * @retval kStatus_COMMON_TASK_Error Invalid priority.
+ */
+common_task_status_t COMMON_TASK_get_statistics(uint8_t priority,
+                                                common_task_msg_statistics_t *statistics,
+                                                bool reset);
+#endif /* COMMON_TASK_PRIORITY_QUEUE */
+
 /*!
  * @brief Get the common task instance
  *
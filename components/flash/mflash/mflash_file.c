@@ -687,6 +687,234 @@ status_t mflash_file_save(const char *path, const uint8_t *data, uint32_t size)
     return status;
 }
 
+#if defined(MFLASH_FILE_WRITER_VERIFY) && MFLASH_FILE_WRITER_VERIFY
+/* Compare programmed data through the memory mapping, the driver invalidates the cache after programming */
+static status_t mflash_fs_verify(mflash_fs_t *fs, uint32_t offset, const void *data, uint32_t size)
+{
+    status_t status;
+    void *ptr = mflash_fs_get_ptr(fs, offset);
+
+    status = mflash_readable_check(ptr, size);
+    if (status != kStatus_Success)
+    {
+        return status;
+    }
+
+    return (memcmp(ptr, data, size) == 0) ? kStatus_Success : kStatus_Fail;
+}
+#endif
+
+/* Program a page of the file area being written and verify it */
+static status_t mflash_writer_page_program(mflash_file_writer_t *writer, uint32_t page_offset, const uint32_t *data)
+{
+    status_t status;
+    mflash_fs_t *fs = writer->fs;
+
+    status = mflash_fs_page_program(fs, writer->file_offset + page_offset, (uint32_t *)(uintptr_t)data);
+#if defined(MFLASH_FILE_WRITER_VERIFY) && MFLASH_FILE_WRITER_VERIFY
+    if (status == kStatus_Success)
+    {
+        status = mflash_fs_verify(fs, writer->file_offset + page_offset, data, MFLASH_PAGE_SIZE);
+    }
+#endif
+
+    return status;
+}
+
+/* Make sure the file area is erased up to given offset, erasing up to MFLASH_FILE_ERASE_AHEAD further */
+static status_t mflash_writer_erase_to(mflash_file_writer_t *writer, uint32_t end_offset)
+{
+    status_t status;
+    uint32_t target = end_offset + MFLASH_FILE_ERASE_AHEAD;
+
+    if (target > writer->alloc_size)
+    {
+        target = writer->alloc_size;
+    }
+
+    while (writer->erased_size < target)
+    {
+        status = mflash_fs_sector_erase(writer->fs, writer->file_offset + writer->erased_size);
+        if (status != kStatus_Success)
+        {
+            return status;
+        }
+        writer->erased_size += MFLASH_SECTOR_SIZE;
+    }
+
+    return kStatus_Success;
+}
+
+/* API, start streaming write of file with given path */
+status_t mflash_file_writer_open(mflash_file_writer_t *writer, const char *path)
+{
+    status_t status;
+    mflash_dir_record_t dr;
+    mflash_fs_t *fs = g_mflash_fs;
+
+    if ((writer == NULL) || (path == NULL))
+    {
+        return kStatus_InvalidArgument;
+    }
+
+    /* Lookup directory record */
+    status = mflash_dir_lookup(fs, path, &dr);
+    if (status != kStatus_Success)
+    {
+        return status;
+    }
+
+    writer->fs          = fs;
+    writer->file_offset = dr.file_offset;
+    writer->alloc_size  = dr.alloc_size;
+    writer->size        = 0u;
+    writer->erased_size = 0u;
+    writer->page_fill   = 0u;
+    (void)memset(writer->first_page, (int)MFLASH_BLANK_PATTERN, MFLASH_PAGE_SIZE);
+
+    /* Erasing the first sector invalidates the meta of the previous file content */
+    status = mflash_writer_erase_to(writer, MFLASH_PAGE_SIZE);
+    if (status != kStatus_Success)
+    {
+        writer->fs = NULL;
+    }
+
+    return status;
+}
+
+/* API, append data to file being written */
+status_t mflash_file_writer_write(mflash_file_writer_t *writer, const uint8_t *data, uint32_t size)
+{
+    status_t status;
+    uint32_t head_size = MFLASH_PAGE_SIZE - sizeof(mflash_file_meta_t);
+
+    if ((writer == NULL) || (writer->fs == NULL))
+    {
+        return kStatus_InvalidArgument;
+    }
+
+    if ((data == NULL) && (size != 0u))
+    {
+        return kStatus_InvalidArgument;
+    }
+
+    /* Check whether the data + meta fits into the pre-allocated file area */
+    if (writer->size + size + sizeof(mflash_file_meta_t) > writer->alloc_size)
+    {
+        return kStatus_OutOfRange;
+    }
+
+    while (size > 0u)
+    {
+        uint32_t copy_size;
+        /* Offset of the write cursor within the file area, meta occupies the very beginning of the first page */
+        uint32_t offset = writer->size + sizeof(mflash_file_meta_t);
+
+        /* Head of the data shares the first page with meta, keep it until the file is committed */
+        if (writer->size < head_size)
+        {
+            copy_size = MIN(size, head_size - writer->size);
+            (void)memcpy((uint8_t *)writer->first_page + offset, data, copy_size);
+        }
+        /* Whole aligned page in a RAM caller buffer, program it in place. Data memory mapped from the flash itself
+         * cannot be read while the flash is being programmed, so it is copied through the page buffer below. */
+        else if ((writer->page_fill == 0u) && (size >= MFLASH_PAGE_SIZE) && (((uintptr_t)data & 3u) == 0u) &&
+                 (mflash_drv_log2phys((void *)data, MFLASH_PAGE_SIZE) == MFLASH_INVALID_ADDRESS))
+        {
+            copy_size = MFLASH_PAGE_SIZE;
+
+            status = mflash_writer_erase_to(writer, offset + MFLASH_PAGE_SIZE);
+            if (status != kStatus_Success)
+            {
+                return status;
+            }
+
+            status = mflash_writer_page_program(writer, offset, (const uint32_t *)(const void *)data);
+            if (status != kStatus_Success)
+            {
+                return status;
+            }
+        }
+        /* Partial or unaligned page, collect it in the page buffer */
+        else
+        {
+            copy_size = MIN(size, MFLASH_PAGE_SIZE - writer->page_fill);
+            (void)memcpy((uint8_t *)writer->page_buf + writer->page_fill, data, copy_size);
+            writer->page_fill += copy_size;
+
+            if (writer->page_fill == MFLASH_PAGE_SIZE)
+            {
+                uint32_t page_offset = offset + copy_size - MFLASH_PAGE_SIZE;
+
+                status = mflash_writer_erase_to(writer, page_offset + MFLASH_PAGE_SIZE);
+                if (status != kStatus_Success)
+                {
+                    return status;
+                }
+
+                status = mflash_writer_page_program(writer, page_offset, writer->page_buf);
+                if (status != kStatus_Success)
+                {
+                    return status;
+                }
+
+                writer->page_fill = 0u;
+            }
+        }
+
+        writer->size += copy_size;
+        data += copy_size;
+        size -= copy_size;
+    }
+
+    return kStatus_Success;
+}
+
+/* API, flush pending data and commit the file */
+status_t mflash_file_writer_close(mflash_file_writer_t *writer)
+{
+    status_t status;
+    mflash_file_meta_t *meta;
+
+    if ((writer == NULL) || (writer->fs == NULL))
+    {
+        return kStatus_InvalidArgument;
+    }
+
+    /* Program the last partial page padded with blank pattern */
+    if (writer->page_fill > 0u)
+    {
+        uint32_t page_offset = writer->size + sizeof(mflash_file_meta_t) - writer->page_fill;
+
+        (void)memset((uint8_t *)writer->page_buf + writer->page_fill, (int)MFLASH_BLANK_PATTERN,
+                     MFLASH_PAGE_SIZE - writer->page_fill);
+
+        status = mflash_writer_erase_to(writer, page_offset + MFLASH_PAGE_SIZE);
+        if (status == kStatus_Success)
+        {
+            status = mflash_writer_page_program(writer, page_offset, writer->page_buf);
+        }
+        if (status != kStatus_Success)
+        {
+            writer->fs = NULL;
+            return status;
+        }
+        writer->page_fill = 0u;
+    }
+
+    /* Set file metadata */
+    meta            = (mflash_file_meta_t *)(void *)writer->first_page;
+    meta->file_size = writer->size;
+    meta->magic_no  = MFLASH_META_MAGIC_NO;
+
+    /* Program the first page putting the metadata in place which marks the file as valid */
+    status = mflash_writer_page_program(writer, 0u, writer->first_page);
+
+    writer->fs = NULL;
+
+    return status;
+}
+
 /* Get direct pointer to file data */
 static status_t mflash_file_mmap_internal(mflash_fs_t *fs, mflash_dir_record_t *dr, const uint8_t **pdata, uint32_t *psize)
 {
@@ -23,6 +23,32 @@ typedef struct
     uint32_t max_size;
 } mflash_file_t;
 
+/*! @brief Number of bytes erased ahead of the write cursor by the streaming writer. */
+#ifndef MFLASH_FILE_ERASE_AHEAD
+#define MFLASH_FILE_ERASE_AHEAD (MFLASH_SECTOR_SIZE)
+#endif
+
+/*! @brief Verify programmed pages through the memory mapping instead of a driver read-back. */
+#ifndef MFLASH_FILE_WRITER_VERIFY
+#define MFLASH_FILE_WRITER_VERIFY 1
+#endif
+
+/*
+ * State of a streaming file write. The structure is owned by the caller and must stay valid between
+ * mflash_file_writer_open and mflash_file_writer_close, its content is private to mflash.
+ */
+typedef struct
+{
+    void *fs;
+    uint32_t file_offset;  /* offset of the file area within the filesystem */
+    uint32_t alloc_size;   /* size of the pre-allocated file area */
+    uint32_t size;         /* file data written so far */
+    uint32_t erased_size;  /* bytes of the file area already erased */
+    uint32_t page_fill;    /* bytes pending in page_buf */
+    uint32_t first_page[MFLASH_PAGE_SIZE / sizeof(uint32_t)]; /* meta + head of data, programmed on close */
+    uint32_t page_buf[MFLASH_PAGE_SIZE / sizeof(uint32_t)];   /* partial page pending programming */
+} mflash_file_writer_t;
+
 /*! @brief Initialization status of mflash subsystem */
 bool mflash_is_initialized(void);
 
@@ -32,6 +58,27 @@ status_t mflash_init(const mflash_file_t *dir_template, bool init_drv);
 /*! @brief Saves data to file with given path. */
 status_t mflash_file_save(const char *path, const uint8_t *data, uint32_t size);
 
+/*!
+ * @brief Starts a streaming write of the file with given path.
+ *
+ * The previous content of the file is invalidated immediately. Data is then appended by mflash_file_writer_write
+ * and the file becomes valid only once mflash_file_writer_close succeeds.
+ */
+status_t mflash_file_writer_open(mflash_file_writer_t *writer, const char *path);
+
+/*!
+ * @brief Appends data to a file opened by mflash_file_writer_open.
+ *
+ * Whole pages of word aligned data are programmed directly from the caller buffer, only unaligned or partial
+ * pages are copied. Data residing in the memory mapped (XIP) flash, e.g. another file obtained by mflash_file_mmap,
+ * cannot be read while the flash is programmed and is always copied through the page buffer. Sectors are erased
+ * just ahead of the write cursor.
+ */
+status_t mflash_file_writer_write(mflash_file_writer_t *writer, const uint8_t *data, uint32_t size);
+
+/*! @brief Flushes pending data and commits the file metadata, making the file valid. */
+status_t mflash_file_writer_close(mflash_file_writer_t *writer);
+
 /*! @brief Returns pointer for direct memory mapped access to file data. */
 status_t mflash_file_mmap(const char *path, const uint8_t **pdata, uint32_t *psize);
 
@@ -86,6 +86,15 @@ typedef struct _mem_pool_structure
     uint16_t blockSize;
     uint16_t numBlocks;
     uint16_t allocatedBlocks;
+#if (defined(MEM_MANAGER_LIFO_POOL) && (MEM_MANAGER_LIFO_POOL > 0U))
+    struct _block_list_header *volatile freeList;
+    uint16_t flags;
+    uint16_t allocatedBlocksMax;
+    uint32_t allocationFailures;
+#if (MEM_LIFO_LATENCY_BINS > 0U)
+    uint16_t latency[MEM_LIFO_LATENCY_BINS];
+#endif
+#endif /*MEM_MANAGER_LIFO_POOL*/
 } mem_pool_structure_t;
 
 /*! @brief Header description for buffers.*/
@@ -97,6 +106,9 @@ typedef struct _block_list_header
     uint32_t caller;
     uint16_t allocatedBytes;
 #endif /*MEM_MANAGER_ENABLE_TRACE*/
+#if (defined(MEM_MANAGER_LIFO_POOL) && (MEM_MANAGER_LIFO_POOL > 0U))
+    mem_pool_structure_t *pool;
+#endif /*MEM_MANAGER_LIFO_POOL*/
 } block_list_header_t;
 
 /*! @brief State structure for memory manager. */
@@ -136,6 +148,30 @@ static mem_statis_t s_memStatis;
 ******************************************************************************
 *****************************************************************************/
 #define BLOCK_HDR_SIZE sizeof(block_list_header_t)
+
+#if (defined(MEM_MANAGER_LIFO_POOL) && (MEM_MANAGER_LIFO_POOL > 0U))
+/* Value of block_list_header_t::allocated for a block handed out by a LIFO pool */
+#define MEM_BLOCK_ALLOCATED_LIFO (0x4C49U)
+
+/* clang-format off */
+#if ((defined(__ARM_ARCH_7M__     ) && (__ARM_ARCH_7M__      == 1)) || \
+     (defined(__ARM_ARCH_7EM__    ) && (__ARM_ARCH_7EM__     == 1)) || \
+     (defined(__ARM_ARCH_8M_MAIN__) && (__ARM_ARCH_8M_MAIN__ == 1)) || \
+     (defined(__ARM_ARCH_8M_BASE__) && (__ARM_ARCH_8M_BASE__ == 1)))
+/* clang-format on */
+/* Exception entry and return clear the local exclusive monitor, so a LDREX/STREX sequence interrupted by an ISR
+ * or a context switch always retries. This makes the free-list immune to ABA without a critical section. */
+#define MEM_LIFO_USE_EXCLUSIVE (1)
+#else
+#define MEM_LIFO_USE_EXCLUSIVE (0)
+#endif
+
+#if (MEM_LIFO_LATENCY_BINS > 0U)
+#ifndef MEM_LIFO_GET_CYCLES
+#define MEM_LIFO_GET_CYCLES() (DWT->CYCCNT)
+#endif
+#endif
+#endif /* MEM_MANAGER_LIFO_POOL */
 /*****************************************************************************
 ******************************************************************************
 * Private functions
@@ -228,6 +264,191 @@ static void MEM_BufferFrees_memStatis(void *buffer)
     s_memStatis.ram_lost -= (block_size - pBlock->allocatedBytes);
 }
 #endif
+#if (defined(MEM_MANAGER_LIFO_POOL) && (MEM_MANAGER_LIFO_POOL > 0U))
+/* Free blocks store the next free block at the start of their payload. */
+static inline block_list_header_t **MEM_LifoNext(block_list_header_t *pBlock)
+{
+    return (block_list_header_t **)(void *)(pBlock + 1);
+}
+
+static void MEM_LifoPush(mem_pool_structure_t *pPool, block_list_header_t *pBlock)
+{
+#if (MEM_LIFO_USE_EXCLUSIVE > 0U)
+    uint32_t head;
+    /* Uncounted before it is back on the free-list, an allocation of the block from an interrupt in between
+     * would otherwise count it twice and raise allocatedBlocksMax above the blocks really in use */
+    SDK_ATOMIC_LOCAL_SUB(&pPool->allocatedBlocks, 1U);
+    do
+    {
+        head                   = __LDREXW((volatile uint32_t *)(volatile void *)&pPool->freeList);
+        *MEM_LifoNext(pBlock) = (block_list_header_t *)head;
+    } while (0U != __STREXW((uint32_t)pBlock, (volatile uint32_t *)(volatile void *)&pPool->freeList));
+#else
+    MEM_ENTER_CRITICAL();
+    *MEM_LifoNext(pBlock) = pPool->freeList;
+    pPool->freeList        = pBlock;
+    pPool->allocatedBlocks--;
+    MEM_EXIT_CRITICAL();
+#endif
+}
+
+static block_list_header_t *MEM_LifoPop(mem_pool_structure_t *pPool)
+{
+    block_list_header_t *pBlock;
+#if (MEM_LIFO_USE_EXCLUSIVE > 0U)
+    uint32_t allocated;
+    uint32_t peak;
+    do
+    {
+        pBlock = (block_list_header_t *)__LDREXW((volatile uint32_t *)(volatile void *)&pPool->freeList);
+        if (NULL == pBlock)
+        {
+            __CLREX();
+            return NULL;
+        }
+    } while (0U != __STREXW((uint32_t)*MEM_LifoNext(pBlock), (volatile uint32_t *)(volatile void *)&pPool->freeList));
+
+    /* Counted only once the block is off the free-list */
+    do
+    {
+        allocated = (uint32_t)__LDREXH(&pPool->allocatedBlocks) + 1U;
+    } while (0U != __STREXH((uint16_t)allocated, &pPool->allocatedBlocks));
+
+    do
+    {
+        peak = __LDREXH(&pPool->allocatedBlocksMax);
+        if (allocated <= peak)
+        {
+            __CLREX();
+            break;
+        }
+    } while (0U != __STREXH((uint16_t)allocated, &pPool->allocatedBlocksMax));
+#else
+    MEM_ENTER_CRITICAL();
+    pBlock = pPool->freeList;
+    if (NULL != pBlock)
+    {
+        pPool->freeList = *MEM_LifoNext(pBlock);
+        pPool->allocatedBlocks++;
+        if (pPool->allocatedBlocks > pPool->allocatedBlocksMax)
+        {
+            pPool->allocatedBlocksMax = pPool->allocatedBlocks;
+        }
+    }
+    MEM_EXIT_CRITICAL();
+#endif
+    return pBlock;
+}
+
+/* Counted by the callers, only once no pool can serve the request */
+static void MEM_LifoCountFailure(mem_pool_structure_t *pPool)
+{
+#if (MEM_LIFO_USE_EXCLUSIVE > 0U)
+    SDK_ATOMIC_LOCAL_ADD(&pPool->allocationFailures, 1U);
+#else
+    MEM_ENTER_CRITICAL();
+    pPool->allocationFailures++;
+    MEM_EXIT_CRITICAL();
+#endif
+}
+
+static void MEM_LifoPoolInit(mem_pool_structure_t *pPool)
+{
+    block_list_header_t *pBlock;
+    uint32_t i = pPool->numBlocks;
+
+    pPool->freeList = NULL;
+    /* Push in reverse so blocks are handed out in address order */
+    while (i > 0U)
+    {
+        i--;
+        pBlock = (block_list_header_t *)(void *)(pPool->pHeap +
+                                                 i * ((uint32_t)pPool->blockSize + (uint32_t)BLOCK_HDR_SIZE));
+        pBlock->allocated     = 0U;
+        pBlock->blockSize     = pPool->blockSize;
+        pBlock->pool          = pPool;
+        *MEM_LifoNext(pBlock) = pPool->freeList;
+        pPool->freeList       = pBlock;
+    }
+    pPool->allocatedBlocks    = 0U;
+    pPool->allocatedBlocksMax = 0U;
+    pPool->allocationFailures = 0U;
+#if (MEM_LIFO_LATENCY_BINS > 0U)
+    (void)memset(pPool->latency, 0x0, sizeof(pPool->latency));
+#endif
+}
+
+#if (MEM_LIFO_LATENCY_BINS > 0U)
+static void MEM_LifoRecordLatency(mem_pool_structure_t *pPool, uint32_t cycles)
+{
+    uint32_t bin   = 0U;
+    uint32_t limit = MEM_LIFO_LATENCY_BIN_CYCLES;
+
+    while ((bin < (MEM_LIFO_LATENCY_BINS - 1U)) && (cycles >= limit))
+    {
+        bin++;
+        limit <<= 1U;
+    }
+    /* Histogram bins saturate, a lost increment under contention is acceptable */
+    if (pPool->latency[bin] != UINT16_MAX)
+    {
+        pPool->latency[bin]++;
+    }
+}
+#endif
+
+static void *MEM_LifoPoolAlloc(mem_pool_structure_t *pPool, uint32_t numBytes)
+{
+    block_list_header_t *pBlock;
+#if (MEM_LIFO_LATENCY_BINS > 0U)
+    uint32_t start = MEM_LIFO_GET_CYCLES();
+#endif
+
+    pBlock = MEM_LifoPop(pPool);
+    if (NULL == pBlock)
+    {
+        return NULL;
+    }
+    pBlock->allocated = MEM_BLOCK_ALLOCATED_LIFO;
+#if (defined(MEM_MANAGER_ENABLE_TRACE) && (MEM_MANAGER_ENABLE_TRACE > 0U))
+    pBlock->allocatedBytes = (uint16_t)numBytes;
+    pBlock->caller         = (uint32_t)((uint32_t *)__mem_get_LR());
+#else
+    (void)numBytes;
+#endif /*MEM_MANAGER_ENABLE_TRACE*/
+    pBlock++;
+    /* Keep the zero-initialised buffer semantic of the pool search path */
+    (void)memset(pBlock, 0x0, pPool->blockSize);
+#if (MEM_LIFO_LATENCY_BINS > 0U)
+    MEM_LifoRecordLatency(pPool, MEM_LIFO_GET_CYCLES() - start);
+#endif
+    return pBlock;
+}
+#endif /* MEM_MANAGER_LIFO_POOL */
+
+#if (defined(MEM_MANAGER_ENABLE_TRACE) && (MEM_MANAGER_ENABLE_TRACE > 0U))
+static void MEM_BufferAllocTrace(mem_pool_structure_t *pPool, uint32_t numBytes)
+{
+    uint32_t fragmentWaste;
+
+    if (pPool->allocatedBlocks > pPool->allocatedBlocksPeak)
+    {
+        pPool->allocatedBlocksPeak = pPool->allocatedBlocks;
+    }
+    fragmentWaste = pPool->blockSize - numBytes;
+    if (fragmentWaste > pPool->poolFragmentWastePeak)
+    {
+        pPool->poolFragmentWastePeak = (uint16_t)fragmentWaste;
+    }
+    pPool->poolFragmentWaste = (uint16_t)fragmentWaste;
+    pPool->poolTotalFragmentWaste += (uint16_t)fragmentWaste;
+    if (fragmentWaste < pPool->poolFragmentMinWaste)
+    {
+        pPool->poolFragmentMinWaste = (uint16_t)fragmentWaste;
+    }
+}
+#endif /*MEM_MANAGER_ENABLE_TRACE*/
+
 #if defined(MEM_STATISTICS_INTERNAL)
 static void MEM_Reports_memStatis(void)
 {
@@ -339,6 +560,13 @@ mem_status_t MEM_AddBuffer(const uint8_t *buffer)
     pPool->poolFragmentWastePeak  = 0;
     pPool->poolFragmentMinWaste   = 0xffff;
 #endif /*MEM_MANAGER_ENABLE_TRACE*/
+#if (defined(MEM_MANAGER_LIFO_POOL) && (MEM_MANAGER_LIFO_POOL > 0U))
+    pPool->flags = memConfig->reserved;
+    if (0U != (pPool->flags & MEM_POOL_FLAG_LIFO))
+    {
+        MEM_LifoPoolInit(pPool);
+    }
+#endif /*MEM_MANAGER_LIFO_POOL*/
     if (s_memmanager.pHeadPool == NULL)
     {
         s_memmanager.pHeadPool = pPool;
@@ -441,12 +669,12 @@ mem_status_t MEM_RemoveBuffer(uint8_t *buffer)
  */
 void *MEM_BufferAllocWithId(uint32_t numBytes, uint8_t poolId)
 {
-#if (defined(MEM_MANAGER_ENABLE_TRACE) && (MEM_MANAGER_ENABLE_TRACE > 0U))
-    uint32_t fragmentWaste = 0;
-#endif /*MEM_MANAGER_ENABLE_TRACE*/
     mem_pool_structure_t *pPool = s_memmanager.pHeadPool;
     block_list_header_t *pBlock;
     void *buffer = NULL;
+#if (defined(MEM_MANAGER_LIFO_POOL) && (MEM_MANAGER_LIFO_POOL > 0U))
+    mem_pool_structure_t *pEmptyLifoPool = NULL;
+#endif /*MEM_MANAGER_LIFO_POOL*/
 
     MEM_ENTER_CRITICAL();
 #ifdef MEM_MANAGER_BENCH
@@ -458,6 +686,17 @@ void *MEM_BufferAllocWithId(uint32_t numBytes, uint8_t poolId)
     {
         if ((numBytes <= pPool->blockSize) && (pPool->poolId == poolId))
         {
+#if (defined(MEM_MANAGER_LIFO_POOL) && (MEM_MANAGER_LIFO_POOL > 0U))
+            if (0U != (pPool->flags & MEM_POOL_FLAG_LIFO))
+            {
+                buffer = MEM_LifoPoolAlloc(pPool, numBytes);
+                if ((NULL == buffer) && (NULL == pEmptyLifoPool))
+                {
+                    pEmptyLifoPool = pPool;
+                }
+            }
+            else
+#endif /*MEM_MANAGER_LIFO_POOL*/
             for (uint32_t i = 0; i < pPool->numBlocks; i++)
             {
                 pBlock = (block_list_header_t *)(void *)(pPool->pHeap + i * ((uint32_t)pPool->blockSize +
@@ -499,6 +738,13 @@ void *MEM_BufferAllocWithId(uint32_t numBytes, uint8_t poolId)
         s_memmanager.allocationFailures++;
     }
 #endif /*MEM_MANAGER_ENABLE_TRACE*/
+#if (defined(MEM_MANAGER_LIFO_POOL) && (MEM_MANAGER_LIFO_POOL > 0U))
+    /* The failure belongs to the first LIFO pool found empty, and only if no later pool served the request */
+    if ((NULL == buffer) && (NULL != pEmptyLifoPool))
+    {
+        MEM_LifoCountFailure(pEmptyLifoPool);
+    }
+#endif /*MEM_MANAGER_LIFO_POOL*/
 
 #ifdef MEM_STATISTICS_INTERNAL
 #ifdef MEM_MANAGER_BENCH
@@ -513,21 +759,7 @@ void *MEM_BufferAllocWithId(uint32_t numBytes, uint8_t poolId)
     }
 #endif /* MEM_STATISTICS_INTERNAL */
 #if (defined(MEM_MANAGER_ENABLE_TRACE) && (MEM_MANAGER_ENABLE_TRACE > 0U))
-    if (pPool->allocatedBlocks > pPool->allocatedBlocksPeak)
-    {
-        pPool->allocatedBlocksPeak = pPool->allocatedBlocks;
-    }
-    fragmentWaste = pPool->blockSize - numBytes;
-    if (fragmentWaste > pPool->poolFragmentWastePeak)
-    {
-        pPool->poolFragmentWastePeak = (uint16_t)fragmentWaste;
-    }
-    pPool->poolFragmentWaste = (uint16_t)fragmentWaste;
-    pPool->poolTotalFragmentWaste += (uint16_t)fragmentWaste;
-    if (fragmentWaste < pPool->poolFragmentMinWaste)
-    {
-        pPool->poolFragmentMinWaste = (uint16_t)fragmentWaste;
-    }
+    MEM_BufferAllocTrace(pPool, numBytes);
 #endif /*MEM_MANAGER_ENABLE_TRACE*/
     MEM_EXIT_CRITICAL();
     return buffer;
@@ -545,6 +777,30 @@ mem_status_t MEM_BufferFree(void *buffer /* IN: Block of memory to free*/
 {
     block_list_header_t *pBlock;
     mem_pool_structure_t *pPool = s_memmanager.pHeadPool;
+
+#if (defined(MEM_MANAGER_LIFO_POOL) && (MEM_MANAGER_LIFO_POOL > 0U))
+    /* LIFO pool blocks know their pool, return them without the critical section or pool search */
+    if ((NULL != buffer) && (MEM_BLOCK_ALLOCATED_LIFO == ((block_list_header_t *)buffer - 1)->allocated))
+    {
+        pBlock = (block_list_header_t *)buffer - 1;
+#if defined(MEM_STATISTICS_INTERNAL)
+        {
+            MEM_ENTER_CRITICAL();
+            MEM_BufferFrees_memStatis(buffer);
+            MEM_EXIT_CRITICAL();
+        }
+#endif /* MEM_STATISTICS_INTERNAL */
+#if (defined(MEM_MANAGER_ENABLE_TRACE) && (MEM_MANAGER_ENABLE_TRACE > 0U))
+        /* Same as the memset of the pool search path, the header keeps its pool and size */
+        pBlock->caller         = 0U;
+        pBlock->allocatedBytes = 0U;
+#endif /*MEM_MANAGER_ENABLE_TRACE*/
+        pBlock->allocated = 0U;
+        MEM_LifoPush(pBlock->pool, pBlock);
+        return kStatus_MemSuccess;
+    }
+#endif /*MEM_MANAGER_LIFO_POOL*/
+
     MEM_ENTER_CRITICAL();
 
     do
@@ -635,6 +891,12 @@ mem_status_t MEM_BufferFreeAllWithId(uint8_t poolId)
             pPool->poolFragmentMinWaste   = 0xffff;
 #endif /*MEM_MANAGER_ENABLE_TRACE*/
             pPool->allocatedBlocks = 0;
+#if (defined(MEM_MANAGER_LIFO_POOL) && (MEM_MANAGER_LIFO_POOL > 0U))
+            if (0U != (pPool->flags & MEM_POOL_FLAG_LIFO))
+            {
+                MEM_LifoPoolInit(pPool);
+            }
+#endif /*MEM_MANAGER_LIFO_POOL*/
         }
         pPool = pPool->nextPool;
     }
@@ -643,6 +905,101 @@ mem_status_t MEM_BufferFreeAllWithId(uint8_t poolId)
     return kStatus_MemSuccess;
 }
 
+#if (defined(MEM_MANAGER_LIFO_POOL) && (MEM_MANAGER_LIFO_POOL > 0U))
+/*!
+ * @brief Allocate a block from a given LIFO pool in constant time.
+ *
+ * @param buffer             Pointer the memory pool buffer, use MEM_BLOCK_BUFFER Macro as the input parameter.
+ * @retval Memory buffer address when allocate success, NULL when the pool is empty or not a LIFO pool.
+ */
+void *MEM_BufferAllocFromPool(const uint8_t *buffer)
+{
+    mem_config_t *memConfig     = (mem_config_t *)(void *)buffer;
+    mem_pool_structure_t *pPool = (mem_pool_structure_t *)(void *)memConfig->pbuffer;
+    void *block;
+
+    assert(buffer);
+
+    if (0U == (pPool->flags & MEM_POOL_FLAG_LIFO))
+    {
+        return NULL;
+    }
+    block = MEM_LifoPoolAlloc(pPool, pPool->blockSize);
+    if (NULL == block)
+    {
+        MEM_LifoCountFailure(pPool);
+    }
+#if (defined(MEM_STATISTICS_INTERNAL) || (defined(MEM_MANAGER_ENABLE_TRACE) && (MEM_MANAGER_ENABLE_TRACE > 0U)))
+    /* Same accounting as MEM_BufferAllocWithId, the fast path is only lock-free without it */
+    {
+        MEM_ENTER_CRITICAL();
+#if (defined(MEM_MANAGER_ENABLE_TRACE) && (MEM_MANAGER_ENABLE_TRACE > 0U))
+        if (NULL == block)
+        {
+            s_memmanager.allocationFailures++;
+        }
+        else
+        {
+            MEM_BufferAllocTrace(pPool, pPool->blockSize);
+        }
+#endif /*MEM_MANAGER_ENABLE_TRACE*/
+#ifdef MEM_STATISTICS_INTERNAL
+        if (NULL != block)
+        {
+            MEM_BufferAllocates_memStatis(block, 0, pPool->blockSize);
+        }
+#endif /* MEM_STATISTICS_INTERNAL */
+        MEM_EXIT_CRITICAL();
+    }
+#endif
+    return block;
+}
+
+/*!
+ * @brief Get the statistics of a LIFO pool.
+ *
+ * @param block                     Pointer the memory pool block, use MEM_BLOCK_BUFFER Macro as the input parameter.
+ * @param statistics                 Filled with the pool statistics.
+ * @param reset                      Clear high-water mark, failure counter and latency histogram after reading.
+ *
+ * @retval kStatus_MemSuccess        Statistics read.
+ * @retval kStatus_MemUnknownError   The pool is not a LIFO pool.
+ */
+mem_status_t MEM_GetPoolStatistics(const uint8_t *buffer, mem_pool_statistics_t *statistics, bool reset)
+{
+    mem_config_t *memConfig     = (mem_config_t *)(void *)buffer;
+    mem_pool_structure_t *pPool = (mem_pool_structure_t *)(void *)memConfig->pbuffer;
+
+    assert(buffer);
+    assert(statistics);
+
+    if (0U == (pPool->flags & MEM_POOL_FLAG_LIFO))
+    {
+        return kStatus_MemUnknownError;
+    }
+
+    MEM_ENTER_CRITICAL();
+    statistics->numBlocks          = pPool->numBlocks;
+    statistics->allocatedBlocks    = pPool->allocatedBlocks;
+    statistics->allocatedBlocksMax = pPool->allocatedBlocksMax;
+    statistics->reserved           = 0U;
+    statistics->allocationFailures = pPool->allocationFailures;
+#if (MEM_LIFO_LATENCY_BINS > 0U)
+    (void)memcpy(statistics->latency, pPool->latency, sizeof(statistics->latency));
+#endif
+    if (reset)
+    {
+        pPool->allocatedBlocksMax = pPool->allocatedBlocks;
+        pPool->allocationFailures = 0U;
+#if (MEM_LIFO_LATENCY_BINS > 0U)
+        (void)memset(pPool->latency, 0x0, sizeof(pPool->latency));
+#endif
+    }
+    MEM_EXIT_CRITICAL();
+    return kStatus_MemSuccess;
+}
+#endif /*MEM_MANAGER_LIFO_POOL*/
+
 mem_status_t MEM_BufferCheck(void *buffer, uint32_t size)
 {
     /* NOT IMPLEMENTED */
@@ -747,6 +1104,21 @@ void MEM_Trace(void)
             "              %d\r\n",
             pPool->numBlocks, pPool->allocatedBlocks, pPool->allocatedBlocksPeak, pPool->poolFragmentWaste,
             pPool->poolFragmentWastePeak, pPool->poolFragmentMinWaste, pPool->poolTotalFragmentWaste);
+#if (defined(MEM_MANAGER_LIFO_POOL) && (MEM_MANAGER_LIFO_POOL > 0U))
+        if (0U != (pPool->flags & MEM_POOL_FLAG_LIFO))
+        {
+            (void)PRINTF("LIFO pool allocatedBlocksMax: %d  allocationFailures: %d\r\n", pPool->allocatedBlocksMax,
+                         pPool->allocationFailures);
+#if (MEM_LIFO_LATENCY_BINS > 0U)
+            for (uint32_t i = 0; i < MEM_LIFO_LATENCY_BINS; i++)
+            {
+                (void)PRINTF("  %s %d cycles: %d\r\n", (i < (MEM_LIFO_LATENCY_BINS - 1U)) ? "< " : ">=",
+                             MEM_LIFO_LATENCY_BIN_CYCLES << ((i < (MEM_LIFO_LATENCY_BINS - 1U)) ? i : (i - 1U)),
+                             pPool->latency[i]);
+            }
+#endif
+        }
+#endif /*MEM_MANAGER_LIFO_POOL*/
         (void)PRINTF("Currently pool meory block allocate status:\r\n");
         for (uint32_t i = 0; i < pPool->numBlocks; i++)
         {
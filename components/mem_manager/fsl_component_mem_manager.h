@@ -66,22 +66,63 @@
 #define MEM_MANAGER_PRE_CONFIGURE (1)
 #endif
 
+/*!
+ * @brief Configures the memory manager LIFO pool mode.
+ *
+ * When enabled, pools added with the MEM_POOL_FLAG_LIFO flag keep their free blocks in a LIFO free-list,
+ * so allocating and freeing a block is O(1) and does not take the global critical section on cores that
+ * support LDREX/STREX, which makes these pools safe to use from interrupt context. Each block header grows
+ * by one pointer to remember its owning pool.
+ */
+#ifndef MEM_MANAGER_LIFO_POOL
+#define MEM_MANAGER_LIFO_POOL (0)
+#endif
+
+#if (defined(MEM_MANAGER_LIFO_POOL) && (MEM_MANAGER_LIFO_POOL > 0U))
+/*!
+ * @brief Number of allocation latency histogram bins kept per LIFO pool, must be even. 0 disables the histogram.
+ *
+ * Bin n counts allocations that took less than (MEM_LIFO_LATENCY_BIN_CYCLES << n) cycles, the last bin counts
+ * all slower ones. Latency is read with MEM_LIFO_GET_CYCLES(), which defaults to the DWT cycle counter; the
+ * application is responsible for enabling it.
+ */
+#ifndef MEM_LIFO_LATENCY_BINS
+#define MEM_LIFO_LATENCY_BINS (0U)
+#endif
+#ifndef MEM_LIFO_LATENCY_BIN_CYCLES
+#define MEM_LIFO_LATENCY_BIN_CYCLES (16U)
+#endif
+#define MEM_POOL_LIFO_SIZE  (12U + 2U * MEM_LIFO_LATENCY_BINS)
+#define MEM_BLOCK_LIFO_SIZE (4U)
+#else
+#define MEM_POOL_LIFO_SIZE  (0U)
+#define MEM_BLOCK_LIFO_SIZE (0U)
+#endif
+
 #if (defined(MEM_MANAGER_ENABLE_TRACE) && (MEM_MANAGER_ENABLE_TRACE > 0U))
 #ifndef MEM_POOL_SIZE
-#define MEM_POOL_SIZE (32U)
+#define MEM_POOL_SIZE (32U + MEM_POOL_LIFO_SIZE)
 #endif
 #ifndef MEM_BLOCK_SIZE
-#define MEM_BLOCK_SIZE (12U)
+#define MEM_BLOCK_SIZE (12U + MEM_BLOCK_LIFO_SIZE)
 #endif
 #else
 #ifndef MEM_POOL_SIZE
-#define MEM_POOL_SIZE (20U)
+#define MEM_POOL_SIZE (20U + MEM_POOL_LIFO_SIZE)
 #endif
 #ifndef MEM_BLOCK_SIZE
-#define MEM_BLOCK_SIZE (4U)
+#define MEM_BLOCK_SIZE (4U + MEM_BLOCK_LIFO_SIZE)
 #endif
 #endif
 
+/*! @brief Pool flag, the pool keeps its free blocks in a LIFO free-list (requires MEM_MANAGER_LIFO_POOL). */
+#define MEM_POOL_FLAG_LIFO (1U << 0)
+
+/*! @brief Flags applied to the pools defined by PoolsDetails_c. */
+#ifndef MEM_POOL_DEFAULT_FLAGS
+#define MEM_POOL_DEFAULT_FLAGS (0U)
+#endif
+
 #define MAX_POOL_ID 3U
 
 /* Debug Macros - stub if not defined */
@@ -113,7 +154,8 @@
 #define MEM_BLOCK_BUFFER_NONAME_DEFINE(blockSize, numberOfBlocks, id)                   \
     MEM_BLOCK_DATA_BUFFER_NONAME_DEFINE(blockSize, numberOfBlocks, id)                  \
     const static mem_config_t g_poolHeadBuffer##blockSize##_##numberOfBlocks##_##id = { \
-        (blockSize), (numberOfBlocks), (id), (0), (uint8_t *)&g_poolBuffer##blockSize##_##numberOfBlocks##_##id[0]}
+        (blockSize), (numberOfBlocks), (id), (MEM_POOL_DEFAULT_FLAGS),                  \
+        (uint8_t *)&g_poolBuffer##blockSize##_##numberOfBlocks##_##id[0]}
 #define MEM_BLOCK_NONAME_BUFFER(blockSize, numberOfBlocks, id) \
     (uint8_t *)&g_poolHeadBuffer##blockSize##_##numberOfBlocks##_##id
 #endif /* MEM_MANAGER_PRE_CONFIGURE */
@@ -145,6 +187,24 @@
     MEM_BLOCK_DATA_BUFFER_DEFINE(name, numberOfBlocks, blockSize, id) \
     mem_config_t g_poolHeadBuffer##name = {(blockSize), (numberOfBlocks), (id), (0), (uint8_t *)&g_poolBuffer##name[0]}
 
+/*!
+ * @brief Defines the memory buffer of a LIFO pool
+ *
+ * Same as MEM_BLOCK_BUFFER_DEFINE, but the pool is registered with MEM_POOL_FLAG_LIFO so MEM_AddBuffer
+ * links its blocks into a free-list. Requires MEM_MANAGER_LIFO_POOL.
+ *
+ * @code
+ * MEM_BLOCK_LIFO_BUFFER_DEFINE(isr64, 16, 64, 0);
+ *
+ * MEM_AddBuffer(MEM_BLOCK_BUFFER(isr64));
+ * buffer = MEM_BufferAllocFromPool(MEM_BLOCK_BUFFER(isr64));
+ * @endcode
+ */
+#define MEM_BLOCK_LIFO_BUFFER_DEFINE(name, numberOfBlocks, blockSize, id)                           \
+    MEM_BLOCK_DATA_BUFFER_DEFINE(name, numberOfBlocks, blockSize, id)                               \
+    mem_config_t g_poolHeadBuffer##name = {(blockSize), (numberOfBlocks), (id), (MEM_POOL_FLAG_LIFO), \
+                                           (uint8_t *)&g_poolBuffer##name[0]}
+
 /*!                                                                     \
  * @brief Gets the memory buffer pointer                                 \
  *                                                                       \
@@ -191,10 +251,25 @@ typedef struct _mem_config
     uint16_t blockSize;      /*< The memory block size. */
     uint16_t numberOfBlocks; /*< The number Of Blocks. */
     uint16_t poolId;         /*< The pool id Of Blocks. */
-    uint16_t reserved;       /*< reserved. */
+    uint16_t reserved;       /*< Pool flags, MEM_POOL_FLAG_xxx. */
     uint8_t *pbuffer;        /*< buffer. */
 } mem_config_t;
 
+#if (defined(MEM_MANAGER_LIFO_POOL) && (MEM_MANAGER_LIFO_POOL > 0U))
+/**@brief LIFO pool statistics. */
+typedef struct _mem_pool_statistics
+{
+    uint16_t numBlocks;          /*< The number Of Blocks. */
+    uint16_t allocatedBlocks;    /*< Blocks currently allocated. */
+    uint16_t allocatedBlocksMax; /*< High-water mark of allocated blocks. */
+    uint16_t reserved;           /*< reserved. */
+    uint32_t allocationFailures; /*< Allocations that found the pool empty and no other pool to serve them. */
+#if (MEM_LIFO_LATENCY_BINS > 0U)
+    uint16_t latency[MEM_LIFO_LATENCY_BINS]; /*< Allocation latency histogram, see MEM_LIFO_LATENCY_BINS. */
+#endif
+} mem_pool_statistics_t;
+#endif /* MEM_MANAGER_LIFO_POOL */
+
 #if defined(gFSCI_MemAllocTest_Enabled_d) && (gFSCI_MemAllocTest_Enabled_d)
 /**@brief Memory status. */
 typedef enum mem_alloc_test_status
@@ -301,6 +376,33 @@ mem_status_t MEM_RemoveBuffer(uint8_t *buffer);
  */
 void *MEM_BufferAllocWithId(uint32_t numBytes, uint8_t poolId);
 
+#if !defined(gMemManagerLight) || (gMemManagerLight == 0)
+#if (defined(MEM_MANAGER_LIFO_POOL) && (MEM_MANAGER_LIFO_POOL > 0U))
+/*!
+ * @brief Allocate a block from a given LIFO pool in constant time.
+ *
+ * The block is taken from the pool free-list without searching other pools. It is safe to call from
+ * interrupt context. The buffer is released with MEM_BufferFree.
+ *
+ * @param buffer             Pointer the memory pool buffer, use MEM_BLOCK_BUFFER Macro as the input parameter.
+ * @retval Memory buffer address when allocate success, NULL when the pool is empty or not a LIFO pool.
+ */
+void *MEM_BufferAllocFromPool(const uint8_t *buffer);
+
+/*!
+ * @brief Get the statistics of a LIFO pool.
+ *
+ * @param buffer                     Pointer the memory pool buffer, use MEM_BLOCK_BUFFER Macro as the input parameter.
+ * @param statistics                 Filled with the pool statistics.
+ * @param reset                      Clear high-water mark, failure counter and latency histogram after reading.
+ *
+ * @retval kStatus_MemSuccess        Statistics read.
+ * @retval kStatus_MemUnknownError   The pool is not a LIFO pool.
+ */
+mem_status_t MEM_GetPoolStatistics(const uint8_t *buffer, mem_pool_statistics_t *statistics, bool reset);
+#endif /* MEM_MANAGER_LIFO_POOL */
+#endif /* gMemManagerLight */
+
 /*!
  * @brief Memory buffer free .
  *
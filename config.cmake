@@ -63,3 +63,8 @@ set(CONFIG_DEVICE_ID MIMXRT1064xxxxB)
 set(CONFIG_FPU DP_FPU)
 set(CONFIG_DSP NO_DSP)
 set(CONFIG_CORE_ID core0)
+# telemetry over RTT is opt-in: cmake -DTELEMETRY=ON (make TELEMETRY=ON)
+if(TELEMETRY)
+    set(CONFIG_USE_driver_rtt true)
+    set(CONFIG_USE_driver_rtt_template true)
+endif()
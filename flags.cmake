@@ -83,6 +83,18 @@ SET(CMAKE_ASM_FLAGS_SDRAM_RELEASE " \
     -mcpu=cortex-m7 \
     ${FPU} \
 ")
+SET(CMAKE_ASM_FLAGS_BENCH " \
+    ${CMAKE_ASM_FLAGS_BENCH} \
+    -D__STARTUP_INITIALIZE_RAMFUNCTION \
+    -D__STARTUP_INITIALIZE_NONCACHEDATA \
+    -D__STARTUP_CLEAR_BSS \
+    -DMCUXPRESSO_SDK \
+    -DCPU_MIMXRT1064DVL6B \
+    -DOSA_USED \
+    -mthumb \
+    -mcpu=cortex-m7 \
+    ${FPU} \
+")
 SET(CMAKE_C_FLAGS_DEBUG " \
     ${CMAKE_C_FLAGS_DEBUG} \
     -include ${ProjDirPath}/src/Config/mcux_config.h \
@@ -246,6 +258,34 @@ SET(CMAKE_C_FLAGS_SDRAM_RELEASE " \
     ${FPU} \
     ${DEBUG_CONSOLE_CONFIG} \
 ")
+SET(CMAKE_C_FLAGS_BENCH " \
+    ${CMAKE_C_FLAGS_BENCH} \
+    -include ${ProjDirPath}/src/Config/mcux_config.h \
+    -DNDEBUG \
+    -DBENCH_BUILD \
+    -DXIP_BOOT_HEADER_ENABLE=1 \
+    -DXIP_EXTERNAL_FLASH=1 \
+    -DUSB_STACK_FREERTOS \
+    -DMCUX_META_BUILD \
+    -DMCUXPRESSO_SDK \
+    -DCPU_MIMXRT1064DVL6B \
+    -DOSA_USED \
+    -DUSE_RTOS=1 \
+    -DSDK_OS_FREE_RTOS \
+    -O2 \
+    --specs=nano.specs \
+    -Wall \
+    -fno-common \
+    -ffunction-sections \
+    -fdata-sections \
+    -fno-builtin \
+    -mthumb \
+    -mapcs \
+    -std=gnu99 \
+    -mcpu=cortex-m7 \
+    ${FPU} \
+    ${DEBUG_CONSOLE_CONFIG} \
+")
 SET(CMAKE_CXX_FLAGS_DEBUG " \
     ${CMAKE_CXX_FLAGS_DEBUG} \
     -DDEBUG \
@@ -397,6 +437,32 @@ SET(CMAKE_CXX_FLAGS_SDRAM_RELEASE " \
     ${FPU} \
     ${DEBUG_CONSOLE_CONFIG} \
 ")
+SET(CMAKE_CXX_FLAGS_BENCH " \
+    ${CMAKE_CXX_FLAGS_BENCH} \
+    -DNDEBUG \
+    -DBENCH_BUILD \
+    -DXIP_EXTERNAL_FLASH=1 \
+    -DMCUX_META_BUILD \
+    -DMCUXPRESSO_SDK \
+    -DCPU_MIMXRT1064DVL6B \
+    -DOSA_USED \
+    -DUSE_RTOS=1 \
+    -DSDK_OS_FREE_RTOS \
+    -O2 \
+    --specs=nano.specs \
+    -Wall \
+    -fno-common \
+    -ffunction-sections \
+    -fdata-sections \
+    -fno-builtin \
+    -mthumb \
+    -mapcs \
+    -fno-rtti \
+    -fno-exceptions \
+    -mcpu=cortex-m7 \
+    ${FPU} \
+    ${DEBUG_CONSOLE_CONFIG} \
+")
 SET(CMAKE_EXE_LINKER_FLAGS_DEBUG " \
     ${CMAKE_EXE_LINKER_FLAGS_DEBUG} \
     -g \
@@ -538,3 +604,26 @@ SET(CMAKE_EXE_LINKER_FLAGS_SDRAM_RELEASE " \
     ${SPECS} \
     -T\"${ProjDirPath}/MIMXRT1064xxxxx_sdram.ld\" -static \
 ")
+SET(CMAKE_EXE_LINKER_FLAGS_BENCH " \
+    ${CMAKE_EXE_LINKER_FLAGS_BENCH} \
+    -Xlinker \
+    --defsym=__heap_size__=0x2000 \
+    -Xlinker \
+    --defsym=__stack_size__=0x2000 \
+    -Xlinker \
+    -Map=output.map \
+    -Wall \
+    -fno-common \
+    -ffunction-sections \
+    -fdata-sections \
+    -fno-builtin \
+    -mthumb \
+    -mapcs \
+    -Wl,--gc-sections \
+    -Wl,-static \
+    -Wl,--print-memory-usage \
+    -mcpu=cortex-m7 \
+    ${FPU} \
+    ${SPECS} \
+    -T\"${ProjDirPath}/MIMXRT1064xxxxx_flexspi_nor.ld\" -static \
+")
@@ -446,16 +446,16 @@ dhara_page_t dhara_journal_capacity(const struct dhara_journal *j)
     return (good_cps << j->log2_ppc) - good_cps;
 }
 
-dhara_page_t dhara_journal_size(const struct dhara_journal *j)
+static dhara_page_t user_pages(const struct dhara_journal *j, dhara_page_t from, dhara_page_t to)
 {
     /* Find the number of raw pages, and the number of checkpoints
-     * between the head and the tail. The difference between the two
-     * is the number of user pages (upper limit).
+     * between the two pages. The difference between the two is the
+     * number of user pages (upper limit).
      */
-    dhara_page_t num_pages = j->head;
-    dhara_page_t num_cps   = j->head >> j->log2_ppc;
+    dhara_page_t num_pages = to;
+    dhara_page_t num_cps   = to >> j->log2_ppc;
 
-    if (j->head < j->tail_sync)
+    if (to < from)
     {
         const dhara_page_t total_pages = j->nand->num_blocks << j->nand->log2_ppb;
 
@@ -463,12 +463,22 @@ dhara_page_t dhara_journal_size(const struct dhara_journal *j)
         num_cps += total_pages >> j->log2_ppc;
     }
 
-    num_pages -= j->tail_sync;
-    num_cps -= j->tail_sync >> j->log2_ppc;
+    num_pages -= from;
+    num_cps -= from >> j->log2_ppc;
 
     return num_pages - num_cps;
 }
 
+dhara_page_t dhara_journal_size(const struct dhara_journal *j)
+{
+    return user_pages(j, j->tail_sync, j->head);
+}
+
+dhara_page_t dhara_journal_dequeued(const struct dhara_journal *j)
+{
+    return user_pages(j, j->tail_sync, j->tail);
+}
+
 int dhara_journal_read_meta(struct dhara_journal *j, dhara_page_t p, uint8_t *buf, dhara_error_t *err)
 {
     /* Offset of metadata within the metadata page */
@@ -150,6 +150,12 @@ dhara_page_t dhara_journal_capacity(const struct dhara_journal *j);
  */
 dhara_page_t dhara_journal_size(const struct dhara_journal *j);
 
+/* Obtain the number of user pages dequeued since the last checkpoint.
+ * They're counted by dhara_journal_size() until the next checkpoint
+ * makes the dequeue permanent.
+ */
+dhara_page_t dhara_journal_dequeued(const struct dhara_journal *j);
+
 /* Obtain a pointer to the cookie data */
 static inline uint8_t *dhara_journal_cookie(const struct dhara_journal *j)
 {
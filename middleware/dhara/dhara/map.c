@@ -59,6 +59,88 @@ static inline void meta_set_alt(uint8_t *meta, int level, dhara_page_t alt)
     dhara_w32(meta + 4 + (level << 2), alt);
 }
 
+/************************************************************************
+ * Sector cache
+ *
+ * The location of a sector changes only when a page carrying its ID is
+ * written to the journal, and every such write in this file updates the
+ * cache once it has succeeded. Recovery moves pages behind our back, so
+ * the cache is flushed when it starts, and bypassed until it's complete.
+ */
+
+static void cache_flush(struct dhara_map *m)
+{
+    dhara_sector_t i;
+
+    if (!m->cache)
+        return;
+
+    for (i = 0; i < (m->cache_mask + 1) * DHARA_MAP_CACHE_WAYS; i++)
+        m->cache[i].sector = DHARA_SECTOR_NONE;
+}
+
+static inline struct dhara_map_cache *cache_set(const struct dhara_map *m, dhara_sector_t s)
+{
+    return m->cache + (((s * 0x9e3779b1u) >> 16) & m->cache_mask) * DHARA_MAP_CACHE_WAYS;
+}
+
+/* Look up a sector, making it the most recently used of its set.
+ * Returns 1 and the page holding the sector (DHARA_PAGE_NONE if it's
+ * unmapped) if the cache knows where it is.
+ */
+static int cache_find(struct dhara_map *m, dhara_sector_t s, dhara_page_t *loc)
+{
+    struct dhara_map_cache *set;
+    struct dhara_map_cache hit;
+    int i;
+
+    if (!m->cache || dhara_journal_in_recovery(&m->journal))
+        return 0;
+
+    set = cache_set(m, s);
+
+    for (i = 0; i < DHARA_MAP_CACHE_WAYS; i++)
+    {
+        if (set[i].sector == s)
+        {
+            hit = set[i];
+
+            for (; i > 0; i--)
+                set[i] = set[i - 1];
+
+            set[0] = hit;
+            *loc   = hit.page;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/* Record the page now holding a sector, replacing the least recently
+ * used entry of the set if the sector isn't in it yet.
+ */
+static void cache_put(struct dhara_map *m, dhara_sector_t s, dhara_page_t p)
+{
+    struct dhara_map_cache *set;
+    int i;
+
+    if (!m->cache || (s == DHARA_SECTOR_NONE) || dhara_journal_in_recovery(&m->journal))
+        return;
+
+    set = cache_set(m, s);
+
+    for (i = 0; i < DHARA_MAP_CACHE_WAYS - 1; i++)
+        if (set[i].sector == s)
+            break;
+
+    for (; i > 0; i--)
+        set[i] = set[i - 1];
+
+    set[0].sector = s;
+    set[0].page   = p;
+}
+
 /************************************************************************
  * Public interface
  */
@@ -70,10 +152,29 @@ void dhara_map_init(struct dhara_map *m, const struct dhara_nand *n, uint8_t *pa
 
     dhara_journal_init(&m->journal, n, page_buf);
     m->gc_ratio = gc_ratio;
+    m->cache    = NULL;
+}
+
+void dhara_map_set_cache(struct dhara_map *m, struct dhara_map_cache *cache, unsigned int count)
+{
+    unsigned int sets = count / DHARA_MAP_CACHE_WAYS;
+
+    /* Sets are indexed by 16 bits of the hash */
+    if (sets > 0x10000)
+        sets = 0x10000;
+
+    while (sets & (sets - 1))
+        sets &= sets - 1;
+
+    m->cache      = sets ? cache : NULL;
+    m->cache_mask = sets - 1;
+    cache_flush(m);
 }
 
 int dhara_map_resume(struct dhara_map *m, dhara_error_t *err)
 {
+    cache_flush(m);
+
     if (dhara_journal_resume(&m->journal, err) < 0)
     {
         m->count = 0;
@@ -90,6 +191,7 @@ void dhara_map_clear(struct dhara_map *m)
     {
         m->count = 0;
         dhara_journal_clear(&m->journal);
+        cache_flush(m);
     }
 }
 
@@ -105,29 +207,24 @@ dhara_sector_t dhara_map_capacity(const struct dhara_map *m)
     return cap - reserve - safety_margin;
 }
 
-/* Trace the path from the root to the given sector, emitting
- * alt-pointers and alt-full bits in the given metadata buffer. This
- * also returns the physical page containing the given sector, if it
- * exists.
- *
- * If the page can't be found, a suitable path will be constructed
- * (containing PAGE_NONE alt-pointers), and DHARA_E_NOT_FOUND will be
- * returned.
+/* Continue tracing the path to the given sector from page p, which is
+ * the subtree at the given depth that contains it, emitting alt-pointers
+ * and alt-full bits for the remaining levels. See trace_path().
  */
-static int trace_path(
-    struct dhara_map *m, dhara_sector_t target, dhara_page_t *loc, uint8_t *new_meta, dhara_error_t *err)
+static int trace_from(struct dhara_map *m,
+                      dhara_sector_t target,
+                      int depth,
+                      dhara_page_t p,
+                      dhara_page_t *loc,
+                      uint8_t *new_meta,
+                      dhara_error_t *err)
 {
     uint8_t meta[DHARA_META_SIZE];
-    int depth      = 0;
-    dhara_page_t p = dhara_journal_root(&m->journal);
-
-    if (new_meta)
-        meta_set_id(new_meta, target);
 
     if (p == DHARA_PAGE_NONE)
         goto not_found;
 
-    if (dhara_journal_read_meta(&m->journal, p, meta, err) < 0)
+    if ((depth < DHARA_RADIX_DEPTH) && (dhara_journal_read_meta(&m->journal, p, meta, err) < 0))
         return -1;
 
     while (depth < DHARA_RADIX_DEPTH)
@@ -149,7 +246,10 @@ static int trace_path(
                 goto not_found;
             }
 
-            if (dhara_journal_read_meta(&m->journal, p, meta, err) < 0)
+            /* Below the last level is the sector itself, and its
+             * metadata isn't needed.
+             */
+            if ((depth + 1 < DHARA_RADIX_DEPTH) && (dhara_journal_read_meta(&m->journal, p, meta, err) < 0))
                 return -1;
         }
         else
@@ -177,9 +277,76 @@ not_found:
     return -1;
 }
 
+/* Trace the path from the root to the given sector, emitting
+ * alt-pointers and alt-full bits in the given metadata buffer. This
+ * also returns the physical page containing the given sector, if it
+ * exists.
+ *
+ * If the page can't be found, a suitable path will be constructed
+ * (containing PAGE_NONE alt-pointers), and DHARA_E_NOT_FOUND will be
+ * returned.
+ */
+static int trace_path(
+    struct dhara_map *m, dhara_sector_t target, dhara_page_t *loc, uint8_t *new_meta, dhara_error_t *err)
+{
+    if (new_meta)
+        meta_set_id(new_meta, target);
+
+    return trace_from(m, target, 0, dhara_journal_root(&m->journal), loc, new_meta, err);
+}
+
+/* Trace the path to the given sector when meta holds the metadata of
+ * the root, for some other sector. Down to the first level at which
+ * the two sectors differ, the paths are the same, so only the rest of
+ * the path is traced, updating meta in place.
+ */
+static int trace_next(struct dhara_map *m, dhara_sector_t target, uint8_t *meta, dhara_error_t *err)
+{
+    const dhara_sector_t prev = meta_get_id(meta);
+    dhara_page_t p;
+    int depth = 0;
+
+    while (!((target ^ prev) & d_bit(depth)))
+        depth++;
+
+    p = meta_get_alt(meta, depth);
+    meta_set_id(meta, target);
+    meta_set_alt(meta, depth, dhara_journal_root(&m->journal));
+
+    return trace_from(m, target, depth + 1, p, NULL, meta, err);
+}
+
 int dhara_map_find(struct dhara_map *m, dhara_sector_t target, dhara_page_t *loc, dhara_error_t *err)
 {
-    return trace_path(m, target, loc, NULL, err);
+    dhara_error_t my_err;
+    dhara_page_t p;
+
+    if (!cache_find(m, target, &p))
+    {
+        if (trace_path(m, target, &p, NULL, &my_err) < 0)
+        {
+            if (my_err != DHARA_E_NOT_FOUND)
+            {
+                dhara_set_error(err, my_err);
+                return -1;
+            }
+
+            p = DHARA_PAGE_NONE;
+        }
+
+        cache_put(m, target, p);
+    }
+
+    if (p == DHARA_PAGE_NONE)
+    {
+        dhara_set_error(err, DHARA_E_NOT_FOUND);
+        return -1;
+    }
+
+    if (loc)
+        *loc = p;
+
+    return 0;
 }
 
 int dhara_map_read(struct dhara_map *m, dhara_sector_t s, uint8_t *data, dhara_error_t *err)
@@ -222,6 +389,12 @@ static int raw_gc(struct dhara_map *m, dhara_page_t src, dhara_error_t *err)
     if (target == DHARA_SECTOR_NONE)
         return 0;
 
+    /* If the cache knows the sector to be elsewhere, the page is
+     * garbage, and there's no need to trace the path.
+     */
+    if (cache_find(m, target, &current) && (current != src))
+        return 0;
+
     /* Find out where the sector once represented by this page
      * currently resides (if anywhere).
      */
@@ -245,6 +418,7 @@ static int raw_gc(struct dhara_map *m, dhara_page_t src, dhara_error_t *err)
     if (dhara_journal_copy(&m->journal, src, meta, err) < 0)
         return -1;
 
+    cache_put(m, target, dhara_journal_root(&m->journal));
     return 0;
 }
 
@@ -261,7 +435,11 @@ static int pad_queue(struct dhara_map *m, dhara_error_t *err)
     if (dhara_journal_read_meta(&m->journal, p, root_meta, err) < 0)
         return -1;
 
-    return dhara_journal_copy(&m->journal, p, root_meta, err);
+    if (dhara_journal_copy(&m->journal, p, root_meta, err) < 0)
+        return -1;
+
+    cache_put(m, meta_get_id(root_meta), dhara_journal_root(&m->journal));
+    return 0;
 }
 
 /* Attempt to recover the journal */
@@ -269,6 +447,11 @@ static int try_recover(struct dhara_map *m, dhara_error_t cause, dhara_error_t *
 {
     int restart_count = 0;
 
+    /* Pages of the failed block are about to move, and the cache is
+     * bypassed until they have.
+     */
+    cache_flush(m);
+
     if (cause != DHARA_E_RECOVER)
     {
         dhara_set_error(err, cause);
@@ -307,11 +490,20 @@ static int try_recover(struct dhara_map *m, dhara_error_t cause, dhara_error_t *
     return 0;
 }
 
+/* Size of the journal as far as garbage collection is concerned. Pages
+ * already dequeued are still counted by the journal until the next
+ * checkpoint, but there's nothing left to collect in them.
+ */
+static dhara_page_t gc_size(const struct dhara_map *m)
+{
+    return dhara_journal_size(&m->journal) - dhara_journal_dequeued(&m->journal);
+}
+
 static int auto_gc(struct dhara_map *m, dhara_error_t *err)
 {
     int i;
 
-    if (dhara_journal_size(&m->journal) < dhara_map_capacity(m))
+    if (gc_size(m) < dhara_map_capacity(m))
         return 0;
 
     for (i = 0; i < m->gc_ratio; i++)
@@ -321,14 +513,46 @@ static int auto_gc(struct dhara_map *m, dhara_error_t *err)
     return 0;
 }
 
-static int prepare_write(struct dhara_map *m, dhara_sector_t dst, uint8_t *meta, dhara_error_t *err)
+/* Collect garbage until the journal is headroom pages below the
+ * capacity of the map, performing at most steps collection steps.
+ * Returns 1 if the target wasn't reached.
+ */
+static int collect(struct dhara_map *m, dhara_page_t headroom, unsigned int steps, dhara_error_t *err)
+{
+    const dhara_sector_t cap = dhara_map_capacity(m);
+    const dhara_page_t target = (cap > headroom) ? (cap - headroom) : 0;
+
+    while (m->count && (gc_size(m) > target))
+    {
+        if (!steps--)
+            return 1;
+
+        if (dhara_map_gc(m, err) < 0)
+            return -1;
+    }
+
+    return 0;
+}
+
+/* Prepare the metadata for writing the given sector. If prev isn't
+ * DHARA_PAGE_NONE, meta already holds the metadata of that page, and
+ * if it's still the root, the path is traced from there.
+ */
+static int prepare_write(
+    struct dhara_map *m, dhara_sector_t dst, dhara_page_t prev, uint8_t *meta, dhara_error_t *err)
 {
     dhara_error_t my_err;
+    int ret;
 
     if (auto_gc(m, err) < 0)
         return -1;
 
-    if (trace_path(m, dst, NULL, meta, &my_err) < 0)
+    if ((prev != DHARA_PAGE_NONE) && (prev == dhara_journal_root(&m->journal)))
+        ret = trace_next(m, dst, meta, &my_err);
+    else
+        ret = trace_path(m, dst, NULL, meta, &my_err);
+
+    if (ret < 0)
     {
         if (my_err != DHARA_E_NOT_FOUND)
         {
@@ -357,7 +581,7 @@ int dhara_map_write(struct dhara_map *m, dhara_sector_t dst, const uint8_t *data
         dhara_error_t my_err;
         const dhara_sector_t old_count = m->count;
 
-        if (prepare_write(m, dst, meta, err) < 0)
+        if (prepare_write(m, dst, DHARA_PAGE_NONE, meta, err) < 0)
             return -1;
 
         if (!dhara_journal_enqueue(&m->journal, data, meta, &my_err))
@@ -369,6 +593,50 @@ int dhara_map_write(struct dhara_map *m, dhara_sector_t dst, const uint8_t *data
             return -1;
     }
 
+    cache_put(m, dst, dhara_journal_root(&m->journal));
+    return 0;
+}
+
+int dhara_map_write_multi(
+    struct dhara_map *m, dhara_sector_t dst, const uint8_t *data, dhara_sector_t count, dhara_error_t *err)
+{
+    const size_t page_size = (size_t)1 << m->journal.nand->log2_page_size;
+    uint8_t meta[DHARA_META_SIZE];
+    dhara_page_t prev = DHARA_PAGE_NONE;
+
+    /* Collect for the whole batch first, so that the pages of the
+     * batch are written back to back.
+     */
+    if (collect(m, count, (unsigned int)m->gc_ratio * count, err) < 0)
+        return -1;
+
+    while (count)
+    {
+        dhara_error_t my_err;
+        const dhara_sector_t old_count = m->count;
+
+        if (prepare_write(m, dst, prev, meta, err) < 0)
+            return -1;
+
+        if (dhara_journal_enqueue(&m->journal, data, meta, &my_err) < 0)
+        {
+            m->count = old_count;
+            prev     = DHARA_PAGE_NONE;
+
+            if (try_recover(m, my_err, err) < 0)
+                return -1;
+
+            continue;
+        }
+
+        prev = dhara_journal_root(&m->journal);
+        cache_put(m, dst, prev);
+
+        dst++;
+        data += page_size;
+        count--;
+    }
+
     return 0;
 }
 
@@ -380,7 +648,7 @@ int dhara_map_copy_page(struct dhara_map *m, dhara_page_t src, dhara_sector_t ds
         dhara_error_t my_err;
         const dhara_sector_t old_count = m->count;
 
-        if (prepare_write(m, dst, meta, err) < 0)
+        if (prepare_write(m, dst, DHARA_PAGE_NONE, meta, err) < 0)
             return -1;
 
         if (!dhara_journal_copy(&m->journal, src, meta, &my_err))
@@ -392,6 +660,7 @@ int dhara_map_copy_page(struct dhara_map *m, dhara_page_t src, dhara_sector_t ds
             return -1;
     }
 
+    cache_put(m, dst, dhara_journal_root(&m->journal));
     return 0;
 }
 
@@ -446,6 +715,7 @@ static int try_delete(struct dhara_map *m, dhara_sector_t s, dhara_error_t *err)
     {
         m->count = 0;
         dhara_journal_clear(&m->journal);
+        cache_flush(m);
         return 0;
     }
 
@@ -467,6 +737,8 @@ static int try_delete(struct dhara_map *m, dhara_sector_t s, dhara_error_t *err)
     if (dhara_journal_copy(&m->journal, alt_page, meta, err) < 0)
         return -1;
 
+    cache_put(m, meta_get_id(meta), dhara_journal_root(&m->journal));
+    cache_put(m, s, DHARA_PAGE_NONE);
     m->count--;
     return 0;
 }
@@ -504,8 +776,10 @@ int dhara_map_sync(struct dhara_map *m, dhara_error_t *err)
         }
         else
         {
+            /* If the page couldn't be moved, it must stay */
             ret = raw_gc(m, p, &my_err);
-            dhara_journal_dequeue(&m->journal);
+            if (!ret)
+                dhara_journal_dequeue(&m->journal);
         }
 
         if ((ret < 0) && (try_recover(m, my_err, err) < 0))
@@ -540,3 +814,8 @@ int dhara_map_gc(struct dhara_map *m, dhara_error_t *err)
 
     return 0;
 }
+
+int dhara_map_idle(struct dhara_map *m, dhara_page_t headroom, unsigned int steps, dhara_error_t *err)
+{
+    return collect(m, headroom, steps, err);
+}
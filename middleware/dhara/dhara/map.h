@@ -27,11 +27,27 @@ typedef uint32_t dhara_sector_t;
 /* This sector value is reserved */
 #define DHARA_SECTOR_NONE	0xffffffff
 
+/* Entry of the optional sector cache. Entries are grouped into sets of
+ * DHARA_MAP_CACHE_WAYS, most recently used first. An empty entry has
+ * the sector DHARA_SECTOR_NONE, a sector known to be unmapped has the
+ * page DHARA_PAGE_NONE.
+ */
+struct dhara_map_cache {
+	dhara_sector_t		sector;
+	dhara_page_t		page;
+};
+
+#define DHARA_MAP_CACHE_WAYS	4
+
 struct dhara_map {
 	struct dhara_journal	journal;
 
 	uint8_t			gc_ratio;
 	dhara_sector_t		count;
+
+	/* Sector cache, NULL if not in use */
+	struct dhara_map_cache	*cache;
+	dhara_sector_t		cache_mask;
 };
 
 /* Initialize a map. You need to supply a buffer for page metadata, and
@@ -45,6 +61,19 @@ struct dhara_map {
 void dhara_map_init(struct dhara_map *m, const struct dhara_nand *n,
 		    uint8_t *page_buf, uint8_t gc_ratio);
 
+/* Attach a cache of sector locations, or detach it (cache = NULL).
+ * The cache is a table of count entries supplied by the caller, count
+ * being a power of two of at least DHARA_MAP_CACHE_WAYS (it's rounded
+ * down otherwise). It remembers where recently found sectors are, so
+ * that dhara_map_find() and dhara_map_read() don't have to trace the
+ * path through the radix tree, reading one page of metadata per level.
+ *
+ * The cache holds no state of its own that needs to be persistent and
+ * may be attached at any time after dhara_map_init().
+ */
+void dhara_map_set_cache(struct dhara_map *m, struct dhara_map_cache *cache,
+			 unsigned int count);
+
 /* Recover stored state, if possible. If there is no valid stored state
  * on the chip, -1 is returned, and an empty map is initialized.
  */
@@ -79,6 +108,19 @@ int dhara_map_read(struct dhara_map *m, dhara_sector_t s,
 int dhara_map_write(struct dhara_map *m, dhara_sector_t s,
 		    const uint8_t *data, dhara_error_t *err);
 
+/* Write data to count consecutive logical sectors, starting at s. The
+ * data is count whole pages. This is equivalent to writing the sectors
+ * one at a time, but garbage collection for the whole batch is done
+ * up front, and the metadata of the previous sector is reused to find
+ * the path to the next one.
+ *
+ * If an error occurs, the sectors before the failed one have been
+ * written.
+ */
+int dhara_map_write_multi(struct dhara_map *m, dhara_sector_t s,
+			  const uint8_t *data, dhara_sector_t count,
+			  dhara_error_t *err);
+
 /* Copy any flash page to a logical sector. */
 int dhara_map_copy_page(struct dhara_map *m, dhara_page_t src,
 			dhara_sector_t dst, dhara_error_t *err);
@@ -111,4 +153,16 @@ int dhara_map_sync(struct dhara_map *m, dhara_error_t *err);
  */
 int dhara_map_gc(struct dhara_map *m, dhara_error_t *err);
 
+/* Perform garbage collection ahead of time, from an idle hook. Writes
+ * collect garbage only when the journal has reached the capacity of
+ * the map, gc_ratio steps at a time. This brings the journal down to
+ * headroom pages below that, so that the next headroom writes don't
+ * collect at all, performing at most steps collection steps.
+ *
+ * Returns 1 if there's more to collect, 0 if the journal is down to
+ * the target, or -1 if an error occurs.
+ */
+int dhara_map_idle(struct dhara_map *m, dhara_page_t headroom,
+		   unsigned int steps, dhara_error_t *err);
+
 #endif
@@ -20,32 +20,252 @@
 
 #define BCH_MAX_SYNS		8
 
+/* The fast decoder works with the logarithm tables of gf13.c */
+#if defined(BCH_NO_TABLES) || defined(GF13_NO_TABLES)
+#define BCH_SERIAL_DECODE
+#endif
+
+#ifdef BCH_NO_TABLES
+#define BCH_TABLE(name)		NULL
+#else
+#define BCH_TABLE(name)		name##_table
+
+/* Remainders of the byte values 0-255, one table per code */
+static const bch_poly_t bch_1bit_table[256] = {
+	0x0000, 0x18eb, 0x11cd, 0x0926, 0x0381, 0x1b6a, 0x124c, 0x0aa7,
+	0x0702, 0x1fe9, 0x16cf, 0x0e24, 0x0483, 0x1c68, 0x154e, 0x0da5,
+	0x0e04, 0x16ef, 0x1fc9, 0x0722, 0x0d85, 0x156e, 0x1c48, 0x04a3,
+	0x0906, 0x11ed, 0x18cb, 0x0020, 0x0a87, 0x126c, 0x1b4a, 0x03a1,
+	0x1c08, 0x04e3, 0x0dc5, 0x152e, 0x1f89, 0x0762, 0x0e44, 0x16af,
+	0x1b0a, 0x03e1, 0x0ac7, 0x122c, 0x188b, 0x0060, 0x0946, 0x11ad,
+	0x120c, 0x0ae7, 0x03c1, 0x1b2a, 0x118d, 0x0966, 0x0040, 0x18ab,
+	0x150e, 0x0de5, 0x04c3, 0x1c28, 0x168f, 0x0e64, 0x0742, 0x1fa9,
+	0x180b, 0x00e0, 0x09c6, 0x112d, 0x1b8a, 0x0361, 0x0a47, 0x12ac,
+	0x1f09, 0x07e2, 0x0ec4, 0x162f, 0x1c88, 0x0463, 0x0d45, 0x15ae,
+	0x160f, 0x0ee4, 0x07c2, 0x1f29, 0x158e, 0x0d65, 0x0443, 0x1ca8,
+	0x110d, 0x09e6, 0x00c0, 0x182b, 0x128c, 0x0a67, 0x0341, 0x1baa,
+	0x0403, 0x1ce8, 0x15ce, 0x0d25, 0x0782, 0x1f69, 0x164f, 0x0ea4,
+	0x0301, 0x1bea, 0x12cc, 0x0a27, 0x0080, 0x186b, 0x114d, 0x09a6,
+	0x0a07, 0x12ec, 0x1bca, 0x0321, 0x0986, 0x116d, 0x184b, 0x00a0,
+	0x0d05, 0x15ee, 0x1cc8, 0x0423, 0x0e84, 0x166f, 0x1f49, 0x07a2,
+	0x100d, 0x08e6, 0x01c0, 0x192b, 0x138c, 0x0b67, 0x0241, 0x1aaa,
+	0x170f, 0x0fe4, 0x06c2, 0x1e29, 0x148e, 0x0c65, 0x0543, 0x1da8,
+	0x1e09, 0x06e2, 0x0fc4, 0x172f, 0x1d88, 0x0563, 0x0c45, 0x14ae,
+	0x190b, 0x01e0, 0x08c6, 0x102d, 0x1a8a, 0x0261, 0x0b47, 0x13ac,
+	0x0c05, 0x14ee, 0x1dc8, 0x0523, 0x0f84, 0x176f, 0x1e49, 0x06a2,
+	0x0b07, 0x13ec, 0x1aca, 0x0221, 0x0886, 0x106d, 0x194b, 0x01a0,
+	0x0201, 0x1aea, 0x13cc, 0x0b27, 0x0180, 0x196b, 0x104d, 0x08a6,
+	0x0503, 0x1de8, 0x14ce, 0x0c25, 0x0682, 0x1e69, 0x174f, 0x0fa4,
+	0x0806, 0x10ed, 0x19cb, 0x0120, 0x0b87, 0x136c, 0x1a4a, 0x02a1,
+	0x0f04, 0x17ef, 0x1ec9, 0x0622, 0x0c85, 0x146e, 0x1d48, 0x05a3,
+	0x0602, 0x1ee9, 0x17cf, 0x0f24, 0x0583, 0x1d68, 0x144e, 0x0ca5,
+	0x0100, 0x19eb, 0x10cd, 0x0826, 0x0281, 0x1a6a, 0x134c, 0x0ba7,
+	0x140e, 0x0ce5, 0x05c3, 0x1d28, 0x178f, 0x0f64, 0x0642, 0x1ea9,
+	0x130c, 0x0be7, 0x02c1, 0x1a2a, 0x108d, 0x0866, 0x0140, 0x19ab,
+	0x1a0a, 0x02e1, 0x0bc7, 0x132c, 0x198b, 0x0160, 0x0846, 0x10ad,
+	0x1d08, 0x05e3, 0x0cc5, 0x142e, 0x1e89, 0x0662, 0x0f44, 0x17af,
+};
+
+static const bch_poly_t bch_2bit_table[256] = {
+	0x0000000, 0x30cb5c9, 0x2cc7ed9, 0x1c0cb10, 0x14de8f9, 0x2415d30, 0x3819620, 0x08d23e9,
+	0x29bd1f2, 0x197643b, 0x057af2b, 0x35b1ae2, 0x3d6390b, 0x0da8cc2, 0x11a47d2, 0x216f21b,
+	0x1e2b6af, 0x2ee0366, 0x32ec876, 0x0227dbf, 0x0af5e56, 0x3a3eb9f, 0x263208f, 0x16f9546,
+	0x379675d, 0x075d294, 0x1b51984, 0x2b9ac4d, 0x2348fa4, 0x1383a6d, 0x0f8f17d, 0x3f444b4,
+	0x3c56d5e, 0x0c9d897, 0x1091387, 0x205a64e, 0x28885a7, 0x184306e, 0x044fb7e, 0x3484eb7,
+	0x15ebcac, 0x2520965, 0x392c275, 0x09e77bc, 0x0135455, 0x31fe19c, 0x2df2a8c, 0x1d39f45,
+	0x227dbf1, 0x12b6e38, 0x0eba528, 0x3e710e1, 0x36a3308, 0x06686c1, 0x1a64dd1, 0x2aaf818,
+	0x0bc0a03, 0x3b0bfca, 0x27074da, 0x17cc113, 0x1f1e2fa, 0x2fd5733, 0x33d9c23, 0x03129ea,
+	0x35fcff7, 0x0537a3e, 0x193b12e, 0x29f04e7, 0x212270e, 0x11e92c7, 0x0de59d7, 0x3d2ec1e,
+	0x1c41e05, 0x2c8abcc, 0x30860dc, 0x004d515, 0x089f6fc, 0x3854335, 0x2458825, 0x1493dec,
+	0x2bd7958, 0x1b1cc91, 0x0710781, 0x37db248, 0x3f091a1, 0x0fc2468, 0x13cef78, 0x2305ab1,
+	0x026a8aa, 0x32a1d63, 0x2ead673, 0x1e663ba, 0x16b4053, 0x267f59a, 0x3a73e8a, 0x0ab8b43,
+	0x09aa2a9, 0x3961760, 0x256dc70, 0x15a69b9, 0x1d74a50, 0x2dbff99, 0x31b3489, 0x0178140,
+	0x201735b, 0x10dc692, 0x0cd0d82, 0x3c1b84b, 0x34c9ba2, 0x0402e6b, 0x180e57b, 0x28c50b2,
+	0x1781406, 0x274a1cf, 0x3b46adf, 0x0b8df16, 0x035fcff, 0x3394936, 0x2f98226, 0x1f537ef,
+	0x3e3c5f4, 0x0ef703d, 0x12fbb2d, 0x2230ee4, 0x2ae2d0d, 0x1a298c4, 0x06253d4, 0x36ee61d,
+	0x26a8aa5, 0x1663f6c, 0x0a6f47c, 0x3aa41b5, 0x327625c, 0x02bd795, 0x1eb1c85, 0x2e7a94c,
+	0x0f15b57, 0x3fdee9e, 0x23d258e, 0x1319047, 0x1bcb3ae, 0x2b00667, 0x370cd77, 0x07c78be,
+	0x3883c0a, 0x08489c3, 0x14442d3, 0x248f71a, 0x2c5d4f3, 0x1c9613a, 0x009aa2a, 0x3051fe3,
+	0x113edf8, 0x21f5831, 0x3df9321, 0x0d326e8, 0x05e0501, 0x352b0c8, 0x2927bd8, 0x19ece11,
+	0x1afe7fb, 0x2a35232, 0x3639922, 0x06f2ceb, 0x0e20f02, 0x3eebacb, 0x22e71db, 0x122c412,
+	0x3343609, 0x03883c0, 0x1f848d0, 0x2f4fd19, 0x279def0, 0x1756b39, 0x0b5a029, 0x3b915e0,
+	0x04d5154, 0x341e49d, 0x2812f8d, 0x18d9a44, 0x100b9ad, 0x20c0c64, 0x3ccc774, 0x0c072bd,
+	0x2d680a6, 0x1da356f, 0x01afe7f, 0x3164bb6, 0x39b685f, 0x097dd96, 0x1571686, 0x25ba34f,
+	0x1354552, 0x239f09b, 0x3f93b8b, 0x0f58e42, 0x078adab, 0x3741862, 0x2b4d372, 0x1b866bb,
+	0x3ae94a0, 0x0a22169, 0x162ea79, 0x26e5fb0, 0x2e37c59, 0x1efc990, 0x02f0280, 0x323b749,
+	0x0d7f3fd, 0x3db4634, 0x21b8d24, 0x11738ed, 0x19a1b04, 0x296aecd, 0x35665dd, 0x05ad014,
+	0x24c220f, 0x14097c6, 0x0805cd6, 0x38ce91f, 0x301caf6, 0x00d7f3f, 0x1cdb42f, 0x2c101e6,
+	0x2f0280c, 0x1fc9dc5, 0x03c56d5, 0x330e31c, 0x3bdc0f5, 0x0b1753c, 0x171be2c, 0x27d0be5,
+	0x06bf9fe, 0x3674c37, 0x2a78727, 0x1ab32ee, 0x1261107, 0x22aa4ce, 0x3ea6fde, 0x0e6da17,
+	0x3129ea3, 0x01e2b6a, 0x1dee07a, 0x2d255b3, 0x25f765a, 0x153c393, 0x0930883, 0x39fbd4a,
+	0x1894f51, 0x285fa98, 0x3453188, 0x0498441, 0x0c4a7a8, 0x3c81261, 0x208d971, 0x1046cb8,
+};
+
+static const bch_poly_t bch_3bit_table[256] = {
+	0x0000000000, 0x35ca0f3ebd, 0x6b941e7d7a, 0x5e5e1143c7,
+	0x6ddd8e4719, 0x58178179a4, 0x0649903a63, 0x33839f04de,
+	0x614eae33df, 0x5484a10d62, 0x0adab04ea5, 0x3f10bf7018,
+	0x0c932074c6, 0x39592f4a7b, 0x67073e09bc, 0x52cd313701,
+	0x7868eeda53, 0x4da2e1e4ee, 0x13fcf0a729, 0x2636ff9994,
+	0x15b5609d4a, 0x207f6fa3f7, 0x7e217ee030, 0x4beb71de8d,
+	0x192640e98c, 0x2cec4fd731, 0x72b25e94f6, 0x477851aa4b,
+	0x74fbceae95, 0x4131c19028, 0x1f6fd0d3ef, 0x2aa5dfed52,
+	0x4a246f094b, 0x7fee6037f6, 0x21b0717431, 0x147a7e4a8c,
+	0x27f9e14e52, 0x1233ee70ef, 0x4c6dff3328, 0x79a7f00d95,
+	0x2b6ac13a94, 0x1ea0ce0429, 0x40fedf47ee, 0x7534d07953,
+	0x46b74f7d8d, 0x737d404330, 0x2d235100f7, 0x18e95e3e4a,
+	0x324c81d318, 0x07868eeda5, 0x59d89fae62, 0x6c129090df,
+	0x5f910f9401, 0x6a5b00aabc, 0x340511e97b, 0x01cf1ed7c6,
+	0x53022fe0c7, 0x66c820de7a, 0x3896319dbd, 0x0d5c3ea300,
+	0x3edfa1a7de, 0x0b15ae9963, 0x554bbfdaa4, 0x6081b0e419,
+	0x2ebd6caf7b, 0x1b776391c6, 0x452972d201, 0x70e37decbc,
+	0x4360e2e862, 0x76aaedd6df, 0x28f4fc9518, 0x1d3ef3aba5,
+	0x4ff3c29ca4, 0x7a39cda219, 0x2467dce1de, 0x11add3df63,
+	0x222e4cdbbd, 0x17e443e500, 0x49ba52a6c7, 0x7c705d987a,
+	0x56d5827528, 0x631f8d4b95, 0x3d419c0852, 0x088b9336ef,
+	0x3b080c3231, 0x0ec2030c8c, 0x509c124f4b, 0x65561d71f6,
+	0x379b2c46f7, 0x025123784a, 0x5c0f323b8d, 0x69c53d0530,
+	0x5a46a201ee, 0x6f8cad3f53, 0x31d2bc7c94, 0x0418b34229,
+	0x649903a630, 0x51530c988d, 0x0f0d1ddb4a, 0x3ac712e5f7,
+	0x09448de129, 0x3c8e82df94, 0x62d0939c53, 0x571a9ca2ee,
+	0x05d7ad95ef, 0x301da2ab52, 0x6e43b3e895, 0x5b89bcd628,
+	0x680a23d2f6, 0x5dc02cec4b, 0x039e3daf8c, 0x3654329131,
+	0x1cf1ed7c63, 0x293be242de, 0x7765f30119, 0x42affc3fa4,
+	0x712c633b7a, 0x44e66c05c7, 0x1ab87d4600, 0x2f727278bd,
+	0x7dbf434fbc, 0x48754c7101, 0x162b5d32c6, 0x23e1520c7b,
+	0x1062cd08a5, 0x25a8c23618, 0x7bf6d375df, 0x4e3cdc4b62,
+	0x5d7ad95ef6, 0x68b0d6604b, 0x36eec7238c, 0x0324c81d31,
+	0x30a75719ef, 0x056d582752, 0x5b33496495, 0x6ef9465a28,
+	0x3c34776d29, 0x09fe785394, 0x57a0691053, 0x626a662eee,
+	0x51e9f92a30, 0x6423f6148d, 0x3a7de7574a, 0x0fb7e869f7,
+	0x25123784a5, 0x10d838ba18, 0x4e8629f9df, 0x7b4c26c762,
+	0x48cfb9c3bc, 0x7d05b6fd01, 0x235ba7bec6, 0x1691a8807b,
+	0x445c99b77a, 0x71969689c7, 0x2fc887ca00, 0x1a0288f4bd,
+	0x298117f063, 0x1c4b18cede, 0x4215098d19, 0x77df06b3a4,
+	0x175eb657bd, 0x2294b96900, 0x7ccaa82ac7, 0x4900a7147a,
+	0x7a833810a4, 0x4f49372e19, 0x1117266dde, 0x24dd295363,
+	0x7610186462, 0x43da175adf, 0x1d84061918, 0x284e0927a5,
+	0x1bcd96237b, 0x2e07991dc6, 0x7059885e01, 0x45938760bc,
+	0x6f36588dee, 0x5afc57b353, 0x04a246f094, 0x316849ce29,
+	0x02ebd6caf7, 0x3721d9f44a, 0x697fc8b78d, 0x5cb5c78930,
+	0x0e78f6be31, 0x3bb2f9808c, 0x65ece8c34b, 0x5026e7fdf6,
+	0x63a578f928, 0x566f77c795, 0x0831668452, 0x3dfb69baef,
+	0x73c7b5f18d, 0x460dbacf30, 0x1853ab8cf7, 0x2d99a4b24a,
+	0x1e1a3bb694, 0x2bd0348829, 0x758e25cbee, 0x40442af553,
+	0x12891bc252, 0x274314fcef, 0x791d05bf28, 0x4cd70a8195,
+	0x7f5495854b, 0x4a9e9abbf6, 0x14c08bf831, 0x210a84c68c,
+	0x0baf5b2bde, 0x3e65541563, 0x603b4556a4, 0x55f14a6819,
+	0x6672d56cc7, 0x53b8da527a, 0x0de6cb11bd, 0x382cc42f00,
+	0x6ae1f51801, 0x5f2bfa26bc, 0x0175eb657b, 0x34bfe45bc6,
+	0x073c7b5f18, 0x32f67461a5, 0x6ca8652262, 0x59626a1cdf,
+	0x39e3daf8c6, 0x0c29d5c67b, 0x5277c485bc, 0x67bdcbbb01,
+	0x543e54bfdf, 0x61f45b8162, 0x3faa4ac2a5, 0x0a6045fc18,
+	0x58ad74cb19, 0x6d677bf5a4, 0x33396ab663, 0x06f36588de,
+	0x3570fa8c00, 0x00baf5b2bd, 0x5ee4e4f17a, 0x6b2eebcfc7,
+	0x418b342295, 0x74413b1c28, 0x2a1f2a5fef, 0x1fd5256152,
+	0x2c56ba658c, 0x199cb55b31, 0x47c2a418f6, 0x7208ab264b,
+	0x20c59a114a, 0x150f952ff7, 0x4b51846c30, 0x7e9b8b528d,
+	0x4d18145653, 0x78d21b68ee, 0x268c0a2b29, 0x1346051594,
+};
+
+static const bch_poly_t bch_4bit_table[256] = {
+	0x0000000000000, 0x98bc3bc50597b, 0x745b73b0b345d, 0xece74875b6d26,
+	0xe8b6e761668ba, 0x700adca4631c1, 0x9ced94d1d5ce7, 0x0451af14d059c,
+	0x944ecaf8757df, 0x0cf2f13d70ea4, 0xe015b948c6382, 0x78a9828dc3af9,
+	0x7cf82d9913f65, 0xe444165c1661e, 0x08a35e29a0b38, 0x901f65eca5243,
+	0x6dbe91ca52915, 0xf502aa0f5706e, 0x19e5e27ae1d48, 0x8159d9bfe4433,
+	0x850876ab341af, 0x1db44d6e318d4, 0xf153051b875f2, 0x69ef3ede82c89,
+	0xf9f05b3227eca, 0x614c60f7227b1, 0x8dab288294a97, 0x15171347913ec,
+	0x1146bc5341670, 0x89fa879644f0b, 0x651dcfe3f222d, 0xfda1f426f7b56,
+	0xdb7d2394a522a, 0x43c11851a0b51, 0xaf26502416677, 0x379a6be113f0c,
+	0x33cbc4f5c3a90, 0xab77ff30c63eb, 0x4790b74570ecd, 0xdf2c8c80757b6,
+	0x4f33e96cd05f5, 0xd78fd2a9d5c8e, 0x3b689adc631a8, 0xa3d4a119668d3,
+	0xa7850e0db6d4f, 0x3f3935c8b3434, 0xd3de7dbd05912, 0x4b62467800069,
+	0xb6c3b25ef7b3f, 0x2e7f899bf2244, 0xc298c1ee44f62, 0x5a24fa2b41619,
+	0x5e75553f91385, 0xc6c96efa94afe, 0x2a2e268f227d8, 0xb2921d4a27ea3,
+	0x228d78a682ce0, 0xba3143638759b, 0x56d60b16318bd, 0xce6a30d3341c6,
+	0xca3b9fc7e445a, 0x5287a402e1d21, 0xbe60ec7757007, 0x26dcd7b25297c,
+	0xf3d94313f22ff, 0x6b6578d6f7b84, 0x878230a3416a2, 0x1f3e0b6644fd9,
+	0x1b6fa47294a45, 0x83d39fb79133e, 0x6f34d7c227e18, 0xf788ec0722763,
+	0x679789eb87520, 0xff2bb22e82c5b, 0x13ccfa5b3417d, 0x8b70c19e31806,
+	0x8f216e8ae1d9a, 0x179d554fe44e1, 0xfb7a1d3a529c7, 0x63c626ff570bc,
+	0x9e67d2d9a0bea, 0x06dbe91ca5291, 0xea3ca16913fb7, 0x72809aac166cc,
+	0x76d135b8c6350, 0xee6d0e7dc3a2b, 0x028a46087570d, 0x9a367dcd70e76,
+	0x0a291821d5c35, 0x929523e4d054e, 0x7e726b9166868, 0xe6ce505463113,
+	0xe29fff40b348f, 0x7a23c485b6df4, 0x96c48cf0000d2, 0x0e78b735059a9,
+	0x28a46087570d5, 0xb0185b42529ae, 0x5cff1337e4488, 0xc44328f2e1df3,
+	0xc01287e63186f, 0x58aebc2334114, 0xb449f45682c32, 0x2cf5cf9387549,
+	0xbceaaa7f2270a, 0x245691ba27e71, 0xc8b1d9cf91357, 0x500de20a94a2c,
+	0x545c4d1e44fb0, 0xcce076db416cb, 0x20073eaef7bed, 0xb8bb056bf2296,
+	0x451af14d059c0, 0xdda6ca88000bb, 0x314182fdb6d9d, 0xa9fdb938b34e6,
+	0xadac162c6317a, 0x35102de966801, 0xd9f7659cd0527, 0x414b5e59d5c5c,
+	0xd1543bb570e1f, 0x49e8007075764, 0xa50f4805c3a42, 0x3db373c0c6339,
+	0x39e2dcd4166a5, 0xa15ee71113fde, 0x4db9af64a52f8, 0xd50594a1a0b83,
+	0xa291821d5c355, 0x3a2db9d859a2e, 0xd6caf1adef708, 0x4e76ca68eae73,
+	0x4a27657c3abef, 0xd29b5eb93f294, 0x3e7c16cc89fb2, 0xa6c02d098c6c9,
+	0x36df48e52948a, 0xae6373202cdf1, 0x42843b559a0d7, 0xda3800909f9ac,
+	0xde69af844fc30, 0x46d594414a54b, 0xaa32dc34fc86d, 0x328ee7f1f9116,
+	0xcf2f13d70ea40, 0x579328120b33b, 0xbb746067bde1d, 0x23c85ba2b8766,
+	0x2799f4b6682fa, 0xbf25cf736db81, 0x53c28706db6a7, 0xcb7ebcc3defdc,
+	0x5b61d92f7bd9f, 0xc3dde2ea7e4e4, 0x2f3aaa9fc89c2, 0xb786915acd0b9,
+	0xb3d73e4e1d525, 0x2b6b058b18c5e, 0xc78c4dfeae178, 0x5f30763bab803,
+	0x79eca189f917f, 0xe1509a4cfc804, 0x0db7d2394a522, 0x950be9fc4fc59,
+	0x915a46e89f9c5, 0x09e67d2d9a0be, 0xe50135582cd98, 0x7dbd0e9d294e3,
+	0xeda26b718c6a0, 0x751e50b489fdb, 0x99f918c13f2fd, 0x014523043ab86,
+	0x05148c10eae1a, 0x9da8b7d5ef761, 0x714fffa059a47, 0xe9f3c4655c33c,
+	0x14523043ab86a, 0x8cee0b86ae111, 0x600943f318c37, 0xf8b578361d54c,
+	0xfce4d722cd0d0, 0x6458ece7c89ab, 0x88bfa4927e48d, 0x10039f577bdf6,
+	0x801cfabbdefb5, 0x18a0c17edb6ce, 0xf447890b6dbe8, 0x6cfbb2ce68293,
+	0x68aa1ddab870f, 0xf016261fbde74, 0x1cf16e6a0b352, 0x844d55af0ea29,
+	0x5148c10eae1aa, 0xc9f4facbab8d1, 0x2513b2be1d5f7, 0xbdaf897b18c8c,
+	0xb9fe266fc8910, 0x21421daacd06b, 0xcda555df7bd4d, 0x55196e1a7e436,
+	0xc5060bf6db675, 0x5dba3033def0e, 0xb15d784668228, 0x29e143836db53,
+	0x2db0ec97bdecf, 0xb50cd752b87b4, 0x59eb9f270ea92, 0xc157a4e20b3e9,
+	0x3cf650c4fc8bf, 0xa44a6b01f91c4, 0x48ad23744fce2, 0xd01118b14a599,
+	0xd440b7a59a005, 0x4cfc8c609f97e, 0xa01bc41529458, 0x38a7ffd02cd23,
+	0xa8b89a3c89f60, 0x3004a1f98c61b, 0xdce3e98c3ab3d, 0x445fd2493f246,
+	0x400e7d5def7da, 0xd8b24698eaea1, 0x34550eed5c387, 0xace9352859afc,
+	0x8a35e29a0b380, 0x1289d95f0eafb, 0xfe6e912ab87dd, 0x66d2aaefbdea6,
+	0x628305fb6db3a, 0xfa3f3e3e68241, 0x16d8764bdef67, 0x8e644d8edb61c,
+	0x1e7b28627e45f, 0x86c713a77bd24, 0x6a205bd2cd002, 0xf29c6017c8979,
+	0xf6cdcf0318ce5, 0x6e71f4c61d59e, 0x8296bcb3ab8b8, 0x1a2a8776ae1c3,
+	0xe78b735059a95, 0x7f3748955c3ee, 0x93d000e0eaec8, 0x0b6c3b25ef7b3,
+	0x0f3d94313f22f, 0x9781aff43ab54, 0x7b66e7818c672, 0xe3dadc4489f09,
+	0x73c5b9a82cd4a, 0xeb79826d29431, 0x079eca189f917, 0x9f22f1dd9a06c,
+	0x9b735ec94a5f0, 0x03cf650c4fc8b, 0xef282d79f91ad, 0x779416bcfc8d6,
+};
+#endif
+
 const struct bch_def bch_1bit = {
 	.syns		= 2,
 	.generator	= 0x201b,
 	.degree		= 13,
-	.ecc_bytes	= 2
+	.ecc_bytes	= 2,
+	.table		= BCH_TABLE(bch_1bit)
 };
 
 const struct bch_def bch_2bit = {
 	.syns		= 4,
 	.generator	= 0x4d5154b,
 	.degree		= 26,
-	.ecc_bytes	= 4
+	.ecc_bytes	= 4,
+	.table		= BCH_TABLE(bch_2bit)
 };
 
 const struct bch_def bch_3bit = {
 	.syns		= 6,
 	.generator	= 0xbaf5b2bded,
 	.degree		= 39,
-	.ecc_bytes	= 5
+	.ecc_bytes	= 5,
+	.table		= BCH_TABLE(bch_3bit)
 };
 
 const struct bch_def bch_4bit = {
 	.syns		= 8,
 	.generator	= 0x14523043ab86ab,
 	.degree		= 52,
-	.ecc_bytes	= 7
+	.ecc_bytes	= 7,
+	.table		= BCH_TABLE(bch_4bit)
 };
 
 static bch_poly_t chunk_remainder(const struct bch_def *def,
@@ -54,6 +274,14 @@ static bch_poly_t chunk_remainder(const struct bch_def *def,
 	bch_poly_t remainder = 0;
 	int i;
 
+	if (def->table) {
+		for (i = 0; i < len; i++)
+			remainder = (remainder >> 8) ^
+				def->table[(remainder ^ chunk[i] ^ 0xff) & 0xff];
+
+		return remainder;
+	}
+
 	for (i = 0; i < len; i++) {
 		int j;
 
@@ -130,6 +358,7 @@ static void poly_add(gf13_elem_t *dst, const gf13_elem_t *src,
 	}
 }
 
+#ifdef BCH_SERIAL_DECODE
 static gf13_elem_t poly_eval(const gf13_elem_t *s, gf13_elem_t x)
 {
 	int i;
@@ -147,11 +376,14 @@ static gf13_elem_t poly_eval(const gf13_elem_t *s, gf13_elem_t x)
 
 	return sum;
 }
+#endif
 
 /************************************************************************
  * Error correction
  */
 
+#ifdef BCH_SERIAL_DECODE
+
 static gf13_elem_t syndrome(const struct bch_def *bch,
 			    const uint8_t *chunk,
 			    size_t len,
@@ -185,6 +417,115 @@ static gf13_elem_t syndrome(const struct bch_def *bch,
 
 	return y;
 }
+#else
+static gf13_elem_t poly_pow(gf13_elem_t x, unsigned int e)
+{
+	gf13_elem_t r = 1;
+
+	while (e) {
+		if (e & 1)
+			r = gf13_mul(r, x);
+
+		x = gf13_mul(x, x);
+		e >>= 1;
+	}
+
+	return r;
+}
+
+/* The received word and the word made of zero chunk bits followed by
+ * the residual (computed remainder XOR stored ECC) differ by a codeword,
+ * so they have the same syndromes: the residual evaluated at x, shifted
+ * past the chunk bits. This costs one division of the chunk instead of a
+ * bit-serial pass over it per syndrome.
+ */
+static gf13_elem_t syndrome(const struct bch_def *bch,
+			    size_t len,
+			    bch_poly_t residual,
+			    gf13_elem_t x)
+{
+	gf13_elem_t y = 0;
+	int i;
+
+	for (i = bch->degree - 1; i >= 0; i--) {
+		if (y)
+			y = gf13_mul(y, x);
+
+		if ((residual >> i) & 1)
+			y ^= 1;
+	}
+
+	return y ? gf13_mul(y, poly_pow(x, len << 3)) : 0;
+}
+
+/* Chien search: the error locations are the bits i with
+ * sigma(x^-i) == 0. The nonzero terms of sigma are kept as logarithms
+ * and stepped by -k for each bit, and the search stops once all roots
+ * of sigma have been found.
+ */
+static void flip_bit(int i, uint8_t *chunk, int chunk_bits, uint8_t *ecc)
+{
+	if (i < chunk_bits) {
+		chunk[i >> 3] ^= 1 << (i & 7);
+	} else {
+		i -= chunk_bits;
+		ecc[i >> 3] ^= 1 << (i & 7);
+	}
+}
+
+static void chien_search(const struct bch_def *bch, const gf13_elem_t *sigma,
+			 uint8_t *chunk, size_t len, uint8_t *ecc)
+{
+	const int chunk_bits = len << 3;
+	const int total_bits = chunk_bits + bch->degree;
+	gf13_elem_t lterm[MAX_POLY];
+	int order[MAX_POLY];
+	int roots = 0;
+	int terms = 0;
+	int i;
+
+	for (i = 1; i < MAX_POLY; i++) {
+		if (sigma[i]) {
+			lterm[terms] = gf13_log[sigma[i]];
+			order[terms++] = i;
+			roots = i;
+		}
+	}
+
+	if (!roots)
+		return;
+
+	/* A single error is at the root of sigma[0] + sigma[1] * x */
+	if (roots == 1) {
+		i = gf13_wrap(lterm[0] + GF13_ORDER - gf13_log[sigma[0]]);
+
+		if (i < total_bits)
+			flip_bit(i, chunk, chunk_bits, ecc);
+
+		return;
+	}
+
+	for (i = 0; i < total_bits; i++) {
+		gf13_elem_t sum = sigma[0];
+		int k;
+
+		for (k = 0; k < terms; k++) {
+			sum ^= gf13_exp[lterm[k]];
+			lterm[k] = (lterm[k] >= order[k]) ?
+				lterm[k] - order[k] :
+				lterm[k] + GF13_ORDER - order[k];
+		}
+
+		if (sum)
+			continue;
+
+		flip_bit(i, chunk, chunk_bits, ecc);
+
+		if (!--roots)
+			break;
+	}
+}
+#endif
 
 static void berlekamp_massey(const gf13_elem_t *s, int N,
 			     gf13_elem_t *sigma)
@@ -236,6 +577,7 @@ static void berlekamp_massey(const gf13_elem_t *s, int N,
 	memcpy(sigma, C, MAX_POLY);
 }
 
+#ifdef BCH_SERIAL_DECODE
 void bch_repair(const struct bch_def *bch,
 		uint8_t *chunk, size_t len, uint8_t *ecc)
 {
@@ -273,3 +615,38 @@ void bch_repair(const struct bch_def *bch,
 		x = gf13_divx(x);
 	}
 }
+#else
+void bch_repair(const struct bch_def *bch,
+		uint8_t *chunk, size_t len, uint8_t *ecc)
+{
+	const bch_poly_t residual = chunk_remainder(bch, chunk, len) ^
+		unpack_poly(bch, ecc);
+	gf13_elem_t syns[BCH_MAX_SYNS];
+	gf13_elem_t sigma[MAX_POLY];
+	gf13_elem_t x;
+	int i;
+
+	if (!residual)
+		return;
+
+	/* Compute syndrome vector. The code is binary, so that
+	 * S(2j) = S(j)^2 and only odd syndromes need to be evaluated.
+	 */
+	x = 2;
+	for (i = 0; i < bch->syns; i++) {
+		if (i & 1)
+			syns[i] = syns[i >> 1] ?
+				gf13_mul(syns[i >> 1], syns[i >> 1]) : 0;
+		else
+			syns[i] = syndrome(bch, len, residual, x);
+
+		x = gf13_mulx(x);
+	}
+
+	/* Compute sigma */
+	berlekamp_massey(syns, bch->syns, sigma);
+
+	/* Each root of sigma corresponds to an error location */
+	chien_search(bch, sigma, chunk, len, ecc);
+}
+#endif
@@ -45,6 +45,11 @@ struct bch_def {
 
 	/* Number of ECC bytes */
 	int		ecc_bytes;
+
+	/* Remainder of each byte value, for the byte-at-a-time division
+	 * (optional). If NULL, the chunk is divided bit by bit.
+	 */
+	const bch_poly_t	*table;
 };
 
 /* Maximum number of ECC bytes (required for 4-bit codes). Some codes
@@ -58,6 +63,14 @@ struct bch_def {
  */
 #define BCH_MAX_CHUNK_SIZE	(1023 - BCH_MAX_ECC)
 
+/* If you need to reduce the code size, you can define BCH_NO_TABLES.
+ *
+ * This leaves out the remainder tables of the codes below (8 kB) and
+ * decodes with the bit-serial syndrome computation and a full root
+ * search, as with GF13_NO_TABLES. It is much slower, mostly in
+ * bch_repair().
+ */
+
 /* BCH codes for 1, 2, 3 and 4-bit ECC */
 extern const struct bch_def bch_1bit;
 extern const struct bch_def bch_2bit;
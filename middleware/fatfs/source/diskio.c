@@ -17,6 +17,7 @@
 #include "ffconf.h"     /* FatFs configuration options */
 #include "ff.h"         /* Obtains integer types */
 #include "diskio.h"     /* Declarations of disk functions */
+#include <stddef.h>
 
 #if defined(RAM_DISK_ENABLE) && (RAM_DISK_ENABLE == 1)
 #include "fsl_ram_disk.h"
@@ -42,6 +43,109 @@
 #include "fsl_nand_disk.h"
 #endif
 
+#if FF_DISK_ASYNC && FF_FS_REENTRANT
+#include "task.h"
+#endif
+
+/*-----------------------------------------------------------------------*/
+/* Drive Lock                                                            */
+/*-----------------------------------------------------------------------*/
+/* With FF_DISK_ASYNC on an RTOS (FF_FS_REENTRANT), the transfers queued */
+/* by disk_submit run in a worker task. A mutex serializes them with the */
+/* disk_read/disk_write/disk_ioctl calls of the other tasks, as the low  */
+/* level drivers are not reentrant.                                      */
+
+#if FF_DISK_ASYNC && FF_FS_REENTRANT
+
+#ifndef FF_DISK_ASYNC_TASK_PRIORITY
+#define FF_DISK_ASYNC_TASK_PRIORITY (configMAX_PRIORITIES - 2)
+#endif
+
+#ifndef FF_DISK_ASYNC_TASK_STACK_SIZE
+#define FF_DISK_ASYNC_TASK_STACK_SIZE (configMINIMAL_STACK_SIZE + 256)
+#endif
+
+#ifndef FF_DISK_ASYNC_NOTIFY_INDEX
+#define FF_DISK_ASYNC_NOTIFY_INDEX 1
+#endif
+
+#if FF_DISK_ASYNC_NOTIFY_INDEX < 1 || FF_DISK_ASYNC_NOTIFY_INDEX >= configTASK_NOTIFICATION_ARRAY_ENTRIES
+#error "FF_DISK_ASYNC_NOTIFY_INDEX must be a task notification index other than 0, below configTASK_NOTIFICATION_ARRAY_ENTRIES"
+#endif
+
+static SemaphoreHandle_t s_diskLock;
+static QueueHandle_t s_diskQueue;
+static TaskHandle_t s_diskTask;
+
+/* The first disk_initialize creates the worker objects. The creation    */
+/* is claimed in a short critical section and done after leaving it, as  */
+/* the RTOS allocates them and must not be called from a critical        */
+/* section. Tasks initializing a drive at the same time wait for it.     */
+#define DISK_ASYNC_NONE 0U
+#define DISK_ASYNC_BUSY 1U
+#define DISK_ASYNC_DONE 2U
+
+static volatile uint8_t s_diskAsyncState = DISK_ASYNC_NONE;
+
+static void disk_async_task(void *param);
+
+static DRESULT disk_async_init(void)
+{
+    uint8_t state;
+
+    taskENTER_CRITICAL();
+    state = s_diskAsyncState;
+    if (state == DISK_ASYNC_NONE)
+    {
+        s_diskAsyncState = DISK_ASYNC_BUSY;
+    }
+    taskEXIT_CRITICAL();
+
+    if (state != DISK_ASYNC_NONE)
+    {
+        while (s_diskAsyncState == DISK_ASYNC_BUSY)
+        {
+            vTaskDelay(1);
+        }
+        return (s_diskAsyncState == DISK_ASYNC_DONE) ? RES_OK : RES_ERROR;
+    }
+
+    /* The lock and the queue exist before the task that uses them */
+    s_diskLock  = xSemaphoreCreateMutex();
+    s_diskQueue = xQueueCreate(FF_DISK_ASYNC, sizeof(DREQ *));
+    if ((s_diskLock == NULL) || (s_diskQueue == NULL) ||
+        (xTaskCreate(disk_async_task, "diskio", FF_DISK_ASYNC_TASK_STACK_SIZE, NULL, FF_DISK_ASYNC_TASK_PRIORITY,
+                     &s_diskTask) != pdPASS))
+    {
+        if (s_diskQueue != NULL)
+        {
+            vQueueDelete(s_diskQueue);
+            s_diskQueue = NULL;
+        }
+        if (s_diskLock != NULL)
+        {
+            vSemaphoreDelete(s_diskLock);
+            s_diskLock = NULL;
+        }
+        s_diskTask = NULL;
+
+        /* A later disk_initialize tries again */
+        s_diskAsyncState = DISK_ASYNC_NONE;
+        return RES_ERROR;
+    }
+
+    s_diskAsyncState = DISK_ASYNC_DONE;
+    return RES_OK;
+}
+
+#define disk_lock()   (void)xSemaphoreTake(s_diskLock, portMAX_DELAY)
+#define disk_unlock() (void)xSemaphoreGive(s_diskLock)
+#else
+#define disk_async_init() RES_OK
+#define disk_lock()
+#define disk_unlock()
+#endif
+
 /*-----------------------------------------------------------------------*/
 /* Get Drive Status                                                      */
 /*-----------------------------------------------------------------------*/
@@ -100,6 +204,10 @@ DSTATUS disk_initialize (
 )
 {
     DSTATUS stat;
+    if (disk_async_init() != RES_OK)
+    {
+        return STA_NOINIT;
+    }
     switch (pdrv)
     {
 #if defined(RAM_DISK_ENABLE) && (RAM_DISK_ENABLE == 1)
@@ -145,7 +253,7 @@ DSTATUS disk_initialize (
 /* Read Sector(s)                                                        */
 /*-----------------------------------------------------------------------*/
 
-DRESULT disk_read (
+static DRESULT disk_read_drive (
     BYTE pdrv,        /* Physical drive nmuber to identify the drive */
     BYTE *buff,        /* Data buffer to store read data */
     LBA_t sector,    /* Start sector in LBA */
@@ -200,7 +308,7 @@ DRESULT disk_read (
 /*-----------------------------------------------------------------------*/
 
 #if FF_FS_READONLY == 0
-DRESULT disk_write (
+static DRESULT disk_write_drive (
     BYTE pdrv,            /* Physical drive nmuber to identify the drive */
     const BYTE *buff,    /* Data to be written */
     LBA_t sector,        /* Start sector in LBA */
@@ -253,7 +361,7 @@ DRESULT disk_write (
 /* Miscellaneous Functions                                               */
 /*-----------------------------------------------------------------------*/
 
-DRESULT disk_ioctl (
+static DRESULT disk_ioctl_drive (
     BYTE pdrv,        /* Physical drive nmuber (0..) */
     BYTE cmd,        /* Control code */
     void *buff        /* Buffer to send/receive control data */
@@ -299,3 +407,156 @@ DRESULT disk_ioctl (
     return RES_PARERR;
 }
 
+
+/*-----------------------------------------------------------------------*/
+/* Read Sector(s), Write Sector(s) and Miscellaneous Functions           */
+/*-----------------------------------------------------------------------*/
+
+DRESULT disk_read (
+    BYTE pdrv,        /* Physical drive nmuber to identify the drive */
+    BYTE *buff,        /* Data buffer to store read data */
+    LBA_t sector,    /* Start sector in LBA */
+    UINT count        /* Number of sectors to read */
+)
+{
+    DRESULT res;
+    disk_lock();
+    res = disk_read_drive(pdrv, buff, sector, count);
+    disk_unlock();
+    return res;
+}
+
+#if FF_FS_READONLY == 0
+DRESULT disk_write (
+    BYTE pdrv,            /* Physical drive nmuber to identify the drive */
+    const BYTE *buff,    /* Data to be written */
+    LBA_t sector,        /* Start sector in LBA */
+    UINT count            /* Number of sectors to write */
+)
+{
+    DRESULT res;
+    disk_lock();
+    res = disk_write_drive(pdrv, buff, sector, count);
+    disk_unlock();
+    return res;
+}
+#endif
+
+DRESULT disk_ioctl (
+    BYTE pdrv,        /* Physical drive nmuber (0..) */
+    BYTE cmd,        /* Control code */
+    void *buff        /* Buffer to send/receive control data */
+)
+{
+    DRESULT res;
+    disk_lock();
+    res = disk_ioctl_drive(pdrv, cmd, buff);
+    disk_unlock();
+    return res;
+}
+
+
+
+#if FF_DISK_ASYNC
+/*-----------------------------------------------------------------------*/
+/* Asynchronous Read/Write                                               */
+/*-----------------------------------------------------------------------*/
+/* disk_submit queues a transfer and returns. On completion req->res is  */
+/* set, req->complete is called and req->busy is cleared. Without RTOS   */
+/* the transfer is done before disk_submit returns.                      */
+
+static void disk_transfer (
+    DREQ *req        /* Request to run */
+)
+{
+    void (*complete)(DREQ *req) = req->complete;
+
+#if FF_FS_READONLY == 0
+    if (req->write != 0U)
+    {
+        req->res = disk_write_drive(req->pdrv, req->buff, req->sector, req->count);
+    }
+    else
+#endif
+    {
+        req->res = disk_read_drive(req->pdrv, req->buff, req->sector, req->count);
+    }
+    if (complete != NULL)
+    {
+        complete(req);
+    }
+}
+
+#if FF_FS_REENTRANT
+static void disk_async_task (
+    void *param
+)
+{
+    DREQ *req;
+    TaskHandle_t owner;
+
+    (void)param;
+    for (;;)
+    {
+        if (xQueueReceive(s_diskQueue, &req, portMAX_DELAY) == pdTRUE)
+        {
+            owner = (TaskHandle_t)req->owner;
+            disk_lock();
+            disk_transfer(req);
+            disk_unlock();
+            /* The owner may reuse the request once busy is cleared */
+            req->busy = 0U;
+            (void)xTaskNotifyGiveIndexed(owner, FF_DISK_ASYNC_NOTIFY_INDEX);
+        }
+    }
+}
+#endif
+
+DRESULT disk_submit (
+    DREQ *req        /* Request to be queued */
+)
+{
+    if (req == NULL)
+    {
+        return RES_PARERR;
+    }
+#if FF_FS_READONLY
+    if (req->write != 0U)
+    {
+        return RES_WRPRT;
+    }
+#endif
+    req->busy = 1U;
+#if FF_FS_REENTRANT
+    if (s_diskQueue == NULL)
+    {
+        req->busy = 0U;
+        return RES_NOTRDY;
+    }
+    req->owner = xTaskGetCurrentTaskHandle();
+    (void)xQueueSend(s_diskQueue, &req, portMAX_DELAY);
+#else
+    req->owner = NULL;
+    disk_transfer(req);
+    req->busy = 0U;
+#endif
+    return RES_OK;
+}
+
+/* Blocks until the request is completed. On an RTOS the waiting task    */
+/* must be the one which submitted the request, the completion is sent   */
+/* by its task notification FF_DISK_ASYNC_NOTIFY_INDEX, so notifications */
+/* the application uses on the default index are left alone.             */
+DRESULT disk_wait (
+    DREQ *req        /* Submitted request */
+)
+{
+#if FF_FS_REENTRANT
+    while (req->busy != 0U)
+    {
+        (void)ulTaskNotifyTakeIndexed(FF_DISK_ASYNC_NOTIFY_INDEX, pdTRUE, portMAX_DELAY);
+    }
+#endif
+    return req->res;
+}
+#endif
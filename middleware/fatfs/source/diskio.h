@@ -29,6 +29,22 @@ typedef enum {
 	RES_PARERR		/* 4: Invalid Parameter */
 } DRESULT;
 
+#if FF_DISK_ASYNC
+/* Asynchronous disk request */
+typedef struct DREQ_ {
+	BYTE	pdrv;		/* Physical drive number */
+	BYTE	write;		/* 0:Read, 1:Write */
+	volatile BYTE busy;	/* Set by disk_submit, cleared by the disk layer on completion */
+	DRESULT	res;		/* Result of the transfer, valid when busy is cleared */
+	BYTE*	buff;		/* Data buffer */
+	LBA_t	sector;		/* Start sector in LBA */
+	UINT	count;		/* Number of sectors */
+	void	(*complete)(struct DREQ_* req);	/* Completion callback (can be null), called in the context of the disk layer */
+	void*	ctx;		/* Argument for the completion callback */
+	void*	owner;		/* Used by the disk layer */
+} DREQ;
+#endif
+
 
 /*---------------------------------------*/
 /* Prototypes for disk control functions */
@@ -39,6 +55,10 @@ DSTATUS disk_status (BYTE pdrv);
 DRESULT disk_read (BYTE pdrv, BYTE* buff, LBA_t sector, UINT count);
 DRESULT disk_write (BYTE pdrv, const BYTE* buff, LBA_t sector, UINT count);
 DRESULT disk_ioctl (BYTE pdrv, BYTE cmd, void* buff);
+#if FF_DISK_ASYNC
+DRESULT disk_submit (DREQ* req);
+DRESULT disk_wait (DREQ* req);
+#endif
 
 
 /* Disk Status Bits (DSTATUS) */
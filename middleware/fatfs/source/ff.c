@@ -266,6 +266,24 @@
 #endif
 
 
+/* Sector cache */
+#if FF_WIN_CACHE && (FF_WIN_CACHE > 255 || FF_FS_TINY)
+#error Wrong FF_WIN_CACHE setting
+#endif
+
+
+/* Asynchronous disk access */
+#if FF_DISK_ASYNC && (FF_DISK_ASYNC < 2 || FF_DISK_ASYNC > 8 || FF_FS_TINY)
+#error Wrong FF_DISK_ASYNC setting
+#endif
+
+
+/* Directory name cache */
+#if FF_DIR_CACHE && (FF_DIR_CACHE < 8 || (FF_DIR_CACHE & (FF_DIR_CACHE - 1)) || (FF_DIR_FILTER & (FF_DIR_FILTER - 1)))
+#error Wrong FF_DIR_CACHE or FF_DIR_FILTER setting
+#endif
+
+
 /* Timestamp */
 #if FF_FS_NORTC == 1
 #if FF_NORTC_YEAR < 1980 || FF_NORTC_YEAR > 2107 || FF_NORTC_MON < 1 || FF_NORTC_MON > 12 || FF_NORTC_MDAY < 1 || FF_NORTC_MDAY > 31
@@ -1054,6 +1072,20 @@ static void clear_share (	/* Clear all lock entries of the volume */
 /* Move/Flush disk access window in the filesystem object                */
 /*-----------------------------------------------------------------------*/
 #if !FF_FS_READONLY
+static FRESULT write_window (	/* Returns FR_OK or FR_DISK_ERR */
+	FATFS* fs,			/* Filesystem object */
+	const BYTE* buf,	/* Sector data */
+	LBA_t sect			/* Sector LBA to write it into */
+)
+{
+	if (disk_write(fs->pdrv, buf, sect, 1) != RES_OK) return FR_DISK_ERR;	/* Write it back into the volume */
+	if (sect - fs->fatbase < fs->fsize) {	/* Is it in the 1st FAT? */
+		if (fs->n_fats == 2) disk_write(fs->pdrv, buf, sect + fs->fsize, 1);	/* Reflect it to 2nd FAT if needed */
+	}
+	return FR_OK;
+}
+
+
 static FRESULT sync_window (	/* Returns FR_OK or FR_DISK_ERR */
 	FATFS* fs			/* Filesystem object */
 )
@@ -1062,19 +1094,113 @@ static FRESULT sync_window (	/* Returns FR_OK or FR_DISK_ERR */
 
 
 	if (fs->wflag) {	/* Is the disk access window dirty? */
-		if (disk_write(fs->pdrv, fs->win, fs->winsect, 1) == RES_OK) {	/* Write it back into the volume */
-			fs->wflag = 0;	/* Clear window dirty flag */
-			if (fs->winsect - fs->fatbase < fs->fsize) {	/* Is it in the 1st FAT? */
-				if (fs->n_fats == 2) disk_write(fs->pdrv, fs->win, fs->winsect + fs->fsize, 1);	/* Reflect it to 2nd FAT if needed */
-			}
-		} else {
-			res = FR_DISK_ERR;
+		res = write_window(fs, fs->win, fs->winsect);
+		if (res == FR_OK) fs->wflag = 0;	/* Clear window dirty flag */
+	}
+	return res;
+}
+#endif
+
+
+#if FF_WIN_CACHE
+#if !FF_FS_READONLY
+static FRESULT sync_cache (	/* Returns FR_OK or FR_DISK_ERR */
+	FATFS* fs			/* Filesystem object */
+)
+{
+	FRESULT res;
+	UINT i;
+
+
+	res = sync_window(fs);		/* Flush the window */
+	for (i = 0; i < FF_WIN_CACHE && res == FR_OK; i++) {	/* Flush dirty sectors in the cache */
+		if (fs->wc_dirty[i]) {
+			res = write_window(fs, fs->wc_buf[i], fs->wc_sect[i]);
+			if (res == FR_OK) fs->wc_dirty[i] = 0;
 		}
 	}
 	return res;
 }
+
+
+static void drop_cache (
+	FATFS* fs,			/* Filesystem object */
+	LBA_t sect,			/* Top of the sectors to be discarded */
+	UINT count			/* Number of sectors */
+)
+{
+	UINT i;
+
+
+	if (fs->winsect - sect < count) {	/* Discard the window if it is in the range, dirty or not */
+		fs->wflag = 0; fs->winsect = (LBA_t)0 - 1;
+	}
+	for (i = 0; i < FF_WIN_CACHE; i++) {	/* Discard cached copies of the sectors */
+		if (fs->wc_sect[i] - sect < count) {
+			fs->wc_dirty[i] = 0; fs->wc_sect[i] = (LBA_t)0 - 1; fs->wc_used[i] = 0;
+		}
+	}
+}
+#endif
+
+
+static void reset_cache (
+	FATFS* fs			/* Filesystem object */
+)
+{
+	UINT i;
+
+
+	fs->wflag = 0; fs->winsect = (LBA_t)0 - 1;		/* Invalidate window */
+	for (i = 0; i < FF_WIN_CACHE; i++) {	/* Invalidate all cache slots */
+		fs->wc_dirty[i] = 0; fs->wc_sect[i] = (LBA_t)0 - 1; fs->wc_used[i] = 0;
+	}
+}
+
+
+static FRESULT move_window (	/* Returns FR_OK or FR_DISK_ERR */
+	FATFS* fs,		/* Filesystem object */
+	LBA_t sect		/* Sector LBA to make appearance in the fs->win[] */
+)
+{
+	FRESULT res = FR_OK;
+	UINT i, n;
+	LBA_t ws;
+	BYTE wf, *p, tmp[64];
+
+
+	if (sect != fs->winsect) {	/* Window offset changed? */
+		for (i = n = 0; i < FF_WIN_CACHE && fs->wc_sect[i] != sect; i++) {	/* Find the sector or the least recently used slot */
+			if (fs->wc_used[i] < fs->wc_used[n]) n = i;
+		}
+		p = fs->wc_buf[i < FF_WIN_CACHE ? i : n];
+		ws = fs->winsect; wf = fs->wflag;
+		if (i < FF_WIN_CACHE) {		/* Cache hit: exchange the window and the slot */
+			n = i;
+			for (i = 0; i < SS(fs); i += sizeof tmp) {
+				memcpy(tmp, fs->win + i, sizeof tmp); memcpy(fs->win + i, p + i, sizeof tmp); memcpy(p + i, tmp, sizeof tmp);
+			}
+			fs->winsect = sect; fs->wflag = fs->wc_dirty[n];
+		} else {					/* Cache miss: replace the least recently used slot with the window */
+#if !FF_FS_READONLY
+			if (fs->wc_dirty[n]) {	/* Write-back the slot to be replaced */
+				if (write_window(fs, p, fs->wc_sect[n]) != FR_OK) return FR_DISK_ERR;	/* Leave the window as it is */
+			}
 #endif
+			memcpy(p, fs->win, SS(fs));
+			if (disk_read(fs->pdrv, fs->win, sect, 1) != RES_OK) {	/* Fill sector window with new data */
+				sect = (LBA_t)0 - 1;	/* Invalidate window if read data is not valid */
+				res = FR_DISK_ERR;
+			}
+			fs->winsect = sect; fs->wflag = 0;
+		}
+		fs->wc_sect[n] = ws; fs->wc_dirty[n] = wf;	/* The previous window is now in the slot */
+		fs->wc_used[n] = (ws == (LBA_t)0 - 1) ? 0 : ++fs->wc_tick;
+	}
+	return res;
+}
 
+#else
 
 static FRESULT move_window (	/* Returns FR_OK or FR_DISK_ERR */
 	FATFS* fs,		/* Filesystem object */
@@ -1098,6 +1224,7 @@ static FRESULT move_window (	/* Returns FR_OK or FR_DISK_ERR */
 	}
 	return res;
 }
+#endif	/* FF_WIN_CACHE */
 
 
 
@@ -1114,9 +1241,16 @@ static FRESULT sync_fs (	/* Returns FR_OK or FR_DISK_ERR */
 	FRESULT res;
 
 
+#if FF_WIN_CACHE
+	res = sync_cache(fs);
+#else
 	res = sync_window(fs);
+#endif
 	if (res == FR_OK) {
 		if (fs->fs_type == FS_FAT32 && fs->fsi_flag == 1) {	/* FAT32: Update FSInfo sector if needed */
+#if FF_WIN_CACHE
+			drop_cache(fs, fs->volbase + 1, 1);	/* Discard stale copy of the FSInfo sector */
+#endif
 			/* Create FSInfo structure */
 			memset(fs->win, 0, sizeof fs->win);
 			st_word(fs->win + BS_55AA, 0xAA55);					/* Boot signature */
@@ -1466,6 +1600,9 @@ static FRESULT remove_chain (	/* FR_OK(0):succeeded, !=0:error */
 			fs->free_clst++;
 			fs->fsi_flag |= 1;
 		}
+#if FF_WIN_CACHE
+		drop_cache(fs, clst2sect(fs, clst), fs->csize);	/* Discard cached sectors of the freed cluster */
+#endif
 #if FF_FS_EXFAT || FF_USE_TRIM
 		if (ecl + 1 == nxt) {	/* Is next cluster contiguous? */
 			ecl = nxt;
@@ -1652,6 +1789,47 @@ static DWORD clmt_clust (	/* <2:Error, >=2:Cluster number */
 
 
 
+#if FF_USE_CLUSTER_RUN
+/*-----------------------------------------------------------------------*/
+/* FAT handling - Extend a transfer over contiguous clusters             */
+/*-----------------------------------------------------------------------*/
+
+static UINT run_clust (	/* Returns number of sectors in the run */
+	FIL* fp,		/* Pointer to the file object (fp->clust is moved to the last cluster of the run) */
+	UINT cc,		/* Number of sectors to the end of current cluster */
+	UINT nsect,		/* Number of sectors to be transferred */
+	int stretch		/* 0:Follow the cluster chain, 1:Stretch it if needed */
+)
+{
+	DWORD clst;
+	FATFS *fs = fp->obj.fs;
+
+
+	while (nsect - cc >= fs->csize) {	/* Is next cluster transferred in whole? */
+#if FF_USE_FASTSEEK
+		if (fp->cltbl) {
+			clst = clmt_clust(fp, fp->fptr + (FSIZE_t)cc * SS(fs));	/* Get cluster# from the CLMT */
+		} else
+#endif
+		{
+#if !FF_FS_READONLY
+			clst = stretch ? create_chain(&fp->obj, fp->clust) : get_fat(&fp->obj, fp->clust);
+#else
+			clst = get_fat(&fp->obj, fp->clust);
+#endif
+		}
+		if (clst != fp->clust + 1) break;	/* End of the run (errors are left to the caller) */
+		fp->clust = clst;
+		cc += fs->csize;
+	}
+	return cc;
+}
+
+#endif	/* FF_USE_CLUSTER_RUN */
+
+
+
+
 /*-----------------------------------------------------------------------*/
 /* Directory handling - Fill a cluster with zeros                        */
 /*-----------------------------------------------------------------------*/
@@ -1669,6 +1847,9 @@ static FRESULT dir_clear (	/* Returns FR_OK or FR_DISK_ERR */
 
 	if (sync_window(fs) != FR_OK) return FR_DISK_ERR;	/* Flush disk access window */
 	sect = clst2sect(fs, clst);		/* Top of the cluster */
+#if FF_WIN_CACHE
+	drop_cache(fs, sect, fs->csize);	/* Discard stale copies of the cluster */
+#endif
 	fs->winsect = sect;				/* Set window to top of the cluster */
 	memset(fs->win, 0, sizeof fs->win);	/* Clear window buffer */
 #if FF_USE_LFN == 3		/* Quick table clear by using multi-secter write */
@@ -2379,6 +2560,515 @@ static FRESULT dir_read (
 
 
 
+#if FF_DIR_CACHE
+/*-----------------------------------------------------------------------*/
+/* Directory handling - Name cache (FAT/FAT32)                           */
+/*-----------------------------------------------------------------------*/
+/* A hint tells where a name was seen in a directory, it is looked up by */
+/* the directory and a hash of the up-cased name (name key) and verified */
+/* against the entries before use. The hints are in sets of DC_WAYS in   */
+/* the order of use. A name found or registered becomes the most recent  */
+/* hint of its set, evicting the least recent one. An entry met by a     */
+/* scan only takes a free hint, so a scan does not evict the hints that  */
+/* are in use, and only once: the volume keeps how far the directory     */
+/* scanned last has been picked up. A name filter tells that a name is   */
+/* not in a directory. It is built by a lookup that reads the whole      */
+/* table and registered names are added to it afterward.                 */
+
+#define DC_WAYS	8	/* Number of hints in a set */
+
+typedef struct {
+	DWORD	dir;		/* Directory (start cluster, 0:root, 0xFFFFFFFF:not cached) */
+	DWORD	lkey;		/* Name key of the LFN block being read */
+	DWORD	blk;		/* Offset of the LFN block being read (0xFFFFFFFF:none) */
+	BYTE	ord, sum;	/* Next order and checksum of the LFN block */
+	BYTE	build;		/* Name filter being built (0:none, 1..:filter index + 1) */
+	BYTE	pick;		/* Pick up the entries met into free hints */
+} DCSCAN;
+
+
+static DWORD dc_mix (	/* Mixed hash value */
+	DWORD h
+)
+{
+	h ^= h >> 16; h *= 0x85EBCA6B;
+	h ^= h >> 13; h *= 0xC2B2AE35;
+	return h ^ (h >> 16);
+}
+
+
+static DWORD dc_dirid (	/* Directory of the name cache */
+	DIR* dp
+)
+{
+	DWORD cl = dp->obj.sclust;
+
+
+	if (dp->obj.fs->fs_type == FS_FAT32 && cl == (DWORD)dp->obj.fs->dirbase) cl = 0;	/* Root directory */
+	return cl;
+}
+
+
+static UINT dc_set (	/* Index of the first hint in the set of the name key */
+	DWORD dir,
+	DWORD key
+)
+{
+	return (UINT)(key ^ dir * 0x9E3779B1) & (FF_DIR_CACHE - DC_WAYS);
+}
+
+
+static UINT dc_way (	/* Index of the name key in the set (DC_WAYS:not in the set) */
+	FATFS* fs,
+	UINT set,
+	DWORD dir,
+	DWORD key
+)
+{
+	UINT i;
+
+
+	for (i = 0; i < DC_WAYS && (fs->dc_dir[set + i] != dir || fs->dc_key[set + i] != key); i++) ;
+	return i;
+}
+
+
+static void dc_front (	/* Put a hint at the front of the set, over the way given */
+	FATFS* fs,
+	UINT set,
+	UINT way,			/* Way to be overwritten, the ways before it move back */
+	DWORD dir,
+	DWORD key,
+	DWORD ofs
+)
+{
+	for ( ; way > 0; way--) {
+		fs->dc_dir[set + way] = fs->dc_dir[set + way - 1];
+		fs->dc_key[set + way] = fs->dc_key[set + way - 1];
+		fs->dc_ofs[set + way] = fs->dc_ofs[set + way - 1];
+	}
+	fs->dc_dir[set] = dir; fs->dc_key[set] = key; fs->dc_ofs[set] = ofs;
+}
+
+
+static DWORD dc_sfnkey (	/* Name key of an SFN */
+	const BYTE* sfn
+)
+{
+	DWORD h = 0x811C9DC5;
+	UINT i;
+
+
+	for (i = 0; i < 11; i++) h = (h ^ sfn[i]) * 0x01000193;	/* FNV-1a */
+	return dc_mix(h);
+}
+
+
+#if FF_USE_LFN
+static DWORD dc_lfnchr (	/* Add a character to the hash of an LFN entry */
+	DWORD h,
+	WCHAR wc
+)
+{
+	if (wc >= 'a' && wc <= 'z') {
+		wc -= 0x20;				/* ASCII is the most common, skip the table */
+	} else if (wc >= 0x80) {
+		wc = (WCHAR)ff_wtoupper(wc);
+	}
+	return (h ^ wc) * 0x01000193;	/* FNV-1a */
+}
+
+
+static DWORD dc_lfnkey (	/* Name key of an LFN, the sum of the terms of its LFN entries in any order */
+	const WCHAR* lfn
+)
+{
+	DWORD key = 0, h;
+	UINT i = 0, s, ord = 1;
+
+
+	do {
+		h = 0x811C9DC5 ^ ord++;	/* Term of the entry of the characters */
+		for (s = 0; s < 13 && lfn[i]; s++, i++) h = dc_lfnchr(h, lfn[i]);
+		if (!lfn[i]) h = (h ^ 0xFFFF0000 ^ i) * 0x01000193;	/* Add the length to the last entry */
+		key += dc_mix(h);
+	} while (lfn[i]);
+	return key;
+}
+#endif
+
+
+#if FF_DIR_FILTER
+static BYTE* dc_filter (	/* Name filter of the directory (null:none) */
+	FATFS* fs,
+	DWORD dir
+)
+{
+	if (fs->df_dir[0] == dir) return fs->df_bits[0];
+	if (fs->df_dir[1] == dir) return fs->df_bits[1];
+	return 0;
+}
+
+
+static void dc_fadd (
+	BYTE* bits,		/* Name filter */
+	DWORD key		/* Name key to add */
+)
+{
+	DWORD b = dc_mix(key) % (FF_DIR_FILTER * 8);
+
+
+	key %= FF_DIR_FILTER * 8;
+	bits[key / 8] |= 1 << (key % 8);
+	bits[b / 8] |= 1 << (b % 8);
+}
+
+
+static int dc_ftest (	/* 0:not in the filter, 1:may be in the filter */
+	const BYTE* bits,	/* Name filter */
+	DWORD key			/* Name key to test */
+)
+{
+	DWORD b = dc_mix(key) % (FF_DIR_FILTER * 8);
+
+
+	key %= FF_DIR_FILTER * 8;
+	return (bits[key / 8] >> (key % 8)) & (bits[b / 8] >> (b % 8)) & 1;
+}
+#endif
+
+
+static void dc_reset (
+	FATFS* fs
+)
+{
+	UINT i;
+
+
+	for (i = 0; i < FF_DIR_CACHE; i++) fs->dc_dir[i] = 0xFFFFFFFF;
+	fs->dc_free = FF_DIR_CACHE;
+	fs->dc_pdir = 0xFFFFFFFF;
+#if FF_DIR_FILTER
+	fs->df_dir[0] = fs->df_dir[1] = 0xFFFFFFFF;
+	fs->df_next = 0;
+#endif
+}
+
+
+#if !FF_FS_READONLY && FF_FS_MINIMIZE == 0
+static void dc_drop (	/* Discard the name cache of a directory removed or created */
+	FATFS* fs,
+	DWORD dir			/* Start cluster of the directory */
+)
+{
+	UINT i;
+
+
+	for (i = 0; i < FF_DIR_CACHE; i++) {
+		if (fs->dc_dir[i] == dir) {
+			fs->dc_dir[i] = 0xFFFFFFFF;
+			fs->dc_free++;
+		}
+	}
+	if (fs->dc_pdir == dir) fs->dc_pdir = 0xFFFFFFFF;
+#if FF_DIR_FILTER
+	if (fs->df_dir[0] == dir) fs->df_dir[0] = 0xFFFFFFFF;
+	if (fs->df_dir[1] == dir) fs->df_dir[1] = 0xFFFFFFFF;
+#endif
+}
+#endif
+
+
+static void dc_put (	/* Register a hint */
+	FATFS* fs,
+	DWORD dir,			/* Directory */
+	DWORD key,			/* Name key */
+	DWORD blk,			/* Offset of the entry block */
+	UINT n,				/* Number of entries in the block */
+	int use				/* 0:met by a scan, only into a free hint, 1:found or registered, the most recent hint */
+)
+{
+	UINT set = dc_set(dir, key);
+	UINT i = dc_way(fs, set, dir, key);
+	DWORD ofs = blk | (DWORD)n << 24;
+
+
+	if (i == DC_WAYS) {		/* Not in the set yet */
+		for (i = 0; i < DC_WAYS && fs->dc_dir[set + i] != 0xFFFFFFFF; i++) ;
+		if (i < DC_WAYS) {
+			fs->dc_free--;
+		} else {
+			if (!use) return;	/* Set is full, keep the hints in use */
+			i = DC_WAYS - 1;	/* Evict the least recent hint */
+		}
+		if (!use) {
+			fs->dc_dir[set + i] = dir; fs->dc_key[set + i] = key; fs->dc_ofs[set + i] = ofs;
+			return;
+		}
+	} else if (!use) {		/* Met by a scan again, keep its place */
+		fs->dc_ofs[set + i] = ofs;
+		return;
+	}
+	dc_front(fs, set, i, dir, key, ofs);
+}
+
+
+#if !FF_FS_READONLY
+static void dc_add (	/* Add the entry just registered to the name cache */
+	DIR* dp,			/* Directory object pointing the SFN entry */
+	UINT nlfn			/* Number of LFN entries */
+)
+{
+	FATFS *fs = dp->obj.fs;
+	DWORD dir = dc_dirid(dp);
+	DWORD key = dc_sfnkey(dp->fn);
+#if FF_DIR_FILTER
+	BYTE *bits = dc_filter(fs, dir);
+
+	if (bits) dc_fadd(bits, key);
+#endif
+#if FF_USE_LFN
+	if (nlfn) {
+		key = dc_lfnkey(fs->lfnbuf);
+#if FF_DIR_FILTER
+		if (bits) dc_fadd(bits, key);
+#endif
+	}
+#endif
+	dc_put(fs, dir, key, dp->dptr - nlfn * SZDIRE, nlfn + 1, 1);
+	if (fs->dc_pdir == dir && dp->dptr >= fs->dc_pofs && dp->dptr - nlfn * SZDIRE < fs->dc_pofs) {
+		fs->dc_pofs = dp->dptr + SZDIRE;	/* Do not let a scan start to pick up in the middle of the block */
+	}
+}
+#endif
+
+
+static void dc_pick (	/* Pick up an entry met by a directory scan */
+	DIR* dp,			/* Directory object pointing the entry */
+	DCSCAN* sc			/* Scan status */
+)
+{
+	FATFS *fs = dp->obj.fs;
+	BYTE *dir = dp->dir;
+	BYTE c = dir[DIR_Name], a = dir[DIR_Attr] & AM_MASK;
+	DWORD key, blk = dp->dptr;
+	UINT n = 1, pick;
+#if FF_USE_LFN
+	DWORD h;
+	UINT i, s;
+	WCHAR wc;
+#endif
+
+
+	if (sc->dir == 0xFFFFFFFF) return;
+	if (!fs->dc_free) sc->pick = 0;		/* No free hint anymore */
+	pick = sc->pick && dp->dptr >= fs->dc_pofs;	/* Not picked up by a scan before? */
+	if (!pick && !sc->build) return;	/* Nothing to do */
+	if (c == DDEM || ((a & AM_VOL) && a != AM_LFN)) {	/* An entry without valid data */
+#if FF_USE_LFN
+		sc->blk = 0xFFFFFFFF;
+#endif
+		return;
+	}
+#if FF_USE_LFN
+	if (a == AM_LFN) {		/* An LFN entry */
+		if (c & LLEF) {		/* Start of an LFN block */
+			sc->blk = dp->dptr; sc->lkey = 0;
+			sc->sum = dir[LDIR_Chksum]; sc->ord = c & (BYTE)~LLEF;
+		}
+		if (sc->blk != 0xFFFFFFFF) {
+			sc->ord = ((c & (BYTE)~LLEF) == sc->ord && dir[LDIR_Chksum] == sc->sum) ? sc->ord - 1 : 0xFF;
+			i = ((c & 0x3F) - 1) * 13;
+			h = 0x811C9DC5 ^ (c & 0x3F);
+			for (s = 0; s < 13; s++, i++) {	/* Hash the characters up to the terminator */
+				wc = ld_word(dir + LfnOfs[s]);
+				if (wc == 0 || wc == 0xFFFF) break;
+				h = dc_lfnchr(h, wc);
+			}
+			if (c & LLEF) h = (h ^ 0xFFFF0000 ^ i) * 0x01000193;	/* Add the length */
+			sc->lkey += dc_mix(h);
+		}
+		return;
+	}
+	if (sc->blk != 0xFFFFFFFF && sc->ord == 0 && sc->sum == sum_sfn(dir)) {	/* An SFN entry with LFN */
+		key = sc->lkey;
+		n += (dp->dptr - sc->blk) / SZDIRE; blk = sc->blk;
+#if FF_DIR_FILTER
+		if (sc->build) {
+			dc_fadd(fs->df_bits[sc->build - 1], key);
+			dc_fadd(fs->df_bits[sc->build - 1], dc_sfnkey(dir));
+		}
+#endif
+	} else {				/* An SFN entry without LFN */
+		key = dc_sfnkey(dir);
+#if FF_DIR_FILTER
+		if (sc->build) dc_fadd(fs->df_bits[sc->build - 1], key);
+#endif
+	}
+	sc->blk = 0xFFFFFFFF;
+#else
+	key = dc_sfnkey(dir);
+#if FF_DIR_FILTER
+	if (sc->build) dc_fadd(fs->df_bits[sc->build - 1], key);
+#endif
+#endif
+	if (pick) dc_put(fs, sc->dir, key, blk, n, 0);
+}
+
+
+static FRESULT dc_verify (	/* FR_OK:the hinted block matched, FR_NO_FILE:stale hint, others:error */
+	DIR* dp,				/* Directory object with the file name */
+	DWORD hint				/* Offset of the entry block (bit 0-23) and number of entries (bit 24-31) */
+)
+{
+	FRESULT res;
+	FATFS *fs = dp->obj.fs;
+	UINT n = hint >> 24;
+	BYTE c, a;
+#if FF_USE_LFN
+	BYTE ord = 0xFF, sum = 0;
+#endif
+
+
+	res = dir_sdi(dp, hint & 0xFFFFFF);
+	if (res == FR_INT_ERR) res = FR_NO_FILE;	/* Out of the table */
+	while (res == FR_OK) {
+		res = move_window(fs, dp->sect);
+		if (res != FR_OK) break;
+		c = dp->dir[DIR_Name];
+		dp->obj.attr = a = dp->dir[DIR_Attr] & AM_MASK;
+		if (c == 0 || c == DDEM) return FR_NO_FILE;
+#if FF_USE_LFN
+		if (--n) {			/* An LFN entry of the block */
+			if (a != AM_LFN || (dp->fn[NSFLAG] & NS_NOLFN)) return FR_NO_FILE;
+			if (ord == 0xFF) {
+				if (!(c & LLEF)) return FR_NO_FILE;
+				sum = dp->dir[LDIR_Chksum]; ord = c & (BYTE)~LLEF;
+			}
+			if ((c & (BYTE)~LLEF) != ord || sum != dp->dir[LDIR_Chksum] || !cmp_lfn(fs->lfnbuf, dp->dir)) return FR_NO_FILE;
+			ord--;
+		} else {			/* The SFN entry */
+			if (a & AM_VOL) return FR_NO_FILE;
+			if (ord == 0 && sum == sum_sfn(dp->dir)) {	/* LFN matched? */
+				dp->blk_ofs = hint & 0xFFFFFF;
+				return FR_OK;
+			}
+			if (ord == 0xFF && !(dp->fn[NSFLAG] & NS_LOSS) && !memcmp(dp->dir, dp->fn, 11)) {	/* SFN matched? */
+				dp->blk_ofs = 0xFFFFFFFF;
+				return FR_OK;
+			}
+			return FR_NO_FILE;
+		}
+#else
+		if (--n || (a & AM_VOL) || memcmp(dp->dir, dp->fn, 11)) return FR_NO_FILE;
+		return FR_OK;
+#endif
+		res = dir_next(dp, 0);	/* Next entry */
+	}
+	return res;
+}
+
+
+static int dc_find (	/* 1:resolved by the name cache, 0:the table needs to be scanned */
+	DIR* dp,			/* Directory object with the file name */
+	DCSCAN* sc,			/* Scan status to be initialized */
+	FRESULT* res		/* Result when resolved */
+)
+{
+	FATFS *fs = dp->obj.fs;
+	DWORD key[2];
+	UINT i, set, way, nk = 0;
+#if FF_DIR_FILTER
+	BYTE *bits;
+#endif
+
+
+	sc->build = 0; sc->pick = 1;
+#if FF_USE_LFN
+	sc->blk = 0xFFFFFFFF; sc->lkey = 0; sc->ord = sc->sum = 0;
+#endif
+	sc->dir = dc_dirid(dp);
+	if (dp->fn[NSFLAG] & NS_DOT) {	/* Dot names are not cached */
+		sc->dir = 0xFFFFFFFF;
+		return 0;
+	}
+#if FF_USE_LFN
+	if (!(dp->fn[NSFLAG] & NS_NOLFN)) key[nk++] = dc_lfnkey(fs->lfnbuf);
+	if (!(dp->fn[NSFLAG] & NS_LOSS)) key[nk++] = dc_sfnkey(dp->fn);
+#else
+	key[nk++] = dc_sfnkey(dp->fn);
+#endif
+	for (i = 0; i < nk; i++) {	/* Check the hints */
+		set = dc_set(sc->dir, key[i]);
+		way = dc_way(fs, set, sc->dir, key[i]);
+		if (way < DC_WAYS) {
+			*res = dc_verify(dp, fs->dc_ofs[set + way]);
+			if (*res == FR_OK) dc_front(fs, set, way, sc->dir, key[i], fs->dc_ofs[set + way]);	/* Make it the most recent hint */
+			if (*res != FR_NO_FILE) return 1;	/* Found at the hint or disk error */
+			fs->dc_dir[set + way] = 0xFFFFFFFF;	/* Discard the stale hint */
+			fs->dc_free++;
+		}
+	}
+#if FF_DIR_FILTER
+	bits = dc_filter(fs, sc->dir);
+	if (bits) {
+		for (i = 0; i < nk && !dc_ftest(bits, key[i]); i++) ;
+		if (i == nk) {			/* Not in the directory */
+			*res = FR_NO_FILE;
+			return 1;
+		}
+		sc->pick = 0;			/* Its entries were picked up when the filter was built */
+	} else {					/* Build the filter of the directory in the scan */
+		i = fs->df_next;
+		fs->df_dir[i] = 0xFFFFFFFF;
+		memset(fs->df_bits[i], 0, FF_DIR_FILTER);
+		sc->build = (BYTE)(i + 1);
+	}
+#endif
+	if (sc->pick && fs->dc_pdir != sc->dir) {	/* Pick up from the start of another directory */
+		fs->dc_pdir = sc->dir; fs->dc_pofs = 0;
+	}
+	*res = dir_sdi(dp, 0);		/* Rewind directory object */
+	return *res != FR_OK;
+}
+
+
+static void dc_done (	/* Complete the scan */
+	DIR* dp,			/* Directory object */
+	DCSCAN* sc,			/* Scan status */
+	FRESULT res			/* Result of the scan */
+)
+{
+	FATFS *fs = dp->obj.fs;
+
+
+	if (sc->dir == 0xFFFFFFFF) return;
+	if (sc->pick) {			/* Move the point picked up to */
+		if (res == FR_NO_FILE) fs->dc_pofs = 0xFFFFFFFF;
+		if (res == FR_OK && dp->dptr >= fs->dc_pofs) fs->dc_pofs = dp->dptr + SZDIRE;
+	}
+	if (res == FR_OK) {		/* Make the name found the most recent hint */
+#if FF_USE_LFN
+		if (dp->blk_ofs != 0xFFFFFFFF) {	/* An entry with LFN, hinted by its LFN only */
+			if (!(dp->fn[NSFLAG] & NS_NOLFN) && ((dp->fn[NSFLAG] & NS_LOSS) || memcmp(dp->dir, dp->fn, 11))) {	/* Found by the LFN? */
+				dc_put(fs, sc->dir, dc_lfnkey(fs->lfnbuf), dp->blk_ofs, (dp->dptr - dp->blk_ofs) / SZDIRE + 1, 1);
+			}
+			return;
+		}
+#endif
+		dc_put(fs, sc->dir, dc_sfnkey(dp->fn), dp->dptr, 1, 1);
+	}
+#if FF_DIR_FILTER
+	if (sc->build && res == FR_NO_FILE) {	/* All entries in the table have been added? */
+		fs->df_dir[sc->build - 1] = sc->dir;
+		fs->df_next = (BYTE)(sc->build % 2);
+	}
+#endif
+}
+
+#endif	/* FF_DIR_CACHE */
+
+
 /*-----------------------------------------------------------------------*/
 /* Directory handling - Find an object in the directory                  */
 /*-----------------------------------------------------------------------*/
@@ -2393,6 +3083,9 @@ static FRESULT dir_find (	/* FR_OK(0):succeeded, !=0:error */
 #if FF_USE_LFN
 	BYTE a, ord, sum;
 #endif
+#if FF_DIR_CACHE
+	DCSCAN sc;
+#endif
 
 	res = dir_sdi(dp, 0);			/* Rewind directory object */
 	if (res != FR_OK) return res;
@@ -2417,6 +3110,9 @@ static FRESULT dir_find (	/* FR_OK(0):succeeded, !=0:error */
 	}
 #endif
 	/* On the FAT/FAT32 volume */
+#if FF_DIR_CACHE
+	if (dc_find(dp, &sc, &res)) return res;	/* Resolved by the name cache? */
+#endif
 #if FF_USE_LFN
 	ord = sum = 0xFF; dp->blk_ofs = 0xFFFFFFFF;	/* Reset LFN sequence */
 #endif
@@ -2425,6 +3121,9 @@ static FRESULT dir_find (	/* FR_OK(0):succeeded, !=0:error */
 		if (res != FR_OK) break;
 		c = dp->dir[DIR_Name];
 		if (c == 0) { res = FR_NO_FILE; break; }	/* Reached to end of table */
+#if FF_DIR_CACHE
+		dc_pick(dp, &sc);		/* Add the entry to the name cache */
+#endif
 #if FF_USE_LFN		/* LFN configuration */
 		dp->obj.attr = a = dp->dir[DIR_Attr] & AM_MASK;
 		if (c == DDEM || ((a & AM_VOL) && a != AM_LFN)) {	/* An entry without valid data */
@@ -2452,6 +3151,9 @@ static FRESULT dir_find (	/* FR_OK(0):succeeded, !=0:error */
 #endif
 		res = dir_next(dp, 0);	/* Next entry */
 	} while (res == FR_OK);
+#if FF_DIR_CACHE
+	dc_done(dp, &sc, res);
+#endif
 
 	return res;
 }
@@ -2555,6 +3257,13 @@ static FRESULT dir_register (	/* FR_OK:succeeded, FR_DENIED:no free entry or too
 			dp->dir[DIR_NTres] = dp->fn[NSFLAG] & (NS_BODY | NS_EXT);	/* Put NT flag */
 #endif
 			fs->wflag = 1;
+#if FF_DIR_CACHE
+#if FF_USE_LFN
+			dc_add(dp, (sn[NSFLAG] & NS_LFN) ? (len + 12) / 13 : 0);	/* Add the name to the name cache */
+#else
+			dc_add(dp, 0);
+#endif
+#endif
 		}
 	}
 
@@ -3299,7 +4008,11 @@ static UINT check_fs (	/* 0:FAT/FAT32 VBR, 1:exFAT VBR, 2:Not FAT and valid BS,
 	BYTE b;
 
 
+#if FF_WIN_CACHE
+	reset_cache(fs);								/* Invalidate window and sector cache */
+#else
 	fs->wflag = 0; fs->winsect = (LBA_t)0 - 1;		/* Invaidate window */
+#endif
 	if (move_window(fs, sect) != FR_OK) return 4;	/* Load the boot sector */
 	sign = ld_word(fs->win + BS_55AA);
 #if FF_FS_EXFAT
@@ -3590,6 +4303,9 @@ static FRESULT mount_volume (	/* FR_OK(0): successful, !=0: an error occurred */
 
 	fs->fs_type = (BYTE)fmt;/* FAT sub-type (the filesystem object gets valid) */
 	fs->id = ++Fsid;		/* Volume mount ID */
+#if FF_DIR_CACHE
+	dc_reset(fs);			/* Discard the name cache */
+#endif
 #if FF_USE_LFN == 1
 	fs->lfnbuf = LfnBuf;	/* Static LFN working buffer */
 #if FF_FS_EXFAT
@@ -3962,7 +4678,11 @@ FRESULT f_read (
 			cc = btr / SS(fs);					/* When remaining bytes >= sector size, */
 			if (cc > 0) {						/* Read maximum contiguous sectors directly */
 				if (csect + cc > fs->csize) {	/* Clip at cluster boundary */
+#if FF_USE_CLUSTER_RUN
+					cc = run_clust(fp, fs->csize - csect, cc, 0);	/* or at the end of contiguous clusters */
+#else
 					cc = fs->csize - csect;
+#endif
 				}
 				if (disk_read(fs->pdrv, rbuff, sect, cc) != RES_OK) ABORT(fs, FR_DISK_ERR);
 #if !FF_FS_READONLY && FF_FS_MINIMIZE <= 2		/* Replace one of the read sectors with cached data if it contains a dirty sector */
@@ -4077,7 +4797,11 @@ FRESULT f_write (
 			cc = btw / SS(fs);				/* When remaining bytes >= sector size, */
 			if (cc > 0) {					/* Write maximum contiguous sectors directly */
 				if (csect + cc > fs->csize) {	/* Clip at cluster boundary */
+#if FF_USE_CLUSTER_RUN
+					cc = run_clust(fp, fs->csize - csect, cc, 1);	/* or at the end of contiguous clusters */
+#else
 					cc = fs->csize - csect;
+#endif
 				}
 				if (disk_write(fs->pdrv, wbuff, sect, cc) != RES_OK) ABORT(fs, FR_DISK_ERR);
 #if FF_FS_MINIMIZE <= 2
@@ -5033,6 +5757,9 @@ FRESULT f_unlink (
 			if (res == FR_OK) {
 				res = dir_remove(&dj);			/* Remove the directory entry */
 				if (res == FR_OK && dclst != 0) {	/* Remove the cluster chain if exist */
+#if FF_DIR_CACHE
+					dc_drop(fs, dclst);			/* Discard the name cache of the directory */
+#endif
 #if FF_FS_EXFAT
 					res = remove_chain(&obj, dclst, 0);
 #else
@@ -5086,6 +5813,9 @@ FRESULT f_mkdir (
 			tm = GET_FATTIME();
 			if (res == FR_OK) {
 				res = dir_clear(fs, dcl);		/* Clean up the new table */
+#if FF_DIR_CACHE
+				dc_drop(fs, dcl);				/* Discard the name cache left by a directory removed */
+#endif
 				if (res == FR_OK) {
 					if (!FF_FS_EXFAT || fs->fs_type != FS_EXFAT) {	/* Create dot entries (FAT only) */
 						memset(fs->win + DIR_Name, ' ', 11);	/* Create "." entry */
@@ -5729,6 +6459,279 @@ FRESULT f_forward (
 
 
 
+#if FF_DISK_ASYNC
+/*-----------------------------------------------------------------------*/
+/* Stream File Data with Overlapped Disk Transfers (with sub-functions)  */
+/*-----------------------------------------------------------------------*/
+/* The file data is moved between the disk and the streaming function in */
+/* buffers of bsize bytes and up to nbuf transfers are kept in flight by */
+/* disk_submit, so that the disk works while the streaming function      */
+/* processes the data of another buffer.                                 */
+
+typedef struct {
+	DREQ	req;		/* Disk request */
+	FSIZE_t	ofs;		/* File offset of the data */
+	UINT	len;		/* Number of data bytes */
+	DWORD	sclst;		/* Cluster of the first sector */
+} STREQ;
+
+
+static DWORD next_stream (	/* Returns cluster of ofs, 0:Disk full, 1:Internal error, 0xFFFFFFFF:Disk error, >=n_fatent:End of chain */
+	FIL* fp,		/* Pointer to the file object */
+	DWORD clst,		/* Cluster holding the byte before ofs */
+	FSIZE_t ofs,	/* File offset on the cluster boundary */
+	int stretch		/* 0:Follow the cluster chain, 1:Stretch it if needed */
+)
+{
+	if (ofs == 0) {		/* On the top of the file? */
+		clst = fp->obj.sclust;	/* Follow from the origin */
+#if !FF_FS_READONLY
+		if (clst == 0 && stretch) {		/* If no cluster is allocated, */
+			clst = create_chain(&fp->obj, 0);	/* create a new cluster chain */
+			if (clst >= 2 && clst < fp->obj.fs->n_fatent) fp->obj.sclust = clst;
+		}
+#endif
+		return clst;
+	}
+#if FF_USE_FASTSEEK
+	if (fp->cltbl) return clmt_clust(fp, ofs);	/* Get cluster# from the CLMT */
+#endif
+#if !FF_FS_READONLY
+	if (stretch) return create_chain(&fp->obj, clst);	/* Follow or stretch cluster chain on the FAT */
+#endif
+	return get_fat(&fp->obj, clst);		/* Follow cluster chain on the FAT */
+}
+
+
+static DWORD map_stream (	/* Returns cluster of the last sector mapped, 0:Disk full, 1:Internal error, 0xFFFFFFFF:Disk error, >=n_fatent:End of chain */
+	FIL* fp,		/* Pointer to the file object */
+	DWORD clst,		/* Cluster holding the byte before ofs */
+	FSIZE_t ofs,	/* File offset on the sector boundary */
+	UINT* nsect,	/* Number of sectors to map, returns number of contiguous sectors mapped */
+	LBA_t* sect,	/* Pointer to return the first sector */
+	int stretch		/* 0:Follow the cluster chain, 1:Stretch it if needed */
+)
+{
+	FATFS *fs = fp->obj.fs;
+	DWORD ncl;
+	UINT csect, cc;
+
+
+	csect = (UINT)(ofs / SS(fs) & (fs->csize - 1));	/* Sector offset in the cluster */
+	if (csect == 0) {						/* On the cluster boundary? */
+		clst = next_stream(fp, clst, ofs, stretch);
+		if (clst < 2 || clst >= fs->n_fatent) return clst;	/* Disk full, end of chain or error */
+	}
+	*sect = clst2sect(fs, clst);
+	if (*sect == 0) return 1;
+	*sect += csect;
+	for (cc = fs->csize - csect; cc < *nsect; cc += fs->csize) {	/* Extend the run over contiguous clusters */
+		ncl = next_stream(fp, clst, ofs + (FSIZE_t)cc * SS(fs), stretch);
+		if (ncl != clst + 1) break;	/* End of the run (errors are left to the next mapping) */
+		clst = ncl;
+	}
+	if (cc < *nsect) *nsect = cc;
+	return clst;
+}
+
+
+FRESULT f_readstream (
+	FIL* fp, 						/* Pointer to the file object */
+	BYTE* work,						/* Work area of nbuf * bsize bytes */
+	UINT bsize,						/* Size of a buffer, multiple of the sector size */
+	UINT nbuf,						/* Number of buffers (2..FF_DISK_ASYNC) */
+	UINT (*func)(const BYTE*,UINT),	/* Pointer to the streaming function (returns less than given to stop) */
+	UINT btr,						/* Number of bytes to read */
+	UINT* br						/* Pointer to number of bytes read */
+)
+{
+	FRESULT res;
+	FATFS *fs;
+	STREQ rq[FF_DISK_ASYNC], *rp;
+	FSIZE_t remain, ofs, end;
+	DWORD clst, cl;
+	LBA_t sect;
+	UINT head, tail, cc, rcnt;
+
+
+	*br = 0;	/* Clear read byte counter */
+	res = validate(&fp->obj, &fs);				/* Check validity of the file object */
+	if (res != FR_OK || (res = (FRESULT)fp->err) != FR_OK) LEAVE_FF(fs, res);	/* Check validity */
+	if (!(fp->flag & FA_READ)) LEAVE_FF(fs, FR_DENIED); /* Check access mode */
+	if (nbuf < 2 || nbuf > FF_DISK_ASYNC || bsize == 0 || bsize % SS(fs) != 0 || fp->fptr % SS(fs) != 0) {
+		LEAVE_FF(fs, FR_INVALID_PARAMETER);	/* Check buffers and file pointer alignment */
+	}
+	remain = fp->obj.objsize - fp->fptr;
+	if (btr > remain) btr = (UINT)remain;		/* Truncate btr by remaining bytes */
+#if !FF_FS_READONLY
+	if (fp->flag & FA_DIRTY) {		/* Write-back dirty sector cache */
+		if (disk_write(fs->pdrv, fp->buf, fp->sect, 1) != RES_OK) ABORT(fs, FR_DISK_ERR);
+		fp->flag &= (BYTE)~FA_DIRTY;
+	}
+#endif
+
+	ofs = fp->fptr; end = ofs + btr; clst = fp->clust;
+	for (head = tail = 0; ; ) {
+		while (res == FR_OK && ofs < end && head - tail < nbuf) {	/* Keep nbuf reads in flight */
+			rp = &rq[head % nbuf];
+			cc = (UINT)((end - ofs + SS(fs) - 1) / SS(fs));	/* Number of sectors left */
+			if (cc > bsize / SS(fs)) cc = bsize / SS(fs);	/* Clip it by the buffer size */
+			cl = map_stream(fp, clst, ofs, &cc, &sect, 0);
+			if (cl < 2 || cl >= fs->n_fatent) {
+				res = (cl == 0xFFFFFFFF) ? FR_DISK_ERR : FR_INT_ERR;
+				break;
+			}
+			clst = cl;
+			rp->ofs = ofs;
+			rp->len = (end - ofs < (FSIZE_t)cc * SS(fs)) ? (UINT)(end - ofs) : cc * SS(fs);
+			rp->sclst = clst - ((UINT)(ofs / SS(fs) & (fs->csize - 1)) + cc - 1) / fs->csize;
+			rp->req.pdrv = fs->pdrv;
+			rp->req.write = 0;
+			rp->req.buff = work + (head % nbuf) * bsize;
+			rp->req.sector = sect;
+			rp->req.count = cc;
+			rp->req.complete = 0;
+			if (disk_submit(&rp->req) != RES_OK) {
+				res = FR_DISK_ERR;
+				break;
+			}
+			ofs += rp->len;
+			head++;
+		}
+		if (head == tail) break;	/* All reads completed? */
+		rp = &rq[tail++ % nbuf];
+		if (disk_wait(&rp->req) != RES_OK) res = FR_DISK_ERR;
+		if (res != FR_OK || rp->ofs != fp->fptr) continue;	/* Drain the reads in flight after an error or a stop */
+		rcnt = (*func)(rp->req.buff, rp->len);	/* Forward the file data */
+		if (rcnt > rp->len) rcnt = rp->len;
+		if (rcnt > 0) {
+			fp->fptr += rcnt; *br += rcnt;
+			fp->clust = rp->sclst + ((UINT)(rp->ofs / SS(fs) & (fs->csize - 1)) * SS(fs) + rcnt - 1) / SS(fs) / fs->csize;
+			if (fp->fptr % SS(fs) != 0) {	/* Stopped in the middle of a sector? */
+				memcpy(fp->buf, rp->req.buff + rcnt / SS(fs) * SS(fs), SS(fs));	/* Keep it in the sector cache */
+				fp->sect = rp->req.sector + rcnt / SS(fs);
+			}
+		}
+		if (rcnt < rp->len) end = ofs;	/* Stream goes busy: stop reading ahead */
+	}
+	if (res != FR_OK) ABORT(fs, res);
+
+	LEAVE_FF(fs, FR_OK);
+}
+
+
+#if !FF_FS_READONLY
+FRESULT f_writestream (
+	FIL* fp, 					/* Pointer to the file object */
+	BYTE* work,					/* Work area of nbuf * bsize bytes */
+	UINT bsize,					/* Size of a buffer, multiple of the sector size */
+	UINT nbuf,					/* Number of buffers (2..FF_DISK_ASYNC) */
+	UINT (*func)(BYTE*,UINT),	/* Pointer to the streaming function (returns less than asked at end of stream) */
+	UINT btw,					/* Number of bytes to write */
+	UINT* bw					/* Pointer to number of bytes written */
+)
+{
+	FRESULT res;
+	FATFS *fs;
+	STREQ rq[FF_DISK_ASYNC], *rp;
+	FSIZE_t ofs, end;
+	DWORD clst, cl;
+	LBA_t sect;
+	UINT head, tail, cc, n, wcnt;
+	BYTE *wbuff, *pbuff = 0;
+
+
+	*bw = 0;	/* Clear write byte counter */
+	res = validate(&fp->obj, &fs);			/* Check validity of the file object */
+	if (res != FR_OK || (res = (FRESULT)fp->err) != FR_OK) LEAVE_FF(fs, res);	/* Check validity */
+	if (!(fp->flag & FA_WRITE)) LEAVE_FF(fs, FR_DENIED);	/* Check access mode */
+	if (nbuf < 2 || nbuf > FF_DISK_ASYNC || bsize == 0 || bsize % SS(fs) != 0 || fp->fptr % SS(fs) != 0) {
+		LEAVE_FF(fs, FR_INVALID_PARAMETER);	/* Check buffers and file pointer alignment */
+	}
+
+	/* Check fptr wrap-around (file size cannot reach 4 GiB at FAT volume) */
+	if ((!FF_FS_EXFAT || fs->fs_type != FS_EXFAT) && (DWORD)(fp->fptr + btw) < (DWORD)fp->fptr) {
+		btw = (UINT)(0xFFFFFFFF - (DWORD)fp->fptr);
+	}
+	if (fp->flag & FA_DIRTY) {		/* Write-back sector cache */
+		if (disk_write(fs->pdrv, fp->buf, fp->sect, 1) != RES_OK) ABORT(fs, FR_DISK_ERR);
+		fp->flag &= (BYTE)~FA_DIRTY;
+	}
+	fp->sect = 0;	/* Invalidate sector cache, it can get overwritten by the direct writes */
+
+	ofs = fp->fptr; end = ofs + btw; clst = fp->clust;
+	for (head = tail = 0; ; ) {
+		while (res == FR_OK && ofs < end && !pbuff && head - tail < nbuf) {	/* Keep nbuf writes in flight */
+			rp = &rq[head % nbuf];
+			wbuff = work + (head % nbuf) * bsize;
+			n = (end - ofs < (FSIZE_t)bsize) ? (UINT)(end - ofs) : bsize;
+			wcnt = (*func)(wbuff, n);		/* Get the data from the stream */
+			if (wcnt > n) wcnt = n;
+			if (wcnt < n) end = ofs + wcnt;	/* End of stream */
+			if (wcnt % SS(fs) != 0) pbuff = wbuff + wcnt / SS(fs) * SS(fs);	/* Last partial sector goes to the sector cache */
+			for (n = wcnt / SS(fs); n > 0; n -= cc, wbuff += cc * SS(fs), ofs += (FSIZE_t)cc * SS(fs)) {
+				cc = n;
+				cl = map_stream(fp, clst, ofs, &cc, &sect, 1);
+				if (cl < 2 || cl >= fs->n_fatent) {
+					if (cl != 0) res = (cl == 0xFFFFFFFF) ? FR_DISK_ERR : FR_INT_ERR;
+					end = ofs; pbuff = 0;	/* Could not allocate a new cluster (disk full) */
+					break;
+				}
+				clst = cl;
+				if (rp) {		/* Write the first run of the buffer in background */
+					rp->req.pdrv = fs->pdrv;
+					rp->req.write = 1;
+					rp->req.buff = wbuff;
+					rp->req.sector = sect;
+					rp->req.count = cc;
+					rp->req.complete = 0;
+					if (disk_submit(&rp->req) != RES_OK) {
+						res = FR_DISK_ERR;
+						break;
+					}
+					head++;
+					rp = 0;
+				} else {		/* and the rest of a fragmented one at once */
+					if (disk_write(fs->pdrv, wbuff, sect, cc) != RES_OK) {
+						res = FR_DISK_ERR;
+						break;
+					}
+				}
+			}
+		}
+		if (head == tail) break;	/* All writes completed? */
+		if (disk_wait(&rq[tail++ % nbuf].req) != RES_OK) res = FR_DISK_ERR;
+	}
+	if (res == FR_OK && pbuff) {	/* Put the last partial sector into the sector cache */
+		cc = 1;
+		cl = map_stream(fp, clst, ofs, &cc, &sect, 1);
+		if (cl < 2 || cl >= fs->n_fatent) {
+			if (cl != 0) res = (cl == 0xFFFFFFFF) ? FR_DISK_ERR : FR_INT_ERR;
+		} else if (ofs < fp->obj.objsize && disk_read(fs->pdrv, fp->buf, sect, 1) != RES_OK) {
+			res = FR_DISK_ERR;
+		} else {
+			clst = cl;
+			memcpy(fp->buf, pbuff, (UINT)(end - ofs));	/* Fit data to the sector */
+			fp->sect = sect;
+			fp->flag |= FA_DIRTY;
+			ofs = end;
+		}
+	}
+	if (res != FR_OK) ABORT(fs, res);
+
+	*bw = (UINT)(ofs - fp->fptr);
+	fp->fptr = ofs;
+	fp->clust = clst;
+	if (fp->fptr > fp->obj.objsize) fp->obj.objsize = fp->fptr;
+	fp->flag |= FA_MODIFIED;				/* Set file change flag */
+
+	LEAVE_FF(fs, FR_OK);
+}
+#endif /* !FF_FS_READONLY */
+#endif /* FF_DISK_ASYNC */
+
+
+
 #if !FF_FS_READONLY && FF_USE_MKFS
 /*-----------------------------------------------------------------------*/
 /* Create FAT/exFAT volume (with sub-functions)                          */
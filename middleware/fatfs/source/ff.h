@@ -171,6 +171,26 @@ typedef struct {
 #endif
 	LBA_t	winsect;		/* Current sector appearing in the win[] */
 	BYTE	win[FF_MAX_SS];	/* Disk access window for Directory, FAT (and file data at tiny cfg) */
+#if FF_WIN_CACHE
+	BYTE	wc_dirty[FF_WIN_CACHE];	/* Dirty flag of each cache slot */
+	LBA_t	wc_sect[FF_WIN_CACHE];	/* Sector held in each cache slot */
+	DWORD	wc_used[FF_WIN_CACHE];	/* Last access stamp of each cache slot (0:unused) */
+	DWORD	wc_tick;		/* Access stamp counter */
+	BYTE	wc_buf[FF_WIN_CACHE][FF_MAX_SS];	/* Sectors swapped out of the win[] */
+#endif
+#if FF_DIR_CACHE
+	DWORD	dc_dir[FF_DIR_CACHE];	/* Directory of each name hint (0xFFFFFFFF:unused) */
+	DWORD	dc_key[FF_DIR_CACHE];	/* Name key of each name hint */
+	DWORD	dc_ofs[FF_DIR_CACHE];	/* Entry block of each name hint (offset and number of entries) */
+	UINT	dc_free;		/* Number of unused name hints */
+	DWORD	dc_pdir;		/* Directory scanned last (0xFFFFFFFF:none) */
+	DWORD	dc_pofs;		/* Offset in dc_pdir up to which the entries have been picked up by scans */
+#if FF_DIR_FILTER
+	DWORD	df_dir[2];		/* Directory of each name filter (0xFFFFFFFF:unused) */
+	BYTE	df_next;		/* Name filter to be replaced next */
+	BYTE	df_bits[2][FF_DIR_FILTER];	/* Name filters */
+#endif
+#endif
 } FATFS;
 
 
@@ -327,6 +347,8 @@ FRESULT f_getlabel (const TCHAR* path, TCHAR* label, DWORD* vsn);	/* Get volume
 FRESULT f_setlabel (const TCHAR* label);							/* Set volume label */
 FRESULT f_forward (FIL* fp, UINT(*func)(const BYTE*,UINT), UINT btf, UINT* bf);	/* Forward data to the stream */
 FRESULT f_expand (FIL* fp, FSIZE_t fsz, BYTE opt);					/* Allocate a contiguous block to the file */
+FRESULT f_readstream (FIL* fp, BYTE* work, UINT bsize, UINT nbuf, UINT(*func)(const BYTE*,UINT), UINT btr, UINT* br);	/* Read data to the stream with overlapped disk transfers */
+FRESULT f_writestream (FIL* fp, BYTE* work, UINT bsize, UINT nbuf, UINT(*func)(BYTE*,UINT), UINT btw, UINT* bw);	/* Write data from the stream with overlapped disk transfers */
 FRESULT f_mount (FATFS* fs, const TCHAR* path, BYTE opt);			/* Mount/Unmount a logical drive */
 FRESULT f_mkfs (const TCHAR* path, const MKFS_PARM* opt, void* work, UINT len);	/* Create a FAT volume */
 FRESULT f_fdisk (BYTE pdrv, const LBA_t ptbl[], void* work);		/* Divide a physical drive into some partitions */
@@ -46,8 +46,6 @@ extern nand_config_t nandConfig;
  ******************************************************************************/
 DRESULT nand_disk_write(BYTE pdrv, const BYTE* buff, LBA_t sector, UINT count)
 {
-    assert(count == 1U);
-
     dhara_error_t err;
 
     if (pdrv != NANDDISK)
@@ -55,7 +53,8 @@ DRESULT nand_disk_write(BYTE pdrv, const BYTE* buff, LBA_t sector, UINT count)
         return RES_PARERR;
     }
 
-    if (dhara_map_write(&map, sector, buff, &err) < 0)
+    /* Consecutive sectors are written as one batch */
+    if (dhara_map_write_multi(&map, sector, buff, count, &err) < 0)
     {
         return RES_ERROR;
     }
@@ -65,8 +64,6 @@ DRESULT nand_disk_write(BYTE pdrv, const BYTE* buff, LBA_t sector, UINT count)
 
 DRESULT nand_disk_read(BYTE pdrv, BYTE* buff, LBA_t sector, UINT count)
 {
-    assert(count == 1U);
-
     dhara_error_t err;
 
     if (pdrv != NANDDISK)
@@ -74,9 +71,14 @@ DRESULT nand_disk_read(BYTE pdrv, BYTE* buff, LBA_t sector, UINT count)
         return RES_PARERR;
     }
 
-    if (dhara_map_read(&map, sector, buff, &err) < 0)
+    for (; count > 0U; count--)
     {
-        return RES_ERROR;
+        if (dhara_map_read(&map, sector++, buff, &err) < 0)
+        {
+            return RES_ERROR;
+        }
+
+        buff += 1U << EXAMPLE_DHARA_NAND_LOG2_PAGE_SIZE;
     }
 
     return RES_OK;
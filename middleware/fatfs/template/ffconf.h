@@ -131,6 +131,30 @@
 #define FF_FS_TINY 0
 #endif
 
+#if !defined(FF_WIN_CACHE)
+#define FF_WIN_CACHE 0
+#endif
+
+#if !defined(FF_USE_CLUSTER_RUN)
+#define FF_USE_CLUSTER_RUN 0
+#endif
+
+#if !defined(FF_DISK_ASYNC)
+#define FF_DISK_ASYNC 0
+#endif
+
+#if !defined(FF_DISK_ASYNC_NOTIFY_INDEX)
+#define FF_DISK_ASYNC_NOTIFY_INDEX 1
+#endif
+
+#if !defined(FF_DIR_CACHE)
+#define FF_DIR_CACHE 0
+#endif
+
+#if !defined(FF_DIR_FILTER)
+#define FF_DIR_FILTER 0
+#endif
+
 #if !defined(FF_FS_EXFAT)
 #define FF_FS_EXFAT 0
 #endif
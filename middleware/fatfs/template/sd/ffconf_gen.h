@@ -265,6 +265,59 @@
 /  buffer in the filesystem object (FATFS) is used for the file data transfer. */
 
 
+#define FF_WIN_CACHE	0
+/* This option sets the number of sectors cached for FAT and directory access.
+/  (0:Single sector window or 1-255:LRU sector cache)
+/  At 0, the filesystem object (FATFS) holds one sector window and every FAT or
+/  directory walk that crosses a sector reloads it. Otherwise the sectors moved out
+/  of the window are kept in an LRU cache of FF_WIN_CACHE sectors, which grows the
+/  filesystem object by FF_WIN_CACHE * FF_MAX_SS bytes. Dirty sectors are written
+/  back when they are replaced and at the synchronization of the filesystem (f_sync,
+/  f_close, ...). It cannot be used with FF_FS_TINY. */
+
+
+#define FF_USE_CLUSTER_RUN	0
+/* This option switches transfer of contiguous cluster runs. (0:Disable or 1:Enable)
+/  At 0, f_read and f_write split the multi-sector transfers at every cluster boundary.
+/  At 1, a run of contiguous clusters is transferred with a single disk_read or
+/  disk_write call. */
+
+
+#define FF_DISK_ASYNC	0
+/* This option switches the asynchronous disk access. (0:Disable or 2-8:Enable)
+/  At 2-8, the disk layer provides disk_submit and disk_wait to queue transfers in
+/  background and f_readstream/f_writestream are available. They stream file data
+/  through up to FF_DISK_ASYNC buffers in flight, so that the disk works while the
+/  application processes the data. With FF_FS_REENTRANT, diskio.c runs the queued
+/  transfers in a worker task, otherwise disk_submit completes them at once.
+/  It cannot be used with FF_FS_TINY. */
+
+
+#define FF_DISK_ASYNC_NOTIFY_INDEX	1
+/* This option sets the task notification index by which the worker task signals
+/  a completed transfer to the task waiting in disk_wait (FF_DISK_ASYNC with
+/  FF_FS_REENTRANT). It must be 1 or more and below the FreeRTOS
+/  configTASK_NOTIFICATION_ARRAY_ENTRIES, and the application must not use this
+/  index on tasks which call f_readstream/f_writestream. */
+
+
+#define FF_DIR_CACHE	0
+#define FF_DIR_FILTER	0
+/* FF_DIR_CACHE sets the number of name hints per volume for the directory lookup
+/  on FAT/FAT32 volumes. (0:Disable or 2^n, at least 8) A hint holds where a name
+/  was found in a directory, keyed by a hash of the directory and the up-cased
+/  name, and takes 12 bytes in the filesystem object. A lookup tries the hint
+/  before it scans the table, and a hint that does not match the entries anymore
+/  is discarded. The hints are kept in 8-way sets, the least recently used one is
+/  replaced by a name found or created, and a scan only fills free hints.
+/  FF_DIR_FILTER sets the size in bytes of a name filter (0:Disable or 2^n). Two
+/  filters per volume tell that a name is not in one of the last two directories
+/  that were searched without a match, so that f_open() with FA_CREATE_NEW and
+/  f_mkdir() do not scan the table again. It needs FF_DIR_CACHE. A long file name
+/  takes two keys in a filter and an 8.3 name one. With 8 bits per key, about 1 in
+/  20 misses is still scanned. */
+
+
 #define FF_FS_EXFAT		0
 /* This option switches support for exFAT filesystem. (0:Disable or 1:Enable)
 /  To enable exFAT, also LFN needs to be enabled. (FF_USE_LFN >= 1)
@@ -41,6 +41,155 @@ static inline void lfs_cache_zero(lfs_t *lfs, lfs_cache_t *pcache) {
     pcache->block = LFS_BLOCK_NULL;
 }
 
+#ifdef LFS_BCACHE
+/// Block cache below the caching block device operations ///
+//
+// A set associative cache of cache_size lines, plus a readahead buffer for
+// sequential file reads. Every read of the block device made by lfs_bd_read
+// goes through lfs_bcache_read, progs and erases invalidate what they
+// overwrite.
+
+static int lfs_bcache_rawread(lfs_t *lfs, lfs_block_t block, lfs_off_t off,
+        void *buffer, lfs_size_t size) {
+    lfs->bcache.stat.reads += 1;
+    lfs->bcache.stat.read_bytes += size;
+    int err = lfs->cfg->read(lfs->cfg, block, off, buffer, size);
+    LFS_ASSERT(err <= 0);
+    return err;
+}
+
+static lfs_bcache_line_t *lfs_bcache_set(lfs_t *lfs,
+        lfs_block_t block, lfs_off_t off) {
+    uint32_t h = block*0x9e3779b9 + off/lfs->cfg->cache_size;
+    return &lfs->bcache.lines[(h % lfs->bcache.sets) * lfs->bcache.ways];
+}
+
+static void lfs_bcache_drop(lfs_t *lfs, lfs_block_t block,
+        lfs_off_t off, lfs_size_t size) {
+    if (!lfs->cfg->bcache_lines) {
+        return;
+    }
+
+    lfs_off_t end = off + size;
+    for (lfs_off_t line_off = lfs_aligndown(off, lfs->cfg->cache_size);
+            line_off < end; line_off += lfs->cfg->cache_size) {
+        lfs_bcache_line_t *set = lfs_bcache_set(lfs, block, line_off);
+        for (lfs_size_t i = 0; i < lfs->bcache.ways; i++) {
+            if (set[i].block == block && set[i].off == line_off) {
+                set[i].block = LFS_BLOCK_NULL;
+            }
+        }
+    }
+
+    if (lfs->bcache.ra_block == block
+            && lfs->bcache.ra_off < end
+            && off < lfs->bcache.ra_off + lfs->bcache.ra_size) {
+        lfs->bcache.ra_block = LFS_BLOCK_NULL;
+    }
+}
+
+static int lfs_bcache_read(lfs_t *lfs, bool filedata,
+        lfs_block_t block, lfs_off_t off,
+        void *buffer, lfs_size_t size) {
+    struct lfs_bcache *bc = &lfs->bcache;
+    uint8_t *data = buffer;
+    if (!lfs->cfg->bcache_lines) {
+        return lfs_bcache_rawread(lfs, block, off, buffer, size);
+    }
+
+    bool sequential = false;
+    if (filedata) {
+        sequential = (block == bc->seq_block && off == bc->seq_off);
+        bc->seq_block = block;
+        bc->seq_off = off + size;
+    }
+
+    if (sequential && size <= lfs->cfg->bcache_readahead) {
+        // serve sequential file reads from the readahead buffer, refilled
+        // from here to as far as it goes in one read
+        if (!(block == bc->ra_block && off >= bc->ra_off
+                && off + size <= bc->ra_off + bc->ra_size)) {
+            bc->ra_block = LFS_BLOCK_NULL;
+            lfs_size_t ra_size = lfs_min(lfs->cfg->bcache_readahead,
+                    lfs->cfg->block_size - off);
+            int err = lfs_bcache_rawread(lfs, block, off,
+                    bc->ra_buffer, ra_size);
+            if (err) {
+                return err;
+            }
+
+            bc->ra_block = block;
+            bc->ra_off = off;
+            bc->ra_size = ra_size;
+            bc->stat.ra_fills += 1;
+        } else {
+            bc->stat.ra_hits += 1;
+        }
+
+        memcpy(data, &bc->ra_buffer[off - bc->ra_off], size);
+        return 0;
+    }
+
+    if (size > lfs->cfg->cache_size) {
+        // large reads would only flush the cache
+        bc->stat.bypasses += 1;
+        return lfs_bcache_rawread(lfs, block, off, buffer, size);
+    }
+
+    while (size > 0) {
+        lfs_off_t line_off = lfs_aligndown(off, lfs->cfg->cache_size);
+        lfs_size_t diff = lfs_min(size,
+                lfs->cfg->cache_size - (off - line_off));
+        lfs_bcache_line_t *set = lfs_bcache_set(lfs, block, line_off);
+        lfs_bcache_line_t *line = NULL;
+        lfs_bcache_line_t *victim = &set[0];
+
+        for (lfs_size_t i = 0; i < bc->ways; i++) {
+            if (set[i].block == block && set[i].off == line_off) {
+                line = &set[i];
+                break;
+            }
+
+            // least recently used, unused lines first
+            if (victim->block != LFS_BLOCK_NULL
+                    && (set[i].block == LFS_BLOCK_NULL
+                        || set[i].used < victim->used)) {
+                victim = &set[i];
+            }
+        }
+
+        uint8_t *line_data = bc->data;
+        if (line) {
+            bc->stat.hits += 1;
+            line_data += (lfs_size_t)(line - bc->lines)*lfs->cfg->cache_size;
+        } else {
+            line = victim;
+            line_data += (lfs_size_t)(line - bc->lines)*lfs->cfg->cache_size;
+            line->block = LFS_BLOCK_NULL;
+            int err = lfs_bcache_rawread(lfs, block, line_off,
+                    line_data, lfs->cfg->cache_size);
+            if (err) {
+                return err;
+            }
+
+            line->block = block;
+            line->off = line_off;
+            bc->stat.misses += 1;
+        }
+
+        bc->clock += 1;
+        line->used = bc->clock;
+        memcpy(data, &line_data[off - line_off], diff);
+
+        data += diff;
+        off += diff;
+        size -= diff;
+    }
+
+    return 0;
+}
+#endif
+
 static int lfs_bd_read(lfs_t *lfs,
         const lfs_cache_t *pcache, lfs_cache_t *rcache, lfs_size_t hint,
         lfs_block_t block, lfs_off_t off,
@@ -92,7 +241,12 @@ static int lfs_bd_read(lfs_t *lfs,
                 size >= lfs->cfg->read_size) {
             // bypass cache?
             diff = lfs_aligndown(diff, lfs->cfg->read_size);
+#ifdef LFS_BCACHE
+            int err = lfs_bcache_read(lfs, rcache != &lfs->rcache,
+                    block, off, data, diff);
+#else
             int err = lfs->cfg->read(lfs->cfg, block, off, data, diff);
+#endif
             if (err) {
                 return err;
             }
@@ -113,8 +267,13 @@ static int lfs_bd_read(lfs_t *lfs,
                     lfs->cfg->block_size)
                 - rcache->off,
                 lfs->cfg->cache_size);
+#ifdef LFS_BCACHE
+        int err = lfs_bcache_read(lfs, rcache != &lfs->rcache, rcache->block,
+                rcache->off, rcache->buffer, rcache->size);
+#else
         int err = lfs->cfg->read(lfs->cfg, rcache->block,
                 rcache->off, rcache->buffer, rcache->size);
+#endif
         LFS_ASSERT(err <= 0);
         if (err) {
             return err;
@@ -178,6 +337,9 @@ static int lfs_bd_flush(lfs_t *lfs,
     if (pcache->block != LFS_BLOCK_NULL && pcache->block != LFS_BLOCK_INLINE) {
         LFS_ASSERT(pcache->block < lfs->block_count);
         lfs_size_t diff = lfs_alignup(pcache->size, lfs->cfg->prog_size);
+#ifdef LFS_BCACHE
+        lfs_bcache_drop(lfs, pcache->block, pcache->off, diff);
+#endif
         int err = lfs->cfg->prog(lfs->cfg, pcache->block,
                 pcache->off, pcache->buffer, diff);
         LFS_ASSERT(err <= 0);
@@ -274,6 +436,9 @@ static int lfs_bd_prog(lfs_t *lfs,
 #ifndef LFS_READONLY
 static int lfs_bd_erase(lfs_t *lfs, lfs_block_t block) {
     LFS_ASSERT(block < lfs->block_count);
+#ifdef LFS_BCACHE
+    lfs_bcache_drop(lfs, block, 0, lfs->cfg->block_size);
+#endif
     int err = lfs->cfg->erase(lfs->cfg, block);
     LFS_ASSERT(err <= 0);
     return err;
@@ -600,6 +765,13 @@ static int lfs_unmount_(lfs_t *lfs);
 // after a checkpoint, the block allocator may realloc any untracked blocks
 static void lfs_alloc_ckpoint(lfs_t *lfs) {
     lfs->lookahead.ckpoint = lfs->block_count;
+#ifdef LFS_FREEMAP
+    if (lfs->freemap.inflight_count) {
+        memset(lfs->freemap.inflight, 0,
+                4*((lfs->block_count+31)/32));
+        lfs->freemap.inflight_count = 0;
+    }
+#endif
 }
 
 // drop the lookahead buffer, this is done during mounting and failed
@@ -649,8 +821,142 @@ static int lfs_alloc_scan(lfs_t *lfs) {
 }
 #endif
 
+#if defined(LFS_FREEMAP) && !defined(LFS_READONLY)
+static inline bool lfs_freemap_test(const uint32_t *map, lfs_block_t block) {
+    return map[block / 32] & (1U << (block % 32));
+}
+
+static int lfs_freemap_mark(void *p, lfs_block_t block) {
+    lfs_t *lfs = (lfs_t*)p;
+    // traversals may report a block more than once
+    if (block < lfs->block_count
+            && !lfs_freemap_test(lfs->freemap.map, block)) {
+        lfs->freemap.map[block / 32] |= 1U << (block % 32);
+        lfs->freemap.free -= 1;
+    }
+
+    return 0;
+}
+
+// rebuild the bitmap with one traversal of the filesystem
+static int lfs_freemap_build(lfs_t *lfs) {
+    lfs_size_t words = (lfs->block_count+31)/32;
+    lfs->freemap.free = lfs->block_count;
+
+    // blocks allocated since the last checkpoint stay in use, they may not
+    // be reachable yet
+    for (lfs_size_t i = 0; i < words; i++) {
+        lfs->freemap.map[i] = lfs->freemap.inflight[i];
+        lfs->freemap.free -= lfs_popc(lfs->freemap.inflight[i]);
+    }
+
+    // padding past the last block is never free
+    if (lfs->block_count % 32) {
+        lfs->freemap.map[words-1] |= ~0U << (lfs->block_count % 32);
+    }
+
+    int err = lfs_fs_traverse_(lfs, lfs_freemap_mark, lfs, true);
+    if (err) {
+        // nothing is free until a build completes
+        memset(lfs->freemap.map, 0xff, 4*words);
+        lfs->freemap.free = 0;
+        lfs->freemap.stale = true;
+        return err;
+    }
+
+    lfs->freemap.stale = false;
+    return 0;
+}
+
+// mark a block no longer referenced by the filesystem as free
+static void lfs_freemap_free(lfs_t *lfs, lfs_block_t block) {
+    if (block < lfs->block_count
+            && lfs_freemap_test(lfs->freemap.map, block)
+            && !lfs_freemap_test(lfs->freemap.inflight, block)) {
+        lfs->freemap.map[block / 32] &= ~(1U << (block % 32));
+        lfs->freemap.free += 1;
+    }
+}
+
+static int lfs_freemap_alloc(lfs_t *lfs, lfs_block_t *block) {
+    // out of free blocks? blocks dropped without being freed are only
+    // found by rebuilding the bitmap
+    if (lfs->freemap.free == 0 && lfs->freemap.stale) {
+        int err = lfs_freemap_build(lfs);
+        if (err) {
+            return err;
+        }
+    }
+
+    if (lfs->freemap.free == 0) {
+        LFS_ERROR("No more free space 0x%"PRIx32, lfs->freemap.next);
+        return LFS_ERR_NOSPC;
+    }
+
+    // find the next clear bit after the previous allocation, a word at a
+    // time, revisiting the first word unmasked after wrapping around
+    lfs_size_t words = (lfs->block_count+31)/32;
+    lfs_size_t i = lfs->freemap.next / 32;
+    uint32_t used = lfs->freemap.map[i]
+            | ((1U << (lfs->freemap.next % 32)) - 1);
+    for (lfs_size_t n = 0; n <= words; n++) {
+        if (~used) {
+            *block = 32*i + lfs_ctz(~used);
+            lfs->freemap.map[i] |= 1U << (*block % 32);
+            lfs->freemap.inflight[i] |= 1U << (*block % 32);
+            lfs->freemap.inflight_count += 1;
+            lfs->freemap.free -= 1;
+            lfs->freemap.stale = true;
+            lfs->freemap.next = (*block + 1) % lfs->block_count;
+            return 0;
+        }
+
+        i = (i + 1) % words;
+        used = lfs->freemap.map[i];
+    }
+
+    // free count out of sync with the bitmap
+    LFS_ASSERT(false);
+    return LFS_ERR_CORRUPT;
+}
+
+// allocate the bitmap once block_count is known, all blocks start in use
+static int lfs_freemap_init(lfs_t *lfs) {
+    if (!lfs->cfg->freemap) {
+        return 0;
+    }
+
+    if (!lfs->freemap.map) {
+        void *buffer = lfs->cfg->freemap_buffer;
+        if (!buffer) {
+            buffer = lfs_malloc(LFS_FREEMAP_BUFFER_SIZE(lfs->block_count));
+            if (!buffer) {
+                return LFS_ERR_NOMEM;
+            }
+        }
+
+        lfs->freemap.map = buffer;
+    }
+
+    lfs_size_t words = (lfs->block_count+31)/32;
+    lfs->freemap.inflight = &lfs->freemap.map[words];
+    memset(lfs->freemap.map, 0xff, 4*words);
+    memset(lfs->freemap.inflight, 0, 4*words);
+    lfs->freemap.inflight_count = 0;
+    lfs->freemap.free = 0;
+    lfs->freemap.stale = true;
+    return 0;
+}
+#endif
+
 #ifndef LFS_READONLY
 static int lfs_alloc(lfs_t *lfs, lfs_block_t *block) {
+#ifdef LFS_FREEMAP
+    if (lfs->freemap.map) {
+        return lfs_freemap_alloc(lfs, block);
+    }
+#endif
+
     while (true) {
         // scan our lookahead buffer for free blocks
         while (lfs->lookahead.next < lfs->lookahead.size) {
@@ -2884,6 +3190,115 @@ static int lfs_ctz_find(lfs_t *lfs,
     return 0;
 }
 
+#ifdef LFS_CTZINDEX
+// start over when the file's CTZ list changed, the stride is the smallest
+// power of two that covers the list with the entries available
+static void lfs_ctzindex_reset(lfs_t *lfs, lfs_file_t *file) {
+    lfs_size_t count = file->cfg->index_count;
+    lfs_off_t top = 0;
+    if (file->ctz.size) {
+        top = lfs_ctz_index(lfs, &(lfs_off_t){file->ctz.size-1});
+    }
+
+    file->index.head = file->ctz.head;
+    file->index.size = file->ctz.size;
+    file->index.stride = 1;
+    while (top / file->index.stride >= count) {
+        file->index.stride *= 2;
+    }
+
+    for (lfs_size_t i = 0; i < count; i++) {
+        file->index.blocks[i] = LFS_BLOCK_NULL;
+    }
+
+    if (top % file->index.stride == 0) {
+        file->index.blocks[top / file->index.stride] = file->ctz.head;
+    }
+}
+
+// find the block at a CTZ index, starting from the nearest indexed block
+// at or above it and indexing the blocks passed on the way
+static int lfs_ctzindex_find(lfs_t *lfs, lfs_file_t *file,
+        lfs_off_t target, lfs_block_t *block) {
+    if (file->index.head != file->ctz.head
+            || file->index.size != file->ctz.size) {
+        lfs_ctzindex_reset(lfs, file);
+    }
+
+    lfs_off_t stride = file->index.stride;
+    lfs_off_t current = lfs_ctz_index(lfs, &(lfs_off_t){file->ctz.size-1});
+    lfs_block_t head = file->ctz.head;
+    for (lfs_off_t i = (target + stride-1) / stride;
+            i*stride < current; i++) {
+        if (file->index.blocks[i] != LFS_BLOCK_NULL) {
+            current = i*stride;
+            head = file->index.blocks[i];
+            break;
+        }
+    }
+
+    while (current > target) {
+        lfs_size_t skip = lfs_min(
+                lfs_npw2(current-target+1) - 1,
+                lfs_ctz(current));
+
+        int err = lfs_bd_read(lfs,
+                NULL, &file->cache, sizeof(head),
+                head, 4*skip, &head, sizeof(head));
+        head = lfs_fromle32(head);
+        if (err) {
+            return err;
+        }
+
+        current -= 1 << skip;
+        if (current % stride == 0) {
+            file->index.blocks[current / stride] = head;
+        }
+    }
+
+    *block = head;
+    return 0;
+}
+
+static int lfs_file_index_(lfs_t *lfs, lfs_file_t *file) {
+    if (!file->cfg->index_count || (file->flags & LFS_F_INLINE)
+            || file->ctz.size == 0) {
+        return 0;
+    }
+
+    // walk down from the end, each step starts at the entry found before
+    lfs_off_t top = lfs_ctz_index(lfs, &(lfs_off_t){file->ctz.size-1});
+    lfs_ctzindex_reset(lfs, file);
+    for (lfs_off_t i = top / file->index.stride; i > 0; i--) {
+        lfs_block_t block;
+        int err = lfs_ctzindex_find(lfs, file,
+                (i-1)*file->index.stride, &block);
+        if (err) {
+            return err;
+        }
+    }
+
+    return 0;
+}
+#endif
+
+// find a block of an open file, through its block index if it has one,
+// the copy of the old list read by lfs_file_flush has no config
+static int lfs_file_ctzfind(lfs_t *lfs, lfs_file_t *file,
+        lfs_size_t pos, lfs_block_t *block, lfs_off_t *off) {
+#ifdef LFS_CTZINDEX
+    if (file->cfg && file->cfg->index_count && file->ctz.size) {
+        lfs_off_t target = lfs_ctz_index(lfs, &pos);
+        *off = pos;
+        return lfs_ctzindex_find(lfs, file, target, block);
+    }
+#endif
+
+    return lfs_ctz_find(lfs, NULL, &file->cache,
+            file->ctz.head, file->ctz.size,
+            pos, block, off);
+}
+
 #ifndef LFS_READONLY
 static int lfs_ctz_extend(lfs_t *lfs,
         lfs_cache_t *pcache, lfs_cache_t *rcache,
@@ -3027,6 +3442,90 @@ static int lfs_ctz_traverse(lfs_t *lfs,
     }
 }
 
+#if defined(LFS_FREEMAP) && !defined(LFS_READONLY)
+static int lfs_freemap_ctzprev(lfs_t *lfs, lfs_block_t *head) {
+    // the first pointer of a block points to the block before it
+    int err = lfs_bd_read(lfs,
+            NULL, &lfs->rcache, sizeof(*head),
+            *head, 0, head, sizeof(*head));
+    *head = lfs_fromle32(*head);
+    return err;
+}
+
+// free the blocks of a committed CTZ list that are not part of the list
+// replacing it, the lists share everything below their first common block
+//
+// a read error only leaks blocks until the next bitmap build
+static void lfs_freemap_dropctz(lfs_t *lfs,
+        lfs_block_t ohead, lfs_size_t osize,
+        lfs_block_t nhead, lfs_size_t nsize) {
+    if (!lfs->freemap.map || osize == 0) {
+        return;
+    }
+
+    lfs_off_t oindex = lfs_ctz_index(lfs, &(lfs_off_t){osize-1});
+    lfs_off_t nindex = 0;
+    if (nsize) {
+        nindex = lfs_ctz_index(lfs, &(lfs_off_t){nsize-1});
+    }
+
+    while (nsize && nindex > oindex) {
+        if (lfs_freemap_ctzprev(lfs, &nhead)) {
+            return;
+        }
+        nindex -= 1;
+    }
+
+    while (true) {
+        if (nsize && nindex == oindex && nhead == ohead) {
+            return;
+        }
+
+        lfs_freemap_free(lfs, ohead);
+        if (oindex == 0) {
+            return;
+        }
+
+        if (nsize && nindex == oindex) {
+            if (lfs_freemap_ctzprev(lfs, &nhead)) {
+                return;
+            }
+            nindex -= 1;
+        }
+
+        if (lfs_freemap_ctzprev(lfs, &ohead)) {
+            return;
+        }
+        oindex -= 1;
+    }
+}
+
+// find the CTZ list of a committed file, unless open files may still
+// read it
+static void lfs_freemap_getctz(lfs_t *lfs, const lfs_mdir_t *dir,
+        uint16_t id, const lfs_file_t *file, struct lfs_ctz *ctz) {
+    ctz->size = 0;
+    if (!lfs->freemap.map) {
+        return;
+    }
+
+    for (struct lfs_mlist *d = lfs->mlist; d; d = d->next) {
+        if (d != (const struct lfs_mlist*)file && d->type == LFS_TYPE_REG
+                && d->id == id && lfs_pair_cmp(d->m.pair, dir->pair) == 0) {
+            return;
+        }
+    }
+
+    lfs_stag_t tag = lfs_dir_get(lfs, dir, LFS_MKTAG(0x700, 0x3ff, 0),
+            LFS_MKTAG(LFS_TYPE_STRUCT, id, sizeof(*ctz)), ctz);
+    if (tag < 0 || lfs_tag_type3(tag) != LFS_TYPE_CTZSTRUCT) {
+        ctz->size = 0;
+        return;
+    }
+    lfs_ctz_fromle32(ctz);
+}
+#endif
+
 
 /// Top level file operations ///
 static int lfs_file_opencfg_(lfs_t *lfs, lfs_file_t *file,
@@ -3051,6 +3550,9 @@ static int lfs_file_opencfg_(lfs_t *lfs, lfs_file_t *file,
     file->pos = 0;
     file->off = 0;
     file->cache.buffer = NULL;
+#ifdef LFS_CTZINDEX
+    file->index.blocks = NULL;
+#endif
 
     // allocate entry for file if it doesn't exist
     lfs_stag_t tag = lfs_dir_find(lfs, &file->m, &path, &file->id);
@@ -3161,6 +3663,24 @@ static int lfs_file_opencfg_(lfs_t *lfs, lfs_file_t *file,
     // zero to avoid information leak
     lfs_cache_zero(lfs, &file->cache);
 
+#ifdef LFS_CTZINDEX
+    // allocate block index if needed, filled as blocks are found
+    if (file->cfg->index_count) {
+        if (file->cfg->index_buffer) {
+            file->index.blocks = file->cfg->index_buffer;
+        } else {
+            file->index.blocks = lfs_malloc(
+                    file->cfg->index_count*sizeof(lfs_block_t));
+            if (!file->index.blocks) {
+                err = LFS_ERR_NOMEM;
+                goto cleanup;
+            }
+        }
+
+        lfs_ctzindex_reset(lfs, file);
+    }
+#endif
+
     if (lfs_tag_type3(tag) == LFS_TYPE_INLINESTRUCT) {
         // load inline files
         file->ctz.head = LFS_BLOCK_INLINE;
@@ -3219,6 +3739,12 @@ static int lfs_file_close_(lfs_t *lfs, lfs_file_t *file) {
         lfs_free(file->cache.buffer);
     }
 
+#ifdef LFS_CTZINDEX
+    if (file->cfg->index_count && !file->cfg->index_buffer) {
+        lfs_free(file->index.blocks);
+    }
+#endif
+
     return err;
 }
 
@@ -3378,6 +3904,11 @@ relocate:
         // actual file updates
         file->ctz.head = file->block;
         file->ctz.size = file->pos;
+#ifdef LFS_CTZINDEX
+        // blocks dropped before being committed may be allocated again, so
+        // the new list can have the head and size of the one indexed
+        file->index.head = LFS_BLOCK_NULL;
+#endif
         file->flags &= ~LFS_F_WRITING;
         file->flags |= LFS_F_DIRTY;
 
@@ -3433,6 +3964,12 @@ static int lfs_file_sync_(lfs_t *lfs, lfs_file_t *file) {
             size = sizeof(ctz);
         }
 
+#ifdef LFS_FREEMAP
+        // find the committed blocks this commit replaces
+        struct lfs_ctz octz;
+        lfs_freemap_getctz(lfs, &file->m, file->id, file, &octz);
+#endif
+
         // commit file data and attributes
         err = lfs_dir_commit(lfs, &file->m, LFS_MKATTRS(
                 {LFS_MKTAG(type, file->id, size), buffer},
@@ -3443,6 +3980,12 @@ static int lfs_file_sync_(lfs_t *lfs, lfs_file_t *file) {
             return err;
         }
 
+#ifdef LFS_FREEMAP
+        lfs_freemap_dropctz(lfs, octz.head, octz.size,
+                file->ctz.head,
+                (file->flags & LFS_F_INLINE) ? 0 : file->ctz.size);
+#endif
+
         file->flags &= ~LFS_F_DIRTY;
     }
 
@@ -3468,8 +4011,7 @@ static lfs_ssize_t lfs_file_flushedread(lfs_t *lfs, lfs_file_t *file,
         if (!(file->flags & LFS_F_READING) ||
                 file->off == lfs->cfg->block_size) {
             if (!(file->flags & LFS_F_INLINE)) {
-                int err = lfs_ctz_find(lfs, NULL, &file->cache,
-                        file->ctz.head, file->ctz.size,
+                int err = lfs_file_ctzfind(lfs, file,
                         file->pos, &file->block, &file->off);
                 if (err) {
                     return err;
@@ -3552,8 +4094,7 @@ static lfs_ssize_t lfs_file_flushedwrite(lfs_t *lfs, lfs_file_t *file,
             if (!(file->flags & LFS_F_INLINE)) {
                 if (!(file->flags & LFS_F_WRITING) && file->pos > 0) {
                     // find out which block we're extending from
-                    int err = lfs_ctz_find(lfs, NULL, &file->cache,
-                            file->ctz.head, file->ctz.size,
+                    int err = lfs_file_ctzfind(lfs, file,
                             file->pos-1, &file->block, &(lfs_off_t){0});
                     if (err) {
                         file->flags |= LFS_F_ERRED;
@@ -3690,14 +4231,11 @@ static lfs_soff_t lfs_file_seek_(lfs_t *lfs, lfs_file_t *file,
     }
 
     // if we're only reading and our new offset is still in the file's cache
-    // we can avoid flushing and needing to reread the data
-    if (
-#ifndef LFS_READONLY
-        !(file->flags & LFS_F_WRITING)
-#else
-        true
-#endif
-            ) {
+    // we can avoid flushing and needing to reread the data, unless the last
+    // read ended at the end of a block, then pos is already in the next
+    // block while the cache still holds this one
+    if ((file->flags & LFS_F_READING)
+            && file->off != lfs->cfg->block_size) {
         int oindex = lfs_ctz_index(lfs, &(lfs_off_t){file->pos});
         lfs_off_t noff = npos;
         int nindex = lfs_ctz_index(lfs, &noff);
@@ -3764,8 +4302,7 @@ static int lfs_file_truncate_(lfs_t *lfs, lfs_file_t *file, lfs_off_t size) {
             }
 
             // lookup new head in ctz skip list
-            err = lfs_ctz_find(lfs, NULL, &file->cache,
-                    file->ctz.head, file->ctz.size,
+            err = lfs_file_ctzfind(lfs, file,
                     size-1, &file->block, &(lfs_off_t){0});
             if (err) {
                 return err;
@@ -3890,6 +4427,14 @@ static int lfs_remove_(lfs_t *lfs, const char *path) {
         lfs->mlist = &dir;
     }
 
+#ifdef LFS_FREEMAP
+    // find the file's blocks, freed with the entry
+    struct lfs_ctz octz = {.size = 0};
+    if (lfs_tag_type3(tag) == LFS_TYPE_REG) {
+        lfs_freemap_getctz(lfs, &cwd, lfs_tag_id(tag), NULL, &octz);
+    }
+#endif
+
     // delete the entry
     err = lfs_dir_commit(lfs, &cwd, LFS_MKATTRS(
             {LFS_MKTAG(LFS_TYPE_DELETE, lfs_tag_id(tag), 0), NULL}));
@@ -3899,6 +4444,9 @@ static int lfs_remove_(lfs_t *lfs, const char *path) {
     }
 
     lfs->mlist = dir.next;
+#ifdef LFS_FREEMAP
+    lfs_freemap_dropctz(lfs, octz.head, octz.size, 0, 0);
+#endif
     if (lfs_tag_type3(tag) == LFS_TYPE_DIR) {
         // fix orphan
         err = lfs_fs_preporphans(lfs, -1);
@@ -3915,6 +4463,14 @@ static int lfs_remove_(lfs_t *lfs, const char *path) {
         if (err) {
             return err;
         }
+
+#ifdef LFS_FREEMAP
+        // the dropped pair is no longer reachable
+        if (lfs->freemap.map) {
+            lfs_freemap_free(lfs, dir.m.pair[0]);
+            lfs_freemap_free(lfs, dir.m.pair[1]);
+        }
+#endif
     }
 
     return 0;
@@ -4004,6 +4560,14 @@ static int lfs_rename_(lfs_t *lfs, const char *oldpath, const char *newpath) {
         lfs->mlist = &prevdir;
     }
 
+#ifdef LFS_FREEMAP
+    // find the replaced file's blocks, freed with its entry
+    struct lfs_ctz prevctz = {.size = 0};
+    if (prevtag != LFS_ERR_NOENT && lfs_tag_type3(prevtag) == LFS_TYPE_REG) {
+        lfs_freemap_getctz(lfs, &newcwd, newid, NULL, &prevctz);
+    }
+#endif
+
     if (!samepair) {
         lfs_fs_prepmove(lfs, newoldid, oldcwd.pair);
     }
@@ -4036,6 +4600,9 @@ static int lfs_rename_(lfs_t *lfs, const char *oldpath, const char *newpath) {
     }
 
     lfs->mlist = prevdir.next;
+#ifdef LFS_FREEMAP
+    lfs_freemap_dropctz(lfs, prevctz.head, prevctz.size, 0, 0);
+#endif
     if (prevtag != LFS_ERR_NOENT
             && lfs_tag_type3(prevtag) == LFS_TYPE_DIR) {
         // fix orphan
@@ -4053,6 +4620,13 @@ static int lfs_rename_(lfs_t *lfs, const char *oldpath, const char *newpath) {
         if (err) {
             return err;
         }
+
+#ifdef LFS_FREEMAP
+        if (lfs->freemap.map) {
+            lfs_freemap_free(lfs, prevdir.m.pair[0]);
+            lfs_freemap_free(lfs, prevdir.m.pair[1]);
+        }
+#endif
     }
 
     return 0;
@@ -4154,6 +4728,15 @@ static int lfs_init(lfs_t *lfs, const struct lfs_config *cfg) {
     lfs->cfg = cfg;
     lfs->block_count = cfg->block_count;  // May be 0
     int err = 0;
+#ifdef LFS_BCACHE
+    memset(&lfs->bcache, 0, sizeof(lfs->bcache));
+    lfs->bcache.ra_block = LFS_BLOCK_NULL;
+    lfs->bcache.seq_block = LFS_BLOCK_NULL;
+#endif
+#ifdef LFS_FREEMAP
+    // allocated once block_count is known
+    memset(&lfs->freemap, 0, sizeof(lfs->freemap));
+#endif
 
 #ifdef LFS_MULTIVERSION
     // this driver only supports minor version < current minor version
@@ -4245,6 +4828,40 @@ static int lfs_init(lfs_t *lfs, const struct lfs_config *cfg) {
         }
     }
 
+#ifdef LFS_BCACHE
+    // setup block cache, line tags first to keep them aligned
+    if (lfs->cfg->bcache_lines) {
+        lfs->bcache.ways = lfs->cfg->bcache_ways;
+        if (!lfs->bcache.ways) {
+            lfs->bcache.ways = lfs_min(4, lfs->cfg->bcache_lines);
+        }
+        LFS_ASSERT(lfs->cfg->bcache_lines % lfs->bcache.ways == 0);
+        LFS_ASSERT(lfs->cfg->bcache_readahead % lfs->cfg->cache_size == 0);
+        lfs->bcache.sets = lfs->cfg->bcache_lines / lfs->bcache.ways;
+
+        void *buffer = lfs->cfg->bcache_buffer;
+        if (!buffer) {
+            buffer = lfs_malloc(LFS_BCACHE_BUFFER_SIZE(
+                    lfs->cfg->bcache_lines, lfs->cfg->cache_size,
+                    lfs->cfg->bcache_readahead));
+            if (!buffer) {
+                err = LFS_ERR_NOMEM;
+                goto cleanup;
+            }
+        }
+
+        lfs->bcache.lines = buffer;
+        lfs->bcache.data = (uint8_t*)&lfs->bcache.lines[
+                lfs->cfg->bcache_lines];
+        lfs->bcache.ra_buffer = &lfs->bcache.data[
+                lfs->cfg->bcache_lines*lfs->cfg->cache_size];
+        for (lfs_size_t i = 0; i < lfs->cfg->bcache_lines; i++) {
+            lfs->bcache.lines[i].block = LFS_BLOCK_NULL;
+            lfs->bcache.lines[i].used = 0;
+        }
+    }
+#endif
+
     // check that the size limits are sane
     LFS_ASSERT(lfs->cfg->name_max <= LFS_NAME_MAX);
     lfs->name_max = lfs->cfg->name_max;
@@ -4320,6 +4937,20 @@ static int lfs_deinit(lfs_t *lfs) {
         lfs_free(lfs->lookahead.buffer);
     }
 
+#ifdef LFS_BCACHE
+    if (!lfs->cfg->bcache_buffer) {
+        lfs_free(lfs->bcache.lines);
+    }
+    lfs->bcache.lines = NULL;
+#endif
+
+#ifdef LFS_FREEMAP
+    if (!lfs->cfg->freemap_buffer) {
+        lfs_free(lfs->freemap.map);
+    }
+    lfs->freemap.map = NULL;
+#endif
+
     return 0;
 }
 
@@ -4344,6 +4975,20 @@ static int lfs_format_(lfs_t *lfs, const struct lfs_config *cfg) {
         lfs->lookahead.next = 0;
         lfs_alloc_ckpoint(lfs);
 
+#ifdef LFS_FREEMAP
+        // or an empty free block bitmap
+        err = lfs_freemap_init(lfs);
+        if (err) {
+            goto cleanup;
+        }
+
+        if (lfs->freemap.map) {
+            for (lfs_block_t block = 0; block < lfs->block_count; block++) {
+                lfs_freemap_free(lfs, block);
+            }
+        }
+#endif
+
         // create root dir
         lfs_mdir_t root;
         err = lfs_dir_alloc(lfs, &root);
@@ -4556,6 +5201,23 @@ static int lfs_mount_(lfs_t *lfs, const struct lfs_config *cfg) {
     lfs->lookahead.start = lfs->seed % lfs->block_count;
     lfs_alloc_drop(lfs);
 
+#if defined(LFS_FREEMAP) && !defined(LFS_READONLY)
+    // build the free block bitmap in one traversal, later allocations
+    // don't need to traverse the filesystem
+    err = lfs_freemap_init(lfs);
+    if (err) {
+        goto cleanup;
+    }
+
+    if (lfs->freemap.map) {
+        lfs->freemap.next = lfs->seed % lfs->block_count;
+        err = lfs_freemap_build(lfs);
+        if (err) {
+            goto cleanup;
+        }
+    }
+#endif
+
     return 0;
 
 cleanup:
@@ -5159,6 +5821,21 @@ static int lfs_fs_gc_(lfs_t *lfs) {
         }
     }
 
+#ifdef LFS_FREEMAP
+    // find blocks dropped without being freed
+    if (lfs->freemap.map) {
+        if (lfs->freemap.stale) {
+            lfs_alloc_ckpoint(lfs);
+            err = lfs_freemap_build(lfs);
+            if (err) {
+                return err;
+            }
+        }
+
+        return 0;
+    }
+#endif
+
     // try to populate the lookahead buffer, unless it's already full
     if (lfs->lookahead.size < 8*lfs->cfg->lookahead_size) {
         err = lfs_alloc_scan(lfs);
@@ -5179,6 +5856,26 @@ static int lfs_fs_grow_(lfs_t *lfs, lfs_size_t block_count) {
     if (block_count > lfs->block_count) {
         lfs->block_count = block_count;
 
+#ifdef LFS_FREEMAP
+        // resize the free block bitmap before anything is allocated
+        if (lfs->freemap.map) {
+            if (!lfs->cfg->freemap_buffer) {
+                lfs_free(lfs->freemap.map);
+                lfs->freemap.map = NULL;
+            }
+
+            int err = lfs_freemap_init(lfs);
+            if (err) {
+                return err;
+            }
+
+            err = lfs_freemap_build(lfs);
+            if (err) {
+                return err;
+            }
+        }
+#endif
+
         // fetch the root
         lfs_mdir_t root;
         int err = lfs_dir_fetch(lfs, &root, lfs->root);
@@ -6168,6 +6865,23 @@ lfs_soff_t lfs_file_seek(lfs_t *lfs, lfs_file_t *file,
     return res;
 }
 
+#ifdef LFS_CTZINDEX
+int lfs_file_index(lfs_t *lfs, lfs_file_t *file) {
+    int err = LFS_LOCK(lfs->cfg);
+    if (err) {
+        return err;
+    }
+    LFS_TRACE("lfs_file_index(%p, %p)", (void*)lfs, (void*)file);
+    LFS_ASSERT(lfs_mlist_isopen(lfs->mlist, (struct lfs_mlist*)file));
+
+    err = lfs_file_index_(lfs, file);
+
+    LFS_TRACE("lfs_file_index -> %d", err);
+    LFS_UNLOCK(lfs->cfg);
+    return err;
+}
+#endif
+
 #ifndef LFS_READONLY
 int lfs_file_truncate(lfs_t *lfs, lfs_file_t *file, lfs_off_t size) {
     int err = LFS_LOCK(lfs->cfg);
@@ -6361,6 +7075,22 @@ lfs_ssize_t lfs_fs_size(lfs_t *lfs) {
     return res;
 }
 
+#ifdef LFS_BCACHE
+int lfs_fs_bcachestat(lfs_t *lfs, struct lfs_bcachestat *stat) {
+    int err = LFS_LOCK(lfs->cfg);
+    if (err) {
+        return err;
+    }
+    LFS_TRACE("lfs_fs_bcachestat(%p, %p)", (void*)lfs, (void*)stat);
+
+    *stat = lfs->bcache.stat;
+
+    LFS_TRACE("lfs_fs_bcachestat -> %d", 0);
+    LFS_UNLOCK(lfs->cfg);
+    return 0;
+}
+#endif
+
 int lfs_fs_traverse(lfs_t *lfs, int (*cb)(void *, lfs_block_t), void *data) {
     int err = LFS_LOCK(lfs->cfg);
     if (err) {
@@ -288,8 +288,73 @@ struct lfs_config {
     // to the most recent minor version when zero.
     uint32_t disk_version;
 #endif
+
+#ifdef LFS_BCACHE
+    // Number of cache_size lines in the optional block cache below the read
+    // cache. Metadata blocks and CTZ pointers read by different operations
+    // stay cached instead of evicting each other from the single read
+    // cache. Must be a multiple of bcache_ways. Zero disables the block
+    // cache.
+    lfs_size_t bcache_lines;
+
+    // Lines per set of the block cache, a line is only evicted by lines
+    // mapping to the same set. Defaults to 4 (or bcache_lines if smaller)
+    // when zero.
+    lfs_size_t bcache_ways;
+
+    // Size of the readahead buffer in bytes. Sequential file reads are
+    // served from it and it is refilled with one block device read. Must be
+    // a multiple of cache_size. Zero disables readahead.
+    lfs_size_t bcache_readahead;
+
+    // Optional statically allocated block cache buffer. Must be
+    // LFS_BCACHE_BUFFER_SIZE(bcache_lines, cache_size, bcache_readahead).
+    // By default lfs_malloc is used to allocate this buffer.
+    void *bcache_buffer;
+#endif
+
+#ifdef LFS_FREEMAP
+    // Keep a bitmap of the blocks in use for the whole volume in RAM instead
+    // of refilling the lookahead buffer with a traversal of the filesystem
+    // every 8*lookahead_size blocks. The bitmap is built with one traversal
+    // at mount and updated as blocks are allocated and as files and
+    // directories are rewritten or removed. Blocks dropped in other ways
+    // are found by a traversal when the bitmap runs out of free blocks, or
+    // by lfs_fs_gc. Uses 2 bits of RAM per block.
+    bool freemap;
+
+    // Optional statically allocated free block bitmap. Must be
+    // LFS_FREEMAP_BUFFER_SIZE(block_count) bytes and 32-bit aligned, and
+    // cover the block_count passed to lfs_fs_grow. By default lfs_malloc is
+    // used to allocate this buffer.
+    void *freemap_buffer;
+#endif
 };
 
+#ifdef LFS_BCACHE
+// Block cache statistics, counted since mount
+struct lfs_bcachestat {
+    // Reads served from block cache lines
+    uint32_t hits;
+
+    // Lines loaded from the block device
+    uint32_t misses;
+
+    // Sequential reads served from the readahead buffer
+    uint32_t ra_hits;
+
+    // Readahead buffer loads
+    uint32_t ra_fills;
+
+    // Large reads passed to the block device uncached
+    uint32_t bypasses;
+
+    // Calls to the block device read function and bytes read by them
+    uint32_t reads;
+    uint32_t read_bytes;
+};
+#endif
+
 // File info structure
 struct lfs_info {
     // Type of the file, either LFS_TYPE_REG or LFS_TYPE_DIR
@@ -361,6 +426,21 @@ struct lfs_file_config {
 
     // Number of custom attributes in the list
     lfs_size_t attr_count;
+
+#ifdef LFS_CTZINDEX
+    // Number of entries in the block index of the file. The index remembers
+    // the addresses of evenly spaced blocks of the file, so finding a block
+    // when seeking walks the skip-list from the nearest indexed block
+    // instead of from the end of the file. With at least one entry per
+    // block of the file a seek reads no pointers once the index is filled.
+    // Entries are filled by reads and seeks, or at once by
+    // lfs_file_index. Zero disables the index.
+    lfs_size_t index_count;
+
+    // Optional statically allocated block index. Must be index_count
+    // entries. By default lfs_malloc is used to allocate this buffer.
+    lfs_block_t *index_buffer;
+#endif
 };
 
 
@@ -372,6 +452,23 @@ typedef struct lfs_cache {
     uint8_t *buffer;
 } lfs_cache_t;
 
+#ifdef LFS_BCACHE
+typedef struct lfs_bcache_line {
+    lfs_block_t block;
+    lfs_off_t off;
+    uint32_t used;
+} lfs_bcache_line_t;
+
+// Size of the block cache buffer: line tags, line data, readahead buffer
+#define LFS_BCACHE_BUFFER_SIZE(lines, cache_size, readahead) \
+    ((lines)*(sizeof(lfs_bcache_line_t) + (cache_size)) + (readahead))
+#endif
+
+#ifdef LFS_FREEMAP
+#define LFS_FREEMAP_BUFFER_SIZE(block_count) \
+    (2*4*(((block_count)+31)/32))
+#endif
+
 typedef struct lfs_mdir {
     lfs_block_t pair[2];
     uint32_t rev;
@@ -413,6 +510,18 @@ typedef struct lfs_file {
     lfs_cache_t cache;
 
     const struct lfs_file_config *cfg;
+
+#ifdef LFS_CTZINDEX
+    struct lfs_ctzindex {
+        // blocks at indexes 0, stride, 2*stride..., LFS_BLOCK_NULL if not
+        // known yet
+        lfs_block_t *blocks;
+        lfs_off_t stride;
+        // the CTZ list indexed, the index is dropped when it changes
+        lfs_block_t head;
+        lfs_size_t size;
+    } index;
+#endif
 } lfs_file_t;
 
 typedef struct lfs_superblock {
@@ -462,6 +571,43 @@ typedef struct lfs {
     lfs_size_t attr_max;
     lfs_size_t inline_max;
 
+#ifdef LFS_BCACHE
+    struct lfs_bcache {
+        lfs_bcache_line_t *lines;
+        uint8_t *data;
+        lfs_size_t sets;
+        lfs_size_t ways;
+        uint32_t clock;
+
+        uint8_t *ra_buffer;
+        lfs_block_t ra_block;
+        lfs_off_t ra_off;
+        lfs_size_t ra_size;
+
+        // end of the latest file data read, to detect sequential reads
+        lfs_block_t seq_block;
+        lfs_off_t seq_off;
+
+        struct lfs_bcachestat stat;
+    } bcache;
+#endif
+
+#ifdef LFS_FREEMAP
+    struct lfs_freemap {
+        // one bit per block, set if in use or allocated
+        uint32_t *map;
+        // blocks allocated since the last checkpoint, may not be reachable
+        // from the filesystem yet
+        uint32_t *inflight;
+        lfs_size_t inflight_count;
+        lfs_block_t next;
+        lfs_size_t free;
+        // blocks were allocated since the last build, some may have been
+        // dropped without being freed
+        bool stale;
+    } freemap;
+#endif
+
 #ifdef LFS_MIGRATE
     struct lfs1 *lfs1;
 #endif
@@ -654,6 +800,17 @@ int lfs_file_rewind(lfs_t *lfs, lfs_file_t *file);
 // Returns the size of the file, or a negative error code on failure.
 lfs_soff_t lfs_file_size(lfs_t *lfs, lfs_file_t *file);
 
+#ifdef LFS_CTZINDEX
+// Fill the block index of the file
+//
+// Walks the block list of the file once, so later seeks and reads anywhere
+// in the file start from an indexed block. Does nothing if the file was
+// opened without an index or is inlined. Writes to the file drop the index.
+//
+// Returns a negative error code on failure.
+int lfs_file_index(lfs_t *lfs, lfs_file_t *file);
+#endif
+
 
 /// Directory operations ///
 
@@ -730,6 +887,16 @@ lfs_ssize_t lfs_fs_size(lfs_t *lfs);
 // Returns a negative error code on failure.
 int lfs_fs_traverse(lfs_t *lfs, int (*cb)(void*, lfs_block_t), void *data);
 
+#ifdef LFS_BCACHE
+// Find the block cache statistics
+//
+// Fills out the bcachestat structure with the counts since mount. All
+// counts are zero if the block cache is disabled.
+//
+// Returns a negative error code on failure.
+int lfs_fs_bcachestat(lfs_t *lfs, struct lfs_bcachestat *stat);
+#endif
+
 #ifndef LFS_READONLY
 // Attempt to make the filesystem consistent and ready for writing
 //
@@ -0,0 +1,249 @@
+/**
+ * @file
+ * TCP demultiplexing benchmarks: 4 byte segments for N established
+ * connections, round-robin, handed to ip4_input() of the server netif
+ * directly in the tcpip thread. This measures finding the pcb of a segment
+ * (the linear list or TCP_PCB_HASH_SIZE) with the rest of tcp_input() on
+ * top; the ACKs are discarded instead of crossing the wire.
+ *
+ * - tcp-demux-1, tcp-demux-50, tcp-demux-200: 1, 50 and 200 connections
+ *
+ * The connections need as many pcbs, e.g.
+ * -DLWIP_BENCH_DEFINES="MEMP_NUM_TCP_PCB=208"; a benchmark the pool is too
+ * small for is skipped. Every connection is checked to have received all of
+ * its bytes.
+ */
+
+#include "lwip/opt.h"
+#include "lwip/tcp.h"
+#include "lwip/priv/tcp_priv.h"
+#include "lwip/ip4.h"
+#include "lwip/inet_chksum.h"
+#include "lwip/prot/ip4.h"
+#include "lwip/prot/tcp.h"
+
+#include "lwip_bench.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_DEMUX_LOCAL_PORT  5001
+#define BENCH_DEMUX_REMOTE_PORT 40000
+#define BENCH_DEMUX_DATA_LEN    4
+
+struct bench_demux_conn {
+  struct tcp_pcb *pcb;
+  u32_t received;
+};
+
+struct bench_demux_state {
+  const struct bench_config *config;
+  u16_t num;
+  struct bench_demux_conn *conns;
+  u32_t segments;
+  u64_t elapsed_us;
+  int skipped;
+  int error;
+};
+
+static err_t
+bench_demux_discard(struct netif *netif, struct pbuf *p, const ip4_addr_t *ipaddr)
+{
+  LWIP_UNUSED_ARG(netif);
+  LWIP_UNUSED_ARG(p);
+  LWIP_UNUSED_ARG(ipaddr);
+  return ERR_OK;
+}
+
+static err_t
+bench_demux_recv(void *arg, struct tcp_pcb *pcb, struct pbuf *p, err_t err)
+{
+  struct bench_demux_conn *conn = (struct bench_demux_conn *)arg;
+
+  LWIP_UNUSED_ARG(err);
+  if (p == NULL) {
+    return ERR_OK;
+  }
+  conn->received += p->tot_len;
+  tcp_recved(pcb, p->tot_len);
+  pbuf_free(p);
+  return ERR_OK;
+}
+
+/* An established connection from the client address, as if it had been
+ * accepted: registered the way tcp_input() registers a new one. */
+static struct tcp_pcb *
+bench_demux_open(struct bench_demux_conn *conn, u16_t remote_port)
+{
+  struct tcp_pcb *pcb = tcp_new();
+  u32_t iss;
+
+  if (pcb == NULL) {
+    return NULL;
+  }
+  /* above the priority tcp_alloc() kills to make room for the next one */
+  tcp_setprio(pcb, TCP_PRIO_MAX);
+  ip_addr_copy_from_ip4(pcb->local_ip, bench_server_ip);
+  ip_addr_copy_from_ip4(pcb->remote_ip, bench_client_ip);
+  pcb->local_port = BENCH_DEMUX_LOCAL_PORT;
+  pcb->remote_port = remote_port;
+  pcb->state = ESTABLISHED;
+  iss = tcp_next_iss(pcb);
+  pcb->snd_wl2 = iss;
+  pcb->snd_nxt = iss;
+  pcb->lastack = iss;
+  pcb->snd_lbb = iss;
+  pcb->rcv_nxt = 1;
+  tcp_arg(pcb, conn);
+  tcp_recv(pcb, bench_demux_recv);
+  TCP_REG_ACTIVE(pcb);
+  return pcb;
+}
+
+static struct pbuf *
+bench_demux_segment(const struct tcp_pcb *pcb)
+{
+  struct pbuf *p;
+  struct ip_hdr *iphdr;
+  struct tcp_hdr *tcphdr;
+
+  p = pbuf_alloc(PBUF_RAW, IP_HLEN + TCP_HLEN + BENCH_DEMUX_DATA_LEN, PBUF_POOL);
+  if ((p == NULL) || (p->len != p->tot_len)) {
+    if (p != NULL) {
+      pbuf_free(p);
+    }
+    return NULL;
+  }
+  iphdr = (struct ip_hdr *)p->payload;
+  memset(iphdr, 0, IP_HLEN + TCP_HLEN + BENCH_DEMUX_DATA_LEN);
+  IPH_VHL_SET(iphdr, 4, IP_HLEN / 4);
+  IPH_LEN_SET(iphdr, lwip_htons(p->tot_len));
+  IPH_TTL_SET(iphdr, 64);
+  IPH_PROTO_SET(iphdr, IP_PROTO_TCP);
+  ip4_addr_copy(iphdr->src, bench_client_ip);
+  ip4_addr_copy(iphdr->dest, bench_server_ip);
+#if CHECKSUM_CHECK_IP
+  IPH_CHKSUM_SET(iphdr, inet_chksum(iphdr, IP_HLEN));
+#endif
+
+  tcphdr = (struct tcp_hdr *)((u8_t *)p->payload + IP_HLEN);
+  tcphdr->src = lwip_htons(pcb->remote_port);
+  tcphdr->dest = lwip_htons(pcb->local_port);
+  tcphdr->seqno = lwip_htonl(pcb->rcv_nxt);
+  tcphdr->ackno = lwip_htonl(pcb->snd_nxt);
+  TCPH_HDRLEN_FLAGS_SET(tcphdr, TCP_HLEN / 4, TCP_ACK | TCP_PSH);
+  tcphdr->wnd = PP_HTONS(TCP_WND_MAX(pcb) > 0xFFFF ? 0xFFFF : TCP_WND_MAX(pcb));
+#if CHECKSUM_CHECK_TCP
+  {
+    ip_addr_t src, dest;
+    ip_addr_copy_from_ip4(src, bench_client_ip);
+    ip_addr_copy_from_ip4(dest, bench_server_ip);
+    pbuf_remove_header(p, IP_HLEN);
+    tcphdr->chksum = ip_chksum_pseudo(p, IP_PROTO_TCP, p->tot_len, &src, &dest);
+    pbuf_add_header(p, IP_HLEN);
+  }
+#endif
+  return p;
+}
+
+/* runs in the tcpip thread for the whole measurement */
+static void
+bench_demux_run_fn(void *arg)
+{
+  struct bench_demux_state *state = (struct bench_demux_state *)arg;
+  netif_output_fn output = bench_server_netif.output;
+  u64_t start_us, end_us;
+  u16_t i, c = 0;
+
+  for (i = 0; i < state->num; i++) {
+    state->conns[i].pcb = bench_demux_open(&state->conns[i], (u16_t)(BENCH_DEMUX_REMOTE_PORT + i));
+    if (state->conns[i].pcb == NULL) {
+      state->skipped = 1;
+      break;
+    }
+  }
+
+  if (!state->skipped) {
+    bench_server_netif.output = bench_demux_discard;
+    start_us = bench_now_us();
+    end_us = start_us + (u64_t)state->config->duration_ms * 1000;
+    for (;;) {
+      struct pbuf *p = bench_demux_segment(state->conns[c].pcb);
+
+      if (p == NULL) {
+        state->error = 1;
+        break;
+      }
+      ip4_input(p, &bench_server_netif);
+      state->segments++;
+      if (++c == state->num) {
+        c = 0;
+      }
+      if (((state->segments & 255) == 0) && (bench_now_us() >= end_us)) {
+        break;
+      }
+    }
+    state->elapsed_us = bench_now_us() - start_us;
+    bench_server_netif.output = output;
+  }
+
+  for (i = 0; i < state->num; i++) {
+    if (state->conns[i].pcb != NULL) {
+      /* all of it delivered to its own connection */
+      if (!state->skipped && !state->error &&
+          (state->conns[i].received != BENCH_DEMUX_DATA_LEN * ((state->segments - i + state->num - 1) / state->num))) {
+        state->error = 1;
+      }
+      tcp_abandon(state->conns[i].pcb, 0);
+    }
+  }
+}
+
+static int
+bench_demux_run(const struct bench_config *config, const char *name, u16_t num)
+{
+  struct bench_demux_state state;
+  double secs;
+
+  memset(&state, 0, sizeof(state));
+  state.config = config;
+  state.num = num;
+  state.conns = (struct bench_demux_conn *)calloc(num, sizeof(struct bench_demux_conn));
+  if (state.conns == NULL) {
+    return -1;
+  }
+  bench_tcpip_call(bench_demux_run_fn, &state);
+  free(state.conns);
+  if (state.skipped) {
+    printf("%-14s skipped, needs MEMP_NUM_TCP_PCB >= %u\n", name, (unsigned)num);
+    return 0;
+  }
+  if (state.error || (state.elapsed_us == 0)) {
+    return -1;
+  }
+
+  secs = (double)state.elapsed_us / 1000000.0;
+  printf("%-14s %lu segments over %u connections in %.2f s: %.0f segments/s (TCP_PCB_HASH_SIZE %d)\n",
+         name, (unsigned long)state.segments, (unsigned)num, secs, state.segments / secs,
+         (int)TCP_PCB_HASH_SIZE);
+  return 0;
+}
+
+int
+bench_tcp_demux_1(const struct bench_config *config)
+{
+  return bench_demux_run(config, "tcp-demux-1", 1);
+}
+
+int
+bench_tcp_demux_50(const struct bench_config *config)
+{
+  return bench_demux_run(config, "tcp-demux-50", 50);
+}
+
+int
+bench_tcp_demux_200(const struct bench_config *config)
+{
+  return bench_demux_run(config, "tcp-demux-200", 200);
+}
@@ -0,0 +1,464 @@
+/**
+ * @file
+ * ENET netif port benchmarks: the driver side of port/ethernetif_*.c against
+ * a mock of the ENET descriptor rings, in the tcpip thread. The mock MAC
+ * takes no CPU time to move bytes, so what is measured is the driver path
+ * alone.
+ *
+ * - eth-tx-copy: TCP sized frames (54 byte header pbuf + 1460 byte data
+ *   pbuf) copied into one TX buffer, as the driver does without
+ *   ETH_TX_ZEROCOPY
+ * - eth-tx-zerocopy: the same frames handed to the descriptors as they are
+ *   with ethernetif_tx_zerocopy_prepare(), released by reclaim
+ * - eth-rx-frame: 60 byte frames received one at a time, one RX interrupt
+ *   and one core lock per frame
+ * - eth-rx-batch: bursts of ETH_RX_BATCH_BUDGET frames under one RX
+ *   interrupt, taken with ethernetif_rx_batch_poll(), one core lock per
+ *   budget
+ *
+ * Every TX frame is checked to reach the ring with its full length, and every
+ * reference the driver took to be released again. Every RX frame is checked
+ * to be taken from the ring and passed to ethernet_input(), which drops it
+ * for its unknown ethertype.
+ *
+ * The RX benchmarks run in the main thread as the RX task does on target,
+ * taking the core lock themselves. Without LWIP_TCPIP_CORE_LOCKING the
+ * frames are posted to the tcpip thread instead; the ones its mailbox has
+ * no room for are counted as input errors.
+ *
+ * On the host the copy of a frame hot in the cache is cheap, and
+ * SYS_ARCH_PROTECT() around the pbuf reference counts is a mutex. On target
+ * the copied TX buffer also has to be cleaned from the data cache for the
+ * DMA, and the protection only masks interrupts, so the two paths compare
+ * differently there.
+ */
+
+#include "lwip/opt.h"
+#include "lwip/pbuf.h"
+
+#include "lwip/netif.h"
+#include "lwip/tcpip.h"
+#include "netif/ethernet.h"
+
+#include "../../../../port/ethernetif_zerocopy.h"
+#include "../../../../port/ethernetif_rx_batch.h"
+
+#include "lwip_bench.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_ETH_TXBD_NUM   8
+#define BENCH_ETH_FRAME_SIZE 1600
+#define BENCH_ETH_RXBD_NUM   64
+#define BENCH_ETH_RX_LEN     60
+
+struct bench_eth_txbd {
+  u16_t length;
+  u8_t last;
+  struct pbuf *context;
+};
+
+/* ENET TX descriptor ring as driven by ENET_StartTxFrame() and
+ * ENET_ReclaimTxDescriptor(): one descriptor per segment, the last one of a
+ * frame carries the frame context. */
+struct bench_eth_tx_ring {
+  struct bench_eth_txbd bd[BENCH_ETH_TXBD_NUM];
+  u16_t produce;
+  u16_t consume;
+  u16_t used;
+  u8_t buffers[BENCH_ETH_TXBD_NUM][BENCH_ETH_FRAME_SIZE];
+  ethernetif_tx_zerocopy_t zc;
+  u64_t sent_bytes;
+};
+
+struct bench_eth_tx_state {
+  const struct bench_config *config;
+  u8_t zerocopy;
+  u32_t frames;
+  u32_t frame_len;
+  u64_t elapsed_us;
+  int error;
+};
+
+static struct bench_eth_tx_ring bench_eth_tx;
+
+/* ENET_StartTxFrame() */
+static err_t
+bench_eth_start_tx_frame(const ethernetif_tx_seg_t *segs, u16_t segs_num, struct pbuf *context)
+{
+  u16_t i;
+
+  if (BENCH_ETH_TXBD_NUM - bench_eth_tx.used < segs_num) {
+    return ERR_BUF;
+  }
+  for (i = 0; i < segs_num; i++) {
+    struct bench_eth_txbd *bd = &bench_eth_tx.bd[bench_eth_tx.produce];
+    bd->length = segs[i].length;
+    bd->last = (u8_t)(i == segs_num - 1);
+    bd->context = bd->last ? context : NULL;
+    bench_eth_tx.produce = (u16_t)((bench_eth_tx.produce + 1) % BENCH_ETH_TXBD_NUM);
+    bench_eth_tx.used++;
+  }
+  return ERR_OK;
+}
+
+/* The MAC sends one frame, then the TX interrupt reclaims its descriptors.
+ * Returns the value of ethernetif_tx_zerocopy_complete(), 0 for a frame of
+ * the copy path. */
+static u8_t
+bench_eth_dma_step(void)
+{
+  while (bench_eth_tx.used > 0) {
+    struct bench_eth_txbd *bd = &bench_eth_tx.bd[bench_eth_tx.consume];
+
+    bench_eth_tx.sent_bytes += bd->length;
+    bench_eth_tx.consume = (u16_t)((bench_eth_tx.consume + 1) % BENCH_ETH_TXBD_NUM);
+    bench_eth_tx.used--;
+    if (bd->last) {
+      return (bd->context != NULL) ? ethernetif_tx_zerocopy_complete(&bench_eth_tx.zc, bd->context) : 0;
+    }
+  }
+  return 0;
+}
+
+/* linkoutput without ETH_TX_ZEROCOPY: the frame is copied into a TX buffer */
+static err_t
+bench_eth_linkoutput_copy(struct pbuf *p)
+{
+  ethernetif_tx_seg_t seg;
+
+  seg.buffer = bench_eth_tx.buffers[bench_eth_tx.produce];
+  seg.length = pbuf_copy_partial(p, seg.buffer, p->tot_len, 0);
+  return bench_eth_start_tx_frame(&seg, 1, NULL);
+}
+
+/* linkoutput with ETH_TX_ZEROCOPY: map, hand to the ring, drop the
+ * reference on failure */
+static err_t
+bench_eth_linkoutput_zerocopy(struct pbuf *p)
+{
+  ethernetif_tx_seg_t segs[ETH_TX_ZEROCOPY_MAX_SEGS];
+  u16_t segs_num;
+  struct pbuf *frame;
+  err_t err;
+
+  frame = ethernetif_tx_zerocopy_prepare(&bench_eth_tx.zc, p, segs, &segs_num);
+  if (frame == NULL) {
+    return ERR_MEM;
+  }
+  err = bench_eth_start_tx_frame(segs, segs_num, frame);
+  if (err != ERR_OK) {
+    pbuf_free(frame);
+  }
+  return err;
+}
+
+/* runs in the tcpip thread for the whole measurement */
+static void
+bench_eth_tx_run_fn(void *arg)
+{
+  struct bench_eth_tx_state *state = (struct bench_eth_tx_state *)arg;
+  struct pbuf *hdr, *data;
+  u64_t start_us, end_us;
+
+  memset(&bench_eth_tx, 0, sizeof(bench_eth_tx));
+  ethernetif_tx_zerocopy_init(&bench_eth_tx.zc);
+
+  hdr = pbuf_alloc(PBUF_RAW, 54, PBUF_RAM);
+  data = pbuf_alloc(PBUF_RAW, 1460, PBUF_RAM);
+  if ((hdr == NULL) || (data == NULL)) {
+    if (hdr != NULL) {
+      pbuf_free(hdr);
+    }
+    if (data != NULL) {
+      pbuf_free(data);
+    }
+    state->error = 1;
+    return;
+  }
+  memset(hdr->payload, 0xAA, hdr->len);
+  memset(data->payload, 0x55, data->len);
+  pbuf_cat(hdr, data);
+  state->frame_len = hdr->tot_len;
+
+  start_us = bench_now_us();
+  end_us = start_us + (u64_t)state->config->duration_ms * 1000;
+  for (;;) {
+    err_t err = state->zerocopy ? bench_eth_linkoutput_zerocopy(hdr) : bench_eth_linkoutput_copy(hdr);
+
+    if (err != ERR_OK) {
+      state->error = 1;
+      break;
+    }
+    if (bench_eth_dma_step() != 0) {
+      /* what the TX task does when the interrupt asks for it */
+      ethernetif_tx_zerocopy_reclaim(&bench_eth_tx.zc);
+    }
+    state->frames++;
+    if (((state->frames & 1023) == 0) && (bench_now_us() >= end_us)) {
+      break;
+    }
+  }
+  ethernetif_tx_zerocopy_reclaim(&bench_eth_tx.zc);
+  state->elapsed_us = bench_now_us() - start_us;
+
+  if ((bench_eth_tx.sent_bytes != (u64_t)state->frames * state->frame_len) || (hdr->ref != 1) ||
+      (state->zerocopy && (bench_eth_tx.zc.framesZeroCopy != state->frames))) {
+    state->error = 1;
+  }
+  pbuf_free(hdr);
+}
+
+static int
+bench_eth_tx_run(const struct bench_config *config, const char *name, u8_t zerocopy)
+{
+  struct bench_eth_tx_state state;
+  double secs;
+
+  memset(&state, 0, sizeof(state));
+  state.config = config;
+  state.zerocopy = zerocopy;
+  bench_tcpip_call(bench_eth_tx_run_fn, &state);
+  if (state.error || (state.elapsed_us == 0)) {
+    return -1;
+  }
+
+  secs = (double)state.elapsed_us / 1000000.0;
+  printf("%-14s %lu frames of %lu bytes in %.2f s: %.0f frames/s, %.1f MB/s\n",
+         name, (unsigned long)state.frames, (unsigned long)state.frame_len, secs, state.frames / secs,
+         (double)state.frames * state.frame_len / secs / 1000000.0);
+  return 0;
+}
+
+int
+bench_eth_tx_copy(const struct bench_config *config)
+{
+  return bench_eth_tx_run(config, "eth-tx-copy", 0);
+}
+
+int
+bench_eth_tx_zerocopy(const struct bench_config *config)
+{
+  return bench_eth_tx_run(config, "eth-tx-zerocopy", 1);
+}
+
+/* ENET RX descriptor ring: the MAC fills descriptors with frames and raises
+ * the RX interrupt unless it is masked, the RX task drains it with
+ * ethernetif_rx_batch_poll() and unmasks the interrupt once it is empty. */
+struct bench_eth_rx_ring {
+  struct pbuf *bd[BENCH_ETH_RXBD_NUM];
+  u16_t produce;
+  u16_t consume;
+  u16_t used;
+  u8_t int_masked;
+  u32_t fetched;
+  u32_t nomem;
+  ethernetif_rx_batch_t rb;
+};
+
+static struct bench_eth_rx_ring bench_eth_rx;
+static struct netif bench_eth_rx_netif;
+
+static u32_t
+bench_eth_rx_clock(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (u32_t)ts.tv_sec * 1000000000U + (u32_t)ts.tv_nsec;
+}
+
+static err_t
+bench_eth_rx_linkoutput(struct netif *netif, struct pbuf *p)
+{
+  LWIP_UNUSED_ARG(netif);
+  LWIP_UNUSED_ARG(p);
+  return ERR_OK;
+}
+
+static err_t
+bench_eth_rx_netif_init(struct netif *netif)
+{
+  static const u8_t hwaddr[ETH_HWADDR_LEN] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x03};
+
+  netif->name[0] = 'r';
+  netif->name[1] = 'x';
+  netif->mtu = 1500;
+  netif->flags = NETIF_FLAG_BROADCAST | NETIF_FLAG_ETHARP | NETIF_FLAG_ETHERNET;
+  netif->hwaddr_len = ETH_HWADDR_LEN;
+  SMEMCPY(netif->hwaddr, hwaddr, ETH_HWADDR_LEN);
+  netif->linkoutput = bench_eth_rx_linkoutput;
+  return ERR_OK;
+}
+
+static void
+bench_eth_rx_netif_add_fn(void *arg)
+{
+  err_t *err = (err_t *)arg;
+
+  if (netif_add(&bench_eth_rx_netif, NULL, NULL, NULL, NULL, bench_eth_rx_netif_init, tcpip_input) == NULL) {
+    *err = ERR_IF;
+    return;
+  }
+  netif_set_up(&bench_eth_rx_netif);
+  netif_set_link_up(&bench_eth_rx_netif);
+  *err = ERR_OK;
+}
+
+static void
+bench_eth_rx_netif_remove_fn(void *arg)
+{
+  LWIP_UNUSED_ARG(arg);
+  netif_remove(&bench_eth_rx_netif);
+}
+
+/* The MAC receives 'num' frames for us, with a local experimental
+ * ethertype. A frame without a buffer is lost as on the wire. */
+static void
+bench_eth_rx_arrive(u16_t num)
+{
+  u16_t i;
+
+  for (i = 0; i < num; i++) {
+    struct pbuf *p;
+    struct eth_hdr *eth;
+
+    if (bench_eth_rx.used == BENCH_ETH_RXBD_NUM) {
+      bench_eth_rx.nomem++;
+      continue;
+    }
+    p = pbuf_alloc(PBUF_RAW, BENCH_ETH_RX_LEN, PBUF_POOL);
+    if (p == NULL) {
+      bench_eth_rx.nomem++;
+      continue;
+    }
+    memset(p->payload, 0, p->len);
+    eth = (struct eth_hdr *)p->payload;
+    SMEMCPY(&eth->dest, bench_eth_rx_netif.hwaddr, ETH_HWADDR_LEN);
+    eth->type = PP_HTONS(0x88B5);
+    bench_eth_rx.bd[bench_eth_rx.produce] = p;
+    bench_eth_rx.produce = (u16_t)((bench_eth_rx.produce + 1) % BENCH_ETH_RXBD_NUM);
+    bench_eth_rx.used++;
+  }
+
+  /* RX interrupt, the callback masks it */
+  if (!bench_eth_rx.int_masked && (bench_eth_rx.used > 0)) {
+    bench_eth_rx.int_masked = 1;
+    ethernetif_rx_batch_irq(&bench_eth_rx.rb);
+  }
+}
+
+/* ENET_GetRxFrame() */
+static struct pbuf *
+bench_eth_rx_fetch(struct netif *netif, u8_t *dropped)
+{
+  struct pbuf *p;
+
+  LWIP_UNUSED_ARG(netif);
+  LWIP_UNUSED_ARG(dropped);
+  if (bench_eth_rx.used == 0) {
+    return NULL;
+  }
+  p = bench_eth_rx.bd[bench_eth_rx.consume];
+  bench_eth_rx.consume = (u16_t)((bench_eth_rx.consume + 1) % BENCH_ETH_RXBD_NUM);
+  bench_eth_rx.used--;
+  bench_eth_rx.fetched++;
+  return p;
+}
+
+/* Totals of the RX batching statistics, which are read and reset every 256
+ * wakeups so that their 32 bit latency sum doesn't wrap */
+struct bench_eth_rx_totals {
+  u64_t frames;
+  u64_t batches;
+  u64_t dropped;
+  u64_t input_errors;
+  u64_t latency_sum;
+  u64_t latency_count;
+  u32_t latency_min;
+  u32_t latency_max;
+};
+
+static void
+bench_eth_rx_collect(struct bench_eth_rx_totals *totals)
+{
+  ethernetif_rx_batch_stats_t stats;
+
+  ethernetif_rx_batch_get_stats(&bench_eth_rx.rb, &stats, 1);
+  totals->frames += stats.frames;
+  totals->batches += stats.batches;
+  totals->dropped += stats.dropped;
+  totals->input_errors += stats.inputErrors;
+  totals->latency_sum += stats.latencySum;
+  totals->latency_count += stats.latencyCount;
+  if ((stats.latencyCount > 0) && (stats.latencyMin < totals->latency_min)) {
+    totals->latency_min = stats.latencyMin;
+  }
+  if (stats.latencyMax > totals->latency_max) {
+    totals->latency_max = stats.latencyMax;
+  }
+}
+
+static int
+bench_eth_rx_run(const struct bench_config *config, const char *name, u16_t burst, u16_t budget)
+{
+  struct bench_eth_rx_totals totals;
+  u64_t start_us, end_us, elapsed_us;
+  u32_t wakeups = 0;
+  err_t err = ERR_IF;
+  double secs;
+
+  memset(&bench_eth_rx, 0, sizeof(bench_eth_rx));
+  memset(&totals, 0, sizeof(totals));
+  totals.latency_min = 0xFFFFFFFFU;
+  ethernetif_rx_batch_init(&bench_eth_rx.rb, bench_eth_rx_clock);
+  bench_tcpip_call(bench_eth_rx_netif_add_fn, &err);
+  if (err != ERR_OK) {
+    return -1;
+  }
+
+  start_us = bench_now_us();
+  end_us = start_us + (u64_t)config->duration_ms * 1000;
+  for (;;) {
+    bench_eth_rx_arrive(burst);
+    /* what the RX task does per wakeup */
+    while (ethernetif_rx_batch_poll(&bench_eth_rx.rb, &bench_eth_rx_netif, bench_eth_rx_fetch, budget) == budget) {
+    }
+    bench_eth_rx.int_masked = 0;
+    if ((++wakeups & 255) == 0) {
+      bench_eth_rx_collect(&totals);
+      if (bench_now_us() >= end_us) {
+        break;
+      }
+    }
+  }
+  elapsed_us = bench_now_us() - start_us;
+
+  bench_tcpip_call(bench_eth_rx_netif_remove_fn, NULL);
+
+  /* every frame taken went to the stack, every wakeup emptied the ring */
+  if ((totals.frames != bench_eth_rx.fetched) || (totals.dropped != 0) || (bench_eth_rx.used != 0) ||
+      (totals.latency_count != wakeups) || (elapsed_us == 0)) {
+    return -1;
+  }
+
+  secs = (double)elapsed_us / 1000000.0;
+  printf("%-14s %lu frames in %.2f s: %.0f frames/s, %lu locks, %lu nomem, %lu input errors, latency min/avg/max %lu/%lu/%lu ns\n",
+         name, (unsigned long)totals.frames, secs, (double)totals.frames / secs, (unsigned long)totals.batches,
+         (unsigned long)bench_eth_rx.nomem, (unsigned long)totals.input_errors, (unsigned long)totals.latency_min,
+         (unsigned long)(totals.latency_sum / totals.latency_count), (unsigned long)totals.latency_max);
+  return 0;
+}
+
+int
+bench_eth_rx_frame(const struct bench_config *config)
+{
+  return bench_eth_rx_run(config, "eth-rx-frame", 1, 1);
+}
+
+int
+bench_eth_rx_batch(const struct bench_config *config)
+{
+  return bench_eth_rx_run(config, "eth-rx-batch", ETH_RX_BATCH_BUDGET, ETH_RX_BATCH_BUDGET);
+}
@@ -0,0 +1,438 @@
+/**
+ * @file
+ * httpsrv benchmarks: the server runs on the server end of the pipeif pair,
+ * socket clients on the client end fetch files from a static file table.
+ *
+ * - http-rate: new connection per request for a small page, N clients
+ * - http-latency: same request from a single client, latency distribution
+ * - http-bulk: large file, N clients, throughput
+ * - http-gzip: text page from a client accepting gzip, served the ".gz" variant
+ * - http-304: text page revalidated with If-None-Match, answered "Not Modified"
+ * - http-post: form posted to a CGI, the body sent 1 ms after the header
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lwip/opt.h"
+#include "lwip/sockets.h"
+#include "lwip/sys.h"
+
+#include "httpsrv.h"
+#include "httpsrv_fs.h"
+#include "FreeRTOS.h"
+
+#include "lwip_bench.h"
+
+#define BENCH_HTTP_PORT        80
+#define BENCH_HTTP_SMALL_SIZE  1024
+#define BENCH_HTTP_LARGE_SIZE  (256 * 1024)
+#define BENCH_HTTP_PAGE_SIZE   (16 * 1024)
+/* text typically compresses 4:1 */
+#define BENCH_HTTP_GZIP_SIZE   (BENCH_HTTP_PAGE_SIZE / 4)
+#define BENCH_HTTP_MAX_SAMPLES 200000
+#define BENCH_HTTP_MAX_CLIENTS 64
+#define BENCH_HTTP_RCVTIMEO_MS 2000
+/* fits the session buffer, the CGI reads it at once */
+#define BENCH_HTTP_POST_SIZE   1024
+
+static char bench_http_small_name[] = "/index.html";
+static char bench_http_large_name[] = "/large.bin";
+static char bench_http_page_name[] = "/page.html";
+static char bench_http_gzip_name[] = "/page.html.gz";
+static HTTPSRV_FS_DIR_ENTRY bench_http_fs[5];
+static uint32_t bench_http_server;
+static char bench_http_gzip_headers[] = "Accept-Encoding: gzip, deflate\r\n";
+static char bench_http_304_headers[32];
+static char bench_http_post_name[] = "/post.cgi";
+static char bench_http_post_body[BENCH_HTTP_POST_SIZE];
+static char bench_http_post_headers[64];
+
+struct bench_http_client {
+  const char *path;
+  /* extra request header fields */
+  const char *headers;
+  /* expected status code, e.g. "200" */
+  const char *status;
+  /* POST request body, NULL for GET */
+  const char *body;
+  u64_t deadline_us;
+  sys_sem_t done;
+  struct bench_latency latency;
+  u64_t bytes;
+  u32_t requests;
+  u32_t errors;
+};
+
+struct bench_http_result {
+  u32_t requests;
+  u32_t errors;
+  u64_t bytes;
+  u32_t elapsed_ms;
+  struct bench_latency latency;
+};
+
+static unsigned char *
+bench_http_file(const char *header, size_t size)
+{
+  unsigned char *data = (unsigned char *)malloc(size);
+  size_t i, len = strlen(header);
+
+  if (data != NULL) {
+    for (i = 0; i < size; i++) {
+      data[i] = (unsigned char)('a' + (i % 26));
+    }
+    memcpy(data, header, LWIP_MIN(len, size));
+  }
+  return data;
+}
+
+/** CGI of http-post: answers 200 if it got the whole form in one read, 400 otherwise */
+static int
+bench_http_post_cgi(HTTPSRV_CGI_REQ_STRUCT *param)
+{
+  static char body[BENCH_HTTP_POST_SIZE];
+  static char ok[] = "ok\n";
+  HTTPSRV_CGI_RES_STRUCT response;
+  uint32_t read = 0;
+
+  if ((param->request_method == HTTPSRV_REQ_POST) && (param->content_length == sizeof(body))) {
+    read = HTTPSRV_cgi_read(param->ses_handle, body, sizeof(body));
+  }
+  memset(&response, 0, sizeof(response));
+  response.ses_handle = param->ses_handle;
+  response.content_type = HTTPSRV_CONTENT_TYPE_PLAIN;
+  response.status_code = ((read == sizeof(body)) && (memcmp(body, bench_http_post_body, sizeof(body)) == 0)) ?
+                         HTTPSRV_CODE_OK : HTTPSRV_CODE_BAD_REQ;
+  response.data = ok;
+  response.data_length = sizeof(ok) - 1;
+  response.content_length = (int32_t)response.data_length;
+  HTTPSRV_cgi_write(&response);
+  return response.content_length;
+}
+
+static char bench_http_post_cgi_name[] = "post";
+static const HTTPSRV_CGI_LINK_STRUCT bench_http_cgi[] = {
+  { bench_http_post_cgi_name, bench_http_post_cgi },
+  { NULL, NULL }
+};
+
+/* started once, shared by all HTTP benchmarks */
+/** Undo the file table setup of bench_http_server_start() */
+static void
+bench_http_files_free(void)
+{
+  int i;
+
+  for (i = 3; i >= 0; i--) {
+    free(bench_http_fs[i].DATA);
+    bench_http_fs[i].DATA = NULL;
+  }
+}
+
+static int
+bench_http_server_start(u32_t max_sessions)
+{
+  HTTPSRV_PARAM_STRUCT params;
+  struct sockaddr_in *addr;
+  int i;
+
+  if (bench_http_server != 0) {
+    return 0;
+  }
+
+  bench_http_fs[0].NAME = bench_http_small_name;
+  bench_http_fs[0].DATA = bench_http_file("<html><body>lwip_bench</body></html>\n", BENCH_HTTP_SMALL_SIZE);
+  bench_http_fs[0].SIZE = BENCH_HTTP_SMALL_SIZE;
+  bench_http_fs[1].NAME = bench_http_large_name;
+  bench_http_fs[1].DATA = bench_http_file("", BENCH_HTTP_LARGE_SIZE);
+  bench_http_fs[1].SIZE = BENCH_HTTP_LARGE_SIZE;
+  bench_http_fs[2].NAME = bench_http_page_name;
+  bench_http_fs[2].DATA = bench_http_file("<html><body>lwip_bench page</body></html>\n", BENCH_HTTP_PAGE_SIZE);
+  bench_http_fs[2].SIZE = BENCH_HTTP_PAGE_SIZE;
+  /* the clients do not decode the body, only the size of the variant matters */
+  bench_http_fs[3].NAME = bench_http_gzip_name;
+  bench_http_fs[3].DATA = bench_http_file("\x1f\x8b", BENCH_HTTP_GZIP_SIZE);
+  bench_http_fs[3].SIZE = BENCH_HTTP_GZIP_SIZE;
+  for (i = 0; i < 4; i++) {
+    if (bench_http_fs[i].DATA == NULL) {
+      bench_http_files_free();
+      return -1;
+    }
+    bench_http_fs[i].ETAG = HTTPSRV_FS_etag(bench_http_fs[i].DATA, bench_http_fs[i].SIZE);
+  }
+  HTTPSRV_FS_init(bench_http_fs);
+  snprintf(bench_http_304_headers, sizeof(bench_http_304_headers), "If-None-Match: \"%08lx\"\r\n",
+           (unsigned long)bench_http_fs[2].ETAG);
+  for (i = 0; i < BENCH_HTTP_POST_SIZE; i++) {
+    bench_http_post_body[i] = (char)('a' + (i * 7) % 26);
+  }
+  snprintf(bench_http_post_headers, sizeof(bench_http_post_headers),
+           "Content-Type: text/plain\r\nContent-Length: %d\r\n", BENCH_HTTP_POST_SIZE);
+
+  memset(&params, 0, sizeof(params));
+  addr = (struct sockaddr_in *)&params.address;
+  addr->sin_family = AF_INET;
+  addr->sin_port = PP_HTONS(BENCH_HTTP_PORT);
+  inet_addr_from_ip4addr(&addr->sin_addr, &bench_server_ip);
+  params.root_dir = "";
+  params.index_page = bench_http_small_name;
+  params.max_ses = max_sessions;
+  params.cgi_lnk_tbl = bench_http_cgi;
+
+  bench_http_server = HTTPSRV_init(&params);
+  if (bench_http_server == 0) {
+    bench_http_files_free();
+    return -1;
+  }
+  return 0;
+}
+
+/** Fetch one file over a new connection, returns the bytes received or -1 */
+static long
+bench_http_get(const struct bench_http_client *client, char *buf, size_t buf_size)
+{
+  struct sockaddr_in local, remote;
+  struct timeval timeout;
+  long total = 0;
+  int sock, len, ok;
+
+  sock = lwip_socket(AF_INET, SOCK_STREAM, 0);
+  if (sock < 0) {
+    return -1;
+  }
+  timeout.tv_sec = BENCH_HTTP_RCVTIMEO_MS / 1000;
+  timeout.tv_usec = (BENCH_HTTP_RCVTIMEO_MS % 1000) * 1000;
+  lwip_setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+  /* bind to the client end so that the connection crosses the wire */
+  memset(&local, 0, sizeof(local));
+  local.sin_family = AF_INET;
+  inet_addr_from_ip4addr(&local.sin_addr, &bench_client_ip);
+  memset(&remote, 0, sizeof(remote));
+  remote.sin_family = AF_INET;
+  remote.sin_port = PP_HTONS(BENCH_HTTP_PORT);
+  inet_addr_from_ip4addr(&remote.sin_addr, &bench_server_ip);
+
+  ok = (lwip_bind(sock, (struct sockaddr *)&local, sizeof(local)) == 0) &&
+       (lwip_connect(sock, (struct sockaddr *)&remote, sizeof(remote)) == 0);
+  if (ok) {
+    /* httpsrv rejects requests without a Host field */
+    len = snprintf(buf, buf_size, "%s %s HTTP/1.0\r\nHost: %s\r\n%s\r\n", (client->body != NULL) ? "POST" : "GET",
+                   client->path, ip4addr_ntoa(&bench_server_ip), client->headers);
+    ok = (lwip_send(sock, buf, (size_t)len, 0) == len);
+  }
+  if (ok && (client->body != NULL)) {
+    int one = 1;
+
+    /* the server sees the header first and has to wait for the body, which Nagle must not hold back */
+    lwip_setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    sys_msleep(1);
+    ok = (lwip_send(sock, client->body, BENCH_HTTP_POST_SIZE, 0) == BENCH_HTTP_POST_SIZE);
+  }
+  while (ok) {
+    len = lwip_recv(sock, buf + ((total == 0) ? 0 : 16), buf_size - 16, 0);
+    if (len < 0) {
+      ok = 0;
+    } else if (len == 0) {
+      break;
+    } else {
+      /* "HTTP/1.x 200" */
+      if ((total == 0) && ((len < 12) || (strncmp(buf, "HTTP/1.", 7) != 0) || (strncmp(buf + 9, client->status, 3) != 0))) {
+        ok = 0;
+      }
+      total += len;
+    }
+  }
+  lwip_close(sock);
+  return (ok && (total > 0)) ? total : -1;
+}
+
+static void
+bench_http_client_thread(void *arg)
+{
+  struct bench_http_client *client = (struct bench_http_client *)arg;
+  char buf[1536];
+
+  while (bench_now_us() < client->deadline_us) {
+    u64_t start = bench_now_us();
+    long n = bench_http_get(client, buf, sizeof(buf));
+    if (bench_now_us() > client->deadline_us) {
+      /* the clock stops at the deadline, a request still running then is not counted */
+      break;
+    }
+    if (n < 0) {
+      client->errors++;
+    } else {
+      client->requests++;
+      client->bytes += (u64_t)n;
+      bench_latency_add(&client->latency, (u32_t)(bench_now_us() - start));
+    }
+  }
+  sys_sem_signal(&client->done);
+}
+
+/** Run clients fetching path for the configured duration and merge their results */
+static int
+bench_http_run(const struct bench_config *config, const char *path, const char *headers,
+               const char *body, const char *status, u32_t num_clients, struct bench_http_result *result)
+{
+  struct bench_http_client clients[BENCH_HTTP_MAX_CLIENTS];
+  u64_t start;
+  u32_t i, started;
+
+  num_clients = LWIP_MIN(num_clients, BENCH_HTTP_MAX_CLIENTS);
+  memset(result, 0, sizeof(*result));
+  /* A session may still be closing when its client connects again. Twice
+   * the sessions, and so twice the listen backlog (max_ses in task mode),
+   * keep the server from dropping a SYN and stalling that client for the
+   * 3 s SYN retransmission. */
+  if ((bench_http_server_start(2 * config->clients) != 0) ||
+      (bench_latency_init(&result->latency, BENCH_HTTP_MAX_SAMPLES) != 0)) {
+    return -1;
+  }
+
+  start = bench_now_us();
+  for (i = 0; i < num_clients; i++) {
+    memset(&clients[i], 0, sizeof(clients[i]));
+    clients[i].path = path;
+    clients[i].headers = headers;
+    clients[i].body = body;
+    clients[i].status = status;
+    clients[i].deadline_us = start + (u64_t)config->duration_ms * 1000;
+    /* one semaphore each: sys_sem_t is binary on the unix port */
+    if (sys_sem_new(&clients[i].done, 0) != ERR_OK) {
+      break;
+    }
+    if (bench_latency_init(&clients[i].latency, BENCH_HTTP_MAX_SAMPLES / num_clients) != 0) {
+      sys_sem_free(&clients[i].done);
+      break;
+    }
+    sys_thread_new("bench_http_client", bench_http_client_thread, &clients[i],
+                   DEFAULT_THREAD_STACKSIZE, DEFAULT_THREAD_PRIO);
+  }
+  started = i;
+  /* the clients started so far use the stack above, wait for them even if setup failed */
+  for (i = 0; i < started; i++) {
+    sys_sem_wait(&clients[i].done);
+  }
+  /* the clients count what completed by the deadline */
+  result->elapsed_ms = config->duration_ms;
+
+  for (i = started; i-- > 0;) {
+    sys_sem_free(&clients[i].done);
+    result->requests += clients[i].requests;
+    result->errors += clients[i].errors;
+    result->bytes += clients[i].bytes;
+    bench_latency_merge(&result->latency, &clients[i].latency);
+    bench_latency_free(&clients[i].latency);
+  }
+  return ((started == num_clients) && (result->requests > 0)) ? 0 : -1;
+}
+
+int
+bench_http_rate(const struct bench_config *config)
+{
+  struct bench_http_result r;
+  int ret = bench_http_run(config, bench_http_small_name, "", NULL, "200", config->clients, &r);
+
+  if (ret == 0) {
+    printf("%-14s %lu requests, %lu errors, %lu clients: %.1f connections/s\n", "http-rate",
+           (unsigned long)r.requests, (unsigned long)r.errors, (unsigned long)config->clients,
+           r.requests * 1000.0 / LWIP_MAX(r.elapsed_ms, 1));
+    bench_latency_report("http-rate", &r.latency);
+  }
+  bench_latency_free(&r.latency);
+  return ret;
+}
+
+int
+bench_http_latency(const struct bench_config *config)
+{
+  struct bench_http_result r;
+  int ret = bench_http_run(config, bench_http_small_name, "", NULL, "200", 1, &r);
+
+  if (ret == 0) {
+    printf("%-14s %lu requests, %lu errors\n", "http-latency",
+           (unsigned long)r.requests, (unsigned long)r.errors);
+    bench_latency_report("http-latency", &r.latency);
+  }
+  bench_latency_free(&r.latency);
+  return ret;
+}
+
+int
+bench_http_bulk(const struct bench_config *config)
+{
+  struct bench_http_result r;
+  int ret = bench_http_run(config, bench_http_large_name, "", NULL, "200", config->clients, &r);
+
+  if (ret == 0) {
+    printf("%-14s %lu files, %lu errors, %lu clients: %.1f Mbit/s\n", "http-bulk",
+           (unsigned long)r.requests, (unsigned long)r.errors, (unsigned long)config->clients,
+           (double)r.bytes * 8.0 / 1000.0 / LWIP_MAX(r.elapsed_ms, 1));
+  }
+  bench_latency_free(&r.latency);
+  return ret;
+}
+
+int
+bench_http_gzip(const struct bench_config *config)
+{
+  struct bench_http_result r;
+  int ret = bench_http_run(config, bench_http_page_name, bench_http_gzip_headers, NULL, "200", config->clients, &r);
+
+  if (ret == 0) {
+    printf("%-14s %lu requests, %lu errors, %lu clients: %.1f requests/s, %.1f bytes/request\n", "http-gzip",
+           (unsigned long)r.requests, (unsigned long)r.errors, (unsigned long)config->clients,
+           r.requests * 1000.0 / LWIP_MAX(r.elapsed_ms, 1), (double)r.bytes / r.requests);
+    bench_latency_report("http-gzip", &r.latency);
+  }
+  bench_latency_free(&r.latency);
+  return ret;
+}
+
+int
+bench_http_304(const struct bench_config *config)
+{
+  struct bench_http_result r;
+  /* filled in with the ETag of the page when the server starts */
+  int ret = bench_http_run(config, bench_http_page_name, bench_http_304_headers, NULL, "304", config->clients, &r);
+
+  if (ret == 0) {
+    printf("%-14s %lu requests, %lu errors, %lu clients: %.1f requests/s, %.1f bytes/request\n", "http-304",
+           (unsigned long)r.requests, (unsigned long)r.errors, (unsigned long)config->clients,
+           r.requests * 1000.0 / LWIP_MAX(r.elapsed_ms, 1), (double)r.bytes / r.requests);
+    bench_latency_report("http-304", &r.latency);
+  }
+  bench_latency_free(&r.latency);
+  return ret;
+}
+
+int
+bench_http_post(const struct bench_config *config)
+{
+  struct bench_http_result r;
+  void *probe = pvPortMalloc(1);
+  int ret;
+
+  /* the CGI gets the session as a uint32_t handle */
+  vPortFree(probe);
+  if ((uintptr_t)probe > UINT32_MAX) {
+    printf("%-14s skipped, needs the httpsrv heap below 4 GiB\n", "http-post");
+    return 0;
+  }
+  /* headers and body are filled in when the server starts */
+  ret = bench_http_run(config, bench_http_post_name, bench_http_post_headers, bench_http_post_body, "200",
+                       config->clients, &r);
+  if (ret == 0) {
+    printf("%-14s %lu requests, %lu errors, %lu clients: %.1f requests/s\n", "http-post",
+           (unsigned long)r.requests, (unsigned long)r.errors, (unsigned long)config->clients,
+           r.requests * 1000.0 / LWIP_MAX(r.elapsed_ms, 1));
+    bench_latency_report("http-post", &r.latency);
+  }
+  bench_latency_free(&r.latency);
+  return ret;
+}
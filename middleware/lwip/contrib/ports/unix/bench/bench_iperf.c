@@ -0,0 +1,121 @@
+/**
+ * @file
+ * TCP throughput across the pipeif pair, measured with lwiperf on both ends.
+ */
+
+#include "lwip/opt.h"
+#include "lwip/apps/lwiperf.h"
+#include "lwip/sys.h"
+
+#include "lwip_bench.h"
+
+#include <stdio.h>
+#include <string.h>
+
+struct bench_iperf_state {
+  const struct bench_config *config;
+  void *server;
+  void *client;
+  sys_sem_t done;
+  u64_t server_bytes;
+  u32_t server_ms;
+  u32_t client_kbps;
+  u32_t server_kbps;
+  int reports;
+  int error;
+};
+
+/* called from the tcpip thread */
+static void
+bench_iperf_report(void *arg, enum lwiperf_report_type report_type,
+                   const ip_addr_t *local_addr, u16_t local_port,
+                   const ip_addr_t *remote_addr, u16_t remote_port,
+                   u64_t bytes_transferred, u32_t ms_duration, u32_t bandwidth_kbitpsec)
+{
+  struct bench_iperf_state *state = (struct bench_iperf_state *)arg;
+
+  LWIP_UNUSED_ARG(local_addr);
+  LWIP_UNUSED_ARG(local_port);
+  LWIP_UNUSED_ARG(remote_addr);
+  LWIP_UNUSED_ARG(remote_port);
+
+  switch (report_type) {
+    case LWIPERF_TCP_DONE_SERVER_RX:
+      state->server_bytes = bytes_transferred;
+      state->server_ms = ms_duration;
+      state->server_kbps = bandwidth_kbitpsec;
+      break;
+    case LWIPERF_TCP_DONE_CLIENT_TX:
+      state->client_kbps = bandwidth_kbitpsec;
+      break;
+    case LWIPERF_TCP_ABORTED_LOCAL:
+      /* from lwiperf_abort() at the end of the test, or a timeout anyway */
+      return;
+    default:
+      state->error = 1;
+      break;
+  }
+  /* sys_sem_t is binary on the unix port: wake the waiter once, after both reports */
+  if (++state->reports == 2) {
+    sys_sem_signal(&state->done);
+  }
+}
+
+/* called from the tcpip thread */
+static void
+bench_iperf_start(void *arg)
+{
+  struct bench_iperf_state *state = (struct bench_iperf_state *)arg;
+  ip_addr_t server_addr;
+
+  ip_addr_copy_from_ip4(server_addr, bench_server_ip);
+  state->server = lwiperf_start_tcp_server(&server_addr, LWIPERF_TCP_PORT_DEFAULT,
+                                           bench_iperf_report, state);
+  /* a negative amount is the test time in units of 10 ms */
+  state->client = lwiperf_start_tcp_client(&server_addr, LWIPERF_TCP_PORT_DEFAULT, LWIPERF_CLIENT,
+                                           -(int)(state->config->duration_ms / 10), 0, LWIPERF_TOS_DEFAULT,
+                                           bench_iperf_report, state);
+}
+
+/* called from the tcpip thread, lwiperf_abort() ignores sessions that already ended */
+static void
+bench_iperf_stop(void *arg)
+{
+  struct bench_iperf_state *state = (struct bench_iperf_state *)arg;
+
+  if (state->client != NULL) {
+    lwiperf_abort(state->client);
+  }
+  if (state->server != NULL) {
+    lwiperf_abort(state->server);
+  }
+}
+
+/** One lwiperf client sending to one lwiperf server for the configured time */
+int
+bench_iperf(const struct bench_config *config)
+{
+  struct bench_iperf_state state;
+
+  memset(&state, 0, sizeof(state));
+  state.config = config;
+  if (sys_sem_new(&state.done, 0) != ERR_OK) {
+    return -1;
+  }
+
+  bench_tcpip_call(bench_iperf_start, &state);
+  if ((state.server == NULL) || (state.client == NULL) ||
+      (sys_arch_sem_wait(&state.done, config->duration_ms + 10000) == SYS_ARCH_TIMEOUT)) {
+    state.error = 1;
+  }
+  bench_tcpip_call(bench_iperf_stop, &state);
+  sys_sem_free(&state.done);
+
+  if (state.error) {
+    return -1;
+  }
+  printf("%-14s %lu bytes in %lu ms: %.1f Mbit/s (client %.1f Mbit/s)\n", "iperf",
+         (unsigned long)state.server_bytes, (unsigned long)state.server_ms,
+         state.server_kbps / 1000.0, state.client_kbps / 1000.0);
+  return 0;
+}
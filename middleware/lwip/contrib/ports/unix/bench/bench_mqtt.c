@@ -0,0 +1,509 @@
+/**
+ * @file
+ * MQTT client benchmarks: the lwIP MQTT client on the client end of the pipeif
+ * pair publishes as fast as it can to a broker stand-in on the server end. The
+ * stand-in is a raw TCP server that answers CONNECT, PUBLISH, PUBREL and PINGREQ
+ * and counts the publishes it received; it does not route messages anywhere.
+ *
+ * - mqtt-qos0: 32 byte QoS 0 publishes without callback, copied, one at a time
+ * - mqtt-batch: same, queued in batches with mqtt_batch_begin()/mqtt_batch_end()
+ * - mqtt-qos1: 32 byte QoS 1 publishes in batches, window MQTT_REQ_MAX_IN_FLIGHT
+ * - mqtt-copy-1k: 1 KiB QoS 0 publishes in batches with mqtt_publish()
+ * - mqtt-zc-1k: same with mqtt_publish_pbuf(), payload referenced by TCP
+ *
+ * QoS 0 publishes are refilled whenever the broker received data, QoS 1
+ * publishes when half of the window was acknowledged.
+ */
+
+#include "lwip/opt.h"
+#include "lwip/apps/mqtt.h"
+#include "lwip/pbuf.h"
+#include "lwip/sys.h"
+#include "lwip/tcp.h"
+
+#include "lwip_bench.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define BENCH_MQTT_PORT      LWIP_IANA_PORT_MQTT
+#define BENCH_MQTT_TOPIC     "bench/data"
+#define BENCH_MQTT_SMALL     32
+#define BENCH_MQTT_LARGE     1024
+
+struct bench_mqtt_mode {
+  const char *name;
+  u16_t payload_len;
+  u8_t qos;
+  u8_t batch;
+  u8_t nocopy;
+};
+
+/* broker stand-in input parser states */
+enum bench_mqtt_rx_state {
+  BENCH_MQTT_RX_TYPE,
+  BENCH_MQTT_RX_LENGTH,
+  BENCH_MQTT_RX_TOPIC_LEN,
+  BENCH_MQTT_RX_TOPIC,
+  BENCH_MQTT_RX_PKT_ID,
+  BENCH_MQTT_RX_SKIP
+};
+
+struct bench_mqtt_state {
+  const struct bench_config *config;
+  const struct bench_mqtt_mode *mode;
+  sys_sem_t done;
+  /* client end */
+  mqtt_client_t *client;
+  struct pbuf *payload;
+  u64_t start_us;
+  u64_t end_us;
+  /* last message received by the broker */
+  u64_t last_us;
+  u32_t published;
+  u32_t completed;
+  u8_t running;
+  u8_t signalled;
+  int error;
+  /* broker end */
+  struct tcp_pcb *listen_pcb;
+  struct tcp_pcb *broker_pcb;
+  enum bench_mqtt_rx_state rx_state;
+  u8_t rx_type;
+  u8_t rx_shift;
+  u8_t rx_collected;
+  u32_t rx_remaining;
+  u32_t rx_skip;
+  u16_t rx_value;
+  u32_t received;
+  u8_t reply[256];
+  u16_t reply_len;
+};
+
+static const struct bench_mqtt_mode bench_mqtt_modes[] = {
+  { "mqtt-qos0",    BENCH_MQTT_SMALL, 0, 0, 0 },
+  { "mqtt-batch",   BENCH_MQTT_SMALL, 0, 1, 0 },
+  { "mqtt-qos1",    BENCH_MQTT_SMALL, 1, 1, 0 },
+  { "mqtt-copy-1k", BENCH_MQTT_LARGE, 0, 1, 0 },
+  { "mqtt-zc-1k",   BENCH_MQTT_LARGE, 0, 1, 1 },
+};
+
+/* called from the tcpip thread */
+static void
+bench_mqtt_signal(struct bench_mqtt_state *state)
+{
+  /* sys_sem_t is binary on the unix port: wake the waiter once */
+  if (!state->signalled) {
+    state->signalled = 1;
+    sys_sem_signal(&state->done);
+  }
+}
+
+/* called from the tcpip thread: done once the broker got everything after the deadline */
+static void
+bench_mqtt_check_done(struct bench_mqtt_state *state)
+{
+  if ((state->end_us != 0) && !state->running && (state->received == state->published) &&
+      ((state->mode->qos == 0) || (state->completed == state->published))) {
+    bench_mqtt_signal(state);
+  }
+}
+
+static void bench_mqtt_pump(struct bench_mqtt_state *state);
+
+/* ---------- broker stand-in ---------- */
+
+static void
+bench_mqtt_broker_flush(struct bench_mqtt_state *state)
+{
+  if ((state->reply_len > 0) &&
+      (tcp_write(state->broker_pcb, state->reply, state->reply_len, TCP_WRITE_FLAG_COPY) != ERR_OK)) {
+    state->error = 1;
+  }
+  state->reply_len = 0;
+}
+
+/* replies of one receive are written to TCP together */
+static void
+bench_mqtt_broker_reply(struct bench_mqtt_state *state, u8_t type, u16_t pkt_id)
+{
+  u8_t *msg;
+
+  if (state->reply_len + 4 > (int)sizeof(state->reply)) {
+    bench_mqtt_broker_flush(state);
+  }
+  msg = &state->reply[state->reply_len];
+  msg[0] = type;
+  if (type == 0xd0) {
+    /* PINGRESP */
+    msg[1] = 0;
+    state->reply_len += 2;
+    return;
+  }
+  msg[1] = 2;
+  msg[2] = (u8_t)(pkt_id >> 8);
+  msg[3] = (u8_t)pkt_id;
+  state->reply_len += 4;
+}
+
+/* a complete fixed header was received */
+static void
+bench_mqtt_broker_header(struct bench_mqtt_state *state)
+{
+  u8_t type = state->rx_type >> 4;
+
+  state->rx_state = BENCH_MQTT_RX_SKIP;
+  state->rx_skip = state->rx_remaining;
+  if (type == 1) {
+    /* CONNECT, answered with CONNACK: session present 0, accepted */
+    bench_mqtt_broker_reply(state, 0x20, 0);
+  } else if (type == 3) {
+    /* PUBLISH */
+    state->received++;
+    state->last_us = bench_now_us();
+    if ((state->rx_type & 0x06) != 0) {
+      state->rx_state = BENCH_MQTT_RX_TOPIC_LEN;
+    }
+  } else if (type == 6) {
+    /* PUBREL */
+    state->rx_state = BENCH_MQTT_RX_PKT_ID;
+  } else if (type == 12) {
+    bench_mqtt_broker_reply(state, 0xd0, 0);
+  }
+  state->rx_collected = 0;
+  state->rx_value = 0;
+}
+
+static void
+bench_mqtt_broker_parse(struct bench_mqtt_state *state, struct pbuf *p)
+{
+  u16_t offset = 0;
+
+  while (offset < p->tot_len) {
+    u8_t b;
+
+    if ((state->rx_state == BENCH_MQTT_RX_SKIP) || (state->rx_state == BENCH_MQTT_RX_TOPIC)) {
+      /* skip payload and topic in bulk */
+      u32_t n = LWIP_MIN(state->rx_skip, (u32_t)(p->tot_len - offset));
+      offset = (u16_t)(offset + n);
+      state->rx_skip -= n;
+      state->rx_remaining -= n;
+      if (state->rx_skip == 0) {
+        if (state->rx_state == BENCH_MQTT_RX_TOPIC) {
+          state->rx_state = BENCH_MQTT_RX_PKT_ID;
+        } else {
+          state->rx_state = BENCH_MQTT_RX_TYPE;
+        }
+      }
+      continue;
+    }
+
+    b = pbuf_get_at(p, offset++);
+    switch (state->rx_state) {
+      case BENCH_MQTT_RX_TYPE:
+        state->rx_type = b;
+        state->rx_remaining = 0;
+        state->rx_shift = 0;
+        state->rx_state = BENCH_MQTT_RX_LENGTH;
+        break;
+      case BENCH_MQTT_RX_LENGTH:
+        state->rx_remaining |= (u32_t)(b & 0x7f) << state->rx_shift;
+        state->rx_shift = (u8_t)(state->rx_shift + 7);
+        if ((b & 0x80) == 0) {
+          bench_mqtt_broker_header(state);
+        }
+        break;
+      case BENCH_MQTT_RX_TOPIC_LEN:
+      case BENCH_MQTT_RX_PKT_ID:
+        state->rx_value = (u16_t)((state->rx_value << 8) | b);
+        state->rx_remaining--;
+        if (++state->rx_collected == 2) {
+          state->rx_collected = 0;
+          if (state->rx_state == BENCH_MQTT_RX_TOPIC_LEN) {
+            state->rx_state = BENCH_MQTT_RX_TOPIC;
+            state->rx_skip = state->rx_value;
+          } else {
+            /* PUBACK for QoS 1, PUBREC for QoS 2, PUBCOMP for PUBREL */
+            u8_t type = state->rx_type >> 4;
+            u8_t reply = (type == 6) ? 0x70 : (((state->rx_type & 0x06) == 0x02) ? 0x40 : 0x50);
+            bench_mqtt_broker_reply(state, reply, state->rx_value);
+            state->rx_state = BENCH_MQTT_RX_SKIP;
+            state->rx_skip = state->rx_remaining;
+          }
+          state->rx_value = 0;
+        }
+        break;
+      default:
+        break;
+    }
+    /* messages without variable header end right after the fixed header */
+    if ((state->rx_state == BENCH_MQTT_RX_SKIP) && (state->rx_skip == 0)) {
+      state->rx_state = BENCH_MQTT_RX_TYPE;
+    }
+  }
+}
+
+static err_t
+bench_mqtt_broker_recv(void *arg, struct tcp_pcb *pcb, struct pbuf *p, err_t err)
+{
+  struct bench_mqtt_state *state = (struct bench_mqtt_state *)arg;
+
+  LWIP_UNUSED_ARG(err);
+  if (p == NULL) {
+    tcp_arg(pcb, NULL);
+    tcp_recv(pcb, NULL);
+    if (tcp_close(pcb) != ERR_OK) {
+      tcp_abort(pcb);
+      state->broker_pcb = NULL;
+      return ERR_ABRT;
+    }
+    state->broker_pcb = NULL;
+    return ERR_OK;
+  }
+  bench_mqtt_broker_parse(state, p);
+  bench_mqtt_broker_flush(state);
+  tcp_recved(pcb, p->tot_len);
+  pbuf_free(p);
+  tcp_output(pcb);
+  if (state->mode->qos == 0) {
+    bench_mqtt_pump(state);
+  } else {
+    bench_mqtt_check_done(state);
+  }
+  return ERR_OK;
+}
+
+static void
+bench_mqtt_broker_err(void *arg, err_t err)
+{
+  struct bench_mqtt_state *state = (struct bench_mqtt_state *)arg;
+
+  LWIP_UNUSED_ARG(err);
+  if (state != NULL) {
+    state->broker_pcb = NULL;
+  }
+}
+
+static err_t
+bench_mqtt_broker_accept(void *arg, struct tcp_pcb *pcb, err_t err)
+{
+  struct bench_mqtt_state *state = (struct bench_mqtt_state *)arg;
+
+  if ((err != ERR_OK) || (pcb == NULL) || (state->broker_pcb != NULL)) {
+    return ERR_VAL;
+  }
+  state->broker_pcb = pcb;
+  state->rx_state = BENCH_MQTT_RX_TYPE;
+  tcp_nagle_disable(pcb);
+  tcp_arg(pcb, state);
+  tcp_recv(pcb, bench_mqtt_broker_recv);
+  tcp_err(pcb, bench_mqtt_broker_err);
+  return ERR_OK;
+}
+
+/* ---------- client ---------- */
+
+/* called from the tcpip thread when a publish completed */
+static void
+bench_mqtt_published(void *arg, err_t err)
+{
+  struct bench_mqtt_state *state = (struct bench_mqtt_state *)arg;
+
+  if (err != ERR_OK) {
+    state->error = 1;
+  }
+  state->completed++;
+  /* refill when half of the window is free, so batches have something to combine */
+  if (state->published - state->completed <= MQTT_REQ_MAX_IN_FLIGHT / 2) {
+    bench_mqtt_pump(state);
+  }
+}
+
+/* publish until the client runs out of requests or buffers */
+static void
+bench_mqtt_pump(struct bench_mqtt_state *state)
+{
+  const struct bench_mqtt_mode *mode = state->mode;
+  err_t err;
+
+  if (state->running && (bench_now_us() >= state->end_us)) {
+    state->running = 0;
+  }
+  if (!state->running) {
+    bench_mqtt_check_done(state);
+    return;
+  }
+  if (mode->batch) {
+    mqtt_batch_begin(state->client);
+  }
+  do {
+    if (mode->nocopy) {
+      err = mqtt_publish_pbuf(state->client, BENCH_MQTT_TOPIC, state->payload, mode->qos, 0,
+                              (mode->qos > 0) ? bench_mqtt_published : NULL, state);
+    } else {
+      err = mqtt_publish(state->client, BENCH_MQTT_TOPIC, state->payload->payload, state->payload->len,
+                         mode->qos, 0, (mode->qos > 0) ? bench_mqtt_published : NULL, state);
+    }
+    if (err == ERR_OK) {
+      state->published++;
+    }
+  } while (err == ERR_OK);
+  if (mode->batch) {
+    mqtt_batch_end(state->client);
+  }
+  if (err != ERR_MEM) {
+    state->error = 1;
+    state->running = 0;
+    bench_mqtt_signal(state);
+  }
+}
+
+static void
+bench_mqtt_connection(mqtt_client_t *client, void *arg, mqtt_connection_status_t status)
+{
+  struct bench_mqtt_state *state = (struct bench_mqtt_state *)arg;
+
+  LWIP_UNUSED_ARG(client);
+  if (status != MQTT_CONNECT_ACCEPTED) {
+    /* also called when the broker goes away during the test */
+    if (state->running || (state->published == 0)) {
+      state->error = 1;
+      state->running = 0;
+      bench_mqtt_signal(state);
+    }
+    return;
+  }
+  state->start_us = bench_now_us();
+  state->end_us = state->start_us + (u64_t)state->config->duration_ms * 1000;
+  state->running = 1;
+  bench_mqtt_pump(state);
+}
+
+/* called from the tcpip thread */
+static void
+bench_mqtt_start(void *arg)
+{
+  struct bench_mqtt_state *state = (struct bench_mqtt_state *)arg;
+  struct mqtt_connect_client_info_t info;
+  struct tcp_pcb *pcb;
+  ip_addr_t server_addr;
+
+  ip_addr_copy_from_ip4(server_addr, bench_server_ip);
+  pcb = tcp_new_ip_type(IPADDR_TYPE_V4);
+  if ((pcb == NULL) || (tcp_bind(pcb, &server_addr, BENCH_MQTT_PORT) != ERR_OK)) {
+    if (pcb != NULL) {
+      tcp_close(pcb);
+    }
+    state->error = 1;
+    return;
+  }
+  state->listen_pcb = tcp_listen(pcb);
+  if (state->listen_pcb == NULL) {
+    tcp_close(pcb);
+    state->error = 1;
+    return;
+  }
+  tcp_arg(state->listen_pcb, state);
+  tcp_accept(state->listen_pcb, bench_mqtt_broker_accept);
+
+  memset(&info, 0, sizeof(info));
+  info.client_id = "lwip_bench";
+  state->client = mqtt_client_new();
+  if ((state->client == NULL) ||
+      (mqtt_client_connect(state->client, &server_addr, BENCH_MQTT_PORT, bench_mqtt_connection, state, &info) != ERR_OK)) {
+    state->error = 1;
+  }
+}
+
+/* called from the tcpip thread */
+static void
+bench_mqtt_stop(void *arg)
+{
+  struct bench_mqtt_state *state = (struct bench_mqtt_state *)arg;
+
+  state->running = 0;
+  if (state->client != NULL) {
+    mqtt_disconnect(state->client);
+    mqtt_client_free(state->client);
+    state->client = NULL;
+  }
+  if (state->broker_pcb != NULL) {
+    tcp_arg(state->broker_pcb, NULL);
+    tcp_recv(state->broker_pcb, NULL);
+    tcp_err(state->broker_pcb, NULL);
+    tcp_abort(state->broker_pcb);
+    state->broker_pcb = NULL;
+  }
+  if (state->listen_pcb != NULL) {
+    tcp_close(state->listen_pcb);
+    state->listen_pcb = NULL;
+  }
+}
+
+static int
+bench_mqtt_run(const struct bench_config *config, const struct bench_mqtt_mode *mode)
+{
+  struct bench_mqtt_state state;
+  double secs;
+
+  memset(&state, 0, sizeof(state));
+  state.config = config;
+  state.mode = mode;
+  /* the payload pbuf is only ever touched from the tcpip thread after this */
+  state.payload = pbuf_alloc(PBUF_RAW, mode->payload_len, PBUF_RAM);
+  if (state.payload == NULL) {
+    return -1;
+  }
+  memset(state.payload->payload, 'm', mode->payload_len);
+  if (sys_sem_new(&state.done, 0) != ERR_OK) {
+    pbuf_free(state.payload);
+    return -1;
+  }
+
+  bench_tcpip_call(bench_mqtt_start, &state);
+  if (!state.error && (sys_arch_sem_wait(&state.done, config->duration_ms + 10000) == SYS_ARCH_TIMEOUT)) {
+    state.error = 1;
+  }
+  bench_tcpip_call(bench_mqtt_stop, &state);
+  sys_sem_free(&state.done);
+  pbuf_free(state.payload);
+
+  if (state.error || (state.received == 0) || (state.last_us <= state.start_us)) {
+    return -1;
+  }
+  secs = (double)(state.last_us - state.start_us) / 1000000.0;
+  printf("%-14s %lu messages of %u bytes in %.2f s: %.0f msg/s, %.1f Mbit/s payload\n",
+         mode->name, (unsigned long)state.received, (unsigned)mode->payload_len, secs,
+         state.received / secs, (state.received * (double)mode->payload_len * 8.0) / secs / 1000000.0);
+  return 0;
+}
+
+int
+bench_mqtt_qos0(const struct bench_config *config)
+{
+  return bench_mqtt_run(config, &bench_mqtt_modes[0]);
+}
+
+int
+bench_mqtt_batch(const struct bench_config *config)
+{
+  return bench_mqtt_run(config, &bench_mqtt_modes[1]);
+}
+
+int
+bench_mqtt_qos1(const struct bench_config *config)
+{
+  return bench_mqtt_run(config, &bench_mqtt_modes[2]);
+}
+
+int
+bench_mqtt_copy_1k(const struct bench_config *config)
+{
+  return bench_mqtt_run(config, &bench_mqtt_modes[3]);
+}
+
+int
+bench_mqtt_zc_1k(const struct bench_config *config)
+{
+  return bench_mqtt_run(config, &bench_mqtt_modes[4]);
+}
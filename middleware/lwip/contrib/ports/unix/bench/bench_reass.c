@@ -0,0 +1,189 @@
+/**
+ * @file
+ * IPv4 reassembly benchmarks: fragments of UDP-sized datagrams are handed to
+ * ip4_reass() directly in the tcpip thread, as fast as it takes them. This
+ * measures reassembly alone; the pipeif pair delivers frames in order and
+ * would mostly measure the wire.
+ *
+ * - reass-inorder: 8000 byte datagrams in 1480 byte fragments, in order
+ * - reass-reverse: same, last fragment first
+ * - reass-random: same, fragments shuffled per datagram
+ * - reass-small: 4096 byte datagrams in 64 fragments of 64 bytes, shuffled
+ *
+ * Every datagram is checked for its length once reassembled. Fragment payloads
+ * are not filled in: they are copied or chained the same either way.
+ */
+
+#include "lwip/opt.h"
+#include "lwip/ip4_frag.h"
+#include "lwip/pbuf.h"
+#include "lwip/prot/ip4.h"
+
+#include "lwip_bench.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define BENCH_REASS_MAX_FRAGS 64
+
+enum bench_reass_order {
+  BENCH_REASS_IN_ORDER,
+  BENCH_REASS_REVERSE,
+  BENCH_REASS_RANDOM
+};
+
+struct bench_reass_mode {
+  const char *name;
+  u16_t datagram_len;
+  u16_t frag_len;
+  enum bench_reass_order order;
+};
+
+static const struct bench_reass_mode bench_reass_modes[] = {
+  { "reass-inorder", 8000, 1480, BENCH_REASS_IN_ORDER },
+  { "reass-reverse", 8000, 1480, BENCH_REASS_REVERSE },
+  { "reass-random",  8000, 1480, BENCH_REASS_RANDOM },
+  { "reass-small",   4096,   64, BENCH_REASS_RANDOM },
+};
+
+struct bench_reass_state {
+  const struct bench_config *config;
+  const struct bench_reass_mode *mode;
+  u32_t datagrams;
+  u64_t elapsed_us;
+  int error;
+};
+
+static struct pbuf *
+bench_reass_fragment(u16_t ip_id, u16_t start, u16_t len, int last)
+{
+  struct pbuf *p;
+  struct ip_hdr *iphdr;
+
+  p = pbuf_alloc(PBUF_RAW, (u16_t)(len + IP_HLEN), PBUF_RAM);
+  if (p == NULL) {
+    return NULL;
+  }
+  iphdr = (struct ip_hdr *)p->payload;
+  memset(iphdr, 0, IP_HLEN);
+  IPH_VHL_SET(iphdr, 4, IP_HLEN / 4);
+  IPH_LEN_SET(iphdr, lwip_htons(p->tot_len));
+  IPH_ID_SET(iphdr, lwip_htons(ip_id));
+  IPH_OFFSET_SET(iphdr, lwip_htons((u16_t)((start / 8) | (last ? 0 : IP_MF))));
+  IPH_TTL_SET(iphdr, 64);
+  IPH_PROTO_SET(iphdr, IP_PROTO_UDP);
+  ip4_addr_copy(iphdr->src, bench_client_ip);
+  ip4_addr_copy(iphdr->dest, bench_server_ip);
+  return p;
+}
+
+/* runs in the tcpip thread for the whole measurement */
+static void
+bench_reass_run_fn(void *arg)
+{
+  struct bench_reass_state *state = (struct bench_reass_state *)arg;
+  const struct bench_reass_mode *mode = state->mode;
+  u16_t order[BENCH_REASS_MAX_FRAGS];
+  u16_t nfrags = (u16_t)((mode->datagram_len + mode->frag_len - 1) / mode->frag_len);
+  u16_t ip_id = 0;
+  u32_t seed = 1;
+  u64_t start_us, end_us;
+  u16_t i, k;
+
+  LWIP_ASSERT("too many fragments", nfrags <= BENCH_REASS_MAX_FRAGS);
+  for (i = 0; i < nfrags; i++) {
+    order[i] = (mode->order == BENCH_REASS_REVERSE) ? (u16_t)(nfrags - 1 - i) : i;
+  }
+
+  start_us = bench_now_us();
+  end_us = start_us + (u64_t)state->config->duration_ms * 1000;
+  for (;;) {
+    struct pbuf *r = NULL;
+
+    if (mode->order == BENCH_REASS_RANDOM) {
+      for (i = (u16_t)(nfrags - 1); i > 0; i--) {
+        u16_t j, tmp;
+        seed = seed * 1103515245 + 12345;
+        j = (u16_t)((seed >> 16) % (i + 1));
+        tmp = order[i];
+        order[i] = order[j];
+        order[j] = tmp;
+      }
+    }
+    for (k = 0; k < nfrags; k++) {
+      u16_t start = (u16_t)(order[k] * mode->frag_len);
+      u16_t len = (u16_t)LWIP_MIN(mode->frag_len, mode->datagram_len - start);
+      struct pbuf *p = bench_reass_fragment(ip_id, start, len, order[k] == nfrags - 1);
+
+      if (p == NULL) {
+        state->error = 1;
+        return;
+      }
+      r = ip4_reass(p);
+      if ((r != NULL) && (k != nfrags - 1)) {
+        pbuf_free(r);
+        state->error = 1;
+        return;
+      }
+    }
+    if ((r == NULL) || (r->tot_len != mode->datagram_len + IP_HLEN)) {
+      if (r != NULL) {
+        pbuf_free(r);
+      }
+      state->error = 1;
+      return;
+    }
+    pbuf_free(r);
+    state->datagrams++;
+    ip_id++;
+    if (((state->datagrams & 63) == 0) && (bench_now_us() >= end_us)) {
+      break;
+    }
+  }
+  state->elapsed_us = bench_now_us() - start_us;
+}
+
+static int
+bench_reass_run(const struct bench_config *config, const struct bench_reass_mode *mode)
+{
+  struct bench_reass_state state;
+  double secs;
+
+  memset(&state, 0, sizeof(state));
+  state.config = config;
+  state.mode = mode;
+  bench_tcpip_call(bench_reass_run_fn, &state);
+  if (state.error || (state.elapsed_us == 0)) {
+    return -1;
+  }
+
+  secs = (double)state.elapsed_us / 1000000.0;
+  printf("%-14s %lu datagrams of %u bytes in %.2f s: %.0f datagrams/s, %.1f Mbit/s payload\n",
+         mode->name, (unsigned long)state.datagrams, (unsigned)mode->datagram_len, secs,
+         state.datagrams / secs, (state.datagrams * (double)mode->datagram_len * 8.0) / secs / 1000000.0);
+  return 0;
+}
+
+int
+bench_reass_inorder(const struct bench_config *config)
+{
+  return bench_reass_run(config, &bench_reass_modes[0]);
+}
+
+int
+bench_reass_reverse(const struct bench_config *config)
+{
+  return bench_reass_run(config, &bench_reass_modes[1]);
+}
+
+int
+bench_reass_random(const struct bench_config *config)
+{
+  return bench_reass_run(config, &bench_reass_modes[2]);
+}
+
+int
+bench_reass_small(const struct bench_config *config)
+{
+  return bench_reass_run(config, &bench_reass_modes[3]);
+}
@@ -0,0 +1,54 @@
+/**
+ * @file
+ * The few FreeRTOS calls httpsrv makes directly (besides lwIP's sys_arch),
+ * mapped onto the unix port so that httpsrv builds unmodified on the host.
+ */
+#ifndef LWIP_BENCH_FREERTOS_H
+#define LWIP_BENCH_FREERTOS_H
+
+#include "lwip/sys.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+
+typedef long BaseType_t;
+typedef void *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *);
+
+#define pdPASS 1
+#define pdFAIL 0
+
+/* below 4 GiB, httpsrv handles are uint32_t (freertos/heap_low.c) */
+void *bench_port_malloc(size_t size);
+void bench_port_free(void *ptr);
+
+#define pvPortMalloc(size) bench_port_malloc(size)
+#define vPortFree(ptr)     bench_port_free(ptr)
+#define taskYIELD()        sched_yield()
+
+static inline BaseType_t
+xTaskCreate(TaskFunction_t function, const char *name, size_t stack_depth, void *arg,
+            unsigned long priority, TaskHandle_t *handle)
+{
+  sys_thread_t thread = sys_thread_new(name, function, arg, (int)stack_depth, (int)priority);
+  if (handle != NULL) {
+    *handle = thread;
+  }
+  return pdPASS;
+}
+
+/* Only a task deleting itself is supported: httpsrv kills other tasks only
+   for timed out CGI scripts, which the benchmark does not run in a task.
+   Nobody joins the thread, so detach it to release its stack: httpsrv runs
+   one task per connection. */
+static inline void
+vTaskDelete(TaskHandle_t task)
+{
+  if (task == NULL) {
+    pthread_detach(pthread_self());
+    pthread_exit(NULL);
+  }
+}
+
+#endif /* LWIP_BENCH_FREERTOS_H */
@@ -0,0 +1,108 @@
+/**
+ * @file
+ * pvPortMalloc()/vPortFree() of the FreeRTOS shim: blocks below 4 GiB, as on
+ * the 32-bit target. httpsrv passes server and session pointers around as
+ * uint32_t handles, and CGI callbacks hand the session handle back to
+ * HTTPSRV_cgi_read()/HTTPSRV_cgi_write().
+ *
+ * Power of two size classes with a free list each, carved from one MAP_32BIT
+ * mapping, so no system call per allocation skews the benchmarks. Hosts
+ * without MAP_32BIT get malloc().
+ */
+
+#include "FreeRTOS.h"
+
+#include <stdint.h>
+#include <sys/mman.h>
+
+#ifdef MAP_32BIT
+
+#define HEAP_LOW_SIZE      (64 * 1024 * 1024)
+/* keeps the size class, aligns the block like malloc() does */
+#define HEAP_LOW_HEADER    16
+#define HEAP_LOW_MIN_SHIFT 5
+#define HEAP_LOW_CLASSES   22
+
+static pthread_mutex_t heap_low_lock = PTHREAD_MUTEX_INITIALIZER;
+static char *heap_low_base;
+static char *heap_low_next;
+static char *heap_low_end;
+static int heap_low_failed;
+static void *heap_low_free[HEAP_LOW_CLASSES];
+
+void *
+bench_port_malloc(size_t size)
+{
+  char *block = NULL;
+  size_t c = 0;
+
+  while (((size_t)1 << (c + HEAP_LOW_MIN_SHIFT)) < size + HEAP_LOW_HEADER) {
+    c++;
+  }
+  if (c >= HEAP_LOW_CLASSES) {
+    return NULL;
+  }
+
+  pthread_mutex_lock(&heap_low_lock);
+  if ((heap_low_base == NULL) && !heap_low_failed) {
+    void *map = mmap(NULL, HEAP_LOW_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_32BIT, -1, 0);
+    if (map == MAP_FAILED) {
+      heap_low_failed = 1;
+    } else {
+      heap_low_base = heap_low_next = (char *)map;
+      heap_low_end = heap_low_base + HEAP_LOW_SIZE;
+    }
+  }
+  if (heap_low_free[c] != NULL) {
+    block = (char *)heap_low_free[c];
+    heap_low_free[c] = *(void **)block;
+  } else if ((heap_low_base != NULL) && ((size_t)(heap_low_end - heap_low_next) >= ((size_t)1 << (c + HEAP_LOW_MIN_SHIFT)))) {
+    block = heap_low_next;
+    heap_low_next += (size_t)1 << (c + HEAP_LOW_MIN_SHIFT);
+  }
+  pthread_mutex_unlock(&heap_low_lock);
+
+  if (heap_low_failed) {
+    return malloc(size);
+  }
+  if (block == NULL) {
+    return NULL;
+  }
+  *(size_t *)block = c;
+  return block + HEAP_LOW_HEADER;
+}
+
+void
+bench_port_free(void *ptr)
+{
+  char *block;
+  size_t c;
+
+  /* malloc() fallback */
+  if ((heap_low_base == NULL) || ((char *)ptr < heap_low_base) || ((char *)ptr >= heap_low_end)) {
+    free(ptr);
+    return;
+  }
+  block = (char *)ptr - HEAP_LOW_HEADER;
+  c = *(size_t *)block;
+  pthread_mutex_lock(&heap_low_lock);
+  *(void **)block = heap_low_free[c];
+  heap_low_free[c] = block;
+  pthread_mutex_unlock(&heap_low_lock);
+}
+
+#else /* MAP_32BIT */
+
+void *
+bench_port_malloc(size_t size)
+{
+  return malloc(size);
+}
+
+void
+bench_port_free(void *ptr)
+{
+  free(ptr);
+}
+
+#endif /* MAP_32BIT */
@@ -0,0 +1,68 @@
+/**
+ * @file
+ * Host benchmark of the lwIP stack over an in-memory pipeif pair.
+ */
+#ifndef LWIP_BENCH_H
+#define LWIP_BENCH_H
+
+#include "lwip/arch.h"
+#include "lwip/ip4_addr.h"
+#include "netif/pipeif.h"
+
+/** Options shared by all benchmarks */
+struct bench_config {
+  /** run time of one measurement, in milliseconds */
+  u32_t duration_ms;
+  /** concurrent client connections for the HTTP benchmarks */
+  u32_t clients;
+  /** wire properties of the pipeif pair */
+  struct pipeif_config wire;
+};
+
+/** Collected latency samples, in microseconds */
+struct bench_latency {
+  u32_t *samples;
+  u32_t count;
+  u32_t capacity;
+};
+
+/* the server end (a) and the client end (b) of the pipeif pair */
+extern struct netif bench_server_netif;
+extern struct netif bench_client_netif;
+extern ip4_addr_t bench_server_ip;
+extern ip4_addr_t bench_client_ip;
+
+u64_t bench_now_us(void);
+void  bench_tcpip_call(void (*fn)(void *arg), void *arg);
+
+int  bench_latency_init(struct bench_latency *lat, u32_t capacity);
+void bench_latency_add(struct bench_latency *lat, u32_t us);
+void bench_latency_merge(struct bench_latency *dst, const struct bench_latency *src);
+void bench_latency_report(const char *name, struct bench_latency *lat);
+void bench_latency_free(struct bench_latency *lat);
+
+int bench_iperf(const struct bench_config *config);
+int bench_http_rate(const struct bench_config *config);
+int bench_http_latency(const struct bench_config *config);
+int bench_http_bulk(const struct bench_config *config);
+int bench_http_gzip(const struct bench_config *config);
+int bench_http_304(const struct bench_config *config);
+int bench_http_post(const struct bench_config *config);
+int bench_mqtt_qos0(const struct bench_config *config);
+int bench_mqtt_batch(const struct bench_config *config);
+int bench_mqtt_qos1(const struct bench_config *config);
+int bench_mqtt_copy_1k(const struct bench_config *config);
+int bench_mqtt_zc_1k(const struct bench_config *config);
+int bench_reass_inorder(const struct bench_config *config);
+int bench_reass_reverse(const struct bench_config *config);
+int bench_reass_random(const struct bench_config *config);
+int bench_reass_small(const struct bench_config *config);
+int bench_tcp_demux_1(const struct bench_config *config);
+int bench_tcp_demux_50(const struct bench_config *config);
+int bench_tcp_demux_200(const struct bench_config *config);
+int bench_eth_tx_copy(const struct bench_config *config);
+int bench_eth_tx_zerocopy(const struct bench_config *config);
+int bench_eth_rx_frame(const struct bench_config *config);
+int bench_eth_rx_batch(const struct bench_config *config);
+
+#endif /* LWIP_BENCH_H */
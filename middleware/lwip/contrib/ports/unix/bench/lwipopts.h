@@ -0,0 +1,185 @@
+/**
+ * @file
+ * lwIP options for the host benchmark (lwip_bench).
+ *
+ * Sizes follow the firmware configuration in template/lwipopts.h so that
+ * results carry over. Every tuning option is guarded with #ifndef, so it can
+ * be overridden at configure time, e.g.
+ *   cmake -DLWIP_BENCH_DEFINES="TCP_WND=(8*TCP_MSS);PBUF_POOL_SIZE=32" ...
+ */
+#ifndef LWIP_HDR_LWIPOPTS_H
+#define LWIP_HDR_LWIPOPTS_H
+
+/* ---------- Platform ---------- */
+#define NO_SYS                          0
+#define SYS_LIGHTWEIGHT_PROT            1
+#define LWIP_NETIF_API                  1
+#define LWIP_NETCONN                    1
+#define LWIP_SOCKET                     1
+#define LWIP_SO_RCVTIMEO                1
+#define LWIP_SO_SNDTIMEO                1
+#define SO_REUSE                        1
+/* keep read()/write()/close() for the host libc */
+#define LWIP_POSIX_SOCKETS_IO_NAMES     0
+
+#ifndef LWIP_TCPIP_CORE_LOCKING
+#define LWIP_TCPIP_CORE_LOCKING         1
+#endif
+
+#ifndef LWIP_TCPIP_CORE_LOCKING_INPUT
+#define LWIP_TCPIP_CORE_LOCKING_INPUT   0
+#endif
+
+/* ---------- Memory ---------- */
+#ifndef MEM_ALIGNMENT
+#define MEM_ALIGNMENT                   4
+#endif
+
+#ifndef MEM_SIZE
+#define MEM_SIZE                        (22 * 1024)
+#endif
+
+#ifndef MEMP_NUM_PBUF
+#define MEMP_NUM_PBUF                   15
+#endif
+
+#ifndef MEMP_NUM_UDP_PCB
+#define MEMP_NUM_UDP_PCB                6
+#endif
+
+#ifndef MEMP_NUM_TCP_PCB
+#define MEMP_NUM_TCP_PCB                10
+#endif
+
+#ifndef MEMP_NUM_TCP_PCB_LISTEN
+#define MEMP_NUM_TCP_PCB_LISTEN         6
+#endif
+
+#ifndef MEMP_NUM_TCP_SEG
+#define MEMP_NUM_TCP_SEG                22
+#endif
+
+#ifndef MEMP_NUM_NETCONN
+#define MEMP_NUM_NETCONN                16
+#endif
+
+#ifndef MEMP_NUM_SYS_TIMEOUT
+#define MEMP_NUM_SYS_TIMEOUT            (LWIP_NUM_SYS_TIMEOUT_INTERNAL + 4)
+#endif
+
+/* pipeif receives into PBUF_POOL: stands in for the ENET_RXBUFF_NUM (10)
+   receive buffers of each of the two ends */
+#ifndef PBUF_POOL_SIZE
+#define PBUF_POOL_SIZE                  20
+#endif
+
+/* ---------- IP reassembly ---------- */
+/* room for the 64 fragments of reass-small, the firmware keeps 4 */
+#ifndef IP_REASS_MAX_PBUFS
+#define IP_REASS_MAX_PBUFS              64
+#endif
+
+/* the contiguous path, off by default in the firmware; the cap takes the
+   8000 byte datagrams of reass-* (-DIP_REASS_CONTIGUOUS=0 for the chain) */
+#ifndef IP_REASS_CONTIGUOUS
+#define IP_REASS_CONTIGUOUS             1
+#endif
+#ifndef IP_REASS_CONTIGUOUS_MAX
+#define IP_REASS_CONTIGUOUS_MAX         (9 * 1024)
+#endif
+
+/* ---------- Protocols ---------- */
+#define LWIP_IPV4                       1
+#define LWIP_IPV6                       0
+#define LWIP_ARP                        1
+#define LWIP_ICMP                       1
+#define LWIP_UDP                        1
+#define LWIP_TCP                        1
+#define LWIP_DHCP                       0
+#define LWIP_DNS                        0
+#define LWIP_IGMP                       0
+
+#ifndef TCP_MSS
+#define TCP_MSS                         (1500 - 40)
+#endif
+
+#ifndef TCP_SND_BUF
+#define TCP_SND_BUF                     (6 * TCP_MSS)
+#endif
+
+#ifndef TCP_SND_QUEUELEN
+#define TCP_SND_QUEUELEN                ((3 * TCP_SND_BUF) / TCP_MSS)
+#endif
+
+#ifndef TCP_WND
+#define TCP_WND                         (2 * TCP_MSS)
+#endif
+
+#ifndef TCP_QUEUE_OOSEQ
+#define TCP_QUEUE_OOSEQ                 0
+#endif
+
+#ifndef TCP_LISTEN_BACKLOG
+#define TCP_LISTEN_BACKLOG              1
+#endif
+
+/* ---------- MQTT ---------- */
+/* room for the 1 KiB publishes of mqtt-copy-1k, the firmware uses the default */
+#ifndef MQTT_OUTPUT_RINGBUF_SIZE
+#define MQTT_OUTPUT_RINGBUF_SIZE        (2 * 1024)
+#endif
+
+/* ---------- Checksums ---------- */
+/* The ENET does them in hardware on target, so by default they cost nothing
+   here either. Enable both to include the software checksum in the numbers. */
+#ifndef CHECKSUM_GEN_IP
+#define CHECKSUM_GEN_IP                 0
+#endif
+#ifndef CHECKSUM_GEN_UDP
+#define CHECKSUM_GEN_UDP                0
+#endif
+#ifndef CHECKSUM_GEN_TCP
+#define CHECKSUM_GEN_TCP                0
+#endif
+#ifndef CHECKSUM_GEN_ICMP
+#define CHECKSUM_GEN_ICMP               0
+#endif
+#ifndef CHECKSUM_CHECK_IP
+#define CHECKSUM_CHECK_IP               0
+#endif
+#ifndef CHECKSUM_CHECK_UDP
+#define CHECKSUM_CHECK_UDP              0
+#endif
+#ifndef CHECKSUM_CHECK_TCP
+#define CHECKSUM_CHECK_TCP              0
+#endif
+#ifndef CHECKSUM_CHECK_ICMP
+#define CHECKSUM_CHECK_ICMP             0
+#endif
+#ifndef LWIP_CHKSUM_ALGORITHM
+#define LWIP_CHKSUM_ALGORITHM           4
+#endif
+
+/* ---------- Statistics ---------- */
+#ifndef LWIP_STATS
+#define LWIP_STATS                      0
+#endif
+
+/* ---------- Threads ---------- */
+#define TCPIP_MBOX_SIZE                 32
+#define DEFAULT_RAW_RECVMBOX_SIZE       12
+#define DEFAULT_UDP_RECVMBOX_SIZE       12
+#define DEFAULT_TCP_RECVMBOX_SIZE       12
+#define DEFAULT_ACCEPTMBOX_SIZE         12
+#define DEFAULT_THREAD_STACKSIZE        3000
+#define DEFAULT_THREAD_PRIO             3
+
+/* ---------- Hooks ---------- */
+/* both pipeif ends live in this stack: send from the end owning the source */
+#define LWIP_HOOK_FILENAME              "netif/pipeif.h"
+#define LWIP_HOOK_IP4_ROUTE_SRC(src, dest) pipeif_route_src(src, dest)
+
+void sys_check_core_locking(void);
+#define LWIP_ASSERT_CORE_LOCKED()       sys_check_core_locking()
+
+#endif /* LWIP_HDR_LWIPOPTS_H */
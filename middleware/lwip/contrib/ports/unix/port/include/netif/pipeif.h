@@ -0,0 +1,46 @@
+/**
+ * @file
+ * In-memory Ethernet netif pair wired back to back, for benchmarking the
+ * stack on the host without a network device.
+ */
+
+#ifndef LWIP_PIPEIF_H
+#define LWIP_PIPEIF_H
+
+#include "lwip/netif.h"
+#include "lwip/ip4_addr.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Properties of the wire between the two ends, applied in both directions */
+struct pipeif_config {
+  /** one-way delay added to every frame, in microseconds */
+  u32_t latency_us;
+  /** frames dropped per million, chosen pseudo-randomly (reproducible) */
+  u32_t loss_ppm;
+};
+
+/** Counters of one end, for frames sent by that end */
+struct pipeif_stats {
+  u32_t frames;
+  u32_t bytes;
+  /** dropped by the configured loss */
+  u32_t lost;
+  /** dropped because no receive pbuf could be allocated */
+  u32_t nomem;
+};
+
+err_t pipeif_pair_add(struct netif *a, const ip4_addr_t *ipaddr_a,
+                      struct netif *b, const ip4_addr_t *ipaddr_b,
+                      const ip4_addr_t *netmask, const struct pipeif_config *config);
+void pipeif_get_stats(const struct netif *netif, struct pipeif_stats *stats);
+
+struct netif *pipeif_route_src(const ip4_addr_t *src, const ip4_addr_t *dest);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LWIP_PIPEIF_H */
@@ -0,0 +1,345 @@
+/**
+ * @file
+ * In-memory Ethernet netif pair wired back to back.
+ *
+ * Every frame sent on one end is copied into a PBUF_POOL pbuf (as a real
+ * driver would on receive) and passed to the input function of the other
+ * end. Both ends live in the same stack: pipeif_route_src() is meant to be
+ * used as LWIP_HOOK_IP4_ROUTE_SRC so that a packet leaves through the end
+ * owning its source address, which makes each direction really cross the
+ * wire instead of being short-cut by routing.
+ *
+ * Without latency, frames are handed to the peer from the sending context.
+ * With latency, each end runs a thread that releases queued frames once
+ * their delivery time has passed.
+ */
+
+#include "lwip/opt.h"
+
+#if LWIP_ARP && LWIP_IPV4 && !NO_SYS /* don't build if not configured for use in lwipopts.h */
+
+#include "lwip/def.h"
+#include "lwip/pbuf.h"
+#include "lwip/snmp.h"
+#include "lwip/stats.h"
+#include "lwip/tcpip.h"
+#include "netif/etharp.h"
+
+#include "netif/pipeif.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define IFNAME0 'p'
+#define IFNAME1 'p'
+
+/** A frame on the wire, waiting for its delivery time */
+struct pipeif_frame {
+  struct pipeif_frame *next;
+  struct pbuf *p;
+  u64_t due_us;
+};
+
+/** State of one end */
+struct pipeif {
+  struct netif *peer;
+  struct pipeif_config config;
+  struct pipeif_stats stats;
+  u32_t rand;
+  /* frames sent by this end that the peer has not received yet */
+  struct pipeif_frame *head;
+  struct pipeif_frame *tail;
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+  pthread_t thread;
+  /* set to end the thread */
+  u8_t stop;
+};
+
+static u8_t pipeif_count;
+
+static u64_t
+pipeif_now_us(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (u64_t)ts.tv_sec * 1000000 + (u64_t)ts.tv_nsec / 1000;
+}
+
+/* xorshift32, seeded per end so that loss patterns repeat between runs */
+static u32_t
+pipeif_rand(struct pipeif *pipe)
+{
+  u32_t x = pipe->rand;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  pipe->rand = x;
+  return x;
+}
+
+static void
+pipeif_deliver(struct netif *peer, struct pbuf *p)
+{
+  if (peer->input(p, peer) != ERR_OK) {
+    LINK_STATS_INC(link.drop);
+    pbuf_free(p);
+  }
+}
+
+static void *
+pipeif_thread(void *arg)
+{
+  struct pipeif *pipe = (struct pipeif *)arg;
+
+  pthread_mutex_lock(&pipe->lock);
+  while (!pipe->stop) {
+    struct pipeif_frame *frame = pipe->head;
+    u64_t now;
+
+    if (frame == NULL) {
+      pthread_cond_wait(&pipe->cond, &pipe->lock);
+      continue;
+    }
+    now = pipeif_now_us();
+    if (frame->due_us > now) {
+      struct timespec ts;
+      clock_gettime(CLOCK_MONOTONIC, &ts);
+      ts.tv_nsec += (long)((frame->due_us - now) * 1000);
+      ts.tv_sec += ts.tv_nsec / 1000000000L;
+      ts.tv_nsec %= 1000000000L;
+      pthread_cond_timedwait(&pipe->cond, &pipe->lock, &ts);
+      continue;
+    }
+    pipe->head = frame->next;
+    if (pipe->head == NULL) {
+      pipe->tail = NULL;
+    }
+    pthread_mutex_unlock(&pipe->lock);
+
+    pipeif_deliver(pipe->peer, frame->p);
+    free(frame);
+
+    pthread_mutex_lock(&pipe->lock);
+  }
+  pthread_mutex_unlock(&pipe->lock);
+  return NULL;
+}
+
+static err_t
+pipeif_linkoutput(struct netif *netif, struct pbuf *p)
+{
+  struct pipeif *pipe = (struct pipeif *)netif->state;
+  struct pbuf *q;
+
+  pipe->stats.frames++;
+  pipe->stats.bytes += p->tot_len;
+  MIB2_STATS_NETIF_ADD(netif, ifoutoctets, p->tot_len);
+
+  if ((pipe->config.loss_ppm != 0) &&
+      ((pipeif_rand(pipe) % 1000000) < pipe->config.loss_ppm)) {
+    pipe->stats.lost++;
+    return ERR_OK;
+  }
+
+  /* the peer receives a copy, like from a DMA ring */
+  q = pbuf_clone(PBUF_RAW, PBUF_POOL, p);
+  if (q == NULL) {
+    pipe->stats.nomem++;
+    LINK_STATS_INC(link.memerr);
+    return ERR_OK;
+  }
+  LINK_STATS_INC(link.xmit);
+
+  if (pipe->config.latency_us == 0) {
+    pipeif_deliver(pipe->peer, q);
+  } else {
+    struct pipeif_frame *frame = (struct pipeif_frame *)malloc(sizeof(struct pipeif_frame));
+    if (frame == NULL) {
+      pipe->stats.nomem++;
+      pbuf_free(q);
+      return ERR_OK;
+    }
+    frame->next = NULL;
+    frame->p = q;
+    frame->due_us = pipeif_now_us() + pipe->config.latency_us;
+
+    pthread_mutex_lock(&pipe->lock);
+    if (pipe->tail != NULL) {
+      pipe->tail->next = frame;
+    } else {
+      pipe->head = frame;
+    }
+    pipe->tail = frame;
+    pthread_cond_signal(&pipe->cond);
+    pthread_mutex_unlock(&pipe->lock);
+  }
+  return ERR_OK;
+}
+
+static err_t
+pipeif_init(struct netif *netif)
+{
+  netif->name[0] = IFNAME0;
+  netif->name[1] = IFNAME1;
+  netif->output = etharp_output;
+  netif->linkoutput = pipeif_linkoutput;
+  netif->mtu = 1500;
+
+  /* locally administered, unique per end */
+  netif->hwaddr_len = ETH_HWADDR_LEN;
+  memset(netif->hwaddr, 0, ETH_HWADDR_LEN);
+  netif->hwaddr[0] = 0x02;
+  netif->hwaddr[5] = ++pipeif_count;
+
+  netif->flags = NETIF_FLAG_BROADCAST | NETIF_FLAG_ETHARP | NETIF_FLAG_ETHERNET | NETIF_FLAG_LINK_UP;
+  MIB2_INIT_NETIF(netif, snmp_ifType_ethernet_csmacd, 0);
+  return ERR_OK;
+}
+
+static struct pipeif *
+pipeif_new(struct netif *peer, const struct pipeif_config *config, u32_t seed)
+{
+  struct pipeif *pipe = (struct pipeif *)calloc(1, sizeof(struct pipeif));
+  pthread_condattr_t attr;
+  int ret;
+
+  if (pipe == NULL) {
+    return NULL;
+  }
+  pipe->peer = peer;
+  if (config != NULL) {
+    pipe->config = *config;
+  }
+  pipe->rand = seed;
+  if (pthread_mutex_init(&pipe->lock, NULL) != 0) {
+    free(pipe);
+    return NULL;
+  }
+  if (pipe->config.latency_us == 0) {
+    return pipe;
+  }
+
+  /* the thread waits for delivery times on the monotonic clock */
+  if (pthread_condattr_init(&attr) != 0) {
+    pthread_mutex_destroy(&pipe->lock);
+    free(pipe);
+    return NULL;
+  }
+  ret = pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+  if (ret == 0) {
+    ret = pthread_cond_init(&pipe->cond, &attr);
+  }
+  pthread_condattr_destroy(&attr);
+  if (ret != 0) {
+    pthread_mutex_destroy(&pipe->lock);
+    free(pipe);
+    return NULL;
+  }
+  if (pthread_create(&pipe->thread, NULL, pipeif_thread, pipe) != 0) {
+    pthread_cond_destroy(&pipe->cond);
+    pthread_mutex_destroy(&pipe->lock);
+    free(pipe);
+    return NULL;
+  }
+  return pipe;
+}
+
+/* Undo pipeif_new(): end the thread and drop the frames still on the wire */
+static void
+pipeif_free(struct pipeif *pipe)
+{
+  if (pipe->config.latency_us != 0) {
+    pthread_mutex_lock(&pipe->lock);
+    pipe->stop = 1;
+    pthread_cond_signal(&pipe->cond);
+    pthread_mutex_unlock(&pipe->lock);
+    pthread_join(pipe->thread, NULL);
+
+    while (pipe->head != NULL) {
+      struct pipeif_frame *frame = pipe->head;
+      pipe->head = frame->next;
+      pbuf_free(frame->p);
+      free(frame);
+    }
+    pthread_cond_destroy(&pipe->cond);
+  }
+  pthread_mutex_destroy(&pipe->lock);
+  free(pipe);
+}
+
+/**
+ * Add two pipeif netifs connected to each other and set them up.
+ * Must be called with the core locked (or from the tcpip thread).
+ *
+ * @param a first end, added first
+ * @param b second end, added last so that it is the first match in
+ *        netif_list: traffic from unbound PCBs towards the subnet leaves here
+ * @param config wire latency and loss, may be NULL for an ideal wire
+ */
+err_t
+pipeif_pair_add(struct netif *a, const ip4_addr_t *ipaddr_a,
+                struct netif *b, const ip4_addr_t *ipaddr_b,
+                const ip4_addr_t *netmask, const struct pipeif_config *config)
+{
+  struct pipeif *pipe_a, *pipe_b;
+
+  LWIP_ASSERT_CORE_LOCKED();
+
+  /* on failure, undo the steps done so far in reverse order */
+  pipe_a = pipeif_new(b, config, 0x2545F491UL);
+  if (pipe_a == NULL) {
+    return ERR_MEM;
+  }
+  pipe_b = pipeif_new(a, config, 0x9E3779B9UL);
+  if (pipe_b == NULL) {
+    pipeif_free(pipe_a);
+    return ERR_MEM;
+  }
+  if (netif_add(a, ipaddr_a, netmask, IP4_ADDR_ANY4, pipe_a, pipeif_init, tcpip_input) == NULL) {
+    pipeif_free(pipe_b);
+    pipeif_free(pipe_a);
+    return ERR_IF;
+  }
+  if (netif_add(b, ipaddr_b, netmask, IP4_ADDR_ANY4, pipe_b, pipeif_init, tcpip_input) == NULL) {
+    netif_remove(a);
+    pipeif_free(pipe_b);
+    pipeif_free(pipe_a);
+    return ERR_IF;
+  }
+  netif_set_up(a);
+  netif_set_up(b);
+  return ERR_OK;
+}
+
+/** Read the counters of frames sent by one end */
+void
+pipeif_get_stats(const struct netif *netif, struct pipeif_stats *stats)
+{
+  const struct pipeif *pipe = (const struct pipeif *)netif->state;
+  *stats = pipe->stats;
+}
+
+/**
+ * LWIP_HOOK_IP4_ROUTE_SRC implementation: route a packet out of the pipeif
+ * end that owns its source address.
+ */
+struct netif *
+pipeif_route_src(const ip4_addr_t *src, const ip4_addr_t *dest)
+{
+  struct netif *netif;
+
+  LWIP_UNUSED_ARG(dest);
+
+  NETIF_FOREACH(netif) {
+    if ((netif->linkoutput == pipeif_linkoutput) && netif_is_up(netif) &&
+        ip4_addr_eq(src, netif_ip4_addr(netif))) {
+      return netif;
+    }
+  }
+  return NULL;
+}
+
+#endif /* LWIP_ARP && LWIP_IPV4 && !NO_SYS */
@@ -8,6 +8,9 @@ message("${CMAKE_CURRENT_LIST_FILE} component is included.")
           ${CMAKE_CURRENT_LIST_DIR}/port/ethernetif.c
           ${CMAKE_CURRENT_LIST_DIR}/port/ethernetif_mmac.c
           ${CMAKE_CURRENT_LIST_DIR}/port/enet_ethernetif_kinetis.c
+          ${CMAKE_CURRENT_LIST_DIR}/port/ethernetif_zerocopy.c
+          ${CMAKE_CURRENT_LIST_DIR}/port/ethernetif_rx_batch.c
+          ${CMAKE_CURRENT_LIST_DIR}/port/lwip_perf.c
         )
 
   
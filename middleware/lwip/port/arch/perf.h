@@ -35,4 +35,19 @@
 #define PERF_START   /* null definition */
 #define PERF_STOP(x) /* null definition */
 
+/* Packet path latency probes, implemented in port/lwip_perf.c (see
+ * lwip_perf.h). lwip_perf_probe() records packet p passing probe point,
+ * lwip_perf_pbuf_init() stamps a new pbuf for LWIP_PBUF_CUSTOM_DATA_INIT().
+ * Only u8_t is known here (def.h includes this file). */
+#if defined(__cplusplus)
+extern "C" {
+#endif
+struct pbuf;
+void lwip_perf_probe(u8_t point, struct pbuf *p);
+void lwip_perf_pbuf_init(struct pbuf *p);
+#if defined(__cplusplus)
+}
+#endif
+#define PERF_PROBE(point, p) lwip_perf_probe((point), (p))
+
 #endif               /* __PERF_H__ */
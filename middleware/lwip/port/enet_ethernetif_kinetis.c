@@ -58,6 +58,12 @@
 
 #include "ethernetif.h"
 #include "ethernetif_priv.h"
+#if ETH_TX_ZEROCOPY
+#include "ethernetif_zerocopy.h"
+#if USE_RTOS && defined(SDK_OS_FREE_RTOS)
+#include "lwip/tcpip.h"
+#endif
+#endif /* ETH_TX_ZEROCOPY */
 
 #include "fsl_enet.h"
 #include "fsl_phy.h"
@@ -135,12 +141,29 @@
 #error "ENET_RXBUFF_NUM < (ENET_RXBD_NUM + MAX_BUFFERS_PER_FRAME)"
 #endif
 
+#if (ETH_RX_COALESCE_FRAMES > 255) || (ETH_RX_COALESCE_TIME > 0xFFFF)
+#error "ETH_RX_COALESCE_FRAMES or ETH_RX_COALESCE_TIME out of range"
+#endif
+
 /* The number of buffer descriptors in ENET TX ring. */
 #ifndef ENET_TXBD_NUM
+#if ETH_TX_ZEROCOPY
+/* A frame takes up to ETH_TX_ZEROCOPY_MAX_SEGS descriptors. */
+#define ENET_TXBD_NUM (8)
+#else
 #define ENET_TXBD_NUM (3)
 #endif
+#endif
 
-#if (CONSTANT_SIZEALIGN(ENET_TXBUFF_SIZE, FSL_ENET_BUFF_ALIGNMENT) * ENET_TXBD_NUM) < (MAX_TX_FRAMELEN)
+#if ETH_TX_ZEROCOPY
+#if ENET_TXBD_NUM < ETH_TX_ZEROCOPY_MAX_SEGS
+#error "ENET_TXBD_NUM < ETH_TX_ZEROCOPY_MAX_SEGS"
+#endif
+/* Every frame in flight holds at least one descriptor. */
+#if ETH_TX_ZEROCOPY_QUEUE_LEN <= ENET_TXBD_NUM
+#error "ETH_TX_ZEROCOPY_QUEUE_LEN <= ENET_TXBD_NUM"
+#endif
+#elif (CONSTANT_SIZEALIGN(ENET_TXBUFF_SIZE, FSL_ENET_BUFF_ALIGNMENT) * ENET_TXBD_NUM) < (MAX_TX_FRAMELEN)
 #warning \
     "The combined size of TX buffers is not enough to hold a frame of maximum length. \
 It may be or may not be possible to transmit such a frame, depending if the ENET DMA is faster \
@@ -181,7 +204,18 @@ struct ethernetif
     enet_rx_bd_struct_t *RxBuffDescrip;
     enet_tx_bd_struct_t *TxBuffDescrip;
     rx_buffer_t *RxDataBuff;
+#if ETH_RX_BATCH
+    ethernetif_rx_batch_t RxBatch;
+#endif
+#if ETH_TX_ZEROCOPY
+    enet_frame_info_t *TxFrameInfo;
+    ethernetif_tx_zerocopy_t TxZeroCopy;
+#if USE_RTOS && defined(SDK_OS_FREE_RTOS)
+    struct tcpip_callback_msg *TxReclaimMsg;
+#endif
+#else
     tx_buffer_t *TxDataBuff;
+#endif /* ETH_TX_ZEROCOPY */
     rx_pbuf_wrapper_t RxPbufs[ENET_RXBUFF_NUM];
     phy_handle_t *phyHandle;
     phy_speed_t last_speed;
@@ -201,6 +235,77 @@ void *ethernetif_get_enet_base(const uint8_t enetIdx);
 /*******************************************************************************
  * Code
  ******************************************************************************/
+#if ETH_TX_ZEROCOPY
+#if USE_RTOS && defined(SDK_OS_FREE_RTOS)
+/** Releases transmitted frames, runs on tcpip_thread. */
+static void ethernetif_tx_reclaim(void *ctx)
+{
+    struct ethernetif *ethernetif = (struct ethernetif *)ctx;
+
+    (void)ethernetif_tx_zerocopy_reclaim(&ethernetif->TxZeroCopy);
+}
+#endif
+
+/**
+ * Hands a transmitted frame back, called from ENET_ReclaimTxDescriptor().
+ * With RTOS the pbufs are released by one tcpip_thread callback per burst
+ * of TX complete events.
+ */
+static void ethernetif_tx_complete(struct ethernetif *ethernetif, enet_frame_info_t *frameInfo)
+{
+    if ((frameInfo == NULL) || (frameInfo->context == NULL))
+    {
+        return;
+    }
+
+    if (ethernetif_tx_zerocopy_complete(&ethernetif->TxZeroCopy, (struct pbuf *)frameInfo->context) != 0U)
+    {
+#if USE_RTOS && defined(SDK_OS_FREE_RTOS)
+        err_t err;
+
+#ifdef __CA7_REV
+        if (SystemGetIRQNestingLevel())
+#else
+        if (__get_IPSR())
+#endif
+        {
+            err = tcpip_callbackmsg_trycallback_fromisr(ethernetif->TxReclaimMsg);
+        }
+        else
+        {
+            err = tcpip_callbackmsg_trycallback(ethernetif->TxReclaimMsg);
+        }
+
+        if (err != ERR_OK)
+        {
+            /* Mailbox full, retried on the next TX complete and done by linkoutput anyway. */
+            ethernetif->TxZeroCopy.reclaimPending = 0U;
+        }
+#endif
+    }
+}
+#endif /* ETH_TX_ZEROCOPY */
+
+#if !(USE_RTOS && defined(SDK_OS_FREE_RTOS)) && ETH_TX_ZEROCOPY
+/* Bare metal: TX complete is polled by ENET_ReclaimTxDescriptor(), which reports through this callback. */
+static void ethernet_callback(ENET_Type *base,
+                              enet_handle_t *handle,
+#if FSL_FEATURE_ENET_QUEUE > 1
+                              uint32_t ringId,
+#endif /* FSL_FEATURE_ENET_QUEUE */
+                              enet_event_t event,
+                              enet_frame_info_t *frameInfo,
+                              void *userData)
+{
+    struct netif *netif = (struct netif *)userData;
+
+    if (event == kENET_TxEvent)
+    {
+        ethernetif_tx_complete(netif->state, frameInfo);
+    }
+}
+#endif
+
 #if USE_RTOS && defined(SDK_OS_FREE_RTOS)
 static void ethernet_callback(ENET_Type *base,
                               enet_handle_t *handle,
@@ -218,12 +323,21 @@ static void ethernet_callback(ENET_Type *base,
     switch (event)
     {
         case kENET_RxEvent:
+#if ETH_RX_BATCH
+            /* Masked until the RX task has drained the ring. */
+            ENET_DisableInterrupts(base, (uint32_t)kENET_RxFrameInterrupt);
+            ethernetif_rx_batch_irq(&ethernetif->RxBatch);
+#endif
             ethernetif_input(netif);
             break;
         case kENET_TxEvent:
         {
             portBASE_TYPE taskToWake = pdFALSE;
 
+#if ETH_TX_ZEROCOPY
+            ethernetif_tx_complete(ethernetif, frameInfo);
+#endif
+
 #ifdef __CA7_REV
             if (SystemGetIRQNestingLevel())
 #else
@@ -399,6 +513,35 @@ static void ethernetif_rx_free(ENET_Type *base, void *buffer, void *userData, ui
     SYS_ARCH_UNPROTECT(old_level);
 }
 
+#if ETH_RX_BATCH
+ethernetif_rx_batch_t *ethernetif_rx_batch_ptr(struct ethernetif *ethernetif)
+{
+    return &ethernetif->RxBatch;
+}
+
+void ethernetif_rx_int_enable(struct netif *netif, bool enable)
+{
+    struct ethernetif *ethernetif = netif->state;
+
+    if (enable)
+    {
+        ENET_EnableInterrupts(ethernetif->base, (uint32_t)kENET_RxFrameInterrupt);
+    }
+    else
+    {
+        ENET_DisableInterrupts(ethernetif->base, (uint32_t)kENET_RxFrameInterrupt);
+    }
+}
+
+#if defined(DWT)
+/** Core cycle counter, used for RX latency statistics. */
+static u32_t ethernetif_rx_clock(void)
+{
+    return DWT->CYCCNT;
+}
+#endif
+#endif /* ETH_RX_BATCH */
+
 /**
  * Initializes ENET driver.
  */
@@ -421,8 +564,13 @@ void ethernetif_plat_init(struct netif *netif,
         &(ethernetif->TxBuffDescrip[0]);              /* Aligned transmit buffer descriptor start address. */
     buffCfg[0].rxBufferAlign =
         NULL; /* Receive data buffer start address. NULL when buffers are allocated by callback for RX zero-copy. */
+#if ETH_TX_ZEROCOPY
+    buffCfg[0].txBufferAlign = NULL; /* Transmit data buffers are the pbufs. */
+    buffCfg[0].txFrameInfo   = ethernetif->TxFrameInfo; /* Transmit frame information start address. */
+#else
     buffCfg[0].txBufferAlign = &(ethernetif->TxDataBuff[0][0]); /* Transmit data buffer start address. */
     buffCfg[0].txFrameInfo = NULL; /* Transmit frame information start address. Set only if using zero-copy transmit. */
+#endif
     buffCfg[0].rxMaintainEnable = true; /* Receive buffer cache maintain. */
     buffCfg[0].txMaintainEnable = true; /* Transmit buffer cache maintain. */
 
@@ -432,6 +580,39 @@ void ethernetif_plat_init(struct netif *netif,
     config.rxBuffFree  = ethernetif_rx_free;
     config.userData    = netif;
 
+#if defined(FSL_FEATURE_ENET_HAS_INTERRUPT_COALESCE) && FSL_FEATURE_ENET_HAS_INTERRUPT_COALESCE && \
+    (ETH_RX_COALESCE_FRAMES > 0)
+    /* Only read by ENET_Init(). TX interrupts stay per frame. */
+    enet_intcoalesce_config_t intCoalesceCfg = {0};
+    for (uint8_t queue = 0; queue < (uint8_t)FSL_FEATURE_ENET_QUEUE; queue++)
+    {
+        intCoalesceCfg.txCoalesceFrameCount[queue] = 1U;
+        intCoalesceCfg.txCoalesceTimeCount[queue]  = 0xFFFFU;
+        intCoalesceCfg.rxCoalesceFrameCount[queue] = ETH_RX_COALESCE_FRAMES;
+        intCoalesceCfg.rxCoalesceTimeCount[queue]  = ETH_RX_COALESCE_TIME;
+    }
+    config.intCoalesceCfg = &intCoalesceCfg;
+#endif
+
+#if ETH_RX_BATCH
+#if defined(DWT)
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    ethernetif_rx_batch_init(&ethernetif->RxBatch, ethernetif_rx_clock);
+#else
+    ethernetif_rx_batch_init(&ethernetif->RxBatch, NULL);
+#endif
+#endif /* ETH_RX_BATCH */
+#if ETH_TX_ZEROCOPY
+    config.callback = ethernet_callback;
+
+    ethernetif_tx_zerocopy_init(&ethernetif->TxZeroCopy);
+#if USE_RTOS && defined(SDK_OS_FREE_RTOS)
+    ethernetif->TxReclaimMsg = tcpip_callbackmsg_new(ethernetif_tx_reclaim, ethernetif);
+    LWIP_ASSERT("TX reclaim message allocation failed", ethernetif->TxReclaimMsg != NULL);
+#endif
+#endif /* ETH_TX_ZEROCOPY */
+
     /* Used for detection of change.
        Initilize to value different than any possible enum value. */
     ethernetif->last_speed   = (phy_speed_t)0xa5a5;
@@ -517,6 +698,11 @@ void ethernetif_plat_init(struct netif *netif,
     /* Initialize the ENET module. */
     ENET_Init(ethernetif->base, &ethernetif->handle, &config, &buffCfg[0], netif->hwaddr, ethernetifConfig->srcClockHz);
 
+#if ETH_TX_ZEROCOPY
+    /* Descriptors are reclaimed in the TX interrupt (or polled), which returns the frame context. */
+    (void)ENET_SetTxReclaim(&ethernetif->handle, true, 0);
+#endif
+
     ENET_ActiveRead(ethernetif->base);
 }
 
@@ -568,6 +754,96 @@ void ethernetif_on_link_down(struct netif *netif_)
     eif->last_link_up      = false;
 }
 
+#if ETH_TX_ZEROCOPY
+/**
+ * Sends frame scattered over several buffers via ENET without copying.
+ * The segments are cleaned from D-cache one by one by the driver.
+ */
+static err_t enet_start_tx_frame(struct ethernetif *ethernetif, enet_tx_frame_struct_t *txFrame)
+{
+#if USE_RTOS && defined(SDK_OS_FREE_RTOS)
+    {
+        status_t result;
+
+        do
+        {
+            result = ENET_StartTxFrame(ethernetif->base, &ethernetif->handle, txFrame, 0);
+
+            if (result == kStatus_ENET_TxFrameBusy)
+            {
+                xEventGroupWaitBits(ethernetif->enetTransmitAccessEvent, ethernetif->txFlag, pdTRUE, (BaseType_t) false,
+                                    portMAX_DELAY);
+            }
+
+        } while (result == kStatus_ENET_TxFrameBusy);
+        return (result == kStatus_Success) ? ERR_OK : ERR_BUF;
+    }
+#else
+    {
+        uint32_t counter;
+        status_t result;
+
+        for (counter = ETHERNETIF_TIMEOUT; counter != 0U; counter--)
+        {
+            result = ENET_StartTxFrame(ethernetif->base, &ethernetif->handle, txFrame, 0);
+            if (result != kStatus_ENET_TxFrameBusy)
+            {
+                return (result == kStatus_Success) ? ERR_OK : ERR_BUF;
+            }
+
+            /* No TX interrupt in bare metal, free the descriptors of sent frames. */
+            ENET_ReclaimTxDescriptor(ethernetif->base, &ethernetif->handle, 0);
+        }
+
+        return ERR_TIMEOUT;
+    }
+#endif
+}
+
+/**
+ * Sends the pbuf chain, referenced until TX complete.
+ */
+static err_t ethernetif_send_zerocopy(struct ethernetif *ethernetif, struct pbuf *p)
+{
+    ethernetif_tx_seg_t segs[ETH_TX_ZEROCOPY_MAX_SEGS];
+    enet_buffer_struct_t txBuff[ETH_TX_ZEROCOPY_MAX_SEGS];
+    enet_tx_frame_struct_t txFrame = {0};
+    struct pbuf *frame;
+    u16_t segsNum;
+    u16_t i;
+    err_t result;
+
+#if !(USE_RTOS && defined(SDK_OS_FREE_RTOS))
+    ENET_ReclaimTxDescriptor(ethernetif->base, &ethernetif->handle, 0);
+#endif
+    /* Drop references of already sent frames in case the callback is late. */
+    (void)ethernetif_tx_zerocopy_reclaim(&ethernetif->TxZeroCopy);
+
+    frame = ethernetif_tx_zerocopy_prepare(&ethernetif->TxZeroCopy, p, segs, &segsNum);
+    if (frame == NULL)
+    {
+        return ERR_MEM;
+    }
+
+    for (i = 0; i < segsNum; i++)
+    {
+        txBuff[i].buffer = segs[i].buffer;
+        txBuff[i].length = segs[i].length;
+    }
+
+    txFrame.txBuffArray = txBuff;
+    txFrame.txBuffNum   = segsNum;
+    txFrame.context     = frame;
+
+    result = enet_start_tx_frame(ethernetif, &txFrame);
+    if (result != ERR_OK)
+    {
+        pbuf_free(frame);
+    }
+
+    return result;
+}
+#else
 /**
  * Returns next buffer for TX.
  * Can wait if no buffer available.
@@ -617,6 +893,7 @@ static err_t enet_send_frame(struct ethernetif *ethernetif, unsigned char *data,
     }
 #endif
 }
+#endif /* ETH_TX_ZEROCOPY */
 
 /**
  * Reclaims RX buffer held by the p after p is no longer used
@@ -690,7 +967,7 @@ static struct pbuf *ethernetif_rx_frame_to_pbufs(struct ethernetif *ethernetif,
     return p;
 }
 
-struct pbuf *ethernetif_linkinput(struct netif *netif)
+struct pbuf *ethernetif_linkinput_fetch(struct netif *netif, u8_t *dropped)
 {
     struct ethernetif *ethernetif                       = netif->state;
     enet_buffer_struct_t buffers[MAX_BUFFERS_PER_FRAME] = {{0}};
@@ -698,6 +975,12 @@ struct pbuf *ethernetif_linkinput(struct netif *netif)
     struct pbuf *p                                      = NULL;
     status_t status;
 
+#if ETH_TX_ZEROCOPY && !(USE_RTOS && defined(SDK_OS_FREE_RTOS))
+    /* Bare metal polls here too, so sent frames are released when there is no more TX. */
+    ENET_ReclaimTxDescriptor(ethernetif->base, &ethernetif->handle, 0);
+    (void)ethernetif_tx_zerocopy_reclaim(&ethernetif->TxZeroCopy);
+#endif
+
     /* Read frame. */
     status = ENET_GetRxFrame(ethernetif->base, &ethernetif->handle, &rxFrame, 0);
 
@@ -706,6 +989,10 @@ struct pbuf *ethernetif_linkinput(struct netif *netif)
         case kStatus_Success:
             /* Frame read, process it into pbufs. */
             p = ethernetif_rx_frame_to_pbufs(ethernetif, &rxFrame);
+            if (p == NULL)
+            {
+                *dropped = 1U;
+            }
             break;
 
         case kStatus_ENET_RxFrameEmpty:
@@ -717,6 +1004,7 @@ struct pbuf *ethernetif_linkinput(struct netif *netif)
             LWIP_DEBUGF(NETIF_DEBUG, ("ethernetif_linkinput: RxFrameError\n"));
             LINK_STATS_INC(link.drop);
             MIB2_STATS_NETIF_INC(netif, ifindiscards);
+            *dropped = 1U;
             break;
 
         case kStatus_ENET_RxFrameDrop:
@@ -724,6 +1012,7 @@ struct pbuf *ethernetif_linkinput(struct netif *netif)
              * because new buffer(s) allocation failed in the ENET driver. */
             LINK_STATS_INC(link.drop);
             MIB2_STATS_NETIF_INC(netif, ifindiscards);
+            *dropped = 1U;
             break;
 
         default:
@@ -734,20 +1023,31 @@ struct pbuf *ethernetif_linkinput(struct netif *netif)
     return p;
 }
 
+struct pbuf *ethernetif_linkinput(struct netif *netif)
+{
+    u8_t dropped = 0U;
+
+    return ethernetif_linkinput_fetch(netif, &dropped);
+}
+
 err_t ethernetif_linkoutput(struct netif *netif, struct pbuf *p)
 {
     err_t result;
     struct ethernetif *ethernetif = netif->state;
+#if !ETH_TX_ZEROCOPY
     unsigned char *pucBuffer;
     u16_t uCopied;
+#endif
 
     LWIP_ASSERT("Output packet buffer empty", p);
 
+#if !ETH_TX_ZEROCOPY
     pucBuffer = enet_get_tx_buffer(ethernetif);
     if (pucBuffer == NULL)
     {
         return ERR_BUF;
     }
+#endif
 
     /* Initiate transfer. */
 
@@ -761,6 +1061,9 @@ err_t ethernetif_linkoutput(struct netif *netif, struct pbuf *p)
     }
     else
     {
+#if ETH_TX_ZEROCOPY
+        result = ethernetif_send_zerocopy(ethernetif, p);
+#else
         if (p->len == p->tot_len)
         {
             /* No pbuf chain, don't have to copy -> faster. */
@@ -775,6 +1078,7 @@ err_t ethernetif_linkoutput(struct netif *netif, struct pbuf *p)
 
         /* Send frame. */
         result = enet_send_frame(ethernetif, pucBuffer, p->tot_len);
+#endif /* ETH_TX_ZEROCOPY */
     }
 
     if (((u8_t *)p->payload)[0] & 1)
@@ -825,14 +1129,22 @@ err_t ethernetif0_init(struct netif *netif)
     AT_NONCACHEABLE_SECTION_ALIGN(static enet_rx_bd_struct_t rxBuffDescrip_0[ENET_RXBD_NUM], FSL_ENET_BUFF_ALIGNMENT);
     AT_NONCACHEABLE_SECTION_ALIGN(static enet_tx_bd_struct_t txBuffDescrip_0[ENET_TXBD_NUM], FSL_ENET_BUFF_ALIGNMENT);
     SDK_ALIGN(static rx_buffer_t rxDataBuff_0[ENET_RXBUFF_NUM], FSL_ENET_BUFF_ALIGNMENT);
+#if ETH_TX_ZEROCOPY
+    static enet_frame_info_t txFrameInfo_0[ENET_TXBD_NUM];
+#else
     SDK_ALIGN(static tx_buffer_t txDataBuff_0[ENET_TXBD_NUM], FSL_ENET_BUFF_ALIGNMENT);
+#endif
 
     ethernetif_config_t *cfg = (ethernetif_config_t *)netif->state;
 
     ethernetif_0.RxBuffDescrip = &(rxBuffDescrip_0[0]);
     ethernetif_0.TxBuffDescrip = &(txBuffDescrip_0[0]);
     ethernetif_0.RxDataBuff    = &(rxDataBuff_0[0]);
+#if ETH_TX_ZEROCOPY
+    ethernetif_0.TxFrameInfo   = &(txFrameInfo_0[0]);
+#else
     ethernetif_0.TxDataBuff    = &(txDataBuff_0[0]);
+#endif
 
     ethernetif_0.phyHandle = cfg->phyHandle;
 
@@ -858,14 +1170,22 @@ err_t ethernetif1_init(struct netif *netif)
     AT_NONCACHEABLE_SECTION_ALIGN(static enet_rx_bd_struct_t rxBuffDescrip_1[ENET_RXBD_NUM], FSL_ENET_BUFF_ALIGNMENT);
     AT_NONCACHEABLE_SECTION_ALIGN(static enet_tx_bd_struct_t txBuffDescrip_1[ENET_TXBD_NUM], FSL_ENET_BUFF_ALIGNMENT);
     SDK_ALIGN(static rx_buffer_t rxDataBuff_1[ENET_RXBUFF_NUM], FSL_ENET_BUFF_ALIGNMENT);
+#if ETH_TX_ZEROCOPY
+    static enet_frame_info_t txFrameInfo_1[ENET_TXBD_NUM];
+#else
     SDK_ALIGN(static tx_buffer_t txDataBuff_1[ENET_TXBD_NUM], FSL_ENET_BUFF_ALIGNMENT);
+#endif
 
     ethernetif_config_t *cfg = (ethernetif_config_t *)netif->state;
 
     ethernetif_1.RxBuffDescrip = &(rxBuffDescrip_1[0]);
     ethernetif_1.TxBuffDescrip = &(txBuffDescrip_1[0]);
     ethernetif_1.RxDataBuff    = &(rxDataBuff_1[0]);
+#if ETH_TX_ZEROCOPY
+    ethernetif_1.TxFrameInfo   = &(txFrameInfo_1[0]);
+#else
     ethernetif_1.TxDataBuff    = &(txDataBuff_1[0]);
+#endif
 
     ethernetif_1.phyHandle = cfg->phyHandle;
 
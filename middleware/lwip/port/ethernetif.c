@@ -115,6 +115,10 @@ static TaskHandle_t ethernetif_rx_task = NULL;
 
 #endif /* #if ETH_DO_RX_IN_SEPARATE_TASK */
 
+#if ETH_RX_BATCH && defined(SDK_OS_FREE_RTOS) && !ETH_DO_RX_IN_SEPARATE_TASK
+#error "ETH_RX_BATCH needs ETH_DO_RX_IN_SEPARATE_TASK, the core lock cannot be taken in the RX interrupt."
+#endif
+
 #if ((LWIP_IPV6 == 1) && (LWIP_NETIF_EXT_STATUS_CALLBACK == 1))
 static netif_status_callback_fn ipv6_valid_state_user_cb;
 #endif /* ((LWIP_IPV6 == 1) && (LWIP_NETIF_EXT_STATUS_CALLBACK == 1)) */
@@ -198,6 +202,32 @@ void ethernetif_phy_init(struct ethernetif *ethernetif, const ethernetif_config_
     }
 }
 
+#if ETH_RX_BATCH
+static void fetch_received_pkts(struct netif *netif_)
+{
+    ethernetif_rx_batch_t *rb = ethernetif_rx_batch_ptr(netif_->state);
+
+    /* Poll in budgets, the RX interrupt stays masked meanwhile. */
+    while (ethernetif_rx_batch_poll(rb, netif_, ethernetif_linkinput_fetch, ETH_RX_BATCH_BUDGET) == ETH_RX_BATCH_BUDGET)
+    {
+#if ETH_DO_RX_IN_SEPARATE_TASK
+        /* Let tasks of the same priority run between budgets. */
+        taskYIELD();
+#endif
+    }
+
+#if ETH_DO_RX_IN_SEPARATE_TASK
+    /* Ring is empty. A frame received since the last poll keeps its
+     * interrupt pending, so it fires as soon as it is unmasked. */
+    ethernetif_rx_int_enable(netif_, true);
+#endif
+}
+
+void ethernetif_get_rx_batch_stats(struct netif *netif_, ethernetif_rx_batch_stats_t *stats, bool reset)
+{
+    ethernetif_rx_batch_get_stats(ethernetif_rx_batch_ptr(netif_->state), stats, reset ? 1U : 0U);
+}
+#else
 static void fetch_received_pkts(struct netif *netif_)
 {
     /* Move received packets into new pbufs. */
@@ -217,6 +247,7 @@ static void fetch_received_pkts(struct netif *netif_)
         }
 
         /* Pass all packets to ethernet_input, which decides what packets it supports */
+        PERF_PROBE(LWIP_PERF_NETIF_RX, p);
         if (netif_->input(p, netif_) != (err_t)ERR_OK)
         {
             LWIP_DEBUGF(NETIF_DEBUG, ("fetch_received_pkts: IP input error\n"));
@@ -225,6 +256,7 @@ static void fetch_received_pkts(struct netif *netif_)
         }
     }
 }
+#endif /* ETH_RX_BATCH */
 
 #if ETH_DO_RX_IN_SEPARATE_TASK
 static uint32_t netif_to_bitmask(const struct netif *netif_)
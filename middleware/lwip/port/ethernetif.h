@@ -62,6 +62,34 @@
 
 #define ETHERNETIF_TIMEOUT (0xFFFU)
 
+/* Hand pbuf payloads to the TX buffer descriptors instead of copying every
+ * frame into a TX buffer. The pbufs are referenced until TX complete. */
+#ifndef ETH_TX_ZEROCOPY
+#define ETH_TX_ZEROCOPY (0)
+#endif
+
+/* NAPI style RX: the RX interrupt stays masked while the RX task drains the
+ * ring, up to ETH_RX_BATCH_BUDGET frames per core lock acquisition.
+ * Under FreeRTOS it needs ETH_DO_RX_IN_SEPARATE_TASK. */
+#ifndef ETH_RX_BATCH
+#define ETH_RX_BATCH (0)
+#endif
+
+#if ETH_RX_BATCH
+#include "ethernetif_rx_batch.h"
+#endif
+
+/* RX interrupt coalescing: interrupt after this many frames, or when the
+ * first frame is older than ETH_RX_COALESCE_TIME (in 64 ENET clock cycles).
+ * 0 disables coalescing. */
+#ifndef ETH_RX_COALESCE_FRAMES
+#define ETH_RX_COALESCE_FRAMES (0)
+#endif
+
+#ifndef ETH_RX_COALESCE_TIME
+#define ETH_RX_COALESCE_TIME (0)
+#endif
+
 #ifndef ETH_LINK_POLLING_INTERVAL_MS
 #define ETH_LINK_POLLING_INTERVAL_MS (1500)
 #endif
@@ -142,6 +170,18 @@ err_t ethernetif1_init(struct netif *netif);
  */
 void ethernetif_input(struct netif *netif_);
 
+#if ETH_RX_BATCH
+/**
+ * Gets RX batching statistics: frames, batches, interrupts and
+ * interrupt to processed latency.
+ *
+ * @param netif_ the lwip network interface structure for this ethernetif
+ * @param stats filled in
+ * @param reset clear the statistics after reading
+ */
+void ethernetif_get_rx_batch_stats(struct netif *netif_, ethernetif_rx_batch_stats_t *stats, bool reset);
+#endif /* ETH_RX_BATCH */
+
 /**
  * This function probes phy for current link state, speed and duplex and
  * passes those information to lwIP and ethernet driver.
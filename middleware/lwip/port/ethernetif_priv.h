@@ -78,6 +78,21 @@ void *ethernetif_get_enet_qos_base(const uint8_t enetIdx);
 
 void **ethernetif_base_ptr(struct ethernetif *ethernetif);
 
+#if ETH_RX_BATCH
+/**
+ * Returns RX batching state of the interface.
+ */
+ethernetif_rx_batch_t *ethernetif_rx_batch_ptr(struct ethernetif *ethernetif);
+
+/**
+ * Masks or unmasks the MAC RX frame interrupt.
+ *
+ * @param netif  the lwip network interface
+ * @param enable true to unmask
+ */
+void ethernetif_rx_int_enable(struct netif *netif, bool enable);
+#endif /* ETH_RX_BATCH */
+
 #if LWIP_IPV4 && LWIP_IGMP
 err_t ethernetif_igmp_mac_filter(struct netif *netif, const ip4_addr_t *group, enum netif_mac_filter_action action);
 #endif
@@ -96,6 +111,17 @@ err_t ethernetif_mld_mac_filter(struct netif *netif, const ip6_addr_t *group, en
  */
 struct pbuf *ethernetif_linkinput(struct netif *netif);
 
+/**
+ * ethernetif_linkinput() which also tells a dropped frame from an empty
+ * RX ring, an ethernetif_rx_fetch_fn for ethernetif_rx_batch_poll().
+ *
+ * @param netif the lwip network interface structure for this ethernetif
+ * @param dropped set to 1 when a frame was taken from the ring but dropped
+ * @return a pbuf filled with the received packet (including MAC header)
+ *         NULL on an empty ring or a dropped frame
+ */
+struct pbuf *ethernetif_linkinput_fetch(struct netif *netif, u8_t *dropped);
+
 /**
  * This function should do the actual transmission of the packet. The packet is
  * contained in the pbuf that is passed to the function. This pbuf
@@ -0,0 +1,198 @@
+/*
+ * Copyright 2026 NXP
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "lwip/opt.h"
+#include "lwip/pbuf.h"
+#include "lwip/sys.h"
+#include "lwip/ip.h"
+#include "netif/ethernet.h"
+#if !NO_SYS
+#include "lwip/tcpip.h"
+#endif
+
+#include "ethernetif_rx_batch.h"
+
+#include <string.h>
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+#if NO_SYS || !LWIP_TCPIP_CORE_LOCKING
+#define RX_BATCH_LOCK()
+#define RX_BATCH_UNLOCK()
+#else
+#define RX_BATCH_LOCK()   LOCK_TCPIP_CORE()
+#define RX_BATCH_UNLOCK() UNLOCK_TCPIP_CORE()
+#endif
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+
+static void rx_batch_reset_stats(ethernetif_rx_batch_stats_t *stats)
+{
+    (void)memset(stats, 0, sizeof(*stats));
+    stats->latencyMin = 0xFFFFFFFFU;
+}
+
+void ethernetif_rx_batch_init(ethernetif_rx_batch_t *rb, u32_t (*clock)(void))
+{
+    (void)memset(rb, 0, sizeof(*rb));
+    rb->clock = clock;
+    rx_batch_reset_stats(&rb->stats);
+}
+
+void ethernetif_rx_batch_irq(ethernetif_rx_batch_t *rb)
+{
+    /* The interrupt is the only writer of irqCount, the statistics take the
+     * difference to irqCountReset, so a reset never races this increment. */
+    rb->irqCount++;
+
+    /* Only the first interrupt of a wakeup starts the latency measurement. */
+    if ((rb->clock != NULL) && (rb->irqStampValid == 0U))
+    {
+        rb->irqStamp      = rb->clock();
+        rb->irqStampValid = 1U;
+    }
+}
+
+#if NO_SYS || LWIP_TCPIP_CORE_LOCKING
+/* Same decision as tcpip_input(), done here to skip the tcpip_thread mailbox. */
+static err_t rx_batch_stack_input(struct pbuf *p, struct netif *netif)
+{
+#if LWIP_ETHERNET
+    if ((netif->flags & (NETIF_FLAG_ETHARP | NETIF_FLAG_ETHERNET)) != 0U)
+    {
+        return ethernet_input(p, netif);
+    }
+#endif /* LWIP_ETHERNET */
+    return ip_input(p, netif);
+}
+#endif
+
+/* Passes one frame to the stack, the core lock is held. */
+static void rx_batch_input(ethernetif_rx_batch_t *rb, struct netif *netif, struct pbuf *p)
+{
+    err_t err;
+
+#if NO_SYS || LWIP_TCPIP_CORE_LOCKING
+    err = rx_batch_stack_input(p, netif);
+#else
+    err = netif->input(p, netif);
+#endif
+
+    if (err != ERR_OK)
+    {
+        rb->stats.inputErrors++;
+        (void)pbuf_free(p);
+    }
+}
+
+static void rx_batch_latency(ethernetif_rx_batch_t *rb)
+{
+    u32_t latency = rb->clock() - rb->irqStamp;
+
+    rb->irqStampValid = 0U;
+    rb->stats.latencyCount++;
+    rb->stats.latencySum += latency;
+    if (latency < rb->stats.latencyMin)
+    {
+        rb->stats.latencyMin = latency;
+    }
+    if (latency > rb->stats.latencyMax)
+    {
+        rb->stats.latencyMax = latency;
+    }
+}
+
+u16_t ethernetif_rx_batch_poll(ethernetif_rx_batch_t *rb,
+                               struct netif *netif,
+                               ethernetif_rx_fetch_fn fetch,
+                               u16_t budget)
+{
+    u16_t taken = 0U;
+    u16_t n     = 0U;
+    u8_t empty  = 0U;
+
+    if (budget > ETH_RX_BATCH_BUDGET)
+    {
+        budget = ETH_RX_BATCH_BUDGET;
+    }
+
+    /* Each frame goes to the stack as soon as it is taken. Holding the
+     * batch first would pin up to a budget of zero-copy RX buffers, more
+     * than the ENET_RXBUFF_NUM - ENET_RXBD_NUM spare ones. */
+    while (taken < budget)
+    {
+        u8_t dropped   = 0U;
+        struct pbuf *p = fetch(netif, &dropped);
+
+        if (p == NULL)
+        {
+            if (dropped == 0U)
+            {
+                empty = 1U;
+                break;
+            }
+            rb->stats.dropped++;
+        }
+        else
+        {
+            if (n == 0U)
+            {
+                /* Taken on the first frame, an empty poll doesn't lock. */
+                RX_BATCH_LOCK();
+            }
+            PERF_PROBE(LWIP_PERF_NETIF_RX, p);
+            rx_batch_input(rb, netif, p);
+            n++;
+        }
+        taken++;
+    }
+
+    if (n > 0U)
+    {
+        RX_BATCH_UNLOCK();
+
+        rb->stats.frames += n;
+        rb->stats.batches++;
+        if (n > rb->stats.maxBatch)
+        {
+            rb->stats.maxBatch = n;
+        }
+    }
+
+    if (taken == budget)
+    {
+        rb->stats.budgetExhausted++;
+    }
+
+    /* Only a ring found empty ends the wakeup, a dropped frame doesn't. */
+    if ((empty != 0U) && (rb->irqStampValid != 0U))
+    {
+        rx_batch_latency(rb);
+    }
+
+    return taken;
+}
+
+void ethernetif_rx_batch_get_stats(ethernetif_rx_batch_t *rb, ethernetif_rx_batch_stats_t *stats, u8_t reset)
+{
+    u32_t irqCount = rb->irqCount;
+    SYS_ARCH_DECL_PROTECT(old_level);
+
+    SYS_ARCH_PROTECT(old_level);
+    *stats      = rb->stats;
+    stats->irqs = irqCount - rb->irqCountReset;
+    if (reset != 0U)
+    {
+        rx_batch_reset_stats(&rb->stats);
+        rb->irqCountReset = irqCount;
+    }
+    SYS_ARCH_UNPROTECT(old_level);
+}
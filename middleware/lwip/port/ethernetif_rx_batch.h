@@ -0,0 +1,123 @@
+/*
+ * Copyright 2026 NXP
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef ETHERNETIF_RX_BATCH_H
+#define ETHERNETIF_RX_BATCH_H
+
+#include "lwip/opt.h"
+#include "lwip/netif.h"
+#include "lwip/pbuf.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+/* Maximum number of frames taken from the RX ring under one core lock.
+ * The poll loop yields after every budget. */
+#ifndef ETH_RX_BATCH_BUDGET
+#define ETH_RX_BATCH_BUDGET (16U)
+#endif
+
+/**
+ * Returns the next received frame. NULL with *dropped set when a frame was
+ * taken from the RX ring but dropped (receive error or no buffer), NULL
+ * with *dropped left 0 when the ring is empty.
+ */
+typedef struct pbuf *(*ethernetif_rx_fetch_fn)(struct netif *netif, u8_t *dropped);
+
+/**
+ * RX batching statistics. Latency is measured from the first RX interrupt
+ * after an idle ring until the frames of that wakeup are processed, in
+ * ticks of the clock passed to ethernetif_rx_batch_init().
+ */
+typedef struct ethernetif_rx_batch_stats
+{
+    u32_t frames;          /*!< Frames passed to the stack. */
+    u32_t inputErrors;     /*!< Frames dropped by the stack input function. */
+    u32_t dropped;         /*!< Frames dropped by the driver. */
+    u32_t irqs;            /*!< RX interrupts (wakeups), see irqCount. */
+    u32_t batches;         /*!< Non-empty batches, i.e. core lock acquisitions. */
+    u32_t budgetExhausted; /*!< Batches which used up the whole budget. */
+    u16_t maxBatch;        /*!< Largest batch seen. */
+    u32_t latencyMin;      /*!< Shortest interrupt to processed latency. */
+    u32_t latencyMax;      /*!< Longest interrupt to processed latency. */
+    u32_t latencySum;      /*!< Sum of latencies, divide by latencyCount. */
+    u32_t latencyCount;    /*!< Number of latency samples. */
+} ethernetif_rx_batch_stats_t;
+
+/**
+ * RX batching state of one interface.
+ */
+typedef struct ethernetif_rx_batch
+{
+    u32_t (*clock)(void);               /*!< Free running clock for latency, NULL to disable. */
+    volatile u32_t irqStamp;            /*!< Clock at the first not yet served interrupt. */
+    volatile u8_t irqStampValid;        /*!< irqStamp is set. */
+    volatile u32_t irqCount;            /*!< RX interrupts, written by the interrupt only. */
+    u32_t irqCountReset;                /*!< irqCount when the statistics were last reset. */
+    ethernetif_rx_batch_stats_t stats;  /*!< Statistics. */
+} ethernetif_rx_batch_t;
+
+/*******************************************************************************
+ * API
+ ******************************************************************************/
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Initializes RX batching state.
+ *
+ * @param rb RX batching state
+ * @param clock free running clock used for latency statistics, may be NULL
+ */
+void ethernetif_rx_batch_init(ethernetif_rx_batch_t *rb, u32_t (*clock)(void));
+
+/**
+ * Records an RX interrupt. Called from the interrupt, which also masks the
+ * RX interrupt until the poll loop has drained the ring.
+ *
+ * @param rb RX batching state
+ */
+void ethernetif_rx_batch_irq(ethernetif_rx_batch_t *rb);
+
+/**
+ * Takes up to budget frames from the RX ring and passes each one to the
+ * stack as soon as it is taken, all under a single core lock acquisition.
+ * A frame is never held back for the rest of the batch, so a batch keeps
+ * no more RX buffers than the stack itself does. Without
+ * LWIP_TCPIP_CORE_LOCKING the frames are posted one by one with
+ * netif->input.
+ *
+ * @param rb RX batching state
+ * @param netif the interface; ethernet_input() or ip_input() is chosen
+ *              from its flags, as tcpip_input() does
+ * @param fetch function returning the next received frame
+ * @param budget maximum number of frames, at most ETH_RX_BATCH_BUDGET
+ * @return number of frames taken, dropped ones included; less than budget
+ *         means the ring is empty and the RX interrupt can be unmasked
+ */
+u16_t ethernetif_rx_batch_poll(ethernetif_rx_batch_t *rb,
+                               struct netif *netif,
+                               ethernetif_rx_fetch_fn fetch,
+                               u16_t budget);
+
+/**
+ * Copies statistics.
+ *
+ * @param rb RX batching state
+ * @param stats filled in
+ * @param reset clear the statistics after copying
+ */
+void ethernetif_rx_batch_get_stats(ethernetif_rx_batch_t *rb, ethernetif_rx_batch_stats_t *stats, u8_t reset);
+
+#if defined(__cplusplus)
+}
+#endif /* __cplusplus */
+
+#endif /* ETHERNETIF_RX_BATCH_H */
@@ -0,0 +1,118 @@
+/*
+ * Copyright 2026 NXP
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "lwip/opt.h"
+#include "lwip/pbuf.h"
+
+#include "ethernetif_zerocopy.h"
+
+#include <string.h>
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+
+void ethernetif_tx_zerocopy_init(ethernetif_tx_zerocopy_t *zc)
+{
+    (void)memset(zc, 0, sizeof(*zc));
+}
+
+struct pbuf *ethernetif_tx_zerocopy_prepare(ethernetif_tx_zerocopy_t *zc,
+                                            struct pbuf *p,
+                                            ethernetif_tx_seg_t *segs,
+                                            u16_t *segsNum)
+{
+    struct pbuf *q;
+    u16_t n       = 0U;
+    u8_t zeroCopy = 1U;
+
+    LWIP_ASSERT("Output packet buffer empty", (p != NULL) && (p->tot_len > 0U));
+
+    for (q = p; q != NULL; q = q->next)
+    {
+        if (q->len == 0U)
+        {
+            continue;
+        }
+
+        /* PBUF_REF data may change once the stack returns, it has to be copied
+         * when the frame outlives the call, same as etharp queueing does. */
+        if ((n == ETH_TX_ZEROCOPY_MAX_SEGS) || PBUF_NEEDS_COPY(q) ||
+            ((((mem_ptr_t)q->payload) % ETH_TX_ZEROCOPY_SEG_ALIGN) != 0U))
+        {
+            zeroCopy = 0U;
+            break;
+        }
+
+        segs[n].buffer = q->payload;
+        segs[n].length = q->len;
+        n++;
+    }
+
+    if (zeroCopy != 0U)
+    {
+        /* Held until TX complete, this also keeps TCP from rewriting
+         * a segment which is still queued (tcp_output_segment_busy). */
+        pbuf_ref(p);
+        zc->framesZeroCopy++;
+        *segsNum = n;
+        return p;
+    }
+
+    q = pbuf_clone(PBUF_RAW, PBUF_RAM, p);
+    if (q == NULL)
+    {
+        return NULL;
+    }
+
+    LWIP_ASSERT("pbuf_clone payload misaligned", (((mem_ptr_t)q->payload) % ETH_TX_ZEROCOPY_SEG_ALIGN) == 0U);
+
+    zc->framesCopied++;
+    segs[0].buffer = q->payload;
+    segs[0].length = q->len;
+    *segsNum       = 1U;
+    return q;
+}
+
+u8_t ethernetif_tx_zerocopy_complete(ethernetif_tx_zerocopy_t *zc, struct pbuf *frame)
+{
+    u16_t head = zc->doneHead;
+    u16_t next = (u16_t)((head + 1U) % ETH_TX_ZEROCOPY_QUEUE_LEN);
+
+    LWIP_ASSERT("TX complete queue overflow, increase ETH_TX_ZEROCOPY_QUEUE_LEN", next != zc->doneTail);
+
+    /* Both are volatile, so the entry is stored before the index publishes it. */
+    zc->done[head] = frame;
+    zc->doneHead   = next;
+
+    if (zc->reclaimPending != 0U)
+    {
+        return 0U;
+    }
+
+    zc->reclaimPending = 1U;
+    return 1U;
+}
+
+u16_t ethernetif_tx_zerocopy_reclaim(ethernetif_tx_zerocopy_t *zc)
+{
+    u16_t tail  = zc->doneTail;
+    u16_t count = 0U;
+
+    /* Cleared first, a frame completing from now on requests a new reclaim. */
+    zc->reclaimPending = 0U;
+
+    while (tail != zc->doneHead)
+    {
+        (void)pbuf_free(zc->done[tail]);
+        tail         = (u16_t)((tail + 1U) % ETH_TX_ZEROCOPY_QUEUE_LEN);
+        zc->doneTail = tail;
+        count++;
+    }
+
+    return count;
+}
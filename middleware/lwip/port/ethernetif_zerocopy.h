@@ -0,0 +1,118 @@
+/*
+ * Copyright 2026 NXP
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef ETHERNETIF_ZEROCOPY_H
+#define ETHERNETIF_ZEROCOPY_H
+
+#include "lwip/opt.h"
+#include "lwip/pbuf.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+/* Maximum number of buffer descriptors one frame may be scattered to.
+ * Longer pbuf chains are copied into a single pbuf first. */
+#ifndef ETH_TX_ZEROCOPY_MAX_SEGS
+#define ETH_TX_ZEROCOPY_MAX_SEGS (4U)
+#endif
+
+/* Required alignment of the start address of every segment, 1 for none. */
+#ifndef ETH_TX_ZEROCOPY_SEG_ALIGN
+#define ETH_TX_ZEROCOPY_SEG_ALIGN (1U)
+#endif
+
+/* Length of the TX complete queue. Must be greater than the number of frames
+ * which can be in flight, i.e. the number of TX buffer descriptors. */
+#ifndef ETH_TX_ZEROCOPY_QUEUE_LEN
+#define ETH_TX_ZEROCOPY_QUEUE_LEN (16U)
+#endif
+
+/**
+ * One contiguous part of a frame handed to a TX buffer descriptor.
+ */
+typedef struct ethernetif_tx_seg
+{
+    void *buffer;
+    u16_t length;
+} ethernetif_tx_seg_t;
+
+/**
+ * Zero-copy TX state of one interface.
+ *
+ * Frames handed to the MAC keep a reference to their pbuf. The TX complete
+ * interrupt only queues the pbuf, the reference is dropped later by
+ * ethernetif_tx_zerocopy_reclaim() in the lwIP thread context.
+ */
+typedef struct ethernetif_tx_zerocopy
+{
+    struct pbuf *volatile done[ETH_TX_ZEROCOPY_QUEUE_LEN]; /*!< Transmitted frames waiting for pbuf_free(). */
+    volatile u16_t doneHead;                               /*!< Written by the TX complete context only. */
+    volatile u16_t doneTail;                               /*!< Written by the reclaim context only. */
+    volatile u8_t reclaimPending;                          /*!< A reclaim has been requested. */
+    u32_t framesZeroCopy;                                  /*!< Frames sent straight from the pbuf chain. */
+    u32_t framesCopied;                                    /*!< Frames which had to be copied first. */
+} ethernetif_tx_zerocopy_t;
+
+/*******************************************************************************
+ * API
+ ******************************************************************************/
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Initializes zero-copy TX state.
+ */
+void ethernetif_tx_zerocopy_init(ethernetif_tx_zerocopy_t *zc);
+
+/**
+ * Maps a frame to TX segments.
+ *
+ * The pbuf chain is used directly unless it has more than
+ * ETH_TX_ZEROCOPY_MAX_SEGS non-empty pbufs, a misaligned payload, or
+ * volatile (PBUF_REF) data. In that case it is copied into a new PBUF_RAM
+ * pbuf.
+ *
+ * @param zc zero-copy TX state
+ * @param p the frame to send
+ * @param segs array of ETH_TX_ZEROCOPY_MAX_SEGS entries, filled in
+ * @param segsNum number of segments used
+ * @return the pbuf referenced by the segments, it has to be passed to
+ *         ethernetif_tx_zerocopy_complete() once sent or freed with
+ *         pbuf_free() if it could not be sent; NULL on memory error
+ */
+struct pbuf *ethernetif_tx_zerocopy_prepare(ethernetif_tx_zerocopy_t *zc,
+                                            struct pbuf *p,
+                                            ethernetif_tx_seg_t *segs,
+                                            u16_t *segsNum);
+
+/**
+ * Queues a transmitted frame for release. Safe to call from interrupt
+ * context, must not be called concurrently with itself.
+ *
+ * @param zc zero-copy TX state
+ * @param frame the pbuf returned by ethernetif_tx_zerocopy_prepare()
+ * @return 1 if the caller has to schedule ethernetif_tx_zerocopy_reclaim(),
+ *         0 if a reclaim is already pending
+ */
+u8_t ethernetif_tx_zerocopy_complete(ethernetif_tx_zerocopy_t *zc, struct pbuf *frame);
+
+/**
+ * Releases all transmitted frames. Must be called from lwIP thread context.
+ *
+ * @param zc zero-copy TX state
+ * @return number of frames released
+ */
+u16_t ethernetif_tx_zerocopy_reclaim(ethernetif_tx_zerocopy_t *zc);
+
+#if defined(__cplusplus)
+}
+#endif /* __cplusplus */
+
+#endif /* ETHERNETIF_ZEROCOPY_H */
@@ -0,0 +1,287 @@
+/*
+ * Copyright 2026 NXP
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "lwip/opt.h"
+
+#if LWIP_PERF
+
+#include "lwip/pbuf.h"
+#include "lwip/memp.h"
+#include "lwip/stats.h"
+#include "lwip/sys.h"
+
+#include "lwip_perf.h"
+
+#include <string.h>
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+typedef struct lwip_perf_state
+{
+    u32_t (*clock)(void);                                        /*!< Probe clock, NULL when not measuring. */
+    u32_t ticksPerUs;                                            /*!< For printing. */
+    u32_t timelineInterval;                                      /*!< Ticks between samples, 0 = no timeline. */
+    u32_t lastSample;                                            /*!< Clock at the latest sample. */
+    u16_t poolPeak;                                              /*!< PBUF_POOL peak since the latest sample. */
+    u16_t refPeak;                                               /*!< MEMP_PBUF peak since the latest sample. */
+    u16_t head;                                                  /*!< Next sample slot. */
+    u16_t count;                                                 /*!< Valid samples. */
+    lwip_perf_hist_t hist[LWIP_PERF_NUM];                        /*!< Latency per probe point. */
+    lwip_perf_pool_sample_t timeline[LWIP_PERF_TIMELINE_LEN];    /*!< Ring of pbuf use samples. */
+} lwip_perf_state_t;
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+
+static lwip_perf_state_t s_perf;
+
+static const char *const s_perfPointNames[LWIP_PERF_NUM] = {
+    "netif-rx", "ip4-input", "tcp-input", "udp-input", "socket-rx",
+    "tcp-output", "udp-output", "ip4-output", "netif-tx",
+};
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+
+static void lwip_perf_reset_hist(lwip_perf_hist_t *hist)
+{
+    (void)memset(hist, 0, sizeof(*hist));
+    hist->min = 0xFFFFFFFFU;
+}
+
+static void lwip_perf_hist_add(lwip_perf_hist_t *hist, u32_t latency)
+{
+    u32_t v   = latency;
+    u32_t idx = 0U;
+
+    while ((v != 0U) && (idx < (LWIP_PERF_HIST_BUCKETS - 1U)))
+    {
+        idx++;
+        v >>= 1;
+    }
+    hist->bucket[idx]++;
+    hist->count++;
+    if (latency < hist->min)
+    {
+        hist->min = latency;
+    }
+    if (latency > hist->max)
+    {
+        hist->max = latency;
+    }
+}
+
+/* Tracks peak pbuf use and takes a timeline sample once the interval has
+ * passed. Sampling from the probes needs no timer: an idle stack has no
+ * pbufs to show anyway. */
+static void lwip_perf_sample_pools(u32_t now)
+{
+#if MEMP_STATS
+    u16_t poolUsed = (u16_t)MEMP_STATS_GET(used, MEMP_PBUF_POOL);
+    u16_t refUsed  = (u16_t)MEMP_STATS_GET(used, MEMP_PBUF);
+
+    if (poolUsed > s_perf.poolPeak)
+    {
+        s_perf.poolPeak = poolUsed;
+    }
+    if (refUsed > s_perf.refPeak)
+    {
+        s_perf.refPeak = refUsed;
+    }
+    if ((s_perf.timelineInterval != 0U) && ((u32_t)(now - s_perf.lastSample) >= s_perf.timelineInterval))
+    {
+        lwip_perf_pool_sample_t *sample = &s_perf.timeline[s_perf.head];
+
+        sample->time     = now;
+        sample->poolUsed = poolUsed;
+        sample->poolPeak = s_perf.poolPeak;
+        sample->refUsed  = refUsed;
+        sample->refPeak  = s_perf.refPeak;
+        s_perf.head      = (u16_t)((s_perf.head + 1U) % LWIP_PERF_TIMELINE_LEN);
+        if (s_perf.count < LWIP_PERF_TIMELINE_LEN)
+        {
+            s_perf.count++;
+        }
+        s_perf.lastSample = now;
+        s_perf.poolPeak   = poolUsed;
+        s_perf.refPeak    = refUsed;
+    }
+#else
+    LWIP_UNUSED_ARG(now);
+#endif /* MEMP_STATS */
+}
+
+void lwip_perf_init(u32_t (*clock)(void), u32_t ticksPerUs, u32_t timelineInterval)
+{
+    u8_t i;
+    SYS_ARCH_DECL_PROTECT(old_level);
+
+    SYS_ARCH_PROTECT(old_level);
+    (void)memset(&s_perf, 0, sizeof(s_perf));
+    for (i = 0U; i < LWIP_PERF_NUM; i++)
+    {
+        lwip_perf_reset_hist(&s_perf.hist[i]);
+    }
+    s_perf.ticksPerUs       = (ticksPerUs != 0U) ? ticksPerUs : 1U;
+    s_perf.timelineInterval = timelineInterval;
+    s_perf.lastSample       = (clock != NULL) ? clock() : 0U;
+    s_perf.clock            = clock;
+    SYS_ARCH_UNPROTECT(old_level);
+}
+
+void lwip_perf_pbuf_init(struct pbuf *p)
+{
+    u32_t (*clock)(void) = s_perf.clock;
+
+    p->perf_stamp = (clock != NULL) ? clock() : 0U;
+}
+
+void lwip_perf_probe(u8_t point, struct pbuf *p)
+{
+    u32_t (*clock)(void) = s_perf.clock;
+    u32_t now;
+    SYS_ARCH_DECL_PROTECT(old_level);
+
+    if ((clock == NULL) || (p == NULL) || (point >= LWIP_PERF_NUM))
+    {
+        return;
+    }
+
+    now = clock();
+    SYS_ARCH_PROTECT(old_level);
+    lwip_perf_hist_add(&s_perf.hist[point], (u32_t)(now - p->perf_stamp));
+    lwip_perf_sample_pools(now);
+    SYS_ARCH_UNPROTECT(old_level);
+
+    /* Probes starting a path stamp the packet for the probes after them. */
+    if ((point == LWIP_PERF_NETIF_RX) || (point == LWIP_PERF_TCP_OUTPUT) || (point == LWIP_PERF_UDP_OUTPUT))
+    {
+        p->perf_stamp = now;
+    }
+}
+
+void lwip_perf_get_hist(u8_t point, lwip_perf_hist_t *hist, u8_t reset)
+{
+    SYS_ARCH_DECL_PROTECT(old_level);
+
+    if (point >= LWIP_PERF_NUM)
+    {
+        lwip_perf_reset_hist(hist);
+        return;
+    }
+
+    SYS_ARCH_PROTECT(old_level);
+    *hist = s_perf.hist[point];
+    if (reset != 0U)
+    {
+        lwip_perf_reset_hist(&s_perf.hist[point]);
+    }
+    SYS_ARCH_UNPROTECT(old_level);
+}
+
+u32_t lwip_perf_hist_percentile(const lwip_perf_hist_t *hist, u32_t permille)
+{
+    u32_t rank;
+    u32_t seen = 0U;
+    u32_t i;
+
+    if (hist->count == 0U)
+    {
+        return 0U;
+    }
+
+    /* rank of the packet looked for, 1 based, rounded up */
+    rank = (u32_t)((((u64_t)hist->count * permille) + 999U) / 1000U);
+    if (rank == 0U)
+    {
+        rank = 1U;
+    }
+    for (i = 0U; i < LWIP_PERF_HIST_BUCKETS; i++)
+    {
+        seen += hist->bucket[i];
+        if (seen >= rank)
+        {
+            break;
+        }
+    }
+    if (i >= (LWIP_PERF_HIST_BUCKETS - 1U))
+    {
+        return hist->max;
+    }
+    /* upper bound of bucket i, but never beyond what was seen */
+    return LWIP_MIN(((u32_t)1U << i) - 1U, hist->max);
+}
+
+u16_t lwip_perf_get_timeline(lwip_perf_pool_sample_t *samples, u16_t max, u8_t reset)
+{
+    u16_t n;
+    u16_t first;
+    u16_t i;
+    SYS_ARCH_DECL_PROTECT(old_level);
+
+    SYS_ARCH_PROTECT(old_level);
+    n     = LWIP_MIN(max, s_perf.count);
+    first = (u16_t)((s_perf.head + LWIP_PERF_TIMELINE_LEN - s_perf.count) % LWIP_PERF_TIMELINE_LEN);
+    for (i = 0U; i < n; i++)
+    {
+        samples[i] = s_perf.timeline[(first + i) % LWIP_PERF_TIMELINE_LEN];
+    }
+    if (reset != 0U)
+    {
+        s_perf.count = 0U;
+    }
+    SYS_ARCH_UNPROTECT(old_level);
+
+    return n;
+}
+
+const char *lwip_perf_point_name(u8_t point)
+{
+    return (point < LWIP_PERF_NUM) ? s_perfPointNames[point] : "?";
+}
+
+void lwip_perf_print(void)
+{
+    lwip_perf_hist_t hist;
+    lwip_perf_pool_sample_t sample;
+    u32_t us = s_perf.ticksPerUs;
+    u16_t n;
+    u8_t i;
+    SYS_ARCH_DECL_PROTECT(old_level);
+
+    LWIP_PLATFORM_DIAG(("%-11s %10s %8s %8s %8s %8s (us)\n", "probe", "count", "min", "p50", "p99", "max"));
+    for (i = 0U; i < LWIP_PERF_NUM; i++)
+    {
+        lwip_perf_get_hist(i, &hist, 0U);
+        if (hist.count == 0U)
+        {
+            continue;
+        }
+        LWIP_PLATFORM_DIAG(("%-11s %10" U32_F " %8" U32_F " %8" U32_F " %8" U32_F " %8" U32_F "\n",
+                            lwip_perf_point_name(i), hist.count, hist.min / us,
+                            lwip_perf_hist_percentile(&hist, 500U) / us, lwip_perf_hist_percentile(&hist, 990U) / us,
+                            hist.max / us));
+    }
+    SYS_ARCH_PROTECT(old_level);
+    n = s_perf.count;
+    if (n != 0U)
+    {
+        sample = s_perf.timeline[(s_perf.head + LWIP_PERF_TIMELINE_LEN - 1U) % LWIP_PERF_TIMELINE_LEN];
+    }
+    SYS_ARCH_UNPROTECT(old_level);
+    if (n != 0U)
+    {
+        LWIP_PLATFORM_DIAG(("pbuf pool used %" U16_F " peak %" U16_F ", ref used %" U16_F " peak %" U16_F "\n",
+                            sample.poolUsed, sample.poolPeak, sample.refUsed, sample.refPeak));
+    }
+}
+
+#endif /* LWIP_PERF */
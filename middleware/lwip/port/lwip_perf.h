@@ -0,0 +1,150 @@
+/*
+ * Copyright 2026 NXP
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef LWIP_PERF_PORT_H
+#define LWIP_PERF_PORT_H
+
+#include "lwip/opt.h"
+#include "lwip/def.h"
+#include "lwip/pbuf.h"
+
+/*!
+ * Packet path latency probes.
+ *
+ * With LWIP_PERF enabled the stack calls PERF_PROBE() at the probe points
+ * listed in lwip/def.h (LWIP_PERF_NETIF_RX ... LWIP_PERF_NETIF_TX). Every
+ * pbuf carries the clock of the probe that started its path; the other probes
+ * add the time since then to their latency histogram:
+ *
+ * - RX: NETIF_RX stamps the frame, IP4_INPUT, TCP_INPUT, UDP_INPUT and
+ *   SOCKET_RX record the time since the driver handed it over.
+ * - TX: TCP_OUTPUT and UDP_OUTPUT record the time since the pbuf was
+ *   allocated (the time data waited in the send queue, for retransmissions
+ *   the time since the previous transmission) and stamp it again, IP4_OUTPUT
+ *   and NETIF_TX record the time since then.
+ *
+ * Every probe also samples pbuf use; once per timeline interval the current
+ * and peak use of PBUF_POOL and of MEMP_PBUF (PBUF_REF/ROM) go to a ring of
+ * samples. This needs MEMP_STATS.
+ *
+ * lwipopts.h must add the stamp to struct pbuf:
+ *
+ *     #define LWIP_PERF                     1
+ *     #define LWIP_PBUF_CUSTOM_DATA         u32_t perf_stamp;
+ *     #define LWIP_PBUF_CUSTOM_DATA_INIT(p) lwip_perf_pbuf_init(p)
+ *
+ * With LWIP_PERF 0 the probes compile to nothing.
+ */
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+/* Number of histogram buckets. Bucket 0 counts latencies of 0 ticks, bucket i
+ * latencies of 2^(i-1) to 2^i - 1 ticks; the last one takes everything above. */
+#define LWIP_PERF_HIST_BUCKETS (32U)
+
+/* Number of pbuf use samples kept; older samples are overwritten. */
+#ifndef LWIP_PERF_TIMELINE_LEN
+#define LWIP_PERF_TIMELINE_LEN (64U)
+#endif
+
+/**
+ * Latency histogram of one probe point, in ticks of the probe clock.
+ */
+typedef struct lwip_perf_hist
+{
+    u32_t count;                          /*!< Number of packets. */
+    u32_t min;                            /*!< Shortest latency, 0xFFFFFFFF if count is 0. */
+    u32_t max;                            /*!< Longest latency. */
+    u32_t bucket[LWIP_PERF_HIST_BUCKETS]; /*!< log2 buckets, see LWIP_PERF_HIST_BUCKETS. */
+} lwip_perf_hist_t;
+
+/**
+ * pbuf use at one point in time.
+ */
+typedef struct lwip_perf_pool_sample
+{
+    u32_t time;     /*!< Clock at the sample. */
+    u16_t poolUsed; /*!< PBUF_POOL pbufs in use. */
+    u16_t poolPeak; /*!< Most PBUF_POOL pbufs seen in use since the previous sample. */
+    u16_t refUsed;  /*!< MEMP_PBUF (PBUF_REF/ROM) pbufs in use. */
+    u16_t refPeak;  /*!< Most MEMP_PBUF pbufs seen in use since the previous sample. */
+} lwip_perf_pool_sample_t;
+
+/*******************************************************************************
+ * API
+ ******************************************************************************/
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* __cplusplus */
+
+#if LWIP_PERF
+/**
+ * Starts measuring and clears all histograms and the timeline. Probes do
+ * nothing until this is called.
+ *
+ * @param clock free running clock, NULL stops measuring
+ * @param ticksPerUs clock ticks per microsecond, used by lwip_perf_print()
+ * @param timelineInterval clock ticks between pbuf use samples, 0 disables
+ *                         the timeline
+ */
+void lwip_perf_init(u32_t (*clock)(void), u32_t ticksPerUs, u32_t timelineInterval);
+
+/* lwip_perf_probe() and lwip_perf_pbuf_init() are declared by arch/perf.h,
+ * which the stack includes for PERF_PROBE(). */
+
+/**
+ * Copies the latency histogram of a probe point.
+ *
+ * @param point probe point
+ * @param hist filled in
+ * @param reset clear the histogram after copying
+ */
+void lwip_perf_get_hist(u8_t point, lwip_perf_hist_t *hist, u8_t reset);
+
+/**
+ * Returns the latency below which permille of the packets of a histogram
+ * fall, as the upper bound of the bucket it lies in.
+ *
+ * @param hist histogram
+ * @param permille 500 for the median, 990 for the 99th percentile
+ * @return latency in ticks, 0 for an empty histogram
+ */
+u32_t lwip_perf_hist_percentile(const lwip_perf_hist_t *hist, u32_t permille);
+
+/**
+ * Copies pbuf use samples, oldest first.
+ *
+ * @param samples filled in
+ * @param max size of samples
+ * @param reset drop the samples after copying
+ * @return number of samples copied
+ */
+u16_t lwip_perf_get_timeline(lwip_perf_pool_sample_t *samples, u16_t max, u8_t reset);
+
+/**
+ * Returns the name of a probe point, e.g. "ip4-input".
+ *
+ * @param point probe point
+ * @return name, "?" for an unknown point
+ */
+const char *lwip_perf_point_name(u8_t point);
+
+/**
+ * Prints count, min, median, 99th percentile and max latency in microseconds
+ * of every probe point and the latest pbuf use with LWIP_PLATFORM_DIAG.
+ */
+void lwip_perf_print(void);
+#endif /* LWIP_PERF */
+
+#if defined(__cplusplus)
+}
+#endif /* __cplusplus */
+
+#endif /* LWIP_PERF_PORT_H */
@@ -647,6 +647,7 @@ netconn_recv_data(struct netconn *conn, void **new_buf, u8_t apiflags)
       return err;
     }
     len = ((struct pbuf *)buf)->tot_len;
+    PERF_PROBE(LWIP_PERF_SOCKET_RX, (struct pbuf *)buf);
   }
 #endif /* LWIP_TCP */
 #if LWIP_TCP && (LWIP_UDP || LWIP_RAW)
@@ -656,6 +657,7 @@ netconn_recv_data(struct netconn *conn, void **new_buf, u8_t apiflags)
   {
     LWIP_ASSERT("buf != NULL", buf != NULL);
     len = netbuf_len((struct netbuf *)buf);
+    PERF_PROBE(LWIP_PERF_SOCKET_RX, ((struct netbuf *)buf)->p);
   }
 #endif /* (LWIP_UDP || LWIP_RAW) */
 
@@ -193,12 +193,14 @@ EXIT:
 **      none
 **
 ** Return Value:
-**      uint32_t - Number of bytes read
+**      uint32_t - Number of bytes read. In event loop mode the body is buffered before the CGI is called, up to the
+**                 session buffer size. Beyond that it returns what has arrived, zero if nothing has yet.
 */
 uint32_t HTTPSRV_cgi_read(uint32_t ses_handle, char *buffer, uint32_t length)
 {
     HTTPSRV_SESSION_STRUCT *session = (HTTPSRV_SESSION_STRUCT *)ses_handle;
     uint32_t retval;
+    int32_t read;
 
     if ((session == NULL) || (buffer == NULL) || (length == 0))
     {
@@ -210,26 +212,18 @@ uint32_t HTTPSRV_cgi_read(uint32_t ses_handle, char *buffer, uint32_t length)
         length = session->request.content_length;
     }
 
-    retval = httpsrv_read(session, buffer, length);
+    read   = httpsrv_read(session, buffer, length);
+    retval = 0;
 
-    if (retval > 0)
+    /* Zero on timeout, a closed connection or (event loop) nothing arrived yet */
+    if (read > 0)
     {
+        retval = read;
         if (retval <= session->request.content_length)
         {
             session->request.content_length -= retval;
         }
     }
-    else
-    {
-        int optval;
-        socklen_t optlen = sizeof(optval);
-
-        /* Timeout */
-        if ((lwip_getsockopt(session->sock, SOL_SOCKET, SO_ERROR, &optval, &optlen) == 0) && (optval == EWOULDBLOCK))
-        {
-            retval = 0;
-        }
-    }
     session->time = sys_now();
     return (retval);
 }
@@ -103,6 +103,49 @@
 #define HTTPSRV_CFG_RECEIVE_TIMEOUT (1000)
 #endif
 
+/* Send static files straight from the file system image without copying them
+ * into the session buffer or the TCP send queue. The file data must stay valid
+ * until acknowledged by the client, which holds for the (const) HTTPSRV_FS
+ * image. Not used for TLS sessions and files with server side includes. */
+#ifndef HTTPSRV_CFG_ZERO_COPY_ENABLED
+#define HTTPSRV_CFG_ZERO_COPY_ENABLED (1)
+#endif
+
+/* Maximal number of bytes queued by one zero-copy send */
+#ifndef HTTPSRV_CFG_ZERO_COPY_CHUNK
+#define HTTPSRV_CFG_ZERO_COPY_CHUNK (TCP_SND_BUF)
+#endif
+
+/* Serve "<file>.gz" with Content-Encoding: gzip to clients accepting it */
+#ifndef HTTPSRV_CFG_GZIP_ENABLED
+#define HTTPSRV_CFG_GZIP_ENABLED (1)
+#endif
+
+/* Send the ETag of files and answer matching If-None-Match with 304 */
+#ifndef HTTPSRV_CFG_ETAG_ENABLED
+#define HTTPSRV_CFG_ETAG_ENABLED (1)
+#endif
+
+/* Serve all sessions from the server task instead of one task per session.
+ * Sessions cost no stack then, so max_ses is bounded by the number of sockets
+ * (MEMP_NUM_NETCONN) only. CGI/SSI callbacks and TLS handshakes run in the
+ * server task and hold up the other sessions, so they have to be short.
+ * Sends never block: output the socket does not take stays in the session
+ * buffer until the socket is writable. Only CGI/SSI output which does not fit
+ * the session buffer and WebSocket frames wait for the socket (up to the
+ * session timeout). Reads never block either: a POST body is buffered before
+ * the CGI is called, up to the session buffer size, and HTTPSRV_cgi_read()
+ * returns what has arrived of the rest (zero if nothing has yet). */
+#ifndef HTTPSRV_CFG_EVENT_LOOP_ENABLED
+#define HTTPSRV_CFG_EVENT_LOOP_ENABLED (0)
+#endif
+
+/* Event loop poll period in ms: session timeouts and WebSocket API calls are
+ * checked at least this often */
+#ifndef HTTPSRV_CFG_EVENT_LOOP_TICK
+#define HTTPSRV_CFG_EVENT_LOOP_TICK (10)
+#endif
+
 /* WebSocket protocol support */
 #ifndef HTTPSRV_CFG_WEBSOCKET_ENABLED
 #define HTTPSRV_CFG_WEBSOCKET_ENABLED (0)
@@ -256,6 +256,16 @@ int32_t HTTPSRV_FS_ioctl(
                     ((HTTPSRV_FS_DIR_ENTRY_PTR)file_ptr->DEV_DATA_PTR)->DATA + file_ptr->LOCATION;
             }
             break;
+        case IO_IOCTL_HTTPSRV_FS_GET_ETAG:
+            if (file_ptr->DEV_DATA_PTR == NULL)
+            {
+                error_code = HTTPSRV_FS_ERROR_INVALID_FILE_HANDLE;
+            }
+            else
+            {
+                *((uint32_t *)param_ptr) = ((HTTPSRV_FS_DIR_ENTRY_PTR)file_ptr->DEV_DATA_PTR)->ETAG;
+            }
+            break;
         case IO_IOCTL_HTTPSRV_FS_GET_LAST_ERROR:
             error_code = file_ptr->ERROR;
             break;
@@ -432,3 +442,16 @@ size_t HTTPSRV_FS_size(HTTPSRV_FS_FILE_PTR file_fd_ptr)
     }
     return size;
 }
+
+uint32_t HTTPSRV_FS_etag(const unsigned char *data, uint32_t size)
+{
+    uint32_t hash = 2166136261u;
+
+    while (size--)
+    {
+        hash ^= *data++;
+        hash *= 16777619u;
+    }
+    /* Zero means the file has no entity tag */
+    return (hash != 0) ? hash : 1;
+}
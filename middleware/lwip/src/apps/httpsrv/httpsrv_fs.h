@@ -73,6 +73,8 @@
 
 #define IO_IOCTL_HTTPSRV_FS_SEEK (0x06)
 
+#define IO_IOCTL_HTTPSRV_FS_GET_ETAG (0x07)
+
 /*
  * Seek parameters
  */
@@ -89,6 +91,7 @@ typedef struct httpsrv_fs_dir_entry
     uint32_t FLAGS;
     unsigned char *DATA;
     uint32_t SIZE;
+    uint32_t ETAG; /* Entity tag of DATA, see HTTPSRV_FS_etag(). Zero = none. */
 } HTTPSRV_FS_DIR_ENTRY, *HTTPSRV_FS_DIR_ENTRY_PTR;
 
 /* FILE STRUCTURE */
@@ -133,6 +136,16 @@ int32_t HTTPSRV_FS_ioctl(HTTPSRV_FS_FILE_PTR, uint32_t, void *);
  * \return HTTPSRV_FS_ERROR (Failure.)
  */
 int32_t HTTPSRV_FS_fseek(HTTPSRV_FS_FILE_PTR file_ptr, int32_t offset, uint32_t mode);
+/*!
+ * \brief This function computes the entity tag of file data (32-bit FNV-1a,
+ * never zero). mkfs.pl stores the same value in the generated directory.
+ *
+ * \param[in] data The file data.
+ * \param[in] size The file size.
+ *
+ * \return The entity tag.
+ */
+uint32_t HTTPSRV_FS_etag(const unsigned char *data, uint32_t size);
 
 #ifdef __cplusplus
 }
@@ -38,6 +38,10 @@
 #define HTTPSRV_FLAG_KEEP_ALIVE_ENABLED (1 << 6) /* Keep-alive enabled/disabled for session */
 #define HTTPSRV_FLAG_HAS_CONTENT_LENGTH (1 << 7) /* Flag signalizing presence of Content-Length in request. */
 #define HTTPSRV_FLAG_HEADER_SENT        (1 << 8) /* Flag signalizing if response header was sent. */
+#define HTTPSRV_FLAG_ACCEPT_GZIP        (1 << 9) /* Client accepts gzip content encoding */
+#define HTTPSRV_FLAG_IS_GZIP            (1 << 10) /* Response is the gzip variant of the requested file */
+#define HTTPSRV_FLAG_HAS_IF_NONE_MATCH  (1 << 11) /* Flag signalizing presence of If-None-Match in request. */
+#define HTTPSRV_FLAG_DISCARD_BODY      (1 << 12) /* Rest of the request body is discarded as it arrives */
 
 /*
 **  Wildcard typedef for CGI/SSI callback prototype
@@ -118,6 +122,7 @@ typedef struct httpsrv_req_struct
     char *query;                     /* Data send in URL */
     HTTPSRV_AUTH_USER_STRUCT auth;   /* Authentication credentials received from client */
     HTTPSRV_UPGRADE_PROT upgrade_to; /* Protocol to upgrade to. Zero = no upgrade. */
+    uint32_t if_none_match;          /* Entity tag from If-None-Match */
 } HTTPSRV_REQ_STRUCT;
 
 /*
@@ -130,6 +135,7 @@ typedef struct httpsrv_res_struct
     int32_t length;                              /* Response length */
     const HTTPSRV_AUTH_REALM_STRUCT *auth_realm; /* Authentication realm */
     int content_type;                            /* Content type */
+    uint32_t etag;                               /* Entity tag of the file. Zero = none. */
     char script_buffer[3];                       /* Buffer for script tag search. */
 } HTTPSRV_RES_STRUCT;
 
@@ -167,6 +173,12 @@ typedef struct httpsrv_session_struct
 #if HTTPSRV_CFG_WEBSOCKET_ENABLED
     const WS_PLUGIN_STRUCT *plugin;    /* Plugin to be invoked for session. */
     WS_HANDSHAKE_STRUCT *ws_handshake; /* WebSocket hand-shake */
+#if HTTPSRV_CFG_EVENT_LOOP_ENABLED
+    void *ws_context; /* WebSocket context, kept between event loop passes */
+#endif
+#endif
+#if HTTPSRV_CFG_EVENT_LOOP_ENABLED
+    uint32_t tx_pending; /* Bytes at the start of the buffer the socket did not take yet */
 #endif
 #if HTTPSRV_CFG_WOLFSSL_ENABLE || HTTPSRV_CFG_MBEDTLS_ENABLE
     httpsrv_tls_sock_t tls_sock;
@@ -271,6 +271,13 @@ void httpsrv_process_cgi(HTTPSRV_STRUCT *server, HTTPSRV_SESSION_STRUCT *session
         }
 
         session->request.content_length = length;
+#if HTTPSRV_CFG_EVENT_LOOP_ENABLED
+        /* The event loop does not wait for the rest, it is discarded as it arrives */
+        if (length != 0)
+        {
+            session->flags |= HTTPSRV_FLAG_DISCARD_BODY;
+        }
+#endif
     }
     return;
 }
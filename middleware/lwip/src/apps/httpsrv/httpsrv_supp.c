@@ -137,12 +137,23 @@ static const HTTPSRV_CONTENT_TABLE_ROW content_tbl[] = {
 
 static uint32_t httpsrv_sendextstr(HTTPSRV_STRUCT *server, HTTPSRV_SESSION_STRUCT *session, uint32_t length);
 static void httpsrv_print(HTTPSRV_SESSION_STRUCT *session, char *format, ...);
+static void httpsrv_puthdr(HTTPSRV_SESSION_STRUCT *session, int32_t content_len, bool has_entity);
+#if HTTPSRV_CFG_ZERO_COPY_ENABLED
+static int32_t httpsrv_sendfile_nocopy(HTTPSRV_SESSION_STRUCT *session, uint32_t remaining);
+#endif
+static int32_t httpsrv_ses_make_room(HTTPSRV_SESSION_STRUCT *session, uint32_t length);
+#if HTTPSRV_CFG_EVENT_LOOP_ENABLED
+static int httpsrv_ses_wait_send(HTTPSRV_SESSION_STRUCT *session);
+#endif
 static char *httpsrv_get_table_str(HTTPSRV_TABLE_ROW *table, const int32_t id);
 static int httpsrv_get_table_int(HTTPSRV_TABLE_ROW *table, char *str);
 static void httpsrv_process_file_type(char *extension, HTTPSRV_SESSION_STRUCT *session);
 static int32_t httpsrv_set_params(HTTPSRV_STRUCT *server, HTTPSRV_PARAM_STRUCT *params);
 static int32_t httpsrv_init_socket(HTTPSRV_STRUCT *server);
 static int httpsrv_basic_auth(char *auth_string, char **user_ptr, char **pass_ptr);
+#if HTTPSRV_CFG_GZIP_ENABLED
+static bool httpsrv_accepts_gzip(const char *list);
+#endif
 #if HTTPSRV_CFG_WEBSOCKET_ENABLED
 static void *httpsrv_ws_alloc(HTTPSRV_SESSION_STRUCT *session);
 #endif
@@ -405,7 +416,8 @@ static int32_t httpsrv_init_socket(HTTPSRV_STRUCT *server)
     }
 
     /* Listen */
-    error = listen(server->sock, 0);
+    /* Connections are accepted as fast as sessions are free, queue a burst of them instead of dropping SYNs */
+    error = listen(server->sock, server->params.max_ses);
     if (error == -1)
     {
         return (HTTPSRV_LISTEN_FAIL);
@@ -595,11 +607,15 @@ int httpsrv_recv(HTTPSRV_SESSION_STRUCT *session, char *buffer, size_t length, i
 }
 
 /*
- * Send data to socket
+ * Send data to socket. The event loop never blocks in send, a full socket takes
+ * nothing (zero is returned then).
  */
 int httpsrv_send(HTTPSRV_SESSION_STRUCT *session, const char *buffer, size_t length, int flags)
 {
     int result;
+#if HTTPSRV_CFG_EVENT_LOOP_ENABLED
+    flags |= MSG_DONTWAIT;
+#endif
 #if HTTPSRV_CFG_WOLFSSL_ENABLE || HTTPSRV_CFG_MBEDTLS_ENABLE
     if (session->tls_sock != 0)
     {
@@ -609,11 +625,75 @@ int httpsrv_send(HTTPSRV_SESSION_STRUCT *session, const char *buffer, size_t len
 #endif
     {
         result = lwip_send(session->sock, buffer, length, flags);
+#if HTTPSRV_CFG_EVENT_LOOP_ENABLED
+        if ((result == -1) && (errno == EWOULDBLOCK))
+        {
+            result = 0;
+        }
+#endif
     }
 
     return result;
 }
 
+/*
+ * Send all data to socket, for writers which can not leave the rest for later
+ * (direct writes bigger than the session buffer, WebSocket frames). The event
+ * loop waits for the socket to become writable then.
+ */
+int httpsrv_send_all(HTTPSRV_SESSION_STRUCT *session, const char *buffer, size_t length)
+{
+    size_t sent = 0;
+
+    while (sent < length)
+    {
+        int result;
+
+        result = httpsrv_send(session, buffer + sent, length - sent, 0);
+        if (result == -1)
+        {
+            return (-1);
+        }
+#if HTTPSRV_CFG_EVENT_LOOP_ENABLED
+        if ((result == 0) && (httpsrv_ses_wait_send(session) == -1))
+        {
+            return (-1);
+        }
+#endif
+        sent += result;
+    }
+
+    return ((int)length);
+}
+
+#if HTTPSRV_CFG_EVENT_LOOP_ENABLED
+/*
+** Wait until session socket takes more data, at most for the session timeout
+** (a keep-alive session has a short one only while it waits for a request).
+**
+** IN:
+**      HTTPSRV_SESSION_STRUCT* session - session used for transmission
+**
+** OUT:
+**      none
+**
+** Return Value:
+**      int - zero if the socket is writable, -1 on session timeout or error.
+*/
+static int httpsrv_ses_wait_send(HTTPSRV_SESSION_STRUCT *session)
+{
+    fd_set writeset;
+    struct timeval timeout;
+
+    FD_ZERO(&writeset);
+    FD_SET(session->sock, &writeset);
+    timeout.tv_sec  = HTTPSRV_CFG_SES_TIMEOUT / 1000;
+    timeout.tv_usec = (HTTPSRV_CFG_SES_TIMEOUT % 1000) * 1000;
+
+    return ((lwip_select(session->sock + 1, NULL, &writeset, NULL, &timeout) > 0) ? 0 : -1);
+}
+#endif
+
 /*
 ** Send HTTP header according to the session response structure.
 **
@@ -630,13 +710,38 @@ int httpsrv_send(HTTPSRV_SESSION_STRUCT *session, const char *buffer, size_t len
 */
 void httpsrv_sendhdr(HTTPSRV_SESSION_STRUCT *session, int32_t content_len, bool has_entity)
 {
-    char *connection_state;
-    char *phrase;
-
     if (session->flags & HTTPSRV_FLAG_HEADER_SENT)
     {
         return;
     }
+    httpsrv_puthdr(session, content_len, has_entity);
+
+    /* Commented out to prevent problems with file system on KHCI USB */
+    // if ((content_len == 0) && (!has_entity))
+    {
+        httpsrv_ses_flush(session);
+    }
+}
+
+/*
+** Write HTTP header according to the session response structure to the session buffer.
+**
+** IN:
+**      HTTPSRV_SESSION_STRUCT* session - session used for transmission
+**      int32_t                content_len - content length
+**      bool                 has_entity - flag indicating if HTTP entity is going to be send following header.
+**
+** OUT:
+**      none
+**
+** Return Value:
+**      none
+*/
+static void httpsrv_puthdr(HTTPSRV_SESSION_STRUCT *session, int32_t content_len, bool has_entity)
+{
+    char *connection_state;
+    char *phrase;
+
     phrase = httpsrv_get_table_str((HTTPSRV_TABLE_ROW *)reason_phrase, session->response.status_code);
     if (phrase == NULL)
     {
@@ -709,6 +814,19 @@ void httpsrv_sendhdr(HTTPSRV_SESSION_STRUCT *session, int32_t content_len, bool
             }
         }
     }
+#if HTTPSRV_CFG_ETAG_ENABLED
+    if ((session->response.etag != 0) && ((session->response.status_code == HTTPSRV_CODE_OK) ||
+                                          (session->response.status_code == HTTPSRV_CODE_NOT_MODIFIED)))
+    {
+        httpsrv_print(session, "ETag: \"%08lx\"\r\n", (unsigned long)session->response.etag);
+    }
+#endif
+#if HTTPSRV_CFG_GZIP_ENABLED
+    if (session->flags & HTTPSRV_FLAG_IS_GZIP)
+    {
+        httpsrv_print(session, "Content-Encoding: gzip\r\nVary: Accept-Encoding\r\n");
+    }
+#endif
     /* Only non zero length cause sending Content-Length header field */
     if (content_len > 0)
     {
@@ -722,12 +840,6 @@ void httpsrv_sendhdr(HTTPSRV_SESSION_STRUCT *session, int32_t content_len, bool
     }
     /* End of header */
     httpsrv_print(session, "\r\n");
-
-    /* Commented out to prevent problems with file system on KHCI USB */
-    // if ((content_len == 0) && (!has_entity))
-    {
-        httpsrv_ses_flush(session);
-    }
     session->flags |= HTTPSRV_FLAG_HEADER_SENT;
 }
 
@@ -769,6 +881,27 @@ void httpsrv_send_err_page(HTTPSRV_SESSION_STRUCT *session, const char *title, c
     }
 }
 
+#if HTTPSRV_CFG_ETAG_ENABLED
+/*
+** Send "Not Modified" response for the requested file. Cache control and entity
+** tag are the same as for the full response.
+**
+** IN:
+**      HTTPSRV_SESSION_STRUCT* session - session used for transmission
+**
+** OUT:
+**      none
+**
+** Return Value:
+**      none
+*/
+void httpsrv_send_not_modified(HTTPSRV_SESSION_STRUCT *session)
+{
+    httpsrv_process_file_type(strrchr(session->request.path, '.'), session);
+    httpsrv_sendhdr(session, 0, 0);
+}
+#endif
+
 /*
 ** Convert file extension to content type and determine what kind of cache control should be used.
 **
@@ -857,6 +990,8 @@ HTTPSRV_SES_STATE httpsrv_sendfile(HTTPSRV_STRUCT *server, HTTPSRV_SESSION_STRUC
     /* Check if file has server side includes */
     if ((0 == lwip_stricmp(ext, ".shtml")) || (0 == lwip_stricmp(ext, ".shtm")))
     {
+        uint32_t start;
+
         /*
          * Disable keep-alive for this session otherwise we would have to
          * wait for session timeout.
@@ -866,36 +1001,62 @@ HTTPSRV_SES_STATE httpsrv_sendfile(HTTPSRV_STRUCT *server, HTTPSRV_SESSION_STRUC
 
         HTTPSRV_FS_fseek(session->response.file, session->response.length, HTTPSRV_FS_IO_SEEK_SET);
 
-        length = HTTPSRV_FS_read(session->response.file, buffer + session->buffer.offset,
-                                 HTTPSRV_SES_BUF_SIZE_PRV - session->buffer.offset);
+        /* The header may still be in the buffer, the file is read behind it */
+        start  = session->buffer.offset;
+        length = HTTPSRV_FS_read(session->response.file, buffer + start, HTTPSRV_SES_BUF_SIZE_PRV - start);
         if (length > 0)
         {
             uint32_t offset;
 
             offset = httpsrv_sendextstr(server, session, length);
             session->response.length += offset;
-            session->response.length += session->buffer.offset;
+            session->response.length += session->buffer.offset - start;
             httpsrv_ses_flush(session);
         }
     }
     else
     {
-        httpsrv_sendhdr(session, HTTPSRV_FS_size(session->response.file), 1);
+        uint32_t remaining;
+
+        /* The header is sent together with the first part of the file */
+        if (!(session->flags & HTTPSRV_FLAG_HEADER_SENT))
+        {
+            httpsrv_puthdr(session, HTTPSRV_FS_size(session->response.file), 1);
+        }
         HTTPSRV_FS_fseek(session->response.file, session->response.length, HTTPSRV_FS_IO_SEEK_SET);
+        remaining = HTTPSRV_FS_size(session->response.file) - session->response.length;
 
-        length = HTTPSRV_FS_read(session->response.file, buffer + session->buffer.offset,
-                                 HTTPSRV_SES_BUF_SIZE_PRV - session->buffer.offset);
-        //  fread(buffer+session->buffer.offset, 1, HTTPSRV_SES_BUF_SIZE_PRV-session->buffer.offset,
-        //  session->response.file);
-        if (length > 0)
+        length = 0;
+#if HTTPSRV_CFG_ZERO_COPY_ENABLED
+        if (remaining > HTTPSRV_SES_BUF_SIZE_PRV - session->buffer.offset)
         {
-            session->buffer.offset += length;
-            length = httpsrv_ses_flush(session);
-            if (length != -1)
+            length = httpsrv_sendfile_nocopy(session, remaining);
+        }
+        if (length == 0)
+#endif
+        {
+            length = HTTPSRV_FS_read(session->response.file, buffer + session->buffer.offset,
+                                     HTTPSRV_SES_BUF_SIZE_PRV - session->buffer.offset);
+            //  fread(buffer+session->buffer.offset, 1, HTTPSRV_SES_BUF_SIZE_PRV-session->buffer.offset,
+            //  session->response.file);
+            if (length > 0)
             {
-                session->response.length += length;
+                session->buffer.offset += length;
+                if (httpsrv_ses_flush(session) == -1)
+                {
+                    length = -1;
+                }
             }
         }
+        if (length > 0)
+        {
+            session->response.length += length;
+        }
+        else
+        {
+            /* Empty file or error, the header may still be buffered */
+            httpsrv_ses_flush(session);
+        }
     }
 
     if (length <= 0)
@@ -909,6 +1070,66 @@ HTTPSRV_SES_STATE httpsrv_sendfile(HTTPSRV_STRUCT *server, HTTPSRV_SESSION_STRUC
     return (retval);
 }
 
+#if HTTPSRV_CFG_ZERO_COPY_ENABLED
+/*
+** Send file data straight from the file system image. The data is queued for
+** transmission without copying it, so it has to stay valid until acknowledged.
+**
+** IN:
+**      HTTPSRV_SESSION_STRUCT* session - session used for transmission
+**      uint32_t                remaining - number of bytes left in the file
+**
+** OUT:
+**      none
+**
+** Return Value:
+**      int32_t - number of bytes sent, zero if the data has to be copied, -1 on error.
+*/
+static int32_t httpsrv_sendfile_nocopy(HTTPSRV_SESSION_STRUCT *session, uint32_t remaining)
+{
+    unsigned char *data;
+    int length;
+
+#if HTTPSRV_CFG_WOLFSSL_ENABLE || HTTPSRV_CFG_MBEDTLS_ENABLE
+    /* TLS encrypts into its own records */
+    if (session->tls_sock != 0)
+    {
+        return (0);
+    }
+#endif
+    if (HTTPSRV_FS_ioctl(session->response.file, IO_IOCTL_HTTPSRV_FS_GET_CURRENT_DATA_PTR, &data) != HTTPSRV_FS_OK)
+    {
+        return (0);
+    }
+    /* Send buffered header first */
+    if (httpsrv_ses_flush(session) == -1)
+    {
+        return (-1);
+    }
+#if HTTPSRV_CFG_EVENT_LOOP_ENABLED
+    /* Part of it is still waiting, the file data has to go behind it */
+    if (session->tx_pending != 0)
+    {
+        return (0);
+    }
+#endif
+
+    if (remaining > HTTPSRV_CFG_ZERO_COPY_CHUNK)
+    {
+        remaining = HTTPSRV_CFG_ZERO_COPY_CHUNK;
+    }
+#if HTTPSRV_CFG_EVENT_LOOP_ENABLED
+    /* Queue what fits into the send buffer without blocking the event loop, the
+     * copying path below still reports a broken connection */
+    length = lwip_send(session->sock, data, remaining, MSG_NOCOPY | MSG_DONTWAIT);
+    return ((length > 0) ? length : 0);
+#else
+    length = lwip_send(session->sock, data, remaining, MSG_NOCOPY);
+    return ((length > 0) ? length : -1);
+#endif
+}
+#endif
+
 /*
 ** Send extended string to socket (dynamic web pages).
 **
@@ -961,8 +1182,8 @@ static uint32_t httpsrv_sendextstr(HTTPSRV_STRUCT *server, HTTPSRV_SESSION_STRUC
                 session->response.script_buffer[0] = 0;
             }
         }
-        session->buffer.offset = n_send - i;
-        retval                 = i;
+        session->buffer.offset += n_send - i;
+        retval                  = i;
     }
     else if (n == 1) /* There was already the less-than sign.*/
     {
@@ -975,7 +1196,7 @@ static uint32_t httpsrv_sendextstr(HTTPSRV_STRUCT *server, HTTPSRV_SESSION_STRUC
         else
         {
             /* There was no script token, send missing less-than sign. */
-            httpsrv_send(session, session->response.script_buffer, n, 0);
+            httpsrv_send_all(session, session->response.script_buffer, n);
             memset(session->response.script_buffer, 0, sizeof(session->response.script_buffer));
             retval = 0;
         }
@@ -1033,18 +1254,18 @@ int32_t httpsrv_write(HTTPSRV_SESSION_STRUCT *session, char *src, int32_t length
     if (length > HTTPSRV_SES_BUF_SIZE_PRV)
     {
         /* If there are some data already buffered send them to client first */
-        if (httpsrv_ses_flush(session) == -1)
+        if (httpsrv_ses_make_room(session, HTTPSRV_SES_BUF_SIZE_PRV) == -1)
         {
             return (-1);
         }
         else
         {
-            return (httpsrv_send(session, src, length, 0));
+            return (httpsrv_send_all(session, src, length));
         }
     }
 
     /* No space in buffer - make some */
-    if ((space < length) && (httpsrv_ses_flush(session) == -1))
+    if ((space < length) && (httpsrv_ses_make_room(session, length) == -1))
     {
         return (-1);
     }
@@ -1084,13 +1305,22 @@ int32_t httpsrv_write(HTTPSRV_SESSION_STRUCT *session, char *src, int32_t length
 **      none
 **
 ** Return Value:
-**      int - number of bytes read.
+**      int - number of bytes read. The event loop never waits for the client: zero if nothing has arrived yet,
+**            -1 if the connection is closed or failed.
 */
 int32_t httpsrv_read(HTTPSRV_SESSION_STRUCT *session, char *dst, int32_t len)
 {
     int read           = 0;
     uint32_t data_size = session->buffer.offset;
 
+#if HTTPSRV_CFG_EVENT_LOOP_ENABLED
+    /* The buffer holds output the socket did not take yet, not request data */
+    if (session->tx_pending != 0)
+    {
+        data_size = 0;
+    }
+#endif
+
     /* If there are any data in buffer copy them to user buffer */
     if (data_size > 0)
     {
@@ -1104,6 +1334,23 @@ int32_t httpsrv_read(HTTPSRV_SESSION_STRUCT *session, char *dst, int32_t len)
         read = length;
     }
 
+#if HTTPSRV_CFG_EVENT_LOOP_ENABLED
+    /* Take what has arrived, the caller reads the rest on a later readable event */
+    if (read < len)
+    {
+        int received;
+
+        received = httpsrv_recv(session, dst + read, len - read, MSG_DONTWAIT);
+        if (received > 0)
+        {
+            read += received;
+        }
+        else if ((read == 0) && ((received == 0) || (errno != EWOULDBLOCK))) /* 0 means connection is closed.*/
+        {
+            read = -1;
+        }
+    }
+#else
     /* If there is some space remaining in user buffer try to read from socket */
     while (read < len)
     {
@@ -1119,6 +1366,7 @@ int32_t httpsrv_read(HTTPSRV_SESSION_STRUCT *session, char *dst, int32_t len)
             break;
         }
     }
+#endif
 
     return (read);
 }
@@ -1182,7 +1430,7 @@ static void httpsrv_print(HTTPSRV_SESSION_STRUCT *session, char *format, ...)
 #endif
     {
         httpsrv_ses_flush(session);
-        buffer_space = HTTPSRV_SES_BUF_SIZE_PRV;
+        buffer_space = HTTPSRV_SES_BUF_SIZE_PRV - session->buffer.offset;
     }
     va_start(ap, format);
     session->buffer.offset += vsnprintf(buffer + session->buffer.offset, buffer_space, format, ap);
@@ -1190,7 +1438,9 @@ static void httpsrv_print(HTTPSRV_SESSION_STRUCT *session, char *format, ...)
 }
 
 /*
-** Send data from session buffer to client.
+** Send data from session buffer to client. In event loop mode only what the
+** socket takes now is sent, the rest stays at the start of the buffer
+** (session->tx_pending) and is sent by the loop once the socket is writable.
 **
 ** IN:
 **      HTTPSRV_SESSION_STRUCT *session - session to use.
@@ -1221,13 +1471,62 @@ int32_t httpsrv_ses_flush(HTTPSRV_SESSION_STRUCT *session)
             send_total = -1;
             break;
         }
+#if HTTPSRV_CFG_EVENT_LOOP_ENABLED
+        if (send_now == 0)
+        {
+            break;
+        }
+#endif
         send_total += send_now;
     }
+#if HTTPSRV_CFG_EVENT_LOOP_ENABLED
+    session->tx_pending = 0;
+    if ((send_total >= 0) && (send_total < data_length))
+    {
+        session->tx_pending = data_length - send_total;
+        memmove(data, data + send_total, session->tx_pending);
+    }
+    session->buffer.offset = session->tx_pending;
+#else
     session->buffer.offset = 0;
+#endif
 
     return (send_total);
 }
 
+/*
+** Flush session buffer until there is space for data of given length in it.
+**
+** IN:
+**      HTTPSRV_SESSION_STRUCT *session - session to use.
+**      uint32_t                length - space needed, at most the buffer size.
+**
+** OUT:
+**      none
+**
+** Return Value:
+**      int32_t - -1 on error.
+*/
+static int32_t httpsrv_ses_make_room(HTTPSRV_SESSION_STRUCT *session, uint32_t length)
+{
+    int32_t retval;
+
+    retval = httpsrv_ses_flush(session);
+#if HTTPSRV_CFG_EVENT_LOOP_ENABLED
+    /* The writer can not be resumed later, wait until the socket takes enough */
+    while ((retval != -1) && ((HTTPSRV_SES_BUF_SIZE_PRV - session->buffer.offset) < length))
+    {
+        retval = httpsrv_ses_wait_send(session);
+        if (retval != -1)
+        {
+            retval = httpsrv_ses_flush(session);
+        }
+    }
+#endif
+
+    return (retval);
+}
+
 /*
 ** Read HTTP method
 **
@@ -1392,6 +1691,38 @@ int32_t httpsrv_req_hdr(HTTPSRV_SESSION_STRUCT *session, char *buffer)
             }
         }
     }
+#endif
+#if HTTPSRV_CFG_GZIP_ENABLED
+    else if (strncmp(buffer, "Accept-Encoding: ", 17) == 0)
+    {
+        param_ptr = buffer + 17;
+        if (httpsrv_accepts_gzip(param_ptr))
+        {
+            session->flags |= HTTPSRV_FLAG_ACCEPT_GZIP;
+        }
+    }
+#endif
+#if HTTPSRV_CFG_ETAG_ENABLED
+    else if (strncmp(buffer, "If-None-Match: ", 15) == 0)
+    {
+        char *end;
+
+        /* Only a single tag is supported, that is what browsers send back. */
+        param_ptr = buffer + 15;
+        if (strncmp(param_ptr, "W/", 2) == 0)
+        {
+            param_ptr += 2;
+        }
+        if (*param_ptr == '"')
+        {
+            param_ptr++;
+        }
+        session->request.if_none_match = strtoul(param_ptr, &end, 16);
+        if ((end != param_ptr) && ((*end == '"') || (*end == '\0')))
+        {
+            session->flags |= HTTPSRV_FLAG_HAS_IF_NONE_MATCH;
+        }
+    }
 #endif
     else if (strncmp(buffer, "Authorization: ", 15) == 0)
     {
@@ -1705,6 +2036,95 @@ EXIT:
     return (retval);
 }
 
+#if HTTPSRV_CFG_GZIP_ENABLED
+/*
+** Check if an Accept-Encoding list accepts gzip
+**
+** IN:
+**      const char* list - comma separated codings, each with an optional ";q=" weight.
+**
+** OUT:
+**      none
+**
+** Return Value:
+**      true if gzip (or x-gzip) is listed with a non-zero weight, or is not
+**      listed and "*" is listed with a non-zero weight.
+*/
+static bool httpsrv_accepts_gzip(const char *list)
+{
+    int gzip = -1; /* -1 not listed, 0 refused (q=0), 1 accepted */
+    int any  = -1;
+    const char *coding;
+    uint32_t length;
+    int accepted;
+
+    while (*list != '\0')
+    {
+        while ((*list == ' ') || (*list == '\t') || (*list == ','))
+        {
+            list++;
+        }
+        coding = list;
+        while ((*list != '\0') && (*list != ',') && (*list != ';') && (*list != ' ') && (*list != '\t') &&
+               (*list != '\r'))
+        {
+            list++;
+        }
+        length = (uint32_t)(list - coding);
+
+        /* Parameters, only the weight is of interest. A weight of 0, 0.0, 0.00 or 0.000 refuses the coding. */
+        accepted = 1;
+        while ((*list != '\0') && (*list != ','))
+        {
+            if (*list != ';')
+            {
+                list++;
+                continue;
+            }
+            list++;
+            while ((*list == ' ') || (*list == '\t'))
+            {
+                list++;
+            }
+            if (((*list == 'q') || (*list == 'Q')) && (list[1] == '='))
+            {
+                list += 2;
+                accepted = 0;
+                if (*list == '0')
+                {
+                    list++;
+                    if (*list == '.')
+                    {
+                        list++;
+                        while (*list == '0')
+                        {
+                            list++;
+                        }
+                        accepted = isdigit((unsigned char)*list) ? 1 : 0;
+                    }
+                }
+                else
+                {
+                    accepted = 1;
+                }
+            }
+        }
+
+        if (((length == 4) && (lwip_strnicmp(coding, "gzip", 4) == 0)) ||
+            ((length == 6) && (lwip_strnicmp(coding, "x-gzip", 6) == 0)))
+        {
+            gzip = accepted;
+        }
+        else if ((length == 1) && (*coding == '*'))
+        {
+            any = accepted;
+        }
+    }
+
+    return (gzip >= 0) ? (gzip == 1) : (any == 1);
+}
+#endif
+
 /*
  * Join root directory and relative path.
  */
@@ -1739,7 +2159,8 @@ char *httpsrv_path_create(const char *root, char *filename)
     if (path != NULL)
     {
         memcpy(path, root, root_length);
-        if ((root[root_length - 1] != '\\') && (filename[0] != '\\'))
+        /* The default root directory is empty */
+        if (((root_length == 0) || (root[root_length - 1] != '\\')) && (filename[0] != '\\'))
         {
             path[root_length] = '\\';
             root_length++;
@@ -31,6 +31,9 @@ int32_t httpsrv_ses_flush(HTTPSRV_SESSION_STRUCT *session);
 void httpsrv_sendhdr(HTTPSRV_SESSION_STRUCT *session, int32_t content_len, bool has_entity);
 HTTPSRV_SES_STATE httpsrv_sendfile(HTTPSRV_STRUCT *server, HTTPSRV_SESSION_STRUCT *session);
 void httpsrv_send_err_page(HTTPSRV_SESSION_STRUCT *session, const char *title, const char *text);
+#if HTTPSRV_CFG_ETAG_ENABLED
+void httpsrv_send_not_modified(HTTPSRV_SESSION_STRUCT *session);
+#endif
 
 int32_t httpsrv_req_hdr(HTTPSRV_SESSION_STRUCT *session, char *buffer);
 int32_t httpsrv_req_line(HTTPSRV_STRUCT *server, HTTPSRV_SESSION_STRUCT *session, char *buffer);
@@ -45,6 +48,7 @@ const WS_PLUGIN_STRUCT *httpsrv_get_ws_plugin(const WS_PLUGIN_STRUCT *table, cha
 #endif
 int httpsrv_recv(HTTPSRV_SESSION_STRUCT *session, char *buffer, size_t length, int flags);
 int httpsrv_send(HTTPSRV_SESSION_STRUCT *session, const char *buffer, size_t length, int flags);
+int httpsrv_send_all(HTTPSRV_SESSION_STRUCT *session, const char *buffer, size_t length);
 char *httpsrv_get_query(char *src);
 int httpsrv_wait_for_conn(HTTPSRV_STRUCT *server);
 int httpsrv_accept(int sock);
@@ -27,25 +27,47 @@ static void httpsrv_plugin_run(void *server_ptr, void *session_ptr);
 static int httpsrv_req_read(HTTPSRV_STRUCT *server, HTTPSRV_SESSION_STRUCT *session);
 static HTTPSRV_SES_STATE httpsrv_req_do(HTTPSRV_STRUCT *server, HTTPSRV_SESSION_STRUCT *session);
 static HTTPSRV_SES_STATE httpsrv_response(HTTPSRV_STRUCT *server, HTTPSRV_SESSION_STRUCT *session);
+#if HTTPSRV_CFG_GZIP_ENABLED
+static HTTPSRV_FS_FILE *httpsrv_open_gzip(char *path);
+#endif
 
 static inline void httpsrv_ses_set_state(HTTPSRV_SESSION_STRUCT *session, HTTPSRV_SES_STATE new_state);
 static HTTPSRV_SESSION_STRUCT *httpsrv_ses_alloc(HTTPSRV_STRUCT *server, int sock);
 static void httpsrv_ses_free(HTTPSRV_SESSION_STRUCT *session);
 static void httpsrv_ses_close(HTTPSRV_SESSION_STRUCT *session);
 static int httpsrv_ses_init(HTTPSRV_STRUCT *server, HTTPSRV_SESSION_STRUCT *session, const int sock);
+static int httpsrv_ses_open(HTTPSRV_STRUCT *server, int sock);
+#if HTTPSRV_CFG_EVENT_LOOP_ENABLED
+static bool httpsrv_ses_wait_body(HTTPSRV_SESSION_STRUCT *session);
+static int httpsrv_req_body_read(HTTPSRV_SESSION_STRUCT *session);
+static int httpsrv_req_body_discard(HTTPSRV_SESSION_STRUCT *session);
+static int httpsrv_ses_wait_for(HTTPSRV_SESSION_STRUCT *session);
+static void httpsrv_event_loop(HTTPSRV_STRUCT *server);
+#else
 static void httpsrv_session_task(void *arg);
+#endif
+
+#if HTTPSRV_CFG_EVENT_LOOP_ENABLED
+/* What a session waits for before its state machine can make progress */
+#define HTTPSRV_WAIT_NONE  (0)
+#define HTTPSRV_WAIT_READ  (1)
+#define HTTPSRV_WAIT_WRITE (2)
+#endif
 
 /*
  ** HTTPSRV main task which creates new task for each new client request
+ ** (or serves all of them itself with HTTPSRV_CFG_EVENT_LOOP_ENABLED)
  */
 void httpsrv_server_task(void *arg)
 {
     HTTPSRV_STRUCT *server = (HTTPSRV_STRUCT *)arg;
 
+#if HTTPSRV_CFG_EVENT_LOOP_ENABLED
+    httpsrv_event_loop(server);
+#else
     while (1)
     {
         int i;
-        int error;
         int new_sock;
 
         /* limit number of opened sessions */
@@ -71,132 +93,473 @@ void httpsrv_server_task(void *arg)
                  * starvation */
                 sys_msleep(100);
             }
+            else if ((i = httpsrv_ses_open(server, new_sock)) < 0)
+            {
+                sys_sem_signal(&server->ses_cnt);
+            }
             else
             {
+                HTTPSRV_SESSION_STRUCT *session = server->session[i];
+                HTTPSRV_SES_TASK_PARAM *ses_param;
+
+                /* Allocate session task parameter */
+                ses_param = httpsrv_mem_alloc_zero(sizeof(HTTPSRV_SES_TASK_PARAM));
+
+                if (ses_param != NULL)
+                {
+                    ses_param->server    = server;
+                    ses_param->session_p = &server->session[i];
+
+                    /* Try to create task for session */
+                    if (xTaskCreate(httpsrv_session_task, HTTPSRV_SESSION_TASK_NAME,
+#if ((defined(HTTPSRV_CFG_WOLFSSL_ENABLE) && (HTTPSRV_CFG_WOLFSSL_ENABLE != 0)) || \
+     (defined(HTTPSRV_CFG_MBEDTLS_ENABLE) && (HTTPSRV_CFG_MBEDTLS_ENABLE != 0)))
+                                    (server->tls_ctx != NULL) ? HTTPSRV_CFG_HTTPS_SESSION_STACK_SIZE :
+                                                                HTTPSRV_CFG_HTTP_SESSION_STACK_SIZE,
+#else
+                                    HTTPSRV_CFG_HTTP_SESSION_STACK_SIZE,
+#endif
+                                    ses_param, server->params.task_prio, NULL) == pdPASS)
+                    {
+                        continue;
+                    }
+                    httpsrv_mem_free(ses_param);
+                }
+                httpsrv_ses_close(session);
+                httpsrv_ses_free(session);
+                server->session[i] = NULL;
+                sys_sem_signal(&server->ses_cnt);
+            }
+        }
+    }
+#endif /* HTTPSRV_CFG_EVENT_LOOP_ENABLED */
+    /* Server release.*/
+    httpsrv_destroy_server(server);
+    server->server_tid = 0;
+    sys_sem_signal(&server->finished);
+
+    vTaskDelete(NULL);
+}
+
+/*
+ ** Function setting up session for accepted connection
+ **
+ ** IN:
+ **      HTTPSRV_STRUCT *server - pointer to server structure.
+ **      int sock - accepted socket, closed on failure.
+ **
+ ** OUT:
+ **      none
+ **
+ ** Return Value:
+ **      int - index of new session in server session table, -1 on failure.
+ */
+static int httpsrv_ses_open(HTTPSRV_STRUCT *server, int sock)
+{
+    HTTPSRV_SESSION_STRUCT *session;
+    int i;
 #if ((defined(HTTPSRV_CFG_SEND_TIMEOUT) && (HTTPSRV_CFG_SEND_TIMEOUT != 0)) || \
      (defined(HTTPSRV_CFG_RECEIVE_TIMEOUT) && (HTTPSRV_CFG_RECEIVE_TIMEOUT != 0)))
-                struct timeval timeval_option;
+    struct timeval timeval_option;
 #endif
 
-                /* Set socket options */
+    /* Set socket options */
 #if (defined(HTTPSRV_CFG_SEND_TIMEOUT) && (HTTPSRV_CFG_SEND_TIMEOUT != 0))
-                timeval_option.tv_sec  = HTTPSRV_CFG_SEND_TIMEOUT / 1000;          /* seconds */
-                timeval_option.tv_usec = (HTTPSRV_CFG_SEND_TIMEOUT % 1000) * 1000; /* and microseconds */
-                error = lwip_setsockopt(new_sock, SOL_SOCKET, SO_SNDTIMEO, (const void *)&timeval_option,
-                                        sizeof(timeval_option));
-                if (error != 0)
-                {
-                    httpsrv_abort(new_sock);
-                    sys_sem_signal(&server->ses_cnt);
-                    break;
-                }
+    timeval_option.tv_sec  = HTTPSRV_CFG_SEND_TIMEOUT / 1000;          /* seconds */
+    timeval_option.tv_usec = (HTTPSRV_CFG_SEND_TIMEOUT % 1000) * 1000; /* and microseconds */
+    if (lwip_setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, (const void *)&timeval_option, sizeof(timeval_option)) != 0)
+    {
+        httpsrv_abort(sock);
+        return (-1);
+    }
 #endif
 #if (defined(HTTPSRV_CFG_RECEIVE_TIMEOUT) && (HTTPSRV_CFG_RECEIVE_TIMEOUT != 0))
-                timeval_option.tv_sec  = HTTPSRV_CFG_RECEIVE_TIMEOUT / 1000;          /* seconds */
-                timeval_option.tv_usec = (HTTPSRV_CFG_RECEIVE_TIMEOUT % 1000) * 1000; /* and microseconds */
-                error = lwip_setsockopt(new_sock, SOL_SOCKET, SO_RCVTIMEO, (const void *)&timeval_option,
-                                        sizeof(timeval_option));
-                if (error != 0)
-                {
-                    httpsrv_abort(new_sock);
-                    sys_sem_signal(&server->ses_cnt);
-                    break;
-                }
+    timeval_option.tv_sec  = HTTPSRV_CFG_RECEIVE_TIMEOUT / 1000;          /* seconds */
+    timeval_option.tv_usec = (HTTPSRV_CFG_RECEIVE_TIMEOUT % 1000) * 1000; /* and microseconds */
+    if (lwip_setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, (const void *)&timeval_option, sizeof(timeval_option)) != 0)
+    {
+        httpsrv_abort(sock);
+        return (-1);
+    }
 #endif
-                /* Find empty session */
-                for (i = 0; i < server->params.max_ses; i++)
-                {
-                    if (server->session[i] == NULL)
-                    {
-                        break;
-                    }
-                }
+    /* Find empty session */
+    for (i = 0; i < server->params.max_ses; i++)
+    {
+        if (server->session[i] == NULL)
+        {
+            break;
+        }
+    }
+    if (i == server->params.max_ses)
+    {
+        httpsrv_abort(sock);
+        return (-1);
+    }
 
-                if (i != server->params.max_ses)
-                {
-                    HTTPSRV_SESSION_STRUCT *session;
+    /* Allocate session */
+    session = httpsrv_ses_alloc(server, sock);
+    if (session == NULL)
+    {
+        httpsrv_abort(sock);
+        return (-1);
+    }
+    if (ERR_OK != httpsrv_ses_init(server, session, sock))
+    {
+        httpsrv_ses_close(session);
+        httpsrv_ses_free(session);
+        return (-1);
+    }
 
-                    /* Allocate session */
-                    session = httpsrv_ses_alloc(server, new_sock);
-                    if (session)
-                    {
-                        HTTPSRV_SES_TASK_PARAM *ses_param;
+    /* Disable keep-alive for last session so we have at least one session free (not blocked
+     * by keep-alive timeout) */
+    if (i == server->params.max_ses - 1)
+    {
+        session->flags &= ~HTTPSRV_FLAG_KEEP_ALIVE_ENABLED;
+    }
 
-                        /* Allocate session task parameter */
-                        ses_param = httpsrv_mem_alloc_zero(sizeof(HTTPSRV_SES_TASK_PARAM));
+    server->session[i] = session;
+    return (i);
+}
 
-                        if (ses_param != NULL)
-                        {
-                            if (ERR_OK == httpsrv_ses_init(server, session, new_sock))
-                            {
-                                /* Disable keep-alive for last session so we have at least one session free (not blocked
-                                 * by keep-alive timeout) */
-                                if (i == server->params.max_ses - 1)
-                                {
-                                    session->flags &= ~HTTPSRV_FLAG_KEEP_ALIVE_ENABLED;
-                                }
-
-                                server->session[i] = session;
-
-                                ses_param->server    = server;
-                                ses_param->session_p = &server->session[i];
-
-                                /* Try to create task for session */
-                                if (xTaskCreate(httpsrv_session_task, HTTPSRV_SESSION_TASK_NAME,
-#if ((defined(HTTPSRV_CFG_WOLFSSL_ENABLE) && (HTTPSRV_CFG_WOLFSSL_ENABLE != 0)) || \
-     (defined(HTTPSRV_CFG_MBEDTLS_ENABLE) && (HTTPSRV_CFG_MBEDTLS_ENABLE != 0)))
-                                                (server->tls_ctx != NULL) ? HTTPSRV_CFG_HTTPS_SESSION_STACK_SIZE :
-                                                                            HTTPSRV_CFG_HTTP_SESSION_STACK_SIZE,
+#if HTTPSRV_CFG_EVENT_LOOP_ENABLED
+/*
+ ** Check if the session waits for the request body: a POST body is buffered
+ ** before the request is processed (up to the session buffer size), and the
+ ** rest a CGI did not read is discarded before the next keep-alive request.
+ **
+ ** IN:
+ **      HTTPSRV_SESSION_STRUCT* session - session structure pointer.
+ **
+ ** OUT:
+ **      none
+ **
+ ** Return Value:
+ **      bool - true if the session state machine waits for more of the body.
+ */
+static bool httpsrv_ses_wait_body(HTTPSRV_SESSION_STRUCT *session)
+{
+    uint32_t wanted;
+
+    if (session->process_func != httpsrv_http_process)
+    {
+        return (false);
+    }
+    if (session->state == HTTPSRV_SES_END_REQ)
+    {
+        return ((session->flags & (HTTPSRV_FLAG_DISCARD_BODY | HTTPSRV_FLAG_IS_KEEP_ALIVE)) ==
+                (HTTPSRV_FLAG_DISCARD_BODY | HTTPSRV_FLAG_IS_KEEP_ALIVE));
+    }
+    if ((session->state != HTTPSRV_SES_PROCESS_REQ) || (session->request.method != HTTPSRV_REQ_POST) ||
+        !(session->flags & HTTPSRV_FLAG_HAS_CONTENT_LENGTH))
+    {
+        return (false);
+    }
+    wanted = session->request.content_length;
+    if (wanted > HTTPSRV_SES_BUF_SIZE_PRV)
+    {
+        wanted = HTTPSRV_SES_BUF_SIZE_PRV;
+    }
+    return (session->buffer.offset < wanted);
+}
+
+/*
+ ** Read what has arrived of the request body into the session buffer
+ **
+ ** IN:
+ **      HTTPSRV_SESSION_STRUCT* session - session structure pointer.
+ **
+ ** OUT:
+ **      none
+ **
+ ** Return Value:
+ **      int - zero, -1 if the connection is closed or failed.
+ */
+static int httpsrv_req_body_read(HTTPSRV_SESSION_STRUCT *session)
+{
+    uint32_t wanted;
+    int received;
+
+    wanted = session->request.content_length;
+    if (wanted > HTTPSRV_SES_BUF_SIZE_PRV)
+    {
+        wanted = HTTPSRV_SES_BUF_SIZE_PRV;
+    }
+    received = httpsrv_recv(session, session->buffer.data + session->buffer.offset, wanted - session->buffer.offset,
+                            MSG_DONTWAIT);
+    if (received > 0)
+    {
+        session->buffer.offset += received;
+        session->time = sys_now();
+    }
+    else if ((received == 0) || (errno != EWOULDBLOCK)) /* 0 means connection is closed.*/
+    {
+        return (-1);
+    }
+    return (0);
+}
+
+/*
+ ** Discard what has arrived of the rest of the request body
+ **
+ ** IN:
+ **      HTTPSRV_SESSION_STRUCT* session - session structure pointer.
+ **
+ ** OUT:
+ **      none
+ **
+ ** Return Value:
+ **      int - zero, -1 if the connection is closed or failed.
+ */
+static int httpsrv_req_body_discard(HTTPSRV_SESSION_STRUCT *session)
+{
+    char tmp[HTTPSRV_TMP_BUFFER_SIZE];
+
+    while (session->request.content_length != 0)
+    {
+        int32_t chunk;
+        int32_t read;
+
+        chunk = sizeof(tmp);
+        if (session->request.content_length < chunk)
+        {
+            chunk = session->request.content_length;
+        }
+        read = httpsrv_read(session, tmp, chunk);
+        if (read < 0)
+        {
+            return (-1);
+        }
+        if (read == 0)
+        {
+            return (0);
+        }
+        session->request.content_length -= read;
+        session->time = sys_now();
+    }
+    session->flags &= ~HTTPSRV_FLAG_DISCARD_BODY;
+    return (0);
+}
+
+/*
+ ** Get socket event the session state machine waits for
+ **
+ ** IN:
+ **      HTTPSRV_SESSION_STRUCT* session - session structure pointer.
+ **
+ ** OUT:
+ **      none
+ **
+ ** Return Value:
+ **      int - HTTPSRV_WAIT_READ, HTTPSRV_WAIT_WRITE or HTTPSRV_WAIT_NONE if the session can run now.
+ */
+static int httpsrv_ses_wait_for(HTTPSRV_SESSION_STRUCT *session)
+{
+    /* Unsent output goes first, the state machine runs once it is out */
+    if (session->tx_pending != 0)
+    {
+        return (HTTPSRV_WAIT_WRITE);
+    }
+#if HTTPSRV_CFG_WEBSOCKET_ENABLED
+    /* WebSocket session: also polled for API calls on every pass */
+    if (session->process_func != httpsrv_http_process)
+    {
+        return (HTTPSRV_WAIT_READ);
+    }
+#endif
+    if (httpsrv_ses_wait_body(session))
+    {
+        return (HTTPSRV_WAIT_READ);
+    }
+    switch (session->state)
+    {
+        case HTTPSRV_SES_WAIT_REQ:
+            return (HTTPSRV_WAIT_READ);
+        case HTTPSRV_SES_RESP:
+            return (HTTPSRV_WAIT_WRITE);
+        default:
+            return (HTTPSRV_WAIT_NONE);
+    }
+}
+
+/*
+ ** Event loop serving all sessions from the server task. Each session state
+ ** machine is run only when its socket is ready for the next step, so waiting
+ ** for one client never blocks the others.
+ **
+ ** IN:
+ **      HTTPSRV_STRUCT *server - pointer to server structure.
+ **
+ ** OUT:
+ **      none
+ **
+ ** Return Value:
+ **      none
+ */
+static void httpsrv_event_loop(HTTPSRV_STRUCT *server)
+{
+    fd_set readset;
+    fd_set writeset;
+    struct timeval timeout;
+    struct timeval *timeout_ptr;
+    HTTPSRV_SESSION_STRUCT *session;
+    int max_sock;
+    int active;
+    int i;
+
+    /* Never wait in accept, a connection reported by select may have been reset meanwhile */
+    i = 1;
+    (void)lwip_ioctl(server->sock, FIONBIO, &i);
+
+    while (server->valid == HTTPSRV_VALID)
+    {
+        bool ready = false;
+        int used   = 0;
+
+        FD_ZERO(&readset);
+        FD_ZERO(&writeset);
+        max_sock = server->sock;
+
+        for (i = 0; i < server->params.max_ses; i++)
+        {
+            session = server->session[i];
+            if (session == NULL)
+            {
+                continue;
+            }
+            used++;
+            if (session->sock > max_sock)
+            {
+                max_sock = session->sock;
+            }
+            switch (httpsrv_ses_wait_for(session))
+            {
+                case HTTPSRV_WAIT_READ:
+                    FD_SET(session->sock, &readset);
+                    break;
+                case HTTPSRV_WAIT_WRITE:
+                    FD_SET(session->sock, &writeset);
+                    break;
+                default:
+                    ready = true;
+                    break;
+            }
+        }
+        /* Accept new connections only if there is a free session */
+        if (used < server->params.max_ses)
+        {
+            FD_SET(server->sock, &readset);
+        }
+
+        /* Sleep until a socket is ready; wake up periodically while there are sessions to time out */
+        timeout.tv_sec  = 0;
+        timeout.tv_usec = ready ? 0 : (HTTPSRV_CFG_EVENT_LOOP_TICK * 1000);
+        timeout_ptr     = (ready || (used != 0)) ? &timeout : NULL;
+
+        active = lwip_select(max_sock + 1, &readset, &writeset, NULL, timeout_ptr);
+        if (server->valid == HTTPSRV_INVALID)
+        {
+            break;
+        }
+        if (active < 0)
+        {
+            sys_msleep(HTTPSRV_CFG_EVENT_LOOP_TICK);
+            continue;
+        }
+        if (active == 0)
+        {
+            FD_ZERO(&readset);
+            FD_ZERO(&writeset);
+        }
+
+        /* Run sessions which can make progress or timed out */
+        for (i = 0; i < server->params.max_ses; i++)
+        {
+            uint32_t timeout;
+
+            session = server->session[i];
+            if (session == NULL)
+            {
+                continue;
+            }
+            timeout = session->timeout;
+            switch (httpsrv_ses_wait_for(session))
+            {
+                case HTTPSRV_WAIT_READ:
+#if HTTPSRV_CFG_WEBSOCKET_ENABLED
+                    ready = FD_ISSET(session->sock, &readset) || (session->process_func != httpsrv_http_process);
 #else
-                                                HTTPSRV_CFG_HTTP_SESSION_STACK_SIZE,
+                    ready = FD_ISSET(session->sock, &readset);
 #endif
-                                                ses_param, server->params.task_prio, NULL) != pdPASS)
-                                {
-                                    httpsrv_ses_close(session);
-                                    httpsrv_ses_free(session);
-                                    server->session[i] = NULL;
-                                    sys_sem_signal(&server->ses_cnt);
-                                    httpsrv_mem_free(ses_param);
-                                }
-                            }
-                            else
-                            {
-                                httpsrv_ses_close(session);
-                                httpsrv_ses_free(session);
-                                sys_sem_signal(&server->ses_cnt);
-                                httpsrv_mem_free(ses_param);
-                            }
-                        }
-                        else
+                    /* The short keep-alive timeout is for the next request, not the rest of this one */
+                    if (httpsrv_ses_wait_body(session))
+                    {
+                        timeout = HTTPSRV_CFG_SES_TIMEOUT;
+                        if (ready)
                         {
-                            httpsrv_ses_close(session);
-                            httpsrv_ses_free(session);
-                            httpsrv_abort(new_sock);
-                            sys_sem_signal(&server->ses_cnt);
+                            session->time = sys_now();
                         }
                     }
-                    else
+                    break;
+                case HTTPSRV_WAIT_WRITE:
+                    ready = FD_ISSET(session->sock, &writeset);
+                    /* A response in progress is not cut by the short keep-alive timeout */
+                    timeout = HTTPSRV_CFG_SES_TIMEOUT;
+                    if (ready)
                     {
-                        httpsrv_abort(new_sock);
-                        sys_sem_signal(&server->ses_cnt);
+                        session->time = sys_now();
                     }
-                }
-                else
+                    break;
+                default:
+                    ready = true;
+                    break;
+            }
+            if (ready && (session->tx_pending != 0))
+            {
+                /* Send the rest of the output first, the state machine goes on once it is out */
+                if (httpsrv_ses_flush(session) == -1)
                 {
-                    httpsrv_abort(new_sock);
-                    sys_sem_signal(&server->ses_cnt);
+                    session->valid = HTTPSRV_INVALID;
                 }
+                ready = session->valid && (session->tx_pending == 0);
+            }
+            if (ready || ((sys_now() - session->time) > timeout))
+            {
+                session->process_func(server, session);
+            }
+            if (!session->valid)
+            {
+                httpsrv_ses_close(session);
+                httpsrv_ses_free(session);
+                server->session[i] = NULL;
+            }
+        }
+
+        /* Set up session for new connection, it waits for the request from the next pass */
+        if ((active > 0) && FD_ISSET(server->sock, &readset))
+        {
+            int new_sock = httpsrv_accept(server->sock);
+            if (new_sock >= 0)
+            {
+                (void)httpsrv_ses_open(server, new_sock);
             }
         }
     }
-    /* Server release.*/
-    httpsrv_destroy_server(server);
-    server->server_tid = 0;
-    sys_sem_signal(&server->finished);
 
-    vTaskDelete(NULL);
+    /* Server release, end all sessions */
+    for (i = 0; i < server->params.max_ses; i++)
+    {
+        session = server->session[i];
+        if (session != NULL)
+        {
+            session->valid = HTTPSRV_INVALID;
+            session->process_func(server, session);
+            httpsrv_ses_close(session);
+            httpsrv_ses_free(session);
+            server->session[i] = NULL;
+        }
+    }
 }
-
+#else
 /*
  ** Session task.
  ** This task is responsible for session creation, processing and cleanup.
@@ -222,6 +585,7 @@ static void httpsrv_session_task(void *arg)
     sys_sem_signal(&server->ses_cnt);
     vTaskDelete(NULL);
 }
+#endif /* HTTPSRV_CFG_EVENT_LOOP_ENABLED */
 
 /*
  ** Function for session allocation
@@ -472,6 +836,17 @@ void httpsrv_http_process(void *server_ptr, void *session_ptr)
             }
             break;
         case HTTPSRV_SES_PROCESS_REQ:
+#if HTTPSRV_CFG_EVENT_LOOP_ENABLED
+            /* A CGI gets the body without waiting for the client */
+            if (httpsrv_ses_wait_body(session))
+            {
+                if (httpsrv_req_body_read(session) == -1)
+                {
+                    httpsrv_ses_set_state(session, HTTPSRV_SES_CLOSE);
+                }
+                break;
+            }
+#endif
             httpsrv_ses_set_state(session, httpsrv_req_do(server, session));
             break;
 
@@ -485,6 +860,17 @@ void httpsrv_http_process(void *server_ptr, void *session_ptr)
             {
                 httpsrv_ses_set_state(session, HTTPSRV_SES_CLOSE);
             }
+#if HTTPSRV_CFG_EVENT_LOOP_ENABLED
+            else if ((session->flags & HTTPSRV_FLAG_DISCARD_BODY) && (httpsrv_req_body_discard(session) == -1))
+            {
+                httpsrv_ses_set_state(session, HTTPSRV_SES_CLOSE);
+            }
+            else if (session->flags & HTTPSRV_FLAG_DISCARD_BODY)
+            {
+                /* The next request follows the rest of the body */
+                break;
+            }
+#endif
             else
             {
                 /* Re-init session */
@@ -752,18 +1138,81 @@ static HTTPSRV_SES_STATE httpsrv_req_do(HTTPSRV_STRUCT *server, HTTPSRV_SESSION_
         goto EXIT;
     }
 
-    session->response.file   = HTTPSRV_FS_open(full_path);
+    session->response.file = NULL;
+#if HTTPSRV_CFG_GZIP_ENABLED
+    if (session->flags & HTTPSRV_FLAG_ACCEPT_GZIP)
+    {
+        session->response.file = httpsrv_open_gzip(full_path);
+        if (session->response.file)
+        {
+            session->flags |= HTTPSRV_FLAG_IS_GZIP;
+        }
+    }
+    if (!session->response.file)
+#endif
+    {
+        session->response.file = HTTPSRV_FS_open(full_path);
+    }
     session->response.length = 0;
     if (!session->response.file)
     {
         session->response.status_code = HTTPSRV_CODE_NOT_FOUND;
     }
+#if HTTPSRV_CFG_ETAG_ENABLED
+    else if ((HTTPSRV_FS_ioctl(session->response.file, IO_IOCTL_HTTPSRV_FS_GET_ETAG, &session->response.etag) ==
+              HTTPSRV_FS_OK) &&
+             (session->response.etag != 0) && (session->flags & HTTPSRV_FLAG_HAS_IF_NONE_MATCH) &&
+             (session->request.if_none_match == session->response.etag))
+    {
+        session->response.status_code = HTTPSRV_CODE_NOT_MODIFIED;
+    }
+#endif
     httpsrv_mem_free(full_path);
 
 EXIT:
     return (retval);
 }
 
+#if HTTPSRV_CFG_GZIP_ENABLED
+/*
+ ** Open gzip compressed variant "<path>.gz" of a file. Files with server side
+ ** includes are never compressed, their content is processed while sending.
+ **
+ ** IN:
+ **      char* path - full path of the requested file.
+ **
+ ** OUT:
+ **      none
+ **
+ ** Return Value:
+ **      HTTPSRV_FS_FILE* - handle of the compressed file, NULL if there is none.
+ */
+static HTTPSRV_FS_FILE *httpsrv_open_gzip(char *path)
+{
+    HTTPSRV_FS_FILE *file = NULL;
+    char *suffix;
+    char *gz_path;
+    uint32_t length;
+
+    suffix = strrchr(path, '.');
+    if ((suffix != NULL) && ((0 == lwip_stricmp(suffix, ".shtml")) || (0 == lwip_stricmp(suffix, ".shtm"))))
+    {
+        return (NULL);
+    }
+
+    length  = strlen(path);
+    gz_path = httpsrv_mem_alloc(length + sizeof(".gz"));
+    if (gz_path != NULL)
+    {
+        memcpy(gz_path, path, length);
+        memcpy(gz_path + length, ".gz", sizeof(".gz"));
+        file = HTTPSRV_FS_open(gz_path);
+        httpsrv_mem_free(gz_path);
+    }
+    return (file);
+}
+#endif
+
 /*
  ** Function for HTTP sending response, used only if request is not for CGI/SSI
  **
@@ -807,6 +1256,11 @@ static HTTPSRV_SES_STATE httpsrv_response(HTTPSRV_STRUCT *server, HTTPSRV_SESSIO
                 retval = httpsrv_sendfile(server, session);
             }
             break;
+#if HTTPSRV_CFG_ETAG_ENABLED
+        case HTTPSRV_CODE_NOT_MODIFIED:
+            httpsrv_send_not_modified(session);
+            break;
+#endif
         case HTTPSRV_CODE_UNAUTHORIZED:
             httpsrv_send_err_page(session, "Unauthorized", "Unauthorized!");
             break;
@@ -840,7 +1294,12 @@ static inline void httpsrv_ses_set_state(HTTPSRV_SESSION_STRUCT *session, HTTPSR
     if ((session->request.method != HTTPSRV_REQ_POST) ||
         ((session->response.status_code != HTTPSRV_CODE_OK) && (session->script_tid == 0)))
     {
+#if HTTPSRV_CFG_EVENT_LOOP_ENABLED
+        /* Keep output the socket did not take yet */
+        session->buffer.offset = session->tx_pending;
+#else
         session->buffer.offset = 0;
+#endif
     }
 }
 
@@ -861,9 +1320,17 @@ static inline void httpsrv_ses_set_state(HTTPSRV_SESSION_STRUCT *session, HTTPSR
 static void httpsrv_plugin_run(void *server_ptr, void *session_ptr)
 {
     HTTPSRV_SESSION_STRUCT *session = (HTTPSRV_SESSION_STRUCT *)session_ptr;
+#if HTTPSRV_CFG_EVENT_LOOP_ENABLED
+    /* Run one step of WebSocket session, the event loop calls again until it ends. */
+    if (ws_session_step(session) == WS_ERR_FAIL)
+    {
+        session->valid = HTTPSRV_INVALID;
+    }
+#else
     /* Run WebSocket session task. */
     ws_session_run(session);
     session->valid = HTTPSRV_INVALID;
+#endif
 }
 
 #endif
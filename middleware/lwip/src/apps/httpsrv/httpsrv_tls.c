@@ -163,6 +163,22 @@ static int httpsrv_mbedtls_send(void *ctx, unsigned char const *buf, size_t len)
     return result;
 }
 
+#if HTTPSRV_CFG_EVENT_LOOP_ENABLED
+/* Send for the event loop, which never blocks after the handshake */
+static int httpsrv_mbedtls_send_nb(void *ctx, unsigned char const *buf, size_t len)
+{
+    int result;
+
+    result = lwip_send((int)ctx, buf, len, MSG_DONTWAIT);
+    if ((result == -1) && (errno == EWOULDBLOCK))
+    {
+        result = MBEDTLS_ERR_SSL_WANT_WRITE;
+    }
+
+    return result;
+}
+#endif
+
 static int httpsrv_mbedtls_recv(void *ctx, unsigned char *buf, size_t len)
 {
     int result;
@@ -217,6 +233,12 @@ httpsrv_tls_sock_t httpsrv_tls_socket(httpsrv_tls_ctx_t ctx, int sock)
                 httpsrv_tls_shutdown(tls_sock);
                 tls_sock = 0;
             }
+#if HTTPSRV_CFG_EVENT_LOOP_ENABLED
+            else
+            {
+                mbedtls_ssl_set_bio(tls_sock, (void *)sock, httpsrv_mbedtls_send_nb, httpsrv_mbedtls_recv, NULL);
+            }
+#endif
         }
     }
 #endif
@@ -256,6 +278,18 @@ int httpsrv_tls_recv(httpsrv_tls_sock_t tls_sock, void *buf, size_t len, int fla
 #endif
 
 #if HTTPSRV_CFG_MBEDTLS_ENABLE
+#if HTTPSRV_CFG_EVENT_LOOP_ENABLED
+    /* The receive BIO blocks, do not read when nothing is decrypted and nothing arrived */
+    if ((flags & MSG_DONTWAIT) && (mbedtls_ssl_get_bytes_avail(tls_sock) == 0))
+    {
+        char peek;
+
+        if ((lwip_recv((int)tls_sock->p_bio, &peek, 1, MSG_PEEK | MSG_DONTWAIT) == -1) && (errno == EWOULDBLOCK))
+        {
+            return (-1);
+        }
+    }
+#endif
     result = mbedtls_ssl_read(tls_sock, buf, len);
 #endif
 
@@ -269,10 +303,24 @@ int32_t httpsrv_tls_send(httpsrv_tls_sock_t tls_sock, const void *buf, size_t le
 
 #if HTTPSRV_CFG_WOLFSSL_ENABLE
     result = wolfSSL_send(tls_sock, buf, len, flags);
+#if HTTPSRV_CFG_EVENT_LOOP_ENABLED
+    /* Nothing sent, the same data has to be passed again */
+    if ((result < 0) && (wolfSSL_get_error(tls_sock, result) == SSL_ERROR_WANT_WRITE))
+    {
+        result = 0;
+    }
+#endif
 #endif
 
 #if HTTPSRV_CFG_MBEDTLS_ENABLE
     result = mbedtls_ssl_write(tls_sock, buf, len);
+#if HTTPSRV_CFG_EVENT_LOOP_ENABLED
+    /* Nothing sent, the same data has to be passed again */
+    if (result == MBEDTLS_ERR_SSL_WANT_WRITE)
+    {
+        result = 0;
+    }
+#endif
 #endif
 
     return result;
@@ -70,6 +70,62 @@ void ws_session_run(HTTPSRV_SESSION_STRUCT *session)
     }
 }
 
+#if HTTPSRV_CFG_EVENT_LOOP_ENABLED
+/*
+ * Run one pass of WebSocket session from the server event loop. Returns
+ * WS_ERR_FAIL when the session has ended.
+ */
+uint32_t ws_session_step(HTTPSRV_SESSION_STRUCT *session)
+{
+    WS_CONTEXT_STRUCT *context = (WS_CONTEXT_STRUCT *)session->ws_context;
+    uint32_t retval;
+
+    if (!session->valid)
+    {
+        /* Server release */
+        retval = WS_ERR_FAIL;
+    }
+    else
+    {
+        if (context == NULL)
+        {
+            if (ws_init(session, &context) != WS_ERR_OK)
+            {
+                if (context != NULL)
+                {
+                    httpsrv_mem_free(context);
+                }
+                return (WS_ERR_FAIL);
+            }
+            session->ws_context = context;
+        }
+        retval = ws_process(context);
+    }
+
+    /* No receive timeout in the event loop, ping idle client here. */
+    if ((retval != WS_ERR_FAIL) && ((sys_now() - session->time) > (WSCFG_PING_PERIOD * 1000)))
+    {
+        if (context->state != WS_STATE_WAIT_PONG)
+        {
+            ws_send_control_frame(context, (uint8_t *)WS_PING_STRING, strlen(WS_PING_STRING), WS_OPCODE_PING);
+            context->state = WS_STATE_WAIT_PONG;
+            session->time  = sys_now();
+        }
+        else
+        {
+            retval = ws_recv_fail(context);
+        }
+    }
+
+    if ((retval == WS_ERR_FAIL) && (context != NULL))
+    {
+        ws_deinit(context);
+        session->ws_context = NULL;
+    }
+    return (retval);
+}
+#endif
+
 /*
  * Upgrade HTTP session to WebSocket session.
  */
@@ -258,6 +314,7 @@ static uint32_t ws_recv(WS_CONTEXT_STRUCT *context)
         }
 
         buffer->offset += received_size;
+        context->session->time = sys_now();
 
         /* If we are reading frame header, receive data until whole header is in buffer. */
         if (buffer == &context->hdr_buffer)
@@ -382,7 +439,8 @@ static uint32_t ws_process_api_calls(WS_CONTEXT_STRUCT *context)
 
     retval = WS_ERR_PASS;
 
-    while (active == 0)
+    /* The event loop already waits for the socket, take a single look there. */
+    do
     {
         FD_ZERO(&readset);
         FD_ZERO(&exceptset);
@@ -469,7 +527,7 @@ static uint32_t ws_process_api_calls(WS_CONTEXT_STRUCT *context)
                 }
             }
         }
-    } /* while */
+    } while ((active == 0) && !HTTPSRV_CFG_EVENT_LOOP_ENABLED);
 EXIT:
     return (retval);
 }
@@ -1166,7 +1224,7 @@ static int ws_send_frame(WS_CONTEXT_STRUCT *context, WS_FRAME_STRUCT *frame)
         }
         /* Write frame to buffer and send it. */
         ws_write_frame(buffer->data, frame);
-        retval = httpsrv_send(context->session, (char *)buffer->data, ws_get_frame_size(frame), 0);
+        retval = httpsrv_send_all(context->session, (char *)buffer->data, ws_get_frame_size(frame));
         if (retval == -1)
         {
             break;
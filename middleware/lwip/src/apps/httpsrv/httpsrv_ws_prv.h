@@ -259,6 +259,9 @@ extern "C" {
 void ws_session_task(void *init_ptr, void *creator);
 void ws_handshake(WS_HANDSHAKE_STRUCT *handshake);
 void ws_session_run(struct httpsrv_session_struct *session);
+#if HTTPSRV_CFG_EVENT_LOOP_ENABLED
+uint32_t ws_session_step(struct httpsrv_session_struct *session);
+#endif
 
 #ifdef __cplusplus
 }
@@ -36,10 +36,15 @@
 # (pages, pictures, ...) in C constant arrays. Separate C files can be created for selected
 # input files.
 #
+# With -z, a gzip compressed variant "<file>.gz" is added for text files which
+# compress. HTTPSRV sends it instead of the file to clients accepting gzip encoding
+# (requires the IO::Compress::Gzip module). Every directory entry gets the entity tag
+# of its data, HTTPSRV uses it for ETag/If-None-Match validation.
+#
 # Perl:
-# 	perl mkfs.pl -s <separate_file> <input directory>
+# 	perl mkfs.pl [-z] -s <separate_file> <input directory>
 #
-# 	Example: perl mkfs.pl -s image.bmp my_web
+# 	Example: perl mkfs.pl -z -s image.bmp my_web
 
 
 use File::Find;
@@ -50,9 +55,13 @@ use File::Compare;
 
 %SEPARATE_FILES = ();
 $INPUT_DIR = "";
+$GZIP = 0;
 while(@ARGV)
 {
-  if ($ARGV[0] =~ /^-s$/)
+  if ($ARGV[0] =~ /^-z$/)
+  {
+    $GZIP = 1;
+  } elsif ($ARGV[0] =~ /^-s$/)
   {
     shift @ARGV;
     if (@ARGV == 0) { last; }
@@ -74,11 +83,12 @@ if (($INPUT_DIR =~ /^$/) || (@ARGV))
   my $readme =
       "\tThis tool creates C language source file httpsrv_fs_data.c with\n".
       "\tconstant arrays of binary data of all input directory files.\n".
-      "\tData of selected files can be stored in separate C files.\n";
+      "\tData of selected files can be stored in separate C files.\n".
+      "\t-z adds gzip compressed variants of text files.\n";
 
   print "$readme\n";
   print "Usage:\n";
-  print "mkfs.pl [-s <separate_file>] <input_directory>\n";
+  print "mkfs.pl [-z] [-s <separate_file>] <input_directory>\n";
   exit(0);
 }
 
@@ -87,6 +97,11 @@ if (($INPUT_DIR =~ /^$/) || (@ARGV))
 @INPUT_FILES = ();
 find (\&get_files, $INPUT_DIR);
 
+if ($GZIP)
+{
+  require IO::Compress::Gzip;
+}
+
 # Open httpsrv_fs_data.tmp for writing
 
 open(OUTPUT, "> httpsrv_fs_data.tmp") or die "Can't create temporary file httpsrv_fs_data.tmp!\n";
@@ -105,27 +120,39 @@ foreach $file (@INPUT_FILES)
 
 # Process input files
 
+@ENTRIES = ();
 foreach $file (@INPUT_FILES)
 {
   print "Processing file $file\n";
-  $fvar = "httpsrv_fs_" . $file;
-  $fvar =~ s#[/\.]#_#g;
-  &process_file ($file, $fvar, $SEPARATE_FILES{$file});
+  $content = &read_file ($file);
+  &process_file ($file, $content, $SEPARATE_FILES{$file});
+  if ($GZIP && ($file =~ /\.(html?|css|js|svg|txt|xml|json)$/i))
+  {
+    # Minimal header without name and time, so the output does not change between runs
+    IO::Compress::Gzip::gzip(\$content => \$compressed, Minimal => 1, -Level => 9)
+      or die "Can't compress file ${file}!\n";
+    if (length($compressed) < length($content))
+    {
+      print "Compressed file $file to " . length($compressed) . " bytes\n";
+      &process_file ("${file}.gz", $compressed, 0);
+    }
+  }
 }
 
 # Finish httpsrv_fs_data.tmp file
 
 print(OUTPUT "const HTTPSRV_FS_DIR_ENTRY httpsrv_fs_data[] = {\n");
-foreach $file (@INPUT_FILES)
+foreach $entry (@ENTRIES)
 {
+  ($file, $etag) = @$entry;
   $fvar = "httpsrv_fs_" . $file;
   $fvar =~ s#[/\.]#_#g;
   $dest = $file;
   $dest =~ s/^$INPUT_DIR//;
   print(OUTPUT "\t{ \"${dest}\", 0, ");
-  print(OUTPUT "(unsigned char*)${fvar}, sizeof(${fvar}) },\n");
+  printf(OUTPUT "(unsigned char*)${fvar}, sizeof(${fvar}), 0x%08xu },\n", $etag);
 }
-print(OUTPUT "\t{ 0, 0, 0, 0 }\n};\n\n");
+print(OUTPUT "\t{ 0, 0, 0, 0, 0 }\n};\n\n");
 close(OUTPUT);
 
 # Rename temporary to *.c files
@@ -188,13 +215,42 @@ sub check_write_protect
 }
 
 
-sub process_file
+sub read_file
 {
-  my ($file, $fvar, $separate) = @_;
+  my ($file) = @_;
+  my $content;
 
   open(FILE, $file) or die "Can't open file ${file}!\n";
-
   binmode(FILE);
+  local $/;
+  $content = <FILE>;
+  close(FILE);
+  return defined($content) ? $content : "";
+}
+
+
+# Entity tag, the same 32-bit FNV-1a as HTTPSRV_FS_etag()
+sub etag
+{
+  my ($content) = @_;
+  my $hash = 2166136261;
+
+  foreach (unpack("C*", $content))
+  {
+    $hash = (($hash ^ $_) * 16777619) & 0xffffffff;
+  }
+  return ($hash != 0) ? $hash : 1;
+}
+
+
+sub process_file
+{
+  my ($file, $content, $separate) = @_;
+  my $fvar = "httpsrv_fs_" . $file;
+  my $offset;
+
+  $fvar =~ s#[/\.]#_#g;
+  push(@ENTRIES, [$file, &etag($content)]);
 
   $output = "OUTPUT";
   if ($separate)
@@ -210,11 +266,11 @@ sub process_file
   print($output "\t/* $file */\n");
 
   $sep = "\t";
-  while(read(FILE, $data, 10, 0))
+  for ($offset = 0; $offset < length($content); $offset += 10)
   {
-    foreach(split(//, $data))
+    foreach(unpack("C*", substr($content, $offset, 10)))
     {
-      printf($output "${sep}0x%02x", ord($_));
+      printf($output "${sep}0x%02x", $_);
       $sep = ", ";
     }
     $sep = ",\n\t";
@@ -226,7 +282,5 @@ sub process_file
   {
     close($output);
   }
-  
-  close(FILE);
 }
 
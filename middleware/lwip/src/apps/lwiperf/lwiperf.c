@@ -1775,7 +1775,7 @@ lwiperf_start_udp_client(const ip_addr_t *local_addr, u16_t local_port,
       local_addr ? (IP_IS_V6(local_addr) ? IP6_ADDR_ANY : local_addr) : IP_ADDR_ANY, local_port,
       report_fn, report_arg);
 #elif LWIP_IPV4
-    s = lwiperf_start_udp_server(
+    s = (lwiperf_state_udp_t *)lwiperf_start_udp_server(
       local_addr ? local_addr : IP_ADDR_ANY, local_port,
       report_fn, report_arg);
 #endif /* LWIP_IPV6 */
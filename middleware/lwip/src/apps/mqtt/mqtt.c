@@ -162,17 +162,20 @@ mqtt_msg_type_to_str(u8_t msg_type)
 
 
 /**
- * Generate MQTT packet identifier
+ * Generate MQTT packet identifier, skipping identifiers whose request index entry is taken.
+ * The caller must hold a free request item, so an entry is always found.
  * @param client MQTT client
  * @return New packet identifier, range 1 to 65535
  */
 static u16_t
 msg_generate_packet_id(mqtt_client_t *client)
 {
-  client->pkt_id_seq++;
-  if (client->pkt_id_seq == 0) {
+  do {
     client->pkt_id_seq++;
-  }
+    if (client->pkt_id_seq == 0) {
+      client->pkt_id_seq++;
+    }
+  } while (client->req_index[client->pkt_id_seq % MQTT_REQ_MAX_IN_FLIGHT] != NULL);
   return client->pkt_id_seq;
 }
 
@@ -227,17 +230,19 @@ mqtt_ringbuf_len(struct mqtt_ringbuf_t *rb)
 
 /**
  * Try send as many bytes as possible from output ring buffer
- * @param rb Output ring buffer
- * @param tpcb TCP connection handle
+ * @param client MQTT client
  */
 static void
-mqtt_output_send(struct mqtt_ringbuf_t *rb, struct altcp_pcb *tpcb)
+mqtt_output_send(mqtt_client_t *client)
 {
   err_t err;
   u8_t wrap = 0;
+  struct mqtt_ringbuf_t *rb = &client->output;
+  struct altcp_pcb *tpcb = client->conn;
   u16_t ringbuf_lin_len = mqtt_ringbuf_linear_read_length(rb);
-  u16_t send_len = altcp_sndbuf(tpcb);
+  u16_t send_len;
   LWIP_ASSERT("mqtt_output_send: tpcb != NULL", tpcb != NULL);
+  send_len = altcp_sndbuf(tpcb);
 
   if (send_len == 0 || ringbuf_lin_len == 0) {
     return;
@@ -252,52 +257,78 @@ mqtt_output_send(struct mqtt_ringbuf_t *rb, struct altcp_pcb *tpcb)
     /* Wrap around if more data in ring buffer after linear portion */
     wrap = (mqtt_ringbuf_len(rb) > ringbuf_lin_len);
   }
-  err = altcp_write(tpcb, mqtt_ringbuf_get_ptr(rb), send_len, TCP_WRITE_FLAG_COPY | (wrap ? TCP_WRITE_FLAG_MORE : 0));
+  err = altcp_write(tpcb, mqtt_ringbuf_get_ptr(rb), send_len,
+                    TCP_WRITE_FLAG_COPY | ((wrap || client->batch) ? TCP_WRITE_FLAG_MORE : 0));
   if ((err == ERR_OK) && wrap) {
     mqtt_ringbuf_advance_get_idx(rb, send_len);
+    client->tx_written += send_len;
     /* Use the lesser one of ring buffer linear length and TCP send buffer size */
     send_len = LWIP_MIN(altcp_sndbuf(tpcb), mqtt_ringbuf_linear_read_length(rb));
-    err = altcp_write(tpcb, mqtt_ringbuf_get_ptr(rb), send_len, TCP_WRITE_FLAG_COPY);
+    err = altcp_write(tpcb, mqtt_ringbuf_get_ptr(rb), send_len,
+                      TCP_WRITE_FLAG_COPY | (client->batch ? TCP_WRITE_FLAG_MORE : 0));
   }
 
   if (err == ERR_OK) {
     mqtt_ringbuf_advance_get_idx(rb, send_len);
-    /* Flush */
-    altcp_output(tpcb);
+    client->tx_written += send_len;
+    /* Flush, unless more messages of a batch follow */
+    if (!client->batch) {
+      altcp_output(tpcb);
+    }
   } else {
     LWIP_DEBUGF(MQTT_DEBUG_WARN, ("mqtt_output_send: Send failed with err %d (\"%s\")\n", err, lwip_strerr(err)));
   }
 }
 
-
+/**
+ * Release publish payloads sent without copy once TCP acknowledged them
+ * @param client MQTT client
+ * @param all Release all payloads, TCP connection is gone
+ */
+static void
+mqtt_nocopy_release(mqtt_client_t *client, u8_t all)
+{
+  while (client->nocopy_len > 0) {
+    struct mqtt_nocopy_t *nc = &client->nocopy[client->nocopy_get];
+    if (!all && ((s32_t)(client->tx_acked - nc->tx_end) < 0)) {
+      break;
+    }
+    pbuf_free(nc->p);
+    nc->p = NULL;
+    client->nocopy_get++;
+    if (client->nocopy_get >= MQTT_NOCOPY_MAX_IN_FLIGHT) {
+      client->nocopy_get = 0;
+    }
+    client->nocopy_len--;
+  }
+}
 
 /*--------------------------------------------------------------------------------------------------------------------- */
 /* Request queue */
 
 /**
  * Create request item
- * @param r_objs Pointer to request objects
- * @param r_objs_len Number of array entries
- * @param pkt_id Packet identifier of request
+ * @param client MQTT client
+ * @param with_pkt_id Non-zero to assign a new packet identifier, zero for QoS 0 publish (packet identifier 0)
  * @param cb Packet callback to call when requests lifetime ends
  * @param arg Parameter following callback
  * @return Request or NULL if failed to create
  */
 static struct mqtt_request_t *
-mqtt_create_request(struct mqtt_request_t *r_objs, size_t r_objs_len, u16_t pkt_id, mqtt_request_cb_t cb, void *arg)
+mqtt_create_request(mqtt_client_t *client, u8_t with_pkt_id, mqtt_request_cb_t cb, void *arg)
 {
-  struct mqtt_request_t *r = NULL;
-  u8_t n;
-  LWIP_ASSERT("mqtt_create_request: r_objs != NULL", r_objs != NULL);
-  for (n = 0; n < r_objs_len; n++) {
-    /* Item point to itself if not in use */
-    if (r_objs[n].next == &r_objs[n]) {
-      r = &r_objs[n];
-      r->next = NULL;
-      r->cb = cb;
-      r->arg = arg;
-      r->pkt_id = pkt_id;
-      break;
+  struct mqtt_request_t *r = client->free_req;
+  if (r != NULL) {
+    client->free_req = r->next;
+    r->next = NULL;
+    r->prev = NULL;
+    r->cb = cb;
+    r->arg = arg;
+    r->tx_end = 0;
+    r->pkt_id = 0;
+    if (with_pkt_id) {
+      r->pkt_id = msg_generate_packet_id(client);
+      client->req_index[r->pkt_id % MQTT_REQ_MAX_IN_FLIGHT] = r;
     }
   }
   return r;
@@ -305,141 +336,171 @@ mqtt_create_request(struct mqtt_request_t *r_objs, size_t r_objs_len, u16_t pkt_
 
 
 /**
- * Append request to pending request queue
- * @param tail Pointer to request queue tail pointer
+ * Append request to a request queue. All requests have the same timeout,
+ * so the queue stays in order of expiry.
+ * @param client MQTT client
+ * @param queue Request queue
  * @param r Request to append
  */
 static void
-mqtt_append_request(struct mqtt_request_t **tail, struct mqtt_request_t *r)
+mqtt_append_request(mqtt_client_t *client, struct mqtt_request_queue_t *queue, struct mqtt_request_t *r)
 {
-  struct mqtt_request_t *head = NULL;
-  s16_t time_before = 0;
-  struct mqtt_request_t *iter;
-
-  LWIP_ASSERT("mqtt_append_request: tail != NULL", tail != NULL);
+  LWIP_ASSERT("mqtt_append_request: queue != NULL", queue != NULL);
 
-  /* Iterate through queue to find head, and count total timeout time */
-  for (iter = *tail; iter != NULL; iter = iter->next) {
-    time_before += iter->timeout_diff;
-    head = iter;
+  r->expire = (u16_t)(client->req_time + MQTT_REQ_TIMEOUT);
+  r->next = NULL;
+  r->prev = queue->last;
+  if (queue->last == NULL) {
+    queue->first = r;
+  } else {
+    queue->last->next = r;
   }
+  queue->last = r;
+}
 
-  LWIP_ASSERT("mqtt_append_request: time_before <= MQTT_REQ_TIMEOUT", time_before <= MQTT_REQ_TIMEOUT);
-  r->timeout_diff = MQTT_REQ_TIMEOUT - time_before;
-  if (head == NULL) {
-    *tail = r;
+/**
+ * Unchain request from a request queue
+ * @param queue Request queue
+ * @param r Request in queue
+ */
+static void
+mqtt_unchain_request(struct mqtt_request_queue_t *queue, struct mqtt_request_t *r)
+{
+  if (r->prev == NULL) {
+    queue->first = r->next;
+  } else {
+    r->prev->next = r->next;
+  }
+  if (r->next == NULL) {
+    queue->last = r->prev;
   } else {
-    head->next = r;
+    r->next->prev = r->prev;
   }
+  r->next = NULL;
+  r->prev = NULL;
 }
 
 
 /**
  * Delete request item
- * @param r Request item to delete
+ * @param client MQTT client
+ * @param r Request item to delete, not in any queue
  */
 static void
-mqtt_delete_request(struct mqtt_request_t *r)
+mqtt_delete_request(mqtt_client_t *client, struct mqtt_request_t *r)
 {
   if (r != NULL) {
-    r->next = r;
+    if ((r->pkt_id != 0) && (client->req_index[r->pkt_id % MQTT_REQ_MAX_IN_FLIGHT] == r)) {
+      client->req_index[r->pkt_id % MQTT_REQ_MAX_IN_FLIGHT] = NULL;
+    }
+    r->next = client->free_req;
+    client->free_req = r;
   }
 }
 
 /**
- * Remove a request item with a specific packet identifier from request queue
- * @param tail Pointer to request queue tail pointer
- * @param pkt_id Packet identifier of request to take
+ * Remove the request with a specific packet identifier from pending request queue
+ * @param client MQTT client
+ * @param pkt_id Packet identifier of request to take, not 0
  * @return Request item if found, NULL if not
  */
 static struct mqtt_request_t *
-mqtt_take_request(struct mqtt_request_t **tail, u16_t pkt_id)
+mqtt_take_request(mqtt_client_t *client, u16_t pkt_id)
 {
-  struct mqtt_request_t *iter = NULL, *prev = NULL;
-  LWIP_ASSERT("mqtt_take_request: tail != NULL", tail != NULL);
-  /* Search all request for pkt_id */
-  for (iter = *tail; iter != NULL; iter = iter->next) {
-    if (iter->pkt_id == pkt_id) {
-      break;
-    }
-    prev = iter;
+  struct mqtt_request_t *r = client->req_index[pkt_id % MQTT_REQ_MAX_IN_FLIGHT];
+
+  if ((r == NULL) || (r->pkt_id != pkt_id)) {
+    return NULL;
   }
+  mqtt_unchain_request(&client->pend_req_queue, r);
+  client->req_index[pkt_id % MQTT_REQ_MAX_IN_FLIGHT] = NULL;
+  return r;
+}
 
-  /* If request was found */
-  if (iter != NULL) {
-    /* unchain */
-    if (prev == NULL) {
-      *tail = iter->next;
-    } else {
-      prev->next = iter->next;
-    }
-    /* If exists, add remaining timeout time for the request to next */
-    if (iter->next != NULL) {
-      iter->next->timeout_diff += iter->timeout_diff;
+/**
+ * Complete QoS 0 publish requests acknowledged by TCP
+ * @param client MQTT client
+ */
+static void
+mqtt_complete_qos0_requests(mqtt_client_t *client)
+{
+  struct mqtt_request_t *r;
+  /* Queue might be modified in callback, so re-read it in every iteration */
+  while (((r = client->pend_qos0_queue.first) != NULL) && ((s32_t)(client->tx_acked - r->tx_end) >= 0)) {
+    mqtt_unchain_request(&client->pend_qos0_queue, r);
+    LWIP_DEBUGF(MQTT_DEBUG_TRACE, ("mqtt_complete_qos0_requests: Calling QoS 0 publish complete callback\n"));
+    if (r->cb != NULL) {
+      r->cb(r->arg, ERR_OK);
     }
-    iter->next = NULL;
+    mqtt_delete_request(client, r);
   }
-  return iter;
 }
 
 /**
- * Handle requests timeout
- * @param tail Pointer to request queue tail pointer
- * @param t Time since last call in seconds
+ * Handle requests timeout in one request queue
+ * @param client MQTT client
+ * @param queue Request queue
  */
 static void
-mqtt_request_time_elapsed(struct mqtt_request_t **tail, u8_t t)
+mqtt_request_queue_expire(mqtt_client_t *client, struct mqtt_request_queue_t *queue)
 {
   struct mqtt_request_t *r;
-  LWIP_ASSERT("mqtt_request_time_elapsed: tail != NULL", tail != NULL);
-  r = *tail;
-  while (t > 0 && r != NULL) {
-    if (t >= r->timeout_diff) {
-      t -= (u8_t)r->timeout_diff;
-      /* Unchain */
-      *tail = r->next;
-      /* Notify upper layer about timeout */
-      if (r->cb != NULL) {
-        r->cb(r->arg, ERR_TIMEOUT);
-      }
-      mqtt_delete_request(r);
-      /* Tail might be be modified in callback, so re-read it in every iteration */
-      r = *(struct mqtt_request_t *const volatile *)tail;
-    } else {
-      r->timeout_diff -= t;
-      t = 0;
+  /* Queue might be modified in callback, so re-read it in every iteration */
+  while (((r = queue->first) != NULL) && ((s16_t)(client->req_time - r->expire) >= 0)) {
+    mqtt_unchain_request(queue, r);
+    /* Notify upper layer about timeout */
+    if (r->cb != NULL) {
+      r->cb(r->arg, ERR_TIMEOUT);
     }
+    mqtt_delete_request(client, r);
   }
 }
 
+/**
+ * Handle requests timeout
+ * @param client MQTT client
+ * @param t Time since last call in seconds
+ */
+static void
+mqtt_request_time_elapsed(mqtt_client_t *client, u8_t t)
+{
+  client->req_time = (u16_t)(client->req_time + t);
+  mqtt_request_queue_expire(client, &client->pend_req_queue);
+  mqtt_request_queue_expire(client, &client->pend_qos0_queue);
+}
+
 /**
  * Free all request items
- * @param tail Pointer to request queue tail pointer
+ * @param client MQTT client
  */
 static void
-mqtt_clear_requests(struct mqtt_request_t **tail)
+mqtt_clear_requests(mqtt_client_t *client)
 {
-  struct mqtt_request_t *iter, *next;
-  LWIP_ASSERT("mqtt_clear_requests: tail != NULL", tail != NULL);
-  for (iter = *tail; iter != NULL; iter = next) {
-    next = iter->next;
-    mqtt_delete_request(iter);
+  struct mqtt_request_t *r;
+  while ((r = client->pend_req_queue.first) != NULL) {
+    mqtt_unchain_request(&client->pend_req_queue, r);
+    mqtt_delete_request(client, r);
+  }
+  while ((r = client->pend_qos0_queue.first) != NULL) {
+    mqtt_unchain_request(&client->pend_qos0_queue, r);
+    mqtt_delete_request(client, r);
   }
-  *tail = NULL;
 }
 /**
  * Initialize all request items
- * @param r_objs Pointer to request objects
- * @param r_objs_len Number of array entries
+ * @param client MQTT client
  */
 static void
-mqtt_init_requests(struct mqtt_request_t *r_objs, size_t r_objs_len)
+mqtt_init_requests(mqtt_client_t *client)
 {
-  u8_t n;
-  LWIP_ASSERT("mqtt_init_requests: r_objs != NULL", r_objs != NULL);
-  for (n = 0; n < r_objs_len; n++) {
-    /* Item pointing to itself indicates unused */
-    r_objs[n].next = &r_objs[n];
+  size_t n;
+  client->pend_req_queue.first = client->pend_req_queue.last = NULL;
+  client->pend_qos0_queue.first = client->pend_qos0_queue.last = NULL;
+  client->free_req = NULL;
+  for (n = 0; n < LWIP_ARRAYSIZE(client->req_list); n++) {
+    client->req_index[n] = NULL;
+    client->req_list[n].next = client->free_req;
+    client->free_req = &client->req_list[n];
   }
 }
 
@@ -463,9 +524,21 @@ void mqtt_output_append_u16(struct mqtt_ringbuf_t *rb, u16_t value)
 static void
 mqtt_output_append_buf(struct mqtt_ringbuf_t *rb, const void *data, u16_t length)
 {
-  u16_t n;
-  for (n = 0; n < length; n++) {
-    mqtt_ringbuf_put(rb, ((const u8_t *)data)[n]);
+  /* Copy in up to two linear pieces, the space was checked before */
+  u16_t lin_len = LWIP_MIN(length, (u16_t)(MQTT_OUTPUT_RINGBUF_SIZE - rb->put));
+  MEMCPY(&rb->buf[rb->put], data, lin_len);
+  MEMCPY(&rb->buf[0], (const u8_t *)data + lin_len, length - lin_len);
+  rb->put = (u16_t)(rb->put + length);
+  if (rb->put >= MQTT_OUTPUT_RINGBUF_SIZE) {
+    rb->put = (u16_t)(rb->put - MQTT_OUTPUT_RINGBUF_SIZE);
+  }
+}
+
+static void
+mqtt_output_append_pbuf(struct mqtt_ringbuf_t *rb, const struct pbuf *p)
+{
+  for (; p != NULL; p = p->next) {
+    mqtt_output_append_buf(rb, p->payload, p->len);
   }
 }
 
@@ -524,7 +597,58 @@ mqtt_output_check_space(struct mqtt_ringbuf_t *rb, u16_t r_length)
     r_length >>= 7;
   } while (r_length > 0);
 
-  return (total_len <= mqtt_ringbuf_free(rb));
+  /* Keep one byte free, a full ring buffer would look empty (put == get) */
+  return (total_len < mqtt_ringbuf_free(rb));
+}
+
+/**
+ * Append PUBLISH fixed header, topic and packet identifier
+ * @param rb Output ring buffer
+ * @param topic Publish topic string
+ * @param topic_len Length of topic
+ * @param qos MQTT QoS field
+ * @param retain MQTT retain flag
+ * @param pkt_id Packet identifier, only used for QoS 1 and 2
+ * @param r_length Remaining length after fixed header
+ */
+static void
+mqtt_output_append_publish_header(struct mqtt_ringbuf_t *rb, const char *topic, u16_t topic_len,
+                                  u8_t qos, u8_t retain, u16_t pkt_id, u16_t r_length)
+{
+  /* Append fixed header */
+  mqtt_output_append_fixed_header(rb, MQTT_MSG_TYPE_PUBLISH, 0, qos, retain, r_length);
+
+  /* Append Topic */
+  mqtt_output_append_string(rb, topic, topic_len);
+
+  /* Append packet if for QoS 1 and 2*/
+  if (qos > 0) {
+    mqtt_output_append_u16(rb, pkt_id);
+  }
+}
+
+/**
+ * Check if TCP can queue a message without copying its payload
+ * @param client MQTT client
+ * @param hdr_len Length of message up to the payload, copied
+ * @param p Payload
+ * @return 1 if the message will fit, 0 if not
+ */
+static u8_t
+mqtt_output_nocopy_fits(mqtt_client_t *client, u16_t hdr_len, const struct pbuf *p)
+{
+  u16_t mss = altcp_mss(client->conn);
+  /* The copied header might span two segments */
+  u32_t queuelen = 2;
+
+  if ((mss == 0) || (altcp_sndbuf(client->conn) < (u32_t)hdr_len + p->tot_len)) {
+    return 0;
+  }
+  for (; p != NULL; p = p->next) {
+    /* A reference and a header pbuf per segment, one more when extending the previous segment */
+    queuelen += 2 * (p->len / mss + 1) + 1;
+  }
+  return (altcp_sndqueuelen(client->conn) + queuelen <= TCP_SND_QUEUELEN);
 }
 
 
@@ -540,20 +664,24 @@ mqtt_close(mqtt_client_t *client, mqtt_connection_status_t reason)
 
   /* Bring down TCP connection if not already done */
   if (client->conn != NULL) {
-    err_t res;
+    err_t res = ERR_INPROGRESS;
     altcp_recv(client->conn, NULL);
     altcp_err(client->conn,  NULL);
     altcp_sent(client->conn, NULL);
-    res = altcp_close(client->conn);
+    /* Payloads sent without copy are released below, so TCP must not hold on to them */
+    if (client->nocopy_len == 0) {
+      res = altcp_close(client->conn);
+    }
     if (res != ERR_OK) {
       altcp_abort(client->conn);
       LWIP_DEBUGF(MQTT_DEBUG_TRACE, ("mqtt_close: Close err=%s\n", lwip_strerr(res)));
     }
     client->conn = NULL;
   }
+  mqtt_nocopy_release(client, 1);
 
   /* Remove all pending requests */
-  mqtt_clear_requests(&client->pend_req_queue);
+  mqtt_clear_requests(client);
   /* Stop cyclic timer */
   sys_untimeout(mqtt_cyclic_timer, client);
 
@@ -589,7 +717,7 @@ mqtt_cyclic_timer(void *arg)
     }
   } else if (client->conn_state == MQTT_CONNECTED) {
     /* Handle timeout for pending requests */
-    mqtt_request_time_elapsed(&client->pend_req_queue, MQTT_CYCLIC_TIMER_INTERVAL);
+    mqtt_request_time_elapsed(client, MQTT_CYCLIC_TIMER_INTERVAL);
 
     /* keep_alive > 0 means keep alive functionality shall be used */
     if (client->keep_alive > 0) {
@@ -637,7 +765,7 @@ pub_ack_rec_rel_response(mqtt_client_t *client, u8_t msg, u16_t pkt_id, u8_t qos
   if (mqtt_output_check_space(&client->output, 2)) {
     mqtt_output_append_fixed_header(&client->output, msg, 0, qos, 0, 2);
     mqtt_output_append_u16(&client->output, pkt_id);
-    mqtt_output_send(&client->output, client->conn);
+    mqtt_output_send(client);
   } else {
     LWIP_DEBUGF(MQTT_DEBUG_TRACE, ("pub_ack_rec_rel_response: OOM creating response: %s with pkt_id: %d\n",
                                    mqtt_msg_type_to_str(msg), pkt_id));
@@ -804,7 +932,7 @@ mqtt_message_received(mqtt_client_t *client, u8_t fixed_hdr_len, u16_t length, u
 
     } else if (pkt_type == MQTT_MSG_TYPE_SUBACK || pkt_type == MQTT_MSG_TYPE_UNSUBACK ||
                pkt_type == MQTT_MSG_TYPE_PUBCOMP || pkt_type == MQTT_MSG_TYPE_PUBACK) {
-      struct mqtt_request_t *r = mqtt_take_request(&client->pend_req_queue, pkt_id);
+      struct mqtt_request_t *r = mqtt_take_request(client, pkt_id);
       if (r != NULL) {
         LWIP_DEBUGF(MQTT_DEBUG_TRACE, ("mqtt_message_received: %s response with id %d\n", mqtt_msg_type_to_str(pkt_type), pkt_id));
         if (pkt_type == MQTT_MSG_TYPE_SUBACK) {
@@ -817,7 +945,7 @@ mqtt_message_received(mqtt_client_t *client, u8_t fixed_hdr_len, u16_t length, u
         } else if (r->cb != NULL) {
           r->cb(r->arg, ERR_OK);
         }
-        mqtt_delete_request(r);
+        mqtt_delete_request(client, r);
       } else {
         LWIP_DEBUGF(MQTT_DEBUG_WARN, ( "mqtt_message_received: Received %s reply, with wrong pkt_id: %d\n", mqtt_msg_type_to_str(pkt_type), pkt_id));
       }
@@ -985,24 +1113,18 @@ mqtt_tcp_sent_cb(void *arg, struct altcp_pcb *tpcb, u16_t len)
   mqtt_client_t *client = (mqtt_client_t *)arg;
 
   LWIP_UNUSED_ARG(tpcb);
-  LWIP_UNUSED_ARG(len);
 
-  if (client->conn_state == MQTT_CONNECTED) {
-    struct mqtt_request_t *r;
+  client->tx_acked += len;
+  mqtt_nocopy_release(client, 0);
 
+  if (client->conn_state == MQTT_CONNECTED) {
     /* Reset keep-alive send timer and server watchdog */
     client->cyclic_tick = 0;
     client->server_watchdog = 0;
-    /* QoS 0 publish has no response from server, so call its callbacks here */
-    while ((r = mqtt_take_request(&client->pend_req_queue, 0)) != NULL) {
-      LWIP_DEBUGF(MQTT_DEBUG_TRACE, ("mqtt_tcp_sent_cb: Calling QoS 0 publish complete callback\n"));
-      if (r->cb != NULL) {
-        r->cb(r->arg, ERR_OK);
-      }
-      mqtt_delete_request(r);
-    }
+    /* QoS 0 publish has no response from server, so call its callbacks when acknowledged */
+    mqtt_complete_qos0_requests(client);
     /* Try send any remaining buffers from output queue */
-    mqtt_output_send(&client->output, client->conn);
+    mqtt_output_send(client);
   }
   return ERR_OK;
 }
@@ -1034,9 +1156,10 @@ static err_t
 mqtt_tcp_poll_cb(void *arg, struct altcp_pcb *tpcb)
 {
   mqtt_client_t *client = (mqtt_client_t *)arg;
+  LWIP_UNUSED_ARG(tpcb);
   if (client->conn_state == MQTT_CONNECTED) {
     /* Try send any remaining buffers from output queue */
-    mqtt_output_send(&client->output, tpcb);
+    mqtt_output_send(client);
   }
   return ERR_OK;
 }
@@ -1074,7 +1197,7 @@ mqtt_tcp_connect_cb(void *arg, struct altcp_pcb *tpcb, err_t err)
   client->cyclic_tick = 0;
 
   /* Start transmission from output queue, connect message is the first one out*/
-  mqtt_output_send(&client->output, client->conn);
+  mqtt_output_send(client);
 
   return ERR_OK;
 }
@@ -1094,7 +1217,8 @@ mqtt_tcp_connect_cb(void *arg, struct altcp_pcb *tpcb, err_t err)
  * @param payload_length Length of payload (0 is allowed)
  * @param qos Quality of service, 0 1 or 2
  * @param retain MQTT retain flag
- * @param cb Callback to call when publish is complete or has timed out
+ * @param cb Callback to call when publish is complete or has timed out. QoS 0 publish
+ *           without callback is not limited by MQTT_REQ_MAX_IN_FLIGHT
  * @param arg User supplied argument to publish callback
  * @return ERR_OK if successful
  *         ERR_CONN if client is disconnected
@@ -1105,7 +1229,6 @@ mqtt_publish(mqtt_client_t *client, const char *topic, const void *payload, u16_
              mqtt_request_cb_t cb, void *arg)
 {
   struct mqtt_request_t *r;
-  u16_t pkt_id;
   size_t topic_strlen;
   size_t total_len;
   u16_t topic_len;
@@ -1123,47 +1246,203 @@ mqtt_publish(mqtt_client_t *client, const char *topic, const void *payload, u16_
 
   if (qos > 0) {
     total_len += 2;
-    /* Generate pkt_id id for QoS1 and 2 */
-    pkt_id = msg_generate_packet_id(client);
-  } else {
-    /* Use reserved value pkt_id 0 for QoS 0 in request handle */
-    pkt_id = 0;
   }
   LWIP_ERROR("mqtt_publish: total length overflow", (total_len <= 0xFFFF), return ERR_ARG);
   remaining_length = (u16_t)total_len;
 
   LWIP_DEBUGF(MQTT_DEBUG_TRACE, ("mqtt_publish: Publish with payload length %d to topic \"%s\"\n", payload_length, topic));
 
-  r = mqtt_create_request(client->req_list, LWIP_ARRAYSIZE(client->req_list), pkt_id, cb, arg);
-  if (r == NULL) {
-    return ERR_MEM;
+  /* Generate pkt_id id for QoS1 and 2, use reserved value pkt_id 0 for QoS 0 in request handle.
+     QoS 0 publish without callback needs no request handle. */
+  r = NULL;
+  if ((qos > 0) || (cb != NULL)) {
+    r = mqtt_create_request(client, qos > 0, cb, arg);
+    if (r == NULL) {
+      return ERR_MEM;
+    }
   }
 
   if (mqtt_output_check_space(&client->output, remaining_length) == 0) {
-    mqtt_delete_request(r);
+    mqtt_delete_request(client, r);
     return ERR_MEM;
   }
-  /* Append fixed header */
-  mqtt_output_append_fixed_header(&client->output, MQTT_MSG_TYPE_PUBLISH, 0, qos, retain, remaining_length);
+  mqtt_output_append_publish_header(&client->output, topic, topic_len, qos, retain,
+                                    (r != NULL) ? r->pkt_id : 0, remaining_length);
 
-  /* Append Topic */
-  mqtt_output_append_string(&client->output, topic, topic_len);
+  /* Append optional publish payload */
+  if ((payload != NULL) && (payload_length > 0)) {
+    mqtt_output_append_buf(&client->output, payload, payload_length);
+  }
+
+  if (r != NULL) {
+    r->tx_end = client->tx_written + mqtt_ringbuf_len(&client->output);
+    mqtt_append_request(client, (qos > 0) ? &client->pend_req_queue : &client->pend_qos0_queue, r);
+  }
+  mqtt_output_send(client);
+  return ERR_OK;
+}
+
+/**
+ * @ingroup mqtt
+ * MQTT publish function for payloads in a pbuf chain.
+ * When connected and TCP has room for the whole message, TCP references the payload
+ * instead of copying it: the client keeps a reference to p until TCP acknowledged
+ * the payload (at most MQTT_NOCOPY_MAX_IN_FLIGHT payloads), so the payload data must
+ * not be changed until then. Otherwise the payload is copied into the output
+ * ring-buffer like mqtt_publish() does.
+ * mqtt_disconnect() aborts the TCP connection while payloads are still referenced.
+ * @param client MQTT client
+ * @param topic Publish topic string
+ * @param p Data to publish, the caller keeps its reference
+ * @param qos Quality of service, 0 1 or 2
+ * @param retain MQTT retain flag
+ * @param cb Callback to call when publish is complete or has timed out. QoS 0 publish
+ *           without callback is not limited by MQTT_REQ_MAX_IN_FLIGHT
+ * @param arg User supplied argument to publish callback
+ * @return ERR_OK if successful
+ *         ERR_CONN if client is disconnected
+ *         ERR_MEM if short on memory
+ */
+err_t
+mqtt_publish_pbuf(mqtt_client_t *client, const char *topic, struct pbuf *p, u8_t qos, u8_t retain,
+                  mqtt_request_cb_t cb, void *arg)
+{
+  struct mqtt_request_t *r;
+  size_t topic_strlen;
+  size_t total_len;
+  u16_t topic_len;
+  u16_t remaining_length;
+  u16_t hdr_len;
+
+  LWIP_ASSERT_CORE_LOCKED();
+  LWIP_ASSERT("mqtt_publish_pbuf: client != NULL", client);
+  LWIP_ASSERT("mqtt_publish_pbuf: topic != NULL", topic);
+  LWIP_ASSERT("mqtt_publish_pbuf: p != NULL", p);
+  LWIP_ERROR("mqtt_publish_pbuf: TCP disconnected", (client->conn_state != TCP_DISCONNECTED), return ERR_CONN);
+
+  topic_strlen = strlen(topic);
+  LWIP_ERROR("mqtt_publish_pbuf: topic length overflow", (topic_strlen <= (0xFFFF - 2)), return ERR_ARG);
+  topic_len = (u16_t)topic_strlen;
+  total_len = 2 + topic_len + (size_t)p->tot_len;
 
-  /* Append packet if for QoS 1 and 2*/
   if (qos > 0) {
-    mqtt_output_append_u16(&client->output, pkt_id);
+    total_len += 2;
   }
+  LWIP_ERROR("mqtt_publish_pbuf: total length overflow", (total_len <= 0xFFFF), return ERR_ARG);
+  remaining_length = (u16_t)total_len;
+  /* Control byte, remaining length field, topic and packet identifier */
+  hdr_len = (u16_t)(2 + (remaining_length >= 128) + (remaining_length >= 16384) + (remaining_length - p->tot_len));
 
-  /* Append optional publish payload */
-  if ((payload != NULL) && (payload_length > 0)) {
-    mqtt_output_append_buf(&client->output, payload, payload_length);
+  LWIP_DEBUGF(MQTT_DEBUG_TRACE, ("mqtt_publish_pbuf: Publish with payload length %d to topic \"%s\"\n", p->tot_len, topic));
+
+  r = NULL;
+  if ((qos > 0) || (cb != NULL)) {
+    r = mqtt_create_request(client, qos > 0, cb, arg);
+    if (r == NULL) {
+      return ERR_MEM;
+    }
+  }
+
+  /* Payload can only be referenced when everything queued before is written to TCP */
+  if (client->conn_state == MQTT_CONNECTED) {
+    mqtt_output_send(client);
+  }
+  if ((client->conn_state == MQTT_CONNECTED) && (mqtt_ringbuf_len(&client->output) == 0) &&
+      (client->nocopy_len < MQTT_NOCOPY_MAX_IN_FLIGHT) && (hdr_len < MQTT_OUTPUT_RINGBUF_SIZE) &&
+      mqtt_output_nocopy_fits(client, hdr_len, p)) {
+    struct pbuf *q = p;
+
+    /* Header goes through the empty ring-buffer, it leaves with the payload */
+    mqtt_output_append_publish_header(&client->output, topic, topic_len, qos, retain,
+                                      (r != NULL) ? r->pkt_id : 0, remaining_length);
+    client->batch++;
+    mqtt_output_send(client);
+    client->batch--;
+    if (mqtt_ringbuf_len(&client->output) == 0) {
+      for (; q != NULL; q = q->next) {
+        if (q->len > 0) {
+          if (altcp_write(client->conn, q->payload, q->len,
+                          ((q->next != NULL) || client->batch) ? TCP_WRITE_FLAG_MORE : 0) != ERR_OK) {
+            break;
+          }
+          client->tx_written += q->len;
+        }
+      }
+      if (q != p) {
+        struct mqtt_nocopy_t *nc = &client->nocopy[(client->nocopy_get + client->nocopy_len) % MQTT_NOCOPY_MAX_IN_FLIGHT];
+        pbuf_ref(p);
+        nc->p = p;
+        nc->tx_end = client->tx_written;
+        client->nocopy_len++;
+      }
+    }
+    if (q != NULL) {
+      /* Out of memory half way, copy what is left */
+      u16_t rest = 0;
+      const struct pbuf *iter;
+      for (iter = q; iter != NULL; iter = iter->next) {
+        rest = (u16_t)(rest + iter->len);
+      }
+      if (rest >= mqtt_ringbuf_free(&client->output)) {
+        LWIP_DEBUGF(MQTT_DEBUG_WARN, ("mqtt_publish_pbuf: Out of memory within message, disconnecting\n"));
+        mqtt_delete_request(client, r);
+        mqtt_close(client, MQTT_CONNECT_DISCONNECTED);
+        return ERR_CONN;
+      }
+      mqtt_output_append_pbuf(&client->output, q);
+    }
+  } else {
+    if (mqtt_output_check_space(&client->output, remaining_length) == 0) {
+      mqtt_delete_request(client, r);
+      return ERR_MEM;
+    }
+    mqtt_output_append_publish_header(&client->output, topic, topic_len, qos, retain,
+                                      (r != NULL) ? r->pkt_id : 0, remaining_length);
+    mqtt_output_append_pbuf(&client->output, p);
   }
 
-  mqtt_append_request(&client->pend_req_queue, r);
-  mqtt_output_send(&client->output, client->conn);
+  if (r != NULL) {
+    r->tx_end = client->tx_written + mqtt_ringbuf_len(&client->output);
+    mqtt_append_request(client, (qos > 0) ? &client->pend_req_queue : &client->pend_qos0_queue, r);
+  }
+  mqtt_output_send(client);
+  if (!client->batch) {
+    altcp_output(client->conn);
+  }
   return ERR_OK;
 }
 
+/**
+ * @ingroup mqtt
+ * Start a batch of messages: until mqtt_batch_end(), messages are queued to TCP
+ * without being sent, so that several small publishes share a TCP segment.
+ * @param client MQTT client
+ */
+void
+mqtt_batch_begin(mqtt_client_t *client)
+{
+  LWIP_ASSERT_CORE_LOCKED();
+  LWIP_ASSERT("mqtt_batch_begin: client != NULL", client != NULL);
+  client->batch = 1;
+}
+
+/**
+ * @ingroup mqtt
+ * End a batch of messages started with mqtt_batch_begin() and send them.
+ * @param client MQTT client
+ */
+void
+mqtt_batch_end(mqtt_client_t *client)
+{
+  LWIP_ASSERT_CORE_LOCKED();
+  LWIP_ASSERT("mqtt_batch_end: client != NULL", client != NULL);
+  client->batch = 0;
+  if ((client->conn_state != TCP_DISCONNECTED) && (client->conn != NULL)) {
+    mqtt_output_send(client);
+    altcp_output(client->conn);
+  }
+}
+
 
 /**
  * @ingroup mqtt
@@ -1204,14 +1483,14 @@ mqtt_sub_unsub(mqtt_client_t *client, const char *topic, u8_t qos, mqtt_request_
     return ERR_CONN;
   }
 
-  pkt_id = msg_generate_packet_id(client);
-  r = mqtt_create_request(client->req_list, LWIP_ARRAYSIZE(client->req_list), pkt_id, cb, arg);
+  r = mqtt_create_request(client, 1, cb, arg);
   if (r == NULL) {
     return ERR_MEM;
   }
+  pkt_id = r->pkt_id;
 
   if (mqtt_output_check_space(&client->output, remaining_length) == 0) {
-    mqtt_delete_request(r);
+    mqtt_delete_request(client, r);
     return ERR_MEM;
   }
 
@@ -1227,8 +1506,9 @@ mqtt_sub_unsub(mqtt_client_t *client, const char *topic, u8_t qos, mqtt_request_
     mqtt_output_append_u8(&client->output, LWIP_MIN(qos, 2));
   }
 
-  mqtt_append_request(&client->pend_req_queue, r);
-  mqtt_output_send(&client->output, client->conn);
+  r->tx_end = client->tx_written + mqtt_ringbuf_len(&client->output);
+  mqtt_append_request(client, &client->pend_req_queue, r);
+  mqtt_output_send(client);
   return ERR_OK;
 }
 
@@ -1324,7 +1604,7 @@ mqtt_client_connect(mqtt_client_t *client, const ip_addr_t *ip_addr, u16_t port,
   client->connect_arg = arg;
   client->connect_cb = cb;
   client->keep_alive = client_info->keep_alive;
-  mqtt_init_requests(client->req_list, LWIP_ARRAYSIZE(client->req_list));
+  mqtt_init_requests(client);
 
   /* Build connect message */
   if (client_info->will_topic != NULL && client_info->will_msg != NULL) {
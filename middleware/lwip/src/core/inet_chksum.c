@@ -10,7 +10,7 @@
  * \#define LWIP_CHKSUM your_checksum_routine
  *
  * Or you can select from the implementations below by defining
- * LWIP_CHKSUM_ALGORITHM to 1, 2 or 3.
+ * LWIP_CHKSUM_ALGORITHM to 1, 2, 3 or 4.
  */
 
 /*
@@ -255,6 +255,99 @@ lwip_standard_chksum(const void *dataptr, int len)
 }
 #endif
 
+#if (LWIP_CHKSUM_ALGORITHM == 4) || (LWIP_CHKSUM_COPY_ALGORITHM == 2)
+#if !LWIP_HAVE_INT64
+#error "LWIP_CHKSUM_ALGORITHM 4 and LWIP_CHKSUM_COPY_ALGORITHM 2 need 64-bit integers"
+#endif
+
+/** Fold a 64-bit one's complement sum to 16 bits */
+static u32_t
+lwip_chksum_fold64(u64_t sum)
+{
+  u32_t sum32;
+
+  sum = (sum >> 32) + (sum & 0xffffffffUL);
+  sum = (sum >> 32) + (sum & 0xffffffffUL);
+  sum32 = (u32_t)sum;
+  sum32 = FOLD_U32T(sum32);
+  sum32 = FOLD_U32T(sum32);
+  return sum32;
+}
+#endif
+
+#if (LWIP_CHKSUM_ALGORITHM == 4) /* Alternative version #4 */
+/**
+ * Word-at-a-time checksum with a 64-bit accumulator. The inner loop adds
+ * 32 bytes per iteration as 32-bit words without any carry handling: the
+ * carries collect in the upper half of the accumulator and are folded back
+ * once at the end. Head and tail bytes are treated like in version #3.
+ *
+ * @param dataptr points to start of data to be summed at any boundary
+ * @param len length of data to be summed
+ * @return host order (!) lwip checksum (non-inverted Internet sum)
+ */
+u16_t
+lwip_standard_chksum(const void *dataptr, int len)
+{
+  const u8_t *pb = (const u8_t *)dataptr;
+  const u32_t *pl;
+  u64_t sum = 0;
+  u32_t sum32;
+  u16_t t = 0;
+  /* starts at odd byte address? */
+  int odd = ((mem_ptr_t)pb & 1);
+
+  if (odd && len > 0) {
+    ((u8_t *)&t)[1] = *pb++;
+    len--;
+  }
+
+  /* align to u32_t */
+  if (((mem_ptr_t)pb & 2) && len > 1) {
+    sum += *(const u16_t *)(const void *)pb;
+    pb += 2;
+    len -= 2;
+  }
+
+  pl = (const u32_t *)(const void *)pb;
+
+  while (len >= 32) {
+    sum += (u64_t)pl[0] + pl[1] + pl[2] + pl[3];
+    sum += (u64_t)pl[4] + pl[5] + pl[6] + pl[7];
+    pl += 8;
+    len -= 32;
+  }
+
+  while (len >= 4) {
+    sum += *pl++;
+    len -= 4;
+  }
+
+  pb = (const u8_t *)pl;
+
+  /* 16-bit aligned word remaining? */
+  if (len > 1) {
+    sum += *(const u16_t *)(const void *)pb;
+    pb += 2;
+    len -= 2;
+  }
+
+  /* dangling tail byte remaining? */
+  if (len > 0) {
+    ((u8_t *)&t)[0] = *pb;
+  }
+
+  sum += t;
+  sum32 = lwip_chksum_fold64(sum);
+
+  if (odd) {
+    sum32 = SWAP_BYTES_IN_WORD(sum32);
+  }
+
+  return (u16_t)sum32;
+}
+#endif
+
 /** Parts of the pseudo checksum which are common to IPv4 and IPv6 */
 static u16_t
 inet_cksum_pseudo_base(struct pbuf *p, u8_t proto, u16_t proto_len, u32_t acc)
@@ -606,3 +699,61 @@ lwip_chksum_copy(void *dst, const void *src, u16_t len)
   return LWIP_CHKSUM(dst, len);
 }
 #endif /* (LWIP_CHKSUM_COPY_ALGORITHM == 1) */
+
+#if (LWIP_CHKSUM_COPY_ALGORITHM == 2) /* Version #2 */
+/* A 4-byte SMEMCPY is a single load/store on cores with unaligned access. */
+#define LWIP_CHKSUM_COPY_WORD(d, s, w) do { \
+  SMEMCPY(&(w), (s), 4); \
+  SMEMCPY((d), &(w), 4); \
+  (s) += 4; \
+  (d) += 4; \
+} while (0)
+
+/** Fused copy and checksum: every word is added to a 64-bit accumulator
+ * while it is in a register, so the data is read only once. Source and
+ * destination may have any (and different) alignment. The words are summed
+ * relative to the start of the buffer, so no byte swap is needed.
+ */
+u16_t
+lwip_chksum_copy(void *dst, const void *src, u16_t len)
+{
+  u8_t *d = (u8_t *)dst;
+  const u8_t *s = (const u8_t *)src;
+  u64_t sum = 0;
+  u32_t w0, w1, w2, w3;
+  u16_t t;
+
+  while (len >= 16) {
+    LWIP_CHKSUM_COPY_WORD(d, s, w0);
+    LWIP_CHKSUM_COPY_WORD(d, s, w1);
+    LWIP_CHKSUM_COPY_WORD(d, s, w2);
+    LWIP_CHKSUM_COPY_WORD(d, s, w3);
+    sum += (u64_t)w0 + w1 + w2 + w3;
+    len -= 16;
+  }
+
+  while (len >= 4) {
+    LWIP_CHKSUM_COPY_WORD(d, s, w0);
+    sum += w0;
+    len -= 4;
+  }
+
+  if (len > 1) {
+    SMEMCPY(&t, s, 2);
+    SMEMCPY(d, &t, 2);
+    sum += t;
+    s += 2;
+    d += 2;
+    len -= 2;
+  }
+
+  if (len > 0) {
+    *d = *s;
+    t = 0;
+    ((u8_t *)&t)[0] = *s;
+    sum += t;
+  }
+
+  return (u16_t)lwip_chksum_fold64(sum);
+}
+#endif /* (LWIP_CHKSUM_COPY_ALGORITHM == 2) */
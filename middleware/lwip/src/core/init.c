@@ -164,6 +164,12 @@ PACK_STRUCT_END
 #if (LWIP_TCP && TCP_LISTEN_BACKLOG && ((TCP_DEFAULT_LISTEN_BACKLOG < 0) || (TCP_DEFAULT_LISTEN_BACKLOG > 0xff)))
 #error "If you want to use TCP backlog, TCP_DEFAULT_LISTEN_BACKLOG must fit into an u8_t"
 #endif
+#if (LWIP_TCP && (TCP_PCB_HASH_SIZE & (TCP_PCB_HASH_SIZE - 1)))
+#error "TCP_PCB_HASH_SIZE must be 0 or a power of 2"
+#endif
+#if (LWIP_ARP && (ETHARP_TABLE_HASH_SIZE & (ETHARP_TABLE_HASH_SIZE - 1)))
+#error "ETHARP_TABLE_HASH_SIZE must be 0 or a power of 2"
+#endif
 #if (LWIP_TCP && LWIP_TCP_SACK_OUT && !TCP_QUEUE_OOSEQ)
 #error "To use LWIP_TCP_SACK_OUT, TCP_QUEUE_OOSEQ needs to be enabled"
 #endif
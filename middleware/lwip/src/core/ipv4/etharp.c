@@ -105,6 +105,15 @@ struct etharp_entry {
 
 static struct etharp_entry arp_table[ARP_TABLE_SIZE];
 
+#if ETHARP_TABLE_HASH_SIZE
+/** Heads of the IP address hash chains, as arp_table index + 1 (0: empty chain) */
+static u16_t arp_hash_head[ETHARP_TABLE_HASH_SIZE];
+/** Next entry in the same chain, as arp_table index + 1 (0: end of chain) */
+static u16_t arp_hash_next[ARP_TABLE_SIZE];
+/** Non-zero if the entry is linked into the chain of its IP address */
+static u8_t arp_hash_linked[ARP_TABLE_SIZE];
+#endif /* ETHARP_TABLE_HASH_SIZE */
+
 #if !LWIP_NETIF_HWADDRHINT
 static netif_addr_idx_t etharp_cached_entry;
 #endif /* !LWIP_NETIF_HWADDRHINT */
@@ -164,6 +173,68 @@ free_etharp_q(struct etharp_q_entry *q)
 
 #endif /* ARP_QUEUEING */
 
+#if ETHARP_TABLE_HASH_SIZE
+static u16_t
+etharp_hash(const ip4_addr_t *ipaddr)
+{
+  u32_t h = ip4_addr_get_u32(ipaddr) * 0x9E3779B1UL;
+  return (u16_t)((h ^ (h >> 16)) & (ETHARP_TABLE_HASH_SIZE - 1));
+}
+
+/** Remove an entry from its hash chain (no-op if not linked) */
+static void
+etharp_hash_unlink(int i)
+{
+  u16_t *link;
+
+  if (!arp_hash_linked[i]) {
+    return;
+  }
+  link = &arp_hash_head[etharp_hash(&arp_table[i].ipaddr)];
+  while (*link != i + 1) {
+    LWIP_ASSERT("etharp_hash_unlink: entry not in its chain", *link != 0);
+    link = &arp_hash_next[*link - 1];
+  }
+  *link = arp_hash_next[i];
+  arp_hash_next[i] = 0;
+  arp_hash_linked[i] = 0;
+}
+
+/** Link an entry into the chain of its (just set) IP address */
+static void
+etharp_hash_link(int i)
+{
+  u16_t *head = &arp_hash_head[etharp_hash(&arp_table[i].ipaddr)];
+
+  LWIP_ASSERT("etharp_hash_link: entry already linked", !arp_hash_linked[i]);
+  arp_hash_next[i] = *head;
+  *head = (u16_t)(i + 1);
+  arp_hash_linked[i] = 1;
+}
+
+/** Search the hash chain of an IP address for a used entry */
+static s16_t
+etharp_hash_find(const ip4_addr_t *ipaddr, struct netif *netif)
+{
+  u16_t n;
+
+  LWIP_UNUSED_ARG(netif);
+
+  for (n = arp_hash_head[etharp_hash(ipaddr)]; n != 0; n = arp_hash_next[n - 1]) {
+    s16_t i = (s16_t)(n - 1);
+    if ((arp_table[i].state != ETHARP_STATE_EMPTY) &&
+        ip4_addr_eq(ipaddr, &arp_table[i].ipaddr)
+#if ETHARP_TABLE_MATCH_NETIF
+        && ((netif == NULL) || (netif == arp_table[i].netif))
+#endif /* ETHARP_TABLE_MATCH_NETIF */
+       ) {
+      return i;
+    }
+  }
+  return -1;
+}
+#endif /* ETHARP_TABLE_HASH_SIZE */
+
 /** Clean up ARP table entries */
 static void
 etharp_free_entry(int i)
@@ -177,6 +248,9 @@ etharp_free_entry(int i)
     free_etharp_q(arp_table[i].q);
     arp_table[i].q = NULL;
   }
+#if ETHARP_TABLE_HASH_SIZE
+  etharp_hash_unlink(i);
+#endif /* ETHARP_TABLE_HASH_SIZE */
   /* recycle entry for re-use */
   arp_table[i].state = ETHARP_STATE_EMPTY;
 #ifdef LWIP_DEBUG
@@ -263,9 +337,27 @@ etharp_find_entry(const ip4_addr_t *ipaddr, u8_t flags, struct netif *netif)
   s16_t old_queue = ARP_TABLE_SIZE;
   /* its age */
   u16_t age_queue = 0, age_pending = 0, age_stable = 0;
+  /* address to match in the sweep below */
+  const ip4_addr_t *match = ipaddr;
 
   LWIP_UNUSED_ARG(netif);
 
+#if ETHARP_TABLE_HASH_SIZE
+  if (ipaddr != NULL) {
+    i = etharp_hash_find(ipaddr, netif);
+    if (i >= 0) {
+      LWIP_DEBUGF(ETHARP_DEBUG | LWIP_DBG_TRACE, ("etharp_find_entry: found matching entry %d\n", (int)i));
+      return i;
+    }
+    if ((flags & ETHARP_FLAG_FIND_ONLY) != 0) {
+      LWIP_DEBUGF(ETHARP_DEBUG | LWIP_DBG_TRACE, ("etharp_find_entry: no matching entry found\n"));
+      return (s16_t)ERR_MEM;
+    }
+    /* not cached: the sweep only has to choose an entry to (re)use */
+    match = NULL;
+  }
+#endif /* ETHARP_TABLE_HASH_SIZE */
+
   /**
    * a) do a search through the cache, remember candidates
    * b) select candidate entry
@@ -292,7 +384,7 @@ etharp_find_entry(const ip4_addr_t *ipaddr, u8_t flags, struct netif *netif)
       LWIP_ASSERT("state == ETHARP_STATE_PENDING || state >= ETHARP_STATE_STABLE",
                   state == ETHARP_STATE_PENDING || state >= ETHARP_STATE_STABLE);
       /* if given, does IP address match IP address in ARP entry? */
-      if (ipaddr && ip4_addr_eq(ipaddr, &arp_table[i].ipaddr)
+      if (match && ip4_addr_eq(match, &arp_table[i].ipaddr)
 #if ETHARP_TABLE_MATCH_NETIF
           && ((netif == NULL) || (netif == arp_table[i].netif))
 #endif /* ETHARP_TABLE_MATCH_NETIF */
@@ -392,7 +484,14 @@ etharp_find_entry(const ip4_addr_t *ipaddr, u8_t flags, struct netif *netif)
   /* IP address given? */
   if (ipaddr != NULL) {
     /* set IP address */
+#if ETHARP_TABLE_HASH_SIZE
+    /* an empty entry may still be linked if its last user never filled it in */
+    etharp_hash_unlink(i);
+    ip4_addr_copy(arp_table[i].ipaddr, *ipaddr);
+    etharp_hash_link(i);
+#else /* ETHARP_TABLE_HASH_SIZE */
     ip4_addr_copy(arp_table[i].ipaddr, *ipaddr);
+#endif /* ETHARP_TABLE_HASH_SIZE */
   }
   arp_table[i].ctime = 0;
 #if ETHARP_TABLE_MATCH_NETIF
@@ -57,7 +57,8 @@
  * - IP header options are not supported
  * - fragments must not overlap (e.g. due to different routes),
  *   currently, overlapping or duplicate fragments are thrown away
- *   if IP_REASS_CHECK_OVERLAP=1 (the default)!
+ *   if IP_REASS_CHECK_OVERLAP=1 (the default) and, regardless of it,
+ *   once a datagram has been made contiguous (IP_REASS_CONTIGUOUS)!
  *
  * @todo: work with IP header options
  */
@@ -78,6 +79,14 @@
 #endif /* IP_REASS_FREE_OLDEST */
 
 #define IP_REASS_FLAG_LASTFRAG 0x01
+#if IP_REASS_CONTIGUOUS
+#define IP_REASS_FLAG_CONTIGUOUS 0x02
+
+/** A contiguous datagram is kept as IP header and payload, followed by a bitmap
+ * of the payload received so far (one bit per 8 byte unit of fragment offset) */
+#define IP_REASS_MAP_OFFSET(datagram_len) LWIP_MEM_ALIGN_SIZE(IP_HLEN + (u32_t)(datagram_len))
+#define IP_REASS_MAP_SIZE(datagram_len)   (((((u32_t)(datagram_len) + 7) / 8) + 7) / 8)
+#endif /* IP_REASS_CONTIGUOUS */
 
 #define IP_REASS_VALIDATE_TELEGRAM_FINISHED  1
 #define IP_REASS_VALIDATE_PBUF_QUEUED        0
@@ -118,6 +127,50 @@ static u16_t ip_reass_pbufcount;
 static void ip_reass_dequeue_datagram(struct ip_reassdata *ipr, struct ip_reassdata *prev);
 static int ip_reass_free_complete_datagram(struct ip_reassdata *ipr, struct ip_reassdata *prev);
 
+#if IP_REASS_CONTIGUOUS
+/** Check if any part of the payload range [start, end) has been received already */
+static int
+ip_reass_map_test(const u8_t *map, u16_t start, u16_t end)
+{
+  u32_t unit = start / 8;
+  u32_t last = ((u32_t)end + 7) / 8;
+
+  while (unit < last) {
+    if (((unit & 7) == 0) && ((last - unit) >= 8)) {
+      /* 8 units at once */
+      if (map[unit / 8] != 0) {
+        return 1;
+      }
+      unit += 8;
+    } else {
+      if ((map[unit / 8] & (1 << (unit & 7))) != 0) {
+        return 1;
+      }
+      unit++;
+    }
+  }
+  return 0;
+}
+
+/** Mark the payload range [start, end) as received */
+static void
+ip_reass_map_set(u8_t *map, u16_t start, u16_t end)
+{
+  u32_t unit = start / 8;
+  u32_t last = ((u32_t)end + 7) / 8;
+
+  while (unit < last) {
+    if (((unit & 7) == 0) && ((last - unit) >= 8)) {
+      map[unit / 8] = 0xff;
+      unit += 8;
+    } else {
+      map[unit / 8] = (u8_t)(map[unit / 8] | (1 << (unit & 7)));
+      unit++;
+    }
+  }
+}
+#endif /* IP_REASS_CONTIGUOUS */
+
 /**
  * Reassembly timer base function
  * for both NO_SYS == 0 and 1 (!).
@@ -174,6 +227,26 @@ ip_reass_free_complete_datagram(struct ip_reassdata *ipr, struct ip_reassdata *p
   }
 
   MIB2_STATS_INC(mib2.ipreasmfails);
+#if IP_REASS_CONTIGUOUS
+  if ((ipr->flags & IP_REASS_FLAG_CONTIGUOUS) != 0) {
+    /* a single buffer holds all fragments received so far */
+    p = ipr->p;
+#if LWIP_ICMP
+    if ((*((u8_t *)p->payload + IP_REASS_MAP_OFFSET(ipr->datagram_len)) & 1) != 0) {
+      /* The first fragment was received, send ICMP time exceeded. */
+      SMEMCPY(p->payload, &ipr->iphdr, IP_HLEN);
+      icmp_time_exceeded(p, ICMP_TE_FRAG);
+    }
+#endif /* LWIP_ICMP */
+    pbufs_freed = pbuf_clen(p);
+    pbuf_free(p);
+    ip_reass_dequeue_datagram(ipr, prev);
+    LWIP_ASSERT("ip_reass_pbufcount >= pbufs_freed", ip_reass_pbufcount >= pbufs_freed);
+    ip_reass_pbufcount = (u16_t)(ip_reass_pbufcount - pbufs_freed);
+    return pbufs_freed;
+  }
+#endif /* IP_REASS_CONTIGUOUS */
+
 #if LWIP_ICMP
   iprh = (struct ip_reass_helper *)ipr->p->payload;
   if (iprh->start == 0) {
@@ -330,11 +403,40 @@ ip_reass_dequeue_datagram(struct ip_reassdata *ipr, struct ip_reassdata *prev)
   memp_free(MEMP_REASSDATA, ipr);
 }
 
+#if !IP_REASS_CHECK_OVERLAP
+/**
+ * Check that the fragments of a datagram follow each other without holes.
+ * Only needed if overlapping fragments are queued, otherwise the number of
+ * bytes received tells if all of them are there.
+ * @param ipr points to the reassembly state
+ * @param datagram_len total payload length of the datagram
+ * @return 1 if the fragments cover the datagram, 0 if some are missing
+ */
+static int
+ip_reass_chain_is_complete(struct ip_reassdata *ipr, u16_t datagram_len)
+{
+  struct ip_reass_helper *iprh;
+  struct pbuf *q;
+  u16_t end = 0;
+
+  for (q = ipr->p; q != NULL; q = iprh->next_pbuf) {
+    iprh = (struct ip_reass_helper *)q->payload;
+    if (iprh->start != end) {
+      /* There is a fragment missing (or overlapping) before this one */
+      return 0;
+    }
+    end = iprh->end;
+  }
+  return end == datagram_len;
+}
+#endif /* !IP_REASS_CHECK_OVERLAP */
+
 /**
  * Chain a new pbuf into the pbuf list that composes the datagram.  The pbuf list
  * will grow over time as  new pbufs are rx.
- * Also checks that the datagram passes basic continuity checks (if the last
- * fragment was received at least once).
+ * Fragments arriving in order are appended to the last one without walking the
+ * list. The datagram is complete once the last fragment was received and the
+ * fragments add up to its length.
  * @param ipr points to the reassembly state
  * @param new_p points to the pbuf for the current fragment
  * @param is_last is 1 if this pbuf has MF==0 (ipr->flags not updated yet)
@@ -345,10 +447,9 @@ ip_reass_chain_frag_into_datagram_and_validate(struct ip_reassdata *ipr, struct
 {
   struct ip_reass_helper *iprh, *iprh_tmp, *iprh_prev = NULL;
   struct pbuf *q;
-  u16_t offset, len;
+  u16_t offset, len, datagram_len;
   u8_t hlen;
   struct ip_hdr *fraghdr;
-  int valid = 1;
 
   /* Extract length and fragment offset from current fragment */
   fraghdr = (struct ip_hdr *)new_p->payload;
@@ -375,124 +476,229 @@ ip_reass_chain_frag_into_datagram_and_validate(struct ip_reassdata *ipr, struct
     return IP_REASS_VALIDATE_PBUF_DROPPED;
   }
 
-  /* Iterate through until we either get to the end of the list (append),
-   * or we find one with a larger offset (insert). */
-  for (q = ipr->p; q != NULL;) {
-    iprh_tmp = (struct ip_reass_helper *)q->payload;
-    if (iprh->start < iprh_tmp->start) {
-      /* the new pbuf should be inserted before this */
-      iprh->next_pbuf = q;
-      if (iprh_prev != NULL) {
-        /* not the fragment with the lowest offset */
+  /* The last fragment fixes the datagram length: no fragment may end behind it */
+  iprh_tmp = (ipr->p_last != NULL) ? (struct ip_reass_helper *)ipr->p_last->payload : NULL;
+  if (is_last) {
+    if (((ipr->flags & IP_REASS_FLAG_LASTFRAG) != 0) && (iprh->end != ipr->datagram_len)) {
+      /* another last fragment with a different length */
+      return IP_REASS_VALIDATE_PBUF_DROPPED;
+    }
+    if ((iprh_tmp != NULL) && (iprh_tmp->end > iprh->end)) {
+      /* fragments beyond the end of the datagram were received */
+      return IP_REASS_VALIDATE_PBUF_DROPPED;
+    }
+    datagram_len = iprh->end;
+  } else if ((ipr->flags & IP_REASS_FLAG_LASTFRAG) != 0) {
+    if (iprh->end > ipr->datagram_len) {
+      /* fragment beyond the end of the datagram */
+      return IP_REASS_VALIDATE_PBUF_DROPPED;
+    }
+    datagram_len = ipr->datagram_len;
+  } else {
+    datagram_len = 0;
+  }
+
+  if (iprh_tmp == NULL) {
+    LWIP_ASSERT("no last fragment, this must be the first fragment!",
+                ipr->p == NULL);
+    /* this is the first fragment we ever received for this ip datagram */
+    ipr->p = new_p;
+    ipr->p_last = new_p;
+  } else if ((iprh->start > iprh_tmp->start) && (iprh->start >= iprh_tmp->end)) {
+    /* this is (for now), the fragment with the highest offset:
+     * chain it to the last fragment */
+    iprh_tmp->next_pbuf = new_p;
+    ipr->p_last = new_p;
+  } else {
+    /* Iterate through until we either get to the end of the list (append),
+     * or we find one with a larger offset (insert). */
+    for (q = ipr->p; q != NULL;) {
+      iprh_tmp = (struct ip_reass_helper *)q->payload;
+      if (iprh->start < iprh_tmp->start) {
+        /* the new pbuf should be inserted before this */
+        iprh->next_pbuf = q;
+        if (iprh_prev != NULL) {
+          /* not the fragment with the lowest offset */
 #if IP_REASS_CHECK_OVERLAP
-        if ((iprh->start < iprh_prev->end) || (iprh->end > iprh_tmp->start)) {
-          /* fragment overlaps with previous or following, throw away */
-          return IP_REASS_VALIDATE_PBUF_DROPPED;
-        }
+          if ((iprh->start < iprh_prev->end) || (iprh->end > iprh_tmp->start)) {
+            /* fragment overlaps with previous or following, throw away */
+            return IP_REASS_VALIDATE_PBUF_DROPPED;
+          }
 #endif /* IP_REASS_CHECK_OVERLAP */
-        iprh_prev->next_pbuf = new_p;
-        if (iprh_prev->end != iprh->start) {
-          /* There is a fragment missing between the current
-           * and the previous fragment */
-          valid = 0;
-        }
-      } else {
+          iprh_prev->next_pbuf = new_p;
+        } else {
 #if IP_REASS_CHECK_OVERLAP
-        if (iprh->end > iprh_tmp->start) {
-          /* fragment overlaps with following, throw away */
-          return IP_REASS_VALIDATE_PBUF_DROPPED;
-        }
+          if (iprh->end > iprh_tmp->start) {
+            /* fragment overlaps with following, throw away */
+            return IP_REASS_VALIDATE_PBUF_DROPPED;
+          }
 #endif /* IP_REASS_CHECK_OVERLAP */
-        /* fragment with the lowest offset */
-        ipr->p = new_p;
-      }
-      break;
-    } else if (iprh->start == iprh_tmp->start) {
-      /* received the same datagram twice: no need to keep the datagram */
-      return IP_REASS_VALIDATE_PBUF_DROPPED;
+          /* fragment with the lowest offset */
+          ipr->p = new_p;
+        }
+        break;
+      } else if (iprh->start == iprh_tmp->start) {
+        /* received the same datagram twice: no need to keep the datagram */
+        return IP_REASS_VALIDATE_PBUF_DROPPED;
 #if IP_REASS_CHECK_OVERLAP
-    } else if (iprh->start < iprh_tmp->end) {
-      /* overlap: no need to keep the new datagram */
-      return IP_REASS_VALIDATE_PBUF_DROPPED;
+      } else if (iprh->start < iprh_tmp->end) {
+        /* overlap: no need to keep the new datagram */
+        return IP_REASS_VALIDATE_PBUF_DROPPED;
 #endif /* IP_REASS_CHECK_OVERLAP */
-    } else {
-      /* Check if the fragments received so far have no holes. */
-      if (iprh_prev != NULL) {
-        if (iprh_prev->end != iprh_tmp->start) {
-          /* There is a fragment missing between the current
-           * and the previous fragment */
-          valid = 0;
-        }
       }
+      q = iprh_tmp->next_pbuf;
+      iprh_prev = iprh_tmp;
     }
-    q = iprh_tmp->next_pbuf;
-    iprh_prev = iprh_tmp;
-  }
 
-  /* If q is NULL, then we made it to the end of the list. Determine what to do now */
-  if (q == NULL) {
-    if (iprh_prev != NULL) {
-      /* this is (for now), the fragment with the highest offset:
-       * chain it to the last fragment */
-#if IP_REASS_CHECK_OVERLAP
-      LWIP_ASSERT("check fragments don't overlap", iprh_prev->end <= iprh->start);
-#endif /* IP_REASS_CHECK_OVERLAP */
+    /* If q is NULL, then we made it to the end of the list: the new fragment
+     * overlaps the last one (only queued without IP_REASS_CHECK_OVERLAP) */
+    if (q == NULL) {
+      LWIP_ASSERT("sanity check", iprh_prev != NULL);
       iprh_prev->next_pbuf = new_p;
-      if (iprh_prev->end != iprh->start) {
-        valid = 0;
-      }
-    } else {
-#if IP_REASS_CHECK_OVERLAP
-      LWIP_ASSERT("no previous fragment, this must be the first fragment!",
-                  ipr->p == NULL);
-#endif /* IP_REASS_CHECK_OVERLAP */
-      /* this is the first fragment we ever received for this ip datagram */
-      ipr->p = new_p;
+      ipr->p_last = new_p;
     }
   }
+  ipr->recvd_len += len;
 
   /* At this point, the validation part begins: */
   /* If we already received the last fragment */
   if (is_last || ((ipr->flags & IP_REASS_FLAG_LASTFRAG) != 0)) {
-    /* and had no holes so far */
-    if (valid) {
-      /* then check if the rest of the fragments is here */
-      /* Check if the queue starts with the first datagram */
-      if ((ipr->p == NULL) || (((struct ip_reass_helper *)ipr->p->payload)->start != 0)) {
-        valid = 0;
-      } else {
-        /* and check that there are no holes after this datagram */
-        iprh_prev = iprh;
-        q = iprh->next_pbuf;
-        while (q != NULL) {
-          iprh = (struct ip_reass_helper *)q->payload;
-          if (iprh_prev->end != iprh->start) {
-            valid = 0;
-            break;
-          }
-          iprh_prev = iprh;
-          q = iprh->next_pbuf;
-        }
-        /* if still valid, all fragments are received
-         * (because to the MF==0 already arrived */
-        if (valid) {
-          LWIP_ASSERT("sanity check", ipr->p != NULL);
-          LWIP_ASSERT("sanity check",
-                      ((struct ip_reass_helper *)ipr->p->payload) != iprh);
-          LWIP_ASSERT("validate_datagram:next_pbuf!=NULL",
-                      iprh->next_pbuf == NULL);
-        }
-      }
+    /* Queued fragments neither overlap nor end behind the last one, so all
+     * of them are there once their lengths add up to the datagram length. */
+    if ((ipr->recvd_len >= datagram_len)
+#if !IP_REASS_CHECK_OVERLAP
+        && ip_reass_chain_is_complete(ipr, datagram_len)
+#endif /* !IP_REASS_CHECK_OVERLAP */
+       ) {
+      LWIP_ASSERT("sanity check",
+                  ((struct ip_reass_helper *)ipr->p->payload)->start == 0);
+      LWIP_ASSERT("validate_datagram:next_pbuf!=NULL",
+                  ((struct ip_reass_helper *)ipr->p_last->payload)->next_pbuf == NULL);
+      return IP_REASS_VALIDATE_TELEGRAM_FINISHED;
     }
-    /* If valid is 0 here, there are some fragments missing in the middle
-     * (since MF == 0 has already arrived). Such datagrams simply time out if
-     * no more fragments are received... */
-    return valid ? IP_REASS_VALIDATE_TELEGRAM_FINISHED : IP_REASS_VALIDATE_PBUF_QUEUED;
+    /* Some fragments are missing (since MF == 0 has already arrived). Such
+     * datagrams simply time out if no more fragments are received... */
   }
   /* If we come here, not all fragments were received, yet! */
   return IP_REASS_VALIDATE_PBUF_QUEUED; /* not yet valid! */
 }
 
+#if IP_REASS_CONTIGUOUS
+/**
+ * Move the fragments of a datagram into a single buffer once its length is
+ * known. The datagram stays chained if the buffer is larger than
+ * IP_REASS_CONTIGUOUS_MAX or cannot be allocated.
+ * Overlapping fragments (only queued without IP_REASS_CHECK_OVERLAP) are
+ * dropped.
+ * @param ipr points to the reassembly state (IP_REASS_FLAG_LASTFRAG set)
+ */
+static void
+ip_reass_make_contiguous(struct ip_reassdata *ipr)
+{
+  struct ip_reass_helper *iprh;
+  struct pbuf *buf, *q;
+  u32_t map_offset = IP_REASS_MAP_OFFSET(ipr->datagram_len);
+  u32_t buf_len = map_offset + IP_REASS_MAP_SIZE(ipr->datagram_len);
+  u16_t clen;
+  u8_t *map;
+
+  if ((buf_len > 0xFFFF) || (buf_len > IP_REASS_CONTIGUOUS_MAX)) {
+    /* no room for the bitmap behind this datagram, or it would take too
+       much of the heap: keep it chained */
+    return;
+  }
+  /* reserve room for the link header, the datagram might be sent back (ICMP) */
+  buf = pbuf_alloc(PBUF_LINK, (u16_t)buf_len, PBUF_RAM);
+  if (buf == NULL) {
+    LWIP_DEBUGF(IP_REASS_DEBUG, ("ip_reass_make_contiguous: no memory for %"U16_F" bytes, chaining\n",
+                                 ipr->datagram_len));
+    return;
+  }
+  map = (u8_t *)buf->payload + map_offset;
+  memset(map, 0, IP_REASS_MAP_SIZE(ipr->datagram_len));
+
+  ipr->recvd_len = 0;
+  q = ipr->p;
+  while (q != NULL) {
+    struct pbuf *pcur = q;
+    iprh = (struct ip_reass_helper *)q->payload;
+    q = iprh->next_pbuf;
+    if ((iprh->end <= ipr->datagram_len) && !ip_reass_map_test(map, iprh->start, iprh->end)) {
+      u16_t len = (u16_t)(iprh->end - iprh->start);
+      if (pbuf_copy_partial(pcur, (u8_t *)buf->payload + IP_HLEN + iprh->start, len, IP_HLEN) == len) {
+        ip_reass_map_set(map, iprh->start, iprh->end);
+        ipr->recvd_len += len;
+      }
+    }
+    clen = pbuf_clen(pcur);
+    LWIP_ASSERT("ip_reass_pbufcount >= clen", ip_reass_pbufcount >= clen);
+    ip_reass_pbufcount = (u16_t)(ip_reass_pbufcount - clen);
+    pbuf_free(pcur);
+  }
+  ipr->p = buf;
+  ipr->p_last = NULL;
+  ipr->flags |= IP_REASS_FLAG_CONTIGUOUS;
+  ip_reass_pbufcount = (u16_t)(ip_reass_pbufcount + pbuf_clen(buf));
+}
+
+/**
+ * Copy a fragment into the buffer of a contiguous datagram. The fragment is
+ * not freed.
+ * @param ipr points to the reassembly state (IP_REASS_FLAG_CONTIGUOUS set)
+ * @param p points to the fragment, IP header included
+ * @param start fragment offset
+ * @param end fragment offset + length
+ * @param is_last is 1 if this pbuf has MF==0
+ * @return see IP_REASS_VALIDATE_* defines
+ */
+static int
+ip_reass_copy_frag_into_datagram(struct ip_reassdata *ipr, struct pbuf *p, u16_t start, u16_t end, int is_last)
+{
+  u8_t *map = (u8_t *)ipr->p->payload + IP_REASS_MAP_OFFSET(ipr->datagram_len);
+  u16_t len = (u16_t)(end - start);
+
+  if ((end > ipr->datagram_len) || (is_last && (end != ipr->datagram_len))) {
+    /* fragment beyond the end of the datagram or another last fragment */
+    return IP_REASS_VALIDATE_PBUF_DROPPED;
+  }
+  if (ip_reass_map_test(map, start, end)) {
+    /* duplicate or overlapping fragment */
+    return IP_REASS_VALIDATE_PBUF_DROPPED;
+  }
+  if (pbuf_copy_partial(p, (u8_t *)ipr->p->payload + IP_HLEN + start, len, IP_HLEN) != len) {
+    return IP_REASS_VALIDATE_PBUF_DROPPED;
+  }
+  ip_reass_map_set(map, start, end);
+  ipr->recvd_len += len;
+
+  return (ipr->recvd_len == ipr->datagram_len) ?
+         IP_REASS_VALIDATE_TELEGRAM_FINISHED : IP_REASS_VALIDATE_PBUF_QUEUED;
+}
+#endif /* IP_REASS_CONTIGUOUS */
+
+/**
+ * Restore the IP header of the first fragment in front of a reassembled
+ * datagram, with the length, offset and checksum of the whole datagram.
+ * @param ipr points to the reassembly state
+ * @param p first pbuf of the datagram
+ */
+static void
+ip_reass_set_datagram_header(struct ip_reassdata *ipr, struct pbuf *p)
+{
+  struct ip_hdr *iphdr = (struct ip_hdr *)p->payload;
+
+  SMEMCPY(iphdr, &ipr->iphdr, IP_HLEN);
+  IPH_LEN_SET(iphdr, lwip_htons((u16_t)(ipr->datagram_len + IP_HLEN)));
+  IPH_OFFSET_SET(iphdr, 0);
+  IPH_CHKSUM_SET(iphdr, 0);
+  /* @todo: do we need to set/calculate the correct checksum? */
+#if CHECKSUM_GEN_IP
+  IF__NETIF_CHECKSUM_ENABLED(ip_current_input_netif(), NETIF_CHECKSUM_GEN_IP) {
+    IPH_CHKSUM_SET(iphdr, inet_chksum(iphdr, IP_HLEN));
+  }
+#endif /* CHECKSUM_GEN_IP */
+}
+
 /**
  * Reassembles incoming IP fragments into an IP datagram.
  *
@@ -530,6 +736,13 @@ ip4_reass(struct pbuf *p)
     goto nullreturn;
   }
   len = (u16_t)(len - hlen);
+  if (((IPH_OFFSET(fraghdr) & PP_NTOHS(IP_MF)) != 0) && ((len & 7) != 0)) {
+    /* only the last fragment may end off an 8 byte boundary (RFC 791): the
+       datagram could never be completed */
+    LWIP_DEBUGF(IP_REASS_DEBUG, ("ip4_reass: fragment length %"U16_F" not a multiple of 8\n", len));
+    IPFRAG_STATS_INC(ip_frag.err);
+    goto nullreturn;
+  }
 
   /* Check if we are allowed to enqueue more datagrams. */
   clen = pbuf_clen(p);
@@ -593,59 +806,73 @@ ip4_reass(struct pbuf *p)
       goto nullreturn_ipr;
     }
   }
-  /* find the right place to insert this pbuf */
-  /* @todo: trim pbufs if fragments are overlapping */
-  valid = ip_reass_chain_frag_into_datagram_and_validate(ipr, p, is_last);
-  if (valid == IP_REASS_VALIDATE_PBUF_DROPPED) {
-    goto nullreturn_ipr;
-  }
-  /* if we come here, the pbuf has been enqueued */
-
-  /* Track the current number of pbufs current 'in-flight', in order to limit
-     the number of fragments that may be enqueued at any one time
-     (overflow checked by testing against IP_REASS_MAX_PBUFS) */
-  ip_reass_pbufcount = (u16_t)(ip_reass_pbufcount + clen);
-  if (is_last) {
-    u16_t datagram_len = (u16_t)(offset + len);
-    ipr->datagram_len = datagram_len;
-    ipr->flags |= IP_REASS_FLAG_LASTFRAG;
-    LWIP_DEBUGF(IP_REASS_DEBUG,
-                ("ip4_reass: last fragment seen, total len %"S16_F"\n",
-                 ipr->datagram_len));
+#if IP_REASS_CONTIGUOUS
+  if ((ipr->flags & IP_REASS_FLAG_CONTIGUOUS) != 0) {
+    valid = ip_reass_copy_frag_into_datagram(ipr, p, offset, (u16_t)(offset + len), is_last);
+    if (valid == IP_REASS_VALIDATE_PBUF_DROPPED) {
+      goto nullreturn_ipr;
+    }
+    /* the fragment has been copied, it is not enqueued */
+    pbuf_free(p);
+  } else
+#endif /* IP_REASS_CONTIGUOUS */
+  {
+    /* find the right place to insert this pbuf */
+    /* @todo: trim pbufs if fragments are overlapping */
+    valid = ip_reass_chain_frag_into_datagram_and_validate(ipr, p, is_last);
+    if (valid == IP_REASS_VALIDATE_PBUF_DROPPED) {
+      goto nullreturn_ipr;
+    }
+    /* if we come here, the pbuf has been enqueued */
+
+    /* Track the current number of pbufs current 'in-flight', in order to limit
+       the number of fragments that may be enqueued at any one time
+       (overflow checked by testing against IP_REASS_MAX_PBUFS) */
+    ip_reass_pbufcount = (u16_t)(ip_reass_pbufcount + clen);
+    if (is_last) {
+      u16_t datagram_len = (u16_t)(offset + len);
+      ipr->datagram_len = datagram_len;
+      ipr->flags |= IP_REASS_FLAG_LASTFRAG;
+      LWIP_DEBUGF(IP_REASS_DEBUG,
+                  ("ip4_reass: last fragment seen, total len %"S16_F"\n",
+                   ipr->datagram_len));
+    }
+#if IP_REASS_CONTIGUOUS
+    if ((valid == IP_REASS_VALIDATE_PBUF_QUEUED) && ((ipr->flags & IP_REASS_FLAG_LASTFRAG) != 0)) {
+      /* the length is known now, but fragments are missing */
+      ip_reass_make_contiguous(ipr);
+    }
+#endif /* IP_REASS_CONTIGUOUS */
   }
 
   if (valid == IP_REASS_VALIDATE_TELEGRAM_FINISHED) {
     struct ip_reassdata *ipr_prev;
     /* the totally last fragment (flag more fragments = 0) was received at least
      * once AND all fragments are received */
-    u16_t datagram_len = (u16_t)(ipr->datagram_len + IP_HLEN);
-
-    /* save the second pbuf before copying the header over the pointer */
-    r = ((struct ip_reass_helper *)ipr->p->payload)->next_pbuf;
-
-    /* copy the original ip header back to the first pbuf */
-    fraghdr = (struct ip_hdr *)(ipr->p->payload);
-    SMEMCPY(fraghdr, &ipr->iphdr, IP_HLEN);
-    IPH_LEN_SET(fraghdr, lwip_htons(datagram_len));
-    IPH_OFFSET_SET(fraghdr, 0);
-    IPH_CHKSUM_SET(fraghdr, 0);
-    /* @todo: do we need to set/calculate the correct checksum? */
-#if CHECKSUM_GEN_IP
-    IF__NETIF_CHECKSUM_ENABLED(ip_current_input_netif(), NETIF_CHECKSUM_GEN_IP) {
-      IPH_CHKSUM_SET(fraghdr, inet_chksum(fraghdr, IP_HLEN));
-    }
-#endif /* CHECKSUM_GEN_IP */
-
     p = ipr->p;
+#if IP_REASS_CONTIGUOUS
+    if ((ipr->flags & IP_REASS_FLAG_CONTIGUOUS) != 0) {
+      ip_reass_set_datagram_header(ipr, p);
+      /* cut off the bitmap */
+      pbuf_realloc(p, (u16_t)(ipr->datagram_len + IP_HLEN));
+    } else
+#endif /* IP_REASS_CONTIGUOUS */
+    {
+      /* save the second pbuf before copying the header over the pointer */
+      r = ((struct ip_reass_helper *)p->payload)->next_pbuf;
 
-    /* chain together the pbufs contained within the reass_data list. */
-    while (r != NULL) {
-      iprh = (struct ip_reass_helper *)r->payload;
+      /* copy the original ip header back to the first pbuf */
+      ip_reass_set_datagram_header(ipr, p);
 
-      /* hide the ip header for every succeeding fragment */
-      pbuf_remove_header(r, IP_HLEN);
-      pbuf_cat(p, r);
-      r = iprh->next_pbuf;
+      /* chain together the pbufs contained within the reass_data list. */
+      while (r != NULL) {
+        iprh = (struct ip_reass_helper *)r->payload;
+
+        /* hide the ip header for every succeeding fragment */
+        pbuf_remove_header(r, IP_HLEN);
+        pbuf_cat(p, r);
+        r = iprh->next_pbuf;
+      }
     }
 
     /* find the previous entry in the linked list */
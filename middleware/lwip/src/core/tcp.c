@@ -185,6 +185,12 @@ struct tcp_pcb **const tcp_pcb_lists[] = {&tcp_listen_pcbs.pcbs, &tcp_bound_pcbs
 
 u8_t tcp_active_pcbs_changed;
 
+#if TCP_PCB_HASH_SIZE
+/** Active PCBs hashed on their 4-tuple, chained through pcb->hash_next.
+ * Holds exactly the PCBs on tcp_active_pcbs. */
+static struct tcp_pcb *tcp_active_hash[TCP_PCB_HASH_SIZE];
+#endif /* TCP_PCB_HASH_SIZE */
+
 /** Timer counter to handle calling slow-timer from tcp_tmr() */
 static u8_t tcp_timer;
 static u8_t tcp_timer_ctr;
@@ -580,8 +586,14 @@ tcp_abandon(struct tcp_pcb *pcb, int reset)
      are in an active state, call the receive function associated with
      the PCB with a NULL argument, and send an RST to the remote end. */
   if (pcb->state == TIME_WAIT) {
+    /* a connection only shut down for tx may still be referenced */
+#if LWIP_CALLBACK_API
+    errf = pcb->errf;
+#endif /* LWIP_CALLBACK_API */
+    errf_arg = pcb->callback_arg;
     tcp_pcb_remove(&tcp_tw_pcbs, pcb);
     tcp_free(pcb);
+    TCP_EVENT_ERR(TIME_WAIT, errf, errf_arg, ERR_ABRT);
   } else {
     int send_rst = 0;
     u16_t local_port = 0;
@@ -1400,6 +1412,7 @@ tcp_slowtmr_start:
       enum tcp_state last_state;
       tcp_pcb_purge(pcb);
       /* Remove PCB from tcp_active_pcbs list. */
+      TCP_PCB_HASH_REMOVE(pcb);
       if (prev != NULL) {
         LWIP_ASSERT("tcp_slowtmr: middle tcp != tcp_active_pcbs", pcb != tcp_active_pcbs);
         prev->next = pcb->next;
@@ -1464,6 +1477,10 @@ tcp_slowtmr_start:
     /* If the PCB should be removed, do it. */
     if (pcb_remove) {
       struct tcp_pcb *pcb2;
+#if LWIP_CALLBACK_API
+      tcp_err_fn err_fn = pcb->errf;
+#endif /* LWIP_CALLBACK_API */
+      void *err_arg = pcb->callback_arg;
       tcp_pcb_purge(pcb);
       /* Remove PCB from tcp_tw_pcbs list. */
       if (prev != NULL) {
@@ -1477,6 +1494,9 @@ tcp_slowtmr_start:
       pcb2 = pcb;
       pcb = pcb->next;
       tcp_free(pcb2);
+
+      /* a connection only shut down for tx may still be referenced */
+      TCP_EVENT_ERR(TIME_WAIT, err_fn, err_arg, ERR_ABRT);
     } else {
       prev = pcb;
       pcb = pcb->next;
@@ -2208,6 +2228,104 @@ tcp_pcb_purge(struct tcp_pcb *pcb)
   }
 }
 
+#if TCP_PCB_HASH_SIZE
+/** Bucket index of a connection. The local IP address is left out: it rarely
+ * differs between connections and the full 4-tuple is compared on lookup. */
+static u32_t
+tcp_pcb_hash(const ip_addr_t *remote_ip, u16_t remote_port, u16_t local_port)
+{
+  u32_t h = ((u32_t)remote_port << 16) | local_port;
+
+#if LWIP_IPV6
+  if (IP_IS_V6(remote_ip)) {
+    const ip6_addr_t *ip6 = ip_2_ip6(remote_ip);
+    h ^= ip6->addr[0] ^ ip6->addr[1] ^ ip6->addr[2] ^ ip6->addr[3];
+  } else
+#endif /* LWIP_IPV6 */
+  {
+#if LWIP_IPV4
+    h ^= ip4_addr_get_u32(ip_2_ip4(remote_ip));
+#endif /* LWIP_IPV4 */
+  }
+  /* multiplicative mixing so that both ports and address reach the low bits */
+  h *= 0x9E3779B1UL;
+  return (h ^ (h >> 16)) & (TCP_PCB_HASH_SIZE - 1);
+}
+
+/**
+ * Add a PCB that is being registered on tcp_active_pcbs to the hash table.
+ * Its remote address and both ports must already be set.
+ */
+void
+tcp_pcb_hash_insert(struct tcp_pcb *pcb)
+{
+  struct tcp_pcb **bucket;
+
+  LWIP_ASSERT("tcp_pcb_hash_insert: invalid pcb", pcb != NULL);
+
+  bucket = &tcp_active_hash[tcp_pcb_hash(&pcb->remote_ip, pcb->remote_port, pcb->local_port)];
+  pcb->hash_next = *bucket;
+  *bucket = pcb;
+}
+
+/**
+ * Remove a PCB from the hash table before it leaves tcp_active_pcbs.
+ * Must be called before its remote address or ports are changed. Like TCP_RMV,
+ * this is a no-op for a PCB that is not (or no longer) registered, which
+ * happens when tcp_input removes a PCB that was closed from a callback.
+ */
+void
+tcp_pcb_hash_remove(struct tcp_pcb *pcb)
+{
+  struct tcp_pcb **link;
+
+  LWIP_ASSERT("tcp_pcb_hash_remove: invalid pcb", pcb != NULL);
+
+  link = &tcp_active_hash[tcp_pcb_hash(&pcb->remote_ip, pcb->remote_port, pcb->local_port)];
+  while (*link != NULL) {
+    if (*link == pcb) {
+      *link = pcb->hash_next;
+      pcb->hash_next = NULL;
+      return;
+    }
+    link = &(*link)->hash_next;
+  }
+}
+
+/**
+ * Find the active PCB for an incoming segment.
+ *
+ * @param netif_idx index of the netif the segment arrived on
+ * @return the matching PCB or NULL
+ */
+struct tcp_pcb *
+tcp_pcb_hash_lookup(const ip_addr_t *remote_ip, u16_t remote_port,
+                    const ip_addr_t *local_ip, u16_t local_port,
+                    u8_t netif_idx)
+{
+  struct tcp_pcb *pcb;
+
+  for (pcb = tcp_active_hash[tcp_pcb_hash(remote_ip, remote_port, local_port)];
+       pcb != NULL; pcb = pcb->hash_next) {
+    LWIP_ASSERT("tcp_pcb_hash_lookup: active pcb->state != CLOSED", pcb->state != CLOSED);
+    LWIP_ASSERT("tcp_pcb_hash_lookup: active pcb->state != TIME-WAIT", pcb->state != TIME_WAIT);
+    LWIP_ASSERT("tcp_pcb_hash_lookup: active pcb->state != LISTEN", pcb->state != LISTEN);
+
+    /* check if PCB is bound to specific netif */
+    if ((pcb->netif_idx != NETIF_NO_INDEX) && (pcb->netif_idx != netif_idx)) {
+      continue;
+    }
+    if (pcb->remote_port == remote_port &&
+        pcb->local_port == local_port &&
+        ip_addr_eq(&pcb->remote_ip, remote_ip) &&
+        ip_addr_eq(&pcb->local_ip, local_ip)) {
+      return pcb;
+    }
+  }
+  return NULL;
+}
+#endif /* TCP_PCB_HASH_SIZE */
+
 /**
  * Purges the PCB and removes it from a PCB list. Any delayed ACKs are sent first.
  *
@@ -2220,6 +2338,9 @@ tcp_pcb_remove(struct tcp_pcb **pcblist, struct tcp_pcb *pcb)
   LWIP_ASSERT("tcp_pcb_remove: invalid pcb", pcb != NULL);
   LWIP_ASSERT("tcp_pcb_remove: invalid pcblist", pcblist != NULL);
 
+  if (pcblist == &tcp_active_pcbs) {
+    TCP_PCB_HASH_REMOVE(pcb);
+  }
   TCP_RMV(pcblist, pcb);
 
   tcp_pcb_purge(pcb);
@@ -131,6 +131,7 @@ tcp_input(struct pbuf *p, struct netif *inp)
   LWIP_ASSERT("tcp_input: invalid pbuf", p != NULL);
 
   PERF_START;
+  PERF_PROBE(LWIP_PERF_TCP_INPUT, p);
 
   TCP_STATS_INC(tcp.recv);
   MIB2_STATS_INC(mib2.tcpinsegs);
@@ -247,6 +248,11 @@ tcp_input(struct pbuf *p, struct netif *inp)
      for an active connection. */
   prev = NULL;
 
+#if TCP_PCB_HASH_SIZE
+  pcb = tcp_pcb_hash_lookup(ip_current_src_addr(), tcphdr->src,
+                            ip_current_dest_addr(), tcphdr->dest,
+                            netif_get_index(ip_data.current_input_netif));
+#else /* TCP_PCB_HASH_SIZE */
   for (pcb = tcp_active_pcbs; pcb != NULL; pcb = pcb->next) {
     LWIP_ASSERT("tcp_input: active pcb->state != CLOSED", pcb->state != CLOSED);
     LWIP_ASSERT("tcp_input: active pcb->state != TIME-WAIT", pcb->state != TIME_WAIT);
@@ -279,6 +285,7 @@ tcp_input(struct pbuf *p, struct netif *inp)
     }
     prev = pcb;
   }
+#endif /* TCP_PCB_HASH_SIZE */
 
   if (pcb == NULL) {
     /* If it did not go to an active connection, we check the connections
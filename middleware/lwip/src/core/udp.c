@@ -208,6 +208,7 @@ udp_input(struct pbuf *p, struct netif *inp)
   LWIP_ASSERT("udp_input: invalid netif", inp != NULL);
 
   PERF_START;
+  PERF_PROBE(LWIP_PERF_UDP_INPUT, p);
 
   UDP_STATS_INC(udp.recv);
 
@@ -724,6 +725,8 @@ udp_sendto_if_src_chksum(struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *d
   LWIP_ERROR("udp_sendto_if_src: invalid src_ip", src_ip != NULL, return ERR_ARG);
   LWIP_ERROR("udp_sendto_if_src: invalid netif", netif != NULL, return ERR_ARG);
 
+  PERF_PROBE(LWIP_PERF_UDP_OUTPUT, p);
+
   if (!IP_ADDR_PCB_VERSION_MATCH(pcb, src_ip) ||
       !IP_ADDR_PCB_VERSION_MATCH(pcb, dst_ip)) {
     return ERR_VAL;
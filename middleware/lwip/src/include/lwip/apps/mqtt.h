@@ -40,6 +40,7 @@
 #include "lwip/apps/mqtt_opts.h"
 #include "lwip/err.h"
 #include "lwip/ip_addr.h"
+#include "lwip/pbuf.h"
 #include "lwip/prot/iana.h"
 
 #ifdef __cplusplus
@@ -199,6 +200,11 @@ err_t mqtt_sub_unsub(mqtt_client_t *client, const char *topic, u8_t qos, mqtt_re
 
 err_t mqtt_publish(mqtt_client_t *client, const char *topic, const void *payload, u16_t payload_length, u8_t qos, u8_t retain,
                                     mqtt_request_cb_t cb, void *arg);
+err_t mqtt_publish_pbuf(mqtt_client_t *client, const char *topic, struct pbuf *p, u8_t qos, u8_t retain,
+                        mqtt_request_cb_t cb, void *arg);
+
+void mqtt_batch_begin(mqtt_client_t *client);
+void mqtt_batch_end(mqtt_client_t *client);
 
 #ifdef __cplusplus
 }
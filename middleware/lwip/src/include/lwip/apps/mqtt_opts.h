@@ -66,11 +66,21 @@ extern "C" {
 
 /**
  * Maximum number of pending subscribe, unsubscribe and publish requests to server .
+ * Responses are matched to requests in constant time, so this may be raised to
+ * keep more QoS 1/2 publishes in flight.
  */
 #ifndef MQTT_REQ_MAX_IN_FLIGHT
 #define MQTT_REQ_MAX_IN_FLIGHT 4
 #endif
 
+/**
+ * Maximum number of mqtt_publish_pbuf() payloads referenced until acknowledged by TCP.
+ * Payloads beyond that are copied into the output ring-buffer.
+ */
+#ifndef MQTT_NOCOPY_MAX_IN_FLIGHT
+#define MQTT_NOCOPY_MAX_IN_FLIGHT 4
+#endif
+
 /**
  * Seconds between each cyclic timer call.
  */
@@ -47,16 +47,34 @@ extern "C" {
 /** Pending request item, binds application callback to pending server requests */
 struct mqtt_request_t
 {
-  /** Next item in list, NULL means this is the last in chain,
-      next pointing at itself means request is unallocated */
+  /** Next item in list, NULL means this is the last in chain */
   struct mqtt_request_t *next;
+  /** Previous item in list, NULL means this is the first in chain */
+  struct mqtt_request_t *prev;
   /** Callback to upper layer */
   mqtt_request_cb_t cb;
   void *arg;
+  /** Output stream position after the request, QoS 0 publish is complete when TCP acknowledged it */
+  u32_t tx_end;
   /** MQTT packet identifier */
   u16_t pkt_id;
-  /** Expire time relative to element before this  */
-  u16_t timeout_diff;
+  /** Expire time, in seconds of mqtt_client_s::req_time */
+  u16_t expire;
+};
+
+/** Request queue, oldest request first */
+struct mqtt_request_queue_t
+{
+  struct mqtt_request_t *first;
+  struct mqtt_request_t *last;
+};
+
+/** Publish payload referenced by TCP until acknowledged */
+struct mqtt_nocopy_t
+{
+  struct pbuf *p;
+  /** Output stream position after the payload */
+  u32_t tx_end;
 };
 
 /** Ring buffer */
@@ -83,9 +101,26 @@ struct mqtt_client_s
   /** Connection callback */
   void *connect_arg;
   mqtt_connection_cb_t connect_cb;
-  /** Pending requests to server */
-  struct mqtt_request_t *pend_req_queue;
+  /** Pending requests to server, in order of expiry */
+  struct mqtt_request_queue_t pend_req_queue;
+  /** QoS 0 publish requests waiting for TCP acknowledge, in order of expiry */
+  struct mqtt_request_queue_t pend_qos0_queue;
+  /** Unused request items */
+  struct mqtt_request_t *free_req;
+  /** Requests with packet identifier, at index pkt_id % MQTT_REQ_MAX_IN_FLIGHT */
+  struct mqtt_request_t *req_index[MQTT_REQ_MAX_IN_FLIGHT];
   struct mqtt_request_t req_list[MQTT_REQ_MAX_IN_FLIGHT];
+  /** Request timer, seconds */
+  u16_t req_time;
+  /** Non-zero between mqtt_batch_begin() and mqtt_batch_end() */
+  u8_t batch;
+  /** Output stream bytes written to and acknowledged by TCP */
+  u32_t tx_written;
+  u32_t tx_acked;
+  /** Publish payloads sent without copy, oldest first */
+  struct mqtt_nocopy_t nocopy[MQTT_NOCOPY_MAX_IN_FLIGHT];
+  u16_t nocopy_get;
+  u16_t nocopy_len;
   void *inpub_arg;
   /** Incoming data callback */
   mqtt_incoming_data_cb_t data_cb;
@@ -43,6 +43,9 @@
  * Measurement calls made throughout lwip, these can be defined to nothing.
  * - PERF_START: start measuring something.
  * - PERF_STOP(x): stop measuring something, and record the result.
+ * - PERF_PROBE(point, p): packet p passes probe point 'point' (one of the
+ *   LWIP_PERF_xxx defines below) on its way through the stack. Defaults to
+ *   nothing if arch/perf.h does not define it.
  */
 
 #ifndef LWIP_HDR_DEF_H
@@ -51,11 +54,29 @@
 /* arch.h might define NULL already */
 #include "lwip/arch.h"
 #include "lwip/opt.h"
+
+/** @ingroup perf
+ * Probe points passed to PERF_PROBE, in the order a packet passes them */
+#define LWIP_PERF_NETIF_RX    0 /* driver passes a received frame to netif->input */
+#define LWIP_PERF_IP4_INPUT   1 /* ip4_input */
+#define LWIP_PERF_TCP_INPUT   2 /* tcp_input */
+#define LWIP_PERF_UDP_INPUT   3 /* udp_input */
+#define LWIP_PERF_SOCKET_RX   4 /* netconn/socket receive hands data to the application */
+#define LWIP_PERF_TCP_OUTPUT  5 /* tcp_output_segment, before the segment goes to IP */
+#define LWIP_PERF_UDP_OUTPUT  6 /* udp_sendto_if_src */
+#define LWIP_PERF_IP4_OUTPUT  7 /* ip4_output_if_src */
+#define LWIP_PERF_NETIF_TX    8 /* ethernet_output, before netif->linkoutput */
+#define LWIP_PERF_NUM         9
+
 #if LWIP_PERF
 #include "arch/perf.h"
+#ifndef PERF_PROBE
+#define PERF_PROBE(point, p)  /* null definition */
+#endif
 #else /* LWIP_PERF */
 #define PERF_START    /* null definition */
 #define PERF_STOP(x)  /* null definition */
+#define PERF_PROBE(point, p)  /* null definition */
 #endif /* LWIP_PERF */
 
 #ifdef __cplusplus
@@ -58,7 +58,11 @@
 # ifndef LWIP_CHKSUM_COPY
 #  define LWIP_CHKSUM_COPY(dst, src, len) lwip_chksum_copy(dst, src, len)
 #  ifndef LWIP_CHKSUM_COPY_ALGORITHM
-#   define LWIP_CHKSUM_COPY_ALGORITHM 1
+#   if LWIP_HAVE_INT64
+#    define LWIP_CHKSUM_COPY_ALGORITHM 2
+#   else
+#    define LWIP_CHKSUM_COPY_ALGORITHM 1
+#   endif
 #  endif /* LWIP_CHKSUM_COPY_ALGORITHM */
 # else /* LWIP_CHKSUM_COPY */
 #  define LWIP_CHKSUM_COPY_ALGORITHM 0
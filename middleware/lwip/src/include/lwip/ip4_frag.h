@@ -61,7 +61,11 @@ extern "C" {
 struct ip_reassdata {
   struct ip_reassdata *next;
   struct pbuf *p;
+  /** fragment with the highest offset, fragments received in order are appended here */
+  struct pbuf *p_last;
   struct ip_hdr iphdr;
+  /** number of payload bytes received so far */
+  u32_t recvd_len;
   u16_t datagram_len;
   u8_t flags;
   u8_t timer;
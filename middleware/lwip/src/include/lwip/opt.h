@@ -732,6 +732,15 @@
 #if !defined ETHARP_TABLE_MATCH_NETIF || defined __DOXYGEN__
 #define ETHARP_TABLE_MATCH_NETIF        !LWIP_SINGLE_NETIF
 #endif
+
+/** ETHARP_TABLE_HASH_SIZE > 0: Index the ARP table by IP address with a hash
+ * table of this many buckets (must be a power of 2), so that lookups of known
+ * entries don't have to walk all ARP_TABLE_SIZE entries. Only worth it with a
+ * large ARP_TABLE_SIZE. Costs 2 bytes per bucket and 3 bytes per entry.
+ */
+#if !defined ETHARP_TABLE_HASH_SIZE || defined __DOXYGEN__
+#define ETHARP_TABLE_HASH_SIZE          0
+#endif
 /**
  * @}
  */
@@ -820,6 +829,34 @@
 #define IP_REASS_MAX_PBUFS              10
 #endif
 
+/**
+ * IP_REASS_CONTIGUOUS==1: Copy the fragments of a datagram into a single
+ * PBUF_RAM buffer (allocated from the heap) as soon as its last fragment
+ * arrived and the total length is known. Fragments received later are copied
+ * straight into it and freed, so they don't hold pool pbufs, and received
+ * ranges are tracked in a bitmap over 8-byte units (duplicate and overlap
+ * checks and the completion check don't walk the fragment list). The
+ * reassembled datagram is passed on as one contiguous pbuf.
+ * Datagrams whose last fragment arrives last are still chained without
+ * copying. Needs heap (MEM_SIZE) for the largest datagram expected, up to
+ * MEMP_NUM_REASSDATA of them at once; datagrams larger than
+ * IP_REASS_CONTIGUOUS_MAX, or if the allocation fails, are reassembled as a
+ * chain.
+ */
+#if !defined IP_REASS_CONTIGUOUS || defined __DOXYGEN__
+#define IP_REASS_CONTIGUOUS             0
+#endif
+
+/**
+ * IP_REASS_CONTIGUOUS_MAX: Largest heap buffer allocated for a contiguous
+ * datagram (IP_REASS_CONTIGUOUS), IP header and received bitmap included.
+ * Larger datagrams stay chained, so that a few large datagrams waiting for
+ * their missing fragments cannot pin most of the heap.
+ */
+#if !defined IP_REASS_CONTIGUOUS_MAX || defined __DOXYGEN__
+#define IP_REASS_CONTIGUOUS_MAX         (MEM_SIZE / 4)
+#endif
+
 /**
  * IP_DEFAULT_TTL: Default value for Time-To-Live used by transport layers.
  */
@@ -1473,6 +1510,18 @@
 #define TCP_DEFAULT_LISTEN_BACKLOG      0xff
 #endif
 
+/**
+ * TCP_PCB_HASH_SIZE > 0: Additionally keep the active PCBs in a hash table of
+ * this many buckets (must be a power of 2), keyed on remote IP address, remote
+ * port and local port. tcp_input() then finds the PCB of an incoming segment in
+ * about constant time instead of walking tcp_active_pcbs, which helps when
+ * many connections are open at the same time. TIME-WAIT and listening PCBs are
+ * still searched linearly. Costs one pointer per bucket and per PCB.
+ */
+#if !defined TCP_PCB_HASH_SIZE || defined __DOXYGEN__
+#define TCP_PCB_HASH_SIZE               0
+#endif
+
 /**
  * TCP_OVERSIZE: The maximum number of bytes that tcp_write may
  * allocate ahead of time in an attempt to create shorter pbuf chains
@@ -419,14 +419,29 @@ extern struct tcp_pcb ** const tcp_pcb_lists[NUM_TCP_PCB_LISTS];
 
 #endif /* LWIP_DEBUG */
 
+#if TCP_PCB_HASH_SIZE
+void tcp_pcb_hash_insert(struct tcp_pcb *pcb);
+void tcp_pcb_hash_remove(struct tcp_pcb *pcb);
+struct tcp_pcb *tcp_pcb_hash_lookup(const ip_addr_t *remote_ip, u16_t remote_port,
+                                    const ip_addr_t *local_ip, u16_t local_port,
+                                    u8_t netif_idx);
+#define TCP_PCB_HASH_INSERT(npcb) tcp_pcb_hash_insert(npcb)
+#define TCP_PCB_HASH_REMOVE(npcb) tcp_pcb_hash_remove(npcb)
+#else /* TCP_PCB_HASH_SIZE */
+#define TCP_PCB_HASH_INSERT(npcb)
+#define TCP_PCB_HASH_REMOVE(npcb)
+#endif /* TCP_PCB_HASH_SIZE */
+
 #define TCP_REG_ACTIVE(npcb)                       \
   do {                                             \
     TCP_REG(&tcp_active_pcbs, npcb);               \
+    TCP_PCB_HASH_INSERT(npcb);                     \
     tcp_active_pcbs_changed = 1;                   \
   } while (0)
 
 #define TCP_RMV_ACTIVE(npcb)                       \
   do {                                             \
+    TCP_PCB_HASH_REMOVE(npcb);                     \
     TCP_RMV(&tcp_active_pcbs, npcb);               \
     tcp_active_pcbs_changed = 1;                   \
   } while (0)
@@ -273,6 +273,7 @@ struct linger {
 #define MSG_DONTWAIT   0x08    /* Nonblocking i/o for this operation only */
 #define MSG_MORE       0x10    /* Sender will send more */
 #define MSG_NOSIGNAL   0x20    /* Uninmplemented: Requests not to send the SIGPIPE signal if an attempt to send is made on a stream-oriented socket that is no longer connected. */
+#define MSG_NOCOPY     0x40    /* lwIP extension for send() on TCP: the data stays valid and unchanged until acknowledged (e.g. const data in flash), queue it without copying */
 
 
 /*
@@ -246,6 +246,11 @@ struct tcp_pcb {
 /** protocol specific PCB members */
   TCP_PCB_COMMON(struct tcp_pcb);
 
+#if TCP_PCB_HASH_SIZE
+  /** next PCB in the same tcp_active_hash bucket */
+  struct tcp_pcb *hash_next;
+#endif /* TCP_PCB_HASH_SIZE */
+
   /* ports are in host byte order */
   u16_t remote_port;
 
@@ -318,6 +318,7 @@ ethernet_output(struct netif * netif, struct pbuf * p,
               ("ethernet_output: sending packet %p\n", (void *)p));
 
   /* send the packet */
+  PERF_PROBE(LWIP_PERF_NETIF_TX, p);
   return netif->linkoutput(netif, p);
 
 pbuf_header_failed:
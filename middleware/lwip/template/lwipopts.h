@@ -188,6 +188,15 @@ void sys_check_core_locking(void);
 #define IP_REASS_MAX_PBUFS 4
 #endif
 
+/* IP_REASS_CONTIGUOUS: copy out-of-order fragments into one heap buffer once
+   the datagram length is known, so they don't hold receive pbufs. The buffer
+   stays allocated until the datagram completes or times out, so it is off
+   by default; when enabled, IP_REASS_CONTIGUOUS_MAX (MEM_SIZE / 4 unless
+   set) caps the buffer and larger datagrams are chained. */
+#ifndef IP_REASS_CONTIGUOUS
+#define IP_REASS_CONTIGUOUS 0
+#endif
+
 /* ---------- TCP options ---------- */
 #ifndef LWIP_TCP
 #define LWIP_TCP 1
@@ -250,6 +259,20 @@ void sys_check_core_locking(void);
 #define UDP_TTL 255
 #endif
 
+/* ---------- Packet path latency probes (port/lwip_perf.c) ---------- */
+#ifndef LWIP_PERF
+#define LWIP_PERF 0
+#endif
+#if LWIP_PERF
+/* pbufs carry the clock of the probe that started their path */
+#define LWIP_PBUF_CUSTOM_DATA         u32_t perf_stamp;
+#define LWIP_PBUF_CUSTOM_DATA_INIT(p) lwip_perf_pbuf_init(p)
+/* the pbuf use timeline reads the memp statistics */
+#ifndef LWIP_STATS
+#define LWIP_STATS 1
+#endif
+#endif
+
 /* ---------- Statistics options ---------- */
 #ifndef LWIP_STATS
 #define LWIP_STATS 0
@@ -308,6 +331,15 @@ void sys_check_core_locking(void);
 #define CHECKSUM_CHECK_ICMP6 0
 #endif
 
+/**
+ * Software checksum, used where it is not offloaded to the MAC: 64-bit
+ * accumulator, 32 bytes per loop. With CHECKSUM_GEN_TCP, also define
+ * LWIP_CHECKSUM_ON_COPY 1 to checksum TCP data while it is copied.
+ */
+#ifndef LWIP_CHKSUM_ALGORITHM
+#define LWIP_CHKSUM_ALGORITHM 4
+#endif
+
 /**
  * DEFAULT_THREAD_STACKSIZE: The stack size used by any other lwIP thread.
  * The stack size value itself is platform-dependent, but is passed to
@@ -46,6 +46,7 @@ set(LWIP_TESTFILES
 	${LWIP_TESTDIR}/lwip_unittests.c
 	${LWIP_TESTDIR}/api/test_sockets.c
 	${LWIP_TESTDIR}/arch/sys_arch.c
+	${LWIP_TESTDIR}/core/test_chksum.c
 	${LWIP_TESTDIR}/core/test_def.c
 	${LWIP_TESTDIR}/core/test_dns.c
 	${LWIP_TESTDIR}/core/test_mem.c
@@ -62,7 +63,14 @@ set(LWIP_TESTFILES
 	${LWIP_TESTDIR}/tcp/tcp_helper.c
 	${LWIP_TESTDIR}/tcp/test_tcp_oos.c
 	${LWIP_TESTDIR}/tcp/test_tcp_state.c
+	${LWIP_TESTDIR}/tcp/test_tcp_demux.c
 	${LWIP_TESTDIR}/tcp/test_tcp.c
 	${LWIP_TESTDIR}/udp/test_udp.c
 	${LWIP_TESTDIR}/ppp/test_pppos.c
+	${LWIP_TESTDIR}/port/test_ethernetif_rx_batch.c
+	${LWIP_TESTDIR}/port/test_ethernetif_zerocopy.c
+	${LWIP_TESTDIR}/port/test_lwip_perf.c
+	${LWIP_DIR}/port/ethernetif_rx_batch.c
+	${LWIP_DIR}/port/ethernetif_zerocopy.c
+	${LWIP_DIR}/port/lwip_perf.c
 )
@@ -34,6 +34,7 @@ TESTDIR=$(LWIPDIR)/../test/unit
 TESTFILES=$(TESTDIR)/lwip_unittests.c \
 	$(TESTDIR)/api/test_sockets.c \
 	$(TESTDIR)/arch/sys_arch.c \
+	$(TESTDIR)/core/test_chksum.c \
 	$(TESTDIR)/core/test_def.c \
 	$(TESTDIR)/core/test_dns.c \
 	$(TESTDIR)/core/test_mem.c \
@@ -50,7 +51,14 @@ TESTFILES=$(TESTDIR)/lwip_unittests.c \
 	$(TESTDIR)/tcp/tcp_helper.c \
 	$(TESTDIR)/tcp/test_tcp_oos.c \
 	$(TESTDIR)/tcp/test_tcp_state.c \
+	$(TESTDIR)/tcp/test_tcp_demux.c \
 	$(TESTDIR)/tcp/test_tcp.c \
 	$(TESTDIR)/udp/test_udp.c \
-	$(TESTDIR)/ppp/test_pppos.c
+	$(TESTDIR)/ppp/test_pppos.c \
+	$(TESTDIR)/port/test_ethernetif_rx_batch.c \
+	$(TESTDIR)/port/test_ethernetif_zerocopy.c \
+	$(TESTDIR)/port/test_lwip_perf.c \
+	$(LWIPDIR)/../port/ethernetif_rx_batch.c \
+	$(LWIPDIR)/../port/ethernetif_zerocopy.c \
+	$(LWIPDIR)/../port/lwip_perf.c
 
@@ -828,6 +828,97 @@ cleanup:
 }
 END_TEST
 
+/* Search the queued segments of a pcb for a pbuf referencing data */
+static int
+test_sockets_pcb_references(struct tcp_pcb *pcb, const void *data)
+{
+  struct tcp_seg *queues[2];
+  int i;
+
+  queues[0] = pcb->unsent;
+  queues[1] = pcb->unacked;
+  for (i = 0; i < 2; i++) {
+    struct tcp_seg *seg;
+    for (seg = queues[i]; seg != NULL; seg = seg->next) {
+      struct pbuf *q;
+      for (q = seg->p; q != NULL; q = q->next) {
+        if (q->payload == data) {
+          return 1;
+        }
+      }
+    }
+  }
+  return 0;
+}
+
+START_TEST(test_sockets_send_nocopy)
+{
+  int sl, sact;
+  int spass = -1;
+  int ret;
+  struct sockaddr_in sa_listen;
+  const u16_t port = 1235;
+  static const char txbuf[] = "static data, sent without copying";
+  char rxbuf[64];
+  struct lwip_sock *sact_sock;
+  int one = 1;
+  LWIP_UNUSED_ARG(_i);
+
+  memset(&sa_listen, 0, sizeof(sa_listen));
+  sa_listen.sin_family = AF_INET;
+  sa_listen.sin_port = PP_HTONS(port);
+  sa_listen.sin_addr.s_addr = PP_HTONL(INADDR_LOOPBACK);
+
+  sl = lwip_socket(AF_INET, SOCK_STREAM, 0);
+  fail_unless(sl >= 0);
+  ret = lwip_bind(sl, (struct sockaddr *)&sa_listen, sizeof(sa_listen));
+  fail_unless(ret == 0);
+  ret = lwip_listen(sl, 0);
+  fail_unless(ret == 0);
+
+  sact = test_sockets_alloc_socket_nonblocking(AF_INET, SOCK_STREAM);
+  fail_unless(sact >= 0);
+  ret = lwip_connect(sact, (struct sockaddr *)&sa_listen, sizeof(sa_listen));
+  fail_unless((ret == 0) || ((ret == -1) && (errno == EINPROGRESS)));
+  while (tcpip_thread_poll_one());
+
+  spass = lwip_accept(sl, NULL, NULL);
+  fail_unless(spass >= 0);
+
+  sact_sock = lwip_socket_dbg_get_socket(sact);
+  fail_unless(sact_sock != NULL);
+  /* send both writes right away instead of waiting for the (delayed) ACK */
+  ret = lwip_setsockopt(sact, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  fail_unless(ret == 0);
+
+  /* without the flag, the data is copied */
+  ret = lwip_send(sact, txbuf, sizeof(txbuf), 0);
+  fail_unless(ret == sizeof(txbuf));
+  fail_unless(!test_sockets_pcb_references(sact_sock->conn->pcb.tcp, txbuf));
+  while (tcpip_thread_poll_one());
+
+  ret = lwip_recv(spass, rxbuf, sizeof(rxbuf), 0);
+  fail_unless(ret == sizeof(txbuf));
+
+  /* the queued segment points at txbuf instead of a copy of it */
+  ret = lwip_send(sact, txbuf, sizeof(txbuf), MSG_NOCOPY);
+  fail_unless(ret == sizeof(txbuf));
+  fail_unless(test_sockets_pcb_references(sact_sock->conn->pcb.tcp, txbuf));
+  while (tcpip_thread_poll_one());
+
+  ret = lwip_recv(spass, rxbuf, sizeof(rxbuf), 0);
+  fail_unless(ret == sizeof(txbuf));
+  fail_unless(memcmp(rxbuf, txbuf, sizeof(txbuf)) == 0);
+
+  ret = lwip_close(sl);
+  fail_unless(ret == 0);
+  ret = lwip_close(sact);
+  fail_unless(ret == 0);
+  ret = lwip_close(spass);
+  fail_unless(ret == 0);
+}
+END_TEST
+
 /** Create the suite including all tests for this module */
 Suite *
 sockets_suite(void)
@@ -838,6 +929,7 @@ sockets_suite(void)
     TESTFUNC(test_sockets_msgapis),
     TESTFUNC(test_sockets_select),
     TESTFUNC(test_sockets_recv_after_rst),
+    TESTFUNC(test_sockets_send_nocopy),
   };
   return create_suite("SOCKETS", tests, sizeof(tests)/sizeof(testfunc), sockets_setup, sockets_teardown);
 }
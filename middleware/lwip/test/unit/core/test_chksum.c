@@ -0,0 +1,132 @@
+#include "test_chksum.h"
+
+#include "lwip/inet_chksum.h"
+#include "lwip/def.h"
+
+#include <string.h>
+
+#if !LWIP_CHECKSUM_ON_COPY
+#error "This tests needs LWIP_CHECKSUM_ON_COPY enabled"
+#endif
+
+#define TEST_CHKSUM_BUF_SIZE 1600
+
+static u8_t src_buf[TEST_CHKSUM_BUF_SIZE + 8];
+static u8_t dst_buf[TEST_CHKSUM_BUF_SIZE + 8];
+
+/* RFC 1071, byte by byte, network order. */
+static u16_t
+ref_chksum(const u8_t *data, int len)
+{
+  u32_t acc = 0;
+  int i;
+
+  for (i = 0; i + 1 < len; i += 2) {
+    acc += ((u32_t)data[i] << 8) | data[i + 1];
+  }
+  if (len & 1) {
+    acc += (u32_t)data[len - 1] << 8;
+  }
+  while (acc >> 16) {
+    acc = (acc >> 16) + (acc & 0xffff);
+  }
+  return (u16_t)~acc;
+}
+
+static void
+fill(u8_t *buf, size_t len, u32_t seed)
+{
+  size_t i;
+
+  for (i = 0; i < len; i++) {
+    seed = seed * 1103515245UL + 12345UL;
+    buf[i] = (u8_t)(seed >> 16);
+  }
+}
+
+/* Setups/teardown functions */
+
+static void
+chksum_setup(void)
+{
+  fill(src_buf, sizeof(src_buf), 1);
+}
+
+static void
+chksum_teardown(void)
+{
+}
+
+/* Test functions */
+
+/** inet_chksum() matches RFC 1071 for every alignment and length. */
+START_TEST(test_chksum_alignments)
+{
+  int offset, len;
+  LWIP_UNUSED_ARG(_i);
+
+  for (offset = 0; offset < 8; offset++) {
+    for (len = 0; len <= 300; len++) {
+      u16_t expected = ref_chksum(&src_buf[offset], len);
+      /* inet_chksum() is stored as is, i.e. it is in network order */
+      u16_t actual = lwip_ntohs(inet_chksum(&src_buf[offset], (u16_t)len));
+      fail_unless(actual == expected, "offset %d len %d: %04x != %04x", offset, len, actual, expected);
+    }
+    len = TEST_CHKSUM_BUF_SIZE;
+    fail_unless(lwip_ntohs(inet_chksum(&src_buf[offset], (u16_t)len)) == ref_chksum(&src_buf[offset], len));
+  }
+}
+END_TEST
+
+/** All 0xff data exercises the carry folding of the accumulator. */
+START_TEST(test_chksum_carry)
+{
+  LWIP_UNUSED_ARG(_i);
+
+  memset(dst_buf, 0xff, sizeof(dst_buf));
+  fail_unless(lwip_ntohs(inet_chksum(dst_buf, TEST_CHKSUM_BUF_SIZE)) == ref_chksum(dst_buf, TEST_CHKSUM_BUF_SIZE));
+  fail_unless(lwip_ntohs(inet_chksum(&dst_buf[1], 1499)) == ref_chksum(&dst_buf[1], 1499));
+  memset(dst_buf, 0, sizeof(dst_buf));
+  fail_unless(inet_chksum(dst_buf, 64) == 0xffff);
+}
+END_TEST
+
+/** Copy-and-checksum copies exactly and gives the same sum, for any
+ * combination of source and destination alignment. */
+START_TEST(test_chksum_copy)
+{
+  int src_off, dst_off, len;
+  LWIP_UNUSED_ARG(_i);
+
+  for (src_off = 0; src_off < 4; src_off++) {
+    for (dst_off = 0; dst_off < 4; dst_off++) {
+      for (len = 0; len <= 100; len++) {
+        u16_t sum, inverted;
+        memset(dst_buf, 0xa5, sizeof(dst_buf));
+        sum = LWIP_CHKSUM_COPY(&dst_buf[dst_off], &src_buf[src_off], (u16_t)len);
+        fail_unless(memcmp(&dst_buf[dst_off], &src_buf[src_off], len) == 0);
+        fail_unless(dst_buf[dst_off + len] == 0xa5, "overrun at len %d", len);
+        if (dst_off > 0) {
+          fail_unless(dst_buf[dst_off - 1] == 0xa5);
+        }
+        /* Same convention as LWIP_CHKSUM: host order, not inverted. */
+        inverted = (u16_t)~sum;
+        fail_unless(lwip_ntohs(inverted) == ref_chksum(&src_buf[src_off], len),
+                    "src %d dst %d len %d", src_off, dst_off, len);
+      }
+    }
+  }
+}
+END_TEST
+
+/** Create the suite including all tests for this module */
+Suite *
+chksum_suite(void)
+{
+  testfunc tests[] = {
+    TESTFUNC(test_chksum_alignments),
+    TESTFUNC(test_chksum_carry),
+    TESTFUNC(test_chksum_copy)
+  };
+  return create_suite("CHKSUM", tests, sizeof(tests)/sizeof(testfunc), chksum_setup, chksum_teardown);
+}
@@ -39,6 +39,7 @@
 #include "lwip/prot/ip4.h"
 
 #include "lwip/tcpip.h"
+#include "lwip/ip4_frag.h"
 
 #if !LWIP_IPV4 || !IP_REASSEMBLY || !MIB2_STATS || !IPFRAG_STATS
 #error "This tests needs LWIP_IPV4, IP_REASSEMBLY; MIB2- and IPFRAG-statistics enabled"
@@ -139,6 +140,65 @@ create_ip4_input_fragment(u16_t ip_id, u16_t start, u16_t len, int last)
   }
 }
 
+/* Payload of the datagrams reassembled by the ip4_reass() tests */
+static u8_t reass_data[6000];
+static u32_t reass_seed;
+
+static u32_t
+reass_rand(void)
+{
+  reass_seed = reass_seed * 1103515245 + 12345;
+  return reass_seed >> 16;
+}
+
+/* Pass a fragment carrying reass_data[start, start + len) to ip4_reass() */
+static struct pbuf *
+reass_fragment(u16_t ip_id, u16_t start, u16_t len, int last)
+{
+  struct pbuf *p;
+  struct ip_hdr *iphdr;
+
+  fail_unless(start + len <= sizeof(reass_data));
+  p = pbuf_alloc(PBUF_RAW, (u16_t)(len + IP_HLEN), PBUF_RAM);
+  fail_unless(p != NULL);
+  iphdr = (struct ip_hdr *)p->payload;
+  memset(iphdr, 0, IP_HLEN);
+  IPH_VHL_SET(iphdr, 4, IP_HLEN / 4);
+  IPH_LEN_SET(iphdr, lwip_htons(p->tot_len));
+  IPH_ID_SET(iphdr, lwip_htons(ip_id));
+  IPH_OFFSET_SET(iphdr, lwip_htons((u16_t)((start / 8) | (last ? 0 : IP_MF))));
+  IPH_TTL_SET(iphdr, 5);
+  IPH_PROTO_SET(iphdr, IP_PROTO_UDP);
+  IP4_ADDR(&iphdr->src, 192, 168, 0, 2);
+  IP4_ADDR(&iphdr->dest, 192, 168, 0, 1);
+  fail_unless(pbuf_take_at(p, &reass_data[start], len, IP_HLEN) == ERR_OK);
+  return ip4_reass(p);
+}
+
+/* Check a reassembled datagram against reass_data and free it */
+static void
+reass_check_datagram(struct pbuf *p, u16_t len)
+{
+  fail_unless(p != NULL);
+  if (p != NULL) {
+    fail_unless(p->tot_len == len + IP_HLEN);
+    fail_unless(lwip_ntohs(IPH_LEN((struct ip_hdr *)p->payload)) == len + IP_HLEN);
+    fail_unless(IPH_OFFSET((struct ip_hdr *)p->payload) == 0);
+    fail_unless(pbuf_memcmp(p, IP_HLEN, reass_data, len) == 0);
+    pbuf_free(p);
+  }
+}
+
+static void
+reass_init_data(void)
+{
+  size_t i;
+  reass_seed = 0x1234;
+  for (i = 0; i < sizeof(reass_data); i++) {
+    reass_data[i] = (u8_t)reass_rand();
+  }
+}
+
 static err_t arpless_output(struct netif *netif, struct pbuf *p,
                             const ip4_addr_t *ipaddr) {
   LWIP_UNUSED_ARG(ipaddr);
@@ -267,6 +327,153 @@ START_TEST(test_ip4_reass)
 }
 END_TEST
 
+/* Duplicate, overlapping and inconsistent fragments are dropped without
+   disturbing the datagram */
+START_TEST(test_ip4_reass_dup_overlap)
+{
+  const u16_t ip_id = 129;
+  u16_t drop;
+  LWIP_UNUSED_ARG(_i);
+
+  reass_init_data();
+  drop = lwip_stats.ip_frag.drop;
+
+  fail_unless(reass_fragment(ip_id, 1600, 800, 0) == NULL);
+  fail_unless(reass_fragment(ip_id, 3200, 700, 1) == NULL);
+  /* duplicate */
+  fail_unless(reass_fragment(ip_id, 1600, 800, 0) == NULL);
+  /* overlaps the end of 1600..2400 */
+  fail_unless(reass_fragment(ip_id, 2000, 800, 0) == NULL);
+  /* overlaps the start of 1600..2400 */
+  fail_unless(reass_fragment(ip_id, 1200, 800, 0) == NULL);
+  /* last fragment with a different length */
+  fail_unless(reass_fragment(ip_id, 3200, 600, 1) == NULL);
+  /* beyond the last fragment */
+  fail_unless(reass_fragment(ip_id, 4000, 80, 0) == NULL);
+  /* not a multiple of 8 bytes without being the last one */
+  fail_unless(reass_fragment(ip_id, 0, 801, 0) == NULL);
+  fail_unless(lwip_stats.ip_frag.drop == drop + 6);
+
+  fail_unless(reass_fragment(ip_id, 0, 800, 0) == NULL);
+  fail_unless(reass_fragment(ip_id, 2400, 800, 0) == NULL);
+  reass_check_datagram(reass_fragment(ip_id, 800, 800, 0), 3900);
+  fail_unless(lwip_stats.ip_frag.drop == drop + 6);
+}
+END_TEST
+
+/* Random fragment sizes and orders, with duplicates and overlapping fragments
+   sent in between */
+START_TEST(test_ip4_reass_fuzz)
+{
+  u16_t ip_id = 1000;
+  int iteration;
+  LWIP_UNUSED_ARG(_i);
+
+  reass_init_data();
+
+  for (iteration = 0; iteration < 2000; iteration++) {
+    u16_t order[IP_REASS_MAX_PBUFS];
+    u16_t nfrags, frag_len, datagram_len, drop, extra = 0;
+    u16_t i, k;
+
+    nfrags = (u16_t)(2 + reass_rand() % (IP_REASS_MAX_PBUFS - 1));
+    frag_len = (u16_t)(8 * (1 + reass_rand() % (sizeof(reass_data) / 8 / nfrags)));
+    datagram_len = (u16_t)(frag_len * (nfrags - 1) + 1 + reass_rand() % frag_len);
+    for (i = 0; i < nfrags; i++) {
+      order[i] = i;
+    }
+    switch (iteration % 4) {
+      case 0:
+        /* in order */
+        break;
+      case 1:
+        /* reverse */
+        for (i = 0; i < nfrags; i++) {
+          order[i] = (u16_t)(nfrags - 1 - i);
+        }
+        break;
+      default:
+        for (i = (u16_t)(nfrags - 1); i > 0; i--) {
+          u16_t j = (u16_t)(reass_rand() % (i + 1));
+          u16_t tmp = order[i];
+          order[i] = order[j];
+          order[j] = tmp;
+        }
+        break;
+    }
+
+    drop = lwip_stats.ip_frag.drop;
+    for (k = 0; k < nfrags; k++) {
+      u16_t idx = order[k];
+      u16_t start = (u16_t)(idx * frag_len);
+      u16_t len = (idx == nfrags - 1) ? (u16_t)(datagram_len - start) : frag_len;
+      struct pbuf *p = reass_fragment(ip_id, start, len, idx == nfrags - 1);
+
+      if (k == nfrags - 1) {
+        reass_check_datagram(p, datagram_len);
+        break;
+      }
+      fail_unless(p == NULL);
+
+      /* some more fragments while the datagram is incomplete */
+      idx = order[reass_rand() % (k + 1)];
+      start = (u16_t)(idx * frag_len);
+      len = (idx == nfrags - 1) ? (u16_t)(datagram_len - start) : frag_len;
+      switch (reass_rand() % 4) {
+        case 0:
+          /* duplicate of a fragment received */
+          fail_unless(reass_fragment(ip_id, start, len, idx == nfrags - 1) == NULL);
+          extra++;
+          break;
+        case 1:
+          /* overlapping a fragment received */
+          start = (u16_t)(start + 8 * (reass_rand() % ((len + 7) / 8)));
+          len = (u16_t)(8 * (1 + reass_rand() % (frag_len / 8)));
+          if (start + len <= sizeof(reass_data)) {
+            fail_unless(reass_fragment(ip_id, start, len, 0) == NULL);
+            extra++;
+          }
+          break;
+        default:
+          break;
+      }
+    }
+    fail_unless(lwip_stats.ip_frag.drop == drop + extra);
+    ip_id++;
+  }
+}
+END_TEST
+
+/* An incomplete datagram times out and sends ICMP time exceeded if its first
+   fragment was received */
+START_TEST(test_ip4_reass_timeout)
+{
+  const u16_t ip_id = 130;
+  u16_t fails;
+  int i;
+  LWIP_UNUSED_ARG(_i);
+
+  reass_init_data();
+  test_netif_add();
+  test_netif.output = arpless_output;
+  linkoutput_ctr = 0;
+  fails = (u16_t)lwip_stats.mib2.ipreasmfails;
+
+  fail_unless(reass_fragment(ip_id, 1600, 800, 1) == NULL);
+  fail_unless(reass_fragment(ip_id, 0, 800, 0) == NULL);
+  for (i = 0; i <= IP_REASS_MAXAGE; i++) {
+    fail_unless(linkoutput_ctr == 0);
+    ip_reass_tmr();
+  }
+  fail_unless(lwip_stats.mib2.ipreasmfails == fails + 1u);
+  fail_unless(linkoutput_ctr == 1);
+  fail_unless(linkoutput_pkt_len >= IP_HLEN + 2);
+  fail_unless(linkoutput_pkt[IP_HLEN] == ICMP_TE);
+  fail_unless(linkoutput_pkt[IP_HLEN + 1] == ICMP_TE_FRAG);
+  test_netif_remove();
+}
+END_TEST
+
 /* packets to 127.0.0.1 shall not be sent out to netif_default */
 START_TEST(test_127_0_0_1)
 {
@@ -369,6 +576,9 @@ ip4_suite(void)
   testfunc tests[] = {
     TESTFUNC(test_ip4_frag),
     TESTFUNC(test_ip4_reass),
+    TESTFUNC(test_ip4_reass_dup_overlap),
+    TESTFUNC(test_ip4_reass_fuzz),
+    TESTFUNC(test_ip4_reass_timeout),
     TESTFUNC(test_127_0_0_1),
     TESTFUNC(test_ip4addr_aton),
     TESTFUNC(test_ip4_icmp_replylen_short),
@@ -36,6 +36,8 @@
 #include "tcp/test_tcp.h"
 #include "tcp/test_tcp_oos.h"
 #include "tcp/test_tcp_state.h"
+#include "tcp/test_tcp_demux.h"
+#include "core/test_chksum.h"
 #include "core/test_def.h"
 #include "core/test_dns.h"
 #include "core/test_mem.h"
@@ -49,6 +51,9 @@
 #include "mqtt/test_mqtt.h"
 #include "api/test_sockets.h"
 #include "ppp/test_pppos.h"
+#include "port/test_ethernetif_rx_batch.h"
+#include "port/test_ethernetif_zerocopy.h"
+#include "port/test_lwip_perf.h"
 
 #include "lwip/init.h"
 #if !NO_SYS
@@ -118,6 +123,8 @@ int main(void)
     tcp_suite,
     tcp_oos_suite,
     tcp_state_suite,
+    tcp_demux_suite,
+    chksum_suite,
     def_suite,
     dns_suite,
     mem_suite,
@@ -129,7 +136,10 @@ int main(void)
     dhcp6_suite,
     mdns_suite,
     mqtt_suite,
-    sockets_suite
+    sockets_suite,
+    ethernetif_rx_batch_suite,
+    ethernetif_zerocopy_suite,
+    lwip_perf_suite
 #if PPP_SUPPORT && PPPOS_SUPPORT
     , pppos_suite
 #endif /* PPP_SUPPORT && PPPOS_SUPPORT */
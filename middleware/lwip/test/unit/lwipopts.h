@@ -33,11 +33,17 @@
 #ifndef LWIP_HDR_LWIPOPTS_H
 #define LWIP_HDR_LWIPOPTS_H
 
+/* Additional option set from test_configs, e.g. the hashed lookups */
+#ifdef LWIP_UNITTESTS_CONFIG
+#include LWIP_UNITTESTS_CONFIG
+#endif
+
 #define LWIP_TESTMODE                   1
 
 #define LWIP_IPV6                       1
 
 #define LWIP_CHECKSUM_ON_COPY           1
+#define LWIP_CHKSUM_ALGORITHM           4
 #define TCP_CHECKSUM_ON_COPY_SANITY_CHECK 1
 #define TCP_CHECKSUM_ON_COPY_SANITY_CHECK_FAIL(printfmsg) LWIP_ASSERT("TCP_CHECKSUM_ON_COPY_SANITY_CHECK_FAIL", 0)
 
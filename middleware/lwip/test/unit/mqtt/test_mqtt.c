@@ -9,12 +9,15 @@ const ip_addr_t test_mqtt_local_ip = IPADDR4_INIT_BYTES(192, 168, 1, 1);
 const ip_addr_t test_mqtt_remote_ip = IPADDR4_INIT_BYTES(192, 168, 1, 2);
 const ip_addr_t test_mqtt_netmask = IPADDR4_INIT_BYTES(255, 255, 255, 0);
 
+static int test_mqtt_tx_frames;
+
 static err_t test_mqtt_netif_output(struct netif *netif, struct pbuf *p,
        const ip4_addr_t *ipaddr)
 {
   LWIP_UNUSED_ARG(netif);
   LWIP_UNUSED_ARG(ipaddr);
   LWIP_UNUSED_ARG(p);
+  test_mqtt_tx_frames++;
   return ERR_OK;
 }
 
@@ -106,10 +109,204 @@ START_TEST(basic_connect)
 }
 END_TEST
 
+static const struct mqtt_connect_client_info_t test_mqtt_client_info = {
+  "dumm",
+  NULL, NULL,
+  10,
+  NULL, NULL, 0, 0, 0
+};
+
+/* Feed data into the client as if received from the server */
+static void
+test_mqtt_rx(mqtt_client_t *client, unsigned char *data, u16_t len)
+{
+  struct pbuf *p = pbuf_alloc(PBUF_RAW, len, PBUF_REF);
+  fail_unless(p != NULL);
+  p->payload = data;
+  /* since we hack the rx path, we have to hack the rx window, too: */
+  client->conn->rcv_wnd -= p->tot_len;
+  if (client->conn->recv(client->conn->callback_arg, client->conn, p, ERR_OK) != ERR_OK) {
+    pbuf_free(p);
+  }
+}
+
+/* Connect a new client, faking TCP connect and CONNACK */
+static mqtt_client_t *
+test_mqtt_connect(struct netif *netif)
+{
+  mqtt_client_t *client;
+  unsigned char connack[] = {0x20, 0x02, 0x00, 0x00};
+
+  test_mqtt_init_netif(netif, &test_mqtt_local_ip, &test_mqtt_netmask);
+  client = mqtt_client_new();
+  fail_unless(client != NULL);
+  fail_unless(mqtt_client_connect(client, &test_mqtt_remote_ip, 1234, test_mqtt_connection_cb, NULL,
+                                  &test_mqtt_client_info) == ERR_OK);
+  client->conn->connected(client->conn->callback_arg, client->conn, ERR_OK);
+  test_mqtt_rx(client, connack, sizeof(connack));
+  fail_unless(mqtt_client_is_connected(client));
+  return client;
+}
+
+static int test_mqtt_req_done[MQTT_REQ_MAX_IN_FLIGHT + 1];
+static int test_mqtt_req_order;
+
+static void
+test_mqtt_request_cb(void *arg, err_t err)
+{
+  fail_unless(err == ERR_OK);
+  test_mqtt_req_done[(size_t)arg] = ++test_mqtt_req_order;
+}
+
+START_TEST(publish_out_of_order_ack)
+{
+  mqtt_client_t *client;
+  struct netif netif;
+  u16_t pkt_id[MQTT_REQ_MAX_IN_FLIGHT];
+  unsigned char puback[] = {0x40, 0x02, 0x00, 0x00};
+  size_t i;
+  LWIP_UNUSED_ARG(_i);
+
+  memset(test_mqtt_req_done, 0, sizeof(test_mqtt_req_done));
+  test_mqtt_req_order = 0;
+  client = test_mqtt_connect(&netif);
+
+  /* fill the in-flight window with QoS 1 publishes */
+  for (i = 0; i < MQTT_REQ_MAX_IN_FLIGHT; i++) {
+    fail_unless(mqtt_publish(client, "t", "x", 1, 1, 0, test_mqtt_request_cb, (void *)i) == ERR_OK);
+    pkt_id[i] = client->pkt_id_seq;
+  }
+  fail_unless(mqtt_publish(client, "t", "x", 1, 1, 0, test_mqtt_request_cb, NULL) == ERR_MEM);
+
+  /* acknowledge in reverse order, an unknown packet identifier is ignored */
+  puback[3] = 0xff;
+  test_mqtt_rx(client, puback, sizeof(puback));
+  for (i = MQTT_REQ_MAX_IN_FLIGHT; i > 0; i--) {
+    puback[2] = (unsigned char)(pkt_id[i - 1] >> 8);
+    puback[3] = (unsigned char)pkt_id[i - 1];
+    test_mqtt_rx(client, puback, sizeof(puback));
+    fail_unless(test_mqtt_req_done[i - 1] == (int)(MQTT_REQ_MAX_IN_FLIGHT - i + 1));
+  }
+  /* a duplicate acknowledge finds no request */
+  test_mqtt_rx(client, puback, sizeof(puback));
+  fail_unless(test_mqtt_req_order == MQTT_REQ_MAX_IN_FLIGHT);
+
+  /* the window is free again, with fresh packet identifiers */
+  fail_unless(mqtt_publish(client, "t", "x", 1, 1, 0, test_mqtt_request_cb, NULL) == ERR_OK);
+  for (i = 0; i < MQTT_REQ_MAX_IN_FLIGHT; i++) {
+    fail_unless(client->pkt_id_seq != pkt_id[i]);
+  }
+
+  mqtt_disconnect(client);
+  mem_free(client);
+}
+END_TEST
+
+START_TEST(publish_qos0_completes_on_ack)
+{
+  mqtt_client_t *client;
+  struct netif netif;
+  LWIP_UNUSED_ARG(_i);
+
+  memset(test_mqtt_req_done, 0, sizeof(test_mqtt_req_done));
+  test_mqtt_req_order = 0;
+  client = test_mqtt_connect(&netif);
+
+  fail_unless(mqtt_publish(client, "t", "xyz", 3, 0, 0, test_mqtt_request_cb, (void *)0) == ERR_OK);
+  fail_unless(mqtt_publish(client, "t", "xyz", 3, 0, 0, test_mqtt_request_cb, (void *)1) == ERR_OK);
+  fail_unless(client->tx_written > 0);
+  /* the first publish is complete only when TCP acknowledged all of it */
+  client->conn->sent(client->conn->callback_arg, client->conn, (u16_t)(client->tx_written - 9));
+  fail_unless(test_mqtt_req_order == 0);
+  client->conn->sent(client->conn->callback_arg, client->conn, 1);
+  fail_unless(test_mqtt_req_order == 1);
+  fail_unless(test_mqtt_req_done[0] == 1);
+  client->conn->sent(client->conn->callback_arg, client->conn, 8);
+  fail_unless(test_mqtt_req_done[1] == 2);
+
+  mqtt_disconnect(client);
+  mem_free(client);
+}
+END_TEST
+
+START_TEST(publish_pbuf_nocopy)
+{
+  mqtt_client_t *client;
+  struct netif netif;
+  struct pbuf *p;
+  LWIP_UNUSED_ARG(_i);
+
+  memset(test_mqtt_req_done, 0, sizeof(test_mqtt_req_done));
+  test_mqtt_req_order = 0;
+  client = test_mqtt_connect(&netif);
+  p = pbuf_alloc(PBUF_RAW, 1000, PBUF_RAM);
+  fail_unless(p != NULL);
+  memset(p->payload, 0x55, p->len);
+
+  /* larger than the ring-buffer, so the payload can only be referenced */
+  fail_unless(p->tot_len > MQTT_OUTPUT_RINGBUF_SIZE);
+  fail_unless(mqtt_publish_pbuf(client, "t", p, 0, 0, test_mqtt_request_cb, (void *)0) == ERR_OK);
+  fail_unless(p->ref == 2);
+  fail_unless(client->output.get == client->output.put);
+  client->conn->sent(client->conn->callback_arg, client->conn, (u16_t)client->tx_written);
+  fail_unless(p->ref == 1);
+  fail_unless(test_mqtt_req_done[0] == 1);
+
+  /* disconnecting drops the reference to unacknowledged payloads */
+  fail_unless(mqtt_publish_pbuf(client, "t", p, 1, 0, test_mqtt_request_cb, (void *)1) == ERR_OK);
+  fail_unless(p->ref == 2);
+  mqtt_disconnect(client);
+  fail_unless(p->ref == 1);
+  fail_unless(test_mqtt_req_done[1] == 0);
+
+  pbuf_free(p);
+  mem_free(client);
+}
+END_TEST
+
+START_TEST(publish_batch)
+{
+  mqtt_client_t *client;
+  struct netif netif;
+  int i;
+  LWIP_UNUSED_ARG(_i);
+
+  client = test_mqtt_connect(&netif);
+  /* let TCP send, the connection never really came up */
+  client->conn->state = ESTABLISHED;
+  client->conn->cwnd = client->conn->snd_wnd;
+  tcp_nagle_disable(client->conn);
+  test_mqtt_tx_frames = 0;
+
+  /* messages of a batch are queued to TCP, but only sent at the end, in one segment */
+  mqtt_batch_begin(client);
+  for (i = 0; i < 3; i++) {
+    fail_unless(mqtt_publish(client, "t", "xyz", 3, 0, 0, NULL, NULL) == ERR_OK);
+  }
+  fail_unless(client->output.get == client->output.put);
+  fail_unless(test_mqtt_tx_frames == 0);
+  mqtt_batch_end(client);
+  fail_unless(test_mqtt_tx_frames == 1);
+
+  /* without a batch every message is sent right away */
+  fail_unless(mqtt_publish(client, "t", "xyz", 3, 0, 0, NULL, NULL) == ERR_OK);
+  fail_unless(test_mqtt_tx_frames == 2);
+
+  /* close without FIN handshake */
+  client->conn->state = SYN_SENT;
+  mqtt_disconnect(client);
+  mem_free(client);
+}
+END_TEST
+
 Suite* mqtt_suite(void)
 {
   testfunc tests[] = {
     TESTFUNC(basic_connect),
+    TESTFUNC(publish_out_of_order_ack),
+    TESTFUNC(publish_qos0_completes_on_ack),
+    TESTFUNC(publish_pbuf_nocopy),
+    TESTFUNC(publish_batch),
   };
   return create_suite("MQTT", tests, sizeof(tests)/sizeof(testfunc), mqtt_setup, mqtt_teardown);
 }
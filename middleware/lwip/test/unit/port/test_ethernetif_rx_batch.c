@@ -0,0 +1,316 @@
+#include "test_ethernetif_rx_batch.h"
+
+#include "lwip/pbuf.h"
+#include "lwip/stats.h"
+#include "lwip/etharp.h"
+#include "netif/ethernet.h"
+
+#include "../../../port/ethernetif_rx_batch.h"
+
+#include <string.h>
+#include <time.h>
+
+#if !LWIP_STATS || !MEM_STATS || !MEMP_STATS
+#error "This tests needs MEM- and MEMP-statistics enabled"
+#endif
+
+/* Mock of the ENET RX descriptor ring: the "MAC" fills descriptors with
+ * frames and raises the RX interrupt unless it is masked, the RX task
+ * drains it with ethernetif_rx_batch_poll() and unmasks the interrupt
+ * once the ring is empty. */
+
+#define MOCK_RXBD_NUM 64
+#define MOCK_FRAME_LEN 60
+
+struct mock_rx_ring {
+  struct pbuf *bd[MOCK_RXBD_NUM];
+  u16_t produce;
+  u16_t consume;
+  u16_t used;
+  u8_t int_masked;
+  u16_t bad;        /* frames at the head of the ring the driver drops */
+  u32_t dropped;
+  u32_t fetched;
+};
+
+static struct mock_rx_ring ring;
+static ethernetif_rx_batch_t rb;
+static struct netif test_netif;
+static const struct eth_addr test_mac = {{0x00, 0x01, 0x02, 0x03, 0x04, 0x05}};
+
+static u32_t
+mock_clock(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (u32_t)ts.tv_sec * 1000000000U + (u32_t)ts.tv_nsec;
+}
+
+static err_t
+test_netif_init(struct netif *netif)
+{
+  netif->mtu = 1500;
+  netif->flags = NETIF_FLAG_BROADCAST | NETIF_FLAG_ETHARP | NETIF_FLAG_LINK_UP;
+  netif->hwaddr_len = ETH_HWADDR_LEN;
+  SMEMCPY(netif->hwaddr, test_mac.addr, ETH_HWADDR_LEN);
+  return ERR_OK;
+}
+
+/* A frame for us with a local experimental ethertype, dropped by ethernet_input(). */
+static struct pbuf *
+make_frame(void)
+{
+  struct pbuf *p = pbuf_alloc(PBUF_RAW, MOCK_FRAME_LEN, PBUF_POOL);
+  struct eth_hdr *eth;
+
+  if (p == NULL) {
+    return NULL;
+  }
+  memset(p->payload, 0, p->len);
+  eth = (struct eth_hdr *)p->payload;
+  SMEMCPY(&eth->dest, &test_mac, sizeof(test_mac));
+  eth->type = PP_HTONS(0x88B5);
+  return p;
+}
+
+/* The MAC receives 'num' frames. */
+static void
+mock_rx_arrive(u16_t num)
+{
+  u16_t i;
+
+  for (i = 0; i < num; i++) {
+    if (ring.used == MOCK_RXBD_NUM) {
+      ring.dropped++;
+      continue;
+    }
+    ring.bd[ring.produce] = make_frame();
+    fail_unless(ring.bd[ring.produce] != NULL);
+    ring.produce = (u16_t)((ring.produce + 1) % MOCK_RXBD_NUM);
+    ring.used++;
+  }
+
+  /* RX interrupt, the callback masks it. */
+  if (!ring.int_masked && (ring.used > 0)) {
+    ring.int_masked = 1;
+    ethernetif_rx_batch_irq(&rb);
+  }
+}
+
+/* ENET_GetRxFrame() */
+static struct pbuf *
+mock_fetch(struct netif *netif, u8_t *dropped)
+{
+  struct pbuf *p;
+
+  fail_unless(netif == &test_netif);
+  fail_unless(ring.int_masked, "polled with RX interrupt unmasked");
+  if (ring.used == 0) {
+    return NULL;
+  }
+  p = ring.bd[ring.consume];
+  ring.consume = (u16_t)((ring.consume + 1) % MOCK_RXBD_NUM);
+  ring.used--;
+  if (ring.bad > 0) {
+    /* Receive error, or no buffer to replace the one of the descriptor */
+    ring.bad--;
+    pbuf_free(p);
+    *dropped = 1;
+    return NULL;
+  }
+  ring.fetched++;
+  return p;
+}
+
+/* What the RX task does per wakeup. */
+static u32_t
+mock_rx_task(u16_t budget)
+{
+  u32_t polls = 1;
+
+  while (ethernetif_rx_batch_poll(&rb, &test_netif, mock_fetch, budget) == budget) {
+    polls++;
+  }
+  ring.int_masked = 0;
+  return polls;
+}
+
+/* Setups/teardown functions */
+
+static void
+ethernetif_rx_batch_setup(void)
+{
+  ip4_addr_t addr;
+
+  memset(&ring, 0, sizeof(ring));
+  ethernetif_rx_batch_init(&rb, mock_clock);
+  ip4_addr_set_zero(&addr);
+  netif_add(&test_netif, &addr, &addr, &addr, NULL, test_netif_init, ethernet_input);
+  netif_set_up(&test_netif);
+  lwip_check_ensure_no_alloc(SKIP_POOL(MEMP_SYS_TIMEOUT));
+}
+
+static void
+ethernetif_rx_batch_teardown(void)
+{
+  netif_remove(&test_netif);
+  lwip_check_ensure_no_alloc(SKIP_POOL(MEMP_SYS_TIMEOUT));
+}
+
+/* Test functions */
+
+/** A burst is taken in budgets, one core lock per budget. */
+START_TEST(test_ethernetif_rx_batch_budget)
+{
+  ethernetif_rx_batch_stats_t stats;
+  LWIP_UNUSED_ARG(_i);
+
+  mock_rx_arrive(40);
+  fail_unless(ring.int_masked);
+  fail_unless(mock_rx_task(16) == 3);
+  fail_unless(!ring.int_masked);
+  fail_unless(ring.used == 0);
+
+  ethernetif_rx_batch_get_stats(&rb, &stats, 0);
+  fail_unless(stats.frames == 40);
+  fail_unless(stats.batches == 3);
+  fail_unless(stats.budgetExhausted == 2);
+  fail_unless(stats.maxBatch == 16);
+  fail_unless(stats.irqs == 1);
+  fail_unless(stats.inputErrors == 0);
+  fail_unless(stats.latencyCount == 1);
+  fail_unless(stats.latencyMin <= stats.latencyMax);
+}
+END_TEST
+
+/** A burst of exactly one budget ends with an empty poll, which is not
+ * a batch. */
+START_TEST(test_ethernetif_rx_batch_exact_budget)
+{
+  ethernetif_rx_batch_stats_t stats;
+  LWIP_UNUSED_ARG(_i);
+
+  mock_rx_arrive(16);
+  fail_unless(mock_rx_task(16) == 2);
+  ethernetif_rx_batch_get_stats(&rb, &stats, 1);
+  fail_unless(stats.frames == 16);
+  fail_unless(stats.batches == 1);
+  fail_unless(stats.budgetExhausted == 1);
+  /* Latency is taken when the ring is found empty. */
+  fail_unless(stats.latencyCount == 1);
+  fail_unless(rb.irqStampValid == 0);
+
+  ethernetif_rx_batch_get_stats(&rb, &stats, 0);
+  fail_unless(stats.frames == 0);
+  fail_unless(stats.latencyMin == 0xFFFFFFFFU);
+}
+END_TEST
+
+/** Frames arriving while the interrupt is masked raise no interrupt. */
+START_TEST(test_ethernetif_rx_batch_masked)
+{
+  ethernetif_rx_batch_stats_t stats;
+  LWIP_UNUSED_ARG(_i);
+
+  mock_rx_arrive(4);
+  mock_rx_arrive(4);
+  mock_rx_arrive(4);
+  mock_rx_task(ETH_RX_BATCH_BUDGET);
+  mock_rx_arrive(1);
+  mock_rx_task(ETH_RX_BATCH_BUDGET);
+
+  ethernetif_rx_batch_get_stats(&rb, &stats, 0);
+  fail_unless(stats.irqs == 2);
+  fail_unless(stats.frames == 13);
+  fail_unless(stats.batches == 2);
+  fail_unless(stats.latencyCount == 2);
+}
+END_TEST
+
+/** A frame dropped by the driver doesn't end the wakeup: the frames behind
+ * it are still taken, and the latency is taken once the ring is empty. */
+START_TEST(test_ethernetif_rx_batch_driver_drop)
+{
+  ethernetif_rx_batch_stats_t stats;
+  LWIP_UNUSED_ARG(_i);
+
+  mock_rx_arrive(6);
+  ring.bad = 2;
+  fail_unless(ethernetif_rx_batch_poll(&rb, &test_netif, mock_fetch, 4) == 4);
+  ethernetif_rx_batch_get_stats(&rb, &stats, 0);
+  fail_unless(stats.dropped == 2);
+  fail_unless(stats.frames == 2);
+  fail_unless(stats.latencyCount == 0);
+  fail_unless(rb.irqStampValid);
+
+  /* Only drops: a full budget, no batch */
+  ring.bad = 2;
+  fail_unless(ethernetif_rx_batch_poll(&rb, &test_netif, mock_fetch, 2) == 2);
+  ethernetif_rx_batch_get_stats(&rb, &stats, 0);
+  fail_unless(stats.dropped == 4);
+  fail_unless(stats.batches == 1);
+  fail_unless(stats.latencyCount == 0);
+
+  fail_unless(mock_rx_task(4) == 1);
+  ethernetif_rx_batch_get_stats(&rb, &stats, 0);
+  fail_unless(stats.frames == 2);
+  fail_unless(stats.latencyCount == 1);
+  fail_unless(ring.used == 0);
+}
+END_TEST
+
+/** The interrupt only counts into irqCount, never into the statistics the
+ * task resets, and a reset starts the count from the interrupts so far. */
+START_TEST(test_ethernetif_rx_batch_irq_count)
+{
+  ethernetif_rx_batch_stats_t stats;
+  LWIP_UNUSED_ARG(_i);
+
+  mock_rx_arrive(1);
+  fail_unless(rb.stats.irqs == 0);
+  ethernetif_rx_batch_get_stats(&rb, &stats, 1);
+  fail_unless(stats.irqs == 1);
+
+  /* Interrupts while the task still holds the wakeup */
+  ethernetif_rx_batch_irq(&rb);
+  ethernetif_rx_batch_irq(&rb);
+  fail_unless(rb.stats.irqs == 0);
+  ethernetif_rx_batch_get_stats(&rb, &stats, 0);
+  fail_unless(stats.irqs == 2);
+  mock_rx_task(ETH_RX_BATCH_BUDGET);
+  mock_rx_arrive(1);
+  ethernetif_rx_batch_get_stats(&rb, &stats, 1);
+  fail_unless(stats.irqs == 3);
+  ethernetif_rx_batch_get_stats(&rb, &stats, 0);
+  fail_unless(stats.irqs == 0);
+  mock_rx_task(ETH_RX_BATCH_BUDGET);
+}
+END_TEST
+
+/** The budget is capped at ETH_RX_BATCH_BUDGET. */
+START_TEST(test_ethernetif_rx_batch_budget_cap)
+{
+  LWIP_UNUSED_ARG(_i);
+
+  mock_rx_arrive(ETH_RX_BATCH_BUDGET + 1);
+  fail_unless(ethernetif_rx_batch_poll(&rb, &test_netif, mock_fetch, ETH_RX_BATCH_BUDGET * 2) == ETH_RX_BATCH_BUDGET);
+  fail_unless(ring.used == 1);
+  mock_rx_task(ETH_RX_BATCH_BUDGET);
+  fail_unless(ring.used == 0);
+}
+END_TEST
+
+/** Create the suite including all tests for this module */
+Suite *
+ethernetif_rx_batch_suite(void)
+{
+  testfunc tests[] = {
+    TESTFUNC(test_ethernetif_rx_batch_budget),
+    TESTFUNC(test_ethernetif_rx_batch_exact_budget),
+    TESTFUNC(test_ethernetif_rx_batch_masked),
+    TESTFUNC(test_ethernetif_rx_batch_driver_drop),
+    TESTFUNC(test_ethernetif_rx_batch_budget_cap),
+    TESTFUNC(test_ethernetif_rx_batch_irq_count)
+  };
+  return create_suite("ETHERNETIF_RX_BATCH", tests, sizeof(tests)/sizeof(testfunc), ethernetif_rx_batch_setup, ethernetif_rx_batch_teardown);
+}
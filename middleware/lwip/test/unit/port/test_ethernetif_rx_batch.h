@@ -0,0 +1,8 @@
+#ifndef LWIP_HDR_TEST_ETHERNETIF_RX_BATCH_H
+#define LWIP_HDR_TEST_ETHERNETIF_RX_BATCH_H
+
+#include "../lwip_check.h"
+
+Suite *ethernetif_rx_batch_suite(void);
+
+#endif
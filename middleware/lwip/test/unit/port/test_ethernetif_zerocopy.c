@@ -0,0 +1,310 @@
+#include "test_ethernetif_zerocopy.h"
+
+#include "lwip/pbuf.h"
+#include "lwip/stats.h"
+
+#include "../../../port/ethernetif_zerocopy.h"
+
+#include <string.h>
+
+#if !LWIP_STATS || !MEM_STATS || !MEMP_STATS
+#error "This tests needs MEM- and MEMP-statistics enabled"
+#endif
+
+/* Mock of the ENET TX descriptor ring as driven by ENET_StartTxFrame() and
+ * ENET_ReclaimTxDescriptor(): one descriptor per segment, the last one of a
+ * frame carries the frame context. */
+
+#define MOCK_TXBD_NUM 8
+#define MOCK_WIRE_SIZE 1600
+
+struct mock_txbd {
+  const u8_t *buffer;
+  u16_t length;
+  u8_t ready;
+  u8_t last;
+  struct pbuf *context;
+};
+
+struct mock_ring {
+  struct mock_txbd bd[MOCK_TXBD_NUM];
+  u16_t produce;
+  u16_t consume;
+  u16_t used;
+  u8_t wire[MOCK_WIRE_SIZE];
+  u16_t wire_len;
+  u32_t frames;
+  u32_t busy;
+};
+
+static struct mock_ring ring;
+static ethernetif_tx_zerocopy_t zc;
+
+/* ENET_StartTxFrame() */
+static err_t
+mock_start_tx_frame(const ethernetif_tx_seg_t *segs, u16_t segs_num, struct pbuf *context)
+{
+  u16_t i;
+
+  if (MOCK_TXBD_NUM - ring.used < segs_num) {
+    ring.busy++;
+    return ERR_BUF;
+  }
+  for (i = 0; i < segs_num; i++) {
+    struct mock_txbd *bd = &ring.bd[ring.produce];
+    bd->buffer = (const u8_t *)segs[i].buffer;
+    bd->length = segs[i].length;
+    bd->last = (u8_t)(i == segs_num - 1);
+    bd->context = bd->last ? context : NULL;
+    bd->ready = 1;
+    ring.produce = (u16_t)((ring.produce + 1) % MOCK_TXBD_NUM);
+    ring.used++;
+  }
+  return ERR_OK;
+}
+
+/* MAC DMA sends one frame, then the TX interrupt reclaims its descriptors.
+ * Returns the value of ethernetif_tx_zerocopy_complete() or -1 if idle. */
+static int
+mock_dma_step(void)
+{
+  int ret = -1;
+
+  ring.wire_len = 0;
+  while (ring.used > 0) {
+    struct mock_txbd *bd = &ring.bd[ring.consume];
+    fail_unless(bd->ready);
+    fail_unless(ring.wire_len + bd->length <= MOCK_WIRE_SIZE);
+    memcpy(&ring.wire[ring.wire_len], bd->buffer, bd->length);
+    ring.wire_len = (u16_t)(ring.wire_len + bd->length);
+    bd->ready = 0;
+    ring.consume = (u16_t)((ring.consume + 1) % MOCK_TXBD_NUM);
+    ring.used--;
+    if (bd->last) {
+      ring.frames++;
+      /* Frames of the copy path have no context, as in the driver. */
+      ret = (bd->context != NULL) ? ethernetif_tx_zerocopy_complete(&zc, bd->context) : 0;
+      break;
+    }
+  }
+  return ret;
+}
+
+/* What linkoutput does: map, hand to the ring, drop the reference on failure. */
+static err_t
+mock_linkoutput(struct pbuf *p)
+{
+  ethernetif_tx_seg_t segs[ETH_TX_ZEROCOPY_MAX_SEGS];
+  u16_t segs_num;
+  struct pbuf *frame;
+  err_t err;
+
+  frame = ethernetif_tx_zerocopy_prepare(&zc, p, segs, &segs_num);
+  if (frame == NULL) {
+    return ERR_MEM;
+  }
+  err = mock_start_tx_frame(segs, segs_num, frame);
+  if (err != ERR_OK) {
+    pbuf_free(frame);
+  }
+  return err;
+}
+
+/* A frame of 'num' pbufs of 'len' bytes each, filled with a counter. */
+static struct pbuf *
+make_chain(u16_t num, u16_t len, pbuf_type type)
+{
+  static u8_t refdata[MOCK_WIRE_SIZE];
+  struct pbuf *p = NULL;
+  u16_t i, j;
+
+  for (i = 0; i < num; i++) {
+    struct pbuf *q;
+    if (type == PBUF_REF) {
+      q = pbuf_alloc(PBUF_RAW, len, PBUF_REF);
+      fail_unless(q != NULL);
+      q->payload = &refdata[i * len];
+    } else {
+      q = pbuf_alloc(PBUF_RAW, len, type);
+      fail_unless(q != NULL);
+    }
+    for (j = 0; j < len; j++) {
+      ((u8_t *)q->payload)[j] = (u8_t)(i * len + j);
+    }
+    if (p == NULL) {
+      p = q;
+    } else {
+      pbuf_cat(p, q);
+    }
+  }
+  return p;
+}
+
+static void
+check_wire(const struct pbuf *p)
+{
+  u16_t i;
+
+  fail_unless(ring.wire_len == p->tot_len);
+  for (i = 0; i < ring.wire_len; i++) {
+    fail_unless(ring.wire[i] == (u8_t)i, "wire byte %d mismatch", i);
+  }
+}
+
+/* Setups/teardown functions */
+
+static void
+ethernetif_zerocopy_setup(void)
+{
+  memset(&ring, 0, sizeof(ring));
+  ethernetif_tx_zerocopy_init(&zc);
+  lwip_check_ensure_no_alloc(SKIP_POOL(MEMP_SYS_TIMEOUT));
+}
+
+static void
+ethernetif_zerocopy_teardown(void)
+{
+  lwip_check_ensure_no_alloc(SKIP_POOL(MEMP_SYS_TIMEOUT));
+}
+
+/* Test functions */
+
+/** A pbuf chain is handed to the descriptors as is, no byte is copied. */
+START_TEST(test_ethernetif_zerocopy_chain)
+{
+  struct pbuf *p, *q;
+  u16_t i;
+  LWIP_UNUSED_ARG(_i);
+
+  p = make_chain(3, 200, PBUF_RAM);
+  fail_unless(mock_linkoutput(p) == ERR_OK);
+  fail_unless(zc.framesZeroCopy == 1);
+  fail_unless(zc.framesCopied == 0);
+  fail_unless(ring.used == 3);
+
+  for (q = p, i = 0; q != NULL; q = q->next, i++) {
+    fail_unless(ring.bd[i].buffer == q->payload);
+    fail_unless(ring.bd[i].length == q->len);
+  }
+  fail_unless(ring.bd[2].last);
+  fail_unless(ring.bd[2].context == p);
+
+  fail_unless(mock_dma_step() == 1);
+  check_wire(p);
+
+  pbuf_free(p);
+  fail_unless(ethernetif_tx_zerocopy_reclaim(&zc) == 1);
+}
+END_TEST
+
+/** The driver reference keeps the frame alive until reclaim. */
+START_TEST(test_ethernetif_zerocopy_ref_held)
+{
+  struct pbuf *p;
+  LWIP_UNUSED_ARG(_i);
+
+  p = make_chain(1, 100, PBUF_RAM);
+  fail_unless(mock_linkoutput(p) == ERR_OK);
+  fail_unless(p->ref == 2);
+
+  /* The stack is done with it, the MAC is not. */
+  pbuf_free(p);
+  fail_unless(p->ref == 1);
+  fail_unless(MEMP_STATS_GET(used, MEMP_PBUF) + lwip_stats.mem.used > 0);
+
+  fail_unless(mock_dma_step() == 1);
+  check_wire(p);
+  fail_unless(zc.reclaimPending == 1);
+
+  fail_unless(ethernetif_tx_zerocopy_reclaim(&zc) == 1);
+  fail_unless(zc.reclaimPending == 0);
+  fail_unless(ethernetif_tx_zerocopy_reclaim(&zc) == 0);
+}
+END_TEST
+
+/** Frames completing while a reclaim is pending request no second one. */
+START_TEST(test_ethernetif_zerocopy_reclaim_batch)
+{
+  struct pbuf *p[4];
+  int i;
+  LWIP_UNUSED_ARG(_i);
+
+  for (i = 0; i < 4; i++) {
+    p[i] = make_chain(1, 64, PBUF_RAM);
+    fail_unless(mock_linkoutput(p[i]) == ERR_OK);
+    pbuf_free(p[i]);
+  }
+  fail_unless(mock_dma_step() == 1);
+  fail_unless(mock_dma_step() == 0);
+  fail_unless(mock_dma_step() == 0);
+  fail_unless(ethernetif_tx_zerocopy_reclaim(&zc) == 3);
+  fail_unless(mock_dma_step() == 1);
+  fail_unless(ethernetif_tx_zerocopy_reclaim(&zc) == 1);
+  fail_unless(mock_dma_step() == -1);
+}
+END_TEST
+
+/** PBUF_REF data and chains longer than the segment limit are copied. */
+START_TEST(test_ethernetif_zerocopy_fallback_copy)
+{
+  struct pbuf *p;
+  LWIP_UNUSED_ARG(_i);
+
+  p = make_chain(2, 100, PBUF_REF);
+  fail_unless(mock_linkoutput(p) == ERR_OK);
+  fail_unless(zc.framesCopied == 1);
+  fail_unless(ring.used == 1);
+  fail_unless(ring.bd[0].context != p);
+  fail_unless(p->ref == 1);
+  fail_unless(mock_dma_step() == 1);
+  check_wire(p);
+  pbuf_free(p);
+  fail_unless(ethernetif_tx_zerocopy_reclaim(&zc) == 1);
+
+  p = make_chain(ETH_TX_ZEROCOPY_MAX_SEGS + 1, 60, PBUF_RAM);
+  fail_unless(mock_linkoutput(p) == ERR_OK);
+  fail_unless(zc.framesCopied == 2);
+  fail_unless(zc.framesZeroCopy == 0);
+  fail_unless(ring.used == 1);
+  fail_unless(mock_dma_step() == 1);
+  check_wire(p);
+  pbuf_free(p);
+  fail_unless(ethernetif_tx_zerocopy_reclaim(&zc) == 1);
+}
+END_TEST
+
+/** A full ring drops the driver reference again. */
+START_TEST(test_ethernetif_zerocopy_ring_busy)
+{
+  struct pbuf *p, *q;
+  LWIP_UNUSED_ARG(_i);
+
+  p = make_chain(ETH_TX_ZEROCOPY_MAX_SEGS, 100, PBUF_RAM);
+  q = make_chain(ETH_TX_ZEROCOPY_MAX_SEGS, 100, PBUF_RAM);
+  fail_unless(mock_linkoutput(p) == ERR_OK);
+  fail_unless(mock_linkoutput(q) == ERR_OK);
+  fail_unless(mock_linkoutput(p) == ERR_BUF);
+  fail_unless(ring.busy == 1);
+  fail_unless(p->ref == 2);
+
+  fail_unless(mock_dma_step() == 1);
+  fail_unless(mock_dma_step() == 0);
+  pbuf_free(p);
+  pbuf_free(q);
+  fail_unless(ethernetif_tx_zerocopy_reclaim(&zc) == 2);
+}
+END_TEST
+
+/** Create the suite including all tests for this module */
+Suite *
+ethernetif_zerocopy_suite(void)
+{
+  testfunc tests[] = {
+    TESTFUNC(test_ethernetif_zerocopy_chain),
+    TESTFUNC(test_ethernetif_zerocopy_ref_held),
+    TESTFUNC(test_ethernetif_zerocopy_reclaim_batch),
+    TESTFUNC(test_ethernetif_zerocopy_fallback_copy),
+    TESTFUNC(test_ethernetif_zerocopy_ring_busy)
+  };
+  return create_suite("ETHERNETIF_ZEROCOPY", tests, sizeof(tests)/sizeof(testfunc), ethernetif_zerocopy_setup, ethernetif_zerocopy_teardown);
+}
@@ -0,0 +1,8 @@
+#ifndef LWIP_HDR_TEST_ETHERNETIF_ZEROCOPY_H
+#define LWIP_HDR_TEST_ETHERNETIF_ZEROCOPY_H
+
+#include "../lwip_check.h"
+
+Suite *ethernetif_zerocopy_suite(void);
+
+#endif
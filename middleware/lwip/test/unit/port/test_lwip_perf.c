@@ -0,0 +1,325 @@
+#include "test_lwip_perf.h"
+
+#include "lwip/pbuf.h"
+#include "lwip/stats.h"
+#include "lwip/udp.h"
+#include "lwip/ip4.h"
+#include "lwip/prot/ip4.h"
+
+#include "../../../port/lwip_perf.h"
+
+#include <string.h>
+
+#if LWIP_PERF /* built with test_configs/opt_hashed_perf.h */
+
+#if !LWIP_STATS || !MEMP_STATS
+#error "This tests needs MEMP-statistics enabled"
+#endif
+
+static u32_t mock_now;
+static struct netif test_netif;
+static struct pbuf *sent;
+static u32_t received;
+
+static u32_t
+mock_clock(void)
+{
+  return mock_now;
+}
+
+static err_t
+test_netif_output(struct netif *netif, struct pbuf *p, const ip4_addr_t *ipaddr)
+{
+  LWIP_UNUSED_ARG(netif);
+  LWIP_UNUSED_ARG(ipaddr);
+  fail_unless(sent == NULL);
+  sent = pbuf_clone(PBUF_RAW, PBUF_POOL, p);
+  fail_unless(sent != NULL);
+  return ERR_OK;
+}
+
+static err_t
+test_netif_init(struct netif *netif)
+{
+  netif->mtu = 1500;
+  netif->output = test_netif_output;
+  netif->flags = NETIF_FLAG_LINK_UP;
+  return ERR_OK;
+}
+
+static void
+test_udp_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *addr, u16_t port)
+{
+  LWIP_UNUSED_ARG(arg);
+  LWIP_UNUSED_ARG(pcb);
+  LWIP_UNUSED_ARG(addr);
+  LWIP_UNUSED_ARG(port);
+  received++;
+  pbuf_free(p);
+}
+
+static u32_t
+hist_count(u8_t point)
+{
+  lwip_perf_hist_t hist;
+  lwip_perf_get_hist(point, &hist, 0);
+  return hist.count;
+}
+
+/* Setups/teardown functions */
+
+static void
+lwip_perf_setup(void)
+{
+  mock_now = 1000;
+  sent = NULL;
+  received = 0;
+  lwip_perf_init(mock_clock, 1, 0);
+  lwip_check_ensure_no_alloc(SKIP_POOL(MEMP_SYS_TIMEOUT));
+}
+
+static void
+lwip_perf_teardown(void)
+{
+  if (sent != NULL) {
+    pbuf_free(sent);
+    sent = NULL;
+  }
+  /* the other suites run with the probes stopped */
+  lwip_perf_init(NULL, 1, 0);
+  lwip_check_ensure_no_alloc(SKIP_POOL(MEMP_SYS_TIMEOUT));
+}
+
+/* Test functions */
+
+/** The RX path is timed from the driver handing the frame over. */
+START_TEST(test_lwip_perf_hist)
+{
+  lwip_perf_hist_t hist;
+  struct pbuf *p;
+  LWIP_UNUSED_ARG(_i);
+
+  p = pbuf_alloc(PBUF_RAW, 64, PBUF_RAM);
+  fail_unless(p != NULL);
+  fail_unless(p->perf_stamp == 1000);
+
+  mock_now += 5;
+  PERF_PROBE(LWIP_PERF_NETIF_RX, p);
+  fail_unless(p->perf_stamp == 1005);
+  mock_now += 100;
+  PERF_PROBE(LWIP_PERF_IP4_INPUT, p);
+  mock_now += 200;
+  PERF_PROBE(LWIP_PERF_UDP_INPUT, p);
+  /* unknown points are ignored */
+  PERF_PROBE(LWIP_PERF_NUM, p);
+  pbuf_free(p);
+
+  lwip_perf_get_hist(LWIP_PERF_NETIF_RX, &hist, 0);
+  fail_unless(hist.count == 1);
+  fail_unless(hist.min == 5);
+  fail_unless(hist.bucket[3] == 1);
+
+  lwip_perf_get_hist(LWIP_PERF_IP4_INPUT, &hist, 1);
+  fail_unless(hist.count == 1);
+  fail_unless(hist.min == 100);
+  fail_unless(hist.max == 100);
+  fail_unless(hist.bucket[7] == 1);
+  fail_unless(lwip_perf_hist_percentile(&hist, 500) == 100);
+
+  lwip_perf_get_hist(LWIP_PERF_UDP_INPUT, &hist, 0);
+  fail_unless(hist.min == 300);
+  fail_unless(hist.bucket[9] == 1);
+
+  /* reset */
+  lwip_perf_get_hist(LWIP_PERF_IP4_INPUT, &hist, 0);
+  fail_unless(hist.count == 0);
+  fail_unless(hist.min == 0xFFFFFFFFU);
+  fail_unless(lwip_perf_hist_percentile(&hist, 500) == 0);
+  fail_unless(hist_count(LWIP_PERF_TCP_INPUT) == 0);
+
+  fail_unless(strcmp(lwip_perf_point_name(LWIP_PERF_SOCKET_RX), "socket-rx") == 0);
+  fail_unless(strcmp(lwip_perf_point_name(LWIP_PERF_NUM), "?") == 0);
+}
+END_TEST
+
+/** Percentiles come from the bucket bounds and do not exceed max. */
+START_TEST(test_lwip_perf_percentile)
+{
+  lwip_perf_hist_t hist;
+  struct pbuf *p;
+  int i;
+  LWIP_UNUSED_ARG(_i);
+
+  p = pbuf_alloc(PBUF_RAW, 64, PBUF_RAM);
+  fail_unless(p != NULL);
+  PERF_PROBE(LWIP_PERF_NETIF_RX, p);
+  for (i = 0; i < 98; i++) {
+    p->perf_stamp = mock_now - 10;
+    PERF_PROBE(LWIP_PERF_IP4_INPUT, p);
+  }
+  p->perf_stamp = mock_now - 5000;
+  PERF_PROBE(LWIP_PERF_IP4_INPUT, p);
+  p->perf_stamp = mock_now - 0x80000000U;
+  PERF_PROBE(LWIP_PERF_IP4_INPUT, p);
+  pbuf_free(p);
+
+  lwip_perf_get_hist(LWIP_PERF_IP4_INPUT, &hist, 0);
+  fail_unless(hist.count == 100);
+  fail_unless(hist.min == 10);
+  fail_unless(lwip_perf_hist_percentile(&hist, 500) == 15);
+  fail_unless(lwip_perf_hist_percentile(&hist, 980) == 15);
+  fail_unless(lwip_perf_hist_percentile(&hist, 990) == 8191);
+  /* beyond the last bucket */
+  fail_unless(hist.bucket[LWIP_PERF_HIST_BUCKETS - 1] == 1);
+  fail_unless(lwip_perf_hist_percentile(&hist, 1000) == 0x80000000U);
+}
+END_TEST
+
+/** pbuf pool use is sampled once per interval, oldest sample first. */
+START_TEST(test_lwip_perf_timeline)
+{
+  lwip_perf_pool_sample_t samples[LWIP_PERF_TIMELINE_LEN];
+  struct pbuf *p[3];
+  u16_t n, i;
+  LWIP_UNUSED_ARG(_i);
+
+  lwip_perf_init(mock_clock, 1, 100);
+  for (i = 0; i < 3; i++) {
+    p[i] = pbuf_alloc(PBUF_RAW, 64, PBUF_POOL);
+    fail_unless(p[i] != NULL);
+  }
+  mock_now += 50;
+  PERF_PROBE(LWIP_PERF_IP4_INPUT, p[0]);
+  fail_unless(lwip_perf_get_timeline(samples, LWIP_PERF_TIMELINE_LEN, 0) == 0);
+  mock_now += 50;
+  PERF_PROBE(LWIP_PERF_IP4_INPUT, p[0]);
+  pbuf_free(p[1]);
+  pbuf_free(p[2]);
+  mock_now += 100;
+  PERF_PROBE(LWIP_PERF_IP4_INPUT, p[0]);
+
+  n = lwip_perf_get_timeline(samples, LWIP_PERF_TIMELINE_LEN, 0);
+  fail_unless(n == 2);
+  fail_unless(samples[0].time == 1100);
+  fail_unless(samples[0].poolUsed == 3);
+  fail_unless(samples[0].poolPeak == 3);
+  fail_unless(samples[1].time == 1200);
+  fail_unless(samples[1].poolUsed == 1);
+  fail_unless(samples[1].poolPeak == 3);
+  fail_unless(samples[1].refUsed == 0);
+
+  /* the ring keeps the latest LWIP_PERF_TIMELINE_LEN samples */
+  for (i = 0; i < LWIP_PERF_TIMELINE_LEN + 5; i++) {
+    mock_now += 100;
+    PERF_PROBE(LWIP_PERF_IP4_INPUT, p[0]);
+  }
+  n = lwip_perf_get_timeline(samples, LWIP_PERF_TIMELINE_LEN, 1);
+  fail_unless(n == LWIP_PERF_TIMELINE_LEN);
+  fail_unless(samples[n - 1].time == mock_now);
+  for (i = 1; i < n; i++) {
+    fail_unless(samples[i].time == samples[i - 1].time + 100);
+  }
+  fail_unless(lwip_perf_get_timeline(samples, LWIP_PERF_TIMELINE_LEN, 0) == 0);
+  pbuf_free(p[0]);
+}
+END_TEST
+
+/** A UDP datagram passes the TX probes on the way out and the RX probes
+ * when it is fed back in with the addresses swapped. */
+START_TEST(test_lwip_perf_udp_path)
+{
+  ip4_addr_t addr, netmask, gw;
+  ip_addr_t dst;
+  struct udp_pcb *tx, *rx;
+  struct ip_hdr *iphdr;
+  ip4_addr_t tmp;
+  lwip_perf_hist_t hist;
+  struct pbuf *p;
+  LWIP_UNUSED_ARG(_i);
+
+  IP4_ADDR(&addr, 10, 0, 0, 1);
+  IP4_ADDR(&netmask, 255, 255, 255, 0);
+  ip4_addr_set_zero(&gw);
+  IP_ADDR4(&dst, 10, 0, 0, 2);
+  fail_unless(netif_add(&test_netif, &addr, &netmask, &gw, NULL, test_netif_init, ip4_input) != NULL);
+  netif_set_up(&test_netif);
+
+  tx = udp_new();
+  rx = udp_new();
+  fail_unless((tx != NULL) && (rx != NULL));
+  fail_unless(udp_bind(tx, IP4_ADDR_ANY, 1234) == ERR_OK);
+  fail_unless(udp_bind(rx, IP4_ADDR_ANY, 7) == ERR_OK);
+  udp_recv(rx, test_udp_recv, NULL);
+
+  p = pbuf_alloc(PBUF_TRANSPORT, 32, PBUF_RAM);
+  fail_unless(p != NULL);
+  memset(p->payload, 0x55, p->len);
+  mock_now += 20;
+  fail_unless(udp_sendto_if(tx, p, &dst, 7, &test_netif) == ERR_OK);
+  pbuf_free(p);
+  fail_unless(sent != NULL);
+
+  lwip_perf_get_hist(LWIP_PERF_UDP_OUTPUT, &hist, 0);
+  fail_unless(hist.count == 1);
+  fail_unless(hist.min == 20);
+  fail_unless(hist_count(LWIP_PERF_IP4_OUTPUT) == 1);
+  fail_unless(hist_count(LWIP_PERF_IP4_INPUT) == 0);
+
+  /* receive it: swapping the addresses keeps the checksums valid */
+  iphdr = (struct ip_hdr *)sent->payload;
+  ip4_addr_copy(tmp, iphdr->src);
+  ip4_addr_copy(iphdr->src, iphdr->dest);
+  ip4_addr_copy(iphdr->dest, tmp);
+  p = sent;
+  sent = NULL;
+  PERF_PROBE(LWIP_PERF_NETIF_RX, p);
+  mock_now += 50;
+  fail_unless(test_netif.input(p, &test_netif) == ERR_OK);
+  fail_unless(received == 1);
+
+  lwip_perf_get_hist(LWIP_PERF_IP4_INPUT, &hist, 0);
+  fail_unless(hist.count == 1);
+  fail_unless(hist.min == 50);
+  lwip_perf_get_hist(LWIP_PERF_UDP_INPUT, &hist, 0);
+  fail_unless(hist.count == 1);
+  fail_unless(hist.min == 50);
+  fail_unless(hist_count(LWIP_PERF_TCP_INPUT) == 0);
+  fail_unless(hist_count(LWIP_PERF_TCP_OUTPUT) == 0);
+  lwip_perf_print();
+
+  udp_remove(tx);
+  udp_remove(rx);
+  netif_remove(&test_netif);
+}
+END_TEST
+
+/** Create the suite including all tests for this module */
+Suite *
+lwip_perf_suite(void)
+{
+  testfunc tests[] = {
+    TESTFUNC(test_lwip_perf_hist),
+    TESTFUNC(test_lwip_perf_percentile),
+    TESTFUNC(test_lwip_perf_timeline),
+    TESTFUNC(test_lwip_perf_udp_path)
+  };
+  return create_suite("LWIP_PERF", tests, sizeof(tests)/sizeof(testfunc), lwip_perf_setup, lwip_perf_teardown);
+}
+
+#else /* LWIP_PERF */
+
+START_TEST(test_lwip_perf_dummy)
+{
+  LWIP_UNUSED_ARG(_i);
+}
+END_TEST
+
+Suite *
+lwip_perf_suite(void)
+{
+  testfunc tests[] = {
+    TESTFUNC(test_lwip_perf_dummy),
+  };
+  return create_suite("LWIP_PERF", tests, sizeof(tests)/sizeof(testfunc), NULL, NULL);
+}
+#endif /* LWIP_PERF */
@@ -0,0 +1,8 @@
+#ifndef LWIP_HDR_TEST_LWIP_PERF_H
+#define LWIP_HDR_TEST_LWIP_PERF_H
+
+#include "../lwip_check.h"
+
+Suite *lwip_perf_suite(void);
+
+#endif
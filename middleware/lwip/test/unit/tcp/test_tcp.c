@@ -378,6 +378,40 @@ START_TEST(test_tcp_active_abort)
 }
 END_TEST
 
+/** Check that freeing a TIME_WAIT pcb tells the application it is gone:
+ * a connection only shut down for tx still references it. */
+START_TEST(test_tcp_time_wait_abort)
+{
+  struct test_tcp_counters counters;
+  struct tcp_pcb* pcb;
+  LWIP_UNUSED_ARG(_i);
+
+  memset(&counters, 0, sizeof(counters));
+
+  /* killed to make room for a new pcb */
+  pcb = test_tcp_new_counters_pcb(&counters);
+  EXPECT_RET(pcb != NULL);
+  tcp_set_state(pcb, TIME_WAIT, &test_local_ip, &test_remote_ip, TEST_LOCAL_PORT, TEST_REMOTE_PORT);
+  EXPECT(MEMP_STATS_GET(used, MEMP_TCP_PCB) == 1);
+  tcp_abort(pcb);
+  EXPECT(MEMP_STATS_GET(used, MEMP_TCP_PCB) == 0);
+  EXPECT(counters.err_calls == 1);
+  EXPECT(counters.last_err == ERR_ABRT);
+
+  /* timed out after 2 * MSL */
+  memset(&counters, 0, sizeof(counters));
+  pcb = test_tcp_new_counters_pcb(&counters);
+  EXPECT_RET(pcb != NULL);
+  tcp_set_state(pcb, TIME_WAIT, &test_local_ip, &test_remote_ip, TEST_LOCAL_PORT, TEST_REMOTE_PORT);
+  pcb->tmr = tcp_ticks;
+  tcp_ticks += 2 * TCP_MSL / TCP_SLOW_INTERVAL + 1;
+  tcp_slowtmr();
+  EXPECT(MEMP_STATS_GET(used, MEMP_TCP_PCB) == 0);
+  EXPECT(counters.err_calls == 1);
+  EXPECT(counters.last_err == ERR_ABRT);
+}
+END_TEST
+
 /** Check that we handle malformed tcp headers, and discard the pbuf(s) */
 START_TEST(test_tcp_malformed_header)
 {
@@ -1680,6 +1714,7 @@ tcp_suite(void)
     TESTFUNC(test_tcp_recv_inseq_trim),
     TESTFUNC(test_tcp_passive_close),
     TESTFUNC(test_tcp_active_abort),
+    TESTFUNC(test_tcp_time_wait_abort),
     TESTFUNC(test_tcp_malformed_header),
     TESTFUNC(test_tcp_fast_retx_recover),
     TESTFUNC(test_tcp_fast_rexmit_wraparound),
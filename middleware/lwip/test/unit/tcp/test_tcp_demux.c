@@ -0,0 +1,155 @@
+#include "test_tcp_demux.h"
+
+#include "lwip/priv/tcp_priv.h"
+#include "lwip/stats.h"
+#include "tcp_helper.h"
+
+#include <string.h>
+
+#if !LWIP_STATS || !TCP_STATS || !MEMP_STATS
+#error "This tests needs TCP- and MEMP-statistics enabled"
+#endif
+
+/* number of connections used by the tests */
+#define DEMUX_NUM_PCBS     LWIP_MIN(MEMP_NUM_TCP_PCB, 32)
+
+static struct tcp_pcb *pcbs[MEMP_NUM_TCP_PCB];
+static struct test_tcp_counters counters[MEMP_NUM_TCP_PCB];
+
+/* Setups/teardown functions */
+static struct netif *old_netif_list;
+static struct netif *old_netif_default;
+
+static void
+tcp_demux_setup(void)
+{
+  old_netif_list = netif_list;
+  old_netif_default = netif_default;
+  netif_list = NULL;
+  netif_default = NULL;
+  tcp_remove_all();
+  memset(pcbs, 0, sizeof(pcbs));
+  memset(counters, 0, sizeof(counters));
+  lwip_check_ensure_no_alloc(SKIP_POOL(MEMP_SYS_TIMEOUT));
+}
+
+static void
+tcp_demux_teardown(void)
+{
+  netif_list = NULL;
+  netif_default = NULL;
+  tcp_remove_all();
+  netif_list = old_netif_list;
+  netif_default = old_netif_default;
+  lwip_check_ensure_no_alloc(SKIP_POOL(MEMP_SYS_TIMEOUT));
+}
+
+/* Connection i talks to 192.168.1.(2 + i % 4), port TEST_REMOTE_PORT + i, so
+ * that connections differ in remote address as well as in remote port. */
+static void
+demux_open(int num)
+{
+  int i;
+
+  for (i = 0; i < num; i++) {
+    ip_addr_t remote_ip;
+
+    IP_ADDR4(&remote_ip, 192, 168, 1, (u8_t)(2 + (i % 4)));
+    pcbs[i] = test_tcp_new_counters_pcb(&counters[i]);
+    EXPECT_RET(pcbs[i] != NULL);
+    tcp_set_state(pcbs[i], ESTABLISHED, &test_local_ip, &remote_ip,
+                  TEST_LOCAL_PORT, (u16_t)(TEST_REMOTE_PORT + i));
+  }
+}
+
+static void
+demux_input(int i, struct netif *netif)
+{
+  char data[] = {1, 2, 3, 4};
+  struct pbuf *p;
+
+  p = tcp_create_rx_segment(pcbs[i], data, sizeof(data), 0, 0, 0);
+  EXPECT_RET(p != NULL);
+  test_tcp_input(p, netif);
+}
+
+/* Test functions */
+
+/** Open many connections and check that every segment reaches its own pcb */
+START_TEST(test_tcp_demux_many)
+{
+  struct netif netif;
+  struct test_tcp_txcounters txcounters;
+  int i;
+  LWIP_UNUSED_ARG(_i);
+
+  test_tcp_init_netif(&netif, &txcounters, &test_local_ip, &test_netmask);
+  demux_open(DEMUX_NUM_PCBS);
+
+  /* feed in reverse order of registration, each pcb is hit exactly once */
+  for (i = DEMUX_NUM_PCBS - 1; i >= 0; i--) {
+    demux_input(i, &netif);
+  }
+  for (i = 0; i < DEMUX_NUM_PCBS; i++) {
+    EXPECT(counters[i].recv_calls == 1);
+    EXPECT(counters[i].recved_bytes == 4);
+    EXPECT(counters[i].err_calls == 0);
+  }
+  EXPECT(MEMP_STATS_GET(used, MEMP_TCP_PCB) == DEMUX_NUM_PCBS);
+}
+END_TEST
+
+/** Remove every other connection and check that lookups still find the
+ * remaining ones and no longer find the removed ones */
+START_TEST(test_tcp_demux_remove)
+{
+  struct netif netif;
+  struct test_tcp_txcounters txcounters;
+  int i;
+  LWIP_UNUSED_ARG(_i);
+
+  test_tcp_init_netif(&netif, &txcounters, &test_local_ip, &test_netmask);
+  demux_open(DEMUX_NUM_PCBS);
+
+  for (i = 0; i < DEMUX_NUM_PCBS; i += 2) {
+    tcp_abort(pcbs[i]);
+    EXPECT(counters[i].err_calls == 1);
+  }
+  txcounters.num_tx_calls = 0;
+
+  for (i = 1; i < DEMUX_NUM_PCBS; i += 2) {
+    demux_input(i, &netif);
+    EXPECT(counters[i].recv_calls == 1);
+  }
+  /* segments for removed connections are answered with RST only */
+  for (i = 0; i < DEMUX_NUM_PCBS; i += 2) {
+    char data[] = {1, 2, 3, 4};
+    ip_addr_t remote_ip, local_ip;
+    struct pbuf *p;
+    u32_t tx_calls = txcounters.num_tx_calls;
+
+    IP_ADDR4(&remote_ip, 192, 168, 1, (u8_t)(2 + (i % 4)));
+    ip_addr_copy(local_ip, test_local_ip);
+    p = tcp_create_segment(&remote_ip, &local_ip,
+                           (u16_t)(TEST_REMOTE_PORT + i), TEST_LOCAL_PORT,
+                           data, sizeof(data), 12345, 0, TCP_ACK);
+    EXPECT_RET(p != NULL);
+    test_tcp_input(p, &netif);
+    EXPECT(txcounters.num_tx_calls == tx_calls + 1);
+  }
+  for (i = 0; i < DEMUX_NUM_PCBS; i++) {
+    EXPECT(counters[i].recv_calls == (u32_t)(i & 1));
+  }
+}
+END_TEST
+
+/** Create the suite including all tests for this module */
+Suite *
+tcp_demux_suite(void)
+{
+  testfunc tests[] = {
+    TESTFUNC(test_tcp_demux_many),
+    TESTFUNC(test_tcp_demux_remove)
+  };
+  return create_suite("TCP_DEMUX", tests, sizeof(tests)/sizeof(testfunc), tcp_demux_setup, tcp_demux_teardown);
+}
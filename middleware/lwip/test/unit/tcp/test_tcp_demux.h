@@ -0,0 +1,8 @@
+#ifndef LWIP_HDR_TEST_TCP_DEMUX_H
+#define LWIP_HDR_TEST_TCP_DEMUX_H
+
+#include "../lwip_check.h"
+
+Suite *tcp_demux_suite(void);
+
+#endif
@@ -0,0 +1,23 @@
+/*
+ * Option set for the unit tests on top of test/unit/lwipopts.h, built with
+ * LWIP_UNITTESTS_CONFIG (see contrib/ports/unix/check). It only sets options
+ * lwipopts.h leaves at their opt.h defaults, so the default build keeps
+ * testing the default code paths.
+ */
+
+/* Hashed ARP cache and TCP PCB demux, with small tables so that hash chains
+ * with several entries are exercised */
+#define ETHARP_TABLE_HASH_SIZE          4
+#define TCP_PCB_HASH_SIZE               8
+/* the 32 connections of TCP_DEMUX */
+#define MEMP_NUM_TCP_PCB                32
+
+/* Packet path latency probes of port/lwip_perf.c. The unix port's arch/perf.h
+ * does not know them, so they are hooked up here. */
+#define LWIP_PERF                       1
+#define LWIP_PBUF_CUSTOM_DATA           u32_t perf_stamp;
+#define LWIP_PBUF_CUSTOM_DATA_INIT(p)   lwip_perf_pbuf_init(p)
+#define PERF_PROBE(point, p)            lwip_perf_probe((point), (p))
+struct pbuf;
+void lwip_perf_probe(unsigned char point, struct pbuf *p);
+void lwip_perf_pbuf_init(struct pbuf *p);
@@ -135,6 +135,12 @@ enum
 #endif
 /*!@brief SDMMC host dma descriptor buffer address align size */
 #define SDMMCHOST_DMA_DESCRIPTOR_BUFFER_ALIGN_SIZE (4U)
+/*!@brief SDMMC host dma descriptor size in words of the descriptor buffer */
+#define SDMMCHOST_DMA_DESCRIPTOR_WORDS (2U)
+/*!@brief SDMMC host maximum data length of one dma descriptor */
+#define SDMMCHOST_DMA_DESCRIPTOR_MAX_LENGTH                                                    \
+    (SDMMCHOST_DMA_MODE == kUSDHC_DmaModeAdma1 ? USDHC_ADMA1_DESCRIPTOR_MAX_LENGTH_PER_ENTRY : \
+                                                 USDHC_ADMA2_DESCRIPTOR_MAX_LENGTH_PER_ENTRY)
 /*!@brief tuning configuration */
 #define SDMMCHOST_STANDARD_TUNING_START            (10U) /*!< standard tuning start point */
 #define SDMMCHOST_TUINIG_STEP                      (2U)  /*!< standard tuning stBep */
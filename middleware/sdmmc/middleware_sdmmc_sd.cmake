@@ -5,6 +5,7 @@ message("${CMAKE_CURRENT_LIST_FILE} component is included.")
 
       target_sources(${MCUX_SDK_PROJECT_NAME} PRIVATE
           ${CMAKE_CURRENT_LIST_DIR}/sd/fsl_sd.c
+          ${CMAKE_CURRENT_LIST_DIR}/sd/fsl_sd_stream.c
         )
 
   
@@ -0,0 +1,484 @@
+/*
+ * Copyright 2026 NXP
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "fsl_sd_stream.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+/*! @brief Card idle timeout of a stream */
+#ifndef SD_STREAM_IDLE_TIMEOUT_MS
+#define SD_STREAM_IDLE_TIMEOUT_MS (600U)
+#endif
+/*! @brief DAT0 polling interval while the card is busy */
+#ifndef SD_STREAM_BUSY_POLL_US
+#define SD_STREAM_BUSY_POLL_US (10U)
+#endif
+/*! @brief Descriptor chains are only supported by the host with the scatter gather transfer */
+#if defined SDMMCHOST_ENABLE_CACHE_LINE_ALIGN_TRANSFER && SDMMCHOST_ENABLE_CACHE_LINE_ALIGN_TRANSFER
+#define SD_STREAM_QUEUE_BUFFERS SD_STREAM_MAX_BUFFERS
+#else
+#define SD_STREAM_QUEUE_BUFFERS (1U)
+#endif
+/*! @brief DMA descriptors of a buffer */
+#define SD_STREAM_DESCRIPTORS(size) \
+    (((size) + SDMMCHOST_DMA_DESCRIPTOR_MAX_LENGTH - 1U) / SDMMCHOST_DMA_DESCRIPTOR_MAX_LENGTH)
+
+/*******************************************************************************
+ * Prototypes
+ ******************************************************************************/
+/*!
+ * @brief Wait for the card to release DAT0.
+ *
+ * @param stream Stream state.
+ * @retval kStatus_SDMMC_PollingCardIdleFailed Card busy after SD_STREAM_IDLE_TIMEOUT_MS.
+ * @retval kStatus_Success Card not busy.
+ */
+static status_t SD_StreamWaitIdle(sd_stream_t *stream);
+
+/*!
+ * @brief Send a command without data.
+ *
+ * @param stream Stream state.
+ * @param index Command index.
+ * @param argument Command argument.
+ * @param responseType Command response type.
+ * @param response Response of the command.
+ * @retval kStatus_SDMMC_TransferFailed Command failed or the response has error flags.
+ * @retval kStatus_Success Operate successfully.
+ */
+static status_t SD_StreamSendCommand(
+    sd_stream_t *stream, uint32_t index, uint32_t argument, uint32_t responseType, uint32_t *response);
+
+/*!
+ * @brief Transfer the queued buffers.
+ *
+ * @param stream Stream state.
+ */
+static status_t SD_StreamTransfer(sd_stream_t *stream);
+
+/*!
+ * @brief Queue a buffer, transferring the queued buffers when enough blocks are queued.
+ *
+ * @param stream Stream state.
+ * @param buffer Buffer address.
+ * @param blockCount The number of blocks.
+ */
+static status_t SD_StreamQueue(sd_stream_t *stream, uint8_t *buffer, uint32_t blockCount);
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+static status_t SD_StreamWaitIdle(sd_stream_t *stream)
+{
+    uint32_t timeoutUs = SD_STREAM_IDLE_TIMEOUT_MS * 1000U;
+    uint32_t delayUs;
+
+    while (SDMMCHOST_IsCardBusy(stream->card->host))
+    {
+        delayUs = SDMMC_OSADelayUs(SD_STREAM_BUSY_POLL_US);
+        if (delayUs >= timeoutUs)
+        {
+            return kStatus_SDMMC_PollingCardIdleFailed;
+        }
+        timeoutUs -= delayUs;
+    }
+
+    return kStatus_Success;
+}
+
+static status_t SD_StreamSendCommand(
+    sd_stream_t *stream, uint32_t index, uint32_t argument, uint32_t responseType, uint32_t *response)
+{
+    sdmmchost_transfer_t content = {0};
+    sdmmchost_cmd_t command      = {0};
+    status_t error;
+
+    command.index              = index;
+    command.argument           = argument;
+    command.responseType       = responseType;
+    command.responseErrorFlags = SDMMC_R1_ALL_ERROR_FLAG;
+    if (index == (uint32_t)kSDMMC_StopTransmission)
+    {
+        command.type = kCARD_CommandTypeAbort;
+    }
+
+    content.command = &command;
+    content.data    = NULL;
+
+    stream->statistics.commands++;
+    error = SDMMCHOST_TransferFunction(stream->card->host, &content);
+    if (kStatus_Success != error)
+    {
+        SDMMC_LOG("\r\nError: send CMD%d failed with host error %d, response %x\r\n", index, error,
+                  command.response[0U]);
+        return kStatus_SDMMC_TransferFailed;
+    }
+
+    if (response != NULL)
+    {
+        *response = command.response[0U];
+    }
+
+    return kStatus_Success;
+}
+
+static status_t SD_StreamTransfer(sd_stream_t *stream)
+{
+    sd_card_t *card  = stream->card;
+    uint32_t blocks  = stream->queuedBlocks;
+    uint32_t startUs = 0U;
+    uint32_t readyUs = 0U;
+    uint32_t latencyUs;
+    uint32_t bucket;
+    uint32_t response = 0U;
+    status_t error;
+#if defined SDMMCHOST_ENABLE_CACHE_LINE_ALIGN_TRANSFER && SDMMCHOST_ENABLE_CACHE_LINE_ALIGN_TRANSFER
+    sdmmchost_scatter_gather_transfer_t content = {0};
+    sdmmchost_scatter_gather_data_t data        = {0};
+#else
+    sdmmchost_transfer_t content = {0};
+    sdmmchost_data_t data        = {0};
+#endif
+    sdmmchost_cmd_t command = {0};
+
+    if (blocks == 0U)
+    {
+        return kStatus_Success;
+    }
+
+    (void)SDMMC_OSAMutexLock(&card->lock, osaWaitForever_c);
+
+    if (stream->timestamp != NULL)
+    {
+        startUs = stream->timestamp();
+    }
+
+    /* the card is still programming the previous transfer, which overlapped with queuing this one */
+    error = SD_StreamWaitIdle(stream);
+
+    if (stream->timestamp != NULL)
+    {
+        readyUs = stream->timestamp();
+        stream->statistics.busyUs += readyUs - startUs;
+    }
+
+    /* pre-erase the blocks of the transfer */
+    if ((kStatus_Success == error) && (stream->direction == kSD_StreamWrite))
+    {
+        error = SD_StreamSendCommand(stream, (uint32_t)kSDMMC_ApplicationCommand, card->relativeAddress << 16U,
+                                     kCARD_ResponseTypeR1, &response);
+        if ((kStatus_Success == error) && ((response & SDMMC_MASK(kSDMMC_R1ApplicationCommandFlag)) == 0U))
+        {
+            error = kStatus_SDMMC_TransferFailed;
+        }
+
+        if (kStatus_Success == error)
+        {
+            error = SD_StreamSendCommand(stream, (uint32_t)kSD_ApplicationSetWriteBlockEraseCount, blocks,
+                                         kCARD_ResponseTypeR1, NULL);
+        }
+    }
+
+    if (kStatus_Success == error)
+    {
+        /* predefined transfers end without waiting for the card, CMD12 is R1b */
+        if ((card->flags & (uint32_t)kSD_SupportSetBlockCountCmd) != 0U)
+        {
+            data.enableAutoCommand23 = true;
+        }
+        else
+        {
+            data.enableAutoCommand12 = true;
+        }
+        data.blockSize = FSL_SDMMC_DEFAULT_BLOCK_SIZE;
+
+#if defined SDMMCHOST_ENABLE_CACHE_LINE_ALIGN_TRANSFER && SDMMCHOST_ENABLE_CACHE_LINE_ALIGN_TRANSFER
+        for (uint32_t i = 0U; i < stream->queuedBuffers; i++)
+        {
+            stream->buffers[i].dataList = (i + 1U < stream->queuedBuffers) ? &stream->buffers[i + 1U] : NULL;
+        }
+        data.dataDirection = stream->direction == kSD_StreamWrite ? kUSDHC_TransferDirectionSend :
+                                                                    kUSDHC_TransferDirectionReceive;
+        (void)memcpy(&data.sgData, &stream->buffers[0U], sizeof(data.sgData));
+#else
+        data.blockCount = blocks;
+        if (stream->direction == kSD_StreamWrite)
+        {
+            data.txData = stream->buffers[0U].dataAddr;
+        }
+        else
+        {
+            data.rxData = stream->buffers[0U].dataAddr;
+        }
+#endif
+
+        command.index = stream->direction == kSD_StreamWrite ? (uint32_t)kSDMMC_WriteMultipleBlock :
+                                                               (uint32_t)kSDMMC_ReadMultipleBlock;
+        command.argument = stream->nextBlock;
+        if (0U == (card->flags & (uint32_t)kSD_SupportHighCapacityFlag))
+        {
+            command.argument *= FSL_SDMMC_DEFAULT_BLOCK_SIZE;
+        }
+        command.responseType       = kCARD_ResponseTypeR1;
+        command.responseErrorFlags = SDMMC_R1_ALL_ERROR_FLAG;
+
+        content.command = &command;
+        content.data    = &data;
+
+        /* CMD25/CMD18 and the auto CMD23, the auto CMD12 is only sent once all the blocks are transferred */
+        stream->statistics.commands += data.enableAutoCommand23 ? 2U : 1U;
+#if defined SDMMCHOST_ENABLE_CACHE_LINE_ALIGN_TRANSFER && SDMMCHOST_ENABLE_CACHE_LINE_ALIGN_TRANSFER
+        error = SDMMCHOST_ScatterGatherTransferFunction(card->host, &content);
+#else
+        error = SDMMCHOST_TransferFunction(card->host, &content);
+#endif
+        if (kStatus_Success != error)
+        {
+            SDMMC_LOG("\r\nError: stream transfer of %d blocks at %d failed with host error %d, response %x\r\n",
+                      blocks, stream->nextBlock, error, command.response[0U]);
+
+            /* abort the data transfer, the card is left receiving or sending data */
+            (void)SD_StreamSendCommand(stream, (uint32_t)kSDMMC_StopTransmission, 0U, kCARD_ResponseTypeR1b, NULL);
+            (void)SD_StreamWaitIdle(stream);
+            error = kStatus_SDMMC_TransferFailed;
+        }
+        else if (data.enableAutoCommand12)
+        {
+            stream->statistics.commands++;
+        }
+    }
+
+    if (kStatus_Success == error)
+    {
+        stream->nextBlock += blocks;
+        stream->queuedBlocks      = 0U;
+        stream->queuedBuffers     = 0U;
+        stream->queuedDescriptors = 0U;
+
+        stream->statistics.transfers++;
+        stream->statistics.blocks += blocks;
+
+        if (stream->timestamp != NULL)
+        {
+            latencyUs = stream->timestamp() - readyUs;
+            stream->statistics.totalLatencyUs += latencyUs;
+            if ((stream->statistics.transfers == 1U) || (latencyUs < stream->statistics.minLatencyUs))
+            {
+                stream->statistics.minLatencyUs = latencyUs;
+            }
+            if (latencyUs > stream->statistics.maxLatencyUs)
+            {
+                stream->statistics.maxLatencyUs = latencyUs;
+            }
+
+            for (bucket = 0U; bucket < SD_STREAM_LATENCY_BUCKETS - 1U; bucket++)
+            {
+                if (latencyUs < (SD_STREAM_LATENCY_BUCKET_US << bucket))
+                {
+                    break;
+                }
+            }
+            stream->statistics.latencyHistogram[bucket]++;
+        }
+    }
+    else
+    {
+        stream->statistics.errors++;
+    }
+
+    (void)SDMMC_OSAMutexUnlock(&card->lock);
+
+    return error;
+}
+
+static status_t SD_StreamQueue(sd_stream_t *stream, uint8_t *buffer, uint32_t blockCount)
+{
+    sdmmchost_t *host = stream->card->host;
+    sdmmchost_scatter_gather_data_list_t *last;
+    uint32_t descriptors;
+    uint32_t lastBlocks;
+    uint32_t blocks;
+    status_t error;
+
+    if ((((uint32_t)(uintptr_t)buffer & (sizeof(uint32_t) - 1U)) != 0U) ||
+        (blockCount > stream->card->blockCount - stream->nextBlock - stream->queuedBlocks))
+    {
+        return kStatus_InvalidArgument;
+    }
+
+    while (blockCount != 0U)
+    {
+        last        = stream->queuedBuffers != 0U ? &stream->buffers[stream->queuedBuffers - 1U] : NULL;
+        descriptors = host->dmaDesBufferWordsNum / SDMMCHOST_DMA_DESCRIPTOR_WORDS - stream->queuedDescriptors;
+        lastBlocks  = 0U;
+
+        if ((last != NULL) && ((uint8_t *)last->dataAddr + last->dataSize == buffer))
+        {
+            /* following the last buffer, which grows into the room left in its descriptors */
+            descriptors += SD_STREAM_DESCRIPTORS(last->dataSize);
+            lastBlocks = last->dataSize / FSL_SDMMC_DEFAULT_BLOCK_SIZE;
+        }
+        else if (stream->queuedBuffers < SD_STREAM_QUEUE_BUFFERS)
+        {
+            last = NULL;
+        }
+        else
+        {
+            descriptors = 0U;
+        }
+
+        /* as many blocks as the host transfers at once, and as its descriptor buffer holds */
+        blocks = MIN(blockCount, host->maxBlockCount - stream->queuedBlocks);
+        blocks = MIN(blocks, descriptors * SDMMCHOST_DMA_DESCRIPTOR_MAX_LENGTH / FSL_SDMMC_DEFAULT_BLOCK_SIZE -
+                                 lastBlocks);
+
+        if (blocks == 0U)
+        {
+            if (stream->queuedBlocks == 0U)
+            {
+                return kStatus_InvalidArgument;
+            }
+
+            error = SD_StreamTransfer(stream);
+            if (kStatus_Success != error)
+            {
+                return error;
+            }
+            continue;
+        }
+
+        if (last == NULL)
+        {
+            last           = &stream->buffers[stream->queuedBuffers++];
+            last->dataAddr = (uint32_t *)(uintptr_t)buffer;
+            last->dataSize = 0U;
+            last->dataList = NULL;
+        }
+
+        stream->queuedDescriptors -= SD_STREAM_DESCRIPTORS(last->dataSize);
+        last->dataSize += blocks * FSL_SDMMC_DEFAULT_BLOCK_SIZE;
+        stream->queuedDescriptors += SD_STREAM_DESCRIPTORS(last->dataSize);
+        stream->queuedBlocks += blocks;
+        buffer += blocks * FSL_SDMMC_DEFAULT_BLOCK_SIZE;
+        blockCount -= blocks;
+
+        if (stream->queuedBlocks >= stream->transferBlocks)
+        {
+            error = SD_StreamTransfer(stream);
+            if (kStatus_Success != error)
+            {
+                return error;
+            }
+        }
+    }
+
+    return kStatus_Success;
+}
+
+status_t SD_StreamStart(sd_card_t *card,
+                        sd_stream_t *stream,
+                        sd_stream_direction_t direction,
+                        uint32_t startBlock,
+                        uint32_t transferBlocks)
+{
+    assert(card != NULL);
+    assert(stream != NULL);
+
+    uint32_t response = 0U;
+    status_t error;
+
+    if (startBlock >= card->blockCount)
+    {
+        return kStatus_InvalidArgument;
+    }
+
+    (void)memset(stream, 0, sizeof(sd_stream_t));
+    stream->card           = card;
+    stream->direction      = direction;
+    stream->nextBlock      = startBlock;
+    stream->transferBlocks = transferBlocks == 0U ? card->host->maxBlockCount : transferBlocks;
+
+    (void)SDMMC_OSAMutexLock(&card->lock, osaWaitForever_c);
+
+    error = SD_StreamWaitIdle(stream);
+    if (kStatus_Success == error)
+    {
+        error = SD_StreamSendCommand(stream, (uint32_t)kSDMMC_SendStatus, card->relativeAddress << 16U,
+                                     kCARD_ResponseTypeR1, &response);
+    }
+
+    if ((kStatus_Success != error) || ((response & SDMMC_MASK(kSDMMC_R1ReadyForDataFlag)) == 0U) ||
+        (SDMMC_R1_CURRENT_STATE(response) != (uint32_t)kSDMMC_R1StateTransfer))
+    {
+        SDMMC_LOG("Error : stream start failed, card status busy\r\n");
+        error = kStatus_SDMMC_PollingCardIdleFailed;
+    }
+
+    (void)SDMMC_OSAMutexUnlock(&card->lock);
+
+    return error;
+}
+
+void SD_StreamInstallTimestamp(sd_stream_t *stream, sd_stream_timestamp_t timestamp)
+{
+    assert(stream != NULL);
+
+    stream->timestamp = timestamp;
+}
+
+status_t SD_StreamWrite(sd_stream_t *stream, const uint8_t *buffer, uint32_t blockCount)
+{
+    assert(stream != NULL);
+    assert(buffer != NULL);
+    assert(stream->direction == kSD_StreamWrite);
+
+    return SD_StreamQueue(stream, (uint8_t *)(uintptr_t)buffer, blockCount);
+}
+
+status_t SD_StreamRead(sd_stream_t *stream, uint8_t *buffer, uint32_t blockCount)
+{
+    assert(stream != NULL);
+    assert(buffer != NULL);
+    assert(stream->direction == kSD_StreamRead);
+
+    return SD_StreamQueue(stream, buffer, blockCount);
+}
+
+status_t SD_StreamFlush(sd_stream_t *stream)
+{
+    assert(stream != NULL);
+
+    return SD_StreamTransfer(stream);
+}
+
+status_t SD_StreamStop(sd_stream_t *stream)
+{
+    assert(stream != NULL);
+
+    status_t error = SD_StreamTransfer(stream);
+
+    if (kStatus_Success == error)
+    {
+        error = SD_StreamWaitIdle(stream);
+    }
+
+    return error;
+}
+
+void SD_StreamGetStatistics(sd_stream_t *stream, sd_stream_statistics_t *statistics, bool reset)
+{
+    assert(stream != NULL);
+    assert(statistics != NULL);
+
+    (void)memcpy(statistics, &stream->statistics, sizeof(sd_stream_statistics_t));
+
+    if (reset)
+    {
+        (void)memset(&stream->statistics, 0, sizeof(sd_stream_statistics_t));
+    }
+}
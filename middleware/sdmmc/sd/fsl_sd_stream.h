@@ -0,0 +1,205 @@
+/*
+ * Copyright 2026 NXP
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef _FSL_SD_STREAM_H_
+#define _FSL_SD_STREAM_H_
+
+#include "fsl_sd.h"
+
+/*!
+ * @addtogroup sdcard_stream SD Card Streaming
+ * @ingroup sdcard
+ * @{
+ */
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+/*! @brief Maximum number of caller buffers queued into one multi-block transfer */
+#ifndef SD_STREAM_MAX_BUFFERS
+#define SD_STREAM_MAX_BUFFERS (16U)
+#endif
+/*! @brief Number of buckets of the transfer latency histogram */
+#define SD_STREAM_LATENCY_BUCKETS (8U)
+/*! @brief Upper latency limit of the first histogram bucket in us, doubling with each following bucket */
+#define SD_STREAM_LATENCY_BUCKET_US (256U)
+
+/*! @brief SD stream direction */
+typedef enum _sd_stream_direction
+{
+    kSD_StreamWrite = 0U, /*!< buffers are written to the card */
+    kSD_StreamRead  = 1U, /*!< buffers are read from the card */
+} sd_stream_direction_t;
+
+/*! @brief SD stream timestamp function, returning a free running time in us */
+typedef uint32_t (*sd_stream_timestamp_t)(void);
+
+/*!
+ * @brief SD stream statistics
+ *
+ * The latency of a transfer is the time from its first command to the end of its data, the time the card was still
+ * busy programming the previous transfer is counted separately in busyUs. Times are only measured with a timestamp
+ * function installed.
+ */
+typedef struct _sd_stream_statistics
+{
+    uint32_t transfers;                                   /*!< multi-block transfers completed */
+    uint32_t blocks;                                      /*!< blocks transferred */
+    uint32_t commands;                                    /*!< commands sent, including CMD55/ACMD23 and CMD23/CMD12 */
+    uint32_t errors;                                      /*!< transfers failed */
+    uint32_t minLatencyUs;                                /*!< shortest transfer latency */
+    uint32_t maxLatencyUs;                                /*!< longest transfer latency */
+    uint64_t totalLatencyUs;                              /*!< sum of the transfer latencies */
+    uint64_t busyUs;                                      /*!< time waited for the card before the transfers */
+    uint32_t latencyHistogram[SD_STREAM_LATENCY_BUCKETS]; /*!< transfers by latency, bucket n counts latencies below
+                                                               SD_STREAM_LATENCY_BUCKET_US << n, the last bucket
+                                                               all the longer ones */
+} sd_stream_statistics_t;
+
+/*!
+ * @brief SD stream state
+ *
+ * A stream transfers consecutive blocks from a start block on. Caller buffers are queued until enough blocks are
+ * queued for one transfer, which is then issued as a single CMD25/CMD18 over a DMA descriptor chain covering all the
+ * queued buffers.
+ */
+typedef struct _sd_stream
+{
+    sd_card_t *card;                 /*!< card descriptor */
+    sd_stream_direction_t direction; /*!< stream direction */
+    uint32_t nextBlock;              /*!< card block of the first queued buffer */
+    uint32_t transferBlocks;         /*!< queued blocks which start a transfer */
+    uint32_t queuedBlocks;           /*!< blocks queued */
+    uint32_t queuedBuffers;          /*!< buffers queued */
+    uint32_t queuedDescriptors;      /*!< DMA descriptors taken by the queued buffers */
+    sdmmchost_scatter_gather_data_list_t buffers[SD_STREAM_MAX_BUFFERS]; /*!< queued buffers */
+    sd_stream_timestamp_t timestamp;                                    /*!< timestamp function */
+    sd_stream_statistics_t statistics;                                  /*!< transfer statistics */
+} sd_stream_t;
+
+/*************************************************************************************************
+ * API
+ ************************************************************************************************/
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/*!
+ * @name SDCARD Streaming Function
+ * @{
+ */
+
+/*!
+ * @brief Starts a stream of consecutive blocks.
+ *
+ * The card must be initialized and idle. Buffers are then queued with SD_StreamWrite or SD_StreamRead, and moved
+ * in transfers of at least transferBlocks blocks, or as many as the DMA descriptor buffer of the host and
+ * SD_STREAM_MAX_BUFFERS allow.
+ *
+ * Writes send ACMD23 with the block count of each transfer, so the card pre-erases the blocks before they are
+ * written. If the card supports CMD23, transfers are predefined multi-block transfers sent with auto CMD23, which
+ * don't wait for the card to finish programming at their end: the next transfer or SD_StreamStop waits for it
+ * instead. Otherwise they are stopped with auto CMD12.
+ *
+ * @param card Card descriptor.
+ * @param stream Stream state.
+ * @param direction Stream direction.
+ * @param startBlock The start block index.
+ * @param transferBlocks The number of queued blocks which start a transfer, 0 for as many as possible.
+ * @retval #kStatus_InvalidArgument Invalid argument.
+ * @retval #kStatus_SDMMC_PollingCardIdleFailed Card not idle.
+ * @retval #kStatus_Success Operate successfully.
+ */
+status_t SD_StreamStart(sd_card_t *card,
+                        sd_stream_t *stream,
+                        sd_stream_direction_t direction,
+                        uint32_t startBlock,
+                        uint32_t transferBlocks);
+
+/*!
+ * @brief Installs a timestamp function to measure the transfer latencies.
+ *
+ * @param stream Stream state.
+ * @param timestamp Timestamp function, NULL to stop measuring.
+ */
+void SD_StreamInstallTimestamp(sd_stream_t *stream, sd_stream_timestamp_t timestamp);
+
+/*!
+ * @brief Queues blocks to write.
+ *
+ * The buffer is queued without copying it, it must stay unchanged until it has been transferred, that is until a
+ * later call to this function, SD_StreamFlush or SD_StreamStop returns. The buffer must be word aligned, a buffer
+ * following the previous one in memory extends its DMA descriptor.
+ *
+ * @param stream Stream state.
+ * @param buffer The buffer holding the data to be written to the card.
+ * @param blockCount The number of blocks to write.
+ * @retval #kStatus_InvalidArgument Invalid argument, misaligned buffer or blocks beyond the end of the card.
+ * @retval #kStatus_SDMMC_PollingCardIdleFailed Card not idle.
+ * @retval #kStatus_SDMMC_TransferFailed Transfer failed, the blocks queued so far are kept and transferred again by
+ * SD_StreamFlush, the stream ends at nextBlock + queuedBlocks.
+ * @retval #kStatus_Success Operate successfully.
+ */
+status_t SD_StreamWrite(sd_stream_t *stream, const uint8_t *buffer, uint32_t blockCount);
+
+/*!
+ * @brief Queues blocks to read.
+ *
+ * The buffer is filled once it has been transferred, that is when a later call to this function, SD_StreamFlush or
+ * SD_StreamStop returns. The buffer must be word aligned.
+ *
+ * @param stream Stream state.
+ * @param buffer The buffer to save the data read from card.
+ * @param blockCount The number of blocks to read.
+ * @retval #kStatus_InvalidArgument Invalid argument, misaligned buffer or blocks beyond the end of the card.
+ * @retval #kStatus_SDMMC_PollingCardIdleFailed Card not idle.
+ * @retval #kStatus_SDMMC_TransferFailed Transfer failed, the blocks queued so far are kept and transferred again by
+ * SD_StreamFlush, the stream ends at nextBlock + queuedBlocks.
+ * @retval #kStatus_Success Operate successfully.
+ */
+status_t SD_StreamRead(sd_stream_t *stream, uint8_t *buffer, uint32_t blockCount);
+
+/*!
+ * @brief Transfers the queued buffers.
+ *
+ * The card may still be programming the written blocks when the function returns.
+ *
+ * @param stream Stream state.
+ * @retval #kStatus_SDMMC_PollingCardIdleFailed Card not idle.
+ * @retval #kStatus_SDMMC_TransferFailed Transfer failed, the queued buffers are kept.
+ * @retval #kStatus_Success Operate successfully.
+ */
+status_t SD_StreamFlush(sd_stream_t *stream);
+
+/*!
+ * @brief Stops a stream.
+ *
+ * Transfers the queued buffers and waits until the card has finished programming them.
+ *
+ * @param stream Stream state.
+ * @retval #kStatus_SDMMC_PollingCardIdleFailed Card not idle.
+ * @retval #kStatus_SDMMC_TransferFailed Transfer failed, the queued buffers are kept.
+ * @retval #kStatus_Success Operate successfully.
+ */
+status_t SD_StreamStop(sd_stream_t *stream);
+
+/*!
+ * @brief Gets the transfer statistics of a stream.
+ *
+ * @param stream Stream state.
+ * @param statistics Statistics since SD_StreamStart or the last reset.
+ * @param reset true to reset the statistics.
+ */
+void SD_StreamGetStatistics(sd_stream_t *stream, sd_stream_statistics_t *statistics, bool reset);
+
+/* @} */
+
+#if defined(__cplusplus)
+}
+#endif
+/*! @} */
+#endif /* _FSL_SD_STREAM_H_*/
@@ -0,0 +1,179 @@
+#include "Bench.hpp"
+
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+
+namespace bench
+{
+
+Case *Case::_head = nullptr;
+uint32_t Runner::_samples[Runner::MAX_ITERATIONS];
+uint64_t Runner::events = 0;
+uint64_t Runner::bytes = 0;
+
+Case::Case(const char *group_, const char *name_, CaseFunc func_, CaseFunc setup_, uint32_t ops_)
+	: group(group_), name(name_), func(func_), setup(setup_), ops(ops_ > 0 ? ops_ : 1)
+{
+	// Append so cases run in link order.
+	Case **tail = &_head;
+
+	while (*tail != nullptr) {
+		tail = &(*tail)->_next;
+	}
+
+	*tail = this;
+}
+
+void Timer::init()
+{
+#if defined(__arm__)
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+#if defined(__CORTEX_M) && (__CORTEX_M == 7U)
+	DWT->LAR = 0xC5ACCE55;
+#endif
+	DWT->CYCCNT = 0;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+}
+
+const char *Timer::unit()
+{
+#if defined(__arm__)
+	return "cyc";
+#else
+	return "ns";
+#endif
+}
+
+uint32_t Timer::ticks_per_us()
+{
+#if defined(__arm__)
+	return SystemCoreClock / 1000000U;
+#else
+	return 1000;
+#endif
+}
+
+static bool matches(const Case &c, const char *filter)
+{
+	if (filter == nullptr || filter[0] == '\0') {
+		return true;
+	}
+
+	char full[64];
+	snprintf(full, sizeof(full), "%s.%s", c.group, c.name);
+	return strstr(full, filter) != nullptr;
+}
+
+// Smallest back to back reading of the timer, subtracted from every sample.
+static uint32_t timer_overhead()
+{
+	uint32_t best = UINT32_MAX;
+
+	for (int i = 0; i < 32; i++) {
+		const uint32_t t0 = Timer::now();
+		const uint32_t t1 = Timer::now();
+		best = std::min(best, t1 - t0);
+	}
+
+	return best;
+}
+
+bool Runner::run(const Case &c, const Config &config, Result &result)
+{
+	const uint32_t iterations = std::min(config.iterations, MAX_ITERATIONS);
+
+	if (iterations == 0 || c.func == nullptr) {
+		return false;
+	}
+
+	if (c.setup) {
+		c.setup();
+	}
+
+	for (uint32_t i = 0; i < config.warmup; i++) {
+		c.func();
+	}
+
+	const uint32_t overhead = timer_overhead();
+
+	events = 0;
+	bytes = 0;
+
+	for (uint32_t i = 0; i < iterations; i++) {
+		const uint32_t t0 = Timer::now();
+		c.func();
+		const uint32_t dt = Timer::now() - t0;
+
+		_samples[i] = (dt > overhead ? dt - overhead : 0) / c.ops;
+	}
+
+	std::sort(_samples, _samples + iterations);
+
+	result.iterations = iterations;
+	result.min = _samples[0];
+	result.median = _samples[iterations / 2];
+	result.p99 = _samples[(iterations * 99) / 100];
+	result.max = _samples[iterations - 1];
+	result.events = events;
+	result.bytes = bytes;
+	return true;
+}
+
+int Runner::run_all(const Config &config, SinkFunc sink)
+{
+	char line[160];
+	int count = 0;
+
+	Timer::init();
+
+	snprintf(line, sizeof(line), "%-32s %8s %10s %10s %10s %10s\r\n",
+		 "case", "iter", "min", "median", "p99", "max");
+	sink(line);
+
+	for (Case *c = Case::first(); c != nullptr; c = c->next()) {
+		if (!matches(*c, config.filter)) {
+			continue;
+		}
+
+		Result r;
+
+		if (!run(*c, config, r)) {
+			continue;
+		}
+
+		char full[64];
+		snprintf(full, sizeof(full), "%s.%s", c->group, c->name);
+		snprintf(line, sizeof(line), "%-32s %8lu %7lu%-3s %7lu%-3s %7lu%-3s %7lu%-3s\r\n", full,
+			 (unsigned long)r.iterations,
+			 (unsigned long)r.min, Timer::unit(),
+			 (unsigned long)r.median, Timer::unit(),
+			 (unsigned long)r.p99, Timer::unit(),
+			 (unsigned long)r.max, Timer::unit());
+
+		if (r.events > 0) {
+			// events per operation with two decimals
+			const uint64_t per_op = (r.events * 100) / ((uint64_t)r.iterations * c->ops);
+			size_t len = strlen(line) - 2; // before "\r\n"
+			snprintf(&line[len], sizeof(line) - len, " %6lu.%02lu ev/op\r\n",
+				 (unsigned long)(per_op / 100), (unsigned long)(per_op % 100));
+		}
+
+		if (r.bytes > 0 && r.median > 0) {
+			// MB/s at the median time with two decimals
+			const uint64_t per_op = r.bytes / ((uint64_t)r.iterations * c->ops);
+			const uint64_t rate = (per_op * Timer::ticks_per_us() * 100) / r.median;
+			size_t len = strlen(line) - 2;
+			snprintf(&line[len], sizeof(line) - len, " %6lu.%02lu MB/s\r\n",
+				 (unsigned long)(rate / 100), (unsigned long)(rate % 100));
+		}
+
+		sink(line);
+		count++;
+	}
+
+	return count;
+}
+
+} // namespace bench
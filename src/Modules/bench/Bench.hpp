@@ -0,0 +1,154 @@
+#ifndef BENCH_HPP
+#define BENCH_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__arm__)
+#include "fsl_device_registers.h"
+#else
+#include <time.h>
+#endif
+
+// Microbenchmark harness.
+//
+// Cases register themselves at static init time with BENCH_CASE() and are
+// run by Bench::Runner, which times every iteration separately and reports
+// min/median/p99. On target the clock is the DWT cycle counter (unit "cyc"),
+// on the host it is CLOCK_MONOTONIC (unit "ns").
+//
+// Only built with CMAKE_BUILD_TYPE=bench.
+
+namespace bench
+{
+
+typedef void (*CaseFunc)();
+typedef void (*SinkFunc)(const char *line);
+
+class Case
+{
+public:
+	/* @brief Register a case, called by BENCH_CASE()
+	 *
+	 * @param group Group name, used by the runner filter.
+	 * @param name Case name.
+	 * @param func Function executed once per iteration.
+	 * @param setup Optional function executed once before warmup.
+	 * @param ops Operations done per call, results are divided by it.
+	 */
+	Case(const char *group, const char *name, CaseFunc func, CaseFunc setup = nullptr, uint32_t ops = 1);
+
+	static Case *first() { return _head; }
+	Case *next() const { return _next; }
+
+	const char *group;
+	const char *name;
+	CaseFunc func;
+	CaseFunc setup;
+	uint32_t ops;
+
+private:
+	static Case *_head;
+	Case *_next{nullptr};
+};
+
+struct Config {
+	uint32_t warmup{16};
+	uint32_t iterations{256};
+	const char *filter{nullptr};     // substring matched against "group.name"
+};
+
+struct Result {
+	uint32_t iterations;
+	uint32_t min;
+	uint32_t median;
+	uint32_t p99;
+	uint32_t max;
+	uint64_t events;                 // bench::count() calls during the timed iterations
+	uint64_t bytes;                  // bench::transfer() bytes during the timed iterations
+};
+
+class Runner
+{
+public:
+	static constexpr uint32_t MAX_ITERATIONS = 1024;
+
+	/* @brief Run all matching cases and report one line per case
+	 *
+	 * @param config Warmup/iteration control and filter.
+	 * @param sink Receives every formatted report line.
+	 *
+	 * @returns number of cases run.
+	 */
+	static int run_all(const Config &config, SinkFunc sink);
+
+	/* @brief Time a single case
+	 *
+	 * @returns false if the case could not be run.
+	 */
+	static bool run(const Case &c, const Config &config, Result &result);
+
+	static uint64_t events;
+	static uint64_t bytes;
+
+private:
+	static uint32_t _samples[MAX_ITERATIONS];
+};
+
+/* @brief Count events of the running case, e.g. block device reads
+ *
+ * Cases that count get their events per operation reported next to the
+ * timing. Counts made during setup and warmup are dropped.
+ */
+inline void count(uint32_t n = 1)
+{
+	Runner::events += n;
+}
+
+/* @brief Count bytes moved by the running case, e.g. file data
+ *
+ * Cases that count get their throughput at the median time reported in
+ * MB/s. Counts made during setup and warmup are dropped.
+ */
+inline void transfer(uint32_t n)
+{
+	Runner::bytes += n;
+}
+
+class Timer
+{
+public:
+	static void init();
+
+	static inline uint32_t now()
+	{
+#if defined(__arm__)
+		return DWT->CYCCNT;
+#else
+		timespec ts;
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		return (uint32_t)((uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec);
+#endif
+	}
+
+	static const char *unit();
+	static uint32_t ticks_per_us();
+};
+
+// Keep the compiler from discarding a value computed by a benchmark.
+template<typename T>
+inline void do_not_optimize(T const &value)
+{
+	__asm__ volatile("" : : "r,m"(value) : "memory");
+}
+
+} // namespace bench
+
+#define BENCH_CASE_EX(group, name, setup, ops) \
+	static void bench_##group##_##name(); \
+	static bench::Case bench_case_##group##_##name(#group, #name, bench_##group##_##name, setup, ops); \
+	static void bench_##group##_##name()
+
+#define BENCH_CASE(group, name) BENCH_CASE_EX(group, name, nullptr, 1)
+
+#endif
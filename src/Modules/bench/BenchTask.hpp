@@ -0,0 +1,59 @@
+#ifndef BENCH_TASK_HPP
+#define BENCH_TASK_HPP
+
+#include "Tasks.hpp"
+#include "Bench.hpp"
+
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+// Runs every registered benchmark once the CDC port is opened and streams
+// the report over it.
+class BenchTask : public Tasks
+{
+public:
+	BenchTask() = default;
+	~BenchTask() override = default;
+
+	void Init(void *handle) override {}
+
+	void CallBack(void *param) override
+	{
+		while ((1U != s_cdcVcom.attach) || (1U != s_cdcVcom.startTransactions)) {
+			vTaskDelay(pdMS_TO_TICKS(100));
+		}
+
+		bench::Config config;
+
+		// Benchmarks run at the highest priority so they are not preempted
+		// by the tasks they are meant to measure.
+		vTaskPrioritySet(nullptr, configMAX_PRIORITIES - 1);
+		bench::Runner::run_all(config, CdcSink);
+		vTaskPrioritySet(nullptr, tskIDLE_PRIORITY + 1);
+
+		while (1) {
+			vTaskDelay(pdMS_TO_TICKS(1000));
+		}
+	}
+
+private:
+	static void CdcSink(const char *line)
+	{
+		static uint8_t buffer[160];
+		size_t len = strlen(line);
+
+		if (len > sizeof(buffer)) {
+			len = sizeof(buffer);
+		}
+
+		memcpy(buffer, line, len);
+		USB_DeviceCdcAcmSend(s_cdcVcom.cdcAcmHandle, USB_CDC_VCOM_BULK_IN_ENDPOINT, buffer, len);
+
+		// Let the bulk transfer complete before the buffer is reused.
+		vTaskDelay(pdMS_TO_TICKS(5));
+	}
+};
+
+#endif
@@ -0,0 +1,52 @@
+#include "Bench.hpp"
+
+// Heap allocation through operator new/delete, which Ringbuffer::allocate()
+// and the other modules use: the newlib heap (fsl_sbrk.c) on target, the C
+// library on the host.
+//
+//   new_delete_64     one 64 B buffer allocated and freed again
+//   new_delete_mixed  16 buffers of 16 B to 1 KiB allocated and freed in a
+//                     different order, with 8 more held the whole time, so
+//                     the free list is fragmented
+
+static constexpr int MIXED = 16;
+static constexpr int HELD = 8;
+
+static uint8_t *s_held[HELD];
+static size_t s_sizes[MIXED];
+static int s_order[MIXED];
+
+static void heap_setup()
+{
+	for (int i = 0; i < HELD; i++) {
+		if (s_held[i] == nullptr) {
+			s_held[i] = new uint8_t[48 + 32 * i];
+		}
+	}
+
+	for (int i = 0; i < MIXED; i++) {
+		s_sizes[i] = (size_t)16 << (i % 7);
+		s_order[i] = (i * 5 + 3) % MIXED;
+	}
+}
+
+BENCH_CASE(heap, new_delete_64)
+{
+	uint8_t *buffer = new uint8_t[64];
+	bench::do_not_optimize(buffer);
+	delete[] buffer;
+}
+
+BENCH_CASE_EX(heap, new_delete_mixed, heap_setup, MIXED)
+{
+	uint8_t *buffers[MIXED];
+
+	for (int i = 0; i < MIXED; i++) {
+		buffers[i] = new uint8_t[s_sizes[i]];
+		bench::do_not_optimize(buffers[i]);
+	}
+
+	for (int i = 0; i < MIXED; i++) {
+		delete[] buffers[s_order[i]];
+	}
+}
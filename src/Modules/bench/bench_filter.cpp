@@ -0,0 +1,42 @@
+#include "Bench.hpp"
+
+#include <mathlib/math/filter/LowPassFilter2p.hpp>
+#include <mathlib/math/filter/NotchFilter.hpp>
+
+static constexpr int FILTER_SAMPLES = 64;
+
+static float s_samples[FILTER_SAMPLES];
+static math::LowPassFilter2p<float> s_lpf;
+static math::NotchFilter<float> s_notch;
+
+static void filter_setup()
+{
+	for (int i = 0; i < FILTER_SAMPLES; i++) {
+		s_samples[i] = (float)((i * 37) % 17) - 8.f;
+	}
+
+	s_lpf.set_cutoff_frequency(1000.f, 80.f);
+	s_notch.setParameters(1000.f, 120.f, 20.f);
+}
+
+BENCH_CASE_EX(filter, lpf2p_apply, filter_setup, FILTER_SAMPLES)
+{
+	float out = 0.f;
+
+	for (int i = 0; i < FILTER_SAMPLES; i++) {
+		out += s_lpf.apply(s_samples[i]);
+	}
+
+	bench::do_not_optimize(out);
+}
+
+BENCH_CASE_EX(filter, notch_apply, filter_setup, FILTER_SAMPLES)
+{
+	float out = 0.f;
+
+	for (int i = 0; i < FILTER_SAMPLES; i++) {
+		out += s_notch.apply(s_samples[i]);
+	}
+
+	bench::do_not_optimize(out);
+}
@@ -0,0 +1,47 @@
+#include "Bench.hpp"
+
+#include <matrix/math.hpp>
+
+using namespace matrix;
+
+static SquareMatrix<float, 6> s_a;
+static SquareMatrix<float, 6> s_b;
+static Quatf s_q;
+static Vector3f s_v;
+
+static void matrix_setup()
+{
+	for (size_t i = 0; i < 6; i++) {
+		for (size_t j = 0; j < 6; j++) {
+			s_a(i, j) = 0.1f * (float)(i + 1) + 0.01f * (float)j;
+			s_b(i, j) = (i == j) ? 2.f : 0.05f * (float)(i + j);
+		}
+	}
+
+	s_q = Quatf(Eulerf(0.1f, -0.2f, 0.3f));
+	s_v = Vector3f(1.f, 2.f, 3.f);
+}
+
+BENCH_CASE_EX(matrix, mul_6x6, matrix_setup, 1)
+{
+	SquareMatrix<float, 6> c = s_a * s_b;
+	bench::do_not_optimize(c);
+}
+
+BENCH_CASE_EX(matrix, inv_6x6, matrix_setup, 1)
+{
+	SquareMatrix<float, 6> c = inv(s_b);
+	bench::do_not_optimize(c);
+}
+
+BENCH_CASE_EX(matrix, quat_rotate, matrix_setup, 1)
+{
+	Vector3f r = s_q.rotateVector(s_v);
+	bench::do_not_optimize(r);
+}
+
+BENCH_CASE_EX(matrix, quat_to_dcm, matrix_setup, 1)
+{
+	Dcmf d(s_q);
+	bench::do_not_optimize(d);
+}
@@ -0,0 +1,27 @@
+#include "Bench.hpp"
+
+#include "Ringbuffer.hpp"
+
+static Ringbuffer s_ringbuffer;
+static bool s_allocated{false};
+static uint8_t s_packet[64];
+
+static void ringbuffer_setup()
+{
+	if (!s_allocated) {
+		s_allocated = s_ringbuffer.allocate(4096);
+	}
+
+	for (size_t i = 0; i < sizeof(s_packet); i++) {
+		s_packet[i] = (uint8_t)i;
+	}
+}
+
+BENCH_CASE_EX(ringbuffer, push_pop_64, ringbuffer_setup, 1)
+{
+	uint8_t out[sizeof(s_packet)];
+
+	s_ringbuffer.push_back(s_packet, sizeof(s_packet));
+	size_t n = s_ringbuffer.pop_front(out, sizeof(out));
+	bench::do_not_optimize(n);
+}
@@ -0,0 +1,62 @@
+#include "Bench.hpp"
+
+#include "RttTransport.hpp"
+#include "Telemetry.hpp"
+
+// Estimator sized sample: attitude quaternion, position, velocity, biases.
+struct EstimatorState {
+	float q[4];
+	float pos[3];
+	float vel[3];
+	float gyro_bias[3];
+	float accel_bias[3];
+};
+
+static uint8_t s_rtt_buffer[16384];
+static telemetry::RttTransport s_transport(1, "Telemetry", s_rtt_buffer, sizeof(s_rtt_buffer));
+static telemetry::Writer s_writer(s_transport);
+static telemetry::Topic s_topic("estimator", 1);
+static EstimatorState s_state;
+static uint32_t s_timestamp;
+
+static void telemetry_setup()
+{
+	s_transport.init();
+
+	for (size_t i = 0; i < sizeof(s_state) / sizeof(float); i++) {
+		((float *)&s_state)[i] = 0.1f * (float)i;
+	}
+}
+
+// CRC-16/CCITT-FALSE of the frames, over the largest raw frame
+BENCH_CASE(crc, crc16_ccitt_max_frame)
+{
+	static uint8_t raw[telemetry::MAX_RAW_SIZE];
+	uint16_t crc = telemetry::crc16(raw, sizeof(raw));
+	raw[0] = (uint8_t)crc;
+	bench::do_not_optimize(crc);
+	bench::transfer(sizeof(raw));
+}
+
+BENCH_CASE(telemetry, encode_64)
+{
+	uint8_t frame[telemetry::MAX_FRAME_SIZE];
+	size_t len = telemetry::encode_frame(frame, 1, (uint8_t)s_timestamp, s_timestamp, &s_state, sizeof(s_state));
+	s_timestamp += 250;
+	bench::do_not_optimize(len);
+}
+
+// 16 publishes per iteration, then the up-buffer is drained the way the
+// debug probe would, so the writer never sees a full buffer.
+BENCH_CASE_EX(telemetry, publish_rtt_64, telemetry_setup, 16)
+{
+	for (int i = 0; i < 16; i++) {
+		s_writer.publish(s_topic, &s_state, sizeof(s_state), s_timestamp);
+		s_timestamp += 250;
+	}
+
+	uint8_t drain[256];
+
+	while (SEGGER_RTT_ReadUpBufferNoLock(1, drain, sizeof(drain)) > 0) {
+	}
+}
@@ -0,0 +1,248 @@
+#include "BlockDevice.hpp"
+
+#include <stdlib.h>
+#include <string.h>
+
+int BlockDevice::read(uint64_t addr, void *buffer, uint32_t size)
+{
+	if (addr % _geometry.read_size != 0 || size % _geometry.read_size != 0 || addr + size > this->size()) {
+		return -1;
+	}
+
+	_stats.reads++;
+	_stats.bytes_read += size;
+	return do_read(addr, buffer, size);
+}
+
+int BlockDevice::prog(uint64_t addr, const void *buffer, uint32_t size)
+{
+	if (addr % _geometry.prog_size != 0 || size % _geometry.prog_size != 0 || addr + size > this->size()) {
+		return -1;
+	}
+
+	_stats.progs++;
+	_stats.bytes_programmed += size;
+	return do_prog(addr, buffer, size);
+}
+
+int BlockDevice::erase(uint32_t block)
+{
+	if (block >= _geometry.block_count) {
+		return -1;
+	}
+
+	_stats.erases++;
+	return do_erase((uint64_t)block * _geometry.erase_size, _geometry.erase_size);
+}
+
+// RAM
+
+RamBlockDevice::~RamBlockDevice()
+{
+	free(_image);
+}
+
+bool RamBlockDevice::init(const Geometry &geometry)
+{
+	_geometry = geometry;
+	_stats = Stats{};
+
+	free(_image);
+	_image = (uint8_t *)malloc(size());
+
+	if (_image == nullptr) {
+		return false;
+	}
+
+	memset(_image, 0xff, size());
+	return true;
+}
+
+int RamBlockDevice::do_read(uint64_t addr, void *buffer, uint32_t size)
+{
+	memcpy(buffer, &_image[addr], size);
+	return 0;
+}
+
+int RamBlockDevice::do_prog(uint64_t addr, const void *buffer, uint32_t size)
+{
+	memcpy(&_image[addr], buffer, size);
+	return 0;
+}
+
+int RamBlockDevice::do_erase(uint64_t addr, uint32_t size)
+{
+	memset(&_image[addr], 0xff, size);
+	return 0;
+}
+
+// File
+
+FileBlockDevice::~FileBlockDevice()
+{
+	if (_file != nullptr) {
+		fclose(_file);
+	}
+}
+
+bool FileBlockDevice::init(const char *path, const Geometry &geometry)
+{
+	_geometry = geometry;
+	_stats = Stats{};
+
+	if (_file != nullptr) {
+		fclose(_file);
+	}
+
+	_file = fopen(path, "w+b");
+
+	if (_file == nullptr) {
+		return false;
+	}
+
+	for (uint32_t block = 0; block < _geometry.block_count; block++) {
+		if (do_erase((uint64_t)block * _geometry.erase_size, _geometry.erase_size) != 0) {
+			return false;
+		}
+	}
+
+	return fflush(_file) == 0;
+}
+
+int FileBlockDevice::do_read(uint64_t addr, void *buffer, uint32_t size)
+{
+	if (fseek(_file, (long)addr, SEEK_SET) != 0 || fread(buffer, 1, size, _file) != size) {
+		return -1;
+	}
+
+	return 0;
+}
+
+int FileBlockDevice::do_prog(uint64_t addr, const void *buffer, uint32_t size)
+{
+	if (fseek(_file, (long)addr, SEEK_SET) != 0 || fwrite(buffer, 1, size, _file) != size) {
+		return -1;
+	}
+
+	return 0;
+}
+
+int FileBlockDevice::do_erase(uint64_t addr, uint32_t size)
+{
+	uint8_t erased[4096];
+
+	memset(erased, 0xff, sizeof(erased));
+
+	if (fseek(_file, (long)addr, SEEK_SET) != 0) {
+		return -1;
+	}
+
+	for (uint32_t off = 0; off < size; off += sizeof(erased)) {
+		const uint32_t n = size - off < sizeof(erased) ? size - off : sizeof(erased);
+
+		if (fwrite(erased, 1, n, _file) != n) {
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+int FileBlockDevice::do_sync()
+{
+	return fflush(_file) == 0 ? 0 : -1;
+}
+
+// Simulation
+
+void SimBlockDevice::init(BlockDevice *backing, const Timing *timing)
+{
+	_geometry = backing->geometry();
+	_stats = Stats{};
+	_backing = backing;
+	_timing = timing;
+	_time_ns = 0;
+	_violations = 0;
+	_erases.assign(_geometry.block_count, 0);
+	_programmed.assign(_geometry.block_count, 0);
+
+	// The backing image starts erased
+	_written.assign(_geometry.raw ? size() / _geometry.prog_size : 0, 0);
+}
+
+SimBlockDevice::Wear SimBlockDevice::wear() const
+{
+	Wear wear{};
+	uint64_t erases = 0;
+	uint64_t programmed = 0;
+
+	for (uint32_t block = 0; block < _geometry.block_count; block++) {
+		wear.max_erases = _erases[block] > wear.max_erases ? _erases[block] : wear.max_erases;
+		programmed = _programmed[block] > programmed ? _programmed[block] : programmed;
+		erases += _erases[block];
+	}
+
+	wear.mean_erases = (double)erases / _geometry.block_count;
+	wear.max_rewrites = (double)programmed / _geometry.erase_size;
+	wear.violations = _violations;
+	return wear;
+}
+
+int SimBlockDevice::do_read(uint64_t addr, void *buffer, uint32_t size)
+{
+	if (_timing != nullptr) {
+		_time_ns += (uint64_t)_timing->read_us * 1000 + (uint64_t)size * _timing->byte_ns;
+	}
+
+	return _backing->read(addr, buffer, size);
+}
+
+int SimBlockDevice::do_prog(uint64_t addr, const void *buffer, uint32_t size)
+{
+	const uint32_t units = size / _geometry.prog_size;
+
+	if (_timing != nullptr) {
+		_time_ns += (uint64_t)_timing->commit_us * 1000 + (uint64_t)units * _timing->prog_us * 1000 +
+			    (uint64_t)size * _timing->byte_ns;
+	}
+
+	for (uint64_t off = 0; off < size;) {
+		// Split at erase blocks
+		const uint64_t block = (addr + off) / _geometry.erase_size;
+		const uint64_t end = (block + 1) * _geometry.erase_size - addr;
+		const uint64_t n = (end < size ? end : size) - off;
+
+		_programmed[block] += n;
+		off += n;
+	}
+
+	for (uint64_t unit = addr / _geometry.prog_size; _geometry.raw && unit < addr / _geometry.prog_size + units;
+	     unit++) {
+		_violations += _written[unit];
+		_written[unit] = 1;
+	}
+
+	return _backing->prog(addr, buffer, size);
+}
+
+int SimBlockDevice::do_erase(uint64_t addr, uint32_t size)
+{
+	const uint32_t block = (uint32_t)(addr / _geometry.erase_size);
+
+	if (_timing != nullptr) {
+		_time_ns += (uint64_t)_timing->erase_us * 1000;
+	}
+
+	_erases[block]++;
+
+	if (_geometry.raw) {
+		memset(&_written[addr / _geometry.prog_size], 0, size / _geometry.prog_size);
+	}
+
+	return _backing->erase(block);
+}
+
+int SimBlockDevice::do_sync()
+{
+	return _backing->sync();
+}
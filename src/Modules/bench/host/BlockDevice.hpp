@@ -0,0 +1,157 @@
+#ifndef BLOCK_DEVICE_HPP
+#define BLOCK_DEVICE_HPP
+
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+
+// Block devices for comparing the filesystems on the host, the interface
+// the adapters of trace_replay put under littlefs (lfs_config), FatFs
+// (diskio) and dhara (dhara_nand), see TraceFs.cpp. A device is
+// block_count erase blocks of erase_size bytes, read in multiples of
+// read_size and programmed in multiples of prog_size at aligned addresses.
+// Raw flash programs erased bytes only. Managed devices (SD cards, eMMC)
+// program in place and are never erased by the filesystem.
+//
+//   RamBlockDevice   image in RAM
+//   FileBlockDevice  image in a file, left behind for inspection
+//   SimBlockDevice   time and wear of a device type, on top of either
+class BlockDevice
+{
+public:
+	struct Geometry {
+		uint32_t read_size;
+		uint32_t prog_size;
+		uint32_t erase_size;
+		uint32_t block_count;
+		bool raw;              // raw flash, programs need erased bytes
+	};
+
+	struct Stats {
+		uint64_t reads;
+		uint64_t progs;
+		uint64_t erases;
+		uint64_t bytes_read;
+		uint64_t bytes_programmed;
+	};
+
+	virtual ~BlockDevice() = default;
+
+	const Geometry &geometry() const { return _geometry; }
+	uint64_t size() const { return (uint64_t)_geometry.erase_size * _geometry.block_count; }
+	const Stats &stats() const { return _stats; }
+	void reset_stats() { _stats = Stats{}; }
+
+	/* @brief Read, program or erase, counted in the stats
+	 *
+	 * Reads and programs may cross erase blocks.
+	 *
+	 * @returns 0 on success, -1 if out of range, misaligned or the image
+	 *          can't be accessed.
+	 */
+	int read(uint64_t addr, void *buffer, uint32_t size);
+	int prog(uint64_t addr, const void *buffer, uint32_t size);
+	int erase(uint32_t block);
+	int sync() { return do_sync(); }
+
+protected:
+	// Called with the address range checked
+	virtual int do_read(uint64_t addr, void *buffer, uint32_t size) = 0;
+	virtual int do_prog(uint64_t addr, const void *buffer, uint32_t size) = 0;
+	virtual int do_erase(uint64_t addr, uint32_t size) = 0;
+	virtual int do_sync() { return 0; }
+
+	Geometry _geometry{};
+	Stats _stats{};
+};
+
+class RamBlockDevice : public BlockDevice
+{
+public:
+	~RamBlockDevice() override;
+
+	/* @brief Allocate an erased image
+	 *
+	 * @returns false if out of memory.
+	 */
+	bool init(const Geometry &geometry);
+
+protected:
+	int do_read(uint64_t addr, void *buffer, uint32_t size) override;
+	int do_prog(uint64_t addr, const void *buffer, uint32_t size) override;
+	int do_erase(uint64_t addr, uint32_t size) override;
+
+private:
+	uint8_t *_image{nullptr};
+};
+
+class FileBlockDevice : public BlockDevice
+{
+public:
+	~FileBlockDevice() override;
+
+	/* @brief Create the image file, erased, replacing an existing one
+	 *
+	 * @returns false if the file can't be written.
+	 */
+	bool init(const char *path, const Geometry &geometry);
+
+protected:
+	int do_read(uint64_t addr, void *buffer, uint32_t size) override;
+	int do_prog(uint64_t addr, const void *buffer, uint32_t size) override;
+	int do_erase(uint64_t addr, uint32_t size) override;
+	int do_sync() override;
+
+private:
+	FILE *_file{nullptr};
+};
+
+// Time and wear of a device type on top of another device, with the same
+// geometry. The device doesn't wait: the time requests would take is added
+// up in time_ns(), for the caller to add to the time it measures.
+class SimBlockDevice : public BlockDevice
+{
+public:
+	struct Timing {
+		uint32_t read_us;      // per read, command and array access
+		uint32_t prog_us;      // per prog_size programmed
+		uint32_t erase_us;     // per erase block
+		uint32_t commit_us;    // per program request, managed devices
+		uint32_t byte_ns;      // bus transfer
+	};
+
+	struct Wear {
+		uint32_t max_erases;   // of the most erased block
+		double mean_erases;
+		double max_rewrites;   // bytes programmed into the most programmed
+				       // block, in erase blocks
+		uint64_t violations;   // programs of bytes not erased, raw devices
+	};
+
+	/* @brief Simulate on top of a device
+	 *
+	 * @param backing Device holding the image.
+	 * @param timing Time of the requests, nullptr for none.
+	 */
+	void init(BlockDevice *backing, const Timing *timing);
+
+	uint64_t time_ns() const { return _time_ns; }
+	Wear wear() const;
+
+protected:
+	int do_read(uint64_t addr, void *buffer, uint32_t size) override;
+	int do_prog(uint64_t addr, const void *buffer, uint32_t size) override;
+	int do_erase(uint64_t addr, uint32_t size) override;
+	int do_sync() override;
+
+private:
+	BlockDevice *_backing{nullptr};
+	const Timing *_timing{nullptr};
+	uint64_t _time_ns{0};
+	std::vector<uint32_t> _erases;       // per erase block
+	std::vector<uint64_t> _programmed;   // bytes per erase block
+	std::vector<uint8_t> _written;       // per prog_size, raw devices
+	uint64_t _violations{0};
+};
+
+#endif
@@ -0,0 +1,242 @@
+#include "DharaNandSim.hpp"
+
+#include "Bench.hpp"
+
+#include <chrono>
+#include <stdlib.h>
+#include <string.h>
+
+DharaNandSim::~DharaNandSim()
+{
+	free(_image);
+	free(_bad);
+	free(_next);
+}
+
+bool DharaNandSim::init(uint8_t log2_page_size, uint8_t log2_ppb, unsigned int num_blocks, unsigned int factory_bad,
+			uint32_t fail_rate, uint32_t seed)
+{
+	const size_t size = (size_t)num_blocks << (log2_page_size + log2_ppb);
+
+	free(_image);
+	free(_bad);
+	free(_next);
+	_image = (uint8_t *)malloc(size);
+	_bad = (uint8_t *)calloc(num_blocks, 1);
+	_next = (uint16_t *)calloc(num_blocks, sizeof(uint16_t));
+
+	if (_image == nullptr || _bad == nullptr || _next == nullptr) {
+		return false;
+	}
+
+	memset(_image, 0xff, size);
+	_nand.log2_page_size = log2_page_size;
+	_nand.log2_ppb = log2_ppb;
+	_nand.num_blocks = num_blocks;
+	_fail_rate = fail_rate;
+	_seed = seed;
+	_paused = false;
+	_stats = Stats{};
+
+	for (unsigned int n = 0; n < factory_bad && n < num_blocks; n++) {
+		dhara_block_t b;
+
+		do {
+			_seed = _seed * 1103515245 + 12345;
+			b = (_seed >> 8) % num_blocks;
+		} while (_bad[b]);
+
+		_bad[b] = 1;
+	}
+
+	return true;
+}
+
+unsigned int DharaNandSim::bad_blocks() const
+{
+	unsigned int count = 0;
+
+	for (unsigned int b = 0; b < _nand.num_blocks; b++) {
+		count += _bad[b];
+	}
+
+	return count;
+}
+
+bool DharaNandSim::fail()
+{
+	if (_fail_rate == 0) {
+		return false;
+	}
+
+	_seed = _seed * 1103515245 + 12345;
+
+	if ((_seed >> 8) % _fail_rate != 0) {
+		return false;
+	}
+
+	_stats.failures++;
+	return true;
+}
+
+void DharaNandSim::account(uint32_t &counter, uint32_t us, size_t bytes)
+{
+	if (_paused) {
+		return;
+	}
+
+	counter++;
+	bench::count();
+
+	if (_timing != nullptr) {
+		auto end = std::chrono::steady_clock::now() + std::chrono::microseconds(us) +
+			   std::chrono::nanoseconds((uint64_t)_timing->byte_ns * bytes);
+
+		while (std::chrono::steady_clock::now() < end) {
+		}
+	}
+}
+
+void DharaNandSim::mark_bad(dhara_block_t b)
+{
+	if (b < _nand.num_blocks) {
+		_bad[b] = 1;
+
+		// A worn out block does not keep its data, reads of pages dhara
+		// has moved off it return zeros
+		const size_t block_size = (size_t)1 << (_nand.log2_page_size + _nand.log2_ppb);
+		memset(&_image[(size_t)b * block_size], 0, block_size);
+	}
+}
+
+int DharaNandSim::erase(dhara_block_t b, dhara_error_t *err)
+{
+	account(_stats.erases, _timing ? _timing->erase_us : 0, 0);
+
+	if (is_bad(b)) {
+		_stats.violations++;
+		dhara_set_error(err, DHARA_E_BAD_BLOCK);
+		return -1;
+	}
+
+	const size_t block_size = (size_t)1 << (_nand.log2_page_size + _nand.log2_ppb);
+	memset(&_image[(size_t)b * block_size], 0xff, block_size);
+	_next[b] = 0;
+
+	if (fail()) {
+		dhara_set_error(err, DHARA_E_BAD_BLOCK);
+		return -1;
+	}
+
+	return 0;
+}
+
+int DharaNandSim::prog(dhara_page_t p, const uint8_t *data, dhara_error_t *err)
+{
+	account(_stats.progs, _timing ? _timing->prog_us : 0, (size_t)1 << _nand.log2_page_size);
+	return program(p, data, err);
+}
+
+int DharaNandSim::program(dhara_page_t p, const uint8_t *data, dhara_error_t *err)
+{
+	const size_t page_size = (size_t)1 << _nand.log2_page_size;
+	const dhara_block_t b = p >> _nand.log2_ppb;
+	const uint16_t page = p & ((1u << _nand.log2_ppb) - 1);
+
+	if (is_bad(b) || page < _next[b]) {
+		_stats.violations++;
+		dhara_set_error(err, DHARA_E_BAD_BLOCK);
+		return -1;
+	}
+
+	// Pages skipped within the block stay erased
+	_next[b] = page + 1;
+
+	if (fail()) {
+		dhara_set_error(err, DHARA_E_BAD_BLOCK);
+		return -1;
+	}
+
+	memcpy(&_image[(size_t)p * page_size], data, page_size);
+	return 0;
+}
+
+bool DharaNandSim::is_free(dhara_page_t p) const
+{
+	const dhara_block_t b = p >> _nand.log2_ppb;
+	const uint16_t page = p & ((1u << _nand.log2_ppb) - 1);
+
+	return b < _nand.num_blocks && page >= _next[b];
+}
+
+int DharaNandSim::read(dhara_page_t p, size_t offset, size_t length, uint8_t *data, dhara_error_t *err)
+{
+	const size_t page_size = (size_t)1 << _nand.log2_page_size;
+
+	account(_stats.reads, _timing ? _timing->read_us : 0, length);
+
+	if ((p >> _nand.log2_ppb) >= _nand.num_blocks || offset + length > page_size) {
+		dhara_set_error(err, DHARA_E_ECC);
+		return -1;
+	}
+
+	memcpy(data, &_image[(size_t)p * page_size + offset], length);
+	return 0;
+}
+
+int DharaNandSim::copy(dhara_page_t src, dhara_page_t dst, dhara_error_t *err)
+{
+	// Internal data move, read into the cache register and programmed
+	// back without a bus transfer
+	account(_stats.reads, _timing ? _timing->read_us : 0, 0);
+	account(_stats.progs, _timing ? _timing->prog_us : 0, 0);
+
+	if ((src >> _nand.log2_ppb) >= _nand.num_blocks) {
+		dhara_set_error(err, DHARA_E_ECC);
+		return -1;
+	}
+
+	return program(dst, &_image[(size_t)src << _nand.log2_page_size], err);
+}
+
+// dhara driver interface
+
+extern "C" {
+
+int dhara_nand_is_bad(const struct dhara_nand *n, dhara_block_t b)
+{
+	return DharaNandSim::from(n)->is_bad(b);
+}
+
+void dhara_nand_mark_bad(const struct dhara_nand *n, dhara_block_t b)
+{
+	DharaNandSim::from(n)->mark_bad(b);
+}
+
+int dhara_nand_erase(const struct dhara_nand *n, dhara_block_t b, dhara_error_t *err)
+{
+	return DharaNandSim::from(n)->erase(b, err);
+}
+
+int dhara_nand_prog(const struct dhara_nand *n, dhara_page_t p, const uint8_t *data, dhara_error_t *err)
+{
+	return DharaNandSim::from(n)->prog(p, data, err);
+}
+
+int dhara_nand_is_free(const struct dhara_nand *n, dhara_page_t p)
+{
+	return DharaNandSim::from(n)->is_free(p);
+}
+
+int dhara_nand_read(const struct dhara_nand *n, dhara_page_t p, size_t offset, size_t length, uint8_t *data,
+		    dhara_error_t *err)
+{
+	return DharaNandSim::from(n)->read(p, offset, length, data, err);
+}
+
+int dhara_nand_copy(const struct dhara_nand *n, dhara_page_t src, dhara_page_t dst, dhara_error_t *err)
+{
+	return DharaNandSim::from(n)->copy(src, dst, err);
+}
+
+}
@@ -0,0 +1,96 @@
+#ifndef DHARA_NAND_SIM_HPP
+#define DHARA_NAND_SIM_HPP
+
+extern "C" {
+#include "nand.h"
+}
+
+#include <stdint.h>
+
+// Simulated NAND chip for dhara on the host, implementing the dhara_nand_*
+// driver functions on a RAM image. Blocks can be bad from the factory, and
+// a program or erase fails at a given rate, after which dhara marks the
+// block bad and its pages read back as zeros. Pages must be programmed in
+// order, once, into erased good blocks; anything else is counted as a
+// violation.
+//
+// Every page read, page program and block erase is passed to bench::count()
+// and, with timing set, busy-waits for the array and bus time of the chip.
+// While paused, operations neither count nor wait, which stands in for work
+// done while the application is idle.
+class DharaNandSim
+{
+public:
+	struct Timing {
+		uint32_t read_us;      // array to cache register
+		uint32_t prog_us;      // cache register to array
+		uint32_t erase_us;
+		uint32_t byte_ns;      // bus transfer
+	};
+
+	struct Stats {
+		uint32_t reads;
+		uint32_t progs;
+		uint32_t erases;
+		uint32_t failures;     // injected program/erase failures
+		uint32_t violations;   // programs out of order, into bad blocks or twice
+	};
+
+	DharaNandSim() = default;
+	~DharaNandSim();
+
+	/* @brief Allocate an erased image
+	 *
+	 * @param log2_page_size Page size, e.g. 11 for 2 KiB.
+	 * @param log2_ppb Pages per erase block, e.g. 6 for 64.
+	 * @param num_blocks Chip size in blocks.
+	 * @param factory_bad Number of blocks marked bad from the start,
+	 *                    chosen at random.
+	 * @param fail_rate One in fail_rate programs and erases fails, 0 for
+	 *                  none.
+	 * @param seed Seed of the bad block and failure choices.
+	 *
+	 * @returns false if out of memory.
+	 */
+	bool init(uint8_t log2_page_size, uint8_t log2_ppb, unsigned int num_blocks, unsigned int factory_bad,
+		  uint32_t fail_rate, uint32_t seed);
+
+	const dhara_nand *nand() const { return &_nand; }
+
+	void set_timing(const Timing *timing) { _timing = timing; }
+	void set_fail_rate(uint32_t fail_rate) { _fail_rate = fail_rate; }
+	void pause(bool paused) { _paused = paused; }
+
+	unsigned int bad_blocks() const;
+	const Stats &stats() const { return _stats; }
+	void reset_stats() { _stats = Stats{}; }
+
+	static DharaNandSim *from(const dhara_nand *n) { return (DharaNandSim *)n; }
+
+	bool is_bad(dhara_block_t b) const { return b >= _nand.num_blocks || _bad[b]; }
+	void mark_bad(dhara_block_t b);
+	int erase(dhara_block_t b, dhara_error_t *err);
+	int prog(dhara_page_t p, const uint8_t *data, dhara_error_t *err);
+	bool is_free(dhara_page_t p) const;
+	int read(dhara_page_t p, size_t offset, size_t length, uint8_t *data, dhara_error_t *err);
+	int copy(dhara_page_t src, dhara_page_t dst, dhara_error_t *err);
+
+private:
+	int program(dhara_page_t p, const uint8_t *data, dhara_error_t *err);
+	bool fail();
+	void account(uint32_t &counter, uint32_t us, size_t bytes);
+
+	// First member, dhara passes a pointer to it to the driver functions
+	dhara_nand _nand{};
+
+	uint8_t *_image{nullptr};
+	uint8_t *_bad{nullptr};
+	uint16_t *_next{nullptr};      // next page to program in each block
+	const Timing *_timing{nullptr};
+	uint32_t _fail_rate{0};
+	uint32_t _seed{1};
+	bool _paused{false};
+	Stats _stats{};
+};
+
+#endif
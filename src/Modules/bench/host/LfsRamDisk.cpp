@@ -0,0 +1,93 @@
+#include "LfsRamDisk.hpp"
+
+#include "Bench.hpp"
+
+#include <stdlib.h>
+#include <string.h>
+
+LfsRamDisk::~LfsRamDisk()
+{
+	free(_image);
+}
+
+bool LfsRamDisk::init(lfs_size_t block_count, lfs_config &config)
+{
+	free(_image);
+	_image = (uint8_t *)malloc((size_t)block_count * BLOCK_SIZE);
+
+	if (_image == nullptr) {
+		return false;
+	}
+
+	memset(_image, 0xff, (size_t)block_count * BLOCK_SIZE);
+	_block_count = block_count;
+	_stats = Stats{};
+
+	memset(&config, 0, sizeof(config));
+	config.context = this;
+	config.read = read;
+	config.prog = prog;
+	config.erase = erase;
+	config.sync = sync;
+	config.read_size = READ_SIZE;
+	config.prog_size = PROG_SIZE;
+	config.block_size = BLOCK_SIZE;
+	config.block_count = block_count;
+	config.block_cycles = 500;
+	config.cache_size = CACHE_SIZE;
+	config.lookahead_size = 16;
+	return true;
+}
+
+int LfsRamDisk::read(const lfs_config *c, lfs_block_t block, lfs_off_t off, void *buffer, lfs_size_t size)
+{
+	LfsRamDisk *disk = (LfsRamDisk *)c->context;
+
+	if (block >= disk->_block_count || off + size > BLOCK_SIZE) {
+		return LFS_ERR_IO;
+	}
+
+	memcpy(buffer, &disk->_image[(size_t)block * BLOCK_SIZE + off], size);
+	disk->_stats.reads++;
+	bench::count();
+	return LFS_ERR_OK;
+}
+
+int LfsRamDisk::prog(const lfs_config *c, lfs_block_t block, lfs_off_t off, const void *buffer, lfs_size_t size)
+{
+	LfsRamDisk *disk = (LfsRamDisk *)c->context;
+
+	if (block >= disk->_block_count || off + size > BLOCK_SIZE) {
+		return LFS_ERR_IO;
+	}
+
+	// NOR flash programming only clears bits
+	uint8_t *dst = &disk->_image[(size_t)block * BLOCK_SIZE + off];
+	const uint8_t *src = (const uint8_t *)buffer;
+
+	for (lfs_size_t i = 0; i < size; i++) {
+		dst[i] &= src[i];
+	}
+
+	disk->_stats.progs++;
+	return LFS_ERR_OK;
+}
+
+int LfsRamDisk::erase(const lfs_config *c, lfs_block_t block)
+{
+	LfsRamDisk *disk = (LfsRamDisk *)c->context;
+
+	if (block >= disk->_block_count) {
+		return LFS_ERR_IO;
+	}
+
+	memset(&disk->_image[(size_t)block * BLOCK_SIZE], 0xff, BLOCK_SIZE);
+	disk->_stats.erases++;
+	return LFS_ERR_OK;
+}
+
+int LfsRamDisk::sync(const lfs_config *c)
+{
+	(void)c;
+	return LFS_ERR_OK;
+}
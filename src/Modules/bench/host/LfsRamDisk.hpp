@@ -0,0 +1,53 @@
+#ifndef LFS_RAM_DISK_HPP
+#define LFS_RAM_DISK_HPP
+
+#include "lfs.h"
+
+#include <stdint.h>
+
+// RAM backed littlefs block device for the host benchmarks, with the
+// geometry of the QSPI volumes (4 KiB erase blocks, 256 B pages). Every
+// block device read is passed to bench::count(), so cases report reads per
+// operation.
+class LfsRamDisk
+{
+public:
+	static constexpr lfs_size_t BLOCK_SIZE = 4096;
+	static constexpr lfs_size_t READ_SIZE = 16;
+	static constexpr lfs_size_t PROG_SIZE = 256;
+	static constexpr lfs_size_t CACHE_SIZE = 256;
+
+	struct Stats {
+		uint32_t reads;
+		uint32_t progs;
+		uint32_t erases;
+	};
+
+	LfsRamDisk() = default;
+	~LfsRamDisk();
+
+	/* @brief Allocate the image and fill in a littlefs configuration
+	 *
+	 * @param block_count Volume size in blocks.
+	 * @param config Filled in with the block device and default sizes, the
+	 *               caller may adjust the optional settings before mounting.
+	 *
+	 * @returns false if out of memory.
+	 */
+	bool init(lfs_size_t block_count, lfs_config &config);
+
+	const Stats &stats() const { return _stats; }
+	void reset_stats() { _stats = Stats{}; }
+
+private:
+	static int read(const lfs_config *c, lfs_block_t block, lfs_off_t off, void *buffer, lfs_size_t size);
+	static int prog(const lfs_config *c, lfs_block_t block, lfs_off_t off, const void *buffer, lfs_size_t size);
+	static int erase(const lfs_config *c, lfs_block_t block);
+	static int sync(const lfs_config *c);
+
+	uint8_t *_image{nullptr};
+	lfs_size_t _block_count{0};
+	Stats _stats{};
+};
+
+#endif
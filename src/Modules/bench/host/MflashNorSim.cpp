@@ -0,0 +1,162 @@
+#include "MflashNorSim.hpp"
+
+#include "Bench.hpp"
+
+extern "C" {
+#include "mflash_drv.h"
+}
+
+#include <stdlib.h>
+#include <string.h>
+
+static MflashNorSim *s_sim = nullptr;
+
+MflashNorSim::~MflashNorSim()
+{
+	if (s_sim == this) {
+		s_sim = nullptr;
+	}
+
+	free(_image);
+	free(_erases);
+}
+
+bool MflashNorSim::init(uint32_t size)
+{
+	free(_image);
+	free(_erases);
+	_image = (uint8_t *)malloc(size);
+	_erases = (uint32_t *)calloc(size / MFLASH_SECTOR_SIZE, sizeof(uint32_t));
+
+	if (_image == nullptr || _erases == nullptr) {
+		return false;
+	}
+
+	_size = size;
+	_sector_size = MFLASH_SECTOR_SIZE;
+	_page_size = MFLASH_PAGE_SIZE;
+	_fail_after = UINT32_MAX;
+	_stats = Stats{};
+	memset(_image, 0xff, size);
+	s_sim = this;
+	return true;
+}
+
+void MflashNorSim::blank()
+{
+	memset(_image, 0xff, _size);
+}
+
+void MflashNorSim::reset_stats()
+{
+	_stats = Stats{};
+	memset(_erases, 0, _size / _sector_size * sizeof(uint32_t));
+}
+
+bool MflashNorSim::fail()
+{
+	if (_fail_after == 0) {
+		return true;
+	}
+
+	if (_fail_after != UINT32_MAX) {
+		_fail_after--;
+	}
+
+	return false;
+}
+
+int32_t MflashNorSim::sector_erase(uint32_t addr)
+{
+	if (addr % _sector_size != 0 || addr >= _size || fail()) {
+		return kStatus_Fail;
+	}
+
+	memset(&_image[addr], 0xff, _sector_size);
+	_erases[addr / _sector_size]++;
+	_stats.erases++;
+	bench::count();
+	return kStatus_Success;
+}
+
+int32_t MflashNorSim::page_program(uint32_t addr, const uint32_t *data)
+{
+	if (addr % _page_size != 0 || addr >= _size || fail()) {
+		return kStatus_Fail;
+	}
+
+	// The memory mapped flash can't be read while it is programmed
+	if (log2phys((void *)data, _page_size) != MFLASH_INVALID_ADDRESS) {
+		_stats.xip_sources++;
+		return kStatus_Fail;
+	}
+
+	for (uint32_t i = 0; i < _page_size; i++) {
+		if (_image[addr + i] != 0xff) {
+			_stats.violations++;
+			break;
+		}
+	}
+
+	// NOR programming only clears bits
+	for (uint32_t i = 0; i < _page_size; i++) {
+		_image[addr + i] &= ((const uint8_t *)data)[i];
+	}
+
+	_stats.progs++;
+	bench::count();
+	return kStatus_Success;
+}
+
+int32_t MflashNorSim::read(uint32_t addr, uint32_t *buffer, uint32_t len)
+{
+	if (addr > _size || len > _size - addr) {
+		return kStatus_Fail;
+	}
+
+	memcpy(buffer, &_image[addr], len);
+	return kStatus_Success;
+}
+
+void *MflashNorSim::phys2log(uint32_t addr, uint32_t len)
+{
+	return addr <= _size && len <= _size - addr ? &_image[addr] : nullptr;
+}
+
+uint32_t MflashNorSim::log2phys(void *ptr, uint32_t len)
+{
+	const uintptr_t addr = (uintptr_t)ptr - (uintptr_t)_image;
+
+	return (uintptr_t)ptr >= (uintptr_t)_image && addr <= _size && len <= _size - addr ? (uint32_t)addr
+											 : MFLASH_INVALID_ADDRESS;
+}
+
+extern "C" int32_t mflash_drv_init(void)
+{
+	return s_sim != nullptr ? kStatus_Success : kStatus_Fail;
+}
+
+extern "C" int32_t mflash_drv_sector_erase(uint32_t sector_addr)
+{
+	return s_sim->sector_erase(sector_addr);
+}
+
+extern "C" int32_t mflash_drv_page_program(uint32_t page_addr, uint32_t *data)
+{
+	return s_sim->page_program(page_addr, data);
+}
+
+extern "C" int32_t mflash_drv_read(uint32_t addr, uint32_t *buffer, uint32_t len)
+{
+	return s_sim->read(addr, buffer, len);
+}
+
+extern "C" void *mflash_drv_phys2log(uint32_t addr, uint32_t len)
+{
+	return s_sim->phys2log(addr, len);
+}
+
+extern "C" uint32_t mflash_drv_log2phys(void *ptr, uint32_t len)
+{
+	return s_sim->log2phys(ptr, len);
+}
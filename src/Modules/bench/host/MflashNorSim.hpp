@@ -0,0 +1,68 @@
+#ifndef MFLASH_NOR_SIM_HPP
+#define MFLASH_NOR_SIM_HPP
+
+#include <stdint.h>
+
+// Simulated NOR flash for mflash on the host, implementing the mflash_drv_*
+// driver functions on a RAM image mapped at physical address 0. Sectors are
+// erased to 0xff and pages programmed whole; programming a page that is not
+// blank is counted as a violation, as mflash never relies on incremental
+// writes. Programming from data inside the image fails, as the memory mapped
+// flash can't be read during a program on target. Every program and erase is
+// passed to bench::count().
+//
+// The driver functions go to the simulator initialised last. After
+// fail_after(n), the n+1th program or erase and all later ones fail without
+// touching the image, which stands in for a power loss.
+class MflashNorSim
+{
+public:
+	struct Stats {
+		uint32_t progs;
+		uint32_t erases;
+		uint32_t violations;   // programs into pages that are not blank
+		uint32_t xip_sources;  // programs refused for data inside the image
+	};
+
+	MflashNorSim() = default;
+	~MflashNorSim();
+
+	/* @brief Allocate an erased image and route the driver functions to it
+	 *
+	 * @param size Flash size, a multiple of the sector size.
+	 *
+	 * @returns false if out of memory.
+	 */
+	bool init(uint32_t size);
+
+	/* @brief Erase the whole image, without counting */
+	void blank();
+
+	void fail_after(uint32_t ops) { _fail_after = ops; }
+	void fail_never() { _fail_after = UINT32_MAX; }
+
+	const Stats &stats() const { return _stats; }
+	void reset_stats();
+
+	/* @brief Erases of the sector at the given address since reset_stats() */
+	uint32_t erases(uint32_t addr) const { return _erases[addr / _sector_size]; }
+
+	int32_t sector_erase(uint32_t addr);
+	int32_t page_program(uint32_t addr, const uint32_t *data);
+	int32_t read(uint32_t addr, uint32_t *buffer, uint32_t len);
+	void *phys2log(uint32_t addr, uint32_t len);
+	uint32_t log2phys(void *ptr, uint32_t len);
+
+private:
+	bool fail();
+
+	uint8_t *_image{nullptr};
+	uint32_t *_erases{nullptr};
+	uint32_t _size{0};
+	uint32_t _sector_size{0};
+	uint32_t _page_size{0};
+	uint32_t _fail_after{UINT32_MAX};
+	Stats _stats{};
+};
+
+#endif
@@ -0,0 +1,414 @@
+#include "SdCardSim.hpp"
+
+#include "Bench.hpp"
+
+#include <stdlib.h>
+#include <string.h>
+
+static constexpr uint32_t BLOCK_SIZE = 512;
+
+// R1 card status bits
+static constexpr uint32_t R1_OUT_OF_RANGE = 1u << 31;
+static constexpr uint32_t R1_ILLEGAL_COMMAND = 1u << 22;
+static constexpr uint32_t R1_READY_FOR_DATA = 1u << 8;
+static constexpr uint32_t R1_APP_CMD = 1u << 5;
+
+SdCardSim::~SdCardSim()
+{
+	free(_image);
+}
+
+bool SdCardSim::init(uint32_t blocks, bool cmd23, uint32_t max_block_count, uint32_t descriptor_words,
+		     uint32_t fail_rate, uint32_t seed)
+{
+	free(_image);
+	_image = (uint8_t *)malloc((size_t)blocks * BLOCK_SIZE);
+
+	if (_image == nullptr) {
+		return false;
+	}
+
+	memset(_image, 0xff, (size_t)blocks * BLOCK_SIZE);
+	_blocks = blocks;
+	_cmd23 = cmd23;
+	_fail_rate = fail_rate;
+	_seed = seed;
+	_paused = false;
+	_stats = Stats{};
+
+	_state = STATE_TRAN;
+	_app = false;
+	_block_count = 0;
+	_pre_erase = 0;
+	_address = 0;
+	_pending_blocks = 0;
+	_pending_bus_ns = 0;
+	_busy_polls = 0;
+	_busy_until = {};
+
+	_host = sdmmchost_t{};
+	_host.dmaDesBufferWordsNum = descriptor_words;
+	_host.maxBlockCount = max_block_count;
+	_host.maxBlockSize = BLOCK_SIZE;
+	_host.card = this;
+
+	return true;
+}
+
+void SdCardSim::wait(uint64_t ns)
+{
+	if (_timing == nullptr || _paused) {
+		return;
+	}
+
+	auto end = std::chrono::steady_clock::now() + std::chrono::nanoseconds(ns);
+
+	while (std::chrono::steady_clock::now() < end) {
+	}
+}
+
+bool SdCardSim::fail()
+{
+	if (_fail_rate == 0) {
+		return false;
+	}
+
+	_seed = _seed * 1103515245 + 12345;
+	return (_seed >> 8) % _fail_rate == 0;
+}
+
+bool SdCardSim::programming()
+{
+	if (_state != STATE_PRG) {
+		return false;
+	}
+
+	if (_busy_polls > 0 || std::chrono::steady_clock::now() < _busy_until) {
+		return true;
+	}
+
+	_state = STATE_TRAN;
+	return false;
+}
+
+bool SdCardSim::busy()
+{
+	if (_state == STATE_PRG && _busy_polls > 0) {
+		_busy_polls--;
+		return true;
+	}
+
+	return programming();
+}
+
+void SdCardSim::wait_busy()
+{
+	_busy_polls = 0;
+
+	while (programming()) {
+	}
+}
+
+uint32_t SdCardSim::status() const
+{
+	return ((uint32_t)_state << 9) | (_state == STATE_TRAN ? R1_READY_FOR_DATA : 0);
+}
+
+void SdCardSim::program()
+{
+	// The card programs while the blocks come in, what outruns the bus
+	// and the commit are left for after the last block
+	const uint32_t erased = _pending_blocks < _pre_erase ? _pending_blocks : _pre_erase;
+	uint64_t busy_ns = 0;
+
+	if (_timing != nullptr && !_paused) {
+		const uint64_t prog_ns =
+			(uint64_t)erased * _timing->prog_erased_ns + (uint64_t)(_pending_blocks - erased) * _timing->prog_ns;
+		busy_ns = (uint64_t)_timing->commit_us * 1000 + (prog_ns > _pending_bus_ns ? prog_ns - _pending_bus_ns : 0);
+		_busy_polls = 0;
+
+	} else {
+		_busy_polls = 2;
+	}
+
+	_stats.pre_erased += erased;
+	_busy_until = std::chrono::steady_clock::now() + std::chrono::nanoseconds(busy_ns);
+	_state = STATE_PRG;
+	_block_count = 0;
+	_pre_erase = 0;
+	_pending_blocks = 0;
+	_pending_bus_ns = 0;
+}
+
+status_t SdCardSim::command(sdmmchost_cmd_t *command, uint32_t blocks)
+{
+	const bool app = _app;
+	uint32_t response = 0;
+
+	if (!_paused) {
+		_stats.commands++;
+		bench::count();
+	}
+
+	wait(_timing ? _timing->command_ns : 0);
+	_app = false;
+
+	switch (command->index) {
+	case 13:
+		programming();
+		response = status();
+		break;
+
+	case 12:
+		if (_state == STATE_RCV) {
+			program();
+
+		} else if (_state == STATE_DATA) {
+			_block_count = 0;
+			_state = STATE_TRAN;
+
+		} else {
+			_stats.violations++;
+			response = R1_ILLEGAL_COMMAND;
+		}
+
+		response |= status();
+
+		// R1b, the host waits for DAT0
+		wait_busy();
+		break;
+
+	default:
+		if (programming() || _state != STATE_TRAN) {
+			_stats.violations++;
+			response = status() | R1_ILLEGAL_COMMAND;
+			break;
+		}
+
+		response = status();
+
+		if (command->index == 55) {
+			_app = true;
+			response |= R1_APP_CMD;
+
+		} else if (command->index == 23 && app) {
+			_pre_erase = command->argument & 0x7fffff;
+			response |= R1_APP_CMD;
+
+		} else if (command->index == 23) {
+			_block_count = command->argument;
+
+		} else if (command->index == 18 || command->index == 25) {
+			if (blocks == 0 || (_block_count != 0 && _block_count != blocks)) {
+				_stats.violations++;
+				response |= R1_ILLEGAL_COMMAND;
+
+			} else if (command->argument >= _blocks || blocks > _blocks - command->argument) {
+				response |= R1_OUT_OF_RANGE;
+
+			} else {
+				_address = command->argument;
+				_state = command->index == 25 ? STATE_RCV : STATE_DATA;
+			}
+
+		} else {
+			_stats.violations++;
+			response |= R1_ILLEGAL_COMMAND;
+		}
+	}
+
+	command->response[0] = response;
+	return (response & command->responseErrorFlags) != 0 ? kStatus_Fail : kStatus_Success;
+}
+
+status_t SdCardSim::data(const Segment *segments, uint32_t count, bool write)
+{
+	uint32_t blocks = 0;
+	uint32_t done = 0;
+
+	for (uint32_t i = 0; i < count; i++) {
+		blocks += segments[i].size / BLOCK_SIZE;
+	}
+
+	// A CRC error part way through
+	const uint32_t fail_at = fail() ? (_seed >> 4) % blocks : blocks;
+
+	for (uint32_t i = 0; i < count && done < fail_at; i++) {
+		for (uint32_t offset = 0; offset < segments[i].size && done < fail_at; offset += BLOCK_SIZE, done++) {
+			uint8_t *block = &_image[(size_t)_address * BLOCK_SIZE];
+
+			if (write) {
+				memcpy(block, &segments[i].data[offset], BLOCK_SIZE);
+
+			} else {
+				memcpy(&segments[i].data[offset], block, BLOCK_SIZE);
+			}
+
+			_address++;
+		}
+	}
+
+	const uint64_t bus_ns = _timing ? (uint64_t)done * BLOCK_SIZE * _timing->byte_ns : 0;
+	wait(bus_ns + (!write && _timing ? (uint64_t)_timing->access_us * 1000 : 0));
+
+	if (write) {
+		_pending_blocks += done;
+		_pending_bus_ns += bus_ns;
+	}
+
+	if (done < blocks) {
+		// The card waits for the rest of the blocks, or CMD12
+		_stats.failures++;
+		return kStatus_Fail;
+	}
+
+	if (!_paused) {
+		(write ? _stats.blocks_written : _stats.blocks_read) += blocks;
+	}
+
+	if (_block_count != 0) {
+		// Predefined transfer complete
+		if (write) {
+			program();
+
+		} else {
+			_block_count = 0;
+			_state = STATE_TRAN;
+		}
+	}
+
+	return kStatus_Success;
+}
+
+status_t SdCardSim::transfer(sdmmchost_cmd_t *command, const Segment *segments, uint32_t count, bool write,
+			     bool auto12, bool auto23)
+{
+	uint32_t size = 0;
+	uint32_t descriptors = 0;
+
+	for (uint32_t i = 0; i < count; i++) {
+		if (segments[i].data == nullptr || ((uintptr_t)segments[i].data & 3) != 0 || (segments[i].size & 3) != 0) {
+			_stats.violations++;
+			return kStatus_Fail;
+		}
+
+		size += segments[i].size;
+		descriptors += (segments[i].size + SDMMCHOST_DMA_DESCRIPTOR_MAX_LENGTH - 1) / SDMMCHOST_DMA_DESCRIPTOR_MAX_LENGTH;
+	}
+
+	// The host fails before sending anything if it can't build the
+	// descriptor chain or the block count is too large
+	if (size % BLOCK_SIZE != 0 || size / BLOCK_SIZE > _host.maxBlockCount ||
+	    descriptors * SDMMCHOST_DMA_DESCRIPTOR_WORDS > _host.dmaDesBufferWordsNum) {
+		_stats.violations++;
+		return kStatus_Fail;
+	}
+
+	const uint32_t blocks = size / BLOCK_SIZE;
+	status_t error;
+
+	if (count > 0 && auto23) {
+		sdmmchost_cmd_t set_block_count{};
+		set_block_count.index = 23;
+		set_block_count.argument = blocks;
+		set_block_count.responseType = kCARD_ResponseTypeR1;
+		set_block_count.responseErrorFlags = command->responseErrorFlags;
+
+		error = this->command(&set_block_count, 0);
+
+		if (error != kStatus_Success) {
+			return error;
+		}
+	}
+
+	error = this->command(command, blocks);
+
+	if (error != kStatus_Success || count == 0) {
+		return error;
+	}
+
+	error = data(segments, count, write);
+
+	if (error == kStatus_Success && auto12) {
+		sdmmchost_cmd_t stop{};
+		stop.index = 12;
+		stop.type = kCARD_CommandTypeAbort;
+		stop.responseType = kCARD_ResponseTypeR1b;
+		stop.responseErrorFlags = command->responseErrorFlags;
+
+		error = this->command(&stop, 0);
+	}
+
+	return error;
+}
+
+status_t SdCardSim::transfer(sdmmchost_cmd_t *command, sdmmchost_data_t *data)
+{
+	if (data == nullptr) {
+		return transfer(command, nullptr, 0, false, false, false);
+	}
+
+	const bool write = data->txData != nullptr;
+	const Segment segment = {write ? (uint8_t *)(uintptr_t)data->txData : (uint8_t *)data->rxData,
+				 (uint32_t)(data->blockSize * data->blockCount)};
+
+	if (data->blockSize != BLOCK_SIZE) {
+		_stats.violations++;
+		return kStatus_Fail;
+	}
+
+	return transfer(command, &segment, 1, write, data->enableAutoCommand12, data->enableAutoCommand23);
+}
+
+status_t SdCardSim::transfer(sdmmchost_cmd_t *command, sdmmchost_scatter_gather_data_t *data)
+{
+	if (data == nullptr) {
+		return transfer(command, nullptr, 0, false, false, false);
+	}
+
+	Segment segments[MAX_SEGMENTS];
+	uint32_t count = 0;
+
+	for (sdmmchost_scatter_gather_data_list_t *list = &data->sgData; list != nullptr; list = list->dataList) {
+		if (count == MAX_SEGMENTS || data->blockSize != BLOCK_SIZE) {
+			_stats.violations++;
+			return kStatus_Fail;
+		}
+
+		segments[count++] = {(uint8_t *)list->dataAddr, list->dataSize};
+	}
+
+	return transfer(command, segments, count, data->dataDirection == kUSDHC_TransferDirectionSend,
+			data->enableAutoCommand12, data->enableAutoCommand23);
+}
+
+// Host adapter
+
+extern "C" {
+
+bool SDMMCHOST_IsCardBusy(sdmmchost_t *host)
+{
+	return SdCardSim::from(host)->busy();
+}
+
+status_t SDMMCHOST_TransferFunction(sdmmchost_t *host, sdmmchost_transfer_t *content)
+{
+	return SdCardSim::from(host)->transfer(content->command, content->data);
+}
+
+status_t SDMMCHOST_ScatterGatherTransferFunction(sdmmchost_t *host, sdmmchost_scatter_gather_transfer_t *content)
+{
+	return SdCardSim::from(host)->transfer(content->command, content->data);
+}
+
+uint32_t SDMMC_OSADelayUs(uint32_t microseconds)
+{
+	auto end = std::chrono::steady_clock::now() + std::chrono::microseconds(microseconds);
+
+	while (std::chrono::steady_clock::now() < end) {
+	}
+
+	return microseconds;
+}
+
+}
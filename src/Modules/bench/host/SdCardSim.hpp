@@ -0,0 +1,131 @@
+#ifndef SD_CARD_SIM_HPP
+#define SD_CARD_SIM_HPP
+
+#include "fsl_sdmmc_host.h"
+
+#include <chrono>
+#include <stdint.h>
+
+// Simulated SD card behind the stand-in host adapter (fsl_sdmmc_host.h), a
+// RAM image of 512 byte blocks and the transfer state machine of the card
+// for the commands of block reads and writes: CMD12, CMD13, CMD18, CMD23,
+// CMD25, CMD55 and ACMD23. Multi-block writes end in the programming state,
+// busy on DAT0, after a predefined block count (CMD23) or CMD12. Commands
+// other than CMD12/CMD13 while the card is busy, receiving or sending, and
+// descriptor chains the host couldn't build are counted as violations and
+// fail.
+//
+// One in fail_rate data transfers fails with a CRC error part way, leaving
+// the card receiving or sending until CMD12.
+//
+// Every command on the bus, including auto CMD12/CMD23, is passed to
+// bench::count(). With timing set, commands and data busy-wait for the bus
+// time, and the card stays busy after a write for the time it takes to
+// program what outran the bus and commit the write, in the background of
+// the host. Without timing, the card stays busy for two DAT0 polls.
+class SdCardSim
+{
+public:
+	struct Timing {
+		uint32_t command_ns;     // command, response and host interrupt
+		uint32_t byte_ns;        // data bus
+		uint32_t access_us;      // read access time before the first block
+		uint32_t commit_us;      // after the last block of a write
+		uint32_t prog_ns;        // programming one block
+		uint32_t prog_erased_ns; // programming one pre-erased block
+	};
+
+	struct Stats {
+		uint32_t commands;
+		uint32_t blocks_written; // in transfers which completed
+		uint32_t blocks_read;
+		uint32_t pre_erased;     // blocks written after ACMD23
+		uint32_t failures;       // injected CRC errors
+		uint32_t violations;
+	};
+
+	SdCardSim() = default;
+	~SdCardSim();
+
+	/* @brief Allocate an erased card
+	 *
+	 * @param blocks Card size in blocks.
+	 * @param cmd23 The card supports CMD23 (SCR), only recorded for the
+	 *              card driver to look up.
+	 * @param max_block_count Maximum block count of the host.
+	 * @param descriptor_words DMA descriptor buffer size of the host.
+	 * @param fail_rate One in fail_rate data transfers fails, 0 for none.
+	 * @param seed Seed of the failures.
+	 *
+	 * @returns false if out of memory.
+	 */
+	bool init(uint32_t blocks, bool cmd23, uint32_t max_block_count, uint32_t descriptor_words, uint32_t fail_rate,
+		  uint32_t seed);
+
+	sdmmchost_t *host() { return &_host; }
+	uint32_t blocks() const { return _blocks; }
+	bool cmd23() const { return _cmd23; }
+	const uint8_t *image() const { return _image; }
+
+	void set_timing(const Timing *timing) { _timing = timing; }
+	void set_fail_rate(uint32_t fail_rate) { _fail_rate = fail_rate; }
+	void pause(bool paused) { _paused = paused; }
+
+	const Stats &stats() const { return _stats; }
+	void reset_stats() { _stats = Stats{}; }
+
+	static SdCardSim *from(sdmmchost_t *host) { return (SdCardSim *)host->card; }
+
+	bool busy();
+	status_t transfer(sdmmchost_cmd_t *command, sdmmchost_data_t *data);
+	status_t transfer(sdmmchost_cmd_t *command, sdmmchost_scatter_gather_data_t *data);
+
+private:
+	struct Segment {
+		uint8_t *data;
+		uint32_t size;
+	};
+
+	enum State : uint32_t {
+		STATE_TRAN = 4,
+		STATE_DATA = 5,
+		STATE_RCV = 6,
+		STATE_PRG = 7,
+	};
+
+	static constexpr uint32_t MAX_SEGMENTS = 64;
+
+	status_t transfer(sdmmchost_cmd_t *command, const Segment *segments, uint32_t count, bool write, bool auto12,
+			  bool auto23);
+	status_t command(sdmmchost_cmd_t *command, uint32_t blocks);
+	status_t data(const Segment *segments, uint32_t count, bool write);
+	void program();
+	bool programming();
+	void wait_busy();
+	uint32_t status() const;
+	bool fail();
+	void wait(uint64_t ns);
+
+	sdmmchost_t _host{};
+
+	uint8_t *_image{nullptr};
+	uint32_t _blocks{0};
+	bool _cmd23{false};
+	const Timing *_timing{nullptr};
+	uint32_t _fail_rate{0};
+	uint32_t _seed{1};
+	bool _paused{false};
+	Stats _stats{};
+
+	State _state{STATE_TRAN};
+	bool _app{false};               // CMD55 received
+	uint32_t _block_count{0};       // CMD23, 0 for open-ended
+	uint32_t _pre_erase{0};         // ACMD23
+	uint32_t _address{0};           // next block of the current transfer
+	uint32_t _pending_blocks{0};    // received, not programmed yet
+	uint64_t _pending_bus_ns{0};    // bus time of the received blocks
+	uint32_t _busy_polls{0};
+	std::chrono::steady_clock::time_point _busy_until{};
+};
+
+#endif
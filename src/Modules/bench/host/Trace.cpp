@@ -0,0 +1,290 @@
+#include "Trace.hpp"
+
+#include <stdlib.h>
+#include <string.h>
+
+static constexpr uint32_t LOG_RECORDS = 8192;
+static constexpr uint32_t LOG_RECORD_MIN = 64;
+static constexpr uint32_t LOG_RECORD_MAX = 1024;
+static constexpr uint32_t LOG_SYNC_RECORDS = 16;
+static constexpr uint32_t LOG_SIZE = 512 * 1024;
+static constexpr uint32_t LOG_FILES = 4;
+static constexpr uint32_t LOG_INDEX_SIZE = 16;
+
+static constexpr uint32_t CONFIG_FILES = 8;
+static constexpr uint32_t CONFIG_SIZE_MIN = 64;
+static constexpr uint32_t CONFIG_SIZE_MAX = 512;
+static constexpr uint32_t CONFIG_UPDATES = 2000;
+static constexpr uint32_t CONFIG_READ_EVERY = 100;
+
+static constexpr uint32_t ASSET_FILES = 24;
+static constexpr uint32_t ASSET_CHUNK = 4096;
+static constexpr uint32_t ASSET_CHUNKS_MAX = 64;
+static constexpr uint32_t ASSET_LOADS = 400;
+static constexpr uint32_t ASSET_PART = 16 * 1024;
+
+static const char *const TYPE_NAMES[] = {"mkdir", "open", "write", "read", "seek", "sync", "close", "remove"};
+static const char *const MODE_NAMES[] = {"r", "r+", "w", "a"};
+
+const char *Trace::type_name(Type type)
+{
+	return TYPE_NAMES[type];
+}
+
+uint32_t Trace::random()
+{
+	_seed = _seed * 1103515245 + 12345;
+	return _seed >> 8;
+}
+
+uint32_t Trace::path(const char *path)
+{
+	auto it = _index.find(path);
+
+	if (it != _index.end()) {
+		return it->second;
+	}
+
+	_paths.push_back(path);
+	_index.emplace(path, (uint32_t)_paths.size() - 1);
+	return (uint32_t)_paths.size() - 1;
+}
+
+void Trace::add(Type type, const char *path, uint32_t arg, Mode mode)
+{
+	_ops.push_back(Op{type, mode, this->path(path), arg, (uint32_t)_ops.size() + 1});
+}
+
+bool Trace::load(const char *file)
+{
+	FILE *in = fopen(file, "r");
+	char line[512];
+	uint32_t number = 0;
+	bool ok = true;
+
+	if (in == nullptr) {
+		fprintf(stderr, "%s: can't open\n", file);
+		return false;
+	}
+
+	_name = file;
+	_ops.clear();
+	_paths.clear();
+	_index.clear();
+
+	while (fgets(line, sizeof(line), in) != nullptr) {
+		char command[16];
+		char path[256];
+		char arg[16];
+		int fields;
+		unsigned int type;
+
+		number++;
+
+		if (strchr(line, '#') != nullptr) {
+			*strchr(line, '#') = '\0';
+		}
+
+		fields = sscanf(line, "%15s %255s %15s", command, path, arg);
+
+		if (fields <= 0) {
+			continue;
+		}
+
+		for (type = 0; type <= REMOVE && strcmp(command, TYPE_NAMES[type]) != 0; type++) {
+		}
+
+		const bool with_arg = type == OPEN || type == WRITE || type == READ || type == SEEK;
+		Op op{(Type)type, MODE_READ, 0, 0, number};
+
+		if (type > REMOVE || fields != (with_arg ? 3 : 2)) {
+			fprintf(stderr, "%s:%u: syntax error\n", file, number);
+			ok = false;
+			continue;
+		}
+
+		if (type == OPEN) {
+			unsigned int mode;
+
+			for (mode = 0; mode <= MODE_APPEND && strcmp(arg, MODE_NAMES[mode]) != 0; mode++) {
+			}
+
+			if (mode > MODE_APPEND) {
+				fprintf(stderr, "%s:%u: unknown mode %s\n", file, number, arg);
+				ok = false;
+				continue;
+			}
+
+			op.mode = (Mode)mode;
+
+		} else if (with_arg) {
+			op.arg = (uint32_t)strtoul(arg, nullptr, 0);
+		}
+
+		op.path = this->path(path);
+		_ops.push_back(op);
+	}
+
+	fclose(in);
+	return ok;
+}
+
+void Trace::save(FILE *out) const
+{
+	fprintf(out, "# %s\n", _name.c_str());
+
+	for (const Op &op : _ops) {
+		fprintf(out, "%s %s", TYPE_NAMES[op.type], _paths[op.path].c_str());
+
+		if (op.type == OPEN) {
+			fprintf(out, " %s", MODE_NAMES[op.mode]);
+
+		} else if (op.type == WRITE || op.type == READ || op.type == SEEK) {
+			fprintf(out, " %u", op.arg);
+		}
+
+		fprintf(out, "\n");
+	}
+}
+
+bool Trace::generate(const char *name, uint32_t scale)
+{
+	_name = name;
+	_ops.clear();
+	_paths.clear();
+	_index.clear();
+	_seed = 1;
+
+	if (strcmp(name, "logger") == 0) {
+		generate_logger(scale);
+
+	} else if (strcmp(name, "config") == 0) {
+		generate_config(scale);
+
+	} else if (strcmp(name, "assets") == 0) {
+		generate_assets(scale);
+
+	} else {
+		return false;
+	}
+
+	return true;
+}
+
+void Trace::generate_logger(uint32_t scale)
+{
+	char log[32];
+	uint32_t segment = 0;
+	uint32_t size = 0;
+
+	add(MKDIR, "/log");
+	snprintf(log, sizeof(log), "/log/%05u.bin", segment);
+	add(OPEN, log, 0, MODE_WRITE);
+
+	for (uint32_t record = 0; record < LOG_RECORDS * scale; record++) {
+		const uint32_t n = LOG_RECORD_MIN + random() % (LOG_RECORD_MAX - LOG_RECORD_MIN + 1);
+
+		add(WRITE, log, n);
+		size += n;
+
+		if ((record + 1) % LOG_SYNC_RECORDS == 0) {
+			add(SYNC, log);
+		}
+
+		if (size >= LOG_SIZE) {
+			add(CLOSE, log);
+			segment++;
+			size = 0;
+
+			if (segment >= LOG_FILES) {
+				snprintf(log, sizeof(log), "/log/%05u.bin", segment - LOG_FILES);
+				add(REMOVE, log);
+			}
+
+			add(OPEN, "/log/index", 0, MODE_WRITE);
+			add(WRITE, "/log/index", LOG_INDEX_SIZE);
+			add(CLOSE, "/log/index");
+
+			snprintf(log, sizeof(log), "/log/%05u.bin", segment);
+			add(OPEN, log, 0, MODE_WRITE);
+		}
+	}
+
+	add(CLOSE, log);
+}
+
+void Trace::generate_config(uint32_t scale)
+{
+	char file[32];
+	uint32_t sizes[CONFIG_FILES];
+
+	add(MKDIR, "/cfg");
+
+	for (uint32_t key = 0; key < CONFIG_FILES; key++) {
+		sizes[key] = CONFIG_SIZE_MIN + random() % (CONFIG_SIZE_MAX - CONFIG_SIZE_MIN + 1);
+		snprintf(file, sizeof(file), "/cfg/key%u", key);
+		add(OPEN, file, 0, MODE_WRITE);
+		add(WRITE, file, sizes[key]);
+		add(CLOSE, file);
+	}
+
+	for (uint32_t update = 0; update < CONFIG_UPDATES * scale; update++) {
+		// Half the updates to the first file, a quarter to the second...
+		const uint32_t r = random() % 16;
+		const uint32_t key = r < 8 ? 0 : r < 12 ? 1 : r < 14 ? 2 : 3 + random() % (CONFIG_FILES - 3);
+
+		snprintf(file, sizeof(file), "/cfg/key%u", key);
+		add(OPEN, file, 0, MODE_WRITE);
+		add(WRITE, file, sizes[key]);
+		add(CLOSE, file);
+
+		for (uint32_t k = 0; (update + 1) % CONFIG_READ_EVERY == 0 && k < CONFIG_FILES; k++) {
+			snprintf(file, sizeof(file), "/cfg/key%u", k);
+			add(OPEN, file, 0, MODE_READ);
+			add(READ, file, sizes[k]);
+			add(CLOSE, file);
+		}
+	}
+}
+
+void Trace::generate_assets(uint32_t scale)
+{
+	char file[32];
+	uint32_t sizes[ASSET_FILES];
+
+	add(MKDIR, "/assets");
+
+	for (uint32_t asset = 0; asset < ASSET_FILES; asset++) {
+		sizes[asset] = ASSET_CHUNK * (1 + random() % ASSET_CHUNKS_MAX);
+		snprintf(file, sizeof(file), "/assets/a%02u.bin", asset);
+		add(OPEN, file, 0, MODE_WRITE);
+
+		for (uint32_t off = 0; off < sizes[asset]; off += ASSET_CHUNK) {
+			add(WRITE, file, ASSET_CHUNK);
+		}
+
+		add(CLOSE, file);
+	}
+
+	for (uint32_t load = 0; load < ASSET_LOADS * scale; load++) {
+		const uint32_t asset = random() % ASSET_FILES;
+		uint32_t off = 0;
+		uint32_t end = sizes[asset];
+
+		snprintf(file, sizeof(file), "/assets/a%02u.bin", asset);
+		add(OPEN, file, 0, MODE_READ);
+
+		if (random() % 2 == 0) {
+			// Part of the asset, e.g. one frame of an animation
+			off = random() % (sizes[asset] / ASSET_CHUNK) * ASSET_CHUNK;
+			end = off + ASSET_PART < end ? off + ASSET_PART : end;
+			add(SEEK, file, off);
+		}
+
+		for (; off < end; off += ASSET_CHUNK) {
+			add(READ, file, ASSET_CHUNK);
+		}
+
+		add(CLOSE, file);
+	}
+}
@@ -0,0 +1,106 @@
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// File I/O trace replayed by trace_replay, recorded from an application or
+// generated. A trace is text, one operation per line, '#' starts a
+// comment:
+//
+//   mkdir  <path>
+//   open   <path> r|r+|w|a     as fopen(), w creates or truncates, a
+//                              creates and writes at the end
+//   write  <path> <bytes>
+//   read   <path> <bytes>
+//   seek   <path> <offset>
+//   sync   <path>
+//   close  <path>
+//   remove <path>
+//
+// A path is open at most once at a time. Only the lengths are recorded,
+// the replay writes its own data and checks what it reads back.
+//
+// The generated traces stand for the storage uses of the products:
+//
+//   logger  records of 64 B to 1 KiB appended to a log, synced every 16
+//           records and rotated every 512 KiB keeping 4 logs, and an index
+//           file rewritten at every rotation
+//   config  8 settings files of 64 to 512 B, rewritten whole, mostly the
+//           first ones, and all read back now and then
+//   assets  24 files of 4 to 256 KiB written once, then loaded whole or
+//           in part with 4 KiB reads
+class Trace
+{
+public:
+	enum Type : uint8_t {
+		MKDIR,
+		OPEN,
+		WRITE,
+		READ,
+		SEEK,
+		SYNC,
+		CLOSE,
+		REMOVE,
+	};
+
+	enum Mode : uint8_t {
+		MODE_READ,         // r
+		MODE_UPDATE,       // r+
+		MODE_WRITE,        // w
+		MODE_APPEND,       // a
+	};
+
+	struct Op {
+		Type type;
+		Mode mode;
+		uint32_t path;     // index of paths()
+		uint32_t arg;      // bytes or offset
+		uint32_t line;
+	};
+
+	/* @brief Read a trace file
+	 *
+	 * @returns false if the file can't be read or has errors, which are
+	 *          printed.
+	 */
+	bool load(const char *file);
+
+	/* @brief Generate one of the traces above
+	 *
+	 * @param name logger, config or assets.
+	 * @param scale Multiplies the number of records, updates or loads, the
+	 *              space used stays the same.
+	 *
+	 * @returns false if there is no such trace.
+	 */
+	bool generate(const char *name, uint32_t scale);
+
+	void save(FILE *out) const;
+
+	const char *name() const { return _name.c_str(); }
+	const std::vector<Op> &ops() const { return _ops; }
+	const std::vector<std::string> &paths() const { return _paths; }
+
+	static const char *type_name(Type type);
+
+private:
+	uint32_t path(const char *path);
+	void add(Type type, const char *path, uint32_t arg = 0, Mode mode = MODE_READ);
+	uint32_t random();
+
+	void generate_logger(uint32_t scale);
+	void generate_config(uint32_t scale);
+	void generate_assets(uint32_t scale);
+
+	std::string _name;
+	std::vector<Op> _ops;
+	std::vector<std::string> _paths;
+	std::unordered_map<std::string, uint32_t> _index;
+	uint32_t _seed{1};
+};
+
+#endif
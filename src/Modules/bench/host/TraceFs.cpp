@@ -0,0 +1,690 @@
+#include "TraceFs.hpp"
+
+#include "diskio.h"
+#include "lfs.h"
+
+extern "C" {
+#include "map.h"
+}
+
+#include <string.h>
+
+static constexpr lfs_size_t LFS_BLOCK_CYCLES = 500;
+static constexpr lfs_size_t LFS_LOOKAHEAD_SIZE = 16;
+static constexpr lfs_size_t LFS_BCACHE_LINES = 16;
+static constexpr lfs_size_t LFS_READAHEAD = 1024;
+
+static constexpr uint32_t SECTOR_SIZE = 512;
+static constexpr uint8_t DHARA_GC_RATIO = 4;
+
+// littlefs
+
+class LittlefsTraceFs : public TraceFs
+{
+public:
+	LittlefsTraceFs(BlockDevice *device, bool cached);
+	~LittlefsTraceFs() override;
+
+	bool format() override;
+	bool remount() override;
+	int mkdir(const char *path) override;
+	int open(uint32_t file, const char *path, Trace::Mode mode) override;
+	int write(uint32_t file, const void *buffer, uint32_t size) override;
+	int read(uint32_t file, void *buffer, uint32_t size) override;
+	int seek(uint32_t file, uint32_t offset) override;
+	int sync(uint32_t file) override;
+	int close(uint32_t file) override;
+	int remove(const char *path) override;
+
+private:
+	static int bd_read(const lfs_config *c, lfs_block_t block, lfs_off_t off, void *buffer, lfs_size_t size);
+	static int bd_prog(const lfs_config *c, lfs_block_t block, lfs_off_t off, const void *buffer, lfs_size_t size);
+	static int bd_erase(const lfs_config *c, lfs_block_t block);
+	static int bd_sync(const lfs_config *c);
+
+	lfs_file_t *file(uint32_t file) { return file < _files.size() ? _files[file] : nullptr; }
+	void unmount();
+
+	BlockDevice *_device;
+	lfs_config _config{};
+	lfs_t _lfs{};
+	bool _mounted{false};
+	std::vector<lfs_file_t *> _files;
+};
+
+LittlefsTraceFs::LittlefsTraceFs(BlockDevice *device, bool cached) : _device(device)
+{
+	const BlockDevice::Geometry &geometry = device->geometry();
+
+	_config.context = this;
+	_config.read = bd_read;
+	_config.prog = bd_prog;
+	_config.erase = bd_erase;
+	_config.sync = bd_sync;
+	_config.read_size = geometry.read_size;
+	_config.prog_size = geometry.prog_size;
+	_config.block_size = geometry.erase_size;
+	_config.block_count = geometry.block_count;
+	_config.block_cycles = LFS_BLOCK_CYCLES;
+	_config.cache_size = geometry.prog_size;
+	_config.lookahead_size = LFS_LOOKAHEAD_SIZE;
+
+	if (cached) {
+		_config.bcache_lines = LFS_BCACHE_LINES;
+		_config.bcache_readahead = LFS_READAHEAD;
+		_config.freemap = true;
+	}
+}
+
+LittlefsTraceFs::~LittlefsTraceFs()
+{
+	unmount();
+}
+
+int LittlefsTraceFs::bd_read(const lfs_config *c, lfs_block_t block, lfs_off_t off, void *buffer, lfs_size_t size)
+{
+	LittlefsTraceFs *fs = (LittlefsTraceFs *)c->context;
+	return fs->_device->read((uint64_t)block * c->block_size + off, buffer, size) == 0 ? LFS_ERR_OK : LFS_ERR_IO;
+}
+
+int LittlefsTraceFs::bd_prog(const lfs_config *c, lfs_block_t block, lfs_off_t off, const void *buffer,
+			     lfs_size_t size)
+{
+	LittlefsTraceFs *fs = (LittlefsTraceFs *)c->context;
+	return fs->_device->prog((uint64_t)block * c->block_size + off, buffer, size) == 0 ? LFS_ERR_OK : LFS_ERR_IO;
+}
+
+int LittlefsTraceFs::bd_erase(const lfs_config *c, lfs_block_t block)
+{
+	LittlefsTraceFs *fs = (LittlefsTraceFs *)c->context;
+	return fs->_device->erase(block) == 0 ? LFS_ERR_OK : LFS_ERR_IO;
+}
+
+int LittlefsTraceFs::bd_sync(const lfs_config *c)
+{
+	LittlefsTraceFs *fs = (LittlefsTraceFs *)c->context;
+	return fs->_device->sync() == 0 ? LFS_ERR_OK : LFS_ERR_IO;
+}
+
+void LittlefsTraceFs::unmount()
+{
+	for (uint32_t f = 0; f < _files.size(); f++) {
+		close(f);
+	}
+
+	if (_mounted) {
+		lfs_unmount(&_lfs);
+		_mounted = false;
+	}
+}
+
+bool LittlefsTraceFs::format()
+{
+	unmount();
+	_mounted = lfs_format(&_lfs, &_config) == LFS_ERR_OK && lfs_mount(&_lfs, &_config) == LFS_ERR_OK;
+	return _mounted;
+}
+
+bool LittlefsTraceFs::remount()
+{
+	unmount();
+	_mounted = lfs_mount(&_lfs, &_config) == LFS_ERR_OK;
+	return _mounted;
+}
+
+int LittlefsTraceFs::mkdir(const char *path)
+{
+	return lfs_mkdir(&_lfs, path);
+}
+
+int LittlefsTraceFs::open(uint32_t file, const char *path, Trace::Mode mode)
+{
+	static const int FLAGS[] = {
+		LFS_O_RDONLY,
+		LFS_O_RDWR,
+		LFS_O_RDWR | LFS_O_CREAT | LFS_O_TRUNC,
+		LFS_O_WRONLY | LFS_O_CREAT | LFS_O_APPEND,
+	};
+
+	if (file >= _files.size()) {
+		_files.resize(file + 1, nullptr);
+	}
+
+	if (_files[file] != nullptr) {
+		return LFS_ERR_INVAL;
+	}
+
+	lfs_file_t *f = new lfs_file_t;
+	const int err = lfs_file_open(&_lfs, f, path, FLAGS[mode]);
+
+	if (err < 0) {
+		delete f;
+		return err;
+	}
+
+	_files[file] = f;
+	return 0;
+}
+
+int LittlefsTraceFs::write(uint32_t file, const void *buffer, uint32_t size)
+{
+	lfs_file_t *f = this->file(file);
+	return f != nullptr ? (int)lfs_file_write(&_lfs, f, buffer, size) : LFS_ERR_BADF;
+}
+
+int LittlefsTraceFs::read(uint32_t file, void *buffer, uint32_t size)
+{
+	lfs_file_t *f = this->file(file);
+	return f != nullptr ? (int)lfs_file_read(&_lfs, f, buffer, size) : LFS_ERR_BADF;
+}
+
+int LittlefsTraceFs::seek(uint32_t file, uint32_t offset)
+{
+	lfs_file_t *f = this->file(file);
+	const lfs_soff_t pos = f != nullptr ? lfs_file_seek(&_lfs, f, offset, LFS_SEEK_SET) : LFS_ERR_BADF;
+	return pos < 0 ? (int)pos : 0;
+}
+
+int LittlefsTraceFs::sync(uint32_t file)
+{
+	lfs_file_t *f = this->file(file);
+	return f != nullptr ? lfs_file_sync(&_lfs, f) : LFS_ERR_BADF;
+}
+
+int LittlefsTraceFs::close(uint32_t file)
+{
+	lfs_file_t *f = this->file(file);
+
+	if (f == nullptr) {
+		return LFS_ERR_BADF;
+	}
+
+	const int err = lfs_file_close(&_lfs, f);
+	delete f;
+	_files[file] = nullptr;
+	return err;
+}
+
+int LittlefsTraceFs::remove(const char *path)
+{
+	return lfs_remove(&_lfs, path);
+}
+
+TraceFs *trace_fs_littlefs(BlockDevice *device, bool cached)
+{
+	return new LittlefsTraceFs(device, cached);
+}
+
+// Sector disks under FatFs
+
+class SectorDisk
+{
+public:
+	virtual ~SectorDisk() = default;
+
+	// Make the disk ready, erased (format) or as left by the last mount
+	virtual bool start(bool format) = 0;
+	virtual LBA_t sectors() const = 0;
+	virtual DWORD block_sectors() const = 0;
+	virtual DRESULT read(BYTE *buff, LBA_t sector, UINT count) = 0;
+	virtual DRESULT write(const BYTE *buff, LBA_t sector, UINT count) = 0;
+	virtual DRESULT sync() = 0;
+};
+
+class DeviceDisk : public SectorDisk
+{
+public:
+	explicit DeviceDisk(BlockDevice *device) : _device(device) {}
+
+	bool start(bool format) override
+	{
+		(void)format;
+		return true;
+	}
+
+	LBA_t sectors() const override { return (LBA_t)(_device->size() / SECTOR_SIZE); }
+	DWORD block_sectors() const override { return _device->geometry().erase_size / SECTOR_SIZE; }
+
+	DRESULT read(BYTE *buff, LBA_t sector, UINT count) override
+	{
+		return _device->read((uint64_t)sector * SECTOR_SIZE, buff, count * SECTOR_SIZE) == 0 ? RES_OK : RES_ERROR;
+	}
+
+	DRESULT write(const BYTE *buff, LBA_t sector, UINT count) override
+	{
+		return _device->prog((uint64_t)sector * SECTOR_SIZE, buff, count * SECTOR_SIZE) == 0 ? RES_OK : RES_ERROR;
+	}
+
+	DRESULT sync() override { return _device->sync() == 0 ? RES_OK : RES_ERROR; }
+
+private:
+	BlockDevice *_device;
+};
+
+// dhara driver on a raw NAND device, dhara passes a pointer to the first
+// member to the driver functions
+struct DharaDeviceNand {
+	dhara_nand nand;
+	BlockDevice *device;
+	std::vector<uint8_t> bad;
+	std::vector<uint8_t> programmed;   // per page, since the last erase
+	std::vector<uint8_t> page;
+
+	static DharaDeviceNand *from(const dhara_nand *n) { return (DharaDeviceNand *)n; }
+	uint32_t page_size() const { return 1u << nand.log2_page_size; }
+};
+
+extern "C" {
+
+int dhara_nand_is_bad(const struct dhara_nand *n, dhara_block_t b)
+{
+	DharaDeviceNand *nand = DharaDeviceNand::from(n);
+	return b >= n->num_blocks || nand->bad[b];
+}
+
+void dhara_nand_mark_bad(const struct dhara_nand *n, dhara_block_t b)
+{
+	DharaDeviceNand::from(n)->bad[b] = 1;
+}
+
+int dhara_nand_erase(const struct dhara_nand *n, dhara_block_t b, dhara_error_t *err)
+{
+	DharaDeviceNand *nand = DharaDeviceNand::from(n);
+
+	if (nand->device->erase(b) != 0) {
+		dhara_set_error(err, DHARA_E_BAD_BLOCK);
+		return -1;
+	}
+
+	memset(&nand->programmed[(size_t)b << n->log2_ppb], 0, (size_t)1 << n->log2_ppb);
+	return 0;
+}
+
+int dhara_nand_prog(const struct dhara_nand *n, dhara_page_t p, const uint8_t *data, dhara_error_t *err)
+{
+	DharaDeviceNand *nand = DharaDeviceNand::from(n);
+
+	if (nand->device->prog((uint64_t)p << n->log2_page_size, data, nand->page_size()) != 0) {
+		dhara_set_error(err, DHARA_E_BAD_BLOCK);
+		return -1;
+	}
+
+	nand->programmed[p] = 1;
+	return 0;
+}
+
+int dhara_nand_is_free(const struct dhara_nand *n, dhara_page_t p)
+{
+	return !DharaDeviceNand::from(n)->programmed[p];
+}
+
+int dhara_nand_read(const struct dhara_nand *n, dhara_page_t p, size_t offset, size_t length, uint8_t *data,
+		    dhara_error_t *err)
+{
+	DharaDeviceNand *nand = DharaDeviceNand::from(n);
+
+	if (nand->device->read(((uint64_t)p << n->log2_page_size) + offset, data, (uint32_t)length) != 0) {
+		dhara_set_error(err, DHARA_E_ECC);
+		return -1;
+	}
+
+	return 0;
+}
+
+int dhara_nand_copy(const struct dhara_nand *n, dhara_page_t src, dhara_page_t dst, dhara_error_t *err)
+{
+	DharaDeviceNand *nand = DharaDeviceNand::from(n);
+
+	if (dhara_nand_read(n, src, 0, nand->page_size(), nand->page.data(), err) < 0) {
+		return -1;
+	}
+
+	return dhara_nand_prog(n, dst, nand->page.data(), err);
+}
+
+}
+
+class DharaDisk : public SectorDisk
+{
+public:
+	explicit DharaDisk(BlockDevice *device)
+	{
+		const BlockDevice::Geometry &geometry = device->geometry();
+
+		_nand.nand.log2_page_size = (uint8_t)__builtin_ctz(geometry.prog_size);
+		_nand.nand.log2_ppb = (uint8_t)__builtin_ctz(geometry.erase_size / geometry.prog_size);
+		_nand.nand.num_blocks = geometry.block_count;
+		_nand.device = device;
+		_nand.bad.assign(geometry.block_count, 0);
+		_nand.programmed.assign(device->size() / geometry.prog_size, 0);
+		_nand.page.resize(geometry.prog_size);
+		_map_page.resize(geometry.prog_size);
+		_sector.resize(geometry.prog_size);
+		_per_page = geometry.prog_size / SECTOR_SIZE;
+	}
+
+	bool start(bool format) override
+	{
+		dhara_map_init(&_map, &_nand.nand, _map_page.data(), DHARA_GC_RATIO);
+
+		// An erased device has no checkpoint to resume from
+		return dhara_map_resume(&_map, nullptr) == 0 || format;
+	}
+
+	LBA_t sectors() const override { return (LBA_t)dhara_map_capacity(&_map) * _per_page; }
+	DWORD block_sectors() const override { return _per_page; }
+
+	DRESULT read(BYTE *buff, LBA_t sector, UINT count) override
+	{
+		while (count > 0) {
+			const dhara_sector_t s = sector / _per_page;
+			const uint32_t first = sector % _per_page;
+			const uint32_t n = count < _per_page - first ? count : _per_page - first;
+
+			if (dhara_map_read(&_map, s, _sector.data(), nullptr) < 0) {
+				return RES_ERROR;
+			}
+
+			memcpy(buff, &_sector[first * SECTOR_SIZE], n * SECTOR_SIZE);
+			buff += n * SECTOR_SIZE;
+			sector += n;
+			count -= n;
+		}
+
+		return RES_OK;
+	}
+
+	DRESULT write(const BYTE *buff, LBA_t sector, UINT count) override
+	{
+		while (count > 0) {
+			const dhara_sector_t s = sector / _per_page;
+			const uint32_t first = sector % _per_page;
+			uint32_t n;
+
+			if (first == 0 && count >= _per_page) {
+				// Whole map sectors at once
+				const dhara_sector_t whole = count / _per_page;
+
+				if (dhara_map_write_multi(&_map, s, buff, whole, nullptr) < 0) {
+					return RES_ERROR;
+				}
+
+				n = whole * _per_page;
+
+			} else {
+				n = count < _per_page - first ? count : _per_page - first;
+
+				if (dhara_map_read(&_map, s, _sector.data(), nullptr) < 0) {
+					return RES_ERROR;
+				}
+
+				memcpy(&_sector[first * SECTOR_SIZE], buff, n * SECTOR_SIZE);
+
+				if (dhara_map_write(&_map, s, _sector.data(), nullptr) < 0) {
+					return RES_ERROR;
+				}
+			}
+
+			buff += n * SECTOR_SIZE;
+			sector += n;
+			count -= n;
+		}
+
+		return RES_OK;
+	}
+
+	DRESULT sync() override { return dhara_map_sync(&_map, nullptr) == 0 ? RES_OK : RES_ERROR; }
+
+private:
+	DharaDeviceNand _nand{};
+	dhara_map _map{};
+	std::vector<uint8_t> _map_page;
+	std::vector<uint8_t> _sector;
+	uint32_t _per_page;
+};
+
+// Disk of the FatFs mounted last, only one at a time
+
+static SectorDisk *s_disk = nullptr;
+
+DSTATUS disk_status(BYTE pdrv)
+{
+	return pdrv == 0 && s_disk != nullptr ? 0 : STA_NOINIT;
+}
+
+DSTATUS disk_initialize(BYTE pdrv)
+{
+	return disk_status(pdrv);
+}
+
+DRESULT disk_read(BYTE pdrv, BYTE *buff, LBA_t sector, UINT count)
+{
+	return pdrv == 0 && s_disk != nullptr ? s_disk->read(buff, sector, count) : RES_NOTRDY;
+}
+
+DRESULT disk_write(BYTE pdrv, const BYTE *buff, LBA_t sector, UINT count)
+{
+	return pdrv == 0 && s_disk != nullptr ? s_disk->write(buff, sector, count) : RES_NOTRDY;
+}
+
+DRESULT disk_ioctl(BYTE pdrv, BYTE cmd, void *buff)
+{
+	if (pdrv != 0 || s_disk == nullptr) {
+		return RES_NOTRDY;
+	}
+
+	switch (cmd) {
+	case CTRL_SYNC:
+		return s_disk->sync();
+
+	case GET_SECTOR_COUNT:
+		*(LBA_t *)buff = s_disk->sectors();
+		return RES_OK;
+
+	case GET_SECTOR_SIZE:
+		*(WORD *)buff = SECTOR_SIZE;
+		return RES_OK;
+
+	case GET_BLOCK_SIZE:
+		*(DWORD *)buff = s_disk->block_sectors();
+		return RES_OK;
+
+	default:
+		return RES_PARERR;
+	}
+}
+
+// Submitted transfers complete before disk_submit() returns
+DRESULT disk_submit(DREQ *req)
+{
+	req->busy = 1;
+	req->res = req->write ? disk_write(req->pdrv, req->buff, req->sector, req->count)
+			      : disk_read(req->pdrv, req->buff, req->sector, req->count);
+
+	if (req->complete != nullptr) {
+		req->complete(req);
+	}
+
+	req->busy = 0;
+	return RES_OK;
+}
+
+DRESULT disk_wait(DREQ *req)
+{
+	return req->res;
+}
+
+// FatFs
+
+class FatfsTraceFs : public TraceFs
+{
+public:
+	FatfsTraceFs(const FatfsCopy *copy, SectorDisk *disk) : _copy(copy), _disk(disk) {}
+	~FatfsTraceFs() override;
+
+	bool format() override;
+	bool remount() override;
+	int mkdir(const char *path) override;
+	int open(uint32_t file, const char *path, Trace::Mode mode) override;
+	int write(uint32_t file, const void *buffer, uint32_t size) override;
+	int read(uint32_t file, void *buffer, uint32_t size) override;
+	int seek(uint32_t file, uint32_t offset) override;
+	int sync(uint32_t file) override;
+	int close(uint32_t file) override;
+	int remove(const char *path) override;
+
+private:
+	FIL *file(uint32_t file) { return file < _files.size() ? _files[file] : nullptr; }
+	void unmount();
+	bool mount(bool format);
+
+	const FatfsCopy *_copy;
+	SectorDisk *_disk;
+	bool _mounted{false};
+	std::vector<FIL *> _files;
+};
+
+FatfsTraceFs::~FatfsTraceFs()
+{
+	unmount();
+	delete _disk;
+}
+
+void FatfsTraceFs::unmount()
+{
+	for (uint32_t f = 0; f < _files.size(); f++) {
+		close(f);
+	}
+
+	if (_mounted) {
+		_copy->unmount();
+		_disk->sync();
+		_mounted = false;
+	}
+
+	if (s_disk == _disk) {
+		s_disk = nullptr;
+	}
+}
+
+bool FatfsTraceFs::mount(bool format)
+{
+	static const MKFS_PARM OPT = {FM_FAT, 2, 0, 0, 0};
+	static BYTE work[FF_MAX_SS * 4];
+
+	unmount();
+
+	if (!_disk->start(format)) {
+		return false;
+	}
+
+	s_disk = _disk;
+
+	if (format && _copy->mkfs("", &OPT, work, sizeof(work)) != FR_OK) {
+		return false;
+	}
+
+	_mounted = _copy->mount() == FR_OK;
+	return _mounted;
+}
+
+bool FatfsTraceFs::format()
+{
+	return mount(true);
+}
+
+bool FatfsTraceFs::remount()
+{
+	return mount(false);
+}
+
+int FatfsTraceFs::mkdir(const char *path)
+{
+	return -(int)_copy->mkdir(path);
+}
+
+int FatfsTraceFs::open(uint32_t file, const char *path, Trace::Mode mode)
+{
+	static const BYTE MODES[] = {
+		FA_READ,
+		FA_READ | FA_WRITE,
+		FA_READ | FA_WRITE | FA_CREATE_ALWAYS,
+		FA_WRITE | FA_OPEN_APPEND,
+	};
+
+	if (file >= _files.size()) {
+		_files.resize(file + 1, nullptr);
+	}
+
+	if (_files[file] != nullptr) {
+		return -(int)FR_INVALID_OBJECT;
+	}
+
+	FIL *f = new FIL;
+	const FRESULT res = _copy->open(f, path, MODES[mode]);
+
+	if (res != FR_OK) {
+		delete f;
+		return -(int)res;
+	}
+
+	_files[file] = f;
+	return 0;
+}
+
+int FatfsTraceFs::write(uint32_t file, const void *buffer, uint32_t size)
+{
+	FIL *f = this->file(file);
+	UINT bw = 0;
+	const FRESULT res = f != nullptr ? _copy->write(f, buffer, size, &bw) : FR_INVALID_OBJECT;
+	return res != FR_OK ? -(int)res : (int)bw;
+}
+
+int FatfsTraceFs::read(uint32_t file, void *buffer, uint32_t size)
+{
+	FIL *f = this->file(file);
+	UINT br = 0;
+	const FRESULT res = f != nullptr ? _copy->read(f, buffer, size, &br) : FR_INVALID_OBJECT;
+	return res != FR_OK ? -(int)res : (int)br;
+}
+
+int FatfsTraceFs::seek(uint32_t file, uint32_t offset)
+{
+	FIL *f = this->file(file);
+	return -(int)(f != nullptr ? _copy->lseek(f, offset) : FR_INVALID_OBJECT);
+}
+
+int FatfsTraceFs::sync(uint32_t file)
+{
+	FIL *f = this->file(file);
+	return -(int)(f != nullptr ? _copy->sync(f) : FR_INVALID_OBJECT);
+}
+
+int FatfsTraceFs::close(uint32_t file)
+{
+	FIL *f = this->file(file);
+
+	if (f == nullptr) {
+		return -(int)FR_INVALID_OBJECT;
+	}
+
+	const FRESULT res = _copy->close(f);
+	delete f;
+	_files[file] = nullptr;
+	return -(int)res;
+}
+
+int FatfsTraceFs::remove(const char *path)
+{
+	return -(int)_copy->unlink(path);
+}
+
+TraceFs *trace_fs_fatfs(BlockDevice *device, const FatfsCopy *copy)
+{
+	return new FatfsTraceFs(copy, new DeviceDisk(device));
+}
+
+TraceFs *trace_fs_fatfs_dhara(BlockDevice *device, const FatfsCopy *copy)
+{
+	return new FatfsTraceFs(copy, new DharaDisk(device));
+}
@@ -0,0 +1,55 @@
+#ifndef TRACE_FS_HPP
+#define TRACE_FS_HPP
+
+#include "BlockDevice.hpp"
+#include "Trace.hpp"
+#include "fatfs_copy.h"
+
+// Filesystem under a trace replay, on a BlockDevice. Files are the paths of
+// the trace, by index. Functions return a negative error code of the
+// filesystem on failure, read and write the number of bytes moved.
+class TraceFs
+{
+public:
+	virtual ~TraceFs() = default;
+
+	/* @brief Format the device and mount
+	 *
+	 * @returns false on failure.
+	 */
+	virtual bool format() = 0;
+
+	/* @brief Unmount, closing the open files, and mount again
+	 *
+	 * @returns false on failure.
+	 */
+	virtual bool remount() = 0;
+
+	virtual int mkdir(const char *path) = 0;
+	virtual int open(uint32_t file, const char *path, Trace::Mode mode) = 0;
+	virtual int write(uint32_t file, const void *buffer, uint32_t size) = 0;
+	virtual int read(uint32_t file, void *buffer, uint32_t size) = 0;
+	virtual int seek(uint32_t file, uint32_t offset) = 0;
+	virtual int sync(uint32_t file) = 0;
+	virtual int close(uint32_t file) = 0;
+	virtual int remove(const char *path) = 0;
+};
+
+/* @brief littlefs on a raw flash device
+ *
+ * @param cached With a 16 line block cache, 1 KiB of readahead and the
+ *               free block bitmap.
+ */
+TraceFs *trace_fs_littlefs(BlockDevice *device, bool cached);
+
+/* @brief A copy of FatFs on a managed device of 512 B sectors */
+TraceFs *trace_fs_fatfs(BlockDevice *device, const FatfsCopy *copy);
+
+/* @brief A copy of FatFs on a dhara map on a raw NAND device
+ *
+ * The map sectors are NAND pages, FatFs sectors are read and written in
+ * them with read-modify-write.
+ */
+TraceFs *trace_fs_fatfs_dhara(BlockDevice *device, const FatfsCopy *copy);
+
+#endif
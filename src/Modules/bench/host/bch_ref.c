@@ -0,0 +1,15 @@
+// dhara BCH built with BCH_NO_TABLES, the bit-serial decoder of the
+// original code, as a reference for test_dhara_bch.cpp and
+// bench_dhara_bch.cpp. Its functions and codes are renamed to bch_ref_*.
+
+#define BCH_NO_TABLES
+
+#define bch_generate bch_ref_generate
+#define bch_verify bch_ref_verify
+#define bch_repair bch_ref_repair
+#define bch_1bit bch_ref_1bit
+#define bch_2bit bch_ref_2bit
+#define bch_3bit bch_ref_3bit
+#define bch_4bit bch_ref_4bit
+
+#include "bch.c"
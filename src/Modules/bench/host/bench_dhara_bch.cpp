@@ -0,0 +1,114 @@
+#include "Bench.hpp"
+
+extern "C" {
+#include "bch.h"
+}
+
+#include <string.h>
+
+// dhara BCH ECC of a 512 B chunk with the 4-bit code, as checked on every
+// NAND page read: bch_verify() and, when it fails, bch_repair() followed by
+// bch_verify() again. MB/s is the chunk data checked at the median time.
+//
+//   *_ref   the bit-serial code of BCH_NO_TABLES (bch_ref.c)
+//   *       the remainder tables, syndromes from the remainder and the
+//           Chien search
+//
+// Both are compared on random chunks of all four codes by test_dhara_bch.
+
+extern "C" {
+extern const struct bch_def bch_ref_4bit;
+int bch_ref_verify(const struct bch_def *bch, const uint8_t *chunk, size_t len, const uint8_t *ecc);
+void bch_ref_repair(const struct bch_def *bch, uint8_t *chunk, size_t len, uint8_t *ecc);
+}
+
+static constexpr size_t CHUNK = 512;
+
+static uint32_t s_seed = 1;
+static uint8_t s_clean[CHUNK];
+static uint8_t s_clean_ecc[BCH_MAX_ECC];
+static uint8_t s_bad[CHUNK];
+static uint8_t s_bad_ecc[BCH_MAX_ECC];
+static uint8_t s_chunk[CHUNK];
+static uint8_t s_ecc[BCH_MAX_ECC];
+
+static uint32_t next_rand()
+{
+	s_seed = s_seed * 1103515245 + 12345;
+	return s_seed >> 8;
+}
+
+// Flips n distinct bits of the chunk and ECC data
+static void flip_bits(uint8_t *chunk, size_t len, uint8_t *ecc, int degree, int n)
+{
+	const uint32_t total = (uint32_t)len * 8 + degree;
+	uint32_t done[8];
+
+	for (int i = 0; i < n; i++) {
+		uint32_t bit;
+		bool dup;
+
+		do {
+			bit = next_rand() % total;
+			dup = false;
+
+			for (int j = 0; j < i; j++) {
+				dup |= done[j] == bit;
+			}
+		} while (dup);
+
+		done[i] = bit;
+
+		if (bit < len * 8) {
+			chunk[bit >> 3] ^= 1 << (bit & 7);
+		} else {
+			bit -= len * 8;
+			ecc[bit >> 3] ^= 1 << (bit & 7);
+		}
+	}
+}
+
+static void setup(int errors)
+{
+	s_seed = 1;
+
+	for (size_t i = 0; i < CHUNK; i++) {
+		s_clean[i] = (uint8_t)next_rand();
+	}
+
+	bch_generate(&bch_4bit, s_clean, CHUNK, s_clean_ecc);
+	memcpy(s_bad, s_clean, CHUNK);
+	memcpy(s_bad_ecc, s_clean_ecc, sizeof(s_bad_ecc));
+	flip_bits(s_bad, CHUNK, s_bad_ecc, bch_4bit.degree, errors);
+}
+
+static void check_chunk(const bch_def *bch, void (*repair)(const bch_def *, uint8_t *, size_t, uint8_t *),
+			int (*verify)(const bch_def *, const uint8_t *, size_t, const uint8_t *))
+{
+	memcpy(s_chunk, s_bad, CHUNK);
+	memcpy(s_ecc, s_bad_ecc, sizeof(s_ecc));
+
+	int res = verify(bch, s_chunk, CHUNK, s_ecc);
+
+	if (res != 0) {
+		repair(bch, s_chunk, CHUNK, s_ecc);
+		res = verify(bch, s_chunk, CHUNK, s_ecc);
+	}
+
+	bench::do_not_optimize(res);
+	bench::transfer(CHUNK);
+}
+
+static void check_fast() { check_chunk(&bch_4bit, bch_repair, bch_verify); }
+static void check_ref() { check_chunk(&bch_ref_4bit, bch_ref_repair, bch_ref_verify); }
+
+static void setup_0() { setup(0); }
+static void setup_1() { setup(1); }
+static void setup_4() { setup(4); }
+
+BENCH_CASE_EX(dhara_bch, verify_512_ref, setup_0, 1) { check_ref(); }
+BENCH_CASE_EX(dhara_bch, verify_512, setup_0, 1) { check_fast(); }
+BENCH_CASE_EX(dhara_bch, repair_512_1err_ref, setup_1, 1) { check_ref(); }
+BENCH_CASE_EX(dhara_bch, repair_512_1err, setup_1, 1) { check_fast(); }
+BENCH_CASE_EX(dhara_bch, repair_512_4err_ref, setup_4, 1) { check_ref(); }
+BENCH_CASE_EX(dhara_bch, repair_512_4err, setup_4, 1) { check_fast(); }
@@ -0,0 +1,161 @@
+#include "Bench.hpp"
+#include "DharaNandSim.hpp"
+
+extern "C" {
+#include "map.h"
+}
+
+#include <stdio.h>
+#include <string.h>
+
+// dhara on a simulated 32 MiB SLC NAND chip (DharaNandSim): 2 KiB pages, 64
+// pages per block and 256 blocks, 4 of them bad from the factory, with one
+// in 100000 programs and erases failing. The chip takes 25 us to read a page
+// into its cache register, 200 us to program, 2 ms to erase and 25 ns per
+// byte on the bus. The map has a GC ratio of 4 and holds 8192 sectors
+// (16 MiB), written in order and then overwritten at random until garbage
+// collection is in its steady state.
+//
+//   read_hot           dhara_map_read() of a random sector of the first 512
+//   read_rand          dhara_map_read() of any sector
+//   *_cache            the same with a 1024 entry sector cache (8 KiB)
+//   write_rand         dhara_map_write() of a random sector, garbage
+//                      collection runs inline once the journal is full
+//   write_rand_idle    the same with dhara_map_idle() between the writes,
+//                      keeping 64 pages of headroom in time not measured
+//   write_seq_8        8 consecutive sectors with dhara_map_write()
+//   write_multi_8      the same with dhara_map_write_multi()
+//
+// ev/op is the number of NAND page reads, page programs and block erases
+// per sector. The map is checked against a model by test_dhara_map.
+
+static constexpr uint8_t LOG2_PAGE_SIZE = 11;
+static constexpr uint8_t LOG2_PPB = 6;
+static constexpr unsigned int NUM_BLOCKS = 256;
+static constexpr unsigned int FACTORY_BAD = 4;
+static constexpr uint32_t FAIL_RATE = 100000;
+static constexpr uint8_t GC_RATIO = 4;
+static constexpr dhara_sector_t SECTORS = 8192;
+static constexpr dhara_sector_t HOT_SECTORS = 512;
+static constexpr unsigned int CACHE_ENTRIES = 1024;
+static constexpr dhara_page_t IDLE_HEADROOM = 64;
+static constexpr dhara_sector_t SEQ_SECTORS = 8;
+
+static constexpr size_t PAGE_SIZE = (size_t)1 << LOG2_PAGE_SIZE;
+static constexpr DharaNandSim::Timing TIMING = {25, 200, 2000, 25};
+
+static DharaNandSim s_nand;
+static dhara_map s_map;
+static uint8_t s_page_buf[PAGE_SIZE];
+static uint8_t s_data[SEQ_SECTORS * PAGE_SIZE];
+static dhara_map_cache s_cache[CACHE_ENTRIES];
+static bool s_ready = false;
+static uint32_t s_seed = 1;
+static dhara_sector_t s_next = 0;
+
+static uint32_t next_random()
+{
+	s_seed = s_seed * 1103515245 + 12345;
+	return s_seed >> 8;
+}
+
+static bool populate()
+{
+	dhara_error_t err;
+
+	if (!s_nand.init(LOG2_PAGE_SIZE, LOG2_PPB, NUM_BLOCKS, FACTORY_BAD, FAIL_RATE, 1)) {
+		return false;
+	}
+
+	dhara_map_init(&s_map, s_nand.nand(), s_page_buf, GC_RATIO);
+	dhara_map_resume(&s_map, nullptr);
+	memset(s_data, 0x5a, sizeof(s_data));
+
+	for (dhara_sector_t s = 0; s < SECTORS; s++) {
+		if (dhara_map_write(&s_map, s, s_data, &err) < 0) {
+			return false;
+		}
+	}
+
+	for (dhara_sector_t n = 0; n < 2 * SECTORS; n++) {
+		if (dhara_map_write(&s_map, next_random() % SECTORS, s_data, &err) < 0) {
+			return false;
+		}
+	}
+
+	return dhara_map_sync(&s_map, &err) == 0;
+}
+
+static void setup(bool cache)
+{
+	// Every case starts from the same state
+	s_nand.set_timing(nullptr);
+	s_seed = 1;
+	s_next = 0;
+	s_ready = populate();
+
+	if (!s_ready) {
+		printf("dhara_map: populating the map failed\n");
+		return;
+	}
+
+	dhara_map_set_cache(&s_map, cache ? s_cache : nullptr, CACHE_ENTRIES);
+
+	// Warm the cache with the hot sectors
+	for (dhara_sector_t s = 0; cache && s < HOT_SECTORS; s++) {
+		dhara_map_find(&s_map, s, nullptr, nullptr);
+	}
+
+	s_nand.set_timing(&TIMING);
+}
+
+static void read_sector(dhara_sector_t sectors)
+{
+	if (s_ready) {
+		dhara_map_read(&s_map, next_random() % sectors, s_data, nullptr);
+		bench::transfer(PAGE_SIZE);
+	}
+}
+
+static void write_random(bool idle)
+{
+	if (s_ready) {
+		dhara_map_write(&s_map, next_random() % SECTORS, s_data, nullptr);
+		bench::transfer(PAGE_SIZE);
+
+		if (idle) {
+			s_nand.pause(true);
+			dhara_map_idle(&s_map, IDLE_HEADROOM, IDLE_HEADROOM * GC_RATIO, nullptr);
+			s_nand.pause(false);
+		}
+	}
+}
+
+static void write_sequential(bool multi)
+{
+	if (s_ready) {
+		if (multi) {
+			dhara_map_write_multi(&s_map, s_next, s_data, SEQ_SECTORS, nullptr);
+
+		} else {
+			for (dhara_sector_t i = 0; i < SEQ_SECTORS; i++) {
+				dhara_map_write(&s_map, s_next + i, &s_data[i * PAGE_SIZE], nullptr);
+			}
+		}
+
+		s_next = (s_next + SEQ_SECTORS) % SECTORS;
+		bench::transfer(SEQ_SECTORS * PAGE_SIZE);
+	}
+}
+
+static void setup_nocache() { setup(false); }
+static void setup_cache() { setup(true); }
+
+BENCH_CASE_EX(dhara_map, read_hot, setup_nocache, 1) { read_sector(HOT_SECTORS); }
+BENCH_CASE_EX(dhara_map, read_hot_cache, setup_cache, 1) { read_sector(HOT_SECTORS); }
+BENCH_CASE_EX(dhara_map, read_rand, setup_nocache, 1) { read_sector(SECTORS); }
+BENCH_CASE_EX(dhara_map, read_rand_cache, setup_cache, 1) { read_sector(SECTORS); }
+BENCH_CASE_EX(dhara_map, write_rand, setup_nocache, 1) { write_random(false); }
+BENCH_CASE_EX(dhara_map, write_rand_idle, setup_nocache, 1) { write_random(true); }
+BENCH_CASE_EX(dhara_map, write_seq_8, setup_nocache, SEQ_SECTORS) { write_sequential(false); }
+BENCH_CASE_EX(dhara_map, write_multi_8, setup_nocache, SEQ_SECTORS) { write_sequential(true); }
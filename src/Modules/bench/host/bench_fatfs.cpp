@@ -0,0 +1,151 @@
+#include "Bench.hpp"
+#include "fatfs_copy.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// FatFs on the SDK RAM disk, 32 MiB formatted FAT16 with 2 KiB clusters and
+// two FATs. Every case runs on FatFs as shipped (win1) and with a 16 sector
+// FF_WIN_CACHE and FF_USE_CLUSTER_RUN (cache). ev/op is the number of
+// disk_read()/disk_write() calls per operation, MB/s the file data moved at
+// the median time.
+//
+//   seqread_64k   64 KiB in one f_read() from a file of contiguous clusters
+//   seqwrite_64k  the same with f_write() into a file created anew
+//   randread_512  512 B at a random offset of a 4 MiB file, every backward
+//                 seek follows the cluster chain from the start over 8 FAT
+//                 sectors
+//   stat          f_stat() of one of 128 files in a directory of 8 sectors
+
+static constexpr UINT SEQ_SIZE = 64 * 1024;
+static constexpr UINT LOG_SIZE = 4 * 1024 * 1024;
+static constexpr UINT RAND_SIZE = 512;
+static constexpr int DIR_FILES = 128;
+
+static const FatfsCopy *s_fs = nullptr;
+static bool s_mounted = false;
+static uint8_t s_buf[SEQ_SIZE];
+static uint8_t s_work[FF_MAX_SS * 4];
+static uint32_t s_seed = 1;
+static FIL s_log;
+static bool s_log_open = false;
+
+static bool write_file(const char *path, UINT size)
+{
+	FIL file;
+	UINT bw = 0;
+
+	if (s_fs->open(&file, path, FA_WRITE | FA_CREATE_ALWAYS) != FR_OK) {
+		return false;
+	}
+
+	for (UINT off = 0; off < size; off += sizeof(s_buf)) {
+		UINT n = 0;
+		s_fs->write(&file, s_buf, size - off < sizeof(s_buf) ? size - off : sizeof(s_buf), &n);
+		bw += n;
+	}
+
+	return s_fs->close(&file) == FR_OK && bw == size;
+}
+
+static void setup(const FatfsCopy *fs)
+{
+	if (s_log_open) {
+		s_fs->close(&s_log);
+		s_log_open = false;
+	}
+
+	if (s_mounted) {
+		s_fs->unmount();
+		s_mounted = false;
+	}
+
+	s_fs = fs;
+	fatfs_disk_set_latency(0, 0);
+
+	const MKFS_PARM opt = {FM_FAT, 2, 0, 0, 2048};
+
+	if (fs->mkfs("", &opt, s_work, sizeof(s_work)) != FR_OK || fs->mount() != FR_OK) {
+		printf("fatfs: format on %s failed\n", fs->name);
+		return;
+	}
+
+	memset(s_buf, 0x5a, sizeof(s_buf));
+	bool ok = write_file("seq.bin", SEQ_SIZE) && write_file("log.bin", LOG_SIZE) && fs->mkdir("dir") == FR_OK;
+	char path[24];
+
+	for (int n = 0; n < DIR_FILES && ok; n++) {
+		snprintf(path, sizeof(path), "dir/file%03d.txt", n);
+		ok = write_file(path, 100);
+	}
+
+	// start from the state found after mounting
+	fs->unmount();
+	s_mounted = ok && fs->mount() == FR_OK;
+	s_log_open = s_mounted && fs->open(&s_log, "log.bin", FA_READ) == FR_OK;
+	s_seed = 1;
+
+	if (!s_log_open) {
+		printf("fatfs: populating the volume on %s failed\n", fs->name);
+	}
+}
+
+static void seqread()
+{
+	FIL file;
+
+	if (s_mounted && s_fs->open(&file, "seq.bin", FA_READ) == FR_OK) {
+		UINT br = 0;
+		s_fs->read(&file, s_buf, SEQ_SIZE, &br);
+		s_fs->close(&file);
+		bench::transfer(br);
+	}
+}
+
+static void seqwrite()
+{
+	FIL file;
+
+	if (s_mounted && s_fs->open(&file, "seq.bin", FA_WRITE | FA_CREATE_ALWAYS) == FR_OK) {
+		UINT bw = 0;
+		s_fs->write(&file, s_buf, SEQ_SIZE, &bw);
+		s_fs->close(&file);
+		bench::transfer(bw);
+	}
+}
+
+static void randread()
+{
+	if (s_log_open) {
+		s_seed = s_seed * 1103515245 + 12345;
+		FSIZE_t pos = (FSIZE_t)((s_seed >> 8) % (LOG_SIZE / RAND_SIZE)) * RAND_SIZE;
+		UINT br = 0;
+		s_fs->lseek(&s_log, pos);
+		s_fs->read(&s_log, s_buf, RAND_SIZE, &br);
+		bench::transfer(br);
+	}
+}
+
+static void stat_file()
+{
+	if (s_mounted) {
+		char path[24];
+		FILINFO info;
+		s_seed = s_seed * 1103515245 + 12345;
+		snprintf(path, sizeof(path), "dir/file%03u.txt", (unsigned)((s_seed >> 16) % DIR_FILES));
+		FRESULT res = s_fs->stat(path, &info);
+		bench::do_not_optimize(res);
+	}
+}
+
+static void setup_win1() { setup(&fatfs_win1); }
+static void setup_cache() { setup(&fatfs_cache); }
+
+BENCH_CASE_EX(fatfs, seqread_64k, setup_win1, 1) { seqread(); }
+BENCH_CASE_EX(fatfs, seqread_64k_cache, setup_cache, 1) { seqread(); }
+BENCH_CASE_EX(fatfs, seqwrite_64k, setup_win1, 1) { seqwrite(); }
+BENCH_CASE_EX(fatfs, seqwrite_64k_cache, setup_cache, 1) { seqwrite(); }
+BENCH_CASE_EX(fatfs, randread_512, setup_win1, 1) { randread(); }
+BENCH_CASE_EX(fatfs, randread_512_cache, setup_cache, 1) { randread(); }
+BENCH_CASE_EX(fatfs, stat, setup_win1, 1) { stat_file(); }
+BENCH_CASE_EX(fatfs, stat_cache, setup_cache, 1) { stat_file(); }
@@ -0,0 +1,123 @@
+#include "Bench.hpp"
+#include "fatfs_copy.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// Path lookup in directories of 64, 512 and 2048 files with long names
+// ("sensor_00042.csv", three entries per file), without (cache) and with
+// (dir) the directory name cache of FF_DIR_CACHE and FF_DIR_FILTER. Both
+// copies have the 16 sector FF_WIN_CACHE, the 2048 file directory takes 384
+// sectors.
+//
+//   open_*     f_open()/f_close() of a random file in the directory, a scan
+//              of half the table on average without the cache, a hint once
+//              the name has been found before with it
+//   miss_2048  f_stat() of a name not in the directory, a scan of the whole
+//              table without the cache, the name filter once a miss has
+//              been scanned with it
+//
+// ev/op is the number of disk_read()/disk_write() calls per operation. The
+// names the cache resolves are checked against a model by test_fatfs_dir.
+
+static constexpr UINT DIR_FILES[] = {64, 512, 2048};
+
+static const FatfsCopy *s_fs = nullptr;
+static bool s_ready = false;
+static uint8_t s_work[FF_MAX_SS * 4];
+static uint32_t s_seed = 1;
+
+static bool populate()
+{
+	const MKFS_PARM opt = {FM_FAT, 2, 0, 0, 2048};
+
+	if (s_fs->mkfs("", &opt, s_work, sizeof(s_work)) != FR_OK || s_fs->mount() != FR_OK) {
+		return false;
+	}
+
+	char path[40];
+
+	for (UINT files : DIR_FILES) {
+		snprintf(path, sizeof(path), "dir%u", files);
+
+		if (s_fs->mkdir(path) != FR_OK) {
+			return false;
+		}
+
+		for (UINT n = 0; n < files; n++) {
+			FIL file;
+			snprintf(path, sizeof(path), "dir%u/sensor_%05u.csv", files, n);
+
+			if (s_fs->open(&file, path, FA_WRITE | FA_CREATE_NEW) != FR_OK || s_fs->close(&file) != FR_OK) {
+				return false;
+			}
+		}
+	}
+
+	// start from the state found after mounting
+	s_fs->unmount();
+	return s_fs->mount() == FR_OK;
+}
+
+static void setup(const FatfsCopy *fs)
+{
+	fatfs_disk_set_latency(0, 0);
+	s_seed = 1;
+
+	if (s_fs == fs && s_ready) {
+		return;
+	}
+
+	if (s_ready) {
+		s_fs->unmount();
+	}
+
+	s_fs = fs;
+	s_ready = populate();
+
+	if (!s_ready) {
+		printf("fatfs_dir: populating the volume on %s failed\n", fs->name);
+	}
+}
+
+static UINT next_file(UINT files)
+{
+	s_seed = s_seed * 1103515245 + 12345;
+	return (s_seed >> 8) % files;
+}
+
+static void open_file(UINT files)
+{
+	if (s_ready) {
+		char path[40];
+		FIL file;
+		snprintf(path, sizeof(path), "dir%u/sensor_%05u.csv", files, next_file(files));
+
+		if (s_fs->open(&file, path, FA_READ) == FR_OK) {
+			s_fs->close(&file);
+		}
+	}
+}
+
+static void stat_missing(UINT files)
+{
+	if (s_ready) {
+		char path[40];
+		FILINFO info;
+		snprintf(path, sizeof(path), "dir%u/missing_%05u.csv", files, next_file(files));
+		FRESULT res = s_fs->stat(path, &info);
+		bench::do_not_optimize(res);
+	}
+}
+
+static void setup_cache() { setup(&fatfs_cache); }
+static void setup_dir() { setup(&fatfs_dir); }
+
+BENCH_CASE_EX(fatfs_dir, open_64, setup_cache, 1) { open_file(64); }
+BENCH_CASE_EX(fatfs_dir, open_512, setup_cache, 1) { open_file(512); }
+BENCH_CASE_EX(fatfs_dir, open_2048, setup_cache, 1) { open_file(2048); }
+BENCH_CASE_EX(fatfs_dir, miss_2048, setup_cache, 1) { stat_missing(2048); }
+BENCH_CASE_EX(fatfs_dir, open_64_dircache, setup_dir, 1) { open_file(64); }
+BENCH_CASE_EX(fatfs_dir, open_512_dircache, setup_dir, 1) { open_file(512); }
+BENCH_CASE_EX(fatfs_dir, open_2048_dircache, setup_dir, 1) { open_file(2048); }
+BENCH_CASE_EX(fatfs_dir, miss_2048_dircache, setup_dir, 1) { stat_missing(2048); }
@@ -0,0 +1,166 @@
+#include "Bench.hpp"
+#include "fatfs_copy.h"
+
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+
+// Streaming a 256 KiB file through an application that processes 16 KiB
+// chunks, on a RAM disk with the latency of an SD card: 200 us per request
+// and 20 us per sector (25 MB/s). Processing takes 40 ns per byte (655 us per
+// chunk), spent spinning on the CPU while the disk sleeps.
+//
+//   read_256k, write_256k    f_read()/f_write() of a chunk, then processing,
+//                            the disk and the CPU take turns
+//   readstream_256k_*buf     f_readstream()/f_writestream() with 2 or 3
+//   writestream_256k_*buf    buffers, the next chunks are transferred while
+//                            the current one is processed
+//
+// All cases run on the copy with cluster runs (fatfs_cache), so a chunk of
+// contiguous clusters is a single disk request in every case. ev/op is the
+// number of disk requests per operation, MB/s the file data moved at the
+// median time. The streamed data is checked by test_fatfs_stream.
+
+static constexpr UINT FILE_SIZE = 256 * 1024;
+static constexpr UINT CHUNK = 16 * 1024;
+static constexpr uint32_t REQUEST_US = 200;
+static constexpr uint32_t SECTOR_NS = 20000;
+static constexpr uint32_t PROCESS_NS_PER_BYTE = 40;
+
+static const FatfsCopy *s_fs = &fatfs_cache;
+static bool s_mounted = false;
+static uint8_t s_work[3 * CHUNK];
+static uint32_t s_sum = 0;
+static uint8_t s_fill = 0;
+
+// Stands in for the application work on a chunk
+static void process(const uint8_t *data, UINT len)
+{
+	auto end = std::chrono::steady_clock::now() + std::chrono::nanoseconds((uint64_t)len * PROCESS_NS_PER_BYTE);
+
+	for (UINT i = 0; i < len; i++) {
+		s_sum += data[i];
+	}
+
+	while (std::chrono::steady_clock::now() < end) {
+	}
+
+	bench::do_not_optimize(s_sum);
+}
+
+static UINT sink(const BYTE *data, UINT len)
+{
+	process(data, len);
+	return len;
+}
+
+static UINT source(BYTE *data, UINT len)
+{
+	memset(data, s_fill++, len);
+	process(data, len);
+	return len;
+}
+
+static void setup()
+{
+	if (s_mounted) {
+		s_fs->unmount();
+		s_mounted = false;
+	}
+
+	fatfs_disk_set_latency(0, 0);
+
+	const MKFS_PARM opt = {FM_FAT, 2, 0, 0, 2048};
+	FIL file;
+	UINT bw = 0;
+
+	if (s_fs->mkfs("", &opt, s_work, sizeof(s_work)) == FR_OK && s_fs->mount() == FR_OK &&
+	    s_fs->open(&file, "stream.bin", FA_WRITE | FA_CREATE_ALWAYS) == FR_OK) {
+		memset(s_work, 0x5a, sizeof(s_work));
+
+		for (UINT off = 0; off < FILE_SIZE; off += CHUNK) {
+			UINT n = 0;
+			s_fs->write(&file, s_work, CHUNK, &n);
+			bw += n;
+		}
+
+		s_mounted = s_fs->close(&file) == FR_OK && bw == FILE_SIZE;
+	}
+
+	if (!s_mounted) {
+		printf("fatfs_stream: creating the file failed\n");
+		return;
+	}
+
+	fatfs_disk_set_latency(REQUEST_US, SECTOR_NS);
+}
+
+static void read_chunks()
+{
+	FIL file;
+
+	if (s_mounted && s_fs->open(&file, "stream.bin", FA_READ) == FR_OK) {
+		UINT total = 0;
+		UINT br;
+
+		do {
+			br = 0;
+			s_fs->read(&file, s_work, CHUNK, &br);
+			process(s_work, br);
+			total += br;
+		} while (br == CHUNK);
+
+		s_fs->close(&file);
+		bench::transfer(total);
+	}
+}
+
+static void read_stream(UINT nbuf)
+{
+	FIL file;
+
+	if (s_mounted && s_fs->open(&file, "stream.bin", FA_READ) == FR_OK) {
+		UINT br = 0;
+		s_fs->readstream(&file, s_work, CHUNK, nbuf, sink, FILE_SIZE, &br);
+		s_fs->close(&file);
+		bench::transfer(br);
+	}
+}
+
+static void write_chunks()
+{
+	FIL file;
+
+	if (s_mounted && s_fs->open(&file, "stream.bin", FA_WRITE | FA_CREATE_ALWAYS) == FR_OK) {
+		UINT total = 0;
+
+		for (UINT off = 0; off < FILE_SIZE; off += CHUNK) {
+			UINT bw = 0;
+			source(s_work, CHUNK);
+			s_fs->write(&file, s_work, CHUNK, &bw);
+			total += bw;
+		}
+
+		s_fs->close(&file);
+		bench::transfer(total);
+	}
+}
+
+static void write_stream(UINT nbuf)
+{
+	FIL file;
+
+	if (s_mounted && s_fs->open(&file, "stream.bin", FA_WRITE | FA_CREATE_ALWAYS) == FR_OK) {
+		UINT bw = 0;
+		s_fs->writestream(&file, s_work, CHUNK, nbuf, source, FILE_SIZE, &bw);
+		s_fs->close(&file);
+		bench::transfer(bw);
+	}
+}
+
+BENCH_CASE_EX(fatfs_stream, read_256k, setup, 1) { read_chunks(); }
+BENCH_CASE_EX(fatfs_stream, readstream_256k_2buf, setup, 1) { read_stream(2); }
+BENCH_CASE_EX(fatfs_stream, readstream_256k_3buf, setup, 1) { read_stream(3); }
+BENCH_CASE_EX(fatfs_stream, write_256k, setup, 1) { write_chunks(); }
+BENCH_CASE_EX(fatfs_stream, writestream_256k_2buf, setup, 1) { write_stream(2); }
+BENCH_CASE_EX(fatfs_stream, writestream_256k_3buf, setup, 1) { write_stream(3); }
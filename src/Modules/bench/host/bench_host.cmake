@@ -0,0 +1,285 @@
+# Host build of the benchmark harness, used for
+#   cmake -DCMAKE_BUILD_TYPE=bench (without a toolchain file)
+# Only the platform independent libraries are built, no SDK or RTOS.
+
+set(BENCH_DIR ${ProjDirPath}/src/Modules/bench)
+set(BENCH_LIB_DIR ${ProjDirPath}/src/Modules/lib)
+set(TELEMETRY_DIR ${ProjDirPath}/src/Modules/telemetry)
+set(RTT_DIR ${ProjDirPath}/components/rtt)
+set(LWIP_DIR ${ProjDirPath}/middleware/lwip)
+set(LFS_DIR ${ProjDirPath}/middleware/littlefs)
+set(FATFS_DIR ${ProjDirPath}/middleware/fatfs/source)
+set(DHARA_DIR ${ProjDirPath}/middleware/dhara)
+set(SDMMC_DIR ${ProjDirPath}/middleware/sdmmc)
+set(MFLASH_DIR ${ProjDirPath}/components/flash/mflash)
+
+file(GLOB BENCH_HOST_SRCS
+    ${BENCH_DIR}/*.cpp
+    ${BENCH_LIB_DIR}/ringbuffer/*.cpp
+    ${TELEMETRY_DIR}/*.cpp
+)
+# RTT runs against its control block in host memory
+list(APPEND BENCH_HOST_SRCS
+    ${BENCH_DIR}/host/bench_main.cpp
+    ${RTT_DIR}/RTT/SEGGER_RTT.c
+)
+# Telemetry stream decoding of telemetry_decode
+list(APPEND BENCH_HOST_SRCS
+    ${BENCH_DIR}/host/bench_telemetry_stream.cpp
+    ${TELEMETRY_DIR}/host/TelemetryStream.cpp
+)
+# lwIP checksum, with bench/host/lwipopts.h and the unix port arch headers
+list(APPEND BENCH_HOST_SRCS
+    ${BENCH_DIR}/host/bench_lwip_chksum.cpp
+    ${LWIP_DIR}/src/core/inet_chksum.c
+    ${LWIP_DIR}/src/core/def.c
+)
+# littlefs on a RAM disk, with the optional block cache, free block bitmap
+# and file block index compiled in
+list(APPEND BENCH_HOST_SRCS
+    ${BENCH_DIR}/host/LfsRamDisk.cpp
+    ${BENCH_DIR}/host/bench_lfs.cpp
+    ${BENCH_DIR}/host/bench_lfs_alloc.cpp
+    ${BENCH_DIR}/host/bench_lfs_seek.cpp
+    ${LFS_DIR}/lfs.c
+    ${LFS_DIR}/lfs_util.c
+)
+# FatFs on the SDK RAM disk, three copies of ff.c built with different
+# options (bench/host/ffconf.h, fatfs_copy.h) sharing ffunicode.c. Submitted
+# disk transfers run in a thread.
+list(APPEND BENCH_HOST_SRCS
+    ${BENCH_DIR}/host/bench_fatfs.cpp
+    ${BENCH_DIR}/host/bench_fatfs_dir.cpp
+    ${BENCH_DIR}/host/bench_fatfs_stream.cpp
+    ${BENCH_DIR}/host/fatfs_diskio.cpp
+    ${BENCH_DIR}/host/fatfs_win1.c
+    ${BENCH_DIR}/host/fatfs_cache.c
+    ${BENCH_DIR}/host/fatfs_dir.c
+    ${FATFS_DIR}/ffunicode.c
+    ${FATFS_DIR}/fsl_ram_disk/fsl_ram_disk.c
+)
+
+# dhara BCH ECC, and a copy built with BCH_NO_TABLES as the reference
+list(APPEND BENCH_HOST_SRCS
+    ${BENCH_DIR}/host/bench_dhara_bch.cpp
+    ${BENCH_DIR}/host/bch_ref.c
+    ${DHARA_DIR}/ecc/bch.c
+    ${DHARA_DIR}/ecc/gf13.c
+)
+# dhara map on a simulated NAND chip with bad blocks
+list(APPEND BENCH_HOST_SRCS
+    ${BENCH_DIR}/host/DharaNandSim.cpp
+    ${BENCH_DIR}/host/bench_dhara_map.cpp
+    ${DHARA_DIR}/dhara/map.c
+    ${DHARA_DIR}/dhara/journal.c
+    ${DHARA_DIR}/dhara/error.c
+)
+# SD card streaming on a simulated card behind a stand-in host adapter
+list(APPEND BENCH_HOST_SRCS
+    ${BENCH_DIR}/host/SdCardSim.cpp
+    ${BENCH_DIR}/host/bench_sd_stream.cpp
+    ${SDMMC_DIR}/sd/fsl_sd_stream.c
+)
+# mflash files on a simulated NOR flash mapped at physical address 0
+list(APPEND BENCH_HOST_SRCS
+    ${BENCH_DIR}/host/MflashNorSim.cpp
+    ${BENCH_DIR}/host/bench_mflash_file.cpp
+    ${MFLASH_DIR}/mflash_file.c
+)
+set_source_files_properties(${MFLASH_DIR}/mflash_file.c PROPERTIES COMPILE_DEFINITIONS MFLASH_FILE_BASEADDR=0)
+
+list(APPEND BENCH_HOST_INC_DIRS
+    ${BENCH_DIR}
+    ${BENCH_LIB_DIR}
+    ${BENCH_LIB_DIR}/matrix
+    ${BENCH_LIB_DIR}/mathlib
+    ${BENCH_LIB_DIR}/ringbuffer
+    ${ProjDirPath}/src/Config
+    ${TELEMETRY_DIR}
+    ${TELEMETRY_DIR}/host
+    ${RTT_DIR}/RTT
+    ${RTT_DIR}/template
+    ${BENCH_DIR}/host
+    ${LWIP_DIR}/src/include
+    ${LWIP_DIR}/contrib/ports/unix/port/include
+    ${LFS_DIR}
+    ${FATFS_DIR}
+    ${FATFS_DIR}/fsl_ram_disk
+    ${DHARA_DIR}/ecc
+    ${DHARA_DIR}/dhara
+    ${SDMMC_DIR}/common
+    ${SDMMC_DIR}/sd
+    ${MFLASH_DIR}
+)
+
+find_package(Threads REQUIRED)
+
+add_executable(bench_host ${BENCH_HOST_SRCS})
+target_include_directories(bench_host PRIVATE ${BENCH_HOST_INC_DIRS})
+target_link_libraries(bench_host PRIVATE Threads::Threads)
+target_compile_definitions(bench_host PRIVATE BENCH_BUILD LFS_BCACHE LFS_FREEMAP LFS_CTZINDEX LFS_NO_DEBUG)
+target_compile_options(bench_host PRIVATE -O2 -g -Wall $<$<COMPILE_LANGUAGE:CXX>:-fno-rtti -fno-exceptions>)
+set_target_properties(bench_host PROPERTIES CXX_STANDARD 17)
+
+# Telemetry stream decoder
+add_executable(telemetry_decode
+    ${TELEMETRY_DIR}/TelemetryFrame.cpp
+    ${TELEMETRY_DIR}/host/TelemetryStream.cpp
+    ${TELEMETRY_DIR}/host/telemetry_decode.cpp
+)
+target_include_directories(telemetry_decode PRIVATE ${TELEMETRY_DIR} ${TELEMETRY_DIR}/host)
+target_compile_options(telemetry_decode PRIVATE -O2 -g -Wall -fno-rtti -fno-exceptions)
+set_target_properties(telemetry_decode PROPERTIES CXX_STANDARD 17)
+
+# Trace replay on the filesystems over simulated block devices
+add_executable(trace_replay
+    ${BENCH_DIR}/host/trace_replay.cpp
+    ${BENCH_DIR}/host/Trace.cpp
+    ${BENCH_DIR}/host/TraceFs.cpp
+    ${BENCH_DIR}/host/BlockDevice.cpp
+    ${BENCH_DIR}/host/fatfs_win1.c
+    ${BENCH_DIR}/host/fatfs_cache.c
+    ${FATFS_DIR}/ffunicode.c
+    ${LFS_DIR}/lfs.c
+    ${LFS_DIR}/lfs_util.c
+    ${DHARA_DIR}/dhara/map.c
+    ${DHARA_DIR}/dhara/journal.c
+    ${DHARA_DIR}/dhara/error.c
+)
+target_include_directories(trace_replay PRIVATE ${BENCH_DIR}/host ${FATFS_DIR} ${LFS_DIR} ${DHARA_DIR}/dhara)
+target_compile_definitions(trace_replay PRIVATE LFS_BCACHE LFS_FREEMAP LFS_CTZINDEX LFS_NO_DEBUG)
+target_compile_options(trace_replay PRIVATE -O2 -g -Wall $<$<COMPILE_LANGUAGE:CXX>:-fno-rtti -fno-exceptions>)
+set_target_properties(trace_replay PROPERTIES CXX_STANDARD 17)
+
+# Host tests, run with ctest (make bench_test). Every test is an executable
+# that returns non-zero on the first mismatch.
+enable_testing()
+
+function(bench_host_test name)
+    add_executable(${name} ${ARGN})
+    target_include_directories(${name} PRIVATE ${BENCH_HOST_INC_DIRS})
+    target_link_libraries(${name} PRIVATE Threads::Threads)
+    target_compile_options(${name} PRIVATE -O2 -g -Wall $<$<COMPILE_LANGUAGE:CXX>:-fno-rtti -fno-exceptions>)
+    set_target_properties(${name} PROPERTIES CXX_STANDARD 17)
+    add_test(NAME ${name} COMMAND ${name})
+endfunction()
+
+# Memory manager LIFO pools. MEM_POOL_SIZE and MEM_BLOCK_SIZE are the sizes
+# of the pool and block headers with 64-bit pointers, MEM_Init() asserts them.
+bench_host_test(test_mem_manager
+    ${BENCH_DIR}/host/test_mem_manager.cpp
+    ${ProjDirPath}/components/mem_manager/fsl_component_mem_manager.c
+)
+target_include_directories(test_mem_manager PRIVATE ${ProjDirPath}/components/mem_manager)
+target_compile_definitions(test_mem_manager PRIVATE
+    gMemManagerLight=0 MEM_MANAGER_PRE_CONFIGURE=0 MEM_MANAGER_LIFO_POOL=1 MEM_POOL_SIZE=48U MEM_BLOCK_SIZE=16U)
+set_source_files_properties(${ProjDirPath}/components/mem_manager/fsl_component_mem_manager.c PROPERTIES
+    COMPILE_OPTIONS -Wno-pointer-to-int-cast)
+
+# mflash file writer
+bench_host_test(test_mflash_file
+    ${BENCH_DIR}/host/test_mflash_file.cpp
+    ${BENCH_DIR}/host/MflashNorSim.cpp
+    ${BENCH_DIR}/Bench.cpp
+    ${MFLASH_DIR}/mflash_file.c
+)
+
+# Common task multi-priority message queue
+bench_host_test(test_common_task
+    ${BENCH_DIR}/host/test_common_task.cpp
+    ${ProjDirPath}/components/common_task/fsl_component_common_task.c
+)
+target_include_directories(test_common_task PRIVATE ${ProjDirPath}/components/common_task)
+target_compile_definitions(test_common_task PRIVATE OSA_USED COMMON_TASK_ENABLE=1 COMMON_TASK_PRIORITY_QUEUE=1)
+
+# Telemetry writer and stream decoder round trip
+bench_host_test(test_telemetry_stream
+    ${BENCH_DIR}/host/test_telemetry_stream.cpp
+    ${TELEMETRY_DIR}/Telemetry.cpp
+    ${TELEMETRY_DIR}/TelemetryFrame.cpp
+    ${TELEMETRY_DIR}/host/TelemetryStream.cpp
+    ${RTT_DIR}/RTT/SEGGER_RTT.c
+)
+
+# littlefs block cache and readahead
+bench_host_test(test_lfs_bcache
+    ${BENCH_DIR}/host/test_lfs_bcache.cpp
+    ${BENCH_DIR}/host/LfsRamDisk.cpp
+    ${BENCH_DIR}/Bench.cpp
+    ${LFS_DIR}/lfs.c
+    ${LFS_DIR}/lfs_util.c
+)
+target_compile_definitions(test_lfs_bcache PRIVATE LFS_BCACHE LFS_NO_DEBUG)
+
+# littlefs free block bitmap, against the lookahead allocator
+bench_host_test(test_lfs_freemap
+    ${BENCH_DIR}/host/test_lfs_freemap.cpp
+    ${BENCH_DIR}/host/LfsRamDisk.cpp
+    ${BENCH_DIR}/Bench.cpp
+    ${LFS_DIR}/lfs.c
+    ${LFS_DIR}/lfs_util.c
+)
+target_compile_definitions(test_lfs_freemap PRIVATE LFS_FREEMAP LFS_NO_DEBUG)
+
+# littlefs block index of open files
+bench_host_test(test_lfs_seek
+    ${BENCH_DIR}/host/test_lfs_seek.cpp
+    ${BENCH_DIR}/host/LfsRamDisk.cpp
+    ${BENCH_DIR}/Bench.cpp
+    ${LFS_DIR}/lfs.c
+    ${LFS_DIR}/lfs_util.c
+)
+target_compile_definitions(test_lfs_seek PRIVATE LFS_CTZINDEX LFS_NO_DEBUG)
+
+# FatFs streams with overlapped transfers on FAT12, FAT16 and FAT32, on a
+# 64 MiB RAM disk
+bench_host_test(test_fatfs_stream
+    ${BENCH_DIR}/host/test_fatfs_stream.cpp
+    ${BENCH_DIR}/host/fatfs_diskio.cpp
+    ${BENCH_DIR}/host/fatfs_win1.c
+    ${BENCH_DIR}/host/fatfs_cache.c
+    ${BENCH_DIR}/Bench.cpp
+    ${FATFS_DIR}/ffunicode.c
+    ${FATFS_DIR}/fsl_ram_disk/fsl_ram_disk.c
+)
+target_compile_definitions(test_fatfs_stream PRIVATE FSL_FF_RAMDISK_DISK_SIZE=0x4000000)
+
+# FatFs directory name cache, with the name cache of the benches and the
+# smallest one
+bench_host_test(test_fatfs_dir
+    ${BENCH_DIR}/host/test_fatfs_dir.cpp
+    ${BENCH_DIR}/host/fatfs_diskio.cpp
+    ${BENCH_DIR}/host/fatfs_win1.c
+    ${BENCH_DIR}/host/fatfs_dir.c
+    ${BENCH_DIR}/host/fatfs_dir_small.c
+    ${BENCH_DIR}/Bench.cpp
+    ${FATFS_DIR}/ffunicode.c
+    ${FATFS_DIR}/fsl_ram_disk/fsl_ram_disk.c
+)
+target_compile_definitions(test_fatfs_dir PRIVATE FSL_FF_RAMDISK_DISK_SIZE=0x4000000)
+
+# dhara BCH ECC against the bit-serial reference
+bench_host_test(test_dhara_bch
+    ${BENCH_DIR}/host/test_dhara_bch.cpp
+    ${BENCH_DIR}/host/bch_ref.c
+    ${DHARA_DIR}/ecc/bch.c
+    ${DHARA_DIR}/ecc/gf13.c
+)
+
+# dhara map on a simulated NAND chip failing often
+bench_host_test(test_dhara_map
+    ${BENCH_DIR}/host/test_dhara_map.cpp
+    ${BENCH_DIR}/host/DharaNandSim.cpp
+    ${BENCH_DIR}/Bench.cpp
+    ${DHARA_DIR}/dhara/map.c
+    ${DHARA_DIR}/dhara/journal.c
+    ${DHARA_DIR}/dhara/error.c
+)
+
+# SD card streaming on a simulated card failing often
+bench_host_test(test_sd_stream
+    ${BENCH_DIR}/host/test_sd_stream.cpp
+    ${BENCH_DIR}/host/SdCardSim.cpp
+    ${BENCH_DIR}/Bench.cpp
+    ${SDMMC_DIR}/sd/fsl_sd_stream.c
+)
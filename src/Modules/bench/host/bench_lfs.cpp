@@ -0,0 +1,147 @@
+#include "Bench.hpp"
+#include "LfsRamDisk.hpp"
+
+#include "lfs.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// littlefs metadata and file reads on an 8 MiB RAM disk with the QSPI
+// geometry, without and with the LFS_BCACHE block cache. The volume holds
+// 4 directories of 16 small files and one 64 KiB file. ev/op is the number
+// of block device reads per operation. The cache is checked by
+// test_lfs_bcache.
+
+static constexpr lfs_size_t BLOCK_COUNT = 2048;
+static constexpr int DIRS = 4;
+static constexpr int FILES = 16;
+static constexpr lfs_size_t SMALL_SIZE = 1000;
+static constexpr lfs_size_t LARGE_SIZE = 64 * 1024;
+static constexpr lfs_size_t CHUNK = 256;
+
+static LfsRamDisk s_disk;
+static lfs_config s_cfg_plain;
+static lfs_config s_cfg_bcache;
+static lfs_t s_lfs;
+static bool s_formatted = false;
+static bool s_mounted = false;
+static uint8_t s_buf[SMALL_SIZE];
+static uint32_t s_seed = 1;
+
+static bool populate()
+{
+	if (lfs_format(&s_lfs, &s_cfg_plain) != LFS_ERR_OK || lfs_mount(&s_lfs, &s_cfg_plain) != LFS_ERR_OK) {
+		return false;
+	}
+
+	char path[32];
+	lfs_file_t file;
+
+	for (size_t i = 0; i < sizeof(s_buf); i++) {
+		s_buf[i] = (uint8_t)i;
+	}
+
+	for (int d = 0; d < DIRS; d++) {
+		snprintf(path, sizeof(path), "d%d", d);
+		lfs_mkdir(&s_lfs, path);
+
+		for (int f = 0; f < FILES; f++) {
+			snprintf(path, sizeof(path), "d%d/file%02d.log", d, f);
+
+			if (lfs_file_open(&s_lfs, &file, path, LFS_O_WRONLY | LFS_O_CREAT) != LFS_ERR_OK) {
+				return false;
+			}
+
+			lfs_file_write(&s_lfs, &file, s_buf, SMALL_SIZE);
+			lfs_file_close(&s_lfs, &file);
+		}
+	}
+
+	if (lfs_file_open(&s_lfs, &file, "large.bin", LFS_O_WRONLY | LFS_O_CREAT) != LFS_ERR_OK) {
+		return false;
+	}
+
+	for (lfs_size_t off = 0; off < LARGE_SIZE; off += SMALL_SIZE) {
+		lfs_file_write(&s_lfs, &file, s_buf, lfs_min(SMALL_SIZE, LARGE_SIZE - off));
+	}
+
+	lfs_file_close(&s_lfs, &file);
+	lfs_unmount(&s_lfs);
+	return true;
+}
+
+static void mount(const lfs_config *cfg)
+{
+	if (!s_formatted) {
+		if (!s_disk.init(BLOCK_COUNT, s_cfg_plain)) {
+			return;
+		}
+
+		s_cfg_bcache = s_cfg_plain;
+		s_cfg_bcache.bcache_lines = 32;
+		s_cfg_bcache.bcache_ways = 4;
+		s_cfg_bcache.bcache_readahead = 2048;
+		s_formatted = populate();
+	}
+
+	if (s_mounted) {
+		lfs_unmount(&s_lfs);
+		s_mounted = false;
+	}
+
+	s_mounted = s_formatted && lfs_mount(&s_lfs, cfg) == LFS_ERR_OK;
+	s_seed = 1;
+}
+
+static void setup_plain() { mount(&s_cfg_plain); }
+static void setup_bcache() { mount(&s_cfg_bcache); }
+
+static void small_path(char *path, size_t len)
+{
+	s_seed = s_seed * 1103515245 + 12345;
+	unsigned n = (s_seed >> 16) % (DIRS * FILES);
+	snprintf(path, len, "d%u/file%02u.log", n / FILES, n % FILES);
+}
+
+static void open_small()
+{
+	char path[32];
+	lfs_file_t file;
+	small_path(path, sizeof(path));
+
+	if (lfs_file_open(&s_lfs, &file, path, LFS_O_RDONLY) == LFS_ERR_OK) {
+		lfs_ssize_t n = lfs_file_read(&s_lfs, &file, s_buf, SMALL_SIZE);
+		bench::do_not_optimize(n);
+		lfs_file_close(&s_lfs, &file);
+	}
+}
+
+static void stat_small()
+{
+	char path[32];
+	lfs_info info;
+	small_path(path, sizeof(path));
+	int err = lfs_stat(&s_lfs, path, &info);
+	bench::do_not_optimize(err);
+}
+
+static void seqread_large()
+{
+	lfs_file_t file;
+
+	if (lfs_file_open(&s_lfs, &file, "large.bin", LFS_O_RDONLY) == LFS_ERR_OK) {
+		for (lfs_size_t off = 0; off < LARGE_SIZE; off += CHUNK) {
+			lfs_ssize_t n = lfs_file_read(&s_lfs, &file, s_buf, CHUNK);
+			bench::do_not_optimize(n);
+		}
+
+		lfs_file_close(&s_lfs, &file);
+	}
+}
+
+BENCH_CASE_EX(lfs, open_small, setup_plain, 1) { open_small(); }
+BENCH_CASE_EX(lfs, open_small_bcache, setup_bcache, 1) { open_small(); }
+BENCH_CASE_EX(lfs, stat, setup_plain, 1) { stat_small(); }
+BENCH_CASE_EX(lfs, stat_bcache, setup_bcache, 1) { stat_small(); }
+BENCH_CASE_EX(lfs, seqread_64k, setup_plain, 1) { seqread_large(); }
+BENCH_CASE_EX(lfs, seqread_64k_bcache, setup_bcache, 1) { seqread_large(); }
@@ -0,0 +1,128 @@
+#include "Bench.hpp"
+#include "LfsRamDisk.hpp"
+
+#include "lfs.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// littlefs block allocation at 25 % - 90 % fill on an 8 MiB RAM disk. The
+// volume is filled with 256 KiB files and every operation rewrites one of 4
+// small 16 KiB files. With the lookahead buffer (16 bytes, 128 blocks) the
+// allocator traverses the whole filesystem, reading the pointers of every
+// file block, whenever the window runs out of free blocks. The fuller the
+// volume, the fewer free blocks a window holds and the longer a traversal
+// takes, which shows up in median, p99 and max. With LFS_FREEMAP the
+// blocks of the old file version are freed when the new one is committed.
+// The bitmap is checked by test_lfs_freemap.
+
+static constexpr lfs_size_t BLOCK_COUNT = 2048;
+static constexpr lfs_size_t FILL_SIZE = 256 * 1024;
+static constexpr lfs_size_t HOT_SIZE = 16 * 1024;
+static constexpr uint32_t HOT_FILES = 4;
+static constexpr lfs_size_t CHUNK = 1024;
+
+static LfsRamDisk s_disk;
+static lfs_config s_cfg;
+static lfs_t s_lfs;
+static bool s_mounted = false;
+static uint32_t s_next = 0;
+static uint8_t s_buf[CHUNK];
+
+static bool write_file(const char *path, lfs_size_t size)
+{
+	lfs_file_t file;
+
+	if (lfs_file_open(&s_lfs, &file, path, LFS_O_WRONLY | LFS_O_CREAT | LFS_O_TRUNC) != LFS_ERR_OK) {
+		return false;
+	}
+
+	bool ok = true;
+
+	for (lfs_size_t off = 0; off < size; off += CHUNK) {
+		ok &= lfs_file_write(&s_lfs, &file, s_buf, CHUNK) == (lfs_ssize_t)CHUNK;
+	}
+
+	return lfs_file_close(&s_lfs, &file) == LFS_ERR_OK && ok;
+}
+
+static void setup(uint32_t fill_percent, bool freemap)
+{
+	if (s_mounted) {
+		lfs_unmount(&s_lfs);
+		s_mounted = false;
+	}
+
+	if (!s_disk.init(BLOCK_COUNT, s_cfg)) {
+		return;
+	}
+
+	s_cfg.freemap = freemap;
+
+	if (lfs_format(&s_lfs, &s_cfg) != LFS_ERR_OK || lfs_mount(&s_lfs, &s_cfg) != LFS_ERR_OK) {
+		return;
+	}
+
+	memset(s_buf, 0x5a, sizeof(s_buf));
+	lfs_mkdir(&s_lfs, "fill");
+	lfs_mkdir(&s_lfs, "hot");
+
+	char path[24];
+	bool ok = true;
+
+	for (uint32_t n = 0; n < HOT_FILES && ok; n++) {
+		snprintf(path, sizeof(path), "hot/%lu", (unsigned long)n);
+		ok = write_file(path, HOT_SIZE);
+	}
+
+	// a 256 KiB file takes 65 blocks including pointers
+	uint32_t fill_files = BLOCK_COUNT * fill_percent / 100 / 65;
+
+	for (uint32_t n = 0; n < fill_files && ok; n++) {
+		snprintf(path, sizeof(path), "fill/%03lu", (unsigned long)n);
+		ok = write_file(path, FILL_SIZE);
+	}
+
+	// start from the state found after a reboot
+	lfs_unmount(&s_lfs);
+	s_mounted = ok && lfs_mount(&s_lfs, &s_cfg) == LFS_ERR_OK;
+	s_next = 0;
+
+	if (!s_mounted) {
+		printf("lfs_alloc: fill to %lu %% failed\n", (unsigned long)fill_percent);
+	}
+}
+
+static void rewrite()
+{
+	if (s_mounted) {
+		char path[24];
+		snprintf(path, sizeof(path), "hot/%lu", (unsigned long)s_next);
+		s_next = (s_next + 1) % HOT_FILES;
+
+		// stop timing a broken volume
+		if (!write_file(path, HOT_SIZE)) {
+			printf("lfs_alloc: rewrite of %s failed\n", path);
+			lfs_unmount(&s_lfs);
+			s_mounted = false;
+		}
+	}
+}
+
+static void setup_25() { setup(25, false); }
+static void setup_50() { setup(50, false); }
+static void setup_75() { setup(75, false); }
+static void setup_90() { setup(90, false); }
+static void setup_25_freemap() { setup(25, true); }
+static void setup_50_freemap() { setup(50, true); }
+static void setup_75_freemap() { setup(75, true); }
+static void setup_90_freemap() { setup(90, true); }
+
+BENCH_CASE_EX(lfs_alloc, rewrite_16k_fill25, setup_25, 1) { rewrite(); }
+BENCH_CASE_EX(lfs_alloc, rewrite_16k_fill25_freemap, setup_25_freemap, 1) { rewrite(); }
+BENCH_CASE_EX(lfs_alloc, rewrite_16k_fill50, setup_50, 1) { rewrite(); }
+BENCH_CASE_EX(lfs_alloc, rewrite_16k_fill50_freemap, setup_50_freemap, 1) { rewrite(); }
+BENCH_CASE_EX(lfs_alloc, rewrite_16k_fill75, setup_75, 1) { rewrite(); }
+BENCH_CASE_EX(lfs_alloc, rewrite_16k_fill75_freemap, setup_75_freemap, 1) { rewrite(); }
+BENCH_CASE_EX(lfs_alloc, rewrite_16k_fill90, setup_90, 1) { rewrite(); }
+BENCH_CASE_EX(lfs_alloc, rewrite_16k_fill90_freemap, setup_90_freemap, 1) { rewrite(); }
@@ -0,0 +1,103 @@
+#include "Bench.hpp"
+#include "LfsRamDisk.hpp"
+
+#include "lfs.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// Random 4 KiB reads from a 12 MiB data log on a 16 MiB RAM disk, without
+// and with the LFS_CTZINDEX block index of the open file. Without the index
+// every seek walks the CTZ skip-list from the end of the file, O(log n)
+// pointer reads. With 64 entries (256 B) the walk starts less than 64
+// blocks above the target, with an entry per block (12 KiB) it reads no
+// pointers once the index is filled.
+// The data itself takes 16-17 reads of cache_size per operation in all
+// cases. The index is checked by test_lfs_seek.
+
+static constexpr lfs_size_t BLOCK_COUNT = 4096;
+static constexpr lfs_size_t LOG_SIZE = 12 * 1024 * 1024;
+static constexpr lfs_size_t READ_SIZE = 4096;
+
+static LfsRamDisk s_disk;
+static lfs_config s_cfg;
+static lfs_t s_lfs;
+static lfs_file_t s_file;
+static lfs_file_config s_file_cfg;
+static bool s_formatted = false;
+static bool s_open = false;
+static uint8_t s_buf[READ_SIZE];
+static uint32_t s_seed = 1;
+
+static bool create_log()
+{
+	if (!s_disk.init(BLOCK_COUNT, s_cfg)) {
+		return false;
+	}
+
+	if (lfs_format(&s_lfs, &s_cfg) != LFS_ERR_OK || lfs_mount(&s_lfs, &s_cfg) != LFS_ERR_OK) {
+		return false;
+	}
+
+	lfs_file_t file;
+
+	if (lfs_file_open(&s_lfs, &file, "log.bin", LFS_O_WRONLY | LFS_O_CREAT) != LFS_ERR_OK) {
+		return false;
+	}
+
+	for (lfs_size_t off = 0; off < LOG_SIZE; off += READ_SIZE) {
+		memset(s_buf, (int)(off / READ_SIZE), sizeof(s_buf));
+		lfs_file_write(&s_lfs, &file, s_buf, READ_SIZE);
+	}
+
+	return lfs_file_close(&s_lfs, &file) == LFS_ERR_OK;
+}
+
+static void open_log(lfs_size_t index_count, bool fill_index)
+{
+	if (s_open) {
+		lfs_file_close(&s_lfs, &s_file);
+		s_open = false;
+	}
+
+	if (!s_formatted) {
+		s_formatted = create_log();
+
+		if (!s_formatted) {
+			printf("lfs_seek: creating the log failed\n");
+			return;
+		}
+	}
+
+	memset(&s_file_cfg, 0, sizeof(s_file_cfg));
+	s_file_cfg.index_count = index_count;
+	s_open = lfs_file_opencfg(&s_lfs, &s_file, "log.bin", LFS_O_RDONLY, &s_file_cfg) == LFS_ERR_OK;
+
+	if (s_open && fill_index) {
+		lfs_file_index(&s_lfs, &s_file);
+	}
+
+	s_seed = 1;
+}
+
+static void random_read()
+{
+	if (s_open) {
+		s_seed = s_seed * 1103515245 + 12345;
+		lfs_soff_t pos = (lfs_soff_t)((s_seed >> 8) % (LOG_SIZE - READ_SIZE));
+		lfs_file_seek(&s_lfs, &s_file, pos, LFS_SEEK_SET);
+		lfs_ssize_t n = lfs_file_read(&s_lfs, &s_file, s_buf, READ_SIZE);
+		bench::do_not_optimize(n);
+	}
+}
+
+// the 12 MiB log takes 3080 blocks
+static void setup_plain() { open_log(0, false); }
+static void setup_index64() { open_log(64, false); }
+static void setup_index_full() { open_log(3080, false); }
+static void setup_index_full_filled() { open_log(3080, true); }
+
+BENCH_CASE_EX(lfs_seek, randread_4k, setup_plain, 1) { random_read(); }
+BENCH_CASE_EX(lfs_seek, randread_4k_index64, setup_index64, 1) { random_read(); }
+BENCH_CASE_EX(lfs_seek, randread_4k_index_full, setup_index_full, 1) { random_read(); }
+BENCH_CASE_EX(lfs_seek, randread_4k_index_filled, setup_index_full_filled, 1) { random_read(); }
@@ -0,0 +1,58 @@
+#include "Bench.hpp"
+
+#include "lwip/inet_chksum.h"
+
+#include <string.h>
+
+// lwIP software checksum over 64 B - 1500 B payloads: memcpy followed by
+// inet_chksum() as done without LWIP_CHECKSUM_ON_COPY, vs. the fused
+// lwip_chksum_copy() used by TCP output.
+
+static uint8_t s_src[1500 + 4];
+static uint8_t s_dst[1500 + 4];
+
+// lwIP's unix port hooks, only needed for linking.
+extern "C" unsigned int lwip_port_rand(void)
+{
+	return 4;
+}
+
+static void chksum_setup()
+{
+	for (size_t i = 0; i < sizeof(s_src); i++) {
+		s_src[i] = (uint8_t)(i * 7);
+	}
+}
+
+static void copy_then_sum(size_t offset, u16_t len)
+{
+	MEMCPY(&s_dst[offset], s_src, len);
+	u16_t sum = inet_chksum(&s_dst[offset], len);
+	bench::do_not_optimize(sum);
+}
+
+static void fused(size_t offset, u16_t len)
+{
+	u16_t sum = lwip_chksum_copy(&s_dst[offset], s_src, len);
+	bench::do_not_optimize(sum);
+}
+
+BENCH_CASE_EX(chksum, inet_1500, chksum_setup, 1)
+{
+	u16_t sum = inet_chksum(s_src, 1500);
+	bench::do_not_optimize(sum);
+}
+
+BENCH_CASE_EX(chksum, copy_then_sum_64, chksum_setup, 1) { copy_then_sum(0, 64); }
+BENCH_CASE_EX(chksum, fused_64, chksum_setup, 1) { fused(0, 64); }
+BENCH_CASE_EX(chksum, copy_then_sum_256, chksum_setup, 1) { copy_then_sum(0, 256); }
+BENCH_CASE_EX(chksum, fused_256, chksum_setup, 1) { fused(0, 256); }
+BENCH_CASE_EX(chksum, copy_then_sum_536, chksum_setup, 1) { copy_then_sum(0, 536); }
+BENCH_CASE_EX(chksum, fused_536, chksum_setup, 1) { fused(0, 536); }
+BENCH_CASE_EX(chksum, copy_then_sum_1460, chksum_setup, 1) { copy_then_sum(0, 1460); }
+BENCH_CASE_EX(chksum, fused_1460, chksum_setup, 1) { fused(0, 1460); }
+BENCH_CASE_EX(chksum, copy_then_sum_1500, chksum_setup, 1) { copy_then_sum(0, 1500); }
+BENCH_CASE_EX(chksum, fused_1500, chksum_setup, 1) { fused(0, 1500); }
+// Destination not word aligned, e.g. after a 54 byte header.
+BENCH_CASE_EX(chksum, copy_then_sum_1460_odd, chksum_setup, 1) { copy_then_sum(2, 1460); }
+BENCH_CASE_EX(chksum, fused_1460_odd, chksum_setup, 1) { fused(2, 1460); }
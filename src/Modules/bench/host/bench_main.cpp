@@ -0,0 +1,38 @@
+#include "Bench.hpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void StdoutSink(const char *line)
+{
+	fputs(line, stdout);
+}
+
+static void usage(const char *name)
+{
+	printf("usage: %s [-w warmup] [-n iterations] [filter]\n", name);
+}
+
+int main(int argc, char *argv[])
+{
+	bench::Config config;
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-w") == 0 && i + 1 < argc) {
+			config.warmup = (uint32_t)strtoul(argv[++i], nullptr, 0);
+
+		} else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+			config.iterations = (uint32_t)strtoul(argv[++i], nullptr, 0);
+
+		} else if (argv[i][0] == '-') {
+			usage(argv[0]);
+			return 1;
+
+		} else {
+			config.filter = argv[i];
+		}
+	}
+
+	return bench::Runner::run_all(config, StdoutSink) > 0 ? 0 : 1;
+}
@@ -0,0 +1,89 @@
+#include "Bench.hpp"
+#include "MflashNorSim.hpp"
+
+extern "C" {
+#include "mflash_file.h"
+}
+
+#include <stdio.h>
+#include <string.h>
+
+// mflash files on a simulated 128 KiB NOR flash (MflashNorSim) with 256 B
+// pages and 4 KiB sectors. Each call stores a 32 KiB file in an area
+// pre-allocated for 64 KiB.
+//
+//   save_32k             mflash_file_save() of the whole file from RAM
+//   writer_32k_4k        mflash_file_writer_write() in aligned 4 KiB chunks,
+//                        programmed straight from the caller buffer
+//   writer_32k_100       the same in unaligned 100 B chunks, collected in
+//                        the page buffer of the writer
+//
+// ev/op is the number of page programs and sector erases per call; the
+// flash is not timed, so the time is the CPU cost of the paths. The writer
+// is checked against a model by test_mflash_file.
+
+static constexpr uint32_t FLASH_SIZE = 128 * 1024;
+static constexpr uint32_t FILE_SIZE = 32 * 1024;
+
+static const mflash_file_t TEMPLATE[] = {
+	{"small", 1000},
+	{"edge", MFLASH_SECTOR_SIZE},
+	{"big", 40000},
+	{"bench", 64 * 1024},
+	{nullptr, 0},
+};
+
+static MflashNorSim s_flash;
+static bool s_ready = false;
+
+// One byte more than the file, to write from an unaligned address
+alignas(4) static uint8_t s_data[FILE_SIZE + 4];
+
+static bool init_flash()
+{
+	if (!s_flash.init(FLASH_SIZE)) {
+		return false;
+	}
+
+	return mflash_init(TEMPLATE, true) == kStatus_Success;
+}
+
+static void setup()
+{
+	s_ready = init_flash();
+
+	if (!s_ready) {
+		printf("mflash_file: formatting the flash failed\n");
+		return;
+	}
+
+	memset(s_data, 0x5a, sizeof(s_data));
+}
+
+static void save()
+{
+	if (s_ready) {
+		mflash_file_save("bench", s_data, FILE_SIZE);
+		bench::transfer(FILE_SIZE);
+	}
+}
+
+static void write(uint32_t chunk, uint32_t align)
+{
+	mflash_file_writer_t writer;
+
+	if (s_ready) {
+		mflash_file_writer_open(&writer, "bench");
+
+		for (uint32_t off = 0; off < FILE_SIZE; off += chunk) {
+			mflash_file_writer_write(&writer, &s_data[align + off], FILE_SIZE - off < chunk ? FILE_SIZE - off : chunk);
+		}
+
+		mflash_file_writer_close(&writer);
+		bench::transfer(FILE_SIZE);
+	}
+}
+
+BENCH_CASE_EX(mflash_file, save_32k, setup, 1) { save(); }
+BENCH_CASE_EX(mflash_file, writer_32k_4k, setup, 1) { write(4096, 0); }
+BENCH_CASE_EX(mflash_file, writer_32k_100, setup, 1) { write(100, 1); }
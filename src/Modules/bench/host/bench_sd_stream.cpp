@@ -0,0 +1,228 @@
+#include "Bench.hpp"
+#include "SdCardSim.hpp"
+
+extern "C" {
+#include "fsl_sd_stream.h"
+}
+
+#include <stdio.h>
+#include <string.h>
+
+// SD card streaming (fsl_sd_stream.c) on a simulated 32 MiB card
+// (SdCardSim) behind a uSDHC host with 16 ADMA2 descriptors. The bus runs
+// at 50 MB/s (4-bit SDR50) with 3 us per command and response, reads wait
+// 80 us for the first block, and the card programs a block in 20 us, 12 us
+// if pre-erased, and takes 300 us to commit a write. Each write op stands
+// for a logger handing over an 8 KiB chunk it took 100 us to fill.
+//
+//   write_blocks_16         what SD_WriteBlocks() does for the chunk: poll
+//                           DAT0 and CMD13, then CMD25 and auto CMD12,
+//                           which waits for the card to program
+//   stream_write_16         SD_StreamWrite() of the chunk, transferred on
+//                           its own with ACMD23 and auto CMD23, the card
+//                           programs while the next chunk is filled
+//   stream_write_16_cmd12   the same on a card without CMD23
+//   stream_write_128_chain  SD_StreamWrite() of 8 chunks in separate
+//                           buffers, transferred together over a chain of
+//                           8 descriptors
+//   read_blocks_16          what SD_ReadBlocks() does for the chunk
+//   stream_read_128_chain   SD_StreamRead() of 8 chunks in separate
+//                           buffers, transferred together
+//
+// Each call hands over 8 chunks, results are per chunk and ev/op is the
+// number of commands on the bus. Random streams are checked against a model
+// by test_sd_stream.
+
+static constexpr uint32_t BLOCK_SIZE = 512;
+static constexpr uint32_t CARD_BLOCKS = 65536;
+static constexpr uint32_t MAX_BLOCK_COUNT = 65535;
+static constexpr uint32_t DESCRIPTOR_WORDS = 32;
+static constexpr uint32_t CHUNK_BLOCKS = 16;
+static constexpr uint32_t CHAIN_CHUNKS = 8;
+static constexpr uint32_t PRODUCE_US = 100;
+static constexpr uint32_t POLL_US = 125; // SD_PollingCardStatusBusy()
+
+static constexpr uint32_t CHUNK_SIZE = CHUNK_BLOCKS * BLOCK_SIZE;
+static constexpr SdCardSim::Timing TIMING = {3000, 20, 80, 300, 20000, 12000};
+
+// R1 status
+static constexpr uint32_t R1_ERRORS = 0xfff90008u;
+static constexpr uint32_t R1_READY_FOR_DATA = 1u << 8;
+static constexpr uint32_t R1_STATE_TRAN = 4;
+
+static SdCardSim s_sim;
+static sd_card_t s_card;
+static sd_stream_t s_stream;
+static bool s_streaming = false;
+static uint32_t s_next = 0;
+static uint32_t s_chunk = 0;
+
+// Chunks of the chains, a block apart so that they don't merge
+alignas(4) static uint8_t s_chunks[CHAIN_CHUNKS][CHUNK_SIZE + BLOCK_SIZE];
+
+static bool init_card(bool cmd23)
+{
+	if (!s_sim.init(CARD_BLOCKS, cmd23, MAX_BLOCK_COUNT, DESCRIPTOR_WORDS, 0, 1)) {
+		return false;
+	}
+
+	memset(&s_card, 0, sizeof(s_card));
+	s_card.host = s_sim.host();
+	s_card.relativeAddress = 1;
+	s_card.blockCount = CARD_BLOCKS;
+	s_card.blockSize = BLOCK_SIZE;
+	s_card.flags = kSD_SupportHighCapacityFlag | (cmd23 ? kSD_SupportSetBlockCountCmd : 0);
+	return true;
+}
+
+// Baseline
+
+static bool wait_ready()
+{
+	sdmmchost_cmd_t command{};
+	sdmmchost_transfer_t content{};
+
+	content.command = &command;
+
+	for (;;) {
+		if (SDMMCHOST_IsCardBusy(s_card.host)) {
+			SDMMC_OSADelayUs(POLL_US);
+			continue;
+		}
+
+		command.index = 13;
+		command.argument = s_card.relativeAddress << 16;
+		command.responseType = kCARD_ResponseTypeR1;
+		command.responseErrorFlags = R1_ERRORS;
+
+		if (SDMMCHOST_TransferFunction(s_card.host, &content) != kStatus_Success) {
+			return false;
+		}
+
+		if ((command.response[0] & R1_READY_FOR_DATA) != 0 && ((command.response[0] >> 9) & 0xf) == R1_STATE_TRAN) {
+			return true;
+		}
+	}
+}
+
+static bool transfer_blocks(bool write, uint8_t *buffer, uint32_t block, uint32_t blocks)
+{
+	sdmmchost_cmd_t command{};
+	sdmmchost_data_t data{};
+	sdmmchost_transfer_t content{};
+
+	if (!wait_ready()) {
+		return false;
+	}
+
+	data.enableAutoCommand12 = true;
+	data.blockSize = BLOCK_SIZE;
+	data.blockCount = blocks;
+
+	if (write) {
+		data.txData = (const uint32_t *)buffer;
+
+	} else {
+		data.rxData = (uint32_t *)buffer;
+	}
+
+	command.index = write ? 25 : 18;
+	command.argument = block;
+	command.responseType = kCARD_ResponseTypeR1;
+	command.responseErrorFlags = R1_ERRORS;
+
+	content.command = &command;
+	content.data = &data;
+
+	return SDMMCHOST_TransferFunction(s_card.host, &content) == kStatus_Success;
+}
+
+// Benchmark
+
+static void setup(bool cmd23, bool stream, sd_stream_direction_t direction, uint32_t transfer_blocks)
+{
+	s_streaming = false;
+	s_next = 0;
+	s_chunk = 0;
+
+	if (!init_card(cmd23)) {
+		printf("sd_stream: allocating the card failed\n");
+		return;
+	}
+
+	memset(s_chunks, 0x5a, sizeof(s_chunks));
+	s_sim.set_timing(&TIMING);
+
+	if (stream) {
+		s_streaming = SD_StreamStart(&s_card, &s_stream, direction, 0, transfer_blocks) == kStatus_Success;
+
+		if (!s_streaming) {
+			printf("sd_stream: starting the stream failed\n");
+		}
+	}
+}
+
+static void next_chunk()
+{
+	s_next += CHUNK_BLOCKS;
+
+	if (s_next + CHUNK_BLOCKS > CARD_BLOCKS) {
+		s_next = 0;
+	}
+
+	s_chunk = (s_chunk + 1) % CHAIN_CHUNKS;
+	bench::transfer(CHUNK_SIZE);
+}
+
+static void write_blocks()
+{
+	for (uint32_t i = 0; i < CHAIN_CHUNKS; i++) {
+		SDMMC_OSADelayUs(PRODUCE_US);
+		transfer_blocks(true, s_chunks[s_chunk], s_next, CHUNK_BLOCKS);
+		next_chunk();
+	}
+}
+
+static void read_blocks()
+{
+	for (uint32_t i = 0; i < CHAIN_CHUNKS; i++) {
+		transfer_blocks(false, s_chunks[s_chunk], s_next, CHUNK_BLOCKS);
+		next_chunk();
+	}
+}
+
+static void stream_chunks()
+{
+	for (uint32_t i = 0; s_streaming && i < CHAIN_CHUNKS; i++) {
+		// Wrap around at the end of the card
+		if (s_next == 0 && s_stream.nextBlock + s_stream.queuedBlocks != 0) {
+			const uint32_t transfer_blocks = s_stream.transferBlocks;
+
+			SD_StreamStop(&s_stream);
+			SD_StreamStart(&s_card, &s_stream, s_stream.direction, 0, transfer_blocks);
+		}
+
+		if (s_stream.direction == kSD_StreamWrite) {
+			SDMMC_OSADelayUs(PRODUCE_US);
+			SD_StreamWrite(&s_stream, s_chunks[s_chunk], CHUNK_BLOCKS);
+
+		} else {
+			SD_StreamRead(&s_stream, s_chunks[s_chunk], CHUNK_BLOCKS);
+		}
+
+		next_chunk();
+	}
+}
+
+static void setup_blocks() { setup(true, false, kSD_StreamWrite, 0); }
+static void setup_write_16() { setup(true, true, kSD_StreamWrite, CHUNK_BLOCKS); }
+static void setup_write_16_cmd12() { setup(false, true, kSD_StreamWrite, CHUNK_BLOCKS); }
+static void setup_write_chain() { setup(true, true, kSD_StreamWrite, CHAIN_CHUNKS * CHUNK_BLOCKS); }
+static void setup_read_chain() { setup(true, true, kSD_StreamRead, CHAIN_CHUNKS * CHUNK_BLOCKS); }
+
+BENCH_CASE_EX(sd_stream, write_blocks_16, setup_blocks, CHAIN_CHUNKS) { write_blocks(); }
+BENCH_CASE_EX(sd_stream, stream_write_16, setup_write_16, CHAIN_CHUNKS) { stream_chunks(); }
+BENCH_CASE_EX(sd_stream, stream_write_16_cmd12, setup_write_16_cmd12, CHAIN_CHUNKS) { stream_chunks(); }
+BENCH_CASE_EX(sd_stream, stream_write_128_chain, setup_write_chain, CHAIN_CHUNKS) { stream_chunks(); }
+BENCH_CASE_EX(sd_stream, read_blocks_16, setup_blocks, CHAIN_CHUNKS) { read_blocks(); }
+BENCH_CASE_EX(sd_stream, stream_read_128_chain, setup_read_chain, CHAIN_CHUNKS) { stream_chunks(); }
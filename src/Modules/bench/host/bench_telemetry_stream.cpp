@@ -0,0 +1,106 @@
+#include "Bench.hpp"
+
+#include "RttTransport.hpp"
+#include "Telemetry.hpp"
+#include "TelemetryStream.hpp"
+
+#include <stdio.h>
+#include <vector>
+
+// Decoding a captured telemetry stream as telemetry_decode does
+// (StreamDecoder), on a stream of three topics published through the
+// writer and an RTT up-buffer drained the way the debug probe would.
+//
+//   decode   one frame per op, with its share of the announcements
+//
+// The round trip is checked by test_telemetry_stream.
+
+static constexpr unsigned RTT_INDEX = 2;
+static constexpr unsigned FRAMES = 1200;
+
+static uint8_t s_rtt_buffer[4096];
+static std::vector<uint8_t> s_stream;
+static bool s_ready = false;
+static uint32_t s_seed = 1;
+
+static uint32_t next_random()
+{
+	s_seed = s_seed * 1103515245 + 12345;
+	return s_seed >> 8;
+}
+
+static void drain()
+{
+	uint8_t buffer[256];
+	unsigned n;
+
+	while ((n = SEGGER_RTT_ReadUpBufferNoLock(RTT_INDEX, buffer, sizeof(buffer))) > 0) {
+		s_stream.insert(s_stream.end(), buffer, buffer + n);
+	}
+}
+
+static bool capture()
+{
+	static telemetry::RttTransport transport(RTT_INDEX, "TelemetryCheck", s_rtt_buffer, sizeof(s_rtt_buffer));
+	telemetry::Writer writer(transport);
+	telemetry::Topic topics[] = {
+		telemetry::Topic("estimator", 1),
+		telemetry::Topic("imu", 2),
+		telemetry::Topic("a_rather_long_status_topic_name", 200),
+	};
+
+	if (!transport.init()) {
+		return false;
+	}
+
+	s_stream.clear();
+	s_seed = 1;
+
+	for (unsigned n = 0; n < FRAMES; n++) {
+		// Mostly the first topic, so that its seq wraps and it is announced again
+		const uint32_t r = next_random() % 8;
+		telemetry::Topic &topic = topics[r < 5 ? 0 : r < 7 ? 1 : 2];
+		const uint8_t payload_len = topic.id() == 1 ? 64 : (uint8_t)(next_random() % (telemetry::MAX_PAYLOAD + 1));
+		uint8_t payload[telemetry::MAX_PAYLOAD];
+
+		// Zeros and random bytes, COBS has to escape the zeros
+		for (unsigned i = 0; i < payload_len; i++) {
+			payload[i] = next_random() % 4 == 0 ? 0 : (uint8_t)next_random();
+		}
+
+		if (!writer.publish(topic, payload, payload_len, n * 250)) {
+			printf("telemetry_stream: publishing frame %u failed\n", n);
+			return false;
+		}
+
+		drain();
+	}
+
+	return true;
+}
+
+// Benchmark
+
+static void setup()
+{
+	s_ready = capture();
+
+	if (!s_ready) {
+		printf("telemetry_stream: capturing the stream failed\n");
+	}
+}
+BENCH_CASE_EX(telemetry_stream, decode, setup, FRAMES)
+{
+	static telemetry::StreamDecoder decoder;
+	telemetry::Frame frame;
+	uint32_t frames = 0;
+
+	if (s_ready) {
+		for (uint8_t byte : s_stream) {
+			frames += decoder.push(byte, frame);
+		}
+
+		bench::do_not_optimize(frames);
+		bench::transfer((uint32_t)s_stream.size());
+	}
+}
@@ -0,0 +1,11 @@
+// FatFs with a 16 sector cache for FAT and directory access (8 KiB) and
+// transfers of contiguous cluster runs.
+
+#define FF_WIN_CACHE 16
+#define FF_USE_CLUSTER_RUN 1
+#define FATFS_COPY cache
+
+#include "fatfs_copy.h"
+#include "ff.c"
+
+FATFS_COPY_DEFINE(cache)
@@ -0,0 +1,90 @@
+#ifndef BENCH_FATFS_COPY_H
+#define BENCH_FATFS_COPY_H
+
+// bench_host links three copies of FatFs, built with different options from
+// fatfs_win1.c, fatfs_cache.c and fatfs_dir.c, so the benches compare them in
+// one run. A copy defines FATFS_COPY to its name before including this header
+// and ff.c, which prefixes the public functions of ff.c with the name. The
+// bench uses a copy through its FatfsCopy table only. FIL, DIR and FILINFO
+// are the same in all copies, FATFS is not and stays inside the copy.
+// test_fatfs_dir links a fourth copy, fatfs_dir_small.c.
+
+#ifdef FATFS_COPY
+#define FATFS_COPY_CAT_(a, b) a##_##b
+#define FATFS_COPY_CAT(a, b) FATFS_COPY_CAT_(a, b)
+
+#define f_open FATFS_COPY_CAT(FATFS_COPY, f_open)
+#define f_close FATFS_COPY_CAT(FATFS_COPY, f_close)
+#define f_read FATFS_COPY_CAT(FATFS_COPY, f_read)
+#define f_write FATFS_COPY_CAT(FATFS_COPY, f_write)
+#define f_lseek FATFS_COPY_CAT(FATFS_COPY, f_lseek)
+#define f_truncate FATFS_COPY_CAT(FATFS_COPY, f_truncate)
+#define f_sync FATFS_COPY_CAT(FATFS_COPY, f_sync)
+#define f_opendir FATFS_COPY_CAT(FATFS_COPY, f_opendir)
+#define f_closedir FATFS_COPY_CAT(FATFS_COPY, f_closedir)
+#define f_readdir FATFS_COPY_CAT(FATFS_COPY, f_readdir)
+#define f_mkdir FATFS_COPY_CAT(FATFS_COPY, f_mkdir)
+#define f_unlink FATFS_COPY_CAT(FATFS_COPY, f_unlink)
+#define f_rename FATFS_COPY_CAT(FATFS_COPY, f_rename)
+#define f_stat FATFS_COPY_CAT(FATFS_COPY, f_stat)
+#define f_getfree FATFS_COPY_CAT(FATFS_COPY, f_getfree)
+#define f_mount FATFS_COPY_CAT(FATFS_COPY, f_mount)
+#define f_mkfs FATFS_COPY_CAT(FATFS_COPY, f_mkfs)
+#define f_readstream FATFS_COPY_CAT(FATFS_COPY, f_readstream)
+#define f_writestream FATFS_COPY_CAT(FATFS_COPY, f_writestream)
+#endif
+
+#include "ff.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+	const char *name;
+	FRESULT (*mount)(void);		// mount the RAM disk volume on the FATFS of the copy
+	FRESULT (*unmount)(void);
+	FRESULT (*mkfs)(const TCHAR *path, const MKFS_PARM *opt, void *work, UINT len);
+	FRESULT (*open)(FIL *fp, const TCHAR *path, BYTE mode);
+	FRESULT (*close)(FIL *fp);
+	FRESULT (*read)(FIL *fp, void *buff, UINT btr, UINT *br);
+	FRESULT (*write)(FIL *fp, const void *buff, UINT btw, UINT *bw);
+	FRESULT (*lseek)(FIL *fp, FSIZE_t ofs);
+	FRESULT (*stat)(const TCHAR *path, FILINFO *fno);
+	FRESULT (*mkdir)(const TCHAR *path);
+	FRESULT (*unlink)(const TCHAR *path);
+	FRESULT (*readstream)(FIL *fp, BYTE *work, UINT bsize, UINT nbuf, UINT (*func)(const BYTE *, UINT), UINT btr,
+			      UINT *br);
+	FRESULT (*writestream)(FIL *fp, BYTE *work, UINT bsize, UINT nbuf, UINT (*func)(BYTE *, UINT), UINT btw,
+			       UINT *bw);
+	FRESULT (*sync)(FIL *fp);
+	FRESULT (*truncate)(FIL *fp);
+	FRESULT (*rename)(const TCHAR *path_old, const TCHAR *path_new);
+	FRESULT (*opendir)(DIR *dp, const TCHAR *path);
+	FRESULT (*closedir)(DIR *dp);
+	FRESULT (*readdir)(DIR *dp, FILINFO *fno);
+} FatfsCopy;
+
+extern const FatfsCopy fatfs_win1;
+extern const FatfsCopy fatfs_cache;
+extern const FatfsCopy fatfs_dir;
+extern const FatfsCopy fatfs_dir_small;
+
+// Latency of the RAM disk of fatfs_diskio.cpp, per request and per sector.
+// Synchronous and submitted transfers sleep for it, with the disk locked.
+void fatfs_disk_set_latency(uint32_t request_us, uint32_t sector_ns);
+
+#ifdef __cplusplus
+}
+#endif
+
+// Table of the copy being compiled, after ff.c
+#define FATFS_COPY_DEFINE(copy) \
+	static FATFS copy_fs; \
+	static FRESULT copy_mount(void) { return f_mount(&copy_fs, "", 1); } \
+	static FRESULT copy_unmount(void) { return f_mount(NULL, "", 0); } \
+	const FatfsCopy fatfs_##copy = { #copy, copy_mount, copy_unmount, f_mkfs, f_open, f_close, \
+		f_read, f_write, f_lseek, f_stat, f_mkdir, f_unlink, f_readstream, f_writestream, f_sync, f_truncate, \
+		f_rename, f_opendir, f_closedir, f_readdir };
+
+#endif
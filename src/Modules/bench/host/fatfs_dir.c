@@ -0,0 +1,13 @@
+// FatFs of fatfs_cache.c with the directory name cache, 4096 name hints
+// (48 KiB) and two 4 KiB name filters.
+
+#define FF_WIN_CACHE 16
+#define FF_USE_CLUSTER_RUN 1
+#define FF_DIR_CACHE 4096
+#define FF_DIR_FILTER 4096
+#define FATFS_COPY dir
+
+#include "fatfs_copy.h"
+#include "ff.c"
+
+FATFS_COPY_DEFINE(dir)
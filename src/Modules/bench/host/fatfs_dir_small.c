@@ -0,0 +1,15 @@
+// FatFs of fatfs_dir.c with the smallest directory name cache, a single set
+// of 8 name hints and two 8 byte name filters, for test_fatfs_dir. Every
+// name competes for the same hints and the filters fill up after a few
+// dozen names.
+
+#define FF_WIN_CACHE 16
+#define FF_USE_CLUSTER_RUN 1
+#define FF_DIR_CACHE 8
+#define FF_DIR_FILTER 8
+#define FATFS_COPY dir_small
+
+#include "fatfs_copy.h"
+#include "ff.c"
+
+FATFS_COPY_DEFINE(dir_small)
@@ -0,0 +1,126 @@
+#include "Bench.hpp"
+
+#include "ff.h"
+#include "diskio.h"
+#include "fsl_ram_disk.h"
+#include "fatfs_copy.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+// Disk interface of both FatFs copies, on the SDK RAM disk instead of
+// diskio.c. Every disk_read(), disk_write() and disk_submit() is passed to
+// bench::count(), so cases report disk requests per operation whatever their
+// length.
+//
+// Submitted transfers run in a worker thread, like the worker task of
+// diskio.c. With a latency set the disk sleeps for it with the device
+// locked, so a card that is busy with a background transfer also delays the
+// synchronous requests, and a sleeping disk leaves the CPU to the caller.
+
+static std::mutex s_device;
+static uint32_t s_request_us = 0;
+static uint32_t s_sector_ns = 0;
+
+// Never destroyed, the worker thread outlives the static destructors
+struct DiskWorker {
+	std::mutex lock;
+	std::condition_variable queued;
+	std::condition_variable done;
+	std::deque<DREQ *> queue;
+};
+
+static DiskWorker *s_worker = nullptr;
+
+void fatfs_disk_set_latency(uint32_t request_us, uint32_t sector_ns)
+{
+	std::lock_guard<std::mutex> device(s_device);
+	s_request_us = request_us;
+	s_sector_ns = sector_ns;
+}
+
+static DRESULT transfer(BYTE pdrv, bool write, BYTE *buff, LBA_t sector, UINT count)
+{
+	std::lock_guard<std::mutex> device(s_device);
+
+	if (s_request_us != 0 || s_sector_ns != 0) {
+		std::this_thread::sleep_for(std::chrono::microseconds(s_request_us) +
+					    std::chrono::nanoseconds((uint64_t)s_sector_ns * count));
+	}
+
+	return write ? ram_disk_write(pdrv, buff, sector, count) : ram_disk_read(pdrv, buff, sector, count);
+}
+
+static void worker_main(DiskWorker *w)
+{
+	for (;;) {
+		std::unique_lock<std::mutex> lock(w->lock);
+		w->queued.wait(lock, [w] { return !w->queue.empty(); });
+		DREQ *req = w->queue.front();
+		w->queue.pop_front();
+		lock.unlock();
+
+		req->res = transfer(req->pdrv, req->write != 0, req->buff, req->sector, req->count);
+
+		if (req->complete != nullptr) {
+			req->complete(req);
+		}
+
+		lock.lock();
+		req->busy = 0;
+		w->done.notify_all();
+	}
+}
+
+DSTATUS disk_status(BYTE pdrv)
+{
+	return ram_disk_status(pdrv);
+}
+
+DSTATUS disk_initialize(BYTE pdrv)
+{
+	return ram_disk_initialize(pdrv);
+}
+
+DRESULT disk_read(BYTE pdrv, BYTE *buff, LBA_t sector, UINT count)
+{
+	bench::count();
+	return transfer(pdrv, false, buff, sector, count);
+}
+
+DRESULT disk_write(BYTE pdrv, const BYTE *buff, LBA_t sector, UINT count)
+{
+	bench::count();
+	return transfer(pdrv, true, const_cast<BYTE *>(buff), sector, count);
+}
+
+DRESULT disk_ioctl(BYTE pdrv, BYTE cmd, void *buff)
+{
+	return ram_disk_ioctl(pdrv, cmd, buff);
+}
+
+DRESULT disk_submit(DREQ *req)
+{
+	if (s_worker == nullptr) {
+		s_worker = new DiskWorker;
+		std::thread(worker_main, s_worker).detach();
+	}
+
+	bench::count();
+	std::lock_guard<std::mutex> lock(s_worker->lock);
+	req->busy = 1;
+	req->owner = s_worker;
+	s_worker->queue.push_back(req);
+	s_worker->queued.notify_one();
+	return RES_OK;
+}
+
+DRESULT disk_wait(DREQ *req)
+{
+	std::unique_lock<std::mutex> lock(s_worker->lock);
+	s_worker->done.wait(lock, [req] { return req->busy == 0; });
+	return req->res;
+}
@@ -0,0 +1,11 @@
+// FatFs as shipped, with the single sector window and transfers split at
+// every cluster boundary.
+
+#define FF_WIN_CACHE 0
+#define FF_USE_CLUSTER_RUN 0
+#define FATFS_COPY win1
+
+#include "fatfs_copy.h"
+#include "ff.c"
+
+FATFS_COPY_DEFINE(win1)
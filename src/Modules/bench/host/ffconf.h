@@ -0,0 +1,75 @@
+#ifndef _FFCONF_H_
+#define _FFCONF_H_
+
+// FatFs options for the copies of FatFs linked into bench_host, on the SDK
+// RAM disk (fsl_ram_disk.c). Based on middleware/fatfs/template/ram with a
+// single volume and long file names in a static buffer. The sector cache,
+// cluster runs and the directory name cache are set per copy, see
+// fatfs_copy.h. The asynchronous disk access is on in all copies, they
+// share the disk layer of fatfs_diskio.cpp, and adds f_readstream and
+// f_writestream only.
+
+#define FFCONF_DEF	80286
+
+#define RAM_DISK_ENABLE 1
+// test_fatfs_stream needs 64 MiB for FAT32 with 512 byte clusters
+#ifndef FSL_FF_RAMDISK_DISK_SIZE
+#define FSL_FF_RAMDISK_DISK_SIZE (32 * 1024 * 1024)
+#endif
+
+#define FF_FS_READONLY	0
+#define FF_FS_MINIMIZE	0
+#define FF_USE_FIND		0
+#define FF_USE_MKFS		1
+#define FF_USE_FASTSEEK	0
+#define FF_USE_EXPAND	0
+#define FF_USE_CHMOD	0
+#define FF_USE_LABEL	0
+#define FF_USE_FORWARD	0
+#define FF_USE_STRFUNC	0
+#define FF_PRINT_LLI	0
+#define FF_PRINT_FLOAT	0
+#define FF_STRF_ENCODE	0
+
+#define FF_CODE_PAGE	437
+#define FF_USE_LFN		1
+#define FF_MAX_LFN		255
+#define FF_LFN_UNICODE	0
+#define FF_LFN_BUF		255
+#define FF_SFN_BUF		12
+#define FF_FS_RPATH		0
+
+#define FF_VOLUMES		1
+#define FF_STR_VOLUME_ID	0
+#define FF_MULTI_PARTITION	0
+#define FF_MIN_SS		512
+#define FF_MAX_SS		512
+#define FF_LBA64		0
+#define FF_MIN_GPT		0x10000000
+#define FF_USE_TRIM		0
+
+#define FF_FS_TINY		0
+#ifndef FF_WIN_CACHE
+#define FF_WIN_CACHE	0
+#endif
+#ifndef FF_USE_CLUSTER_RUN
+#define FF_USE_CLUSTER_RUN	0
+#endif
+#define FF_DISK_ASYNC	4
+#ifndef FF_DIR_CACHE
+#define FF_DIR_CACHE	0
+#endif
+#ifndef FF_DIR_FILTER
+#define FF_DIR_FILTER	0
+#endif
+#define FF_FS_EXFAT		0
+#define FF_FS_NORTC		1
+#define FF_NORTC_MON	1
+#define FF_NORTC_MDAY	1
+#define FF_NORTC_YEAR	2022
+#define FF_FS_NOFSINFO	0
+#define FF_FS_LOCK		0
+#define FF_FS_REENTRANT	0
+#define FF_FS_TIMEOUT	1000
+
+#endif
@@ -0,0 +1,77 @@
+#ifndef BENCH_FSL_COMMON_H
+#define BENCH_FSL_COMMON_H
+
+// Host stand-in for the SDK header, with what the FatFs RAM disk
+// (fsl_ram_disk.c), the SD card streaming (fsl_sd_stream.c), the mflash
+// files (mflash_file.c), the memory manager (fsl_component_mem_manager.c)
+// and common task (fsl_component_common_task.c) use from it.
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef int32_t status_t;
+
+#define MAKE_STATUS(group, code) ((((group) * 100L) + (code)))
+#define MAKE_VERSION(major, minor, bugfix) (((major) << 16) | ((minor) << 8) | (bugfix))
+
+enum {
+	kStatusGroup_Generic = 0,
+	kStatusGroup_SDMMC = 18,
+	kStatusGroup_MEM_MANAGER = 141,
+	kStatusGroup_OSA = 143,
+	kStatusGroup_COMMON_TASK = 144,
+};
+
+enum {
+	kStatus_Success = MAKE_STATUS(kStatusGroup_Generic, 0),
+	kStatus_Fail = MAKE_STATUS(kStatusGroup_Generic, 1),
+	kStatus_ReadOnly = MAKE_STATUS(kStatusGroup_Generic, 2),
+	kStatus_OutOfRange = MAKE_STATUS(kStatusGroup_Generic, 3),
+	kStatus_InvalidArgument = MAKE_STATUS(kStatusGroup_Generic, 4),
+	kStatus_Timeout = MAKE_STATUS(kStatusGroup_Generic, 5),
+};
+
+#ifndef MIN
+#define MIN(a, b) (((a) < (b)) ? (a) : (b))
+#endif
+#ifndef MAX
+#define MAX(a, b) (((a) > (b)) ? (a) : (b))
+#endif
+
+// No interrupts on the host, critical sections only keep the code path
+static inline uint32_t DisableGlobalIRQ(void)
+{
+	return 0;
+}
+
+static inline void EnableGlobalIRQ(uint32_t primask)
+{
+	(void)primask;
+}
+
+// Cycle counter and core clock of CMSIS, set by the tests
+typedef struct {
+	volatile uint32_t CYCCNT;
+} DWT_Type;
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+extern DWT_Type bench_host_dwt;
+extern uint32_t SystemCoreClock;
+
+#if defined(__cplusplus)
+}
+#endif
+
+#define DWT (&bench_host_dwt)
+
+#define __REV(x) __builtin_bswap32(x)
+#define __REV16(x) ((uint32_t)((((x) & 0xff00ff00u) >> 8) | (((x) & 0x00ff00ffu) << 8)))
+
+#endif
@@ -0,0 +1,86 @@
+#ifndef BENCH_FSL_OS_ABSTRACTION_H
+#define BENCH_FSL_OS_ABSTRACTION_H
+
+// Host stand-in for components/osa, with what common task
+// (fsl_component_common_task.c) uses from it. Single threaded: tasks are
+// never started, the caller runs the task function itself, critical
+// sections only keep the code path and a semaphore is a counter that
+// doesn't block.
+
+#include "fsl_common.h"
+
+#define osaWaitForever_c ((uint32_t)(~0UL))
+
+typedef enum _osa_status {
+	KOSA_StatusSuccess = kStatus_Success,
+	KOSA_StatusError = MAKE_STATUS(kStatusGroup_OSA, 1),
+	KOSA_StatusTimeout = MAKE_STATUS(kStatusGroup_OSA, 2),
+} osa_status_t;
+
+typedef void *osa_task_handle_t;
+typedef void *osa_task_param_t;
+typedef void (*osa_task_ptr_t)(osa_task_param_t task_param);
+typedef void *osa_semaphore_handle_t;
+typedef uint32_t osa_semaphore_count_t;
+
+typedef struct osa_task_def_tag {
+	osa_task_ptr_t pthread;
+} osa_task_def_t;
+
+#define OSA_TASK_DEFINE(name, priority, instances, stackSz, useFloat) \
+	static const osa_task_def_t os_thread_def_##name = {(name)}
+#define OSA_TASK(name) (&os_thread_def_##name)
+#define OSA_TASK_HANDLE_DEFINE(name) uint32_t name[1]
+#define OSA_SEMAPHORE_HANDLE_DEFINE(name) uint32_t name[1]
+
+#define OSA_SR_ALLOC() uint32_t osaCurrentSr = 0U
+#define OSA_ENTER_CRITICAL() (osaCurrentSr = DisableGlobalIRQ())
+#define OSA_EXIT_CRITICAL() EnableGlobalIRQ(osaCurrentSr)
+
+static inline osa_status_t OSA_TaskCreate(osa_task_handle_t taskHandle, const osa_task_def_t *thread_def,
+		osa_task_param_t task_param)
+{
+	(void)taskHandle;
+	(void)thread_def;
+	(void)task_param;
+	return KOSA_StatusSuccess;
+}
+
+static inline osa_status_t OSA_TaskDestroy(osa_task_handle_t taskHandle)
+{
+	(void)taskHandle;
+	return KOSA_StatusSuccess;
+}
+
+static inline osa_status_t OSA_SemaphoreCreate(osa_semaphore_handle_t semaphoreHandle, uint32_t initValue)
+{
+	*(uint32_t *)semaphoreHandle = initValue;
+	return KOSA_StatusSuccess;
+}
+
+static inline osa_status_t OSA_SemaphoreDestroy(osa_semaphore_handle_t semaphoreHandle)
+{
+	(void)semaphoreHandle;
+	return KOSA_StatusSuccess;
+}
+
+// Times out at once instead of waiting for a post
+static inline osa_status_t OSA_SemaphoreWait(osa_semaphore_handle_t semaphoreHandle, uint32_t millisec)
+{
+	(void)millisec;
+
+	if (*(uint32_t *)semaphoreHandle == 0U) {
+		return KOSA_StatusTimeout;
+	}
+
+	(*(uint32_t *)semaphoreHandle)--;
+	return KOSA_StatusSuccess;
+}
+
+static inline osa_status_t OSA_SemaphorePost(osa_semaphore_handle_t semaphoreHandle)
+{
+	(*(uint32_t *)semaphoreHandle)++;
+	return KOSA_StatusSuccess;
+}
+
+#endif
@@ -0,0 +1,110 @@
+#ifndef BENCH_FSL_SDMMC_HOST_H
+#define BENCH_FSL_SDMMC_HOST_H
+
+// Host stand-in for middleware/sdmmc/host/usdhc, in place of the adapter
+// the sdmmc/template configurations pair with the card drivers. The types
+// follow fsl_usdhc.h and the adapter configuration is that of the
+// non-blocking uSDHC adapter with ADMA2 scatter gather transfers. Transfers
+// go to the simulated card (SdCardSim) the host points to.
+
+#include "fsl_common.h"
+#include "fsl_sdmmc_osa.h"
+
+#define SDMMCHOST_SUPPORT_VOLTAGE_CONTROL (0)
+#define SDMMCHOST_SUPPORT_DDR50 (0U)
+#define SDMMCHOST_SUPPORT_SDR104 (0U)
+#define SDMMCHOST_SUPPORT_SDR50 (0U)
+#define SDMMCHOST_SUPPORT_HS200 (0U)
+#define SDMMCHOST_SUPPORT_HS400 (0U)
+
+#define SDMMCHOST_ENABLE_CACHE_LINE_ALIGN_TRANSFER 1
+#define SDMMCHOST_DMA_DESCRIPTOR_WORDS (2U)
+#define SDMMCHOST_DMA_DESCRIPTOR_MAX_LENGTH (0xFFFFU - 3U)
+
+enum {
+	kCARD_CommandTypeNormal = 0U,
+	kCARD_CommandTypeSuspend = 1U,
+	kCARD_CommandTypeResume = 2U,
+	kCARD_CommandTypeAbort = 3U,
+};
+
+enum {
+	kCARD_ResponseTypeNone = 0U,
+	kCARD_ResponseTypeR1 = 1U,
+	kCARD_ResponseTypeR1b = 2U,
+};
+
+typedef enum _usdhc_transfer_direction {
+	kUSDHC_TransferDirectionReceive = 1U,
+	kUSDHC_TransferDirectionSend = 0U,
+} usdhc_transfer_direction_t;
+
+typedef struct _sdmmchost_cmd {
+	uint32_t index;
+	uint32_t argument;
+	uint32_t type;
+	uint32_t responseType;
+	uint32_t response[4U];
+	uint32_t responseErrorFlags;
+	uint32_t flags;
+} sdmmchost_cmd_t;
+
+typedef struct _sdmmchost_data {
+	bool enableAutoCommand12;
+	bool enableAutoCommand23;
+	bool enableIgnoreError;
+	uint8_t dataType;
+	size_t blockSize;
+	uint32_t blockCount;
+	uint32_t *rxData;
+	const uint32_t *txData;
+} sdmmchost_data_t;
+
+typedef struct _sdmmchost_transfer {
+	sdmmchost_data_t *data;
+	sdmmchost_cmd_t *command;
+} sdmmchost_transfer_t;
+
+typedef struct _sdmmchost_scatter_gather_data_list {
+	uint32_t *dataAddr;
+	uint32_t dataSize;
+	struct _sdmmchost_scatter_gather_data_list *dataList;
+} sdmmchost_scatter_gather_data_list_t;
+
+typedef struct _sdmmchost_scatter_gather_data {
+	bool enableAutoCommand12;
+	bool enableAutoCommand23;
+	bool enableIgnoreError;
+	usdhc_transfer_direction_t dataDirection;
+	uint8_t dataType;
+	size_t blockSize;
+	sdmmchost_scatter_gather_data_list_t sgData;
+} sdmmchost_scatter_gather_data_t;
+
+typedef struct _sdmmchost_scatter_gather_transfer {
+	sdmmchost_scatter_gather_data_t *data;
+	sdmmchost_cmd_t *command;
+} sdmmchost_scatter_gather_transfer_t;
+
+typedef struct _sdmmchost_ {
+	void *dmaDesBuffer;            // unused, the size limits the chains
+	uint32_t dmaDesBufferWordsNum;
+	uint32_t capability;
+	uint32_t maxBlockCount;
+	uint32_t maxBlockSize;
+	void *card;                    // SdCardSim
+} sdmmchost_t;
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+bool SDMMCHOST_IsCardBusy(sdmmchost_t *host);
+status_t SDMMCHOST_TransferFunction(sdmmchost_t *host, sdmmchost_transfer_t *content);
+status_t SDMMCHOST_ScatterGatherTransferFunction(sdmmchost_t *host, sdmmchost_scatter_gather_transfer_t *content);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif
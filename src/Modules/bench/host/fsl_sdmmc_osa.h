@@ -0,0 +1,38 @@
+#ifndef BENCH_FSL_SDMMC_OSA_H
+#define BENCH_FSL_SDMMC_OSA_H
+
+// Host stand-in for middleware/sdmmc/osa, single threaded: the mutexes do
+// nothing and delays busy-wait (SdCardSim.cpp).
+
+#include "fsl_common.h"
+
+#define osaWaitForever_c ((uint32_t)(-1))
+
+typedef struct _sdmmc_osa_mutex {
+	uint32_t locked;
+} sdmmc_osa_mutex_t;
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+static inline status_t SDMMC_OSAMutexLock(void *mutexHandle, uint32_t millisec)
+{
+	(void)mutexHandle;
+	(void)millisec;
+	return kStatus_Success;
+}
+
+static inline status_t SDMMC_OSAMutexUnlock(void *mutexHandle)
+{
+	(void)mutexHandle;
+	return kStatus_Success;
+}
+
+uint32_t SDMMC_OSADelayUs(uint32_t microseconds);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif
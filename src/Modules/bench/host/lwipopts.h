@@ -0,0 +1,15 @@
+#ifndef BENCH_LWIPOPTS_H
+#define BENCH_LWIPOPTS_H
+
+// lwIP options for the parts of lwIP linked into bench_host (checksum only).
+// Checksum settings match middleware/lwip/template/lwipopts.h.
+
+#define NO_SYS                  1
+#define LWIP_NETCONN            0
+#define LWIP_SOCKET             0
+#define SYS_LIGHTWEIGHT_PROT    0
+
+#define LWIP_CHKSUM_ALGORITHM   4
+#define LWIP_CHECKSUM_ON_COPY   1
+
+#endif
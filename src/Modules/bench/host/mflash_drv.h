@@ -0,0 +1,12 @@
+#ifndef BENCH_MFLASH_DRV_H
+#define BENCH_MFLASH_DRV_H
+
+// Host stand-in for the mflash driver header, with the geometry of the
+// RT1064 QSPI flash. The driver functions are implemented by MflashNorSim.
+
+#include "mflash_common.h"
+
+#define MFLASH_SECTOR_SIZE (0x1000U)
+#define MFLASH_PAGE_SIZE (256U)
+
+#endif
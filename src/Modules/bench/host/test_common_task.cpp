@@ -0,0 +1,323 @@
+extern "C" {
+#include "fsl_os_abstraction.h"
+#include "fsl_component_common_task.h"
+
+void COMMON_TASK_task(osa_task_param_t param);
+}
+
+#include <stdio.h>
+#include <string.h>
+
+// Host test of the multi-priority message queue of common task
+// (COMMON_TASK_PRIORITY_QUEUE) with 4 priorities of 8 messages. The task
+// never runs by itself, dispatch() runs one pass of it, and the cycle
+// counter is set by the test. Checks that the most urgent priority is
+// executed first and each priority in post order, that a post of a pending
+// callback and parameter is coalesced while anything else isn't, that a
+// full priority drops posts without affecting the others, the statistics
+// and the latency in microseconds across a wrap of the counter. Returns
+// non-zero on the first mismatch.
+
+static constexpr uint32_t PRIORITIES = COMMON_TASK_MSG_PRIORITY_COUNT;
+static constexpr uint32_t DEPTH = COMMON_TASK_MAX_MSGQ_COUNT;
+static constexpr uint32_t CORE_CLOCK = 600000000;
+static constexpr uint32_t CYCLES_PER_USEC = CORE_CLOCK / 1000000;
+
+extern "C" {
+extern const uint8_t gUseRtos_c = 0;
+DWT_Type bench_host_dwt;
+uint32_t SystemCoreClock = CORE_CLOCK;
+}
+
+static char s_log[64];
+static uint32_t s_logged = 0;
+
+static void record(void *param)
+{
+	if (s_logged < sizeof(s_log) - 1) {
+		s_log[s_logged++] = *(const char *)param;
+		s_log[s_logged] = '\0';
+	}
+}
+
+static void other(void *param)
+{
+	record(param);
+}
+
+static char s_names[] = "ABCDEFGHIJKLMNOP";
+static common_task_message_t s_msgs[sizeof(s_names) - 1];
+
+static common_task_message_t *msg(char name)
+{
+	common_task_message_t *m = &s_msgs[name - 'A'];
+	m->callback = record;
+	m->callbackParam = &s_names[name - 'A'];
+	return m;
+}
+
+static void dispatch()
+{
+	COMMON_TASK_task(COMMON_TASK_get_instance());
+}
+
+// Runs the task until nothing is pending, the log holds the messages executed
+static void drain()
+{
+	s_logged = 0;
+	s_log[0] = '\0';
+
+	for (uint32_t i = 0; i < PRIORITIES * DEPTH + 1; i++) {
+		dispatch();
+	}
+}
+
+static bool expect_log(const char *what, const char *expect)
+{
+	if (strcmp(s_log, expect) != 0) {
+		printf("common_task: %s executed \"%s\" instead of \"%s\"\n", what, s_log, expect);
+		return false;
+	}
+
+	if (COMMON_TASK_get_pending_message_count() != 0) {
+		printf("common_task: %s left %d messages pending\n", what, COMMON_TASK_get_pending_message_count());
+		return false;
+	}
+
+	return true;
+}
+
+static bool post(char name, uint8_t priority, common_task_status_t expect)
+{
+	const common_task_status_t status = COMMON_TASK_post_message_with_priority(msg(name), priority);
+
+	if (status != expect) {
+		printf("common_task: post of %c at priority %u returned %d instead of %d\n", name, (unsigned)priority,
+		       (int)status, (int)expect);
+		return false;
+	}
+
+	return true;
+}
+
+static bool expect_statistics(uint8_t priority, uint32_t posted, uint32_t coalesced, uint32_t dropped,
+			      uint32_t executed)
+{
+	common_task_msg_statistics_t s;
+
+	if (COMMON_TASK_get_statistics(priority, &s, true) != kStatus_COMMON_TASK_Success ||
+	    s.posted != posted || s.coalesced != coalesced || s.dropped != dropped || s.executed != executed) {
+		printf("common_task: priority %u posted %u, coalesced %u, dropped %u, executed %u instead of %u, %u, %u, %u\n",
+		       (unsigned)priority, (unsigned)s.posted, (unsigned)s.coalesced, (unsigned)s.dropped,
+		       (unsigned)s.executed, (unsigned)posted, (unsigned)coalesced, (unsigned)dropped, (unsigned)executed);
+		return false;
+	}
+
+	return true;
+}
+
+static void reset_statistics()
+{
+	common_task_msg_statistics_t s;
+
+	for (uint8_t priority = 0; priority < PRIORITIES; priority++) {
+		COMMON_TASK_get_statistics(priority, &s, true);
+	}
+}
+
+static bool check_order()
+{
+	// Nothing pending, the task returns without executing anything
+	drain();
+
+	if (!expect_log("an empty queue", "")) {
+		return false;
+	}
+
+	if (!post('A', 3, kStatus_COMMON_TASK_Success) || !post('B', 1, kStatus_COMMON_TASK_Success) ||
+	    !post('C', 0, kStatus_COMMON_TASK_Success) || !post('D', 3, kStatus_COMMON_TASK_Success) ||
+	    !post('E', 2, kStatus_COMMON_TASK_Success) || !post('F', 1, kStatus_COMMON_TASK_Success)) {
+		return false;
+	}
+
+	if (COMMON_TASK_get_pending_message_count() != 6) {
+		printf("common_task: %d messages pending instead of 6\n", COMMON_TASK_get_pending_message_count());
+		return false;
+	}
+
+	drain();
+
+	if (!expect_log("priority order", "CBFEAD")) {
+		return false;
+	}
+
+	// A more urgent post overtakes the ones already pending
+	post('A', 3, kStatus_COMMON_TASK_Success);
+	post('B', 2, kStatus_COMMON_TASK_Success);
+	s_logged = 0;
+	dispatch();
+	post('C', 0, kStatus_COMMON_TASK_Success);
+	dispatch();
+	dispatch();
+
+	if (strcmp(s_log, "BCA") != 0) {
+		printf("common_task: urgent post executed \"%s\" instead of \"BCA\"\n", s_log);
+		return false;
+	}
+
+	// COMMON_TASK_post_message() posts at the default priority, an invalid priority is refused
+	post('D', 0, kStatus_COMMON_TASK_Success);
+
+	if (COMMON_TASK_post_message(msg('E')) != kStatus_COMMON_TASK_Success ||
+	    COMMON_TASK_post_message_with_priority(msg('F'), PRIORITIES) != kStatus_COMMON_TASK_Error) {
+		printf("common_task: default or invalid priority post failed\n");
+		return false;
+	}
+
+	drain();
+
+	if (!expect_log("default priority", "DE") || !expect_statistics(PRIORITIES - 1, 4, 0, 0, 4) ||
+	    !expect_statistics(0, 3, 0, 0, 3)) {
+		return false;
+	}
+
+	reset_statistics();
+	return true;
+}
+
+static bool check_coalesce()
+{
+	common_task_message_t copy = *msg('A');
+	common_task_message_t same_callback = {record, &s_names[1]};
+	common_task_message_t same_param = {other, &s_names[0]};
+
+	// The same callback and parameter from a different message is coalesced
+	if (!post('A', 1, kStatus_COMMON_TASK_Success) ||
+	    COMMON_TASK_post_message_with_priority(&copy, 1) != kStatus_COMMON_TASK_Success ||
+	    !post('A', 1, kStatus_COMMON_TASK_Success) ||
+	    COMMON_TASK_post_message_with_priority(&same_callback, 1) != kStatus_COMMON_TASK_Success ||
+	    COMMON_TASK_post_message_with_priority(&same_param, 1) != kStatus_COMMON_TASK_Success ||
+	    !post('A', 2, kStatus_COMMON_TASK_Success)) {
+		return false;
+	}
+
+	if (COMMON_TASK_get_pending_message_count() != 4) {
+		printf("common_task: %d messages pending after coalescing instead of 4\n",
+		       COMMON_TASK_get_pending_message_count());
+		return false;
+	}
+
+	drain();
+
+	if (!expect_log("coalesced posts", "ABAA") || !expect_statistics(1, 3, 2, 0, 3) ||
+	    !expect_statistics(2, 1, 0, 0, 1)) {
+		return false;
+	}
+
+	// Once executed the message is posted again
+	post('A', 1, kStatus_COMMON_TASK_Success);
+	drain();
+	post('A', 1, kStatus_COMMON_TASK_Success);
+	drain();
+
+	if (!expect_log("a post after execution", "A") || !expect_statistics(1, 2, 0, 0, 2)) {
+		return false;
+	}
+
+	return true;
+}
+
+static bool check_full()
+{
+	char expect[DEPTH + 2] = {};
+
+	for (uint32_t i = 0; i < DEPTH; i++) {
+		expect[i] = (char)('A' + i);
+
+		if (!post(expect[i], 2, kStatus_COMMON_TASK_Success)) {
+			return false;
+		}
+	}
+
+	// A new message is dropped, a pending one still coalesces and the other priorities are unaffected
+	if (!post((char)('A' + DEPTH), 2, kStatus_COMMON_TASK_Busy) ||
+	    !post((char)('A' + DEPTH + 1), 2, kStatus_COMMON_TASK_Busy) || !post('C', 2, kStatus_COMMON_TASK_Success) ||
+	    !post('P', 0, kStatus_COMMON_TASK_Success)) {
+		return false;
+	}
+
+	if (COMMON_TASK_get_pending_message_count() != (int)DEPTH + 1) {
+		printf("common_task: %d messages pending in a full queue instead of %u\n",
+		       COMMON_TASK_get_pending_message_count(), (unsigned)DEPTH + 1);
+		return false;
+	}
+
+	drain();
+	memmove(&expect[1], expect, DEPTH);
+	expect[0] = 'P';
+
+	if (!expect_log("a full queue", expect) || !expect_statistics(2, DEPTH, 1, 2, DEPTH) ||
+	    !expect_statistics(0, 1, 0, 0, 1)) {
+		return false;
+	}
+
+	// Drained, the queue accepts a full load again
+	for (uint32_t i = 0; i < DEPTH; i++) {
+		if (!post((char)('A' + i), 2, kStatus_COMMON_TASK_Success)) {
+			return false;
+		}
+	}
+
+	drain();
+	return expect_statistics(2, DEPTH, 0, 0, DEPTH);
+}
+
+static bool check_latency()
+{
+	common_task_msg_statistics_t s;
+
+	// 250 us and 40 us, the second one posted just before the counter wraps
+	DWT->CYCCNT = 1000;
+	post('A', 3, kStatus_COMMON_TASK_Success);
+	DWT->CYCCNT += 250 * CYCLES_PER_USEC;
+	dispatch();
+
+	DWT->CYCCNT = UINT32_MAX - 10 * CYCLES_PER_USEC;
+	post('B', 3, kStatus_COMMON_TASK_Success);
+	DWT->CYCCNT += 40 * CYCLES_PER_USEC;
+	dispatch();
+
+	if (COMMON_TASK_get_statistics(3, &s, false) != kStatus_COMMON_TASK_Success || s.executed != 2 ||
+	    s.latencyMax != 250 || s.latencyTotal != 290) {
+		printf("common_task: latency max %u us, total %u us instead of 250 us, 290 us\n", (unsigned)s.latencyMax,
+		       (unsigned)s.latencyTotal);
+		return false;
+	}
+
+	// Reading with reset returns the statistics once
+	if (!expect_statistics(3, 2, 0, 0, 2) || !expect_statistics(3, 0, 0, 0, 0)) {
+		return false;
+	}
+
+	return COMMON_TASK_get_statistics(PRIORITIES, &s, false) == kStatus_COMMON_TASK_Error;
+}
+
+int main()
+{
+	if (COMMON_TASK_init() != kStatus_COMMON_TASK_Success) {
+		printf("common_task: init failed\n");
+		return 1;
+	}
+
+	if (!check_order() || !check_coalesce() || !check_full() || !check_latency()) {
+		return 1;
+	}
+
+	if (COMMON_TASK_deinit() != kStatus_COMMON_TASK_Success) {
+		printf("common_task: deinit failed\n");
+		return 1;
+	}
+
+	printf("common_task: ok\n");
+	return 0;
+}
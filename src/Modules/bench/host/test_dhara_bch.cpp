@@ -0,0 +1,145 @@
+extern "C" {
+#include "bch.h"
+}
+
+#include <stdio.h>
+#include <string.h>
+
+// Host test of the dhara BCH codes with the remainder tables, syndromes from
+// the remainder and the Chien search, against the bit-serial code of
+// BCH_NO_TABLES (bch_ref.c). Random chunks of 1 to BCH_MAX_CHUNK_SIZE bytes
+// get up to two errors more than the code corrects, in the chunk or the ECC
+// bytes, for all four codes. Both must give the same ECC bytes, verify
+// result and repaired chunk, and the repair must restore the chunk when
+// there are no more errors than the code corrects. Returns non-zero on the
+// first mismatch.
+
+extern "C" {
+extern const struct bch_def bch_ref_1bit;
+extern const struct bch_def bch_ref_2bit;
+extern const struct bch_def bch_ref_3bit;
+extern const struct bch_def bch_ref_4bit;
+void bch_ref_generate(const struct bch_def *bch, const uint8_t *chunk, size_t len, uint8_t *ecc);
+int bch_ref_verify(const struct bch_def *bch, const uint8_t *chunk, size_t len, const uint8_t *ecc);
+void bch_ref_repair(const struct bch_def *bch, uint8_t *chunk, size_t len, uint8_t *ecc);
+}
+
+static constexpr int TRIALS = 2000;
+
+struct Code {
+	const bch_def *fast;
+	const bch_def *ref;
+	int bits;
+};
+
+static const Code s_codes[] = {
+	{&bch_1bit, &bch_ref_1bit, 1},
+	{&bch_2bit, &bch_ref_2bit, 2},
+	{&bch_3bit, &bch_ref_3bit, 3},
+	{&bch_4bit, &bch_ref_4bit, 4},
+};
+
+static uint32_t s_seed = 1;
+
+static uint32_t next_rand()
+{
+	s_seed = s_seed * 1103515245 + 12345;
+	return s_seed >> 8;
+}
+
+// Flips n distinct bits of the chunk and ECC data
+static void flip_bits(uint8_t *chunk, size_t len, uint8_t *ecc, int degree, int n)
+{
+	const uint32_t total = (uint32_t)len * 8 + degree;
+	uint32_t done[8];
+
+	for (int i = 0; i < n; i++) {
+		uint32_t bit;
+		bool dup;
+
+		do {
+			bit = next_rand() % total;
+			dup = false;
+
+			for (int j = 0; j < i; j++) {
+				dup |= done[j] == bit;
+			}
+		} while (dup);
+
+		done[i] = bit;
+
+		if (bit < len * 8) {
+			chunk[bit >> 3] ^= 1 << (bit & 7);
+		} else {
+			bit -= len * 8;
+			ecc[bit >> 3] ^= 1 << (bit & 7);
+		}
+	}
+}
+
+static bool check_trial(const Code &code)
+{
+	static uint8_t data[BCH_MAX_CHUNK_SIZE];
+	static uint8_t a[BCH_MAX_CHUNK_SIZE];
+	static uint8_t b[BCH_MAX_CHUNK_SIZE];
+	uint8_t ecc[BCH_MAX_ECC];
+	uint8_t ecc_a[BCH_MAX_ECC];
+	uint8_t ecc_b[BCH_MAX_ECC];
+	const size_t len = 1 + next_rand() % BCH_MAX_CHUNK_SIZE;
+	const int errors = next_rand() % (code.bits + 3);
+	const int ecc_bytes = code.fast->ecc_bytes;
+
+	for (size_t i = 0; i < len; i++) {
+		data[i] = (uint8_t)next_rand();
+	}
+
+	bch_generate(code.fast, data, len, ecc);
+	bch_ref_generate(code.ref, data, len, ecc_a);
+
+	if (memcmp(ecc, ecc_a, ecc_bytes) != 0) {
+		printf("dhara_bch: %d-bit ECC of %zu B differs\n", code.bits, len);
+		return false;
+	}
+
+	memcpy(a, data, len);
+	memcpy(ecc_a, ecc, ecc_bytes);
+	flip_bits(a, len, ecc_a, code.fast->degree, errors);
+	memcpy(b, a, len);
+	memcpy(ecc_b, ecc_a, ecc_bytes);
+
+	if (bch_verify(code.fast, a, len, ecc_a) != bch_ref_verify(code.ref, b, len, ecc_b)) {
+		printf("dhara_bch: %d-bit verify of %zu B with %d errors differs\n", code.bits, len, errors);
+		return false;
+	}
+
+	bch_repair(code.fast, a, len, ecc_a);
+	bch_ref_repair(code.ref, b, len, ecc_b);
+
+	if (memcmp(a, b, len) != 0 || memcmp(ecc_a, ecc_b, ecc_bytes) != 0) {
+		printf("dhara_bch: %d-bit repair of %zu B with %d errors differs\n", code.bits, len, errors);
+		return false;
+	}
+
+	if (errors <= code.bits &&
+	    (memcmp(a, data, len) != 0 || memcmp(ecc_a, ecc, ecc_bytes) != 0 || bch_verify(code.fast, a, len, ecc_a) != 0)) {
+		printf("dhara_bch: %d-bit repair of %zu B with %d errors failed\n", code.bits, len, errors);
+		return false;
+	}
+
+	return true;
+}
+
+int main()
+{
+	for (const Code &code : s_codes) {
+		for (int i = 0; i < TRIALS; i++) {
+			if (!check_trial(code)) {
+				printf("dhara_bch: trial %d failed\n", i);
+				return 1;
+			}
+		}
+	}
+
+	printf("dhara_bch: ok\n");
+	return 0;
+}
@@ -0,0 +1,183 @@
+#include "DharaNandSim.hpp"
+
+extern "C" {
+#include "map.h"
+}
+
+#include <stdio.h>
+#include <string.h>
+
+// Host test of the dhara map on a small simulated NAND chip (DharaNandSim):
+// 1 KiB pages, 32 pages per block and 256 blocks, 2 of them bad from the
+// factory, with one in 1000 programs and erases failing. A random sequence
+// of writes, multi-sector writes, trims, reads, syncs, idle garbage
+// collection and resumes after a sync runs on 1024 sectors, without and
+// with the sector cache. Every read and the number of mapped sectors are
+// compared against a model of the sector versions, and the chip must not
+// have been misused. Returns non-zero on the first mismatch.
+
+static constexpr uint8_t LOG2_PAGE_SIZE = 10;
+static constexpr uint8_t LOG2_PPB = 5;
+static constexpr unsigned int NUM_BLOCKS = 256;
+static constexpr unsigned int FACTORY_BAD = 2;
+static constexpr uint32_t FAIL_RATE = 1000;
+static constexpr uint8_t GC_RATIO = 4;
+static constexpr dhara_sector_t SECTORS = 1024;
+static constexpr unsigned int CACHE_ENTRIES = 64;
+static constexpr unsigned int RANDOM_OPS = 30000;
+
+static constexpr size_t PAGE_SIZE = (size_t)1 << LOG2_PAGE_SIZE;
+
+static uint16_t s_version[SECTORS];
+static uint32_t s_seed = 1;
+
+static uint32_t next_random()
+{
+	s_seed = s_seed * 1103515245 + 12345;
+	return s_seed >> 8;
+}
+
+static void fill_page(uint8_t *page, size_t size, dhara_sector_t sector, uint16_t version)
+{
+	for (size_t i = 0; i < size; i += 4) {
+		const uint32_t word = (sector << 16) ^ version ^ (uint32_t)(i * 2654435761u);
+		memcpy(&page[i], &word, 4);
+	}
+}
+
+static bool verify_sector(dhara_map *map, dhara_sector_t sector)
+{
+	uint8_t page[PAGE_SIZE];
+	uint8_t expect[PAGE_SIZE];
+	dhara_error_t err;
+
+	if (s_version[sector] == 0) {
+		memset(expect, 0xff, sizeof(expect));
+
+	} else {
+		fill_page(expect, sizeof(expect), sector, s_version[sector]);
+	}
+
+	if (dhara_map_read(map, sector, page, &err) < 0) {
+		printf("dhara_map: reading sector %u failed: %s\n", (unsigned)sector, dhara_strerror(err));
+		return false;
+	}
+
+	if (memcmp(page, expect, sizeof(page)) != 0) {
+		printf("dhara_map: sector %u doesn't hold version %u\n", (unsigned)sector, s_version[sector]);
+		return false;
+	}
+
+	return true;
+}
+
+static bool check_map(bool cache, uint32_t seed)
+{
+	static DharaNandSim nand;
+	static dhara_map map;
+	static uint8_t page_buf[PAGE_SIZE];
+	static uint8_t data[8 * PAGE_SIZE];
+	static dhara_map_cache entries[CACHE_ENTRIES];
+	dhara_sector_t count = 0;
+	dhara_error_t err;
+
+	if (!nand.init(LOG2_PAGE_SIZE, LOG2_PPB, NUM_BLOCKS, FACTORY_BAD, FAIL_RATE, seed)) {
+		printf("dhara_map: out of memory\n");
+		return false;
+	}
+
+	memset(s_version, 0, sizeof(s_version));
+	s_seed = seed;
+	dhara_map_init(&map, nand.nand(), page_buf, GC_RATIO);
+	dhara_map_resume(&map, nullptr);
+	dhara_map_set_cache(&map, cache ? entries : nullptr, CACHE_ENTRIES);
+
+	for (unsigned int op = 0; op < RANDOM_OPS; op++) {
+		const uint32_t kind = next_random() % 100;
+		const dhara_sector_t sector = next_random() % SECTORS;
+		int ret = 0;
+
+		if (kind < 40) {
+			fill_page(data, PAGE_SIZE, sector, ++s_version[sector]);
+			count += s_version[sector] == 1;
+			ret = dhara_map_write(&map, sector, data, &err);
+
+		} else if (kind < 55) {
+			const dhara_sector_t n = 1 + next_random() % 8;
+			const dhara_sector_t first = sector + n <= SECTORS ? sector : SECTORS - n;
+
+			for (dhara_sector_t i = 0; i < n; i++) {
+				fill_page(&data[i * PAGE_SIZE], PAGE_SIZE, first + i, ++s_version[first + i]);
+				count += s_version[first + i] == 1;
+			}
+
+			ret = dhara_map_write_multi(&map, first, data, n, &err);
+
+		} else if (kind < 65) {
+			count -= s_version[sector] != 0;
+			s_version[sector] = 0;
+			ret = dhara_map_trim(&map, sector, &err);
+
+		} else if (kind < 92) {
+			if (!verify_sector(&map, sector)) {
+				return false;
+			}
+
+		} else if (kind < 95) {
+			ret = dhara_map_sync(&map, &err);
+
+		} else if (kind < 99) {
+			ret = dhara_map_idle(&map, 32, 16, &err);
+
+		} else {
+			// Power cycle after a sync
+			ret = dhara_map_sync(&map, &err);
+
+			if (ret == 0) {
+				dhara_map_init(&map, nand.nand(), page_buf, GC_RATIO);
+				ret = dhara_map_resume(&map, &err);
+				dhara_map_set_cache(&map, cache ? entries : nullptr, CACHE_ENTRIES);
+			}
+
+			for (dhara_sector_t s = 0; s < SECTORS && ret == 0; s++) {
+				if (!verify_sector(&map, s)) {
+					return false;
+				}
+			}
+		}
+
+		if (ret < 0) {
+			printf("dhara_map: operation %u failed: %s\n", op, dhara_strerror(err));
+			return false;
+		}
+
+		if (dhara_map_size(&map) != count) {
+			printf("dhara_map: %u sectors mapped instead of %u\n", (unsigned)dhara_map_size(&map),
+			       (unsigned)count);
+			return false;
+		}
+	}
+
+	if (nand.stats().violations != 0) {
+		printf("dhara_map: %u NAND misuses\n", (unsigned)nand.stats().violations);
+		return false;
+	}
+
+	return true;
+}
+
+int main()
+{
+	if (!check_map(false, 1)) {
+		printf("dhara_map: without the cache failed\n");
+		return 1;
+	}
+
+	if (!check_map(true, 2)) {
+		printf("dhara_map: with the cache failed\n");
+		return 1;
+	}
+
+	printf("dhara_map: ok\n");
+	return 0;
+}
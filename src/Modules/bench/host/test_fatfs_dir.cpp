@@ -0,0 +1,562 @@
+#include "fatfs_copy.h"
+#include "diskio.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+
+// Host test of the directory name cache (FF_DIR_CACHE, FF_DIR_FILTER)
+// against a model of the names in the root and up to four subdirectories.
+// A random sequence of creates, stats, unlinks, renames within and across
+// directories (also to another case of the same name), mkdirs, renames and
+// removals of directories, remounts and directory listings runs on short
+// names, long names of up to five entries and long names whose short names
+// collide. Lookups use random cases of the names, and listings must return
+// the names with the case they were created with. The same sequence runs on
+// FatFs without the cache (fatfs_win1), with the cache of the benches
+// (fatfs_dir) and with the smallest one (fatfs_dir_small), where the hints
+// are evicted all the time and the filters let most names through, on FAT16
+// and FAT32 (the root directory in a cluster chain) volumes. Returns
+// non-zero on the first mismatch.
+
+static constexpr UINT NAME_COUNT = 48;
+static constexpr UINT DIR_NAME_COUNT = 8;
+static constexpr UINT SLOT_COUNT = 5;	// the root and four subdirectories
+static constexpr UINT NAME_MAX = 64;
+static constexpr UINT SECTOR = 512;
+static constexpr uint32_t RANDOM_STEPS = 3000;
+
+struct FatType {
+	const char *name;
+	BYTE fmt;
+	UINT au;
+};
+
+static const FatType s_types[] = {
+	{"FAT16", FM_FAT | FM_SFD, 2048},
+	{"FAT32", FM_FAT32 | FM_SFD, 512},
+};
+
+struct Slot {
+	bool exists;
+	UINT name;				// in s_dir_names
+	char stored[NAME_MAX];	// as created or renamed
+	bool present[NAME_COUNT];
+	char file[NAME_COUNT][NAME_MAX];
+};
+
+static const FatfsCopy *s_copy = nullptr;
+static const char *s_type = "";
+static char s_names[NAME_COUNT][NAME_MAX];
+static char s_dir_names[DIR_NAME_COUNT][NAME_MAX];
+static Slot s_slots[SLOT_COUNT];
+static BYTE s_mkfs_work[FF_MAX_SS];
+static uint32_t s_seed = 1;
+
+static uint32_t next_random()
+{
+	s_seed = s_seed * 1103515245 + 12345;
+	return s_seed >> 8;
+}
+
+// Short names in lower and upper case, 8.3 names in mixed case, long names
+// of two entries, long names with colliding short names and long names of
+// five entries
+static void make_names()
+{
+	for (UINT n = 0; n < NAME_COUNT; n++) {
+		switch (n % 6) {
+		case 0:
+			snprintf(s_names[n], NAME_MAX, "f%02u.txt", n);
+			break;
+		case 1:
+			snprintf(s_names[n], NAME_MAX, "LOG%02u.BIN", n);
+			break;
+		case 2:
+			snprintf(s_names[n], NAME_MAX, "Mixed%02u.Txt", n);
+			break;
+		case 3:
+			snprintf(s_names[n], NAME_MAX, "sensor_reading_%03u.csv", n);
+			break;
+		case 4:
+			snprintf(s_names[n], NAME_MAX, "Measurement %u.log", n);
+			break;
+		default:
+			snprintf(s_names[n], NAME_MAX, "a rather long file name for the entry number %02u.data", n);
+			break;
+		}
+	}
+
+	for (UINT n = 0; n < DIR_NAME_COUNT; n++) {
+		snprintf(s_dir_names[n], NAME_MAX, n % 2 ? "Archive of day %u" : "SUB%u", n);
+	}
+}
+
+// The name in random case now and then
+static void random_case(const char *name, char *text)
+{
+	const bool vary = next_random() % 2;
+	UINT i = 0;
+
+	for (; name[i]; i++) {
+		text[i] = !vary ? name[i] : next_random() % 2 ? (char)toupper(name[i]) : (char)tolower(name[i]);
+	}
+
+	text[i] = 0;
+}
+
+// A subdirectory that does not exist stands for a missing path
+static void make_path(UINT slot, const char *text, char *path)
+{
+	if (slot == 0) {
+		snprintf(path, 2 * NAME_MAX, "%s", text);
+	} else {
+		snprintf(path, 2 * NAME_MAX, "%s/%s", s_slots[slot].exists ? s_slots[slot].stored : "missing dir", text);
+	}
+}
+
+static bool expect(FRESULT res, FRESULT want, const char *what, const char *path)
+{
+	if (res != want) {
+		printf("fatfs_dir: %s %s: %s of \"%s\" returned %d instead of %d\n", s_copy->name, s_type, what, path,
+		       (int)res, (int)want);
+		return false;
+	}
+
+	return true;
+}
+
+static UINT random_slot()
+{
+	return next_random() % SLOT_COUNT;
+}
+
+static bool dir_name_used(UINT name)
+{
+	for (UINT k = 1; k < SLOT_COUNT; k++) {
+		if (s_slots[k].exists && s_slots[k].name == name) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static bool stat_file(UINT slot, UINT n)
+{
+	char text[NAME_MAX], path[2 * NAME_MAX];
+	FILINFO fno;
+
+	random_case(s_names[n], text);
+	make_path(slot, text, path);
+	const FRESULT res = s_copy->stat(path, &fno);
+	const Slot &s = s_slots[slot];
+
+	if (!s.exists) {
+		return expect(res, FR_NO_PATH, "stat", path);
+	}
+
+	if (!s.present[n]) {
+		return expect(res, FR_NO_FILE, "stat", path);
+	}
+
+	if (!expect(res, FR_OK, "stat", path)) {
+		return false;
+	}
+
+	// a long name comes back in the case of the path, like in stock FatFs
+	if (strcasecmp(fno.fname, s.file[n]) != 0 || (fno.fattrib & AM_DIR)) {
+		printf("fatfs_dir: %s %s: stat of \"%s\" found \"%s\" instead of \"%s\"\n", s_copy->name, s_type, path,
+		       fno.fname, s.file[n]);
+		return false;
+	}
+
+	return true;
+}
+
+static bool stat_dir(UINT slot)
+{
+	char text[NAME_MAX];
+	FILINFO fno;
+	const Slot &s = s_slots[slot];
+
+	random_case(s_dir_names[s.name], text);
+	const FRESULT res = s_copy->stat(text, &fno);
+
+	if (!s.exists) {
+		return dir_name_used(s.name) || expect(res, FR_NO_FILE, "stat", text);
+	}
+
+	if (!expect(res, FR_OK, "stat", text)) {
+		return false;
+	}
+
+	if (strcasecmp(fno.fname, s.stored) != 0 || !(fno.fattrib & AM_DIR)) {
+		printf("fatfs_dir: %s %s: stat of \"%s\" found \"%s\" instead of the directory \"%s\"\n", s_copy->name,
+		       s_type, text, fno.fname, s.stored);
+		return false;
+	}
+
+	return true;
+}
+
+static bool check_all(const char *what)
+{
+	for (UINT slot = 0; slot < SLOT_COUNT; slot++) {
+		if (slot != 0 && !stat_dir(slot)) {
+			printf("fatfs_dir: %s %s: after %s\n", s_copy->name, s_type, what);
+			return false;
+		}
+
+		for (UINT n = 0; s_slots[slot].exists && n < NAME_COUNT; n++) {
+			if (!stat_file(slot, n)) {
+				printf("fatfs_dir: %s %s: after %s\n", s_copy->name, s_type, what);
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+static bool create_file(UINT slot, UINT n)
+{
+	char text[NAME_MAX], path[2 * NAME_MAX];
+	FIL fp;
+	Slot &s = s_slots[slot];
+
+	random_case(s_names[n], text);
+	make_path(slot, text, path);
+	const FRESULT res = s_copy->open(&fp, path, FA_WRITE | FA_CREATE_NEW);
+
+	if (!s.exists) {
+		return expect(res, FR_NO_PATH, "create", path);
+	}
+
+	if (s.present[n]) {
+		return expect(res, FR_EXIST, "create", path);
+	}
+
+	if (!expect(res, FR_OK, "create", path) || !expect(s_copy->close(&fp), FR_OK, "close", path)) {
+		return false;
+	}
+
+	s.present[n] = true;
+	strcpy(s.file[n], text);
+	return true;
+}
+
+static bool unlink_file(UINT slot, UINT n)
+{
+	char text[NAME_MAX], path[2 * NAME_MAX];
+	Slot &s = s_slots[slot];
+
+	random_case(s_names[n], text);
+	make_path(slot, text, path);
+	const FRESULT res = s_copy->unlink(path);
+
+	if (!s.exists) {
+		return expect(res, FR_NO_PATH, "unlink", path);
+	}
+
+	if (!expect(res, s.present[n] ? FR_OK : FR_NO_FILE, "unlink", path)) {
+		return false;
+	}
+
+	s.present[n] = false;
+	return true;
+}
+
+// Within a directory or across, to another case of the same name too
+static bool rename_file(UINT from, UINT n, UINT to, UINT m)
+{
+	char text[NAME_MAX], path[2 * NAME_MAX], new_text[NAME_MAX], new_path[2 * NAME_MAX];
+	Slot &s = s_slots[from];
+	Slot &d = s_slots[to];
+
+	random_case(s_names[n], text);
+	make_path(from, text, path);
+	random_case(s_names[m], new_text);
+	make_path(to, new_text, new_path);
+	const FRESULT res = s_copy->rename(path, new_path);
+
+	if (!s.exists) {
+		return expect(res, FR_NO_PATH, "rename", path);
+	}
+
+	if (!s.present[n]) {
+		return expect(res, FR_NO_FILE, "rename", path);
+	}
+
+	if (!d.exists) {
+		return expect(res, FR_NO_PATH, "rename to", new_path);
+	}
+
+	if (d.present[m] && (from != to || n != m)) {
+		return expect(res, FR_EXIST, "rename to", new_path);
+	}
+
+	if (!expect(res, FR_OK, "rename", path)) {
+		return false;
+	}
+
+	s.present[n] = false;
+	d.present[m] = true;
+	strcpy(d.file[m], new_text);
+	return true;
+}
+
+static bool make_dir(UINT slot)
+{
+	char text[NAME_MAX];
+	Slot &s = s_slots[slot];
+
+	if (s.exists) {
+		random_case(s_dir_names[s.name], text);
+		return expect(s_copy->mkdir(text), FR_EXIST, "mkdir", text);
+	}
+
+	UINT name = next_random() % DIR_NAME_COUNT;
+
+	while (dir_name_used(name)) {
+		name = (name + 1) % DIR_NAME_COUNT;
+	}
+
+	random_case(s_dir_names[name], text);
+
+	if (!expect(s_copy->mkdir(text), FR_OK, "mkdir", text)) {
+		return false;
+	}
+
+	memset(&s, 0, sizeof(s));
+	s.exists = true;
+	s.name = name;
+	strcpy(s.stored, text);
+	return true;
+}
+
+// Empties the directory first now and then, it is only removed when empty
+static bool remove_dir(UINT slot)
+{
+	Slot &s = s_slots[slot];
+	bool empty = true;
+
+	if (!s.exists) {
+		return true;
+	}
+
+	for (UINT n = 0; n < NAME_COUNT; n++) {
+		if (s.present[n] && next_random() % 2 && !unlink_file(slot, n)) {
+			return false;
+		}
+
+		empty = empty && !s.present[n];
+	}
+
+	if (!expect(s_copy->unlink(s.stored), empty ? FR_OK : FR_DENIED, "unlink", s.stored)) {
+		return false;
+	}
+
+	s.exists = !empty;
+	return true;
+}
+
+static bool rename_dir(UINT slot)
+{
+	char text[NAME_MAX];
+	Slot &s = s_slots[slot];
+	UINT name = next_random() % DIR_NAME_COUNT;
+
+	if (!s.exists) {
+		return true;
+	}
+
+	while (name != s.name && dir_name_used(name)) {
+		name = (name + 1) % DIR_NAME_COUNT;
+	}
+
+	random_case(s_dir_names[name], text);
+
+	if (!expect(s_copy->rename(s.stored, text), FR_OK, "rename", s.stored)) {
+		return false;
+	}
+
+	s.name = name;
+	strcpy(s.stored, text);
+	return true;
+}
+
+// Every name of the directory exactly once, with its case
+static bool list_dir(UINT slot)
+{
+	const Slot &s = s_slots[slot];
+	bool seen[NAME_COUNT] = {};
+	bool seen_dir[SLOT_COUNT] = {};
+	FILINFO fno;
+	DIR dir;
+
+	if (!s.exists) {
+		return true;
+	}
+
+	const char *path = slot == 0 ? "" : s.stored;
+
+	if (!expect(s_copy->opendir(&dir, path), FR_OK, "opendir", path)) {
+		return false;
+	}
+
+	while (s_copy->readdir(&dir, &fno) == FR_OK && fno.fname[0] != 0) {
+		bool found = false;
+
+		if (fno.fname[0] == '.') {
+			continue;
+		}
+
+		for (UINT n = 0; !found && n < NAME_COUNT; n++) {
+			found = s.present[n] && !seen[n] && strcmp(fno.fname, s.file[n]) == 0;
+			seen[n] = seen[n] || found;
+		}
+
+		for (UINT k = 1; !found && slot == 0 && k < SLOT_COUNT; k++) {
+			found = s_slots[k].exists && !seen_dir[k] && strcmp(fno.fname, s_slots[k].stored) == 0;
+			seen_dir[k] = seen_dir[k] || found;
+		}
+
+		if (!found) {
+			printf("fatfs_dir: %s %s: \"%s\" listed \"%s\", not in the model or twice\n", s_copy->name, s_type,
+			       path, fno.fname);
+			return false;
+		}
+	}
+
+	for (UINT n = 0; n < NAME_COUNT; n++) {
+		if (s.present[n] && !seen[n]) {
+			printf("fatfs_dir: %s %s: \"%s\" did not list \"%s\"\n", s_copy->name, s_type, path, s.file[n]);
+			return false;
+		}
+	}
+
+	for (UINT k = 1; slot == 0 && k < SLOT_COUNT; k++) {
+		if (s_slots[k].exists && !seen_dir[k]) {
+			printf("fatfs_dir: %s %s: the root did not list \"%s\"\n", s_copy->name, s_type, s_slots[k].stored);
+			return false;
+		}
+	}
+
+	return s_copy->closedir(&dir) == FR_OK;
+}
+
+static bool remount()
+{
+	if (s_copy->unmount() != FR_OK || s_copy->mount() != FR_OK) {
+		printf("fatfs_dir: %s %s: remount failed\n", s_copy->name, s_type);
+		return false;
+	}
+
+	return check_all("a remount");
+}
+
+static bool step()
+{
+	const UINT slot = random_slot();
+	const UINT n = next_random() % NAME_COUNT;
+	const UINT sub = 1 + next_random() % (SLOT_COUNT - 1);
+
+	switch (next_random() % 16) {
+	case 0:
+	case 1:
+	case 2:
+	case 3:
+		return create_file(slot, n);
+
+	case 4:
+	case 5:
+	case 6:
+		return stat_file(slot, n) && stat_file(slot, next_random() % NAME_COUNT);
+
+	case 7:
+		return stat_dir(sub);
+
+	case 8:
+	case 9:
+		return unlink_file(slot, n);
+
+	case 10:
+	case 11: {
+			// mostly to an existing directory, a third of them to the same one
+			const UINT to = next_random() % 3 == 0 ? slot : random_slot();
+			const UINT m = next_random() % 4 == 0 ? n : next_random() % NAME_COUNT;
+			return rename_file(slot, n, to, m);
+		}
+
+	case 12:
+		return make_dir(sub);
+
+	case 13:
+		return next_random() % 2 ? remove_dir(sub) : rename_dir(sub);
+
+	case 14:
+		return list_dir(slot);
+
+	default:
+		return next_random() % 8 == 0 ? remount() : check_all("the steps");
+	}
+}
+
+static UINT load16(const BYTE *p)
+{
+	return p[0] | p[1] << 8;
+}
+
+static bool check_type(const FatType &type)
+{
+	const MKFS_PARM opt = {type.fmt, 2, 0, 0, type.au};
+	BYTE boot[SECTOR];
+
+	s_type = type.name;
+	s_seed = 1;
+	memset(s_slots, 0, sizeof(s_slots));
+	s_slots[0].exists = true;
+
+	// BPB_FATSz16 is zero on FAT32 only
+	if (s_copy->mkfs("", &opt, s_mkfs_work, sizeof(s_mkfs_work)) != FR_OK || disk_read(0, boot, 0, 1) != RES_OK ||
+	    (load16(&boot[22]) == 0) != (type.fmt == (FM_FAT32 | FM_SFD))) {
+		printf("fatfs_dir: %s %s: mkfs failed\n", s_copy->name, s_type);
+		return false;
+	}
+
+	if (s_copy->mount() != FR_OK) {
+		printf("fatfs_dir: %s %s: mount failed\n", s_copy->name, s_type);
+		return false;
+	}
+
+	for (uint32_t i = 0; i < RANDOM_STEPS; i++) {
+		if (!step()) {
+			printf("fatfs_dir: %s %s: step %lu failed\n", s_copy->name, s_type, (unsigned long)i);
+			return false;
+		}
+	}
+
+	return remount() && s_copy->unmount() == FR_OK;
+}
+
+int main()
+{
+	static const FatfsCopy *const copies[] = {&fatfs_win1, &fatfs_dir, &fatfs_dir_small};
+
+	make_names();
+
+	for (const FatfsCopy *copy : copies) {
+		s_copy = copy;
+
+		for (const FatType &type : s_types) {
+			if (!check_type(type)) {
+				return 1;
+			}
+		}
+	}
+
+	printf("fatfs_dir: ok\n");
+	return 0;
+}
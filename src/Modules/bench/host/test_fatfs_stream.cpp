@@ -0,0 +1,508 @@
+#include "fatfs_copy.h"
+#include "diskio.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// Host test of f_readstream() and f_writestream() (FF_DISK_ASYNC) on FAT12,
+// FAT16 and FAT32 volumes of the 64 MiB RAM disk, against a model of the
+// file contents. The submitted transfers run in the worker thread of
+// fatfs_diskio.cpp. A random sequence of stream writes and reads at sector
+// aligned positions, with 2 to FF_DISK_ASYNC buffers of 1 to 8 sectors,
+// sources that end early and sinks that stop early, followed by plain
+// reads or writes from where the stream left the file pointer, plain
+// overwrites and appends, truncates, unlinks and remounts runs on six files
+// that grow in turns, so their cluster chains are fragmented. Every read is
+// compared against the model. The same sequence runs on the single sector
+// window copy (fatfs_win1) and the copy with cluster runs (fatfs_cache).
+// Returns non-zero on the first mismatch.
+
+static constexpr UINT FILE_COUNT = 6;
+static constexpr UINT FILE_MAX = 512 * 1024;
+static constexpr UINT STREAM_MAX = 96 * 1024;
+static constexpr UINT IO_MAX = 9000;
+static constexpr UINT SECTOR = 512;
+static constexpr UINT BUF_SECTORS = 8;
+static constexpr uint32_t RANDOM_STEPS = 4000;
+
+struct FatType {
+	const char *name;
+	BYTE fmt;
+	UINT au;
+};
+
+// FAT12 takes 32 KiB clusters to stay below 4085 of them on 64 MiB
+static const FatType s_types[] = {
+	{"FAT12", FM_FAT | FM_SFD, 32768},
+	{"FAT16", FM_FAT | FM_SFD, 4096},
+	{"FAT32", FM_FAT32 | FM_SFD, 512},
+};
+
+static const FatfsCopy *s_copy = nullptr;
+static const char *s_type = "";
+static uint8_t s_model[FILE_COUNT][FILE_MAX];
+static UINT s_size[FILE_COUNT];
+static bool s_exists[FILE_COUNT];
+static BYTE s_work[FF_DISK_ASYNC * BUF_SECTORS * SECTOR];
+static uint8_t s_buf[IO_MAX];
+static BYTE s_mkfs_work[FF_MAX_SS];
+static uint32_t s_seed = 1;
+
+// Data of the stream in progress, a model position and a limit where the
+// source ends or the sink stops
+static uint8_t *s_stream_data = nullptr;
+static UINT s_stream_pos = 0;
+static UINT s_stream_limit = 0;
+static bool s_stream_bad = false;
+
+static uint32_t next_random()
+{
+	s_seed = s_seed * 1103515245 + 12345;
+	return s_seed >> 8;
+}
+
+static void file_name(UINT n, char *name)
+{
+	snprintf(name, 16, "f%u.bin", n);
+}
+
+static UINT source(BYTE *data, UINT len)
+{
+	if (len > s_stream_limit - s_stream_pos) {
+		len = s_stream_limit - s_stream_pos;
+	}
+
+	for (UINT i = 0; i < len; i++) {
+		s_stream_data[s_stream_pos + i] = (uint8_t)next_random();
+	}
+
+	memcpy(data, &s_stream_data[s_stream_pos], len);
+	s_stream_pos += len;
+	return len;
+}
+
+static UINT sink(const BYTE *data, UINT len)
+{
+	if (len > s_stream_limit - s_stream_pos) {
+		len = s_stream_limit - s_stream_pos;
+	}
+
+	if (!s_stream_bad && memcmp(data, &s_stream_data[s_stream_pos], len) != 0) {
+		printf("fatfs_stream: %s %s: streamed data at %u differs\n", s_copy->name, s_type, s_stream_pos);
+		s_stream_bad = true;
+	}
+
+	s_stream_pos += len;
+	return len;
+}
+
+static bool check(FRESULT res, const char *what, UINT n)
+{
+	if (res != FR_OK) {
+		printf("fatfs_stream: %s %s: %s of f%u failed with %d\n", s_copy->name, s_type, what, n, (int)res);
+		return false;
+	}
+
+	return true;
+}
+
+static bool open_file(FIL *fp, UINT n)
+{
+	char name[16];
+	file_name(n, name);
+
+	if (!check(s_copy->open(fp, name, FA_READ | FA_WRITE | FA_OPEN_ALWAYS), "open", n)) {
+		return false;
+	}
+
+	s_exists[n] = true;
+	return true;
+}
+
+static bool close_file(FIL *fp, UINT n)
+{
+	return check(s_copy->close(fp), "close", n);
+}
+
+static bool seek(FIL *fp, UINT n, UINT pos)
+{
+	return check(s_copy->lseek(fp, pos), "seek", n);
+}
+
+// Reads len bytes at the file pointer, fewer at the end of the file
+static bool read_plain(FIL *fp, UINT n, UINT len, const char *what)
+{
+	const UINT pos = (UINT)f_tell(fp);
+	const UINT expect = pos < s_size[n] ? (len < s_size[n] - pos ? len : s_size[n] - pos) : 0;
+	UINT br = 0;
+
+	if (!check(s_copy->read(fp, s_buf, len, &br), "read", n)) {
+		return false;
+	}
+
+	if (br != expect || memcmp(s_buf, &s_model[n][pos], expect) != 0) {
+		printf("fatfs_stream: %s %s: read of %u at %u of f%u returned %u bytes or other data, expected %u after %s\n",
+		       s_copy->name, s_type, len, pos, n, br, expect, what);
+		return false;
+	}
+
+	return true;
+}
+
+// Writes len random bytes at the file pointer, which is not past the end
+static bool write_plain(FIL *fp, UINT n, UINT len)
+{
+	const UINT pos = (UINT)f_tell(fp);
+	UINT bw = 0;
+
+	for (UINT i = 0; i < len; i++) {
+		s_model[n][pos + i] = (uint8_t)next_random();
+	}
+
+	if (!check(s_copy->write(fp, &s_model[n][pos], len, &bw), "write", n)) {
+		return false;
+	}
+
+	if (bw != len) {
+		printf("fatfs_stream: %s %s: write of %u at %u of f%u wrote %u\n", s_copy->name, s_type, len, pos, n, bw);
+		return false;
+	}
+
+	if (pos + len > s_size[n]) {
+		s_size[n] = pos + len;
+	}
+
+	return true;
+}
+
+static UINT random_bsize()
+{
+	return (1 + next_random() % BUF_SECTORS) * SECTOR;
+}
+
+static UINT random_nbuf()
+{
+	return 2 + next_random() % (FF_DISK_ASYNC - 1);
+}
+
+// Streams len bytes in at the file pointer, on a sector boundary, the
+// source ends early at a random point now and then
+static bool write_stream(FIL *fp, UINT n, UINT len)
+{
+	const UINT pos = (UINT)f_tell(fp);
+	const UINT bsize = random_bsize();
+	const UINT nbuf = random_nbuf();
+	const UINT expect = next_random() % 4 == 0 ? next_random() % (len + 1) : len;
+	UINT bw = 0;
+
+	s_stream_data = s_model[n];
+	s_stream_pos = pos;
+	s_stream_limit = pos + expect;
+
+	if (!check(s_copy->writestream(fp, s_work, bsize, nbuf, source, len, &bw), "writestream", n)) {
+		return false;
+	}
+
+	if (bw != expect || (UINT)f_tell(fp) != pos + expect) {
+		printf("fatfs_stream: %s %s: writestream of %u at %u of f%u (%u x %u) wrote %u, expected %u\n",
+		       s_copy->name, s_type, len, pos, n, nbuf, bsize, bw, expect);
+		return false;
+	}
+
+	if (pos + expect > s_size[n]) {
+		s_size[n] = pos + expect;
+	}
+
+	return true;
+}
+
+// Streams len bytes out from the file pointer, on a sector boundary, the
+// sink stops at a random point now and then
+static bool read_stream(FIL *fp, UINT n, UINT len, const char *what)
+{
+	const UINT pos = (UINT)f_tell(fp);
+	const UINT bsize = random_bsize();
+	const UINT nbuf = random_nbuf();
+	const UINT avail = pos < s_size[n] ? (len < s_size[n] - pos ? len : s_size[n] - pos) : 0;
+	const UINT expect = next_random() % 4 == 0 ? next_random() % (avail + 1) : avail;
+	UINT br = 0;
+
+	s_stream_data = s_model[n];
+	s_stream_pos = pos;
+	s_stream_limit = pos + expect;
+	s_stream_bad = false;
+
+	if (!check(s_copy->readstream(fp, s_work, bsize, nbuf, sink, len, &br), "readstream", n)) {
+		return false;
+	}
+
+	if (s_stream_bad || br != expect || (UINT)f_tell(fp) != pos + expect) {
+		printf("fatfs_stream: %s %s: readstream of %u at %u of f%u (%u x %u) read %u, expected %u after %s\n",
+		       s_copy->name, s_type, len, pos, n, nbuf, bsize, br, expect, what);
+		return false;
+	}
+
+	return true;
+}
+
+// The whole file through a stream, and its size on the directory
+static bool check_file(UINT n, const char *what)
+{
+	char name[16];
+	FILINFO fno;
+	FIL fp;
+
+	file_name(n, name);
+	const FRESULT res = s_copy->stat(name, &fno);
+
+	if (!s_exists[n]) {
+		if (res != FR_NO_FILE) {
+			printf("fatfs_stream: %s %s: stat of the removed f%u returned %d after %s\n", s_copy->name, s_type,
+			       n, (int)res, what);
+			return false;
+		}
+
+		return true;
+	}
+
+	if (!check(res, "stat", n)) {
+		return false;
+	}
+
+	if (fno.fsize != s_size[n]) {
+		printf("fatfs_stream: %s %s: f%u has %lu bytes instead of %u after %s\n", s_copy->name, s_type, n,
+		       (unsigned long)fno.fsize, s_size[n], what);
+		return false;
+	}
+
+	s_stream_data = s_model[n];
+	s_stream_pos = 0;
+	s_stream_limit = s_size[n];
+	s_stream_bad = false;
+	UINT br = 0;
+
+	if (!open_file(&fp, n) ||
+	    !check(s_copy->readstream(&fp, s_work, BUF_SECTORS * SECTOR, FF_DISK_ASYNC, sink, FILE_MAX, &br),
+		   "readstream", n)) {
+		return false;
+	}
+
+	if (s_stream_bad || br != s_size[n]) {
+		printf("fatfs_stream: %s %s: f%u read back %u of %u bytes after %s\n", s_copy->name, s_type, n, br,
+		       s_size[n], what);
+		return false;
+	}
+
+	return close_file(&fp, n);
+}
+
+static bool remount()
+{
+	if (s_copy->unmount() != FR_OK || s_copy->mount() != FR_OK) {
+		printf("fatfs_stream: %s %s: remount failed\n", s_copy->name, s_type);
+		return false;
+	}
+
+	for (UINT n = 0; n < FILE_COUNT; n++) {
+		if (!check_file(n, "a remount")) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// A random sector aligned position up to the end of the file
+static UINT aligned_pos(UINT n)
+{
+	return next_random() % (s_size[n] / SECTOR + 1) * SECTOR;
+}
+
+static UINT random_len(UINT pos, UINT max)
+{
+	const UINT room = FILE_MAX - pos;
+	return next_random() % ((max < room ? max : room) + 1);
+}
+
+// A plain read or write from where a stream left the file pointer, which
+// may be in the middle of a sector after an early end
+static bool after_stream(FIL *fp, UINT n)
+{
+	if (next_random() % 2) {
+		return read_plain(fp, n, 1 + next_random() % IO_MAX, "a stream");
+	}
+
+	if ((UINT)f_tell(fp) > s_size[n]) {
+		return true;
+	}
+
+	return write_plain(fp, n, random_len((UINT)f_tell(fp), IO_MAX));
+}
+
+static bool step()
+{
+	const UINT n = next_random() % FILE_COUNT;
+	FIL fp;
+
+	switch (next_random() % 12) {
+	case 0:
+	case 1:
+	case 2: {
+			// a plain read first leaves a sector the stream overwrites in the
+			// sector cache, it is read again right after the stream
+			const UINT pos = aligned_pos(n);
+			const UINT reread = next_random() % 2 ? 1 + next_random() % IO_MAX : 0;
+			bool ok = open_file(&fp, n);
+
+			if (ok && reread != 0) {
+				ok = seek(&fp, n, pos) && read_plain(&fp, n, reread, "the steps");
+			}
+
+			// whole sectors or not, a partial last sector goes through the cache
+			UINT len = random_len(pos, STREAM_MAX);
+			len = next_random() % 2 ? len / SECTOR * SECTOR : len;
+			ok = ok && seek(&fp, n, pos) && write_stream(&fp, n, len);
+
+			if (ok && reread != 0) {
+				ok = seek(&fp, n, pos) && read_plain(&fp, n, reread, "a stream");
+			} else if (ok) {
+				ok = after_stream(&fp, n);
+			}
+
+			for (UINT i = 0; ok && i < 4; i++) {
+				ok = seek(&fp, n, next_random() % (s_size[n] + 1)) &&
+				     read_plain(&fp, n, 1 + next_random() % IO_MAX, "a stream");
+			}
+
+			return ok && close_file(&fp, n);
+		}
+
+	case 3:
+	case 4:
+		return open_file(&fp, n) && seek(&fp, n, aligned_pos(n)) &&
+		       read_stream(&fp, n, 1 + next_random() % STREAM_MAX, "the steps") && after_stream(&fp, n) &&
+		       close_file(&fp, n);
+
+	case 5: {
+			// overwrite anywhere, or append
+			const UINT pos = next_random() % 2 ? next_random() % (s_size[n] + 1) : s_size[n];
+			return open_file(&fp, n) && seek(&fp, n, pos) && write_plain(&fp, n, random_len(pos, IO_MAX)) &&
+			       close_file(&fp, n);
+		}
+
+	case 6: {
+			bool ok = open_file(&fp, n);
+
+			for (UINT i = 0; ok && i < 4; i++) {
+				ok = seek(&fp, n, next_random() % (s_size[n] + 1)) &&
+				     read_plain(&fp, n, 1 + next_random() % IO_MAX, "the steps");
+			}
+
+			return ok && close_file(&fp, n);
+		}
+
+	case 7: {
+			// down anywhere, or to a sector or cluster boundary
+			UINT size = next_random() % (s_size[n] + 1);
+			size = next_random() % 2 ? size / SECTOR * SECTOR : size;
+
+			if (!open_file(&fp, n) || !seek(&fp, n, size) || !check(s_copy->truncate(&fp), "truncate", n) ||
+			    !close_file(&fp, n)) {
+				return false;
+			}
+
+			s_size[n] = size;
+			return check_file(n, "a truncate");
+		}
+
+	case 8: {
+			char name[16];
+			file_name(n, name);
+
+			if (s_exists[n] && !check(s_copy->unlink(name), "unlink", n)) {
+				return false;
+			}
+
+			s_exists[n] = false;
+			s_size[n] = 0;
+			return check_file(n, "an unlink");
+		}
+
+	case 9:
+		return remount();
+
+	default:
+		return check_file(n, "the steps");
+	}
+}
+
+static UINT load16(const BYTE *p)
+{
+	return p[0] | p[1] << 8;
+}
+
+static UINT load32(const BYTE *p)
+{
+	return load16(p) | load16(p + 2) << 16;
+}
+
+// The FAT type of the volume, by its number of clusters like FatFs does,
+// the file system type string is "FAT" for both FAT12 and FAT16
+static const char *volume_type(const BYTE *boot)
+{
+	const UINT fat_size = load16(&boot[22]) != 0 ? load16(&boot[22]) : load32(&boot[36]);
+	const UINT sectors = load16(&boot[19]) != 0 ? load16(&boot[19]) : load32(&boot[32]);
+	const UINT data = load16(&boot[14]) + boot[16] * fat_size + load16(&boot[17]) * 32 / SECTOR;
+	const UINT clusters = (sectors - data) / boot[13];
+
+	return load16(&boot[22]) == 0 ? "FAT32" : clusters <= 0xFF5 ? "FAT12" : "FAT16";
+}
+
+static bool check_type(const FatType &type)
+{
+	const MKFS_PARM opt = {type.fmt, 2, 0, 0, type.au};
+	BYTE boot[SECTOR];
+
+	s_type = type.name;
+	s_seed = 1;
+	memset(s_size, 0, sizeof(s_size));
+	memset(s_exists, 0, sizeof(s_exists));
+
+	if (s_copy->mkfs("", &opt, s_mkfs_work, sizeof(s_mkfs_work)) != FR_OK ||
+	    disk_read(0, boot, 0, 1) != RES_OK || strcmp(volume_type(boot), type.name) != 0) {
+		printf("fatfs_stream: %s %s: mkfs failed\n", s_copy->name, s_type);
+		return false;
+	}
+
+	if (s_copy->mount() != FR_OK) {
+		printf("fatfs_stream: %s %s: mount failed\n", s_copy->name, s_type);
+		return false;
+	}
+
+	for (uint32_t i = 0; i < RANDOM_STEPS; i++) {
+		if (!step()) {
+			printf("fatfs_stream: %s %s: step %lu failed\n", s_copy->name, s_type, (unsigned long)i);
+			return false;
+		}
+	}
+
+	return remount() && s_copy->unmount() == FR_OK;
+}
+
+int main()
+{
+	static const FatfsCopy *const copies[] = {&fatfs_win1, &fatfs_cache};
+
+	for (const FatfsCopy *copy : copies) {
+		s_copy = copy;
+
+		for (const FatType &type : s_types) {
+			if (!check_type(type)) {
+				return 1;
+			}
+		}
+	}
+
+	printf("fatfs_stream: ok\n");
+	return 0;
+}
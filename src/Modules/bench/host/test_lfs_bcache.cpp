@@ -0,0 +1,430 @@
+#include "LfsRamDisk.hpp"
+
+#include "lfs.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// Host test of the LFS_BCACHE block cache and readahead buffer of littlefs
+// on a 64 block RAM disk (LfsRamDisk), small enough that blocks are erased
+// and reused all the time. Files are read back sequentially in random
+// chunks, which is served from the readahead buffer, and at random offsets,
+// which is served from the cache lines, and compared against the data
+// written: after writing, overwriting in place and appending, after the
+// blocks just read were erased and reused by another file, after a seek
+// from the end of a block into the next one, and after a remount. A random sequence of these runs without the cache, with cache
+// lines only and with cache lines and readahead. Returns non-zero on the
+// first mismatch.
+
+static constexpr lfs_size_t BLOCK_COUNT = 64;
+static constexpr uint32_t FILES = 4;
+static constexpr lfs_size_t FILE_MAX = 24 * 1024;
+static constexpr lfs_size_t CHUNK_MAX = 700;
+static constexpr uint32_t RANDOM_READS = 8;
+static constexpr uint32_t RANDOM_STEPS = 2000;
+static constexpr lfs_size_t LINES = 16;
+static constexpr lfs_size_t READAHEAD = 1024;
+
+struct ModelFile {
+	uint8_t data[FILE_MAX];
+	lfs_size_t size;
+	bool exists;
+};
+
+static LfsRamDisk s_disk;
+static lfs_config s_cfg;
+static lfs_t s_lfs;
+static ModelFile s_model[FILES];
+static uint8_t s_buf[FILE_MAX];
+static uint32_t s_seed = 1;
+static const char *s_mode = "";
+
+static uint32_t next_random()
+{
+	s_seed = s_seed * 1103515245 + 12345;
+	return s_seed >> 8;
+}
+
+static const char *path(uint32_t n)
+{
+	static char name[8];
+	snprintf(name, sizeof(name), "f%lu", (unsigned long)n);
+	return name;
+}
+
+static bool start(lfs_size_t lines, lfs_size_t readahead, const char *mode)
+{
+	s_mode = mode;
+	memset(s_model, 0, sizeof(s_model));
+
+	if (!s_disk.init(BLOCK_COUNT, s_cfg)) {
+		printf("lfs_bcache: out of memory\n");
+		return false;
+	}
+
+	s_cfg.bcache_lines = lines;
+	s_cfg.bcache_ways = 4;
+	s_cfg.bcache_readahead = readahead;
+
+	if (lfs_format(&s_lfs, &s_cfg) != LFS_ERR_OK || lfs_mount(&s_lfs, &s_cfg) != LFS_ERR_OK) {
+		printf("lfs_bcache: %s: format failed\n", s_mode);
+		return false;
+	}
+
+	return true;
+}
+
+static bool remount()
+{
+	if (lfs_unmount(&s_lfs) != LFS_ERR_OK || lfs_mount(&s_lfs, &s_cfg) != LFS_ERR_OK) {
+		printf("lfs_bcache: %s: remount failed\n", s_mode);
+		return false;
+	}
+
+	return true;
+}
+
+static bool compare(uint32_t n, lfs_off_t off, lfs_size_t size, const char *what)
+{
+	for (lfs_size_t i = 0; i < size; i++) {
+		if (s_buf[i] != s_model[n].data[off + i]) {
+			printf("lfs_bcache: %s: %s differs at %lu after %s\n", s_mode, path(n), (unsigned long)(off + i), what);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// Reads the whole file sequentially in random chunks, then at random offsets
+static bool verify(uint32_t n, const char *what)
+{
+	const ModelFile &model = s_model[n];
+	lfs_file_t file;
+	const int err = lfs_file_open(&s_lfs, &file, path(n), LFS_O_RDONLY);
+
+	if (!model.exists) {
+		if (err != LFS_ERR_NOENT) {
+			printf("lfs_bcache: %s: %s opened with %d after %s, removed\n", s_mode, path(n), err, what);
+
+			if (err == LFS_ERR_OK) {
+				lfs_file_close(&s_lfs, &file);
+			}
+
+			return false;
+		}
+
+		return true;
+	}
+
+	if (err != LFS_ERR_OK) {
+		printf("lfs_bcache: %s: %s open failed with %d after %s\n", s_mode, path(n), err, what);
+		return false;
+	}
+
+	bool ok = lfs_file_size(&s_lfs, &file) == (lfs_soff_t)model.size;
+
+	if (!ok) {
+		printf("lfs_bcache: %s: %s is %ld bytes instead of %lu after %s\n", s_mode, path(n),
+		       (long)lfs_file_size(&s_lfs, &file), (unsigned long)model.size, what);
+	}
+
+	for (lfs_off_t off = 0; ok && off < model.size;) {
+		const lfs_size_t size = lfs_min(1 + next_random() % CHUNK_MAX, model.size - off);
+		ok = lfs_file_read(&s_lfs, &file, s_buf, size) == (lfs_ssize_t)size && compare(n, off, size, what);
+		off += size;
+	}
+
+	for (uint32_t i = 0; ok && model.size > 0 && i < RANDOM_READS; i++) {
+		const lfs_off_t off = next_random() % model.size;
+		const lfs_size_t size = lfs_min(1 + next_random() % CHUNK_MAX, model.size - off);
+		ok = lfs_file_seek(&s_lfs, &file, off, LFS_SEEK_SET) == (lfs_soff_t)off &&
+		     lfs_file_read(&s_lfs, &file, s_buf, size) == (lfs_ssize_t)size && compare(n, off, size, what);
+	}
+
+	return lfs_file_close(&s_lfs, &file) == LFS_ERR_OK && ok;
+}
+
+static bool verify_all(const char *what)
+{
+	for (uint32_t n = 0; n < FILES; n++) {
+		if (!verify(n, what)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// Writes size random bytes at off in random chunks and reads them back
+// before closing the file, unless readback is false. off is at most the
+// size of the file.
+static bool write_file(uint32_t n, lfs_off_t off, lfs_size_t size, int flags, const char *what, bool readback = true)
+{
+	ModelFile &model = s_model[n];
+	lfs_file_t file;
+
+	if (lfs_file_open(&s_lfs, &file, path(n), LFS_O_RDWR | LFS_O_CREAT | flags) != LFS_ERR_OK) {
+		printf("lfs_bcache: %s: %s open for %s failed\n", s_mode, path(n), what);
+		return false;
+	}
+
+	if (flags & LFS_O_TRUNC) {
+		model.size = 0;
+	}
+
+	for (lfs_size_t i = 0; i < size; i++) {
+		model.data[off + i] = (uint8_t)next_random();
+	}
+
+	model.size = lfs_max(model.size, off + size);
+	model.exists = true;
+	bool ok = lfs_file_seek(&s_lfs, &file, off, LFS_SEEK_SET) == (lfs_soff_t)off;
+
+	for (lfs_size_t done = 0; ok && done < size;) {
+		const lfs_size_t chunk = lfs_min(1 + next_random() % CHUNK_MAX, size - done);
+		ok = lfs_file_write(&s_lfs, &file, &model.data[off + done], chunk) == (lfs_ssize_t)chunk;
+		done += chunk;
+	}
+
+	if (!ok) {
+		printf("lfs_bcache: %s: %s %s failed\n", s_mode, path(n), what);
+	}
+
+	ok = ok && (!readback || (lfs_file_seek(&s_lfs, &file, off, LFS_SEEK_SET) == (lfs_soff_t)off &&
+	     lfs_file_read(&s_lfs, &file, s_buf, size) == (lfs_ssize_t)size && compare(n, off, size, what)));
+
+	if (lfs_file_close(&s_lfs, &file) != LFS_ERR_OK) {
+		printf("lfs_bcache: %s: %s close after %s failed\n", s_mode, path(n), what);
+		return false;
+	}
+
+	return ok;
+}
+
+// Reads the first bytes from the start in cache_size chunks, then size
+// bytes at off, from the same open file
+static bool read_then_seek(uint32_t n, lfs_size_t first, lfs_off_t off, lfs_size_t size, const char *what)
+{
+	lfs_file_t file;
+
+	if (lfs_file_open(&s_lfs, &file, path(n), LFS_O_RDONLY) != LFS_ERR_OK) {
+		printf("lfs_bcache: %s: %s open failed after %s\n", s_mode, path(n), what);
+		return false;
+	}
+
+	bool ok = true;
+
+	for (lfs_off_t pos = 0; ok && pos < first; pos += LfsRamDisk::CACHE_SIZE) {
+		ok = lfs_file_read(&s_lfs, &file, s_buf, LfsRamDisk::CACHE_SIZE) == (lfs_ssize_t)LfsRamDisk::CACHE_SIZE &&
+		     compare(n, pos, LfsRamDisk::CACHE_SIZE, what);
+	}
+
+	ok = ok && lfs_file_seek(&s_lfs, &file, off, LFS_SEEK_SET) == (lfs_soff_t)off &&
+	     lfs_file_read(&s_lfs, &file, s_buf, size) == (lfs_ssize_t)size && compare(n, off, size, what);
+	return lfs_file_close(&s_lfs, &file) == LFS_ERR_OK && ok;
+}
+
+static bool remove_file(uint32_t n)
+{
+	s_model[n].exists = false;
+	s_model[n].size = 0;
+
+	if (lfs_remove(&s_lfs, path(n)) != LFS_ERR_OK) {
+		printf("lfs_bcache: %s: %s remove failed\n", s_mode, path(n));
+		return false;
+	}
+
+	return true;
+}
+
+// A cache with lines only hits cache lines, one with readahead also fills it
+static bool expect_cache_used()
+{
+	lfs_bcachestat stat;
+
+	if (lfs_fs_bcachestat(&s_lfs, &stat) != LFS_ERR_OK || stat.hits == 0 ||
+	    (s_cfg.bcache_readahead != 0 && (stat.ra_hits == 0 || stat.ra_fills == 0))) {
+		printf("lfs_bcache: %s: cache not used, %lu hits, %lu readahead hits\n", s_mode, (unsigned long)stat.hits,
+		       (unsigned long)stat.ra_hits);
+		return false;
+	}
+
+	return true;
+}
+
+static bool check_write()
+{
+	if (!start(LINES, READAHEAD, "write")) {
+		return false;
+	}
+
+	// Inlined, then in blocks, overwritten across the cache lines already read and appended
+	return write_file(0, 0, 100, LFS_O_TRUNC, "an inline write") && verify(0, "an inline write") &&
+	       write_file(0, 0, 20000, LFS_O_TRUNC, "a write") && verify(0, "a write") &&
+	       write_file(0, 5000, 300, 0, "an overwrite") && verify(0, "an overwrite") &&
+	       write_file(0, 4000, 4096, 0, "a block overwrite") && verify(0, "a block overwrite") &&
+	       write_file(0, 20000, 3000, 0, "an append") && verify(0, "an append") &&
+	       // the last read ends at the end of the first block and the seek lands
+	       // in the second block, at an offset of the first block in the file cache
+	       read_then_seek(0, LfsRamDisk::BLOCK_SIZE, LfsRamDisk::BLOCK_SIZE + 3900, 200, "a seek past a block end") &&
+	       write_file(0, 0, 1000, LFS_O_TRUNC, "a truncating write") && verify(0, "a truncating write") &&
+	       expect_cache_used() && lfs_unmount(&s_lfs) == LFS_ERR_OK;
+}
+
+static bool check_erase()
+{
+	if (!start(LINES, READAHEAD, "erase")) {
+		return false;
+	}
+
+	// f0 is read into the cache, removed, and its blocks erased and reused by f1
+	if (!write_file(0, 0, 12000, LFS_O_TRUNC, "a write") || !verify(0, "a write") || !remove_file(0) ||
+	    !verify(0, "a remove")) {
+		return false;
+	}
+
+	const uint32_t erases = s_disk.stats().erases;
+
+	while (s_disk.stats().erases < erases + 2 * BLOCK_COUNT) {
+		if (!write_file(1, 0, FILE_MAX, LFS_O_TRUNC, "a rewrite") || !verify(1, "a rewrite")) {
+			return false;
+		}
+	}
+
+	// and f0 is written again over blocks f1 had
+	return write_file(0, 0, FILE_MAX, LFS_O_TRUNC, "a write after erase") && verify(0, "a write after erase") &&
+	       verify(1, "a write after erase") && expect_cache_used() && lfs_unmount(&s_lfs) == LFS_ERR_OK;
+}
+
+// A sequential read of f0 leaves the rest of its block in the readahead
+// buffer. f1 is rewritten until it is in that block, a read of f1 from
+// where the one of f0 stopped must not be served from the buffer.
+static bool check_reuse()
+{
+	if (!start(LINES, READAHEAD, "reuse")) {
+		return false;
+	}
+
+	static constexpr lfs_size_t SIZE = 3000;
+	static constexpr lfs_off_t STOP = 4 * LfsRamDisk::CACHE_SIZE;
+	lfs_file_t file;
+
+	if (!write_file(0, 0, SIZE, LFS_O_TRUNC, "a write") ||
+	    lfs_file_open(&s_lfs, &file, path(0), LFS_O_RDONLY) != LFS_ERR_OK) {
+		return false;
+	}
+
+	const lfs_block_t block = file.ctz.head;
+	lfs_file_close(&s_lfs, &file);
+
+	if (!read_then_seek(0, STOP - LfsRamDisk::CACHE_SIZE, STOP - LfsRamDisk::CACHE_SIZE, LfsRamDisk::CACHE_SIZE,
+			    "a read") || !remove_file(0)) {
+		return false;
+	}
+
+	// nothing else is read from a file in between
+	for (uint32_t i = 0; i < 4 * BLOCK_COUNT; i++) {
+		if (!write_file(1, 0, SIZE, LFS_O_TRUNC, "a rewrite", false) ||
+		    lfs_file_open(&s_lfs, &file, path(1), LFS_O_RDONLY) != LFS_ERR_OK) {
+			return false;
+		}
+
+		const bool reused = file.ctz.head == block;
+		bool ok = !reused || (lfs_file_seek(&s_lfs, &file, STOP, LFS_SEEK_SET) == (lfs_soff_t)STOP &&
+				      lfs_file_read(&s_lfs, &file, s_buf, LfsRamDisk::CACHE_SIZE) ==
+				      (lfs_ssize_t)LfsRamDisk::CACHE_SIZE && compare(1, STOP, LfsRamDisk::CACHE_SIZE, "a reuse"));
+		ok = lfs_file_close(&s_lfs, &file) == LFS_ERR_OK && ok;
+
+		if (!ok || reused) {
+			return ok && verify(1, "a reuse") && expect_cache_used() && lfs_unmount(&s_lfs) == LFS_ERR_OK;
+		}
+	}
+
+	printf("lfs_bcache: %s: block %lu of %s never reused\n", s_mode, (unsigned long)block, path(0));
+	return false;
+}
+
+static bool check_remount()
+{
+	if (!start(LINES, READAHEAD, "remount")) {
+		return false;
+	}
+
+	for (uint32_t n = 0; n < FILES; n++) {
+		if (!write_file(n, 0, 1000 + n * 6000, LFS_O_TRUNC, "a write")) {
+			return false;
+		}
+	}
+
+	// The cache is read full before the remount and starts empty after it
+	return verify_all("a write") && remount() && verify_all("a remount") && expect_cache_used() &&
+	       remove_file(3) && write_file(2, 3000, 2000, 0, "an overwrite") && remount() && verify_all("a second remount") &&
+	       lfs_unmount(&s_lfs) == LFS_ERR_OK;
+}
+
+static bool check_random(lfs_size_t lines, lfs_size_t readahead, const char *mode)
+{
+	if (!start(lines, readahead, mode)) {
+		return false;
+	}
+
+	s_seed = 1;
+
+	for (uint32_t step = 0; step < RANDOM_STEPS; step++) {
+		const uint32_t n = next_random() % FILES;
+		const ModelFile &model = s_model[n];
+		bool ok = true;
+
+		switch (next_random() % 8) {
+		case 0:
+		case 1:
+			ok = write_file(n, 0, next_random() % (FILE_MAX + 1), LFS_O_TRUNC, "a write") && verify(n, "a write");
+			break;
+
+		case 2:
+		case 3: {
+				const lfs_off_t off = model.size ? next_random() % model.size : 0;
+				ok = write_file(n, off, next_random() % (FILE_MAX - off + 1), 0, "an overwrite") && verify(n, "an overwrite");
+				break;
+			}
+
+		case 4:
+			ok = write_file(n, model.size, next_random() % (FILE_MAX - model.size + 1), 0, "an append") &&
+			     verify(n, "an append");
+			break;
+
+		case 5:
+			ok = !model.exists || (remove_file(n) && verify(n, "a remove"));
+			break;
+
+		case 6:
+			ok = remount() && verify_all("a remount");
+			break;
+
+		default:
+			ok = verify(n, "a read");
+			break;
+		}
+
+		if (!ok) {
+			printf("lfs_bcache: %s: step %lu failed\n", s_mode, (unsigned long)step);
+			return false;
+		}
+	}
+
+	return verify_all("the random steps") && (lines == 0 || expect_cache_used()) &&
+	       lfs_unmount(&s_lfs) == LFS_ERR_OK;
+}
+
+int main()
+{
+	if (!check_write() || !check_erase() || !check_reuse() || !check_remount() || !check_random(0, 0, "random without cache") ||
+	    !check_random(LINES, 0, "random with cache lines") ||
+	    !check_random(LINES, READAHEAD, "random with cache lines and readahead")) {
+		return 1;
+	}
+
+	printf("lfs_bcache: ok\n");
+	return 0;
+}
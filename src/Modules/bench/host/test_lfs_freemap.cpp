@@ -0,0 +1,504 @@
+#include "LfsRamDisk.hpp"
+
+#include "lfs.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// Host test of the LFS_FREEMAP free block bitmap of littlefs on a 48 block
+// RAM disk (LfsRamDisk), against a model of 8 files in 2 directories. A
+// random sequence of writes, overwrites and appends, truncates, renames
+// within and across the directories (replacing the target), removes and
+// remounts keeps the volume busy enough that every block is allocated
+// again and again. A reader is kept open across some of the steps, its
+// file is left alone and must read back unchanged at the end, and a writer
+// keeps appending to a file across steps, with blocks allocated but not
+// committed while the others commit and the bitmap is rebuilt. Every file
+// touched is read back and compared against the model, after a remount
+// all files and the directory listings are. The same sequence runs with
+// the bitmap and with the lookahead allocator. Returns non-zero on the
+// first mismatch.
+
+static constexpr lfs_size_t BLOCK_COUNT = 48;
+static constexpr uint32_t DIRS = 2;
+static constexpr uint32_t FILES_PER_DIR = 4;
+static constexpr uint32_t FILES = DIRS * FILES_PER_DIR;
+static constexpr lfs_size_t FILE_MAX = 16 * 1024;
+static constexpr lfs_size_t DATA_MAX = 64 * 1024;     // all files together
+static constexpr lfs_size_t READER_MIN = 1024;        // not inlined
+static constexpr lfs_size_t CHUNK_MAX = 700;
+static constexpr uint32_t RANDOM_STEPS = 4000;
+
+struct ModelFile {
+	uint8_t data[FILE_MAX];
+	lfs_size_t size;
+	bool exists;
+};
+
+static LfsRamDisk s_disk;
+static lfs_config s_cfg;
+static lfs_t s_lfs;
+static ModelFile s_model[FILES];
+static uint8_t s_buf[FILE_MAX];
+static uint32_t s_seed = 1;
+static const char *s_mode = "";
+
+// The reader and the file contents when it was opened
+static lfs_file_t s_reader;
+static bool s_reader_open = false;
+static uint32_t s_reader_file = 0;
+static ModelFile s_reader_model;
+
+// The writer appending to a file across steps, the model has what it wrote
+static lfs_file_t s_writer;
+static bool s_writer_open = false;
+static uint32_t s_writer_file = 0;
+
+static uint32_t next_random()
+{
+	s_seed = s_seed * 1103515245 + 12345;
+	return s_seed >> 8;
+}
+
+static const char *path(uint32_t n)
+{
+	static char name[16];
+	snprintf(name, sizeof(name), "d%lu/f%lu", (unsigned long)(n / FILES_PER_DIR), (unsigned long)(n % FILES_PER_DIR));
+	return name;
+}
+
+static lfs_size_t data_size()
+{
+	lfs_size_t size = 0;
+
+	for (uint32_t n = 0; n < FILES; n++) {
+		size += s_model[n].exists ? s_model[n].size : 0;
+	}
+
+	return size;
+}
+
+static bool compare(const ModelFile &model, const char *name, lfs_off_t off, lfs_size_t size, const char *what)
+{
+	for (lfs_size_t i = 0; i < size; i++) {
+		if (s_buf[i] != model.data[off + i]) {
+			printf("lfs_freemap: %s: %s differs at %lu after %s\n", s_mode, name, (unsigned long)(off + i), what);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// Reads the whole file in random chunks, then at random offsets
+static bool read_file(lfs_file_t *file, const ModelFile &model, const char *name, const char *what)
+{
+	if (lfs_file_size(&s_lfs, file) != (lfs_soff_t)model.size) {
+		printf("lfs_freemap: %s: %s is %ld bytes instead of %lu after %s\n", s_mode, name,
+		       (long)lfs_file_size(&s_lfs, file), (unsigned long)model.size, what);
+		return false;
+	}
+
+	bool ok = lfs_file_rewind(&s_lfs, file) == LFS_ERR_OK;
+
+	for (lfs_off_t off = 0; ok && off < model.size;) {
+		const lfs_size_t size = lfs_min(1 + next_random() % CHUNK_MAX, model.size - off);
+		ok = lfs_file_read(&s_lfs, file, s_buf, size) == (lfs_ssize_t)size && compare(model, name, off, size, what);
+		off += size;
+	}
+
+	for (uint32_t i = 0; ok && model.size > 0 && i < 4; i++) {
+		const lfs_off_t off = next_random() % model.size;
+		const lfs_size_t size = lfs_min(1 + next_random() % CHUNK_MAX, model.size - off);
+		ok = lfs_file_seek(&s_lfs, file, off, LFS_SEEK_SET) == (lfs_soff_t)off &&
+		     lfs_file_read(&s_lfs, file, s_buf, size) == (lfs_ssize_t)size && compare(model, name, off, size, what);
+	}
+
+	if (!ok) {
+		printf("lfs_freemap: %s: %s read failed after %s\n", s_mode, name, what);
+	}
+
+	return ok;
+}
+
+static bool verify(uint32_t n, const char *what)
+{
+	const ModelFile &model = s_model[n];
+	lfs_file_t file;
+	const int err = lfs_file_open(&s_lfs, &file, path(n), LFS_O_RDONLY);
+
+	if (!model.exists) {
+		if (err != LFS_ERR_NOENT) {
+			printf("lfs_freemap: %s: %s opened with %d after %s, removed\n", s_mode, path(n), err, what);
+
+			if (err == LFS_ERR_OK) {
+				lfs_file_close(&s_lfs, &file);
+			}
+
+			return false;
+		}
+
+		return true;
+	}
+
+	if (err != LFS_ERR_OK) {
+		printf("lfs_freemap: %s: %s open failed with %d after %s\n", s_mode, path(n), err, what);
+		return false;
+	}
+
+	const bool ok = read_file(&file, model, path(n), what);
+	return lfs_file_close(&s_lfs, &file) == LFS_ERR_OK && ok;
+}
+
+// Every file in the model and nothing else is listed, with its size
+static bool verify_dirs(const char *what)
+{
+	for (uint32_t d = 0; d < DIRS; d++) {
+		char name[8];
+		snprintf(name, sizeof(name), "d%lu", (unsigned long)d);
+		lfs_dir_t dir;
+		lfs_info info;
+		uint32_t listed = 0;
+		uint32_t expect = 0;
+
+		if (lfs_dir_open(&s_lfs, &dir, name) != LFS_ERR_OK) {
+			printf("lfs_freemap: %s: %s open failed after %s\n", s_mode, name, what);
+			return false;
+		}
+
+		while (lfs_dir_read(&s_lfs, &dir, &info) > 0) {
+			unsigned f = 0;
+
+			if (strcmp(info.name, ".") == 0 || strcmp(info.name, "..") == 0) {
+				continue;
+			}
+
+			if (sscanf(info.name, "f%u", &f) != 1 || f >= FILES_PER_DIR || !s_model[d * FILES_PER_DIR + f].exists ||
+			    info.size != s_model[d * FILES_PER_DIR + f].size) {
+				printf("lfs_freemap: %s: %s/%s of %lu bytes listed after %s\n", s_mode, name, info.name,
+				       (unsigned long)info.size, what);
+				lfs_dir_close(&s_lfs, &dir);
+				return false;
+			}
+
+			listed++;
+		}
+
+		for (uint32_t f = 0; f < FILES_PER_DIR; f++) {
+			expect += s_model[d * FILES_PER_DIR + f].exists;
+		}
+
+		lfs_dir_close(&s_lfs, &dir);
+
+		if (listed != expect) {
+			printf("lfs_freemap: %s: %s lists %lu files instead of %lu after %s\n", s_mode, name,
+			       (unsigned long)listed, (unsigned long)expect, what);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static bool verify_all(const char *what)
+{
+	for (uint32_t n = 0; n < FILES; n++) {
+		if (!verify(n, what)) {
+			return false;
+		}
+	}
+
+	return verify_dirs(what);
+}
+
+static bool close_reader(const char *what)
+{
+	if (!s_reader_open) {
+		return true;
+	}
+
+	s_reader_open = false;
+	char name[32];
+	snprintf(name, sizeof(name), "the reader of %s", path(s_reader_file));
+	const bool ok = read_file(&s_reader, s_reader_model, name, what);
+	return lfs_file_close(&s_lfs, &s_reader) == LFS_ERR_OK && ok;
+}
+
+static bool open_reader(uint32_t n)
+{
+	s_reader_model = s_model[n];
+	s_reader_file = n;
+	s_reader_open = lfs_file_open(&s_lfs, &s_reader, path(n), LFS_O_RDONLY) == LFS_ERR_OK;
+
+	if (!s_reader_open) {
+		printf("lfs_freemap: %s: reader open of %s failed\n", s_mode, path(n));
+	}
+
+	return s_reader_open;
+}
+
+static bool close_writer(const char *what)
+{
+	if (!s_writer_open) {
+		return true;
+	}
+
+	s_writer_open = false;
+
+	if (lfs_file_close(&s_lfs, &s_writer) != LFS_ERR_OK) {
+		printf("lfs_freemap: %s: writer close of %s failed\n", s_mode, path(s_writer_file));
+		return false;
+	}
+
+	return verify(s_writer_file, what);
+}
+
+static bool open_writer(uint32_t n)
+{
+	s_writer_file = n;
+	s_writer_open = lfs_file_open(&s_lfs, &s_writer, path(n), LFS_O_WRONLY | LFS_O_CREAT | LFS_O_APPEND) ==
+			LFS_ERR_OK;
+	s_model[n].exists = true;
+
+	if (!s_writer_open) {
+		printf("lfs_freemap: %s: writer open of %s failed\n", s_mode, path(n));
+	}
+
+	return s_writer_open;
+}
+
+static bool append_writer(lfs_size_t size)
+{
+	ModelFile &model = s_model[s_writer_file];
+
+	for (lfs_size_t i = 0; i < size; i++) {
+		model.data[model.size + i] = (uint8_t)next_random();
+	}
+
+	if (lfs_file_write(&s_lfs, &s_writer, &model.data[model.size], size) != (lfs_ssize_t)size) {
+		printf("lfs_freemap: %s: writer append to %s failed\n", s_mode, path(s_writer_file));
+		return false;
+	}
+
+	model.size += size;
+	return true;
+}
+
+static bool remount()
+{
+	if (!close_reader("a remount") || !close_writer("a remount")) {
+		return false;
+	}
+
+	if (lfs_unmount(&s_lfs) != LFS_ERR_OK || lfs_mount(&s_lfs, &s_cfg) != LFS_ERR_OK) {
+		printf("lfs_freemap: %s: remount failed\n", s_mode);
+		return false;
+	}
+
+	return true;
+}
+
+// Writes size random bytes at off in random chunks, off is at most the size of the file
+static bool write_file(uint32_t n, lfs_off_t off, lfs_size_t size, int flags, const char *what)
+{
+	ModelFile &model = s_model[n];
+	lfs_file_t file;
+
+	if (lfs_file_open(&s_lfs, &file, path(n), LFS_O_WRONLY | LFS_O_CREAT | flags) != LFS_ERR_OK) {
+		printf("lfs_freemap: %s: %s open for %s failed\n", s_mode, path(n), what);
+		return false;
+	}
+
+	if (flags & LFS_O_TRUNC) {
+		model.size = 0;
+	}
+
+	for (lfs_size_t i = 0; i < size; i++) {
+		model.data[off + i] = (uint8_t)next_random();
+	}
+
+	model.size = lfs_max(model.size, off + size);
+	model.exists = true;
+	bool ok = lfs_file_seek(&s_lfs, &file, off, LFS_SEEK_SET) == (lfs_soff_t)off;
+
+	for (lfs_size_t done = 0; ok && done < size;) {
+		const lfs_size_t chunk = lfs_min(1 + next_random() % CHUNK_MAX, size - done);
+		ok = lfs_file_write(&s_lfs, &file, &model.data[off + done], chunk) == (lfs_ssize_t)chunk;
+		done += chunk;
+	}
+
+	if (lfs_file_close(&s_lfs, &file) != LFS_ERR_OK || !ok) {
+		printf("lfs_freemap: %s: %s %s failed\n", s_mode, path(n), what);
+		return false;
+	}
+
+	return true;
+}
+
+static bool truncate_file(uint32_t n, lfs_size_t size)
+{
+	lfs_file_t file;
+
+	if (lfs_file_open(&s_lfs, &file, path(n), LFS_O_WRONLY) != LFS_ERR_OK) {
+		printf("lfs_freemap: %s: %s open for a truncate failed\n", s_mode, path(n));
+		return false;
+	}
+
+	s_model[n].size = size;
+	const bool ok = lfs_file_truncate(&s_lfs, &file, size) == LFS_ERR_OK;
+
+	if (lfs_file_close(&s_lfs, &file) != LFS_ERR_OK || !ok) {
+		printf("lfs_freemap: %s: %s truncate failed\n", s_mode, path(n));
+		return false;
+	}
+
+	return true;
+}
+
+static bool rename_file(uint32_t from, uint32_t to)
+{
+	char name[16];
+	snprintf(name, sizeof(name), "%s", path(from));
+
+	if (lfs_rename(&s_lfs, name, path(to)) != LFS_ERR_OK) {
+		printf("lfs_freemap: %s: rename of %s to %s failed\n", s_mode, name, path(to));
+		return false;
+	}
+
+	s_model[to] = s_model[from];
+	s_model[from].exists = false;
+	s_model[from].size = 0;
+	return true;
+}
+
+static bool remove_file(uint32_t n)
+{
+	s_model[n].exists = false;
+	s_model[n].size = 0;
+
+	if (lfs_remove(&s_lfs, path(n)) != LFS_ERR_OK) {
+		printf("lfs_freemap: %s: %s remove failed\n", s_mode, path(n));
+		return false;
+	}
+
+	return true;
+}
+
+// The files open in the reader and the writer are left to them until closed
+static bool pinned(uint32_t n)
+{
+	return (s_reader_open && n == s_reader_file) || (s_writer_open && n == s_writer_file);
+}
+
+static bool step(uint32_t n)
+{
+	const ModelFile &model = s_model[n];
+	const lfs_size_t others = data_size() - (model.exists ? model.size : 0);
+	const lfs_size_t room = lfs_min(FILE_MAX, DATA_MAX - others);
+	uint32_t op = next_random() % 11;
+
+	if (s_writer_open && next_random() % 2) {
+		const ModelFile &written = s_model[s_writer_file];
+		const lfs_size_t size = next_random() % (CHUNK_MAX + 1);
+
+		if (data_size() + size <= DATA_MAX && written.size + size <= FILE_MAX && !append_writer(size)) {
+			return false;
+		}
+	}
+
+	if (pinned(n) && op != 7 && !(op == 8 && s_reader_open) && !(op == 9 && s_writer_open)) {
+		return true;
+	}
+
+	switch (op) {
+	case 0:
+	case 1:
+		return write_file(n, 0, next_random() % (room + 1), LFS_O_TRUNC, "a write") && verify(n, "a write");
+
+	case 2: {
+			// an overwrite in the middle or an append
+			const lfs_off_t off = model.size ? next_random() % (model.size + 1) : 0;
+			return write_file(n, off, next_random() % (room - off + 1), 0, "an overwrite") &&
+			       verify(n, "an overwrite");
+		}
+
+	case 3:
+		return !model.exists || (truncate_file(n, next_random() % (model.size + 1)) && verify(n, "a truncate"));
+
+	case 4:
+	case 5: {
+			const uint32_t to = next_random() % FILES;
+			return !model.exists || to == n || pinned(to) ||
+			       (rename_file(n, to) && verify(n, "a rename") && verify(to, "a rename"));
+		}
+
+	case 6:
+		return !model.exists || (remove_file(n) && verify(n, "a remove"));
+
+	case 7:
+		return remount() && verify_all("a remount");
+
+	case 8:
+		if (s_reader_open) {
+			return close_reader("the steps");
+		}
+
+		return model.size < READER_MIN || open_reader(n);
+
+	case 9:
+		if (s_writer_open) {
+			return close_writer("the appends");
+		}
+
+		return open_writer(n);
+
+	default:
+		return verify(n, "a read");
+	}
+}
+
+static bool check_random(bool freemap, const char *mode)
+{
+	s_mode = mode;
+	s_seed = 1;
+	memset(s_model, 0, sizeof(s_model));
+
+	if (!s_disk.init(BLOCK_COUNT, s_cfg)) {
+		printf("lfs_freemap: out of memory\n");
+		return false;
+	}
+
+	s_cfg.freemap = freemap;
+
+	if (lfs_format(&s_lfs, &s_cfg) != LFS_ERR_OK || lfs_mount(&s_lfs, &s_cfg) != LFS_ERR_OK ||
+	    lfs_mkdir(&s_lfs, "d0") != LFS_ERR_OK || lfs_mkdir(&s_lfs, "d1") != LFS_ERR_OK) {
+		printf("lfs_freemap: %s: format failed\n", s_mode);
+		return false;
+	}
+
+	for (uint32_t i = 0; i < RANDOM_STEPS; i++) {
+		if (!step(next_random() % FILES)) {
+			printf("lfs_freemap: %s: step %lu failed\n", s_mode, (unsigned long)i);
+			return false;
+		}
+	}
+
+	// every block was allocated many times over
+	if (s_disk.stats().erases < 20 * BLOCK_COUNT) {
+		printf("lfs_freemap: %s: only %lu erases\n", s_mode, (unsigned long)s_disk.stats().erases);
+		return false;
+	}
+
+	return close_reader("the steps") && close_writer("the steps") && verify_all("the steps") && remount() && verify_all("the last remount") &&
+	       lfs_unmount(&s_lfs) == LFS_ERR_OK;
+}
+
+int main()
+{
+	if (!check_random(true, "freemap") || !check_random(false, "lookahead")) {
+		return 1;
+	}
+
+	printf("lfs_freemap: ok\n");
+	return 0;
+}
@@ -0,0 +1,282 @@
+#include "LfsRamDisk.hpp"
+
+#include "lfs.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// Host test of the LFS_CTZINDEX block index of open littlefs files on a
+// 256 block RAM disk (LfsRamDisk), against a model of the file contents.
+// One file of up to 256 KiB is kept open for reading and writing while a
+// random sequence of seeks from the start, the current position and the
+// end with reads across block boundaries, overwrites, writes past the end,
+// appends, truncates down and up, rewrites from scratch to the same or
+// another size, syncs, lfs_file_index calls, reopens and remounts runs on
+// it. Every read is compared against the model. The same sequence runs
+// without the index, with 4 entries (many blocks per entry) and with an
+// entry per block. Returns non-zero on the first mismatch.
+
+static constexpr lfs_size_t BLOCK_COUNT = 256;
+static constexpr lfs_size_t FILE_MAX = 256 * 1024;
+static constexpr lfs_size_t GAP_MAX = 6000;
+static constexpr lfs_size_t READ_MAX = 9000;
+static constexpr lfs_size_t WRITE_MAX = 9000;
+static constexpr uint32_t RANDOM_STEPS = 6000;
+
+static LfsRamDisk s_disk;
+static lfs_config s_cfg;
+static lfs_t s_lfs;
+static lfs_file_t s_file;
+static lfs_file_config s_file_cfg;
+static uint8_t s_model[FILE_MAX];
+static lfs_size_t s_size = 0;
+static lfs_off_t s_pos = 0;
+static uint8_t s_buf[READ_MAX];
+static uint32_t s_seed = 1;
+static const char *s_mode = "";
+
+static uint32_t next_random()
+{
+	s_seed = s_seed * 1103515245 + 12345;
+	return s_seed >> 8;
+}
+
+static bool open_file(int flags)
+{
+	if (lfs_file_opencfg(&s_lfs, &s_file, "log.bin", LFS_O_RDWR | flags, &s_file_cfg) != LFS_ERR_OK) {
+		printf("lfs_seek: %s: open failed\n", s_mode);
+		return false;
+	}
+
+	s_pos = 0;
+	return true;
+}
+
+static bool reopen(bool remount)
+{
+	if (lfs_file_close(&s_lfs, &s_file) != LFS_ERR_OK) {
+		printf("lfs_seek: %s: close failed\n", s_mode);
+		return false;
+	}
+
+	if (remount && (lfs_unmount(&s_lfs) != LFS_ERR_OK || lfs_mount(&s_lfs, &s_cfg) != LFS_ERR_OK)) {
+		printf("lfs_seek: %s: remount failed\n", s_mode);
+		return false;
+	}
+
+	return open_file(0);
+}
+
+static bool seek(lfs_soff_t off, int whence)
+{
+	const lfs_soff_t pos = lfs_file_seek(&s_lfs, &s_file, off, whence);
+	const lfs_off_t base = whence == LFS_SEEK_SET ? 0 : whence == LFS_SEEK_CUR ? s_pos : s_size;
+
+	if (pos != (lfs_soff_t)(base + off)) {
+		printf("lfs_seek: %s: seek by %ld from %d went to %ld instead of %lu\n", s_mode, (long)off, whence, (long)pos,
+		       (unsigned long)(base + off));
+		return false;
+	}
+
+	s_pos = pos;
+	return true;
+}
+
+// Reads size bytes from the current position, fewer at the end of the file
+static bool read_file(lfs_size_t size, const char *what)
+{
+	const lfs_size_t expect = s_pos < s_size ? lfs_min(size, s_size - s_pos) : 0;
+	const lfs_ssize_t n = lfs_file_read(&s_lfs, &s_file, s_buf, size);
+
+	if (n != (lfs_ssize_t)expect) {
+		printf("lfs_seek: %s: read of %lu at %lu returned %ld instead of %lu after %s\n", s_mode, (unsigned long)size,
+		       (unsigned long)s_pos, (long)n, (unsigned long)expect, what);
+		return false;
+	}
+
+	for (lfs_size_t i = 0; i < expect; i++) {
+		if (s_buf[i] != s_model[s_pos + i]) {
+			printf("lfs_seek: %s: data at %lu differs after %s\n", s_mode, (unsigned long)(s_pos + i), what);
+			return false;
+		}
+	}
+
+	s_pos += expect;
+	return true;
+}
+
+// Writes size random bytes at the current position, past the end of the
+// file the gap reads back as zeros
+static bool write_file(lfs_size_t size)
+{
+	if (s_pos > s_size) {
+		memset(&s_model[s_size], 0, s_pos - s_size);
+	}
+
+	for (lfs_size_t i = 0; i < size; i++) {
+		s_model[s_pos + i] = (uint8_t)next_random();
+	}
+
+	if (lfs_file_write(&s_lfs, &s_file, &s_model[s_pos], size) != (lfs_ssize_t)size) {
+		printf("lfs_seek: %s: write of %lu at %lu failed\n", s_mode, (unsigned long)size, (unsigned long)s_pos);
+		return false;
+	}
+
+	s_pos += size;
+	s_size = lfs_max(s_size, s_pos);
+	return true;
+}
+
+static bool truncate_file(lfs_size_t size)
+{
+	if (size > s_size) {
+		memset(&s_model[s_size], 0, size - s_size);
+	}
+
+	if (lfs_file_truncate(&s_lfs, &s_file, size) != LFS_ERR_OK) {
+		printf("lfs_seek: %s: truncate to %lu failed\n", s_mode, (unsigned long)size);
+		return false;
+	}
+
+	s_size = size;
+	return true;
+}
+
+// Random reads from anywhere in the file, the way a log is searched
+static bool random_reads(uint32_t count, const char *what)
+{
+	for (uint32_t i = 0; i < count; i++) {
+		if (!seek(next_random() % (s_size + 1), LFS_SEEK_SET) || !read_file(1 + next_random() % READ_MAX, what)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static bool step()
+{
+	switch (next_random() % 16) {
+	case 0:
+	case 1:
+	case 2:
+		return random_reads(4, "the steps");
+
+	case 3: {
+			// relative to the current position, backwards too
+			const lfs_soff_t off = (lfs_soff_t)(next_random() % (s_size + 1)) - (lfs_soff_t)s_pos;
+			return seek(off, LFS_SEEK_CUR) && read_file(1 + next_random() % READ_MAX, "a relative seek");
+		}
+
+	case 4: {
+			const lfs_soff_t off = -(lfs_soff_t)(next_random() % (s_size + 1));
+			return seek(off, LFS_SEEK_END) && read_file(1 + next_random() % READ_MAX, "a seek from the end");
+		}
+
+	case 5:
+	case 6: {
+			// an overwrite, or a write past the end
+			const lfs_off_t pos = next_random() % lfs_min(s_size + GAP_MAX, FILE_MAX);
+			const lfs_size_t size = 1 + next_random() % lfs_min(WRITE_MAX, FILE_MAX - pos);
+			return seek(pos, LFS_SEEK_SET) && write_file(size) && random_reads(4, "an overwrite");
+		}
+
+	case 7: {
+			const lfs_size_t size = next_random() % (lfs_min(WRITE_MAX, FILE_MAX - s_size) + 1);
+			return seek(0, LFS_SEEK_END) && write_file(size) && random_reads(4, "an append");
+		}
+
+	case 8:
+		return truncate_file(next_random() % (s_size + 1)) && random_reads(4, "a truncate");
+
+	case 9:
+		return truncate_file(s_size + next_random() % (lfs_min(GAP_MAX, FILE_MAX - s_size) + 1)) &&
+		       random_reads(4, "a truncate up");
+
+	case 10: {
+			// from scratch, mostly to the same size, the head block may be the same again
+			const lfs_size_t size = next_random() % 2 ? s_size : next_random() % FILE_MAX;
+			bool ok = truncate_file(0) && seek(0, LFS_SEEK_SET);
+
+			for (lfs_size_t done = 0; ok && done < size;) {
+				const lfs_size_t chunk = lfs_min(WRITE_MAX, size - done);
+				ok = write_file(chunk);
+				done += chunk;
+			}
+
+			return ok && random_reads(4, "a rewrite");
+		}
+
+	case 11:
+		if (lfs_file_sync(&s_lfs, &s_file) != LFS_ERR_OK) {
+			printf("lfs_seek: %s: sync failed\n", s_mode);
+			return false;
+		}
+
+		return random_reads(4, "a sync");
+
+	case 12:
+		if (lfs_file_index(&s_lfs, &s_file) != LFS_ERR_OK) {
+			printf("lfs_seek: %s: index failed\n", s_mode);
+			return false;
+		}
+
+		return random_reads(4, "an index");
+
+	case 13:
+		return reopen(false) && random_reads(4, "a reopen");
+
+	case 14:
+		return reopen(true) && random_reads(4, "a remount");
+
+	default:
+		// sequentially from where the last read ended
+		return read_file(1 + next_random() % READ_MAX, "a sequential read");
+	}
+}
+
+static bool check_random(lfs_size_t index_count, const char *mode)
+{
+	s_mode = mode;
+	s_seed = 1;
+	s_size = 0;
+
+	if (!s_disk.init(BLOCK_COUNT, s_cfg)) {
+		printf("lfs_seek: out of memory\n");
+		return false;
+	}
+
+	memset(&s_file_cfg, 0, sizeof(s_file_cfg));
+	s_file_cfg.index_count = index_count;
+
+	if (lfs_format(&s_lfs, &s_cfg) != LFS_ERR_OK || lfs_mount(&s_lfs, &s_cfg) != LFS_ERR_OK) {
+		printf("lfs_seek: %s: format failed\n", s_mode);
+		return false;
+	}
+
+	if (!open_file(LFS_O_CREAT)) {
+		return false;
+	}
+
+	for (uint32_t i = 0; i < RANDOM_STEPS; i++) {
+		if (!step()) {
+			printf("lfs_seek: %s: step %lu failed\n", s_mode, (unsigned long)i);
+			return false;
+		}
+	}
+
+	return reopen(true) && random_reads(64, "the steps") && lfs_file_close(&s_lfs, &s_file) == LFS_ERR_OK &&
+	       lfs_unmount(&s_lfs) == LFS_ERR_OK;
+}
+
+int main()
+{
+	// 256 KiB take 65 blocks
+	if (!check_random(0, "without index") || !check_random(4, "index of 4") ||
+	    !check_random(66, "index per block")) {
+		return 1;
+	}
+
+	printf("lfs_seek: ok\n");
+	return 0;
+}
@@ -0,0 +1,341 @@
+extern "C" {
+#include "fsl_component_mem_manager.h"
+}
+
+#include <stdio.h>
+#include <string.h>
+
+// Host test of the LIFO pools of the memory manager (MEM_MANAGER_LIFO_POOL)
+// next to a pool searched the usual way, both with id 0:
+//
+//   lifo    4 blocks of 64 B, MEM_POOL_FLAG_LIFO
+//   search  2 blocks of 128 B
+//
+// The blocks are handed out in address order at first and the LIFO pool
+// then returns the block freed last. Allocations, frees and reallocations
+// are checked against a model that predicts the address of every block,
+// the contents of the blocks in use, when a pool is exhausted and the
+// statistics of the LIFO pool. Returns non-zero on the first mismatch.
+
+static constexpr uint32_t LIFO_BLOCKS = 4;
+static constexpr uint32_t LIFO_SIZE = 64;
+static constexpr uint32_t SEARCH_BLOCKS = 2;
+static constexpr uint32_t SEARCH_SIZE = 128;
+static constexpr unsigned int RANDOM_OPS = 20000;
+
+MEM_BLOCK_LIFO_BUFFER_DEFINE(lifo, 4, 64, 0);
+MEM_BLOCK_BUFFER_DEFINE(search, 2, 128, 0);
+
+static uint32_t s_seed = 1;
+
+static uint32_t next_random()
+{
+	s_seed = s_seed * 1103515245 + 12345;
+	return s_seed >> 8;
+}
+
+static uint8_t *block(uint32_t *pool, uint32_t size, uint32_t index)
+{
+	return (uint8_t *)pool + MEM_POOL_SIZE + index * (MEM_BLOCK_SIZE + size) + MEM_BLOCK_SIZE;
+}
+
+static uint8_t *lifo_block(uint32_t index) { return block(g_poolBufferlifo, LIFO_SIZE, index); }
+static uint8_t *search_block(uint32_t index) { return block(g_poolBuffersearch, SEARCH_SIZE, index); }
+
+static bool zeroed(const uint8_t *data, uint32_t size)
+{
+	for (uint32_t i = 0; i < size; i++) {
+		if (data[i] != 0) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static bool check_statistics(const char *what, uint16_t allocated, uint16_t max, uint32_t failures, bool reset = false)
+{
+	mem_pool_statistics_t stats;
+
+	if (MEM_GetPoolStatistics(MEM_BLOCK_BUFFER(lifo), &stats, reset) != kStatus_MemSuccess ||
+	    stats.numBlocks != LIFO_BLOCKS || stats.allocatedBlocks != allocated || stats.allocatedBlocksMax != max ||
+	    stats.allocationFailures != failures) {
+		printf("mem_manager: %s: %u allocated, max %u, %u failures instead of %u, %u, %u\n", what,
+		       stats.allocatedBlocks, stats.allocatedBlocksMax, (unsigned)stats.allocationFailures, allocated, max,
+		       (unsigned)failures);
+		return false;
+	}
+
+	return true;
+}
+
+// MEM_BufferAllocFromPool() in address order, then the block freed last
+static bool check_order()
+{
+	uint8_t *buffers[LIFO_BLOCKS];
+
+	for (uint32_t i = 0; i < LIFO_BLOCKS; i++) {
+		buffers[i] = (uint8_t *)MEM_BufferAllocFromPool(MEM_BLOCK_BUFFER(lifo));
+
+		if (buffers[i] != lifo_block(i) || !zeroed(buffers[i], LIFO_SIZE)) {
+			printf("mem_manager: allocation %u returned %p instead of %p\n", i, buffers[i], lifo_block(i));
+			return false;
+		}
+
+		memset(buffers[i], 0xa5, LIFO_SIZE);
+	}
+
+	if (MEM_BufferAllocFromPool(MEM_BLOCK_BUFFER(lifo)) != nullptr) {
+		printf("mem_manager: allocation from the exhausted pool succeeded\n");
+		return false;
+	}
+
+	if (!check_statistics("exhausted", LIFO_BLOCKS, LIFO_BLOCKS, 1)) {
+		return false;
+	}
+
+	if (MEM_BufferFree(buffers[1]) != kStatus_MemSuccess || MEM_BufferFree(buffers[3]) != kStatus_MemSuccess ||
+	    !check_statistics("two freed", LIFO_BLOCKS - 2, LIFO_BLOCKS, 1)) {
+		return false;
+	}
+
+	uint8_t *first = (uint8_t *)MEM_BufferAllocFromPool(MEM_BLOCK_BUFFER(lifo));
+	uint8_t *second = (uint8_t *)MEM_BufferAllocFromPool(MEM_BLOCK_BUFFER(lifo));
+
+	if (first != buffers[3] || second != buffers[1] || !zeroed(first, LIFO_SIZE) || !zeroed(second, LIFO_SIZE)) {
+		printf("mem_manager: reallocated %p and %p instead of %p and %p\n", first, second, buffers[3], buffers[1]);
+		return false;
+	}
+
+	for (uint32_t i = 0; i < LIFO_BLOCKS; i++) {
+		MEM_BufferFree(buffers[i]);
+	}
+
+	// The reset brings the high-water mark down to what is in use
+	return check_statistics("freed", 0, LIFO_BLOCKS, 1, true) && check_statistics("reset", 0, 0, 0);
+}
+
+// MEM_BufferAlloc() takes the smallest pool with a free block, a LIFO pool
+// found empty counts a failure only if no other pool serves the request
+static bool check_search()
+{
+	uint8_t *buffers[LIFO_BLOCKS + SEARCH_BLOCKS];
+
+	// check_order() freed the blocks in address order, they come back reversed
+	for (uint32_t i = 0; i < LIFO_BLOCKS + SEARCH_BLOCKS; i++) {
+		uint8_t *expect = i < LIFO_BLOCKS ? lifo_block(LIFO_BLOCKS - 1 - i) : search_block(i - LIFO_BLOCKS);
+		buffers[i] = (uint8_t *)MEM_BufferAlloc(32);
+
+		if (buffers[i] != expect) {
+			printf("mem_manager: search %u returned %p instead of %p\n", i, buffers[i], expect);
+			return false;
+		}
+	}
+
+	if (!check_statistics("spilled", LIFO_BLOCKS, LIFO_BLOCKS, 0)) {
+		return false;
+	}
+
+	if (MEM_BufferAlloc(100) != nullptr || !check_statistics("search pool exhausted", LIFO_BLOCKS, LIFO_BLOCKS, 0) ||
+	    MEM_BufferAlloc(32) != nullptr || !check_statistics("both exhausted", LIFO_BLOCKS, LIFO_BLOCKS, 1)) {
+		printf("mem_manager: allocation from the exhausted pools\n");
+		return false;
+	}
+
+	for (uint32_t i = 0; i < LIFO_BLOCKS + SEARCH_BLOCKS; i++) {
+		MEM_BufferFree(buffers[i]);
+	}
+
+	return check_statistics("search freed", 0, LIFO_BLOCKS, 1, true);
+}
+
+// Model of both pools: the free-list of the LIFO pool as a stack, the
+// search pool hands out its first free block
+
+struct Buffer {
+	uint8_t *data;
+	uint32_t size;     // block size
+	uint8_t tag;
+};
+
+static uint8_t *s_lifo_free[LIFO_BLOCKS];
+static uint32_t s_lifo_free_count;
+static bool s_search_used[SEARCH_BLOCKS];
+static Buffer s_live[LIFO_BLOCKS + SEARCH_BLOCKS];
+static uint32_t s_live_count;
+static uint16_t s_lifo_max;
+static uint32_t s_lifo_failures;
+
+static uint8_t *model_alloc(uint32_t size, uint32_t &block_size)
+{
+	if (size <= LIFO_SIZE) {
+		if (s_lifo_free_count > 0) {
+			const uint16_t allocated = (uint16_t)(LIFO_BLOCKS - s_lifo_free_count + 1);
+			s_lifo_max = allocated > s_lifo_max ? allocated : s_lifo_max;
+			block_size = LIFO_SIZE;
+			return s_lifo_free[--s_lifo_free_count];
+		}
+	}
+
+	if (size <= SEARCH_SIZE) {
+		for (uint32_t i = 0; i < SEARCH_BLOCKS; i++) {
+			if (!s_search_used[i]) {
+				s_search_used[i] = true;
+				block_size = SEARCH_SIZE;
+				return search_block(i);
+			}
+		}
+	}
+
+	s_lifo_failures += size <= LIFO_SIZE;
+	return nullptr;
+}
+
+static void model_free(const Buffer &buffer)
+{
+	if (buffer.size == LIFO_SIZE) {
+		s_lifo_free[s_lifo_free_count++] = buffer.data;
+
+	} else {
+		s_search_used[(buffer.data - search_block(0)) / (MEM_BLOCK_SIZE + SEARCH_SIZE)] = false;
+	}
+}
+
+static bool check_live(unsigned int op)
+{
+	for (uint32_t i = 0; i < s_live_count; i++) {
+		for (uint32_t j = 0; j < s_live[i].size; j++) {
+			if (s_live[i].data[j] != s_live[i].tag) {
+				printf("mem_manager: op %u: %p lost its data at %u\n", op, s_live[i].data, j);
+				return false;
+			}
+		}
+	}
+
+	return check_statistics("model", (uint16_t)(LIFO_BLOCKS - s_lifo_free_count), s_lifo_max, s_lifo_failures);
+}
+
+static bool check_random()
+{
+	// Back to the free-list in address order
+	MEM_BufferFreeAllWithId(0);
+	s_seed = 1;
+	s_live_count = 0;
+	s_lifo_max = 0;
+	s_lifo_failures = 0;
+	s_lifo_free_count = LIFO_BLOCKS;
+	memset(s_search_used, 0, sizeof(s_search_used));
+
+	for (uint32_t i = 0; i < LIFO_BLOCKS; i++) {
+		s_lifo_free[i] = lifo_block(LIFO_BLOCKS - 1 - i);
+	}
+
+	for (unsigned int op = 0; op < RANDOM_OPS; op++) {
+		const uint32_t kind = next_random() % 100;
+		const uint32_t size = 1 + next_random() % (SEARCH_SIZE + 32);
+
+		if (kind < 40) {
+			// MEM_BufferAlloc() or MEM_BufferAllocFromPool()
+			const bool from_pool = kind < 10;
+			uint32_t block_size = 0;
+			uint8_t *expect = model_alloc(from_pool ? 1 : size, block_size);
+			uint8_t *data = (uint8_t *)(from_pool ? MEM_BufferAllocFromPool(MEM_BLOCK_BUFFER(lifo))
+						    : MEM_BufferAlloc(size));
+
+			if (from_pool && expect != nullptr && block_size != LIFO_SIZE) {
+				// Only the LIFO pool, the model took a search block
+				model_free({expect, block_size, 0});
+				s_lifo_failures++;
+				expect = nullptr;
+			}
+
+			if (data != expect || (data != nullptr && !zeroed(data, block_size))) {
+				printf("mem_manager: op %u: allocating %u B returned %p instead of %p\n", op,
+				       from_pool ? LIFO_SIZE : size, data, expect);
+				return false;
+			}
+
+			if (data != nullptr) {
+				s_live[s_live_count] = {data, block_size, (uint8_t)op};
+				memset(data, s_live[s_live_count].tag, block_size);
+				s_live_count++;
+			}
+
+		} else if (kind < 75 && s_live_count > 0) {
+			const uint32_t n = next_random() % s_live_count;
+
+			if (MEM_BufferFree(s_live[n].data) != kStatus_MemSuccess) {
+				printf("mem_manager: op %u: freeing %p failed\n", op, s_live[n].data);
+				return false;
+			}
+
+			model_free(s_live[n]);
+			s_live[n] = s_live[--s_live_count];
+
+		} else if (kind < 95 && s_live_count > 0) {
+			// Grown into a larger pool or kept, the old data moves along
+			Buffer &buffer = s_live[next_random() % s_live_count];
+			uint8_t *expect = buffer.data;
+			uint32_t block_size = buffer.size;
+
+			if (size > buffer.size) {
+				expect = model_alloc(size, block_size);
+
+				if (expect != nullptr) {
+					model_free(buffer);
+				}
+			}
+
+			uint8_t *data = (uint8_t *)MEM_BufferRealloc(buffer.data, size);
+
+			if (data != expect) {
+				printf("mem_manager: op %u: reallocating %p to %u B returned %p instead of %p\n", op,
+				       buffer.data, size, data, expect);
+				return false;
+			}
+
+			if (data != nullptr) {
+				for (uint32_t j = 0; j < buffer.size; j++) {
+					if (data[j] != buffer.tag) {
+						printf("mem_manager: op %u: reallocation to %p lost the data\n", op, data);
+						return false;
+					}
+				}
+
+				buffer = {data, block_size, (uint8_t)op};
+				memset(data, buffer.tag, block_size);
+			}
+
+		} else if (kind == 99) {
+			if (!check_statistics("reset", (uint16_t)(LIFO_BLOCKS - s_lifo_free_count), s_lifo_max, s_lifo_failures,
+					      true)) {
+				return false;
+			}
+
+			s_lifo_max = (uint16_t)(LIFO_BLOCKS - s_lifo_free_count);
+			s_lifo_failures = 0;
+		}
+
+		if (!check_live(op)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+int main()
+{
+	if (MEM_AddBuffer(MEM_BLOCK_BUFFER(lifo)) != kStatus_MemSuccess ||
+	    MEM_AddBuffer(MEM_BLOCK_BUFFER(search)) != kStatus_MemSuccess) {
+		printf("mem_manager: adding the pools failed\n");
+		return 1;
+	}
+
+	if (!check_order() || !check_search() || !check_random()) {
+		return 1;
+	}
+
+	printf("mem_manager: ok\n");
+	return 0;
+}
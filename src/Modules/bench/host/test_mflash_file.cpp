@@ -0,0 +1,344 @@
+#include "MflashNorSim.hpp"
+
+extern "C" {
+#include "mflash_file.h"
+}
+
+#include <stdio.h>
+#include <string.h>
+
+// Host test of the mflash file writer on a simulated 128 KiB NOR flash
+// (MflashNorSim) with 256 B pages and 4 KiB sectors. Files are checked
+// against the data they were given: sizes around the page, meta and sector
+// boundaries, written whole, in pages or in unaligned random chunks,
+// appended and rewritten, up to the end of the area, interrupted and with
+// the flash failing at random points, and copied from another file in the
+// memory mapped flash. Returns non-zero on the first mismatch.
+
+static constexpr uint32_t FLASH_SIZE = 128 * 1024;
+static constexpr uint32_t META_SIZE = 8; // mflash_file_meta_t
+static constexpr uint32_t HEAD_SIZE = MFLASH_PAGE_SIZE - META_SIZE;
+static constexpr uint32_t CHECK_CHUNK_MAX = 700;
+static constexpr unsigned int CHECK_POWER_LOSSES = 200;
+
+static const mflash_file_t TEMPLATE[] = {
+	{"small", 1000},
+	{"edge", MFLASH_SECTOR_SIZE},
+	{"big", 40000},
+	{"copy", 64 * 1024},
+	{nullptr, 0},
+};
+
+static MflashNorSim s_flash;
+static uint32_t s_seed = 1;
+
+// One byte more than the largest file, to write from unaligned addresses
+alignas(4) static uint8_t s_data[64 * 1024 + 4];
+static uint8_t s_previous[40 * 1024];
+static uint32_t s_previous_size = 0;
+
+static uint32_t next_random()
+{
+	s_seed = s_seed * 1103515245 + 12345;
+	return s_seed >> 8;
+}
+
+enum Chunks {
+	CHUNKS_WHOLE,      // one write
+	CHUNKS_PAGES,      // aligned pages and the rest
+	CHUNKS_RANDOM,     // 1 to CHECK_CHUNK_MAX bytes from unaligned addresses
+	CHUNKS_COUNT,
+};
+
+static bool init_flash()
+{
+	if (!s_flash.init(FLASH_SIZE)) {
+		return false;
+	}
+
+	return mflash_init(TEMPLATE, true) == kStatus_Success;
+}
+
+static void fill(uint8_t *data, uint32_t size)
+{
+	for (uint32_t i = 0; i < size; i++) {
+		data[i] = (uint8_t)next_random();
+	}
+}
+
+static status_t write_chunks(mflash_file_writer_t *writer, const uint8_t *data, uint32_t size, Chunks chunks)
+{
+	status_t status = kStatus_Success;
+
+	for (uint32_t off = 0; off < size && status == kStatus_Success;) {
+		uint32_t n = size - off;
+
+		if (chunks == CHUNKS_PAGES) {
+			n = n < MFLASH_PAGE_SIZE ? n : MFLASH_PAGE_SIZE;
+
+		} else if (chunks == CHUNKS_RANDOM) {
+			const uint32_t r = 1 + next_random() % CHECK_CHUNK_MAX;
+			n = n < r ? n : r;
+		}
+
+		status = mflash_file_writer_write(writer, &data[off], n);
+		off += n;
+	}
+
+	return status;
+}
+
+static bool verify_file(const char *path, const uint8_t *expect, uint32_t size)
+{
+	const uint8_t *data;
+	uint32_t n;
+
+	if (mflash_file_mmap(path, &data, &n) != kStatus_Success) {
+		printf("mflash_file: %s is not valid\n", path);
+		return false;
+	}
+
+	if (n != size) {
+		printf("mflash_file: %s holds %u bytes instead of the %u written\n", path, (unsigned)n, (unsigned)size);
+		return false;
+	}
+
+	if (memcmp(data, expect, size) != 0) {
+		printf("mflash_file: %s of %u bytes doesn't hold the data written\n", path, (unsigned)size);
+		return false;
+	}
+
+	return true;
+}
+
+// Each sector under the file is erased once, none further than the erase-ahead
+static bool check_erases(const char *path, uint32_t file_offset, uint32_t alloc_size, uint32_t size)
+{
+	const uint32_t used = (size + META_SIZE + MFLASH_PAGE_SIZE - 1) / MFLASH_PAGE_SIZE * MFLASH_PAGE_SIZE;
+	const uint32_t end = (used > MFLASH_PAGE_SIZE ? used : MFLASH_PAGE_SIZE) + MFLASH_FILE_ERASE_AHEAD;
+
+	for (uint32_t off = 0; off < alloc_size; off += MFLASH_SECTOR_SIZE) {
+		const uint32_t erases = s_flash.erases(file_offset + off);
+
+		if (erases > 1 || (off < used && erases == 0) || (off >= end && erases != 0)) {
+			printf("mflash_file: %s of %u bytes erased the sector at %u %u times\n", path, (unsigned)size,
+			       (unsigned)off, (unsigned)erases);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static bool check_write(const char *path, uint32_t size, Chunks chunks)
+{
+	const uint8_t *data = &s_data[chunks == CHUNKS_RANDOM ? 1 : 0];
+	mflash_file_writer_t writer;
+	status_t status;
+
+	fill((uint8_t *)data, size);
+	s_flash.reset_stats();
+	status = mflash_file_writer_open(&writer, path);
+
+	if (status == kStatus_Success) {
+		status = write_chunks(&writer, data, size, chunks);
+	}
+
+	if (status == kStatus_Success) {
+		status = mflash_file_writer_close(&writer);
+	}
+
+	if (status != kStatus_Success) {
+		printf("mflash_file: writing %u bytes to %s failed: %d\n", (unsigned)size, path, (int)status);
+		return false;
+	}
+
+	if (s_flash.stats().violations != 0) {
+		printf("mflash_file: %s of %u bytes programmed %u pages that were not blank\n", path, (unsigned)size,
+		       (unsigned)s_flash.stats().violations);
+		return false;
+	}
+
+	if (!verify_file(path, data, size) || !check_erases(path, writer.file_offset, writer.alloc_size, size)) {
+		return false;
+	}
+
+	if (strcmp(path, "big") == 0) {
+		memcpy(s_previous, data, size);
+		s_previous_size = size;
+	}
+
+	return true;
+}
+
+static bool check_sizes()
+{
+	static const uint32_t sizes[] = {
+		0, 1, 4, HEAD_SIZE - 1, HEAD_SIZE, HEAD_SIZE + 1, HEAD_SIZE + 4, MFLASH_PAGE_SIZE,
+		HEAD_SIZE + MFLASH_PAGE_SIZE, HEAD_SIZE + MFLASH_PAGE_SIZE + 1, MFLASH_SECTOR_SIZE - META_SIZE - 1,
+		MFLASH_SECTOR_SIZE - META_SIZE, MFLASH_SECTOR_SIZE - META_SIZE + 1, MFLASH_SECTOR_SIZE,
+		2 * MFLASH_SECTOR_SIZE - META_SIZE, 2 * MFLASH_SECTOR_SIZE + 100, 20000,
+		10 * MFLASH_SECTOR_SIZE - META_SIZE,
+	};
+
+	// Every size rewrites the file left by the one before
+	for (uint32_t chunks = 0; chunks < CHUNKS_COUNT; chunks++) {
+		for (uint32_t size : sizes) {
+			if (!check_write("big", size, (Chunks)chunks)) {
+				return false;
+			}
+		}
+	}
+
+	// Whole area of a single sector file
+	return check_write("edge", MFLASH_SECTOR_SIZE - META_SIZE, CHUNKS_RANDOM) &&
+	       check_write("small", 1000, CHUNKS_PAGES);
+}
+
+static bool check_limits()
+{
+	const uint32_t max = MFLASH_SECTOR_SIZE - META_SIZE;
+	mflash_file_writer_t writer;
+
+	fill(s_data, max + 1);
+
+	// Too large at once, or one byte past the end, is refused without
+	// losing what was written
+	if (mflash_file_writer_open(&writer, "edge") != kStatus_Success ||
+	    mflash_file_writer_write(&writer, s_data, max + 1) != kStatus_OutOfRange ||
+	    mflash_file_writer_write(&writer, s_data, max) != kStatus_Success ||
+	    mflash_file_writer_write(&writer, &s_data[max], 1) != kStatus_OutOfRange ||
+	    mflash_file_writer_close(&writer) != kStatus_Success) {
+		printf("mflash_file: writing past the end of edge isn't refused\n");
+		return false;
+	}
+
+	if (!verify_file("edge", s_data, max)) {
+		return false;
+	}
+
+	// A closed writer and unknown files are refused
+	if (mflash_file_writer_write(&writer, s_data, 1) != kStatus_InvalidArgument ||
+	    mflash_file_writer_close(&writer) != kStatus_InvalidArgument ||
+	    mflash_file_writer_open(&writer, "none") == kStatus_Success) {
+		printf("mflash_file: closed writer or unknown file accepted\n");
+		return false;
+	}
+
+	return true;
+}
+
+// A rewrite invalidates the file once its first sector is erased, and the
+// file is valid again only once it is closed. Interrupted before that
+// erase, the file keeps its previous content.
+static bool check_interrupted()
+{
+	const uint8_t *data;
+	uint32_t size;
+
+	for (unsigned int n = 0; n < CHECK_POWER_LOSSES; n++) {
+		const uint32_t length = next_random() % (10 * MFLASH_SECTOR_SIZE - META_SIZE);
+		mflash_file_writer_t writer;
+		status_t status;
+
+		fill(s_data, length);
+
+		if (n % 4 == 0) {
+			// Abandoned without closing
+			status = mflash_file_writer_open(&writer, "big");
+
+			if (status == kStatus_Success) {
+				status = write_chunks(&writer, s_data, length / 2, CHUNKS_RANDOM);
+			}
+
+		} else {
+			// Power loss at a random program or erase
+			s_flash.fail_after(next_random() % (length / MFLASH_PAGE_SIZE + 4));
+			status = mflash_file_writer_open(&writer, "big");
+
+			if (status == kStatus_Success) {
+				status = write_chunks(&writer, s_data, length, CHUNKS_RANDOM);
+			}
+
+			if (status == kStatus_Success) {
+				status = mflash_file_writer_close(&writer);
+			}
+
+			s_flash.fail_never();
+		}
+
+		if (status == kStatus_Success && n % 4 != 0) {
+			if (!verify_file("big", s_data, length)) {
+				return false;
+			}
+
+		} else if (mflash_file_mmap("big", &data, &size) == kStatus_Success &&
+			   (size != s_previous_size || memcmp(data, s_previous, size) != 0)) {
+			printf("mflash_file: big is valid after an interrupted write of %u bytes\n", (unsigned)length);
+			return false;
+		}
+
+		// The next write recovers the file
+		if (!check_write("big", length, CHUNKS_RANDOM)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// Whole pages of another file are read from the memory mapped flash, which
+// can't be programmed from, and go through the page buffer
+static bool check_xip()
+{
+	const uint32_t size = 3 * MFLASH_SECTOR_SIZE + 100;
+	const uint8_t *data;
+	uint32_t n;
+
+	if (!check_write("big", size, CHUNKS_WHOLE) || mflash_file_mmap("big", &data, &n) != kStatus_Success) {
+		return false;
+	}
+
+	for (uint32_t chunks = CHUNKS_WHOLE; chunks <= CHUNKS_PAGES; chunks++) {
+		mflash_file_writer_t writer;
+		status_t status;
+
+		s_flash.reset_stats();
+		status = mflash_file_writer_open(&writer, "copy");
+
+		if (status == kStatus_Success) {
+			status = write_chunks(&writer, data, n, (Chunks)chunks);
+		}
+
+		if (status == kStatus_Success) {
+			status = mflash_file_writer_close(&writer);
+		}
+
+		if (status != kStatus_Success || s_flash.stats().xip_sources != 0) {
+			printf("mflash_file: copying big failed: %d, %u programs from the flash\n", (int)status,
+			       (unsigned)s_flash.stats().xip_sources);
+			return false;
+		}
+
+		if (!verify_file("copy", s_previous, size)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+int main()
+{
+	if (!init_flash()) {
+		printf("mflash_file: formatting the flash failed\n");
+		return 1;
+	}
+
+	if (!check_sizes() || !check_limits() || !check_interrupted() || !check_xip()) {
+		return 1;
+	}
+
+	printf("mflash_file: ok\n");
+	return 0;
+}
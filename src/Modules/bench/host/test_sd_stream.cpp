@@ -0,0 +1,254 @@
+#include "SdCardSim.hpp"
+
+extern "C" {
+#include "fsl_sd_stream.h"
+}
+
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+
+// Host test of SD card streaming (fsl_sd_stream.c) on a simulated 2 MiB
+// card (SdCardSim) behind a uSDHC host with 16 ADMA2 descriptors and 256
+// blocks per transfer, failing one in 50 data transfers. Random write and
+// read streams of up to 1024 blocks are queued in chunks from contiguous
+// and separate buffers, with and without a fixed transfer size, resuming
+// from where the stream ends after each error. Reads and the card image
+// are compared against a model, and the statistics of the streams against
+// the commands, blocks and errors the card saw. This runs with and without
+// CMD23, and misaligned buffers and blocks past the end of the card must be
+// refused. Returns non-zero on the first mismatch.
+
+static constexpr uint32_t BLOCK_SIZE = 512;
+static constexpr uint32_t CARD_BLOCKS = 4096;
+static constexpr uint32_t MAX_BLOCK_COUNT = 256;
+static constexpr uint32_t DESCRIPTOR_WORDS = 32;
+static constexpr uint32_t FAIL_RATE = 50;
+static constexpr uint32_t STREAMS = 300;
+static constexpr uint32_t STREAM_BLOCKS = 1024;
+static constexpr uint32_t CHUNK_BLOCKS = 300;
+static constexpr uint32_t RETRIES = 100;
+
+struct Chunk {
+	uint8_t *buffer;
+	uint32_t block;
+	uint32_t blocks;
+};
+
+static SdCardSim s_sim;
+static sd_card_t s_card;
+static uint8_t s_model[CARD_BLOCKS * BLOCK_SIZE];
+alignas(4) static uint8_t s_pool[2 * STREAM_BLOCKS * BLOCK_SIZE];
+static Chunk s_chunks[STREAM_BLOCKS];
+static uint32_t s_seed = 1;
+
+static uint32_t next_random()
+{
+	s_seed = s_seed * 1103515245 + 12345;
+	return s_seed >> 8;
+}
+
+static uint32_t timestamp()
+{
+	return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(
+		       std::chrono::steady_clock::now().time_since_epoch())
+		.count();
+}
+
+static bool init_card(bool cmd23, uint32_t seed)
+{
+	if (!s_sim.init(CARD_BLOCKS, cmd23, MAX_BLOCK_COUNT, DESCRIPTOR_WORDS, FAIL_RATE, seed)) {
+		return false;
+	}
+
+	memset(&s_card, 0, sizeof(s_card));
+	s_card.host = s_sim.host();
+	s_card.relativeAddress = 1;
+	s_card.blockCount = CARD_BLOCKS;
+	s_card.blockSize = BLOCK_SIZE;
+	s_card.flags = kSD_SupportHighCapacityFlag | (cmd23 ? kSD_SupportSetBlockCountCmd : 0);
+	return true;
+}
+
+// Retransfer what the stream kept after an error until it succeeds
+static status_t recover(sd_stream_t *stream, status_t error)
+{
+	for (uint32_t retry = 0; error == kStatus_SDMMC_TransferFailed && retry < RETRIES; retry++) {
+		error = SD_StreamFlush(stream);
+	}
+
+	return error;
+}
+
+// Queue a chunk, resuming after errors from where the stream ends. A queue
+// of transferBlocks must have been transferred.
+static status_t queue(sd_stream_t *stream, const Chunk &chunk)
+{
+	const uint32_t end = chunk.block + chunk.blocks;
+	uint32_t block = chunk.block;
+
+	while (block < end) {
+		uint8_t *buffer = chunk.buffer + (size_t)(block - chunk.block) * BLOCK_SIZE;
+		status_t error = stream->direction == kSD_StreamWrite
+					 ? SD_StreamWrite(stream, buffer, end - block)
+					 : SD_StreamRead(stream, buffer, end - block);
+
+		if (error == kStatus_Success) {
+			break;
+		}
+
+		// The stream ends where the chunk was queued up to
+		error = recover(stream, error);
+
+		if (error != kStatus_Success || stream->nextBlock < block || stream->nextBlock > end) {
+			return kStatus_Fail;
+		}
+
+		block = stream->nextBlock;
+	}
+
+	return stream->queuedBlocks < stream->transferBlocks ? kStatus_Success : kStatus_Fail;
+}
+
+static bool check_stream(bool cmd23, uint32_t seed)
+{
+	sd_stream_t stream;
+	sd_stream_statistics_t stats;
+	sd_stream_statistics_t total{};
+	uint32_t histogram = 0;
+
+	if (!init_card(cmd23, seed)) {
+		printf("sd_stream: out of memory\n");
+		return false;
+	}
+
+	s_seed = seed;
+	memset(s_model, 0xff, sizeof(s_model));
+
+	for (uint32_t n = 0; n < STREAMS; n++) {
+		const bool write = next_random() % 2 == 0;
+		const uint32_t start = next_random() % CARD_BLOCKS;
+		const uint32_t transfer_blocks = next_random() % 3 == 0 ? 0 : 1 + next_random() % MAX_BLOCK_COUNT;
+		uint32_t blocks = 1 + next_random() % STREAM_BLOCKS;
+		uint32_t chunks = 0;
+		uint32_t offset = 0;
+		status_t error;
+
+		blocks = blocks < CARD_BLOCKS - start ? blocks : CARD_BLOCKS - start;
+
+		if (SD_StreamStart(&s_card, &stream, write ? kSD_StreamWrite : kSD_StreamRead, start, transfer_blocks) !=
+		    kStatus_Success) {
+			printf("sd_stream: starting stream %u failed\n", n);
+			return false;
+		}
+
+		SD_StreamInstallTimestamp(&stream, timestamp);
+
+		// Contiguous and separate buffers of the pool, some of them taking
+		// more than one descriptor
+		for (uint32_t block = start; block < start + blocks; chunks++) {
+			Chunk &chunk = s_chunks[chunks];
+
+			offset += next_random() % 2;
+			chunk.buffer = &s_pool[(size_t)offset * BLOCK_SIZE];
+			chunk.block = block;
+			chunk.blocks = 1 + next_random() % CHUNK_BLOCKS;
+			chunk.blocks = chunk.blocks < start + blocks - block ? chunk.blocks : start + blocks - block;
+
+			if (write) {
+				for (uint32_t i = 0; i < chunk.blocks * BLOCK_SIZE; i += 4) {
+					const uint32_t word = next_random();
+					memcpy(&chunk.buffer[i], &word, 4);
+				}
+
+				memcpy(&s_model[(size_t)block * BLOCK_SIZE], chunk.buffer, chunk.blocks * BLOCK_SIZE);
+			}
+
+			error = queue(&stream, chunk);
+
+			if (error != kStatus_Success) {
+				printf("sd_stream: queuing %u blocks at %u failed: %d\n", chunk.blocks, block, (int)error);
+				return false;
+			}
+
+			offset += chunk.blocks;
+			block += chunk.blocks;
+		}
+
+		error = recover(&stream, SD_StreamStop(&stream));
+
+		if (error != kStatus_Success || stream.nextBlock != start + blocks) {
+			printf("sd_stream: stopping stream %u failed: %d\n", n, (int)error);
+			return false;
+		}
+
+		for (uint32_t i = 0; !write && i < chunks; i++) {
+			const Chunk &chunk = s_chunks[i];
+
+			if (memcmp(chunk.buffer, &s_model[(size_t)chunk.block * BLOCK_SIZE], chunk.blocks * BLOCK_SIZE) != 0) {
+				printf("sd_stream: read %u blocks at %u don't match\n", chunk.blocks, chunk.block);
+				return false;
+			}
+		}
+
+		SD_StreamGetStatistics(&stream, &stats, true);
+		total.transfers += stats.transfers;
+		total.blocks += stats.blocks;
+		total.commands += stats.commands;
+		total.errors += stats.errors;
+
+		for (uint32_t i = 0; i < SD_STREAM_LATENCY_BUCKETS; i++) {
+			histogram += stats.latencyHistogram[i];
+		}
+	}
+
+	const SdCardSim::Stats &card = s_sim.stats();
+
+	if (card.violations != 0 || card.commands != total.commands ||
+	    card.blocks_written + card.blocks_read != total.blocks || card.failures != total.errors ||
+	    histogram != total.transfers || total.errors == 0) {
+		printf("sd_stream: %u violations, %u/%u commands, %u/%u blocks, %u/%u errors, %u/%u transfers\n",
+		       card.violations, card.commands, total.commands, card.blocks_written + card.blocks_read,
+		       total.blocks, card.failures, total.errors, histogram, total.transfers);
+		return false;
+	}
+
+	if (memcmp(s_sim.image(), s_model, sizeof(s_model)) != 0) {
+		printf("sd_stream: card doesn't match the model\n");
+		return false;
+	}
+
+	// Misaligned buffers are refused
+	if (SD_StreamStart(&s_card, &stream, kSD_StreamWrite, 0, 0) != kStatus_Success ||
+	    SD_StreamWrite(&stream, &s_pool[1], 1) != kStatus_InvalidArgument) {
+		printf("sd_stream: misaligned buffer accepted\n");
+		return false;
+	}
+
+	// So are blocks past the end of the card, counting those queued
+	if (SD_StreamStart(&s_card, &stream, kSD_StreamRead, CARD_BLOCKS - 8, 0) != kStatus_Success ||
+	    SD_StreamRead(&stream, s_pool, 6) != kStatus_Success ||
+	    SD_StreamRead(&stream, &s_pool[6 * BLOCK_SIZE], 3) != kStatus_InvalidArgument ||
+	    recover(&stream, SD_StreamStop(&stream)) != kStatus_Success) {
+		printf("sd_stream: blocks past the end accepted\n");
+		return false;
+	}
+
+	return true;
+}
+
+int main()
+{
+	if (!check_stream(true, 1)) {
+		printf("sd_stream: with CMD23 failed\n");
+		return 1;
+	}
+
+	if (!check_stream(false, 2)) {
+		printf("sd_stream: without CMD23 failed\n");
+		return 1;
+	}
+
+	printf("sd_stream: ok\n");
+	return 0;
+}
@@ -0,0 +1,319 @@
+#include "RttTransport.hpp"
+#include "Telemetry.hpp"
+#include "TelemetryStream.hpp"
+
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+// Host test of the telemetry writer and of the stream decoder of
+// telemetry_decode (StreamDecoder).
+//
+// The round trip publishes three topics through the writer and an RTT
+// up-buffer drained the way the debug probe would: every published frame
+// decodes to its topic, seq, timestamp and payload, the topics are named,
+// and on a capture that starts in the middle of a frame, has a corrupted
+// frame and misses one, the decoder resyncs, returns all intact frames and
+// counts exactly the missing ones as lost.
+//
+// The writer checks, on a transport that fails on demand and publishes from
+// inside its write as an interrupt would, that a frame that wasn't written
+// doesn't count for the rate limit, and that only a publish of the same
+// topic is dropped as busy while another topic goes through. Returns
+// non-zero on the first mismatch.
+
+static constexpr unsigned RTT_INDEX = 2;
+static constexpr unsigned FRAMES = 1200;
+
+struct Published {
+	uint8_t topic;
+	uint8_t seq;
+	uint32_t timestamp;
+	uint8_t payload_len;
+	uint8_t payload[telemetry::MAX_PAYLOAD];
+	size_t start;      // span of the publish in the stream, with its announcement
+	size_t end;
+};
+
+static uint8_t s_rtt_buffer[4096];
+static std::vector<uint8_t> s_stream;
+static std::vector<Published> s_published;
+static uint32_t s_seed = 1;
+
+static uint32_t next_random()
+{
+	s_seed = s_seed * 1103515245 + 12345;
+	return s_seed >> 8;
+}
+
+static void drain()
+{
+	uint8_t buffer[256];
+	unsigned n;
+
+	while ((n = SEGGER_RTT_ReadUpBufferNoLock(RTT_INDEX, buffer, sizeof(buffer))) > 0) {
+		s_stream.insert(s_stream.end(), buffer, buffer + n);
+	}
+}
+
+static bool capture()
+{
+	static telemetry::RttTransport transport(RTT_INDEX, "TelemetryCheck", s_rtt_buffer, sizeof(s_rtt_buffer));
+	telemetry::Writer writer(transport);
+	telemetry::Topic topics[] = {
+		telemetry::Topic("estimator", 1),
+		telemetry::Topic("imu", 2),
+		telemetry::Topic("a_rather_long_status_topic_name", 200),
+	};
+
+	if (!transport.init()) {
+		return false;
+	}
+
+	s_stream.clear();
+	s_published.clear();
+	s_seed = 1;
+
+	for (unsigned n = 0; n < FRAMES; n++) {
+		// Mostly the first topic, so that its seq wraps and it is announced again
+		const uint32_t r = next_random() % 8;
+		telemetry::Topic &topic = topics[r < 5 ? 0 : r < 7 ? 1 : 2];
+		Published p{};
+
+		p.topic = topic.id();
+		p.seq = (uint8_t)topic.sent();
+		p.timestamp = n * 250;
+		p.payload_len = topic.id() == 1 ? 64 : (uint8_t)(next_random() % (telemetry::MAX_PAYLOAD + 1));
+
+		// Zeros and random bytes, COBS has to escape the zeros
+		for (unsigned i = 0; i < p.payload_len; i++) {
+			p.payload[i] = next_random() % 4 == 0 ? 0 : (uint8_t)next_random();
+		}
+
+		p.start = s_stream.size();
+
+		if (!writer.publish(topic, p.payload, p.payload_len, p.timestamp)) {
+			printf("telemetry_stream: publishing frame %u failed\n", n);
+			return false;
+		}
+
+		drain();
+		p.end = s_stream.size();
+		s_published.push_back(p);
+	}
+
+	return true;
+}
+
+static bool same(const telemetry::Frame &frame, const Published &p)
+{
+	return frame.topic == p.topic && frame.seq == p.seq && frame.timestamp == p.timestamp &&
+	       frame.payload_len == p.payload_len && memcmp(frame.payload, p.payload, p.payload_len) == 0;
+}
+
+/* @brief Decode a capture and compare it to the published frames
+ *
+ * @param skip Published frames that are not in the capture, by index.
+ * @param lost Frames of each topic counted as lost, in the order of
+ *             checked_topics.
+ */
+static bool check_decode(const char *what, const std::vector<uint8_t> &stream, const std::vector<unsigned> &skip,
+			 const uint32_t lost[3])
+{
+	static const uint8_t checked_topics[] = {1, 2, 200};
+	static const char *const names[] = {"estimator", "imu", "a_rather_long_status_topic_name"};
+	telemetry::StreamDecoder decoder;
+	telemetry::Frame frame;
+	size_t next = 0;
+
+	for (uint8_t byte : stream) {
+		if (!decoder.push(byte, frame)) {
+			continue;
+		}
+
+		while (next < s_published.size() && std::find(skip.begin(), skip.end(), next) != skip.end()) {
+			next++;
+		}
+
+		if (next == s_published.size() || !same(frame, s_published[next])) {
+			printf("telemetry_stream: %s: frame %u decoded as topic %u seq %u\n", what, (unsigned)next,
+			       frame.topic, frame.seq);
+			return false;
+		}
+
+		next++;
+	}
+
+	while (next < s_published.size() && std::find(skip.begin(), skip.end(), next) != skip.end()) {
+		next++;
+	}
+
+	if (next != s_published.size()) {
+		printf("telemetry_stream: %s: %u of %u frames decoded\n", what, (unsigned)next,
+		       (unsigned)s_published.size());
+		return false;
+	}
+
+	for (unsigned i = 0; i < 3; i++) {
+		const telemetry::StreamDecoder::TopicStats &t = decoder.topic(checked_topics[i]);
+
+		if (strcmp(decoder.topic_name(checked_topics[i]), names[i]) != 0 || t.lost != lost[i]) {
+			printf("telemetry_stream: %s: topic %u named %s, %u lost instead of %u\n", what, checked_topics[i],
+			       decoder.topic_name(checked_topics[i]), (unsigned)t.lost, (unsigned)lost[i]);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// Index of the first publish of the topic from the given one on, with no
+// announcement in its span
+static unsigned find_frame(unsigned from, uint8_t topic)
+{
+	while (s_published[from].topic != topic || s_published[from].seq == 0) {
+		from++;
+	}
+
+	return from;
+}
+
+static bool check_round_trip()
+{
+	static const uint32_t none[3] = {0, 0, 0};
+
+	if (!check_decode("clean", s_stream, {}, none)) {
+		return false;
+	}
+
+	// Attach 3 bytes into the first announcement, corrupt a frame of the
+	// second topic and miss a frame of the third. The first topic is named
+	// by its announcement on the seq wrap, the first frame is intact.
+	const unsigned corrupt = find_frame(100, 2);
+	const unsigned missing = find_frame(400, 200);
+	std::vector<uint8_t> damaged(s_stream.begin() + 3, s_stream.end());
+	const uint32_t lost[3] = {0, 1, 1};
+	uint8_t &byte = damaged[s_published[corrupt].end - 3 - 3];
+
+	// Any change is caught by the crc, keep the delimiters where they are
+	byte ^= byte == 0x80 ? 0x40 : 0x80;
+	damaged.erase(damaged.begin() + (s_published[missing].start - 3),
+		      damaged.begin() + (s_published[missing].end - 3));
+
+	return check_decode("damaged", damaged, {corrupt, missing}, lost);
+}
+
+// Writer
+
+// Counts the frames it takes, fails while failing is set and runs nested
+// once from inside the next write, as an interrupt would.
+class CheckTransport : public telemetry::Transport
+{
+public:
+	bool write(const uint8_t *data, size_t len) override
+	{
+		if (nested != nullptr) {
+			void (*run)() = nested;
+			nested = nullptr;
+			run();
+		}
+
+		if (failing) {
+			return false;
+		}
+
+		frames++;
+		return true;
+	}
+
+	bool failing{false};
+	void (*nested)(){nullptr};
+	unsigned frames{0};
+};
+
+static CheckTransport s_transport;
+static telemetry::Writer s_writer(s_transport);
+static telemetry::Topic s_limited("limited", 1, 100);
+static telemetry::Topic s_other("other", 2);
+static bool s_nested_published;
+
+static bool publish(telemetry::Topic &topic, uint32_t timestamp)
+{
+	const uint8_t sample[4] = {1, 2, 3, 4};
+	return s_writer.publish(topic, sample, sizeof(sample), timestamp);
+}
+
+static bool check_rate_limit()
+{
+	// Announcement and first frame at 0, the next one due at 100
+	if (!publish(s_limited, 0) || publish(s_limited, 50) || s_limited.rate_limited() != 1) {
+		printf("telemetry: rate limit of the first frames wrong\n");
+		return false;
+	}
+
+	// Dropped by the transport at 100, so the sample at 150 is still due
+	s_transport.failing = true;
+
+	if (publish(s_limited, 100) || s_limited.dropped() != 1) {
+		printf("telemetry: failed write not reported\n");
+		return false;
+	}
+
+	s_transport.failing = false;
+
+	if (!publish(s_limited, 150) || publish(s_limited, 200) || !publish(s_limited, 250)) {
+		printf("telemetry: failed write held back the rate limit, %u rate limited\n",
+		       (unsigned)s_limited.rate_limited());
+		return false;
+	}
+
+	if (s_limited.sent() != 3 || s_limited.rate_limited() != 2 || s_transport.frames != 4) {
+		printf("telemetry: %u sent, %u rate limited, %u frames instead of 3, 2, 4\n", (unsigned)s_limited.sent(),
+		       (unsigned)s_limited.rate_limited(), s_transport.frames);
+		return false;
+	}
+
+	return true;
+}
+
+static bool check_busy()
+{
+	const uint32_t other_sent = s_other.sent();
+
+	// Another topic published in the middle of a write goes through
+	s_transport.nested = [] { s_nested_published = publish(s_other, 1000); };
+
+	if (!publish(s_limited, 1000) || !s_nested_published || s_other.sent() != other_sent + 1 ||
+	    s_other.busy_drops() != 0 || s_limited.busy_drops() != 0) {
+		printf("telemetry: another topic published during a write was dropped\n");
+		return false;
+	}
+
+	// The same topic is dropped and counted as busy, the interrupted frame is written
+	s_transport.nested = [] { s_nested_published = publish(s_limited, 2000); };
+
+	if (!publish(s_limited, 1500) || s_nested_published || s_limited.busy_drops() != 1 ||
+	    s_limited.rate_limited() != 2) {
+		printf("telemetry: nested publish of the same topic not dropped as busy\n");
+		return false;
+	}
+
+	// The busy drop doesn't count for the rate limit either
+	return publish(s_limited, 1600);
+}
+
+int main()
+{
+	if (!capture()) {
+		printf("telemetry_stream: capturing the stream failed\n");
+		return 1;
+	}
+
+	if (!check_round_trip() || !check_rate_limit() || !check_busy()) {
+		return 1;
+	}
+
+	printf("telemetry: ok\n");
+	return 0;
+}
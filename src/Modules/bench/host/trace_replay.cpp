@@ -0,0 +1,478 @@
+// Replays file I/O traces (Trace.hpp) on the filesystems of middleware/,
+// each on the flash it would sit on in a product, and compares them.
+//
+//   trace_replay [-f fs,...] [-d dir] [-s scale] [-T] trace...
+//   trace_replay -g trace
+//
+//   -f  filesystems to replay on, all by default:
+//         littlefs        littlefs on QSPI NOR flash
+//         littlefs_cache  the same with the block cache and free block map
+//         fatfs           FatFs as shipped on an SD card
+//         fatfs_cache     FatFs with the sector cache and cluster runs
+//         fatfs_dhara     fatfs_cache on dhara on SLC NAND flash
+//   -d  keep the device images in files in dir, instead of in RAM
+//   -s  scale of the generated traces
+//   -T  no device timing, latencies are the time spent in the filesystem
+//   -g  print a generated trace, as a template for recorded ones
+//
+// A trace is the name of a generated trace (logger, config or assets) or a
+// trace file. The devices are 16 MiB and formatted before each replay. An
+// operation takes the time spent in the filesystem plus the time the
+// device would have taken for the requests it made (SimBlockDevice).
+//
+//   MB/s   file data written and read per second of operations
+//   WA     bytes programmed into the device per byte written to files
+//   erases block erases
+//   wear   erases of the most erased block on raw flash, on managed
+//          devices the bytes programmed into the most programmed erase
+//          block, in erase blocks, which its own FTL has to spread
+//   p50..  latency of the operations
+//
+// Reads are checked against what the trace wrote, and every file is read
+// back after remounting at the end of the replay.
+
+#include "BlockDevice.hpp"
+#include "Trace.hpp"
+#include "TraceFs.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static constexpr uint32_t KiB = 1024;
+static constexpr uint32_t MiB = 1024 * 1024;
+
+// W25Q128JV class QSPI NOR, 4 KiB sectors
+static constexpr BlockDevice::Geometry NOR = {16, 256, 4 * KiB, 4096, true};
+static constexpr SimBlockDevice::Timing NOR_TIMING = {1, 400, 45000, 0, 10};
+
+// SD card on 4-bit SDR50, as SdCardSim without overlap
+static constexpr BlockDevice::Geometry SD = {512, 512, 64 * KiB, 256, false};
+static constexpr SimBlockDevice::Timing SD_TIMING = {100, 20, 0, 300, 20};
+
+// SLC NAND, 2 KiB pages, 64 pages per block, as bench_dhara_map.cpp
+static constexpr BlockDevice::Geometry NAND = {1, 2 * KiB, 128 * KiB, 128, true};
+static constexpr SimBlockDevice::Timing NAND_TIMING = {25, 200, 2000, 0, 25};
+
+struct FsConfig {
+	const char *name;
+	const char *device;
+	const BlockDevice::Geometry *geometry;
+	const SimBlockDevice::Timing *timing;
+	TraceFs *(*create)(BlockDevice *device);
+};
+
+static TraceFs *create_littlefs(BlockDevice *device) { return trace_fs_littlefs(device, false); }
+static TraceFs *create_littlefs_cache(BlockDevice *device) { return trace_fs_littlefs(device, true); }
+static TraceFs *create_fatfs(BlockDevice *device) { return trace_fs_fatfs(device, &fatfs_win1); }
+static TraceFs *create_fatfs_cache(BlockDevice *device) { return trace_fs_fatfs(device, &fatfs_cache); }
+static TraceFs *create_fatfs_dhara(BlockDevice *device) { return trace_fs_fatfs_dhara(device, &fatfs_cache); }
+
+static const FsConfig FS_CONFIGS[] = {
+	{"littlefs", "nor", &NOR, &NOR_TIMING, create_littlefs},
+	{"littlefs_cache", "nor", &NOR, &NOR_TIMING, create_littlefs_cache},
+	{"fatfs", "sd", &SD, &SD_TIMING, create_fatfs},
+	{"fatfs_cache", "sd", &SD, &SD_TIMING, create_fatfs_cache},
+	{"fatfs_dhara", "nand", &NAND, &NAND_TIMING, create_fatfs_dhara},
+};
+
+static constexpr size_t FS_COUNT = sizeof(FS_CONFIGS) / sizeof(FS_CONFIGS[0]);
+
+struct Result {
+	uint64_t bytes_written;
+	uint64_t bytes_read;
+	uint64_t time_ns;
+	BlockDevice::Stats device;
+	SimBlockDevice::Wear wear;
+	std::vector<uint64_t> latencies;
+};
+
+// What the files should hold
+struct ModelFile {
+	std::vector<uint8_t> data;
+	uint32_t pos;
+	bool exists;
+	bool open;
+	bool append;
+};
+
+static uint32_t s_seed = 1;
+
+static void fill(uint8_t *buffer, uint32_t size)
+{
+	for (uint32_t i = 0; i < size; i++) {
+		s_seed = s_seed * 1103515245 + 12345;
+		buffer[i] = (uint8_t)(s_seed >> 16);
+	}
+}
+
+static bool failed(const FsConfig &config, const Trace &trace, const Trace::Op &op, const char *what, int err)
+{
+	fprintf(stderr, "%s: %s line %u: %s %s %s (%d)\n", config.name, trace.name(), op.line,
+		Trace::type_name(op.type), trace.paths()[op.path].c_str(), what, err);
+	return false;
+}
+
+static bool verify(TraceFs *fs, const FsConfig &config, const Trace &trace, const std::vector<ModelFile> &files)
+{
+	std::vector<uint8_t> data;
+
+	if (!fs->remount()) {
+		fprintf(stderr, "%s: %s: remounting failed\n", config.name, trace.name());
+		return false;
+	}
+
+	for (uint32_t f = 0; f < files.size(); f++) {
+		const ModelFile &file = files[f];
+		const char *path = trace.paths()[f].c_str();
+
+		if (!file.exists) {
+			continue;
+		}
+
+		// One byte more to see the end of the file
+		data.resize(file.data.size() + 1);
+
+		int err = fs->open(f, path, Trace::MODE_READ);
+		const int n = err == 0 ? fs->read(f, data.data(), (uint32_t)data.size()) : err;
+
+		err = err == 0 ? fs->close(f) : err;
+
+		if (err != 0 || n != (int)file.data.size() || memcmp(data.data(), file.data.data(), file.data.size()) != 0) {
+			fprintf(stderr, "%s: %s: %s doesn't hold what was written after remounting (%d)\n", config.name,
+				trace.name(), path, err != 0 ? err : n);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static bool replay(const Trace &trace, const FsConfig &config, const char *dir, bool timing, Result &result)
+{
+	RamBlockDevice ram;
+	FileBlockDevice file;
+	SimBlockDevice device;
+	BlockDevice *backing = &ram;
+	std::vector<ModelFile> files(trace.paths().size());
+	std::vector<uint8_t> buffer;
+
+	if (dir != nullptr) {
+		std::string path = std::string(dir) + "/" + config.name + ".img";
+
+		if (!file.init(path.c_str(), *config.geometry)) {
+			fprintf(stderr, "%s: can't create %s\n", config.name, path.c_str());
+			return false;
+		}
+
+		backing = &file;
+
+	} else if (!ram.init(*config.geometry)) {
+		fprintf(stderr, "%s: out of memory\n", config.name);
+		return false;
+	}
+
+	device.init(backing, timing ? config.timing : nullptr);
+
+	TraceFs *fs = config.create(&device);
+	bool ok = fs->format();
+
+	if (!ok) {
+		fprintf(stderr, "%s: formatting failed\n", config.name);
+	}
+
+	// Formatting isn't part of the replay
+	const BlockDevice::Stats formatted = device.stats();
+
+	result = Result{};
+	result.latencies.reserve(trace.ops().size());
+	s_seed = 1;
+
+	for (size_t i = 0; ok && i < trace.ops().size(); i++) {
+		const Trace::Op &op = trace.ops()[i];
+		const char *path = trace.paths()[op.path].c_str();
+		ModelFile &model = files[op.path];
+		int ret = 0;
+
+		if (op.type == Trace::WRITE || op.type == Trace::READ) {
+			buffer.resize(op.arg);
+		}
+
+		if (op.type == Trace::WRITE) {
+			fill(buffer.data(), op.arg);
+		}
+
+		const uint64_t device_ns = device.time_ns();
+		const auto begin = std::chrono::steady_clock::now();
+
+		switch (op.type) {
+		case Trace::MKDIR: ret = fs->mkdir(path); break;
+		case Trace::OPEN: ret = fs->open(op.path, path, op.mode); break;
+		case Trace::WRITE: ret = fs->write(op.path, buffer.data(), op.arg); break;
+		case Trace::READ: ret = fs->read(op.path, buffer.data(), op.arg); break;
+		case Trace::SEEK: ret = fs->seek(op.path, op.arg); break;
+		case Trace::SYNC: ret = fs->sync(op.path); break;
+		case Trace::CLOSE: ret = fs->close(op.path); break;
+		case Trace::REMOVE: ret = fs->remove(path); break;
+		}
+
+		const auto end = std::chrono::steady_clock::now();
+		result.latencies.push_back((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count() +
+					   device.time_ns() - device_ns);
+
+		if (ret < 0) {
+			ok = failed(config, trace, op, "failed", ret);
+			break;
+		}
+
+		switch (op.type) {
+		case Trace::OPEN:
+			if (op.mode == Trace::MODE_WRITE) {
+				model.data.clear();
+			}
+
+			model.pos = 0;
+			model.exists = true;
+			model.open = true;
+			model.append = op.mode == Trace::MODE_APPEND;
+			break;
+
+		case Trace::WRITE:
+			if (model.append) {
+				model.pos = (uint32_t)model.data.size();
+			}
+
+			if ((uint32_t)ret != op.arg) {
+				ok = failed(config, trace, op, "is short", ret);
+				break;
+			}
+
+			if (model.pos + op.arg > model.data.size()) {
+				model.data.resize(model.pos + op.arg);
+			}
+
+			memcpy(&model.data[model.pos], buffer.data(), op.arg);
+			model.pos += op.arg;
+			result.bytes_written += op.arg;
+			break;
+
+		case Trace::READ: {
+			const uint32_t left = model.pos < model.data.size() ? (uint32_t)model.data.size() - model.pos : 0;
+
+			if ((uint32_t)ret != std::min(op.arg, left) || memcmp(buffer.data(), &model.data[model.pos], ret) != 0) {
+				ok = failed(config, trace, op, "read other data", ret);
+				break;
+			}
+
+			model.pos += ret;
+			result.bytes_read += ret;
+			break;
+		}
+
+		case Trace::SEEK:
+			model.pos = op.arg;
+			break;
+
+		case Trace::CLOSE:
+			model.open = false;
+			break;
+
+		case Trace::REMOVE:
+			model.data.clear();
+			model.exists = false;
+			break;
+
+		default:
+			break;
+		}
+	}
+
+	result.time_ns = 0;
+
+	for (uint64_t latency : result.latencies) {
+		result.time_ns += latency;
+	}
+
+	result.device = device.stats();
+	result.device.reads -= formatted.reads;
+	result.device.progs -= formatted.progs;
+	result.device.erases -= formatted.erases;
+	result.device.bytes_read -= formatted.bytes_read;
+	result.device.bytes_programmed -= formatted.bytes_programmed;
+
+	// Files the trace left open are closed by remounting
+	for (uint32_t f = 0; ok && f < files.size(); f++) {
+		if (files[f].open) {
+			fs->close(f);
+		}
+	}
+
+	ok = ok && verify(fs, config, trace, files);
+	result.wear = device.wear();
+
+	if (ok && result.wear.violations != 0) {
+		fprintf(stderr, "%s: %s: %llu programs of bytes not erased\n", config.name, trace.name(),
+			(unsigned long long)result.wear.violations);
+		ok = false;
+	}
+
+	delete fs;
+	return ok;
+}
+
+static double percentile_us(const std::vector<uint64_t> &sorted, uint32_t per_mille)
+{
+	if (sorted.empty()) {
+		return 0;
+	}
+
+	return sorted[std::min(sorted.size() - 1, sorted.size() * per_mille / 1000)] / 1000.0;
+}
+
+static void report(const FsConfig &config, Result &result)
+{
+	const uint64_t bytes = result.bytes_written + result.bytes_read;
+	char wa[16] = "-";
+	char wear[16];
+
+	std::sort(result.latencies.begin(), result.latencies.end());
+
+	if (result.bytes_written > 0) {
+		snprintf(wa, sizeof(wa), "%.2f", (double)result.device.bytes_programmed / result.bytes_written);
+	}
+
+	if (config.geometry->raw) {
+		snprintf(wear, sizeof(wear), "%u", result.wear.max_erases);
+
+	} else {
+		snprintf(wear, sizeof(wear), "%.1f", result.wear.max_rewrites);
+	}
+
+	printf("%-16s %-6s %9.2f %7s %8llu %7s %9.1f %9.1f %9.1f %9.1f\n", config.name, config.device,
+	       result.time_ns > 0 ? bytes * 1000.0 / result.time_ns : 0.0, wa, (unsigned long long)result.device.erases,
+	       wear, percentile_us(result.latencies, 500), percentile_us(result.latencies, 990),
+	       percentile_us(result.latencies, 999), result.latencies.empty() ? 0.0 : result.latencies.back() / 1000.0);
+}
+
+static void usage(const char *name)
+{
+	fprintf(stderr, "usage: %s [-f fs,...] [-d dir] [-s scale] [-T] trace...\n", name);
+	fprintf(stderr, "       %s -g trace\n", name);
+}
+
+int main(int argc, char *argv[])
+{
+	bool selected[FS_COUNT];
+	const char *dir = nullptr;
+	const char *generate = nullptr;
+	uint32_t scale = 1;
+	bool timing = true;
+	int traces = 0;
+	int failures = 0;
+
+	std::fill(selected, selected + FS_COUNT, true);
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) {
+			std::fill(selected, selected + FS_COUNT, false);
+
+			for (char *name = strtok(argv[++i], ","); name != nullptr; name = strtok(nullptr, ",")) {
+				size_t n;
+
+				for (n = 0; n < FS_COUNT && strcmp(name, FS_CONFIGS[n].name) != 0; n++) {
+				}
+
+				if (n == FS_COUNT) {
+					fprintf(stderr, "unknown filesystem %s\n", name);
+					return 1;
+				}
+
+				selected[n] = true;
+			}
+
+		} else if (strcmp(argv[i], "-d") == 0 && i + 1 < argc) {
+			dir = argv[++i];
+
+		} else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+			scale = (uint32_t)strtoul(argv[++i], nullptr, 0);
+
+		} else if (strcmp(argv[i], "-g") == 0 && i + 1 < argc) {
+			generate = argv[++i];
+
+		} else if (strcmp(argv[i], "-T") == 0) {
+			timing = false;
+
+		} else if (argv[i][0] == '-') {
+			usage(argv[0]);
+			return 1;
+
+		} else {
+			traces++;
+		}
+	}
+
+	if (generate != nullptr) {
+		Trace trace;
+
+		if (!trace.generate(generate, scale)) {
+			fprintf(stderr, "unknown trace %s\n", generate);
+			return 1;
+		}
+
+		trace.save(stdout);
+		return 0;
+	}
+
+	if (traces == 0 || scale == 0) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	for (int i = 1; i < argc; i++) {
+		Trace trace;
+
+		if (argv[i][0] == '-') {
+			i += strcmp(argv[i], "-T") != 0;
+			continue;
+		}
+
+		if (!trace.generate(argv[i], scale) && !trace.load(argv[i])) {
+			failures++;
+			continue;
+		}
+
+		uint64_t written = 0;
+		uint64_t read = 0;
+
+		for (const Trace::Op &op : trace.ops()) {
+			written += op.type == Trace::WRITE ? op.arg : 0;
+			read += op.type == Trace::READ ? op.arg : 0;
+		}
+
+		printf("%s: %zu operations, %.2f MiB written, %.2f MiB read\n", trace.name(), trace.ops().size(),
+		       (double)written / MiB, (double)read / MiB);
+		printf("%-16s %-6s %9s %7s %8s %7s %9s %9s %9s %9s\n", "fs", "device", "MB/s", "WA", "erases", "wear",
+		       "p50 us", "p99 us", "p99.9 us", "max us");
+
+		for (size_t n = 0; n < FS_COUNT; n++) {
+			Result result;
+
+			if (!selected[n]) {
+				continue;
+			}
+
+			if (!replay(trace, FS_CONFIGS[n], dir, timing, result)) {
+				failures++;
+				continue;
+			}
+
+			report(FS_CONFIGS[n], result);
+		}
+
+		printf("\n");
+	}
+
+	return failures > 0 ? 1 : 0;
+}
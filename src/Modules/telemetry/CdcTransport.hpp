@@ -0,0 +1,50 @@
+#pragma once
+
+#include "Telemetry.hpp"
+
+#include <atomic>
+#include <string.h>
+
+#include "main.h"
+#include "usb_device_cdc_acm.h"
+
+namespace telemetry
+{
+
+// Writes frames to the USB CDC bulk-in endpoint. There is a single
+// transfer buffer, a frame arriving while the previous transfer is still in
+// flight, or while another context is filling the buffer, is dropped.
+class CdcTransport : public Transport
+{
+public:
+	bool write(const uint8_t *data, size_t len) override
+	{
+		if ((1U != s_cdcVcom.attach) || (1U != s_cdcVcom.startTransactions) || len > sizeof(_buffer)) {
+			return false;
+		}
+
+		// The buffer is owned by the controller until the transfer completes.
+		usb_device_cdc_acm_struct_t *cdc = (usb_device_cdc_acm_struct_t *)s_cdcVcom.cdcAcmHandle;
+
+		if (_filling.exchange(true, std::memory_order_acquire)) {
+			return false;
+		}
+
+		bool sent = false;
+
+		if (1U != cdc->bulkIn.isBusy) {
+			memcpy(_buffer, data, len);
+			sent = kStatus_USB_Success == USB_DeviceCdcAcmSend(s_cdcVcom.cdcAcmHandle, USB_CDC_VCOM_BULK_IN_ENDPOINT,
+					_buffer, len);
+		}
+
+		_filling.store(false, std::memory_order_release);
+		return sent;
+	}
+
+private:
+	uint8_t _buffer[MAX_FRAME_SIZE];
+	std::atomic<bool> _filling{false};
+};
+
+} // namespace telemetry
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "Telemetry.hpp"
+
+#include "SEGGER_RTT.h"
+
+namespace telemetry
+{
+
+// Writes frames to a dedicated RTT up-buffer. The buffer is configured
+// in skip mode, a frame that does not fit completely is dropped.
+class RttTransport : public Transport
+{
+public:
+	/* @brief Constructor
+	 *
+	 * @param index Up-buffer index, 0 is the RTT terminal and should not be used.
+	 */
+	RttTransport(unsigned index, const char *name, uint8_t *buffer, unsigned size)
+		: _index(index), _name(name), _buffer(buffer), _size(size) {}
+
+	/* @brief Configure the up-buffer, must be called before the first write
+	 *
+	 * @returns false if the index is not available.
+	 */
+	bool init()
+	{
+		return SEGGER_RTT_ConfigUpBuffer(_index, _name, _buffer, _size, SEGGER_RTT_MODE_NO_BLOCK_SKIP) >= 0;
+	}
+
+	bool write(const uint8_t *data, size_t len) override
+	{
+		unsigned written;
+
+		// Topics published from different contexts share the up-buffer
+		SEGGER_RTT_LOCK();
+		written = SEGGER_RTT_WriteSkipNoLock(_index, data, (unsigned)len);
+		SEGGER_RTT_UNLOCK();
+		return written != 0;
+	}
+
+private:
+	const unsigned _index;
+	const char *_name;
+	uint8_t *_buffer;
+	const unsigned _size;
+};
+
+} // namespace telemetry
@@ -0,0 +1,76 @@
+#include "Telemetry.hpp"
+
+#include <string.h>
+
+namespace telemetry
+{
+
+bool Writer::announce(Topic &topic, uint32_t timestamp)
+{
+	uint8_t payload[MAX_PAYLOAD];
+	size_t name_len = strlen(topic._name);
+
+	if (name_len > MAX_PAYLOAD - 1) {
+		name_len = MAX_PAYLOAD - 1;
+	}
+
+	payload[0] = topic._id;
+	memcpy(&payload[1], topic._name, name_len);
+
+	uint8_t frame[MAX_FRAME_SIZE];
+	const size_t len = encode_frame(frame, TOPIC_ANNOUNCE, 0, timestamp, payload, name_len + 1);
+	return _transport.write(frame, len);
+}
+
+bool Writer::publish(Topic &topic, const void *data, size_t len, uint32_t timestamp)
+{
+	if (topic._id == TOPIC_ANNOUNCE || len > MAX_PAYLOAD) {
+		return false;
+	}
+
+	// Try-lock only, a context interrupting a publish of the same topic
+	// loses its frame instead of waiting for the one it preempted. Other
+	// topics are not affected.
+	if (topic._busy.exchange(true, std::memory_order_acquire)) {
+		topic._busy_drops.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	const bool written = publish_locked(topic, data, len, timestamp);
+
+	topic._busy.store(false, std::memory_order_release);
+	return written;
+}
+
+bool Writer::publish_locked(Topic &topic, const void *data, size_t len, uint32_t timestamp)
+{
+	if (topic._min_interval > 0 && topic._published
+	    && (uint32_t)(timestamp - topic._last_timestamp) < topic._min_interval) {
+		topic._rate_limited.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	// Announce until the first frame made it, then once per seq wrap.
+	if ((topic._seq == 0) && !announce(topic, timestamp)) {
+		topic._dropped.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	uint8_t frame[MAX_FRAME_SIZE];
+	const size_t frame_len = encode_frame(frame, topic._id, topic._seq, timestamp, data, len);
+
+	if (!_transport.write(frame, frame_len)) {
+		topic._dropped.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	// Only a frame that made it counts for the rate limit, a dropped one
+	// doesn't hold back the next sample.
+	topic._published = true;
+	topic._last_timestamp = timestamp;
+	topic._seq++;
+	topic._sent.fetch_add(1, std::memory_order_relaxed);
+	return true;
+}
+
+} // namespace telemetry
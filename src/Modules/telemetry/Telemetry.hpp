@@ -0,0 +1,106 @@
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "TelemetryFrame.hpp"
+
+// Telemetry writer.
+//
+// Producers publish fixed size samples on a Topic from any context,
+// including interrupts. Publishing never blocks: the frame is encoded on the
+// caller stack and handed to the transport, which either takes the whole
+// frame or drops it. Frames are also dropped, and counted, when the topic is
+// published faster than its minimum interval or when the topic is published
+// again from a context that interrupted its own publish.
+//
+// A topic has a single producer, different topics may be published from
+// different contexts without dropping each other's frames.
+//
+// Each topic is announced (id and name) before its first frame and again
+// every 256 frames, so a decoder attaching late learns the topic names.
+
+namespace telemetry
+{
+
+class Transport
+{
+public:
+	virtual ~Transport() = default;
+
+	/* @brief Write a complete frame
+	 *
+	 * Called from the contexts of all topics, the transport serialises
+	 * concurrent writes itself.
+	 *
+	 * @returns false if the frame was not written, partial writes are not
+	 *          allowed.
+	 */
+	virtual bool write(const uint8_t *data, size_t len) = 0;
+};
+
+class Topic
+{
+public:
+	/* @brief Constructor
+	 *
+	 * @param name Topic name sent in the announcement.
+	 * @param id Topic id, 1..255.
+	 * @param min_interval Minimum time between two frames in timestamp
+	 *                     units, 0 to disable rate limiting.
+	 */
+	Topic(const char *name, uint8_t id, uint32_t min_interval = 0)
+		: _name(name), _id(id), _min_interval(min_interval) {}
+
+	const char *name() const { return _name; }
+	uint8_t id() const { return _id; }
+
+	uint32_t sent() const { return _sent.load(std::memory_order_relaxed); }
+	uint32_t rate_limited() const { return _rate_limited.load(std::memory_order_relaxed); }
+	uint32_t dropped() const { return _dropped.load(std::memory_order_relaxed); }
+
+	// Frames dropped because the topic was being published by another context.
+	uint32_t busy_drops() const { return _busy_drops.load(std::memory_order_relaxed); }
+
+private:
+	friend class Writer;
+
+	const char *_name;
+	const uint8_t _id;
+	const uint32_t _min_interval;
+
+	// Timestamp of the last frame written, for the rate limit
+	uint32_t _last_timestamp{0};
+	bool _published{false};
+	uint8_t _seq{0};
+
+	std::atomic<bool> _busy{false};
+	std::atomic<uint32_t> _sent{0};
+	std::atomic<uint32_t> _rate_limited{0};
+	std::atomic<uint32_t> _dropped{0};
+	std::atomic<uint32_t> _busy_drops{0};
+};
+
+class Writer
+{
+public:
+	explicit Writer(Transport &transport) : _transport(transport) {}
+
+	/* @brief Publish one sample
+	 *
+	 * @param data Sample, at most MAX_PAYLOAD bytes.
+	 * @param timestamp Sample time, same unit as the topic interval.
+	 *
+	 * @returns true if the frame was written to the transport.
+	 */
+	bool publish(Topic &topic, const void *data, size_t len, uint32_t timestamp);
+
+private:
+	bool publish_locked(Topic &topic, const void *data, size_t len, uint32_t timestamp);
+	bool announce(Topic &topic, uint32_t timestamp);
+
+	Transport &_transport;
+};
+
+} // namespace telemetry
@@ -0,0 +1,201 @@
+#include "TelemetryFrame.hpp"
+
+#include <string.h>
+
+namespace telemetry
+{
+
+namespace
+{
+
+struct Crc16Table {
+	uint16_t entry[256];
+};
+
+constexpr Crc16Table make_crc16_table()
+{
+	Crc16Table table{};
+
+	for (int i = 0; i < 256; i++) {
+		uint16_t crc = (uint16_t)(i << 8);
+
+		for (int bit = 0; bit < 8; bit++) {
+			crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+		}
+
+		table.entry[i] = crc;
+	}
+
+	return table;
+}
+
+// Built at compile time, the bitwise loop costs several us per frame on target.
+constexpr Crc16Table crc16_table = make_crc16_table();
+
+} // namespace
+
+uint16_t crc16(const uint8_t *data, size_t len, uint16_t crc)
+{
+	for (size_t i = 0; i < len; i++) {
+		crc = (uint16_t)((crc << 8) ^ crc16_table.entry[(uint8_t)((crc >> 8) ^ data[i])]);
+	}
+
+	return crc;
+}
+
+namespace
+{
+
+// Streaming COBS encoder, avoids a second pass over the raw frame.
+class CobsWriter
+{
+public:
+	explicit CobsWriter(uint8_t *out) : _out(out) {}
+
+	void put(uint8_t byte)
+	{
+		if (byte == 0) {
+			close_block();
+			return;
+		}
+
+		_out[_pos++] = byte;
+
+		if (++_code == 0xFF) {
+			close_block();
+		}
+	}
+
+	void put(const uint8_t *data, size_t len)
+	{
+		for (size_t i = 0; i < len; i++) {
+			put(data[i]);
+		}
+	}
+
+	size_t finish()
+	{
+		_out[_code_pos] = _code;
+		_out[_pos++] = 0;
+		return _pos;
+	}
+
+private:
+	void close_block()
+	{
+		_out[_code_pos] = _code;
+		_code_pos = _pos++;
+		_code = 1;
+	}
+
+	uint8_t *_out;
+	size_t _pos{1};
+	size_t _code_pos{0};
+	uint8_t _code{1};
+};
+
+} // namespace
+
+size_t encode_frame(uint8_t *out, uint8_t topic, uint8_t seq, uint32_t timestamp,
+		    const void *payload, size_t payload_len)
+{
+	if (payload_len > MAX_PAYLOAD) {
+		return 0;
+	}
+
+	const uint8_t header[HEADER_SIZE] = {
+		topic,
+		seq,
+		(uint8_t)timestamp,
+		(uint8_t)(timestamp >> 8),
+		(uint8_t)(timestamp >> 16),
+		(uint8_t)(timestamp >> 24),
+	};
+
+	uint16_t crc = crc16(header, sizeof(header));
+	crc = crc16((const uint8_t *)payload, payload_len, crc);
+
+	CobsWriter writer(out);
+	writer.put(header, sizeof(header));
+	writer.put((const uint8_t *)payload, payload_len);
+	writer.put((uint8_t)crc);
+	writer.put((uint8_t)(crc >> 8));
+	return writer.finish();
+}
+
+bool FrameDecoder::push(uint8_t byte, Frame &frame)
+{
+	if (byte != 0) {
+		if (_len < sizeof(_buf)) {
+			_buf[_len++] = byte;
+
+		} else {
+			_overflow = true;
+		}
+
+		return false;
+	}
+
+	bool valid = false;
+
+	if (_overflow) {
+		_framing_errors++;
+
+	} else if (_len > 0) {
+		valid = decode(frame);
+	}
+
+	_len = 0;
+	_overflow = false;
+	return valid;
+}
+
+bool FrameDecoder::decode(Frame &frame)
+{
+	uint8_t raw[MAX_RAW_SIZE + 1];
+	size_t raw_len = 0;
+	size_t i = 0;
+
+	// Undo the COBS block codes, each block implies a
+	// trailing zero unless it is a full 0xFF block or the last one.
+	while (i < _len) {
+		const uint8_t code = _buf[i++];
+
+		if (i + code - 1 > _len || raw_len + code > sizeof(raw)) {
+			_framing_errors++;
+			return false;
+		}
+
+		memcpy(&raw[raw_len], &_buf[i], code - 1);
+		raw_len += code - 1;
+		i += code - 1;
+
+		if (code != 0xFF && i < _len) {
+			raw[raw_len++] = 0;
+		}
+	}
+
+	if (raw_len < HEADER_SIZE + CRC_SIZE) {
+		_framing_errors++;
+		return false;
+	}
+
+	const size_t crc_offset = raw_len - CRC_SIZE;
+	const uint16_t crc = (uint16_t)(raw[crc_offset] | (raw[crc_offset + 1] << 8));
+
+	if (crc16(raw, crc_offset) != crc) {
+		_crc_errors++;
+		return false;
+	}
+
+	frame.topic = raw[0];
+	frame.seq = raw[1];
+	frame.timestamp = (uint32_t)raw[2] | ((uint32_t)raw[3] << 8) | ((uint32_t)raw[4] << 16) | ((uint32_t)raw[5] << 24);
+	frame.payload_len = (uint8_t)(crc_offset - HEADER_SIZE);
+	memcpy(frame.payload, &raw[HEADER_SIZE], frame.payload_len);
+
+	_frames++;
+	return true;
+}
+
+} // namespace telemetry
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Binary telemetry framing.
+//
+// Every frame is
+//
+//   topic (1) | seq (1) | timestamp (4, LE) | payload (0..MAX_PAYLOAD) | crc16 (2, LE)
+//
+// COBS encoded and terminated by a single 0x00, so a reader that attaches
+// in the middle of a stream resynchronises on the next delimiter. The crc is
+// CRC-16/CCITT-FALSE over everything before it.
+//
+// Topic 0 is reserved for announcements, its payload is the announced topic
+// id followed by the topic name (not terminated).
+
+namespace telemetry
+{
+
+static constexpr uint8_t TOPIC_ANNOUNCE = 0;
+
+static constexpr size_t MAX_PAYLOAD = 128;
+static constexpr size_t HEADER_SIZE = 6;
+static constexpr size_t CRC_SIZE = 2;
+static constexpr size_t MAX_RAW_SIZE = HEADER_SIZE + MAX_PAYLOAD + CRC_SIZE;
+
+// COBS adds one byte per started 254 byte block, plus the delimiter.
+static constexpr size_t MAX_FRAME_SIZE = MAX_RAW_SIZE + (MAX_RAW_SIZE / 254) + 2;
+
+struct Frame {
+	uint8_t topic;
+	uint8_t seq;
+	uint32_t timestamp;
+	uint8_t payload_len;
+	uint8_t payload[MAX_PAYLOAD];
+};
+
+/* @brief CRC-16/CCITT-FALSE
+ *
+ * @param crc Initial value, pass a previous result to continue a crc.
+ */
+uint16_t crc16(const uint8_t *data, size_t len, uint16_t crc = 0xFFFF);
+
+/* @brief Encode a complete frame including the delimiter
+ *
+ * @param out Buffer of at least MAX_FRAME_SIZE bytes.
+ * @param payload_len Must not exceed MAX_PAYLOAD.
+ *
+ * @returns number of bytes written to out, 0 if the payload is too large.
+ */
+size_t encode_frame(uint8_t *out, uint8_t topic, uint8_t seq, uint32_t timestamp,
+		    const void *payload, size_t payload_len);
+
+// Incremental decoder, fed with the raw byte stream of the transport.
+class FrameDecoder
+{
+public:
+	/* @brief Process one received byte
+	 *
+	 * @returns true if the byte completed a valid frame, which is then
+	 *          stored in frame.
+	 */
+	bool push(uint8_t byte, Frame &frame);
+
+	uint32_t frames() const { return _frames; }
+	uint32_t crc_errors() const { return _crc_errors; }
+	uint32_t framing_errors() const { return _framing_errors; }
+
+private:
+	bool decode(Frame &frame);
+
+	uint8_t _buf[MAX_FRAME_SIZE];
+	size_t _len{0};
+	bool _overflow{false};
+
+	uint32_t _frames{0};
+	uint32_t _crc_errors{0};
+	uint32_t _framing_errors{0};
+};
+
+} // namespace telemetry
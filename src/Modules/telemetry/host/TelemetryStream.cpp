@@ -0,0 +1,40 @@
+#include "TelemetryStream.hpp"
+
+#include <string.h>
+
+namespace telemetry
+{
+
+bool StreamDecoder::push(uint8_t byte, Frame &frame)
+{
+	if (!_decoder.push(byte, frame)) {
+		return false;
+	}
+
+	if (frame.topic == TOPIC_ANNOUNCE) {
+		if (frame.payload_len > 0) {
+			TopicStats &t = _topics[frame.payload[0]];
+			memcpy(t.name, &frame.payload[1], frame.payload_len - 1);
+			t.name[frame.payload_len - 1] = '\0';
+		}
+
+		return false;
+	}
+
+	TopicStats &t = _topics[frame.topic];
+
+	if (t.frames > 0) {
+		t.lost += (uint8_t)(frame.seq - t.last_seq - 1);
+	}
+
+	t.frames++;
+	t.last_seq = frame.seq;
+	return true;
+}
+
+const char *StreamDecoder::topic_name(uint8_t id) const
+{
+	return _topics[id].name[0] != '\0' ? _topics[id].name : "?";
+}
+
+} // namespace telemetry
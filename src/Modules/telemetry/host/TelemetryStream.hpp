@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "TelemetryFrame.hpp"
+
+namespace telemetry
+{
+
+// Decoder of a captured telemetry stream, as telemetry_decode reads it.
+// Announcements are consumed and name the topics, data frames are returned
+// and counted per topic, with the frames lost in between taken from the
+// gaps in their sequence numbers.
+class StreamDecoder
+{
+public:
+	struct TopicStats {
+		char name[MAX_PAYLOAD];
+		uint32_t frames;
+		uint32_t lost;
+		uint8_t last_seq;
+	};
+
+	/* @brief Process one received byte
+	 *
+	 * @returns true if the byte completed a valid data frame, which is then
+	 *          stored in frame.
+	 */
+	bool push(uint8_t byte, Frame &frame);
+
+	/* @returns the announced name of the topic, "?" before its announcement */
+	const char *topic_name(uint8_t id) const;
+
+	const TopicStats &topic(uint8_t id) const { return _topics[id]; }
+	const FrameDecoder &decoder() const { return _decoder; }
+
+private:
+	FrameDecoder _decoder;
+	TopicStats _topics[256]{};
+};
+
+} // namespace telemetry
@@ -0,0 +1,85 @@
+// Host decoder for the telemetry stream.
+//
+// Reads the raw byte stream captured from the RTT up-buffer (e.g. with
+// JLinkRTTLogger -RTTChannel 1) or from the CDC port and prints one line
+// per frame, followed by per-topic statistics.
+//
+//   telemetry_decode [-q] [file]
+//
+//   -q  only print the statistics
+
+#include <stdio.h>
+#include <string.h>
+
+#include "TelemetryStream.hpp"
+
+using namespace telemetry;
+
+static void print_frame(const StreamDecoder &stream, const Frame &frame)
+{
+	printf("%10lu %-16s %3u %3u ", (unsigned long)frame.timestamp, stream.topic_name(frame.topic), frame.seq,
+	       frame.payload_len);
+
+	for (unsigned i = 0; i < frame.payload_len; i++) {
+		printf("%02x", frame.payload[i]);
+	}
+
+	printf("\n");
+}
+
+int main(int argc, char *argv[])
+{
+	bool quiet = false;
+	const char *path = nullptr;
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-q") == 0) {
+			quiet = true;
+
+		} else if (argv[i][0] == '-') {
+			fprintf(stderr, "usage: %s [-q] [file]\n", argv[0]);
+			return 1;
+
+		} else {
+			path = argv[i];
+		}
+	}
+
+	FILE *in = path ? fopen(path, "rb") : stdin;
+
+	if (in == nullptr) {
+		perror(path);
+		return 1;
+	}
+
+	StreamDecoder stream;
+	Frame frame;
+	int c;
+
+	while ((c = fgetc(in)) != EOF) {
+		if (stream.push((uint8_t)c, frame) && !quiet) {
+			print_frame(stream, frame);
+		}
+	}
+
+	if (in != stdin) {
+		fclose(in);
+	}
+
+	printf("\n%-16s %10s %10s\n", "topic", "frames", "lost");
+
+	for (unsigned id = 1; id < 256; id++) {
+		const StreamDecoder::TopicStats &t = stream.topic((uint8_t)id);
+
+		if (t.frames > 0) {
+			printf("%-16s %10lu %10lu\n", stream.topic_name((uint8_t)id), (unsigned long)t.frames,
+			       (unsigned long)t.lost);
+		}
+	}
+
+	const FrameDecoder &decoder = stream.decoder();
+
+	printf("\nframes %lu, crc errors %lu, framing errors %lu\n", (unsigned long)decoder.frames(),
+	       (unsigned long)decoder.crc_errors(), (unsigned long)decoder.framing_errors());
+	return 0;
+}
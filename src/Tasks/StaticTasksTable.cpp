@@ -1,10 +1,17 @@
 #include "StaticTasksTable.hpp"
 #include "PrintTask.hpp"
 
+#if defined(BENCH_BUILD)
+#include "BenchTask.hpp"
+#endif
+
 // 静态任务注册表
 StaticTaskEntry static_task_table[] = {
 	{Tasks::Create<PrintTaskt>, "Print1", 256, 4, (void *)0x1234},
 	{Tasks::Create<PrintTaskt>, "Print2", 256, 4, (void *)0x4444},
+#if defined(BENCH_BUILD)
+	{Tasks::Create<BenchTask>, "Bench", 1024, 3, nullptr},
+#endif
 };
 
 